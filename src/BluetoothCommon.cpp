@@ -14,4 +14,8 @@ const uint8_t FROMNUM_UUID_16[16u] = {0x53, 0x44, 0xe3, 0x47, 0x75, 0xaa, 0x70,
 const uint8_t LEGACY_LOGRADIO_UUID_16[16u] = {0xe2, 0xf2, 0x1e, 0xbe, 0xc5, 0x15, 0xcf, 0xaa,
                                               0x6b, 0x43, 0xfa, 0x78, 0x38, 0xd2, 0x6f, 0x6c};
 const uint8_t LOGRADIO_UUID_16[16u] = {0x47, 0x95, 0xDF, 0x8C, 0xDE, 0xE9, 0x44, 0x99,
-                                       0x23, 0x44, 0xE6, 0x06, 0x49, 0x6E, 0x3D, 0x5A};
\ No newline at end of file
+                                       0x23, 0x44, 0xE6, 0x06, 0x49, 0x6E, 0x3D, 0x5A};
+const uint8_t FROMRADIOPACKED_UUID_16[16u] = {0xb1, 0x5b, 0x06, 0x5d, 0x77, 0x64, 0x17, 0x87,
+                                              0x27, 0x41, 0x17, 0x8b, 0xe5, 0xca, 0x12, 0xe0};
+const uint8_t LOGRADIOPACKED_UUID_16[16u] = {0xf6, 0x9f, 0x85, 0xa0, 0xed, 0x32, 0x6c, 0xae,
+                                             0x52, 0x4e, 0x3b, 0xf8, 0xe8, 0x62, 0xe2, 0xed};
\ No newline at end of file
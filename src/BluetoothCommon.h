@@ -13,10 +13,15 @@
 #define FROMNUM_UUID "ed9da18c-a800-4f66-a670-aa7547e34453"
 #define LEGACY_LOGRADIO_UUID "6c6fd238-78fa-436b-aacf-15c5be1ef2e2"
 #define LOGRADIO_UUID "5a3d6e49-06e6-4423-9944-e9de8cdf9547"
+/// Like FROMRADIO_UUID, but each read returns several FromRadio packets, see BluetoothPhoneAPIBase::getPackedFromRadio()
+#define FROMRADIOPACKED_UUID "e012cae5-8b17-4127-8717-64775d065bb1"
+/// Like LOGRADIO_UUID, but each notification carries several LogRecords, see BluetoothLogBatch
+#define LOGRADIOPACKED_UUID "ede262e8-f83b-4e52-ae6c-32eda0859ff6"
 
 // NRF52 wants these constants as byte arrays
 // Generated here https://yupana-engineering.com/online-uuid-to-c-array-converter - but in REVERSE BYTE ORDER
-extern const uint8_t MESH_SERVICE_UUID_16[], TORADIO_UUID_16[16u], FROMRADIO_UUID_16[], FROMNUM_UUID_16[], LOGRADIO_UUID_16[];
+extern const uint8_t MESH_SERVICE_UUID_16[], TORADIO_UUID_16[16u], FROMRADIO_UUID_16[], FROMNUM_UUID_16[], LOGRADIO_UUID_16[],
+    FROMRADIOPACKED_UUID_16[], LOGRADIOPACKED_UUID_16[];
 
 /// Given a level between 0-100, update the BLE attribute
 void updateBatteryLevel(uint8_t level);
@@ -0,0 +1,122 @@
+#include "BluetoothLogBatch.h"
+#include "RTC.h"
+#include "Throttle.h"
+#include "concurrency/LockGuard.h"
+#include "configuration.h"
+#include "mesh/mesh-pb-constants.h"
+
+#if HAS_BLUETOOTH && !MESHTASTIC_EXCLUDE_BLUETOOTH && BLE_LOG_BATCHING
+
+static_assert(2 + meshtastic_LogRecord_size <= BLE_LOG_BATCH_SIZE, "A LogRecord must fit in a notification");
+
+// Nothing here may log, it runs inside the logging of whatever is being sent
+
+BluetoothLogBatch::BluetoothLogBatch() : concurrency::OSThread("BluetoothLogBatch")
+{
+    disable(); // only runs while records are waiting
+}
+
+void BluetoothLogBatch::add(meshtastic_LogRecord_Level level, const uint8_t *record, size_t len)
+{
+    concurrency::LockGuard guard(&lock);
+
+    size_t limit = maxNotifyLen();
+    if (limit > BLE_LOG_BATCH_SIZE)
+        limit = BLE_LOG_BATCH_SIZE;
+    // A record longer than a notification goes on its own, cut short by the BLE stack as it was before batching
+    if (limit < 2 + len)
+        limit = 2 + len;
+
+    auto fits = [&]() { return count < BLE_LOG_BATCH_RECORDS && used + 2 + len <= limit; };
+    if (!fits() && count && !Throttle::isWithinTimespanMs(lastNotifyMsec, BLE_LOG_BATCH_MSEC))
+        flush();
+
+    // Backpressure: make room at the expense of less important records, or give up on this one
+    while (!fits()) {
+        if (!dropBelow(level)) {
+            dropped++;
+            return;
+        }
+    }
+
+    if (!count) {
+        enabled = true;
+        setIntervalFromNow(Throttle::isWithinTimespanMs(lastNotifyMsec, BLE_LOG_BATCH_MSEC)
+                               ? BLE_LOG_BATCH_MSEC - (millis() - lastNotifyMsec)
+                               : 0);
+    }
+    append(level, record, len);
+}
+
+void BluetoothLogBatch::clear()
+{
+    concurrency::LockGuard guard(&lock);
+    used = 0;
+    count = 0;
+}
+
+int32_t BluetoothLogBatch::runOnce()
+{
+    concurrency::LockGuard guard(&lock);
+    if (count && !flush())
+        return BLE_LOG_BATCH_MSEC; // The BLE stack is full, try again later
+    return disable();
+}
+
+bool BluetoothLogBatch::flush()
+{
+    if (!notifyBatch(buf, used))
+        return false;
+    lastNotifyMsec = millis();
+    used = 0;
+    count = 0;
+
+    // Let the phone know some records never made it, first thing in the next notification
+    if (dropped != reportedDropped) {
+        meshtastic_LogRecord notice = meshtastic_LogRecord_init_zero;
+        notice.level = meshtastic_LogRecord_Level_WARNING;
+        snprintf(notice.message, sizeof(notice.message), "%u log records dropped, BLE too slow",
+                 (unsigned)(dropped - reportedDropped));
+        strncpy(notice.source, "BluetoothLogBatch", sizeof(notice.source) - 1);
+        notice.time = getValidTime(RTCQuality::RTCQualityDevice, true);
+        uint8_t record[meshtastic_LogRecord_size];
+        size_t len = pb_encode_to_bytes(record, sizeof(record), meshtastic_LogRecord_fields, &notice);
+        append(meshtastic_LogRecord_Level_WARNING, record, len);
+        reportedDropped = dropped;
+        enabled = true;
+        setIntervalFromNow(BLE_LOG_BATCH_MSEC);
+    }
+    return true;
+}
+
+void BluetoothLogBatch::append(meshtastic_LogRecord_Level level, const uint8_t *record, size_t len)
+{
+    buf[used] = len & 0xff;
+    buf[used + 1] = len >> 8;
+    memcpy(buf + used + 2, record, len);
+    used += 2 + len;
+    levels[count++] = level;
+}
+
+bool BluetoothLogBatch::dropBelow(meshtastic_LogRecord_Level level)
+{
+    int victim = -1;
+    for (int i = 0; i < count; i++)
+        if (levels[i] < level && (victim < 0 || levels[i] <= levels[victim]))
+            victim = i;
+    if (victim < 0)
+        return false;
+
+    size_t offset = 0;
+    for (int i = 0; i < victim; i++)
+        offset += 2 + (buf[offset] | (buf[offset + 1] << 8));
+    size_t len = 2 + (buf[offset] | (buf[offset + 1] << 8));
+    memmove(buf + offset, buf + offset + len, used - offset - len);
+    used -= len;
+    memmove(levels + victim, levels + victim + 1, count - victim - 1);
+    count--;
+    dropped++;
+    return true;
+}
+
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "concurrency/Lock.h"
+#include "concurrency/OSThread.h"
+#include "mesh/generated/meshtastic/mesh.pb.h"
+
+/// Set to 1 to send log records to a phone subscribed to LOGRADIOPACKED_UUID several per notification
+#ifndef BLE_LOG_BATCHING
+#define BLE_LOG_BATCHING 0
+#endif
+
+/// The longest a record waits for others to share its notification, and the shortest time between two notifications
+#ifndef BLE_LOG_BATCH_MSEC
+#define BLE_LOG_BATCH_MSEC 100
+#endif
+
+/// Largest packed log notification, the most a BLE attribute can hold
+#define BLE_LOG_BATCH_SIZE 512
+
+/// Most records one notification carries
+#define BLE_LOG_BATCH_RECORDS 32
+
+/**
+ * Collects the encoded LogRecords sent to the phone into notifications of up to MTU - 3 bytes, each record preceded by its
+ * length (2 bytes, little endian) like packed FromRadio reads.  A notification goes out BLE_LOG_BATCH_MSEC after the one
+ * before, or once the next record doesn't fit.
+ *
+ * Under backpressure (logs coming faster than that, or the BLE stack out of buffers) a record that doesn't fit pushes the
+ * lowest level records out of the waiting notification, or is dropped itself if there are none below it.  Dropped records
+ * are counted, and the phone is told how many with a WARNING record at the start of the next notification.
+ *
+ * Platforms implement how to notify and how long a notification may be.
+ */
+class BluetoothLogBatch : private concurrency::OSThread
+{
+  public:
+    BluetoothLogBatch();
+
+    /// Queue an encoded LogRecord of the given level, called with the print lock held
+    void add(meshtastic_LogRecord_Level level, const uint8_t *record, size_t len);
+
+    /// Forget what was waiting, the phone it was for is gone
+    void clear();
+
+    /// Records dropped under backpressure since boot
+    uint32_t getDropped() const { return dropped; }
+
+  protected:
+    /// Send buf as one notification on the packed log characteristic
+    /// @return false if the BLE stack has no room for it right now
+    virtual bool notifyBatch(const uint8_t *buf, size_t len) = 0;
+
+    /// The longest notification the connected phone accepts, i.e. MTU - 3
+    virtual size_t maxNotifyLen() = 0;
+
+    virtual int32_t runOnce() override;
+
+  private:
+    concurrency::Lock lock;
+    uint8_t buf[BLE_LOG_BATCH_SIZE];
+    size_t used = 0;
+    uint8_t levels[BLE_LOG_BATCH_RECORDS]; // of each record in buf, in order
+    uint8_t count = 0;
+    uint32_t lastNotifyMsec = 0;
+    uint32_t dropped = 0, reportedDropped = 0;
+
+    /// Send what is waiting, called with lock held
+    /// @return false if it couldn't be sent
+    bool flush();
+
+    /// Append a record, the caller has checked it fits
+    void append(meshtastic_LogRecord_Level level, const uint8_t *record, size_t len);
+
+    /// Drop the newest waiting record of the lowest level, if that is below level
+    /// @return false if there is none
+    bool dropBelow(meshtastic_LogRecord_Level level);
+};
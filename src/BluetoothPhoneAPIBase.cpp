@@ -0,0 +1,71 @@
+#include "BluetoothPhoneAPIBase.h"
+#include "Throttle.h"
+#include "configuration.h"
+
+#if HAS_BLUETOOTH && !MESHTASTIC_EXCLUDE_BLUETOOTH
+
+static_assert(2 + meshtastic_FromRadio_size <= BLE_PACKED_FROMRADIO_SIZE, "A FromRadio must fit in a packed read");
+
+BluetoothPhoneAPIBase::BluetoothPhoneAPIBase() : concurrency::OSThread("BluetoothPhoneAPI")
+{
+    disable(); // only runs to send a coalesced notification
+}
+
+void BluetoothPhoneAPIBase::onNowHasData(uint32_t fromRadioNum)
+{
+    PhoneAPI::onNowHasData(fromRadioNum);
+
+    pendingFromNum = fromRadioNum;
+    if (!Throttle::isWithinTimespanMs(lastNotifyMsec, BLE_FROMNUM_COALESCE_MSEC)) {
+        notifyPending = false;
+        lastNotifyMsec = millis();
+        notifyFromNum(fromRadioNum);
+    } else if (!notifyPending) {
+        // Notified very recently, tell the phone about this (and anything else arriving meanwhile) once the window is over
+        notifyPending = true;
+        enabled = true;
+        setIntervalFromNow(BLE_FROMNUM_COALESCE_MSEC);
+    }
+}
+
+int32_t BluetoothPhoneAPIBase::runOnce()
+{
+    if (notifyPending && isConnected()) {
+        lastNotifyMsec = millis();
+        notifyFromNum(pendingFromNum);
+    }
+    notifyPending = false;
+    return disable();
+}
+
+size_t BluetoothPhoneAPIBase::getPackedFromRadio(uint8_t *buf, size_t preferredLen)
+{
+    if (preferredLen > BLE_PACKED_FROMRADIO_SIZE)
+        preferredLen = BLE_PACKED_FROMRADIO_SIZE;
+
+    size_t used = 0;
+    while (used + 3 <= preferredLen || !used) {
+        if (!pendingPacketLen)
+            pendingPacketLen = getFromRadio(pendingPacket);
+        if (!pendingPacketLen)
+            break;
+        if (used && used + 2 + pendingPacketLen > preferredLen)
+            break; // keep it for next time
+
+        buf[used] = pendingPacketLen & 0xff;
+        buf[used + 1] = pendingPacketLen >> 8;
+        memcpy(buf + used + 2, pendingPacket, pendingPacketLen);
+        used += 2 + pendingPacketLen;
+        pendingPacketLen = 0;
+    }
+    return used;
+}
+
+void BluetoothPhoneAPIBase::close()
+{
+    pendingPacketLen = 0; // belonged to the old connection
+    notifyPending = false;
+    PhoneAPI::close();
+}
+
+#endif
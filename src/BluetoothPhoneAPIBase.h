@@ -0,0 +1,50 @@
+#pragma once
+
+#include "concurrency/OSThread.h"
+#include "mesh/PhoneAPI.h"
+
+/// fromNum notifications closer together than this are merged into one, the phone reads until empty after each anyway
+#ifndef BLE_FROMNUM_COALESCE_MSEC
+#define BLE_FROMNUM_COALESCE_MSEC 20
+#endif
+
+/// Largest value of the packed FromRadio characteristic, the most a BLE attribute can hold
+#define BLE_PACKED_FROMRADIO_SIZE 512
+
+/**
+ * The parts of our bluetooth PhoneAPI that NimBLE and nRF52 share: notification coalescing and packed FromRadio reads.
+ * Platforms only have to implement how to notify fromNum.
+ */
+class BluetoothPhoneAPIBase : public PhoneAPI, protected concurrency::OSThread
+{
+  public:
+    BluetoothPhoneAPIBase();
+
+    /**
+     * Fill buf (BLE_PACKED_FROMRADIO_SIZE bytes) for a read of the packed FromRadio characteristic.
+     *
+     * Each FromRadio is preceded by its length (2 bytes, little endian).  There is always at least one packet if any are
+     * available, further ones are only added while the total fits in preferredLen (i.e. MTU - 1) so a read takes a single
+     * round trip.  A packet that doesn't fit is kept for the next read.
+     * @return the number of bytes used, 0 if nothing is available
+     */
+    size_t getPackedFromRadio(uint8_t *buf, size_t preferredLen);
+
+    virtual void close() override;
+
+  protected:
+    /// Send a fromNum notification to the phone now
+    virtual void notifyFromNum(uint32_t fromRadioNum) = 0;
+
+    virtual void onNowHasData(uint32_t fromRadioNum) override;
+
+    virtual int32_t runOnce() override;
+
+  private:
+    uint32_t lastNotifyMsec = 0;
+    uint32_t pendingFromNum = 0;
+    bool notifyPending = false;
+
+    uint8_t pendingPacket[meshtastic_FromRadio_size]; // the packet that didn't fit in the last packed read
+    size_t pendingPacketLen = 0;
+};
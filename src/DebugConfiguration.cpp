@@ -30,6 +30,12 @@ SOFTWARE.*/
 #include "platform/portduino/PortduinoGlue.h"
 #endif
 
+#if HAS_NETWORKING && SYSLOG_QUEUE_BYTES
+#include "LogRing.h"
+#include "concurrency/LockGuard.h"
+#include "concurrency/OSThread.h"
+#endif
+
 /// A C wrapper for LOG_DEBUG that can be used from arduino C libs that don't know about C++ or meshtastic
 extern "C" void logLegacy(const char *level, const char *fmt, ...)
 {
@@ -42,6 +48,29 @@ extern "C" void logLegacy(const char *level, const char *fmt, ...)
 
 #if HAS_NETWORKING
 
+#if SYSLOG_QUEUE_BYTES
+/// Longest line queued, longer ones are cut short
+#define SYSLOG_LINE_LEN 256
+
+/// How often the sender looks for lines while there were none
+#define SYSLOG_IDLE_INTERVAL_MS 100
+
+/// Sends the queued syslog lines
+class SyslogSender : public concurrency::OSThread
+{
+    Syslog &syslog;
+
+  public:
+    explicit SyslogSender(Syslog &syslog) : concurrency::OSThread("Syslog"), syslog(syslog) {}
+
+  protected:
+    virtual int32_t runOnce() override
+    {
+        return syslog.sendQueued(SYSLOG_SEND_PER_RUN) ? SYSLOG_SEND_INTERVAL_MS : SYSLOG_IDLE_INTERVAL_MS;
+    }
+};
+#endif
+
 Syslog::Syslog(UDP &client)
 {
     this->_client = &client;
@@ -97,6 +126,13 @@ Syslog &Syslog::logMask(uint8_t priMask)
 
 void Syslog::enable()
 {
+#if SYSLOG_QUEUE_BYTES
+    if (!this->_queue) {
+        this->_queueLock = new concurrency::Lock();
+        this->_sender = new SyslogSender(*this);
+        this->_queue = new LogRing(new uint8_t[SYSLOG_QUEUE_BYTES], SYSLOG_QUEUE_BYTES);
+    }
+#endif
     this->_client->begin(this->_port);
     this->_enabled = true;
 }
@@ -105,6 +141,14 @@ void Syslog::disable()
 {
     this->_enabled = false;
     this->_client->stop();
+#if SYSLOG_QUEUE_BYTES
+    if (this->_queue) {
+        concurrency::LockGuard guard(this->_queueLock);
+        while (!this->_queue->empty())
+            this->_queue->pop();
+        this->_queue->takeDropped();
+    }
+#endif
 }
 
 bool Syslog::isEnabled()
@@ -119,6 +163,29 @@ bool Syslog::vlogf(uint16_t pri, const char *fmt, va_list args)
 
 bool Syslog::vlogf(uint16_t pri, const char *appName, const char *fmt, va_list args)
 {
+#if SYSLOG_QUEUE_BYTES
+    if (this->_queue) {
+        if (!this->_enabled)
+            return false;
+        if ((LOG_MASK(LOG_PRI(pri)) & this->_priMask) == 0)
+            return true;
+
+        // The priority, then the text.  Static because RedirectablePrint only logs to us with its print lock held
+        static char line[1 + SYSLOG_LINE_LEN];
+        int len = vsnprintf(line + 1, sizeof(line) - 1, fmt, args);
+        if (len < 0)
+            return false;
+        if (len > SYSLOG_LINE_LEN - 1)
+            len = SYSLOG_LINE_LEN - 1;
+        line[0] = (char)pri;
+
+        // No thread name means our own appName
+        concurrency::LockGuard guard(this->_queueLock);
+        this->_queue->pushDroppingOldest(NULL, appName == this->_appName ? NULL : appName, line, 1 + len);
+        return true;
+    }
+#endif
+
     char *message;
     size_t initialLen;
     size_t len;
@@ -142,6 +209,45 @@ bool Syslog::vlogf(uint16_t pri, const char *appName, const char *fmt, va_list a
     return result;
 }
 
+#if SYSLOG_QUEUE_BYTES
+bool Syslog::sendQueued(size_t maxLines)
+{
+    for (size_t i = 0; i < maxLines; i++) {
+        char message[SYSLOG_LINE_LEN];
+        char appName[sizeof(LogRing::Record::threadName)];
+        uint16_t pri = 0;
+        uint32_t dropped;
+        bool have;
+        {
+            concurrency::LockGuard guard(this->_queueLock);
+            dropped = this->_queue->takeDropped();
+            LogRing::Record r;
+            have = this->_queue->peek(r);
+            if (have) {
+                // The line is copied out so the send happens without the lock, logging can go on meanwhile
+                pri = (uint8_t)r.text[0];
+                memcpy(message, r.text + 1, r.len - 1);
+                message[r.len - 1] = '\0';
+                memcpy(appName, r.threadName, sizeof(appName));
+                this->_queue->pop();
+            }
+        }
+
+        if (dropped) {
+            char note[48];
+            snprintf(note, sizeof(note), "%u syslog messages dropped, the queue was full", (unsigned)dropped);
+            this->_sendLog(SYSLOG_WARN, this->_appName, note);
+        }
+        if (!have)
+            return false;
+        this->_sendLog(pri, appName[0] ? appName : this->_appName, message);
+    }
+
+    concurrency::LockGuard guard(this->_queueLock);
+    return !this->_queue->empty();
+}
+#endif
+
 inline bool Syslog::_sendLog(uint16_t pri, const char *appName, const char *message)
 {
     int result;
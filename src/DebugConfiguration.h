@@ -24,6 +24,20 @@
 #define MESHTASTIC_LOG_LEVEL_CRIT "CRIT "
 #define MESHTASTIC_LOG_LEVEL_TRACE "TRACE"
 
+// The same levels as numbers, more verbose is higher (in the order of the portduino level_* settings)
+#define MESHTASTIC_LOG_LEVEL_NUM_CRIT 0
+#define MESHTASTIC_LOG_LEVEL_NUM_ERROR 0
+#define MESHTASTIC_LOG_LEVEL_NUM_WARN 1
+#define MESHTASTIC_LOG_LEVEL_NUM_INFO 2
+#define MESHTASTIC_LOG_LEVEL_NUM_DEBUG 3
+#define MESHTASTIC_LOG_LEVEL_NUM_TRACE 4
+
+// The most verbose level built in, LOG_* calls above it compile to nothing. E.g. -DMESHTASTIC_LOG_MAX_LEVEL=2 leaves out
+// debug and trace messages.
+#ifndef MESHTASTIC_LOG_MAX_LEVEL
+#define MESHTASTIC_LOG_MAX_LEVEL MESHTASTIC_LOG_LEVEL_NUM_TRACE
+#endif
+
 #include "SerialConsole.h"
 
 // If defined we will include support for ARM ICE "semihosting" for a virtual
@@ -46,12 +60,18 @@
 #define LOG_TRACE(...) SEGGER_RTT_printf(0, __VA_ARGS__)
 #else
 #if defined(DEBUG_PORT) && !defined(DEBUG_MUTE)
-#define LOG_DEBUG(...) DEBUG_PORT.log(MESHTASTIC_LOG_LEVEL_DEBUG, __VA_ARGS__)
-#define LOG_INFO(...) DEBUG_PORT.log(MESHTASTIC_LOG_LEVEL_INFO, __VA_ARGS__)
-#define LOG_WARN(...) DEBUG_PORT.log(MESHTASTIC_LOG_LEVEL_WARN, __VA_ARGS__)
-#define LOG_ERROR(...) DEBUG_PORT.log(MESHTASTIC_LOG_LEVEL_ERROR, __VA_ARGS__)
-#define LOG_CRIT(...) DEBUG_PORT.log(MESHTASTIC_LOG_LEVEL_CRIT, __VA_ARGS__)
-#define LOG_TRACE(...) DEBUG_PORT.log(MESHTASTIC_LOG_LEVEL_TRACE, __VA_ARGS__)
+// The level is checked before the arguments are evaluated or anything is formatted
+#define MESHTASTIC_LOG(num, level, ...)                                                                                          \
+    do {                                                                                                                         \
+        if ((num) <= MESHTASTIC_LOG_MAX_LEVEL && DEBUG_PORT.isLogLevelEnabled(num))                                              \
+            DEBUG_PORT.log(num, level, __VA_ARGS__);                                                                             \
+    } while (0)
+#define LOG_DEBUG(...) MESHTASTIC_LOG(MESHTASTIC_LOG_LEVEL_NUM_DEBUG, MESHTASTIC_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) MESHTASTIC_LOG(MESHTASTIC_LOG_LEVEL_NUM_INFO, MESHTASTIC_LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...) MESHTASTIC_LOG(MESHTASTIC_LOG_LEVEL_NUM_WARN, MESHTASTIC_LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) MESHTASTIC_LOG(MESHTASTIC_LOG_LEVEL_NUM_ERROR, MESHTASTIC_LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_CRIT(...) MESHTASTIC_LOG(MESHTASTIC_LOG_LEVEL_NUM_CRIT, MESHTASTIC_LOG_LEVEL_CRIT, __VA_ARGS__)
+#define LOG_TRACE(...) MESHTASTIC_LOG(MESHTASTIC_LOG_LEVEL_NUM_TRACE, MESHTASTIC_LOG_LEVEL_TRACE, __VA_ARGS__)
 #else
 #define LOG_DEBUG(...)
 #define LOG_INFO(...)
@@ -67,6 +87,20 @@ extern "C" void logLegacy(const char *level, const char *fmt, ...);
 
 #define SYSLOG_NILVALUE "-"
 
+/// Bytes of syslog lines kept for a thread of their own to send, dropping the oldest when it is full, so the UDP sends don't
+/// happen in whatever thread logged.  0 sends each line as it is logged
+#ifndef SYSLOG_QUEUE_BYTES
+#define SYSLOG_QUEUE_BYTES 0
+#endif
+
+/// With SYSLOG_QUEUE_BYTES, the most lines (one datagram each) sent every SYSLOG_SEND_INTERVAL_MS
+#ifndef SYSLOG_SEND_PER_RUN
+#define SYSLOG_SEND_PER_RUN 8
+#endif
+#ifndef SYSLOG_SEND_INTERVAL_MS
+#define SYSLOG_SEND_INTERVAL_MS 20
+#endif
+
 #define SYSLOG_CRIT 2  /* critical conditions */
 #define SYSLOG_ERR 3   /* error conditions */
 #define SYSLOG_WARN 4  /* warning conditions */
@@ -136,6 +170,15 @@ extern "C" void logLegacy(const char *level, const char *fmt, ...);
 
 #if HAS_NETWORKING
 
+#if SYSLOG_QUEUE_BYTES
+class LogRing;
+namespace concurrency
+{
+class Lock;
+class OSThread;
+} // namespace concurrency
+#endif
+
 class Syslog
 {
   private:
@@ -148,6 +191,11 @@ class Syslog
     uint16_t _priDefault;
     uint8_t _priMask = 0xff;
     bool _enabled = false;
+#if SYSLOG_QUEUE_BYTES
+    LogRing *_queue = NULL; // allocated when first enabled
+    concurrency::Lock *_queueLock = NULL;
+    concurrency::OSThread *_sender = NULL;
+#endif
 
     bool _sendLog(uint16_t pri, const char *appName, const char *message);
 
@@ -167,6 +215,12 @@ class Syslog
 
     bool vlogf(uint16_t pri, const char *fmt, va_list args) __attribute__((format(printf, 3, 0)));
     bool vlogf(uint16_t pri, const char *appName, const char *fmt, va_list args) __attribute__((format(printf, 3, 0)));
+
+#if SYSLOG_QUEUE_BYTES
+    /// Send up to maxLines of the queued lines
+    /// @return true if there are more
+    bool sendQueued(size_t maxLines);
+#endif
 };
 
 #endif // HAS_NETWORKING
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include "EventTrace.h"
+#include "configuration.h"
+
+#if EVENT_TRACE && defined(ARCH_PORTDUINO)
+
+#include "concurrency/LockGuard.h"
+#include "concurrency/OSThread.h"
+#include <atomic>
+#include <chrono>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+/// Events kept between writes, more are dropped (and counted) until the writer catches up
+#ifndef EVENT_TRACE_MAX_BUFFERED
+#define EVENT_TRACE_MAX_BUFFERED 65536
+#endif
+
+/// How often buffered events are written out
+#ifndef EVENT_TRACE_FLUSH_MSEC
+#define EVENT_TRACE_FLUSH_MSEC 1000
+#endif
+
+namespace EventTrace
+{
+
+struct Event {
+    char phase; // 'X' complete, 'C' counter, 'M' thread name
+    uint32_t tid;
+    uint64_t ts;
+    uint64_t dur;
+    int64_t value;
+    char name[40];
+};
+
+static std::atomic<bool> recording(false);
+static std::atomic<uint32_t> nextTid(1);
+static std::atomic<uint32_t> dropped(0);
+static concurrency::Lock *lock;
+static std::vector<Event> buffered, writing; // swapped by the writer, so recording never waits for the disk
+static FILE *file;
+
+static thread_local uint32_t tid; // 0 until the thread's first event
+
+static void flush();
+
+class Writer : public concurrency::OSThread
+{
+  public:
+    Writer() : concurrency::OSThread("EventTrace") {}
+
+  protected:
+    virtual int32_t runOnce() override
+    {
+        flush();
+        return EVENT_TRACE_FLUSH_MSEC;
+    }
+};
+
+static Writer *writer;
+
+static void writeName(const char *name)
+{
+    for (const char *c = name; *c; c++) {
+        if (*c == '"' || *c == '\\')
+            fputc('\\', file);
+        if ((unsigned char)*c >= ' ')
+            fputc(*c, file);
+    }
+}
+
+static void flush()
+{
+    {
+        concurrency::LockGuard guard(lock);
+        writing.swap(buffered);
+    }
+    if (!file) {
+        writing.clear();
+        return;
+    }
+    for (const Event &e : writing) {
+        fprintf(file, "{\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"name\":\"", e.phase, e.tid, (unsigned long long)e.ts);
+        writeName(e.phase == 'M' ? "thread_name" : e.name);
+        if (e.phase == 'X')
+            fprintf(file, "\",\"dur\":%llu},\n", (unsigned long long)e.dur);
+        else if (e.phase == 'C')
+            fprintf(file, "\",\"args\":{\"value\":%lld}},\n", (long long)e.value);
+        else {
+            fputs("\",\"args\":{\"name\":\"", file);
+            writeName(e.name);
+            fputs("\"}},\n", file);
+        }
+    }
+    writing.clear();
+
+    uint32_t lost = dropped.exchange(0);
+    if (lost)
+        fprintf(file, "{\"ph\":\"i\",\"pid\":1,\"tid\":0,\"ts\":%llu,\"s\":\"g\",\"name\":\"%u events dropped\"},\n",
+                (unsigned long long)now(), lost);
+    fflush(file);
+}
+
+uint64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void record(char phase, const char *name, uint64_t ts, uint64_t dur, int64_t value)
+{
+    if (!recording.load(std::memory_order_relaxed))
+        return;
+
+    concurrency::LockGuard guard(lock);
+    if (buffered.size() + 2 > EVENT_TRACE_MAX_BUFFERED) {
+        dropped++;
+        return;
+    }
+
+    Event e;
+    if (!tid) {
+        // Name the track after the OS thread
+        tid = nextTid++;
+        e.tid = tid;
+        e.phase = 'M';
+        e.ts = ts;
+        if (pthread_getname_np(pthread_self(), e.name, sizeof(e.name)) != 0)
+            snprintf(e.name, sizeof(e.name), "thread %u", tid);
+        buffered.push_back(e);
+    }
+    e.tid = tid;
+    e.phase = phase;
+    e.ts = ts;
+    e.dur = dur;
+    e.value = value;
+    strncpy(e.name, name, sizeof(e.name) - 1);
+    e.name[sizeof(e.name) - 1] = '\0';
+    buffered.push_back(e);
+}
+
+void complete(const char *name, uint64_t startUs, uint64_t endUs)
+{
+    record('X', name, startUs, endUs - startUs, 0);
+}
+
+void counter(const char *name, int64_t value)
+{
+    record('C', name, now(), 0, value);
+}
+
+bool start(const char *path)
+{
+    if (!lock)
+        lock = new concurrency::Lock();
+    file = fopen(path, "w");
+    if (!file) {
+        LOG_ERROR("Can't open event trace %s: %s", path, strerror(errno));
+        return false;
+    }
+    fputs("[\n", file);
+    buffered.reserve(EVENT_TRACE_MAX_BUFFERED);
+    writing.reserve(EVENT_TRACE_MAX_BUFFERED);
+    if (!writer)
+        writer = new Writer();
+    recording = true;
+    LOG_INFO("Trace events to %s", path);
+    return true;
+}
+
+void stop()
+{
+    if (!recording)
+        return;
+    recording = false;
+    flush();
+    fclose(file);
+    file = NULL;
+}
+
+} // namespace EventTrace
+
+#endif
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+
+/// Set to 1 to record trace events (see EventTrace) on meshtasticd, written where Logging: EventTraceFile says
+#ifndef EVENT_TRACE
+#define EVENT_TRACE 0
+#endif
+
+#if EVENT_TRACE && defined(ARCH_PORTDUINO)
+#define TRACE_SCOPE(name) EventTrace::Scope eventTraceScope##__LINE__(name)
+#define TRACE_COUNTER(name, value) EventTrace::counter(name, value)
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_COUNTER(name, value)
+#endif
+
+/**
+ * Chrome trace events, to see where the cooperative loop spends its time and how late threads get to run.  Open the file in
+ * Perfetto (ui.perfetto.dev) or chrome://tracing.
+ *
+ * TRACE_SCOPE(name) records a complete event from there to the end of the enclosing block, TRACE_COUNTER(name, value) a
+ * counter sample.  Events are only kept in memory where they happen; a thread of its own writes them out in batches.  Names
+ * are copied, they needn't outlive the event.  Without EVENT_TRACE both macros are nothing.
+ */
+namespace EventTrace
+{
+
+#if EVENT_TRACE && defined(ARCH_PORTDUINO)
+/// Start writing events to path, as a JSON array the viewers accept unterminated (so a crash doesn't lose the file)
+bool start(const char *path);
+
+/// Write out what is buffered and stop recording
+void stop();
+
+void complete(const char *name, uint64_t startUs, uint64_t endUs);
+
+void counter(const char *name, int64_t value);
+
+/// Microseconds on the trace clock
+uint64_t now();
+
+class Scope
+{
+  public:
+    explicit Scope(const char *name) : name(name), startUs(now()) {}
+    ~Scope() { complete(name, startUs, now()); }
+
+  private:
+    const char *name;
+    uint64_t startUs;
+};
+#endif
+
+} // namespace EventTrace
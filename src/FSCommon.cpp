@@ -40,8 +40,8 @@ SPIClass SPI_HSPI(HSPI);
 bool copyFile(const char *from, const char *to)
 {
 #ifdef FSCom
-    // take SPI Lock
-    concurrency::LockGuard g(spiLock);
+    // take the filesystem lock
+    concurrency::LockGuard g(fsLock);
     unsigned char cbuffer[16];
 
     File f1 = FSCom.open(from, FILE_O_READ);
@@ -64,6 +64,7 @@ bool copyFile(const char *from, const char *to)
     f2.flush();
     f2.close();
     f1.close();
+    invalidateFileManifest();
     return true;
 #endif
 }
@@ -81,15 +82,17 @@ bool renameFile(const char *pathFrom, const char *pathTo)
 #ifdef FSCom
 
 #ifdef ARCH_ESP32
-    // take SPI Lock
-    spiLock->lock();
+    // take the filesystem lock
+    fsLock->lock();
     // rename was fixed for ESP32 IDF LittleFS in April
     bool result = FSCom.rename(pathFrom, pathTo);
-    spiLock->unlock();
+    fsLock->unlock();
+    invalidateFileManifest();
     return result;
 #else
     // copyFile does its own locking.
     if (copyFile(pathFrom, pathTo) && FSCom.remove(pathFrom)) {
+        invalidateFileManifest();
         return true;
     } else {
         return false;
@@ -152,6 +155,32 @@ std::vector<meshtastic_FileInfo> getFiles(const char *dirname, uint8_t levels)
     return filenames;
 }
 
+static std::vector<meshtastic_FileInfo> fileManifest;
+static volatile bool fileManifestValid = false;
+
+/**
+ * @brief The file list sent to clients on connect, all files up to ten levels deep.
+ *
+ * Walking the whole filesystem takes seconds once range test logs and InkHUD data pile up, so the list is kept until
+ * invalidateFileManifest() says something changed.  Like getFiles(), callers should hold SPILOCK.
+ */
+const std::vector<meshtastic_FileInfo> &getFileManifest()
+{
+    if (!fileManifestValid) {
+        fileManifestValid = true; // before walking, so a write during the walk invalidates again
+        fileManifest = getFiles("/", 10);
+    }
+    return fileManifest;
+}
+
+/**
+ * Call after creating, growing, renaming or removing a file so the next getFileManifest() walks the filesystem again.
+ */
+void invalidateFileManifest()
+{
+    fileManifestValid = false;
+}
+
 /**
  * Lists the contents of a directory.
  * We can't use SPILOCK here because of recursion. Callers of this function should use SPILOCK.
@@ -275,6 +304,7 @@ void rmDir(const char *dirname)
     // nRF52 implementation of LittleFS has a recursive delete function
     FSCom.rmdir_r(dirname);
 #endif
+    invalidateFileManifest();
 
 #endif
 }
@@ -287,7 +317,7 @@ __attribute__((weak, noinline)) void preFSBegin() {}
 void fsInit()
 {
 #ifdef FSCom
-    concurrency::LockGuard g(spiLock);
+    concurrency::LockGuard g(fsLock);
     preFSBegin();
     if (!FSBegin()) {
         LOG_ERROR("Filesystem mount failed");
@@ -0,0 +1,179 @@
+#include "HeapTracker.h"
+#include "configuration.h"
+#include "memGet.h"
+#include "mesh/MemoryPool.h"
+
+#if HEAP_TRACKING
+#include "FlatHashMap.h"
+#include "freertosinc.h"
+
+// new can be called from any task, and taking a Lock might itself allocate
+#ifdef ARCH_ESP32
+static portMUX_TYPE trackerMux = portMUX_INITIALIZER_UNLOCKED;
+#define TRACKER_LOCK() portENTER_CRITICAL(&trackerMux)
+#define TRACKER_UNLOCK() portEXIT_CRITICAL(&trackerMux)
+#elif defined(HAS_FREE_RTOS)
+#define TRACKER_LOCK() taskENTER_CRITICAL()
+#define TRACKER_UNLOCK() taskEXIT_CRITICAL()
+#else
+#define TRACKER_LOCK()
+#define TRACKER_UNLOCK()
+#endif
+
+namespace
+{
+struct Header {
+    uint16_t site;
+    uint16_t magic;
+    uint32_t size;
+}; // 8 bytes, so what follows stays 8 byte aligned
+
+const uint16_t HEADER_MAGIC = 0x4854;
+const uint16_t OTHER_SITE = HEAP_TRACKER_SITES; // the last slot
+
+const uint16_t INDEX_SIZE = 2 * HEAP_TRACKER_SITES; // power of two, at most half full
+
+// Plain zero initialised arrays rather than a FlatHashMap, static constructors call new before ours would have run
+HeapTracker::Site sites[HEAP_TRACKER_SITES + 1];
+uint16_t numSites;
+uint32_t indexCallers[INDEX_SIZE]; // open addressing caller -> indexSites, 0 for empty
+uint16_t indexSites[INDEX_SIZE];
+
+// Called with the lock held
+uint16_t siteFor(void *caller)
+{
+    uint32_t key = (uintptr_t)caller;
+    uint16_t i = flatHashMix32(key) & (INDEX_SIZE - 1);
+    while (indexCallers[i]) {
+        if (indexCallers[i] == key)
+            return indexSites[i];
+        i = (i + 1) & (INDEX_SIZE - 1);
+    }
+    if (numSites >= HEAP_TRACKER_SITES)
+        return OTHER_SITE;
+
+    indexCallers[i] = key;
+    indexSites[i] = numSites;
+    sites[numSites].caller = key;
+    return numSites++;
+}
+} // namespace
+
+void *HeapTracker::alloc(size_t size, void *caller, void *(*rawAlloc)(size_t))
+{
+    Header *h = (Header *)rawAlloc(size + sizeof(Header));
+    if (!h)
+        return NULL;
+
+    TRACKER_LOCK();
+    uint16_t i = siteFor(caller);
+    Site &s = sites[i];
+    s.allocs++;
+    s.liveBytes += size;
+    if (s.liveBytes > s.peakBytes)
+        s.peakBytes = s.liveBytes;
+    TRACKER_UNLOCK();
+
+    h->site = i;
+    h->magic = HEADER_MAGIC;
+    h->size = size;
+    return h + 1;
+}
+
+void HeapTracker::free(void *p, void (*rawFree)(void *))
+{
+    if (!p)
+        return;
+
+    Header *h = (Header *)p - 1;
+    if (h->magic != HEADER_MAGIC || h->site > OTHER_SITE) {
+        LOG_ERROR("Heap tracker: delete of %p that new didn't make", p);
+        return; // leaked rather than corrupt the heap
+    }
+    h->magic = 0;
+
+    TRACKER_LOCK();
+    Site &s = sites[h->site];
+    s.frees++;
+    s.liveBytes -= h->size;
+    TRACKER_UNLOCK();
+
+    rawFree(h);
+}
+
+#ifdef ARCH_ESP32
+// nRF52 has its own in platform/nrf52/alloc.cpp
+static void *plainMalloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void plainFree(void *p)
+{
+    ::free(p);
+}
+
+void *operator new(size_t size)
+{
+    return HeapTracker::alloc(size, __builtin_return_address(0), plainMalloc);
+}
+
+void *operator new[](size_t size)
+{
+    return HeapTracker::alloc(size, __builtin_return_address(0), plainMalloc);
+}
+
+void operator delete(void *ptr)
+{
+    HeapTracker::free(ptr, plainFree);
+}
+
+void operator delete[](void *ptr)
+{
+    HeapTracker::free(ptr, plainFree);
+}
+#endif
+#endif
+
+void HeapTracker::logStats(uint8_t topSites)
+{
+    uint32_t freeHeap = memGet.getFreeHeap(), largest = memGet.getLargestFreeBlock();
+    if (largest != UINT32_MAX && freeHeap)
+        LOG_INFO("Heap: %u free, %u lowest, largest block %u (%u%% fragmented)", freeHeap, memGet.getMinFreeHeap(), largest,
+                 100 - (uint32_t)((uint64_t)largest * 100 / freeHeap));
+
+    for (const MemoryPoolStats *p = MemoryPoolStats::first(); p; p = p->nextPool())
+        LOG_INFO("Pool %s: %u/%u free, high water %u, %u heap fallbacks", p->getName(), (uint32_t)p->getFree(),
+                 (uint32_t)p->getMaxSize(), (uint32_t)p->getHighWaterMark(), p->getHeapFallbacks());
+
+#if HEAP_TRACKING
+    // Take the biggest holders under the lock, then log them without it
+    Site top[16];
+    if (topSites > 16)
+        topSites = 16;
+    uint8_t n = 0;
+    TRACKER_LOCK();
+    for (uint16_t i = 0; i <= OTHER_SITE; i++) {
+        const Site &s = sites[i];
+        if (!s.allocs || !topSites)
+            continue;
+        if (n < topSites)
+            n++;
+        else if (top[n - 1].liveBytes >= s.liveBytes)
+            continue;
+        // Insertion into top, kept sorted by live bytes
+        uint8_t j = n - 1;
+        while (j > 0 && top[j - 1].liveBytes < s.liveBytes) {
+            top[j] = top[j - 1];
+            j--;
+        }
+        top[j] = s;
+    }
+    TRACKER_UNLOCK();
+
+    LOG_INFO("Heap sites holding the most (site, live/peak bytes, allocs/frees):");
+    for (uint8_t i = 0; i < n; i++)
+        LOG_INFO("  0x%08x: %u/%u, %u/%u", (uint32_t)top[i].caller, top[i].liveBytes, top[i].peakBytes, top[i].allocs,
+                 top[i].frees);
+#endif
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Set to 1 to count heap allocations made with new per call site (see HeapTracker), costs 8 bytes and a hash lookup per
+/// allocation.  Implemented on ESP32 and nRF52, where we own operator new.
+#ifndef HEAP_TRACKING
+#define HEAP_TRACKING 0
+#endif
+
+/// Number of distinct call sites we keep counts for, allocations from any others are counted together
+#ifndef HEAP_TRACKER_SITES
+#define HEAP_TRACKER_SITES 64
+#endif
+
+/**
+ * Per call site heap accounting, to find what slowly eats the heap on long running nodes.
+ *
+ * Each allocation gets a small header recording its size and the site that made it, so frees are charged back to the same
+ * site.  A site is the return address of operator new, look it up in the firmware's .map or with addr2line.
+ */
+class HeapTracker
+{
+  public:
+    struct Site {
+        uintptr_t caller; // 0 for all the sites that didn't fit
+        uint32_t allocs;
+        uint32_t frees;
+        uint32_t liveBytes;
+        uint32_t peakBytes;
+    };
+
+#if HEAP_TRACKING
+    /// Allocate size bytes with rawAlloc and charge them to caller
+    static void *alloc(size_t size, void *caller, void *(*rawAlloc)(size_t));
+
+    /// Free p, which must have come from alloc(), with rawFree
+    static void free(void *p, void (*rawFree)(void *));
+#endif
+
+    /// Log heap fragmentation, the packet pools and (with HEAP_TRACKING) the sites holding the most memory
+    static void logStats(uint8_t topSites = 8);
+};
@@ -0,0 +1,116 @@
+#include "I2CBus.h"
+#include <Arduino.h>
+#include <Throttle.h>
+
+I2CBus *I2CBus::get(TwoWire *wire)
+{
+    static I2CBus bus0(&Wire);
+#if WIRE_INTERFACES_COUNT == 2
+    static I2CBus bus1(&Wire1);
+    if (wire == &Wire1)
+        return &bus1;
+#endif
+    if (wire != &Wire)
+        LOG_WARN("I2C bus %p unknown, sharing the first bus's lock", wire);
+    return &bus0;
+}
+
+void I2CBus::setDeviceClock(uint8_t addr, uint32_t clockHz)
+{
+    concurrency::LockGuard g(&lock);
+    Device *d = devices.findOrInsert(addr);
+    if (d)
+        d->clockHz = clockHz;
+}
+
+// Called with the lock held
+void I2CBus::begin(uint8_t addr)
+{
+    startUs = micros();
+    const Device *d = devices.find(addr);
+    uint32_t clockHz = (d && d->clockHz) ? d->clockHz : defaultClockHz;
+    if (clockHz != currentClockHz) {
+        wire->setClock(clockHz);
+        currentClockHz = clockHz;
+    }
+}
+
+// Called with the lock held
+void I2CBus::end(uint8_t addr, uint32_t bytes, bool ok)
+{
+    Device *d = devices.findOrInsert(addr);
+    if (d) {
+        d->stats.transactions++;
+        d->stats.bytes += bytes;
+        d->stats.busyUs += micros() - startUs;
+        if (!ok)
+            d->stats.errors++;
+    }
+
+    if (I2C_BUS_STATS_SECS && !Throttle::isWithinTimespanMs(lastStatsMs, I2C_BUS_STATS_SECS * 1000UL)) {
+        lastStatsMs = millis();
+        printStats();
+    }
+}
+
+bool I2CBus::readRegisters(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t len)
+{
+    concurrency::LockGuard g(&lock);
+    begin(addr);
+
+    wire->beginTransmission(addr);
+    wire->write(reg);
+    bool ok = wire->endTransmission() == 0;
+    uint8_t got = 0;
+    if (ok) {
+        wire->requestFrom(addr, len);
+        while (got < len && wire->available())
+            data[got++] = wire->read();
+        ok = got == len;
+    }
+
+    end(addr, 1 + got, ok);
+    return ok;
+}
+
+bool I2CBus::write(uint8_t addr, const uint8_t *data, uint8_t len)
+{
+    concurrency::LockGuard g(&lock);
+    begin(addr);
+
+    wire->beginTransmission(addr);
+    wire->write(data, len);
+    bool ok = wire->endTransmission() == 0;
+
+    end(addr, len, ok);
+    return ok;
+}
+
+uint8_t I2CBus::read(uint8_t addr, uint8_t *data, uint8_t len)
+{
+    concurrency::LockGuard g(&lock);
+    begin(addr);
+
+    wire->requestFrom(addr, len);
+    uint8_t got = 0;
+    while (got < len && wire->available())
+        data[got++] = wire->read();
+
+    end(addr, got, got > 0);
+    return got;
+}
+
+void I2CBus::logStats()
+{
+    concurrency::LockGuard g(&lock);
+    printStats();
+}
+
+// Called with the lock held
+void I2CBus::printStats()
+{
+    devices.forEach([](const uint8_t &addr, const Device &d) {
+        LOG_DEBUG("I2C 0x%02x: %u transactions, %u bytes, %u errors, %ums busy", addr, d.stats.transactions, d.stats.bytes,
+                  d.stats.errors, d.stats.busyUs / 1000);
+    });
+}
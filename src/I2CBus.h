@@ -0,0 +1,95 @@
+#pragma once
+
+#include "FlatHashMap.h"
+#include "concurrency/LockGuard.h"
+#include "configuration.h"
+#include <Wire.h>
+
+// Bus clock for devices that haven't asked for another with setDeviceClock()
+#ifndef I2C_BUS_CLOCK_HZ
+#define I2C_BUS_CLOCK_HZ 100000
+#endif
+
+// Log how much bus time each device used this often, 0 for never
+#ifndef I2C_BUS_STATS_SECS
+#define I2C_BUS_STATS_SECS 0
+#endif
+
+/**
+ * Serializes the transactions of every driver that shares one I2C bus (TwoWire), so keyboard polling, sensor reads and the
+ * PMU each get the bus to themselves, and keeps count of the bus time each device uses.
+ *
+ * Each device can have its own clock (a keyboard polled many times a second can run at 400 kHz while a slow sensor keeps
+ * 100 kHz); the clock is only changed when the next transaction is for a device that wants a different one.
+ *
+ * Drivers that read several registers ask for them in one transaction with readRegisters() rather than one at a time.
+ * Libraries that take a TwoWire and do their own transactions don't go through here.
+ */
+class I2CBus
+{
+  public:
+    struct DeviceStats {
+        uint32_t transactions = 0;
+        uint32_t bytes = 0;
+        uint32_t errors = 0;
+        uint32_t busyUs = 0; // time spent on the bus, including any clock change
+    };
+
+    explicit I2CBus(TwoWire *wire) : wire(wire) {}
+
+    /// The bus for wire, one per TwoWire
+    static I2CBus *get(TwoWire *wire);
+
+    TwoWire *getWire() const { return wire; }
+
+    /// Talk to addr at clockHz from now on, 0 for the bus default
+    void setDeviceClock(uint8_t addr, uint32_t clockHz);
+
+    /// Change the clock of devices that haven't asked for their own
+    void setDefaultClock(uint32_t clockHz) { defaultClockHz = clockHz; }
+
+    /// Read len consecutive registers starting at reg in one transaction, the device must auto-increment
+    bool readRegisters(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t len);
+
+    bool readRegister(uint8_t addr, uint8_t reg, uint8_t &value) { return readRegisters(addr, reg, &value, 1); }
+
+    /// Write len bytes as-is (usually a register followed by its values)
+    bool write(uint8_t addr, const uint8_t *data, uint8_t len);
+
+    bool writeRegister(uint8_t addr, uint8_t reg, uint8_t value)
+    {
+        uint8_t data[2] = {reg, value};
+        return write(addr, data, sizeof(data));
+    }
+
+    /// Read up to len bytes without selecting a register first
+    /// @return how many were read
+    uint8_t read(uint8_t addr, uint8_t *data, uint8_t len);
+
+    /// Call f(addr, stats) for every device that has used the bus
+    template <class F> void forEachDevice(F f)
+    {
+        concurrency::LockGuard g(&lock);
+        devices.forEach([&](const uint8_t &addr, const Device &d) { f(addr, d.stats); });
+    }
+
+    void logStats();
+
+  private:
+    struct Device {
+        uint32_t clockHz = 0; // 0 for the default
+        DeviceStats stats;
+    };
+
+    TwoWire *wire;
+    concurrency::Lock lock;
+    uint32_t defaultClockHz = I2C_BUS_CLOCK_HZ;
+    uint32_t currentClockHz = 0; // what wire is set to, 0 if not set by us yet
+    uint32_t startUs = 0;
+    uint32_t lastStatsMs = 0;
+    FlatHashMap<uint8_t, Device, 32> devices;
+
+    void begin(uint8_t addr);
+    void end(uint8_t addr, uint32_t bytes, bool ok);
+    void printStats();
+};
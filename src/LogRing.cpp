@@ -0,0 +1,93 @@
+#include "LogRing.h"
+#include <string.h>
+
+bool LogRing::push(const char *logLevel, const char *threadName, const char *text, size_t len)
+{
+    if (tryPush(logLevel, threadName, text, len))
+        return true;
+    dropped++;
+    return false;
+}
+
+void LogRing::pushDroppingOldest(const char *logLevel, const char *threadName, const char *text, size_t len)
+{
+    while (!tryPush(logLevel, threadName, text, len)) {
+        dropped++;
+        if (count == 0)
+            return; // bigger than the whole ring
+        pop();
+    }
+}
+
+bool LogRing::tryPush(const char *logLevel, const char *threadName, const char *text, size_t len)
+{
+    if (len > UINT16_MAX)
+        len = UINT16_MAX;
+    size_t need = sizeof(Header) + len;
+
+    if (count == 0) {
+        head = tail = 0;
+        wrap = size;
+    }
+
+    size_t at;
+    if (tail >= head) {
+        if (size - tail >= need) {
+            at = tail;
+        } else if (need < head) {
+            // Leave the rest of the end unused, tail must stay behind head so it can't look empty
+            wrap = tail;
+            at = 0;
+        } else {
+            return false;
+        }
+    } else if (head - tail > need) {
+        at = tail;
+    } else {
+        return false;
+    }
+
+    Header h;
+    h.logLevel = logLevel;
+    memset(h.threadName, 0, sizeof(h.threadName));
+    if (threadName)
+        strncpy(h.threadName, threadName, sizeof(h.threadName) - 1);
+    h.len = len;
+    memcpy(buf + at, &h, sizeof(h));
+    memcpy(buf + at + sizeof(h), text, len);
+    tail = at + need;
+    count++;
+    return true;
+}
+
+bool LogRing::peek(Record &r) const
+{
+    if (count == 0)
+        return false;
+
+    Header h;
+    memcpy(&h, buf + head, sizeof(h));
+    r.logLevel = h.logLevel;
+    memcpy(r.threadName, h.threadName, sizeof(r.threadName));
+    r.len = h.len;
+    r.text = (const char *)buf + head + sizeof(h);
+    return true;
+}
+
+void LogRing::pop()
+{
+    if (count == 0)
+        return;
+
+    Header h;
+    memcpy(&h, buf + head, sizeof(h));
+    head += sizeof(h) + h.len;
+    count--;
+    if (count == 0) {
+        head = tail = 0;
+        wrap = size;
+    } else if (head == wrap) {
+        head = 0;
+        wrap = size;
+    }
+}
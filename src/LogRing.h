@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Formatted log messages waiting to be printed, in a byte ring so short messages only take the space they need.
+ *
+ * Each record is a header (level, thread name, length) followed by the text.  A record never wraps around the end of the
+ * buffer; if it doesn't fit before the end it goes at the start, and the reader skips the unused tail.
+ *
+ * Not thread safe, RedirectablePrint only uses it under its print lock and Syslog under its queue lock.
+ */
+class LogRing
+{
+  public:
+    struct Record {
+        const char *logLevel; // one of the MESHTASTIC_LOG_LEVEL_* strings
+        char threadName[16];
+        uint16_t len;
+        const char *text; // not NUL terminated
+    };
+
+    LogRing(uint8_t *buf, size_t size) : buf(buf), size(size), wrap(size) {}
+
+    /// @return false if there's no room, the message is dropped and counted
+    bool push(const char *logLevel, const char *threadName, const char *text, size_t len);
+
+    /// As push(), but makes room by dropping the oldest messages (counted) rather than the new one
+    void pushDroppingOldest(const char *logLevel, const char *threadName, const char *text, size_t len);
+
+    /// The oldest record, valid until pop()
+    /// @return false if there are none
+    bool peek(Record &r) const;
+
+    void pop();
+
+    bool empty() const { return count == 0; }
+
+    /// Messages dropped since last asked
+    uint32_t takeDropped()
+    {
+        uint32_t n = dropped;
+        dropped = 0;
+        return n;
+    }
+
+  private:
+    struct Header {
+        const char *logLevel;
+        char threadName[16];
+        uint16_t len;
+    };
+
+    uint8_t *buf;
+    size_t size;
+    size_t head = 0, tail = 0; // read and write positions
+    size_t wrap;               // where the reader goes back to the start, size when the records don't wrap
+    size_t count = 0;
+    uint32_t dropped = 0;
+
+    /// push() without counting a message that doesn't fit
+    bool tryPush(const char *logLevel, const char *threadName, const char *text, size_t len);
+};
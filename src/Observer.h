@@ -1,16 +1,84 @@
 #pragma once
 
 #include <Arduino.h>
-#include <list>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 
 template <class T> class Observable;
 
+/**
+ * The pointers an Observer or Observable keeps, in the order they were added.  Lives in the storage it is given, and if
+ * allowed to grow moves to the heap once that is full, so observing costs no allocation per entry and notifying walks an
+ * array rather than a linked list.
+ */
+template <class P> class ObserverList
+{
+    P **items;
+    uint8_t count = 0;
+    uint8_t capacity;
+    bool growable;
+    bool onHeap = false;
+
+  public:
+    ObserverList(P **storage, uint8_t capacity, bool growable) : items(storage), capacity(capacity), growable(growable) {}
+
+    ~ObserverList()
+    {
+        if (onHeap)
+            free(items);
+    }
+
+    ObserverList(const ObserverList &) = delete;
+    ObserverList &operator=(const ObserverList &) = delete;
+
+    uint8_t size() const { return count; }
+
+    P *operator[](uint8_t i) const { return items[i]; }
+
+    /// @return false if there is no room and we may not grow
+    bool add(P *p)
+    {
+        if (count == capacity) {
+            if (!growable || capacity > UINT8_MAX - 4)
+                return false;
+            P **grown = (P **)malloc((capacity + 4) * sizeof(P *));
+            if (!grown)
+                return false;
+            if (count)
+                memcpy(grown, items, count * sizeof(P *));
+            if (onHeap)
+                free(items);
+            items = grown;
+            onHeap = true;
+            capacity += 4;
+        }
+        items[count++] = p;
+        return true;
+    }
+
+    /// Remove every copy of p, keeping the others in order
+    void remove(P *p)
+    {
+        uint8_t kept = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            if (items[i] != p)
+                items[kept++] = items[i];
+        }
+        count = kept;
+    }
+
+    void clear() { count = 0; }
+};
+
 /**
  * An observer which can be mixed in as a baseclass.  Implement onNotify as a method in your class.
  */
 template <class T> class Observer
 {
-    std::list<Observable<T> *> observables;
+    // Nearly every observer watches a single observable, which then needs no heap
+    Observable<T> *firstObservable[1];
+    ObserverList<Observable<T>> observables = ObserverList<Observable<T>>(firstObservable, 1, true);
 
   public:
     virtual ~Observer();
@@ -55,9 +123,11 @@ template <class Callback, class T> class CallbackObserver : public Observer<T>
  */
 template <class T> class Observable
 {
-    std::list<Observer<T> *> observers;
+    ObserverList<Observer<T>> observers;
 
   public:
+    Observable() : observers(NULL, 0, true) {}
+
     /**
      * Tell all observers about a change, observers can process arg as they wish
      *
@@ -65,31 +135,52 @@ template <class T> class Observable
      */
     int notifyObservers(T arg)
     {
-        for (typename std::list<Observer<T> *>::const_iterator iterator = observers.begin(); iterator != observers.end();
-             ++iterator) {
-            int result = (*iterator)->onNotify(arg);
+        for (uint8_t i = 0; i < observers.size();) {
+            Observer<T> *o = observers[i];
+            int result = o->onNotify(arg);
             if (result != 0)
                 return result;
+            if (i < observers.size() && observers[i] == o)
+                i++; // otherwise o unobserved itself and the next one has moved into its place
         }
 
         return 0;
     }
 
+  protected:
+    /// For ObservableArray, which never grows beyond the storage it gives us
+    Observable(Observer<T> **storage, uint8_t capacity) : observers(storage, capacity, false) {}
+
   private:
     friend class Observer<T>;
 
     // Not called directly, instead call observer.observe
-    void addObserver(Observer<T> *o) { observers.push_back(o); }
+    bool addObserver(Observer<T> *o)
+    {
+        bool added = observers.add(o);
+        assert(added); // an ObservableArray with too small a capacity
+        return added;
+    }
 
     void removeObserver(Observer<T> *o) { observers.remove(o); }
 };
 
+/**
+ * An Observable with room for a fixed number of observers and no heap use at all.  Meant for frequently notified sources
+ * whose observers are known up front, observing one that is already full is a bug.
+ */
+template <class T, uint8_t N> class ObservableArray : public Observable<T>
+{
+    Observer<T> *storage[N];
+
+  public:
+    ObservableArray() : Observable<T>(storage, N) {}
+};
+
 template <class T> Observer<T>::~Observer()
 {
-    for (typename std::list<Observable<T> *>::const_iterator iterator = observables.begin(); iterator != observables.end();
-         ++iterator) {
-        (*iterator)->removeObserver(this);
-    }
+    for (uint8_t i = 0; i < observables.size(); i++)
+        observables[i]->removeObserver(this);
     observables.clear();
 }
 
@@ -101,6 +192,6 @@ template <class T> void Observer<T>::unobserve(Observable<T> *o)
 
 template <class T> void Observer<T>::observe(Observable<T> *o)
 {
-    observables.push_back(o);
-    o->addObserver(this);
+    if (o->addObserver(this))
+        observables.add(o);
 }
\ No newline at end of file
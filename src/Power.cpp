@@ -214,6 +214,125 @@ static void adcDisable()
 #endif
 }
 
+/**
+ * Set to 1 on nRF52 to read the battery with the SAADC in the background: each reading starts the next conversion, which the
+ * SAADC averages in hardware (BATTERY_SAADC_OVERSAMPLE) and EasyDMA stores, and the one after picks the result up.  The main
+ * loop no longer spins over BATTERY_SENSE_SAMPLES analogRead()s.  Boards that switch their divider with ADC_CTRL keep the
+ * blocking reads, the divider would have to stay on between readings.
+ */
+#ifndef BATTERY_SAADC_DMA
+#define BATTERY_SAADC_DMA 0
+#endif
+
+#if BATTERY_SAADC_DMA && defined(ARCH_NRF52) && !defined(ADC_CTRL)
+#define BATTERY_SAADC 1
+
+/// log2 of the samples the SAADC averages into one result, 4 is 16x
+#ifndef BATTERY_SAADC_OVERSAMPLE
+#define BATTERY_SAADC_OVERSAMPLE 4
+#endif
+
+#ifndef BATTERY_SENSE_RESOLUTION_BITS // same default initAnalogBattery() uses
+#define BATTERY_SENSE_RESOLUTION_BITS 10
+#endif
+
+#define SAADC_NO_RESULT INT16_MIN
+
+static volatile int16_t saadcResult = SAADC_NO_RESULT; // written by EasyDMA
+
+/// The SAADC input BATTERY_PIN is wired to
+static uint32_t saadcInput()
+{
+    switch (g_ADigitalPinMap[BATTERY_PIN]) {
+    case 2:
+        return SAADC_CH_PSELP_PSELP_AnalogInput0;
+    case 3:
+        return SAADC_CH_PSELP_PSELP_AnalogInput1;
+    case 4:
+        return SAADC_CH_PSELP_PSELP_AnalogInput2;
+    case 5:
+        return SAADC_CH_PSELP_PSELP_AnalogInput3;
+    case 28:
+        return SAADC_CH_PSELP_PSELP_AnalogInput4;
+    case 29:
+        return SAADC_CH_PSELP_PSELP_AnalogInput5;
+    case 30:
+        return SAADC_CH_PSELP_PSELP_AnalogInput6;
+    case 31:
+        return SAADC_CH_PSELP_PSELP_AnalogInput7;
+    default:
+        return SAADC_CH_PSELP_PSELP_NC;
+    }
+}
+
+/// The gain that gives AREF_VOLTAGE full scale with the 0.6V internal reference, like analogReference() picks
+static uint32_t saadcGain()
+{
+    if (AREF_VOLTAGE > 3.0)
+        return SAADC_CH_CONFIG_GAIN_Gain1_6;
+    if (AREF_VOLTAGE > 2.4)
+        return SAADC_CH_CONFIG_GAIN_Gain1_5;
+    if (AREF_VOLTAGE > 1.8)
+        return SAADC_CH_CONFIG_GAIN_Gain1_4;
+    if (AREF_VOLTAGE > 1.2)
+        return SAADC_CH_CONFIG_GAIN_Gain1_3;
+    if (AREF_VOLTAGE > 0.6)
+        return SAADC_CH_CONFIG_GAIN_Gain1_2;
+    return SAADC_CH_CONFIG_GAIN_Gain1;
+}
+
+/// Start a conversion and return without waiting for it
+static void saadcStart()
+{
+    uint32_t input = saadcInput();
+    if (input == SAADC_CH_PSELP_PSELP_NC)
+        return;
+
+    NRF_SAADC->ENABLE = SAADC_ENABLE_ENABLE_Enabled << SAADC_ENABLE_ENABLE_Pos;
+    NRF_SAADC->RESOLUTION = BATTERY_SENSE_RESOLUTION_BITS >= 14   ? SAADC_RESOLUTION_VAL_14bit
+                            : BATTERY_SENSE_RESOLUTION_BITS >= 12 ? SAADC_RESOLUTION_VAL_12bit
+                            : BATTERY_SENSE_RESOLUTION_BITS >= 10 ? SAADC_RESOLUTION_VAL_10bit
+                                                                  : SAADC_RESOLUTION_VAL_8bit;
+    NRF_SAADC->OVERSAMPLE = BATTERY_SAADC_OVERSAMPLE;
+    NRF_SAADC->SAMPLERATE = SAADC_SAMPLERATE_MODE_Task << SAADC_SAMPLERATE_MODE_Pos;
+    for (int i = 0; i < 8; i++) {
+        NRF_SAADC->CH[i].PSELP = SAADC_CH_PSELP_PSELP_NC;
+        NRF_SAADC->CH[i].PSELN = SAADC_CH_PSELN_PSELN_NC;
+    }
+    // Burst takes all the oversamples on one SAMPLE task
+    NRF_SAADC->CH[0].CONFIG = (saadcGain() << SAADC_CH_CONFIG_GAIN_Pos) |
+                              (SAADC_CH_CONFIG_REFSEL_Internal << SAADC_CH_CONFIG_REFSEL_Pos) |
+                              (SAADC_CH_CONFIG_TACQ_10us << SAADC_CH_CONFIG_TACQ_Pos) |
+                              (SAADC_CH_CONFIG_MODE_SE << SAADC_CH_CONFIG_MODE_Pos) |
+                              (SAADC_CH_CONFIG_BURST_Enabled << SAADC_CH_CONFIG_BURST_Pos);
+    NRF_SAADC->CH[0].PSELP = input;
+
+    saadcResult = SAADC_NO_RESULT;
+    NRF_SAADC->RESULT.PTR = (uint32_t)&saadcResult;
+    NRF_SAADC->RESULT.MAXCNT = 1;
+    NRF_SAADC->EVENTS_END = 0;
+    NRF_SAADC->EVENTS_STARTED = 0;
+    NRF_SAADC->TASKS_START = 1;
+    while (!NRF_SAADC->EVENTS_STARTED) // the buffer pointer is latched within a few clocks
+        ;
+    NRF_SAADC->EVENTS_STARTED = 0;
+    NRF_SAADC->TASKS_SAMPLE = 1;
+}
+
+/// The result of the last saadcStart(), false if it is not there (never started, or an analogRead() elsewhere took the SAADC)
+static bool saadcCollect(uint32_t *raw)
+{
+    int16_t result = saadcResult;
+    if (!NRF_SAADC->EVENTS_END || result == SAADC_NO_RESULT)
+        return false;
+
+    NRF_SAADC->EVENTS_END = 0;
+    NRF_SAADC->ENABLE = SAADC_ENABLE_ENABLE_Disabled << SAADC_ENABLE_ENABLE_Pos;
+    *raw = result < 0 ? 0 : result; // single ended can dip just below 0
+    return true;
+}
+#endif
+
 #endif
 
 /**
@@ -311,13 +430,21 @@ class AnalogBatteryLevel : public HasBatteryLevel
             scaled = esp_adc_cal_raw_to_voltage(raw, adc_characs);
             scaled *= operativeAdcMultiplier;
 #else // block for all other platforms
-            for (uint32_t i = 0; i < BATTERY_SENSE_SAMPLES; i++) {
-                raw += analogRead(BATTERY_PIN);
+#ifdef BATTERY_SAADC
+            if (!saadcCollect(&raw))
+#endif
+            {
+                for (uint32_t i = 0; i < BATTERY_SENSE_SAMPLES; i++) {
+                    raw += analogRead(BATTERY_PIN);
+                }
+                raw = raw / BATTERY_SENSE_SAMPLES;
             }
-            raw = raw / BATTERY_SENSE_SAMPLES;
             scaled = operativeAdcMultiplier * ((1000 * AREF_VOLTAGE) / pow(2, BATTERY_SENSE_RESOLUTION_BITS)) * raw;
 #endif
             adcDisable();
+#ifdef BATTERY_SAADC
+            saadcStart(); // for the next reading
+#endif
 
             if (!initial_read_done) {
                 // Flush the smoothing filter with an ADC reading, if the reading is plausibly correct
@@ -55,6 +55,12 @@ static bool isPowered()
     return !isPowerSavingMode && powerStatus && (!powerStatus->getHasBattery() || powerStatus->getHasUSB());
 }
 
+#if POWER_STATE_STATS
+static void countStateTime();
+#else
+static inline void countStateTime() {}
+#endif
+
 static void sdsEnter()
 {
     LOG_DEBUG("State: SDS");
@@ -82,6 +88,7 @@ static uint32_t secsSlept;
 static void lsEnter()
 {
     LOG_INFO("lsEnter begin, ls_secs=%u", config.power.ls_secs);
+    countStateTime();
     if (screen)
         screen->setOn(false);
     secsSlept = 0; // How long have we been sleeping this time
@@ -161,6 +168,7 @@ static void lsExit()
 static void nbEnter()
 {
     LOG_DEBUG("State: NB");
+    countStateTime();
     if (screen)
         screen->setOn(false);
 #ifdef ARCH_ESP32
@@ -173,6 +181,7 @@ static void nbEnter()
 
 static void darkEnter()
 {
+    countStateTime();
     setBluetoothEnable(true);
     if (screen)
         screen->setOn(false);
@@ -181,6 +190,7 @@ static void darkEnter()
 static void serialEnter()
 {
     LOG_DEBUG("State: SERIAL");
+    countStateTime();
     setBluetoothEnable(false);
     if (screen) {
         screen->setOn(true);
@@ -196,6 +206,7 @@ static void serialExit()
 static void powerEnter()
 {
     // LOG_DEBUG("State: POWER");
+    countStateTime();
     if (!isPowered()) {
         // If we got here, we are in the wrong state - we should be in powered, let that state handle things
         LOG_INFO("Loss of power in Powered");
@@ -227,6 +238,7 @@ static void powerExit()
 static void onEnter()
 {
     LOG_DEBUG("State: ON");
+    countStateTime();
     if (screen)
         screen->setOn(true);
     setBluetoothEnable(true);
@@ -243,6 +255,7 @@ static void onIdle()
 static void bootEnter()
 {
     LOG_DEBUG("State: BOOT");
+    countStateTime();
 }
 
 State stateSHUTDOWN(shutdownEnter, NULL, NULL, "SHUTDOWN");
@@ -257,6 +270,58 @@ State stateON(onEnter, onIdle, NULL, "ON");
 State statePOWER(powerEnter, powerIdle, powerExit, "POWER");
 Fsm powerFSM(&stateBOOT);
 
+#if POWER_NB_LIGHT_SLEEP && defined(ARCH_ESP32)
+static uint32_t nbSleptMs; // Part of the time in NB spent in light sleep
+
+bool PowerFSM_idleSleep(uint32_t msec)
+{
+    if (powerFSM.getState() != &stateNB || msec < POWER_NB_LIGHT_SLEEP_MIN_MS)
+        return false;
+    // The radio is mid packet, or some other service needs the CPU awake
+    if (!doPreflightSleep())
+        return false;
+
+    uint32_t start = millis();
+    powerMon->setState(meshtastic_PowerMon_State_CPU_LightSleep);
+    ledBlink.set(false);
+    doLightSleep(msec); // A radio IRQ wakes us early, its ISR then runs as usual
+    powerMon->clearState(meshtastic_PowerMon_State_CPU_LightSleep);
+    nbSleptMs += millis() - start;
+    return true;
+}
+#endif
+
+#if POWER_STATE_STATS
+static State *const countedStates[] = {&stateBOOT, &stateON, &statePOWER, &stateSERIAL, &stateDARK, &stateNB, &stateLS};
+static const uint8_t numCountedStates = sizeof(countedStates) / sizeof(countedStates[0]);
+static uint32_t stateMs[numCountedStates];
+static uint32_t stateEnteredMs;
+
+// Called from each enter(), while getState() is still the state we are leaving
+static void countStateTime()
+{
+    uint32_t now = millis();
+    const State *from = powerFSM.getState();
+    for (uint8_t i = 0; i < numCountedStates; i++) {
+        if (countedStates[i] == from)
+            stateMs[i] += now - stateEnteredMs;
+    }
+    stateEnteredMs = now;
+}
+
+void PowerFSM_logStateTimes()
+{
+    uint32_t secs[numCountedStates];
+    for (uint8_t i = 0; i < numCountedStates; i++)
+        secs[i] = (stateMs[i] + (countedStates[i] == powerFSM.getState() ? millis() - stateEnteredMs : 0)) / 1000;
+    LOG_INFO("Secs per power state: BOOT %u, ON %u, POWER %u, SERIAL %u, DARK %u, NB %u, LS %u", secs[0], secs[1], secs[2],
+             secs[3], secs[4], secs[5], secs[6]);
+#if POWER_NB_LIGHT_SLEEP && defined(ARCH_ESP32)
+    LOG_INFO("Secs in light sleep during NB: %u", nbSleptMs / 1000);
+#endif
+}
+#endif
+
 void PowerFSM_setup()
 {
     bool isRouter = (config.device.role == meshtastic_Config_DeviceConfig_Role_ROUTER ? 1 : 0);
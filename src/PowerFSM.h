@@ -22,6 +22,21 @@
 #define EVENT_SHUTDOWN 16        // force a full shutdown now (not just sleep)
 #define EVENT_INPUT 17           // input broker wants something, we need to wake up and enable screen
 
+/// In NB, light-sleep the CPU between thread deadlines. The radio keeps receiving and its IRQ wakes us (ESP32 only)
+#ifndef POWER_NB_LIGHT_SLEEP
+#define POWER_NB_LIGHT_SLEEP 0
+#endif
+
+/// Idle gaps shorter than this are not worth entering light sleep for
+#ifndef POWER_NB_LIGHT_SLEEP_MIN_MS
+#define POWER_NB_LIGHT_SLEEP_MIN_MS 20
+#endif
+
+/// Count the time spent in each power state, logged with the local stats
+#ifndef POWER_STATE_STATS
+#define POWER_STATE_STATS 0
+#endif
+
 #if MESHTASTIC_EXCLUDE_POWER_FSM
 class FakeFsm
 {
@@ -45,7 +60,16 @@ void PowerFSM_setup();
 #else
 #include <Fsm.h>
 extern Fsm powerFSM;
-extern State stateON, statePOWER, stateSERIAL, stateDARK;
+extern State stateON, statePOWER, stateSERIAL, stateDARK, stateNB;
 
 void PowerFSM_setup();
+
+#if POWER_NB_LIGHT_SLEEP && defined(ARCH_ESP32)
+/// Light-sleep for up to msec if we are in NB and nothing is in flight, @return false if the caller should delay instead
+bool PowerFSM_idleSleep(uint32_t msec);
+#endif
+
+#if POWER_STATE_STATS
+void PowerFSM_logStateTimes();
+#endif
 #endif
\ No newline at end of file
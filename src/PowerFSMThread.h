@@ -35,6 +35,11 @@ class PowerFSMThread : public OSThread
             powerFSM.trigger(EVENT_SHUTDOWN);
         }
 
+#if POWER_NB_LIGHT_SLEEP && defined(ARCH_ESP32)
+        // NB only has timeouts of several seconds to check, and each run here cuts a light sleep short
+        if (state == &stateNB)
+            return 1000;
+#endif
         return 100;
 #else
         return INT32_MAX;
@@ -12,6 +12,7 @@ bool PowerMon::is_power_enabled(uint64_t m)
 void PowerMon::setState(_meshtastic_PowerMon_State state, const char *reason)
 {
 #ifdef USE_POWERMON
+    accumulateDwell();
     auto oldstates = states;
     states |= state;
     if (oldstates != states && is_power_enabled(state)) {
@@ -23,6 +24,7 @@ void PowerMon::setState(_meshtastic_PowerMon_State state, const char *reason)
 void PowerMon::clearState(_meshtastic_PowerMon_State state, const char *reason)
 {
 #ifdef USE_POWERMON
+    accumulateDwell();
     auto oldstates = states;
     states &= ~state;
     if (oldstates != states && is_power_enabled(state)) {
@@ -39,6 +41,46 @@ void PowerMon::emitLog(const char *reason)
 #endif
 }
 
+void PowerMon::accumulateDwell()
+{
+    if (!dwellRunning)
+        return;
+    uint32_t now = millis();
+    for (int i = 0; i < POWERMON_NUM_STATES; i++)
+        if (states & (1ULL << i))
+            dwellMs[i] += now - lastChangeMs;
+    lastChangeMs = now;
+}
+
+void PowerMon::startDwell()
+{
+    memset(dwellMs, 0, sizeof(dwellMs));
+    dwellStartMs = lastChangeMs = millis();
+    dwellRunning = true;
+}
+
+void PowerMon::logDwell(const char *label)
+{
+#ifdef USE_POWERMON
+    accumulateDwell();
+    dwellRunning = false;
+
+    static const float stateMa[] = POWERMON_STATE_MA;
+    static_assert(sizeof(stateMa) / sizeof(stateMa[0]) == POWERMON_NUM_STATES, "POWERMON_STATE_MA needs a current per state");
+    uint32_t totalMs = lastChangeMs - dwellStartMs;
+    uint32_t asleepMs = dwellMs[0] + dwellMs[1]; // DeepSleep, LightSleep
+    float uAh = (float)(totalMs - asleepMs) * POWERMON_AWAKE_MA / 3600;
+    for (int i = 0; i < POWERMON_NUM_STATES; i++) {
+        if (!dwellMs[i])
+            continue;
+        uint32_t stateUAh = dwellMs[i] * stateMa[i] / 3600;
+        uAh += stateUAh;
+        LOG_INFO("S:PD:%s,0x%x,%u,%u", label, 1u << i, dwellMs[i], stateUAh); // state, ms on, estimated uAh
+    }
+    LOG_INFO("S:PD:%s,total,%u,%u", label, totalMs, (uint32_t)uAh);
+#endif
+}
+
 PowerMon *powerMon;
 
 void powerMonInit()
@@ -7,6 +7,23 @@
 #define USE_POWERMON // FIXME turn this only for certain builds
 #endif
 
+/// The PowerMon_State bits, DeepSleep (bit 0) through GPS_Active (bit 11)
+#define POWERMON_NUM_STATES 12
+
+/**
+ * Rough current of each state in mA, by bit, for the charge estimate of logDwell(): a board with an SX1262 at full power, an
+ * OLED and an L76K class GPS.  Variants that know better define their own, an external meter on the PowerMon log is the
+ * real measure.
+ */
+#ifndef POWERMON_STATE_MA
+#define POWERMON_STATE_MA {0.01f, 1.5f, 5, 5, 120, 0, 15, 5, 10, 0, 80, 25}
+#endif
+
+/// Rough current of the CPU while it isn't in any sleep state, in mA
+#ifndef POWERMON_AWAKE_MA
+#define POWERMON_AWAKE_MA 40
+#endif
+
 /**
  * The singleton class for monitoring power consumption of device
  * subsystems/modes.
@@ -31,7 +48,20 @@ class PowerMon
     void setState(_meshtastic_PowerMon_State state, const char *reason = "");
     void clearState(_meshtastic_PowerMon_State state, const char *reason = "");
 
+    /// Start timing how long each state is on, from now
+    void startDwell();
+
+    /// Log each state's time on since startDwell(), with an estimate of the charge it took (see POWERMON_STATE_MA), and stop
+    void logDwell(const char *label);
+
   private:
+    uint32_t dwellMs[POWERMON_NUM_STATES] = {};
+    uint32_t dwellStartMs = 0, lastChangeMs = 0;
+    bool dwellRunning = false;
+
+    // Credit the time since the last change to the states that were on
+    void accumulateDwell();
+
     // Emit the coded log message
     void emitLog(const char *reason);
 
@@ -19,6 +19,10 @@
 #if HAS_NETWORKING
 extern Syslog syslog;
 #endif
+
+// Longest format (plus the newline) log() copies without allocating, far more than any in the tree
+#define LOG_FORMAT_BUF_LEN 256
+
 void RedirectablePrint::rpInit()
 {
 #ifdef HAS_FREE_RTOS
@@ -158,12 +162,10 @@ void RedirectablePrint::log_to_serial(const char *logLevel, const char *format,
         printf("| ??:??:?? %u ", millis() / 1000);
 #endif
     }
-    auto thread = concurrency::OSThread::currentThread;
-    if (thread) {
+    const char *threadName = getLogThreadName();
+    if (threadName) {
         print("[");
-        // printf("%p ", thread);
-        // assert(thread->ThreadName.length());
-        print(thread->ThreadName);
+        print(threadName);
         print("] ");
     }
     r += vprintf(logLevel, format, arg);
@@ -194,9 +196,9 @@ void RedirectablePrint::log_to_syslog(const char *logLevel, const char *format,
         default:
             ll = 0;
         }
-        auto thread = concurrency::OSThread::currentThread;
-        if (thread) {
-            syslog.vlogf(ll, thread->ThreadName.c_str(), format, arg);
+        const char *threadName = getLogThreadName();
+        if (threadName) {
+            syslog.vlogf(ll, threadName, format, arg);
         } else {
             syslog.vlogf(ll, format, arg);
         }
@@ -215,34 +217,22 @@ void RedirectablePrint::log_to_ble(const char *logLevel, const char *format, va_
         isBleConnected = nrf52Bluetooth != nullptr && nrf52Bluetooth->isConnected();
 #endif
         if (isBleConnected) {
-            char *message;
-            size_t initialLen;
-            size_t len;
-            initialLen = strlen(format);
-            message = new char[initialLen + 1];
-            len = vsnprintf(message, initialLen + 1, format, arg);
-            if (len > initialLen) {
-                delete[] message;
-                message = new char[len + 1];
-                vsnprintf(message, len + 1, format, arg);
-            }
-            auto thread = concurrency::OSThread::currentThread;
+            const char *threadName = getLogThreadName();
             meshtastic_LogRecord logRecord = meshtastic_LogRecord_init_zero;
             logRecord.level = getLogLevel(logLevel);
-            strcpy(logRecord.message, message);
-            if (thread)
-                strcpy(logRecord.source, thread->ThreadName.c_str());
+            vsnprintf(logRecord.message, sizeof(logRecord.message), format, arg);
+            if (threadName)
+                strncpy(logRecord.source, threadName, sizeof(logRecord.source) - 1);
             logRecord.time = getValidTime(RTCQuality::RTCQualityDevice, true);
 
-            uint8_t *buffer = new uint8_t[meshtastic_LogRecord_size];
+            // Only used under the print lock
+            static uint8_t buffer[meshtastic_LogRecord_size];
             size_t size = pb_encode_to_bytes(buffer, meshtastic_LogRecord_size, meshtastic_LogRecord_fields, &logRecord);
 #ifdef ARCH_ESP32
-            nimbleBluetooth->sendLog(buffer, size);
+            nimbleBluetooth->sendLog(buffer, size, logRecord.level);
 #elif defined(ARCH_NRF52)
-            nrf52Bluetooth->sendLog(buffer, size);
+            nrf52Bluetooth->sendLog(buffer, size, logRecord.level);
 #endif
-            delete[] message;
-            delete[] buffer;
         }
     }
 #else
@@ -275,73 +265,199 @@ meshtastic_LogRecord_Level RedirectablePrint::getLogLevel(const char *logLevel)
     return ll;
 }
 
+const char *RedirectablePrint::getLogThreadName() const
+{
+    if (draining)
+        return drainingThreadName[0] ? drainingThreadName : nullptr;
+    auto thread = concurrency::OSThread::currentThread;
+    return thread ? thread->ThreadName.c_str() : nullptr;
+}
+
+uint8_t RedirectablePrint::getLevelNumber(const char *logLevel)
+{
+    switch (logLevel[0]) {
+    case 'D':
+        return MESHTASTIC_LOG_LEVEL_NUM_DEBUG;
+    case 'I':
+        return MESHTASTIC_LOG_LEVEL_NUM_INFO;
+    case 'W':
+        return MESHTASTIC_LOG_LEVEL_NUM_WARN;
+    case 'T':
+        return MESHTASTIC_LOG_LEVEL_NUM_TRACE;
+    default:
+        return MESHTASTIC_LOG_LEVEL_NUM_ERROR;
+    }
+}
+
 void RedirectablePrint::log(const char *logLevel, const char *format, ...)
 {
+    uint8_t level = getLevelNumber(logLevel);
+    if (!isLogLevelEnabled(level))
+        return;
 
-    // append \n to format
-    size_t len = strlen(format);
-    char *newFormat = new char[len + 2];
-    strcpy(newFormat, format);
-    newFormat[len] = '\n';
-    newFormat[len + 1] = '\0';
+    va_list arg;
+    va_start(arg, format);
+    vlog(level, logLevel, format, arg);
+    va_end(arg);
+}
 
+void RedirectablePrint::log(uint8_t level, const char *logLevel, const char *format, ...)
+{
+    va_list arg;
+    va_start(arg, format);
+    vlog(level, logLevel, format, arg);
+    va_end(arg);
+}
+
+void RedirectablePrint::vlog(uint8_t level, const char *logLevel, const char *format, va_list arg)
+{
 #if ARCH_PORTDUINO
     // level trace is special, two possible ways to handle it.
-    if (strcmp(logLevel, MESHTASTIC_LOG_LEVEL_TRACE) == 0) {
-        if (settingsStrings[traceFilename] != "") {
-            va_list arg;
-            va_start(arg, format);
-            try {
-                traceFile << va_arg(arg, char *) << std::endl;
-            } catch (const std::ios_base::failure &e) {
-            }
-            va_end(arg);
-        }
-        if (settingsMap[logoutputlevel] < level_trace && strcmp(logLevel, MESHTASTIC_LOG_LEVEL_TRACE) == 0) {
-            delete[] newFormat;
-            return;
+    if (level == MESHTASTIC_LOG_LEVEL_NUM_TRACE && traceFile.is_open()) {
+        va_list copy;
+        va_copy(copy, arg);
+        try {
+            traceFile << va_arg(copy, char *) << std::endl;
+        } catch (const std::ios_base::failure &e) {
         }
+        va_end(copy);
     }
-    if (settingsMap[logoutputlevel] < level_debug && strcmp(logLevel, MESHTASTIC_LOG_LEVEL_DEBUG) == 0) {
-        delete[] newFormat;
+#endif
+    if (level > outputLevel)
         return;
-    } else if (settingsMap[logoutputlevel] < level_info && strcmp(logLevel, MESHTASTIC_LOG_LEVEL_INFO) == 0) {
-        delete[] newFormat;
+    if (level == MESHTASTIC_LOG_LEVEL_NUM_DEBUG && moduleConfig.serial.override_console_serial_port)
         return;
-    } else if (settingsMap[logoutputlevel] < level_warn && strcmp(logLevel, MESHTASTIC_LOG_LEVEL_WARN) == 0) {
-        delete[] newFormat;
+
+    if (!lockPrint())
         return;
+
+    // append \n to format, in a buffer the print lock protects unless the format is unusually long
+    static char formatBuf[LOG_FORMAT_BUF_LEN];
+    size_t len = strlen(format);
+    char *newFormat = len + 2 <= sizeof(formatBuf) ? formatBuf : new char[len + 2];
+    memcpy(newFormat, format, len);
+    newFormat[len] = '\n';
+    newFormat[len + 1] = '\0';
+
+#if DEBUG_LOG_DEFERRED
+    if (deferring && level > MESHTASTIC_LOG_LEVEL_NUM_ERROR) {
+        defer(logLevel, newFormat, arg);
+    } else {
+        // Keep the order, and get errors out before anything else happens
+        drainLocked(SIZE_MAX);
+        vlogToSinks(logLevel, newFormat, arg);
     }
+#else
+    vlogToSinks(logLevel, newFormat, arg);
 #endif
-    if (moduleConfig.serial.override_console_serial_port && strcmp(logLevel, MESHTASTIC_LOG_LEVEL_DEBUG) == 0) {
+
+    if (newFormat != formatBuf)
         delete[] newFormat;
-        return;
-    }
+    unlockPrint();
+}
 
+bool RedirectablePrint::lockPrint()
+{
 #ifdef HAS_FREE_RTOS
-    if (inDebugPrint != nullptr && xSemaphoreTake(inDebugPrint, portMAX_DELAY) == pdTRUE) {
+    return inDebugPrint != nullptr && xSemaphoreTake(inDebugPrint, portMAX_DELAY) == pdTRUE;
 #else
-    if (!inDebugPrint) {
-        inDebugPrint = true;
+    if (inDebugPrint)
+        return false;
+    inDebugPrint = true;
+    return true;
 #endif
+}
 
-        va_list arg;
-        va_start(arg, format);
-
-        log_to_serial(logLevel, newFormat, arg);
-        log_to_syslog(logLevel, newFormat, arg);
-        log_to_ble(logLevel, newFormat, arg);
-
-        va_end(arg);
+void RedirectablePrint::unlockPrint()
+{
 #ifdef HAS_FREE_RTOS
-        xSemaphoreGive(inDebugPrint);
+    xSemaphoreGive(inDebugPrint);
 #else
-        inDebugPrint = false;
+    inDebugPrint = false;
 #endif
+}
+
+// Called with the print lock held
+void RedirectablePrint::vlogToSinks(const char *logLevel, const char *format, va_list arg)
+{
+    // Each sink consumes the arguments, so each gets its own copy
+    va_list copy;
+    va_copy(copy, arg);
+    log_to_serial(logLevel, format, copy);
+    va_end(copy);
+    va_copy(copy, arg);
+    log_to_syslog(logLevel, format, copy);
+    va_end(copy);
+    va_copy(copy, arg);
+    log_to_ble(logLevel, format, copy);
+    va_end(copy);
+}
+
+void RedirectablePrint::logToSinks(const char *logLevel, const char *format, ...)
+{
+    va_list arg;
+    va_start(arg, format);
+    vlogToSinks(logLevel, format, arg);
+    va_end(arg);
+}
+
+#if DEBUG_LOG_DEFERRED
+// Format once now, print later. Called with the print lock held.
+void RedirectablePrint::defer(const char *logLevel, const char *format, va_list arg)
+{
+    static char text[LOG_FORMAT_BUF_LEN];
+    int n = vsnprintf(text, sizeof(text), format, arg);
+    if (n > (int)sizeof(text) - 1) {
+        n = sizeof(text) - 1;
+        text[n - 1] = '\n';
     }
+    if (n > 0)
+        deferred.push(logLevel, getLogThreadName(), text, n);
+}
+#endif
+
+void RedirectablePrint::startDeferring()
+{
+#if DEBUG_LOG_DEFERRED
+    deferring = true;
+#endif
+}
 
-    delete[] newFormat;
-    return;
+bool RedirectablePrint::drainDeferred(size_t maxBytes)
+{
+#if DEBUG_LOG_DEFERRED
+    if (deferred.empty() || !lockPrint())
+        return !deferred.empty();
+    drainLocked(maxBytes);
+    bool more = !deferred.empty();
+    unlockPrint();
+    return more;
+#else
+    (void)maxBytes;
+    return false;
+#endif
+}
+
+// Called with the print lock held
+void RedirectablePrint::drainLocked(size_t maxBytes)
+{
+#if DEBUG_LOG_DEFERRED
+    size_t printed = 0;
+    LogRing::Record r;
+    while (printed < maxBytes && deferred.peek(r)) {
+        draining = true;
+        drainingThreadName = r.threadName;
+        logToSinks(r.logLevel, "%.*s", (int)r.len, r.text);
+        draining = false;
+        printed += r.len;
+        deferred.pop();
+    }
+    uint32_t dropped = deferred.takeDropped();
+    if (dropped)
+        logToSinks(MESHTASTIC_LOG_LEVEL_WARN, "%u log messages dropped, the log queue was full\n", dropped);
+#else
+    (void)maxBytes;
+#endif
 }
 
 void RedirectablePrint::hexDump(const char *logLevel, unsigned char *buf, uint16_t len)
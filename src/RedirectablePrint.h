@@ -1,11 +1,23 @@
 #pragma once
 
 #include "../freertosinc.h"
+#include "LogRing.h"
 #include "mesh/generated/meshtastic/mesh.pb.h"
 #include <Print.h>
 #include <stdarg.h>
 #include <string>
 
+// Queue formatted log messages in RAM and print them from SerialConsole's thread, so logging never waits on the serial port
+// (or syslog or BLE).  Errors still print straight away, after whatever is queued, in case the node is about to crash.
+#ifndef DEBUG_LOG_DEFERRED
+#define DEBUG_LOG_DEFERRED 0
+#endif
+
+// Bytes of queued messages, further messages are dropped (and counted) while it is full
+#ifndef DEBUG_LOG_DEFERRED_BYTES
+#define DEBUG_LOG_DEFERRED_BYTES 4096
+#endif
+
 /**
  * A Printable that can be switched to squirt its bytes to a different sink.
  * This class is mostly useful to allow debug printing to be redirected away from Serial
@@ -21,6 +33,16 @@ class RedirectablePrint : public Print
 #else
     volatile bool inDebugPrint = false;
 #endif
+    uint8_t outputLevel = UINT8_MAX; // most verbose level printed
+    uint8_t wantedLevel = UINT8_MAX; // most verbose level log() takes at all, above outputLevel for the portduino trace file
+#if DEBUG_LOG_DEFERRED
+    uint8_t deferredBuf[DEBUG_LOG_DEFERRED_BYTES];
+    LogRing deferred = LogRing(deferredBuf, sizeof(deferredBuf));
+    bool deferring = false;
+#endif
+    bool draining = false;                   // printing a queued message
+    const char *drainingThreadName = "";     // and the thread that logged it, empty if none
+
   public:
     explicit RedirectablePrint(Print *_dest) : dest(_dest) {}
 
@@ -41,19 +63,58 @@ class RedirectablePrint : public Print
      */
     void log(const char *logLevel, const char *format, ...) __attribute__((format(printf, 3, 4)));
 
+    /// As above, with the level also as a MESHTASTIC_LOG_LEVEL_NUM_* so it needn't be looked up from the string
+    void log(uint8_t level, const char *logLevel, const char *format, ...) __attribute__((format(printf, 4, 5)));
+
+    /// Whether log() would do anything with a message at this level (a MESHTASTIC_LOG_LEVEL_NUM_*), checked by the LOG_*
+    /// macros before formatting
+    bool isLogLevelEnabled(uint8_t level) const { return level <= wantedLevel; }
+
+    /**
+     * Print messages up to outputLevel (a MESHTASTIC_LOG_LEVEL_NUM_*).  wantedLevel can be higher for messages that are
+     * still handled but not printed.
+     */
+    void setLogLevel(uint8_t outputLevel, uint8_t wantedLevel)
+    {
+        this->outputLevel = outputLevel;
+        this->wantedLevel = wantedLevel > outputLevel ? wantedLevel : outputLevel;
+    }
+
     /** like printf but va_list based */
     size_t vprintf(const char *logLevel, const char *format, va_list arg);
 
     void hexDump(const char *logLevel, unsigned char *buf, uint16_t len);
 
+    /**
+     * With DEBUG_LOG_DEFERRED, start queueing messages rather than printing them, once something calls drainDeferred()
+     * regularly.
+     */
+    void startDeferring();
+
+    /// Print queued messages, about maxBytes of them
+    /// @return whether any are left
+    bool drainDeferred(size_t maxBytes);
+
     std::string mt_sprintf(const std::string fmt_str, ...);
 
   protected:
     /// Subclasses can override if they need to change how we format over the serial port
     virtual void log_to_serial(const char *logLevel, const char *format, va_list arg);
     meshtastic_LogRecord_Level getLogLevel(const char *logLevel);
+    /// Name of the thread that logged the message being printed, or NULL
+    const char *getLogThreadName() const;
 
   private:
+    void vlog(uint8_t level, const char *logLevel, const char *format, va_list arg);
+    bool lockPrint();
+    void unlockPrint();
+    void vlogToSinks(const char *logLevel, const char *format, va_list arg);
+    void logToSinks(const char *logLevel, const char *format, ...) __attribute__((format(printf, 3, 4)));
+#if DEBUG_LOG_DEFERRED
+    void defer(const char *logLevel, const char *format, va_list arg);
+#endif
+    void drainLocked(size_t maxBytes);
+    static uint8_t getLevelNumber(const char *logLevel);
     void log_to_syslog(const char *logLevel, const char *format, va_list arg);
     void log_to_ble(const char *logLevel, const char *format, va_list arg);
 };
\ No newline at end of file
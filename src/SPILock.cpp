@@ -4,9 +4,19 @@
 #include <assert.h>
 
 concurrency::Lock *spiLock;
+concurrency::Lock *fsLock;
 
 void initSPI()
 {
     assert(!spiLock);
     spiLock = new concurrency::Lock();
-}
\ No newline at end of file
+#if SPI_LOCK_SPLIT
+    fsLock = new concurrency::Lock();
+#else
+    fsLock = spiLock;
+#endif
+#if LOCK_STATS
+    spiLock->enableStats("SPI");
+    fsLock->enableStats("FS");
+#endif
+}
@@ -2,11 +2,22 @@
 
 #include "../concurrency/LockGuard.h"
 
+/// Give the filesystem a lock of its own instead of sharing spiLock, see fsLock
+#ifndef SPI_LOCK_SPLIT
+#define SPI_LOCK_SPLIT 0
+#endif
+
 /**
  * Used to provide mutual exclusion for access to the SPI bus.  Usage:
  * concurrency::LockGuard g(spiLock);
  */
 extern concurrency::Lock *spiLock;
 
+/**
+ * Used to provide mutual exclusion for access to the filesystem.  The filesystem is in internal flash, not on the SPI bus the
+ * radio and displays share, so with SPI_LOCK_SPLIT a long flash write no longer holds up the radio.  Otherwise this is spiLock.
+ */
+extern concurrency::Lock *fsLock;
+
 /** Setup SPI access and create the spiLock lock. */
-void initSPI();
\ No newline at end of file
+void initSPI();
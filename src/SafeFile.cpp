@@ -2,10 +2,33 @@
 
 #ifdef FSCom
 
+#ifdef ARCH_ESP32
+#include <esp_rom_crc.h>
+#endif
+
+uint32_t SafeFile::crc32(uint32_t crc, const uint8_t *buffer, size_t size)
+{
+#ifdef ARCH_ESP32
+    return esp_rom_crc32_le(crc, buffer, size); // ROM routine, a word at a time
+#else
+    // Half-byte table: two lookups a byte for 64 bytes of flash, rather than 1KB for a full table
+    static const uint32_t table[16] = {0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+                                       0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+                                       0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+    crc = ~crc;
+    while (size--) {
+        crc ^= *buffer++;
+        crc = (crc >> 4) ^ table[crc & 0x0f];
+        crc = (crc >> 4) ^ table[crc & 0x0f];
+    }
+    return ~crc;
+#endif
+}
+
 // Only way to work on both esp32 and nrf52
 static File openFile(const char *filename, bool fullAtomic)
 {
-    concurrency::LockGuard g(spiLock);
+    concurrency::LockGuard g(fsLock);
     LOG_DEBUG("Opening %s, fullAtomic=%d", filename, fullAtomic);
 #ifdef ARCH_NRF52
     FSCom.remove(filename);
@@ -34,11 +57,7 @@ SafeFile::SafeFile(const char *_filename, bool fullAtomic)
 
 size_t SafeFile::write(uint8_t ch)
 {
-    if (!f)
-        return 0;
-
-    hash ^= ch;
-    return f.write(ch);
+    return write(&ch, 1);
 }
 
 size_t SafeFile::write(const uint8_t *buffer, size_t size)
@@ -46,15 +65,13 @@ size_t SafeFile::write(const uint8_t *buffer, size_t size)
     if (!f)
         return 0;
 
-    for (size_t i = 0; i < size; i++) {
-        hash ^= buffer[i];
-    }
+    crc = crc32(crc, buffer, size);
     return f.write((uint8_t const *)buffer, size); // This nasty cast is _IMPORTANT_ otherwise the correct adafruit method does
                                                    // not get used (they made a mistake in their typing)
 }
 
 /**
- * Atomically close the file (deleting any old versions) and readback the contents to confirm the hash matches
+ * Atomically close the file (deleting any old versions) and readback the contents to confirm the CRC matches
  *
  * @return false for failure
  */
@@ -63,24 +80,31 @@ bool SafeFile::close()
     if (!f)
         return false;
 
-    spiLock->lock();
+    fsLock->lock();
+    f.flush();
     f.close();
-    spiLock->unlock();
+    fsLock->unlock();
+    invalidateFileManifest();
 
 #ifdef ARCH_NRF52
     return true;
 #endif
+#if SAFEFILE_VERIFY_ON_WRITE
     if (!testReadback())
         return false;
 
     { // Scope for lock
-        concurrency::LockGuard g(spiLock);
+        concurrency::LockGuard g(fsLock);
         // brief window of risk here ;-)
         if (fullAtomic && FSCom.exists(filename.c_str()) && !FSCom.remove(filename.c_str())) {
             LOG_ERROR("Can't remove old pref file");
             return false;
         }
     }
+#else
+    // Without the readback the rename itself replaces the old file, so there is no window without one
+    recordCrc();
+#endif
 
     String filenameTmp = filename;
     filenameTmp += ".tmp";
@@ -92,10 +116,10 @@ bool SafeFile::close()
     return true;
 }
 
-/// Read our (closed) tempfile back in and compare the hash
+/// Read our (closed) tempfile back in and compare the CRC
 bool SafeFile::testReadback()
 {
-    concurrency::LockGuard g(spiLock);
+    concurrency::LockGuard g(fsLock);
 
     String filenameTmp = filename;
     filenameTmp += ".tmp";
@@ -105,19 +129,79 @@ bool SafeFile::testReadback()
         return false;
     }
 
-    int c = 0;
-    uint8_t test_hash = 0;
-    while ((c = f2.read()) >= 0) {
-        test_hash ^= (uint8_t)c;
+    uint8_t buffer[64];
+    uint32_t test_crc = 0;
+    int n;
+    while ((n = f2.read(buffer, sizeof(buffer))) > 0) {
+        test_crc = crc32(test_crc, buffer, n);
     }
     f2.close();
 
-    if (test_hash != hash) {
-        LOG_ERROR("Readback failed hash mismatch");
+    if (test_crc != crc) {
+        LOG_ERROR("Readback failed CRC mismatch");
         return false;
     }
 
     return true;
 }
 
+/**
+ * The sidecar holds the new CRC32 and the one it replaces (little endian) and whether that one is known.  It is written before the
+ * rename, so whichever version of the file is in place after a power loss, one of the two matches it.
+ */
+void SafeFile::recordCrc()
+{
+    concurrency::LockGuard g(fsLock);
+    String crcName = filename + ".crc";
+    uint8_t bytes[9] = {0};
+
+    File old = FSCom.open(crcName.c_str(), FILE_O_READ);
+    if (old) {
+        if (old.read(bytes, sizeof(bytes)) == sizeof(bytes)) {
+            memcpy(bytes + 4, bytes, 4); // its new CRC is our previous one
+            bytes[8] = 1;
+        }
+        old.close();
+    }
+    FSCom.remove(crcName.c_str()); // FILE_O_WRITE appends on some platforms
+
+    File record = FSCom.open(crcName.c_str(), FILE_O_WRITE);
+    if (!record) {
+        LOG_WARN("Can't record CRC of %s", filename.c_str());
+        return;
+    }
+    bytes[0] = crc;
+    bytes[1] = crc >> 8;
+    bytes[2] = crc >> 16;
+    bytes[3] = crc >> 24;
+    record.write(bytes, sizeof(bytes));
+    record.close();
+}
+
+bool SafeFile::checkOnLoad(const char *filename, uint32_t crc)
+{
+    String crcName = String(filename) + ".crc";
+    File record = FSCom.open(crcName.c_str(), FILE_O_READ);
+    if (!record)
+        return true; // Written with readback, or before CRCs were recorded
+    uint8_t bytes[9];
+    bool haveRecord = record.read(bytes, sizeof(bytes)) == sizeof(bytes);
+    record.close();
+    if (!haveRecord)
+        return true;
+
+    uint32_t newCrc = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+    uint32_t prevCrc = bytes[4] | (bytes[5] << 8) | (bytes[6] << 16) | ((uint32_t)bytes[7] << 24);
+    bool havePrev = bytes[8];
+    // A power loss between recording and renaming leaves the previous version in place
+    if (crc == newCrc || (havePrev && crc == prevCrc))
+        return true;
+    if (!havePrev) {
+        LOG_WARN("Can't verify %s, its previous version had no CRC", filename);
+        return true;
+    }
+    LOG_ERROR("%s does not match its CRC, the flash copy is damaged", filename);
+    return false;
+}
+
 #endif
\ No newline at end of file
@@ -6,6 +6,15 @@
 
 #ifdef FSCom
 
+/**
+ * By default close() reads every file back and compares its CRC before committing it.  Filesystems whose rename atomically
+ * replaces the target can set this to 0: close() then only flushes and renames, and records the CRC in a "<file>.crc" sidecar
+ * that loaders check with checkOnLoad() instead.  Saves happen far more often than loads, so this halves the flash I/O of saving.
+ */
+#ifndef SAFEFILE_VERIFY_ON_WRITE
+#define SAFEFILE_VERIFY_ON_WRITE 1
+#endif
+
 /**
  * This class provides 'safe'/paranoid file writing.
  *
@@ -13,12 +22,12 @@
  * be very careful about how we write files.  This class provides a restricted (Stream only) writing API for writing to files.
  *
  * Notably:
- * - we keep a simple xor hash of all characters that were written.
+ * - we keep a CRC32 of all characters that were written.
  * - We do not allow seeking (because we want to maintain our hash)
  * - we provide an close() method which is similar to close but returns false if we were unable to successfully write the
  * file.  Also this method
  * - atomically replaces any old version of the file on the disk with our new file (after first rereading the file from the disk
- * to confirm the hash matches)
+ * to confirm the CRC matches, or with SAFEFILE_VERIFY_ON_WRITE 0 recording it for checkOnLoad())
  * - Some files are super huge so we can't do the full atomic rename/copy (because of filesystem size limits).  If !fullAtomic
  * then we still do the readback to verify file is valid so higher level code can handle failures.
  */
@@ -31,20 +40,32 @@ class SafeFile : public Print
     virtual size_t write(const uint8_t *buffer, size_t size);
 
     /**
-     * Atomically close the file (deleting any old versions) and readback the contents to confirm the hash matches
+     * Atomically close the file (deleting any old versions) and readback the contents to confirm the CRC matches
      *
      * @return false for failure
      */
     bool close();
 
+    /// CRC32 (IEEE 802.3) of buffer, continuing from crc (start with 0)
+    static uint32_t crc32(uint32_t crc, const uint8_t *buffer, size_t size);
+
+    /**
+     * Does the content of filename, with this CRC32, match what close() recorded for it?  Files without a record pass.
+     * Callers should hold SPILOCK.
+     */
+    static bool checkOnLoad(const char *filename, uint32_t crc);
+
   private:
-    /// Read our (closed) tempfile back in and compare the hash
+    /// Read our (closed) tempfile back in and compare the CRC
     bool testReadback();
 
+    /// Write the "<file>.crc" sidecar for checkOnLoad()
+    void recordCrc();
+
     String filename;
     File f;
     bool fullAtomic;
-    uint8_t hash = 0;
+    uint32_t crc = 0;
 };
 
 #endif
\ No newline at end of file
@@ -6,6 +6,10 @@
 #include "configuration.h"
 #include "time.h"
 
+#ifdef ARCH_PORTDUINO
+#include "platform/portduino/PortduinoGlue.h"
+#endif
+
 #ifdef RP2040_SLOW_CLOCK
 #define Port Serial2
 #else
@@ -17,6 +21,9 @@
 #endif
 // Defaulting to the formerly removed phone_timeout_secs value of 15 minutes
 #define SERIAL_CONNECTION_TIMEOUT (15 * 60) * 1000UL
+// With DEBUG_LOG_DEFERRED, print about this much of the queued log, this often, about 20ms of the port at 115200 baud
+#define LOG_DRAIN_BYTES_PER_RUN 256
+#define LOG_DRAIN_INTERVAL_MS 5
 
 SerialConsole *console;
 
@@ -24,6 +31,11 @@ void consoleInit()
 {
     new SerialConsole(); // Must be dynamically allocated because we are now inheriting from thread
     DEBUG_PORT.rpInit(); // Simply sets up semaphore
+#ifdef ARCH_PORTDUINO
+    // Trace messages still go to the trace file when they aren't printed
+    DEBUG_PORT.setLogLevel(settingsMap[logoutputlevel],
+                           traceFile.is_open() ? MESHTASTIC_LOG_LEVEL_NUM_TRACE : settingsMap[logoutputlevel]);
+#endif
 }
 
 void consolePrintf(const char *format, ...)
@@ -64,7 +76,12 @@ SerialConsole::SerialConsole() : StreamAPI(&Port), RedirectablePrint(&Port), con
 
 int32_t SerialConsole::runOnce()
 {
-    return runOncePart();
+    // The scheduler is running now, so queued log messages will get printed
+    startDeferring();
+    int32_t delay = runOncePart();
+    if (drainDeferred(LOG_DRAIN_BYTES_PER_RUN))
+        delay = min(delay, (int32_t)LOG_DRAIN_INTERVAL_MS);
+    return delay;
 }
 
 void SerialConsole::flush()
@@ -100,8 +117,8 @@ void SerialConsole::log_to_serial(const char *logLevel, const char *format, va_l
 {
     if (usingProtobufs && config.security.debug_log_api_enabled) {
         meshtastic_LogRecord_Level ll = RedirectablePrint::getLogLevel(logLevel);
-        auto thread = concurrency::OSThread::currentThread;
-        emitLogRecord(ll, thread ? thread->ThreadName.c_str() : "", format, arg);
+        const char *threadName = getLogThreadName();
+        emitLogRecord(ll, threadName ? threadName : "", format, arg);
     } else
         RedirectablePrint::log_to_serial(logLevel, format, arg);
 }
\ No newline at end of file
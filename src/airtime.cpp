@@ -18,6 +18,7 @@ void AirTime::logAirtime(reportTypes reportType, uint32_t airtime_ms)
         air_period_tx[0] = air_period_tx[0] + airtime_ms;
 
         this->utilizationTX[this->getPeriodUtilHour()] = this->utilizationTX[this->getPeriodUtilHour()] + airtime_ms;
+        this->txBudgetMs -= airtime_ms; // may go below zero, that has to be earned back before anything else is sent
     } else if (reportType == RX_LOG) {
         LOG_DEBUG("Packet RX: %ums", airtime_ms);
         this->airtimes.periodRX[0] = this->airtimes.periodRX[0] + airtime_ms;
@@ -29,6 +30,13 @@ void AirTime::logAirtime(reportTypes reportType, uint32_t airtime_ms)
 
     // Log all airtime type for channel utilization
     this->channelUtilization[this->getPeriodUtilMinute()] = channelUtilization[this->getPeriodUtilMinute()] + airtime_ms;
+
+#if AIRTIME_SERIES
+    addToSeries([&](AirtimeBucket &b) {
+        uint16_t &ms = reportType == TX_LOG ? b.txMs : b.rxMs;
+        ms = ms + airtime_ms < UINT16_MAX ? ms + airtime_ms : UINT16_MAX;
+    });
+#endif
 }
 
 uint8_t AirTime::currentPeriodIndex()
@@ -68,6 +76,16 @@ void AirTime::airtimeRotatePeriod()
         air_period_tx[0] = 0;
         air_period_rx[0] = 0;
 
+#if AIRTIME_TOP_TALKERS
+        logTopTalkers();
+        for (auto &table : talkers) {
+            for (AirtimeTalker &t : table) {
+                t.ms /= 2;
+                t.errMs /= 2;
+            }
+        }
+#endif
+
         this->airtimes.lastPeriodIndex = this->currentPeriodIndex();
     }
 }
@@ -144,6 +162,48 @@ bool AirTime::isTxAllowedAirUtil()
     return true;
 }
 
+// The share of the channel we may use, in percent
+static float txBudgetPercent()
+{
+    if (!myRegion || config.lora.override_duty_cycle || myRegion->dutyCycle >= 100)
+        return 100;
+    return myRegion->dutyCycle;
+}
+
+int32_t AirTime::getTxBudgetCapacityMs()
+{
+    return AIRTIME_BUDGET_WINDOW_SECS * 10 * txBudgetPercent(); // secs * 1000 ms * percent / 100
+}
+
+// Called once a second
+void AirTime::refillTxBudget()
+{
+    int32_t capacity = getTxBudgetCapacityMs();
+    int32_t refill = 10 * txBudgetPercent(); // 1000 ms * percent / 100
+    // Also brings the initial value (or a budget left from a region with a higher duty cycle) down to the capacity
+    txBudgetMs = txBudgetMs >= capacity - refill ? capacity : txBudgetMs + refill;
+}
+
+bool AirTime::isTxAllowedBudget(meshtastic_MeshPacket_Priority priority, uint32_t airtime_ms)
+{
+    // How much of the budget must be left after sending, higher priorities may use more of it
+    int32_t capacity = getTxBudgetCapacityMs();
+    int32_t reserve;
+    if (priority >= meshtastic_MeshPacket_Priority_HIGH)
+        reserve = 0; // including ACKs and alerts
+    else if (priority >= meshtastic_MeshPacket_Priority_DEFAULT)
+        reserve = capacity / 5;
+    else
+        reserve = capacity / 2; // background traffic such as telemetry goes first
+
+    // High priority packets may overdraw the budget by one packet, it is only ever a few of them
+    int32_t left = priority >= meshtastic_MeshPacket_Priority_HIGH ? txBudgetMs : txBudgetMs - (int32_t)airtime_ms;
+    if (left >= reserve)
+        return true;
+    LOG_WARN("TX airtime budget low (%d of %d ms). Skip priority %d packet", txBudgetMs, capacity, priority);
+    return false;
+}
+
 // Get the amount of minutes we have to be silent before we can send again
 uint8_t AirTime::getSilentMinutes(float txPercent, float dutyCycle)
 {
@@ -162,6 +222,10 @@ AirTime::AirTime() : concurrency::OSThread("AirTime"), airtimes({}) {}
 int32_t AirTime::runOnce()
 {
     secSinceBoot++;
+    refillTxBudget();
+#if AIRTIME_SERIES
+    rotateSeries();
+#endif
 
     uint8_t utilPeriod = this->getPeriodUtilMinute();
     uint8_t utilPeriodTX = this->getPeriodUtilHour();
@@ -195,6 +259,14 @@ int32_t AirTime::runOnce()
 
         // Reset the channelUtilization window when we roll over
         if (lastUtilPeriod != utilPeriod) {
+#if CONGESTION_AIRTIME_SCALING
+            // Before the new period's slot is cleared, so this is a full minute
+            float util = channelUtilizationPercent();
+            if (util < congestionUtilPercent)
+                congestionUtilPercent = util;
+            else
+                congestionUtilPercent += (util - congestionUtilPercent) / CHANNEL_UTILIZATION_PERIODS;
+#endif
             lastUtilPeriod = utilPeriod;
 
             this->channelUtilization[utilPeriod] = 0;
@@ -204,7 +276,164 @@ int32_t AirTime::runOnce()
             lastUtilPeriodTX = utilPeriodTX;
 
             this->utilizationTX[utilPeriodTX] = 0;
+#if CONGESTION_AIRTIME_SCALING
+            for (PortAirtime &p : portAirtime)
+                p.ms -= p.ms / MINUTES_IN_HOUR;
+#endif
         }
     }
     return (1000 * 1);
 }
+
+#if AIRTIME_TOP_TALKERS
+void AirTime::noteTalker(TalkerKind kind, uint32_t key, uint32_t airtime_ms)
+{
+    AirtimeTalker *table = talkers[kind];
+    AirtimeTalker *least = &table[0];
+    for (int i = 0; i < AIRTIME_TOP_K; i++) {
+        if (table[i].ms && table[i].key == key) {
+            table[i].ms += airtime_ms;
+            return;
+        }
+        if (table[i].ms < least->ms)
+            least = &table[i];
+    }
+    least->key = key;
+    least->errMs = least->ms;
+    least->ms += airtime_ms;
+}
+
+size_t AirTime::getTopTalkers(TalkerKind kind, AirtimeTalker *out, size_t max) const
+{
+    size_t n = 0;
+    for (const AirtimeTalker &t : talkers[kind]) {
+        if (!t.ms)
+            continue;
+        // Insertion sort, there are only AIRTIME_TOP_K of them
+        size_t i = n < max ? n++ : max;
+        while (i > 0 && out[i - 1].ms < t.ms) {
+            if (i < max)
+                out[i] = out[i - 1];
+            i--;
+        }
+        if (i < max)
+            out[i] = t;
+    }
+    return n;
+}
+
+void AirTime::logTopTalkers() const
+{
+    AirtimeTalker top[3];
+    size_t n = getTopTalkers(TALKER_PORT, top, 3);
+    for (size_t i = 0; i < n; i++)
+        LOG_INFO("Airtime by port %u: %ums (+-%u)", top[i].key, top[i].ms, top[i].errMs);
+    n = getTopTalkers(TALKER_NODE, top, 3);
+    for (size_t i = 0; i < n; i++)
+        LOG_INFO("Airtime by node 0x%x: %ums (+-%u)", top[i].key, top[i].ms, top[i].errMs);
+}
+#endif
+
+#if CONGESTION_AIRTIME_SCALING
+void AirTime::logPortAirtime(meshtastic_PortNum port, uint32_t airtime_ms)
+{
+    PortAirtime *slot = &portAirtime[0];
+    for (PortAirtime &p : portAirtime) {
+        if (p.port == port) {
+            slot = &p;
+            break;
+        }
+        if (p.ms < slot->ms)
+            slot = &p;
+    }
+    if (slot->port != port)
+        *slot = {port, 0};
+    slot->ms += airtime_ms;
+}
+
+float AirTime::congestionScale(meshtastic_PortNum port) const
+{
+    float util = congestionUtilPercent;
+    for (const PortAirtime &p : portAirtime) {
+        if (p.port == port && p.ms) {
+            util += p.ms * 100.0f / MS_IN_HOUR;
+            break;
+        }
+    }
+    float scale = util / CONGESTION_TARGET_UTIL_PERCENT;
+    if (scale < CONGESTION_MIN_SCALE)
+        return CONGESTION_MIN_SCALE;
+    if (scale > CONGESTION_MAX_SCALE)
+        return CONGESTION_MAX_SCALE;
+    return scale;
+}
+#endif
+
+#if AIRTIME_SERIES
+void AirTime::logCad(bool busy)
+{
+    addToSeries([&](AirtimeBucket &b) {
+        if (b.cadScans < UINT8_MAX) {
+            b.cadScans++;
+            b.cadBusy += busy;
+        }
+    });
+}
+
+void AirTime::logDuplicate()
+{
+    addToSeries([](AirtimeBucket &b) {
+        if (b.dupes < UINT16_MAX)
+            b.dupes++;
+    });
+}
+
+uint32_t AirTime::getSeriesBucketSecs(SeriesLevel level)
+{
+    static const uint8_t secs[SERIES_LEVELS] = {1, 10, 60};
+    return secs[level];
+}
+
+const AirtimeBucket &AirTime::getSeriesBucket(SeriesLevel level, uint8_t age) const
+{
+    uint32_t now = secSinceBoot / getSeriesBucketSecs(level);
+    return series[level][(now + AIRTIME_SERIES_BUCKETS - age % AIRTIME_SERIES_BUCKETS) % AIRTIME_SERIES_BUCKETS];
+}
+
+void AirTime::rotateSeries()
+{
+    for (uint8_t level = 0; level < SERIES_LEVELS; level++) {
+        uint32_t secs = getSeriesBucketSecs((SeriesLevel)level);
+        if (secSinceBoot % secs == 0)
+            series[level][(secSinceBoot / secs) % AIRTIME_SERIES_BUCKETS] = {};
+    }
+}
+
+float AirTime::seriesBusyPercent(SeriesLevel level, uint8_t n) const
+{
+    // Only as far back as we have been up
+    uint32_t complete = secSinceBoot / getSeriesBucketSecs(level);
+    if (n > complete)
+        n = complete;
+    if (n >= AIRTIME_SERIES_BUCKETS)
+        n = AIRTIME_SERIES_BUCKETS - 1;
+    if (n == 0)
+        return 0;
+
+    uint32_t busyMs = 0;
+    for (uint8_t age = 1; age <= n; age++) {
+        const AirtimeBucket &b = getSeriesBucket(level, age);
+        busyMs += b.rxMs + b.txMs;
+    }
+    // A packet is counted whole in the bucket it ended in, so a long one can overfill a 1 second bucket
+    float percent = busyMs * 100.0f / (n * getSeriesBucketSecs(level) * 1000);
+    return percent > 100 ? 100 : percent;
+}
+
+float AirTime::recentUtilizationPercent()
+{
+    float minute = channelUtilizationPercent();
+    float recent = seriesBusyPercent(SERIES_1S, 10);
+    return recent > minute ? recent : minute;
+}
+#endif
@@ -33,6 +33,76 @@
 #define MS_IN_MINUTE (SECONDS_IN_MINUTE * 1000)
 #define MS_IN_HOUR (MINUTES_IN_HOUR * SECONDS_IN_MINUTE * 1000)
 
+// The TX airtime budget holds this many seconds' worth of our duty cycle allowance, so short bursts can still go out
+#ifndef AIRTIME_BUDGET_WINDOW_SECS
+#define AIRTIME_BUDGET_WINDOW_SECS 600
+#endif
+
+/**
+ * Scale the position, telemetry and nodeinfo broadcast intervals (Default::getConfiguredOrDefaultMsScaled()) by the channel
+ * utilization we measure, instead of by how many nodes are online.  At CONGESTION_TARGET_UTIL_PERCENT they are as configured,
+ * above it they stretch in proportion, up to CONGESTION_MAX_SCALE times, and a port stretches a little more for the share of
+ * the channel our own packets on it took over the last hour.  A rise in utilization is followed over about a minute, a fall
+ * at once, so intervals recover as soon as the channel calms down.
+ */
+#ifndef CONGESTION_AIRTIME_SCALING
+#define CONGESTION_AIRTIME_SCALING 0
+#endif
+
+#ifndef CONGESTION_TARGET_UTIL_PERCENT
+#define CONGESTION_TARGET_UTIL_PERCENT 10
+#endif
+
+#ifndef CONGESTION_MAX_SCALE
+#define CONGESTION_MAX_SCALE 8
+#endif
+
+/// Intervals on a quiet channel shrink to this, like they do for small meshes
+#define CONGESTION_MIN_SCALE 0.6f
+
+/// Ports whose airtime we track, the least used makes room for a new one
+#define CONGESTION_PORTS 8
+
+/**
+ * Break the airtime of the packets we hear and send down by port and by the node that originated them, to see which apps
+ * and which nodes use the channel.  Shown on the "Airtime" screen and logged every hour, see AirTime::getTopTalkers().
+ */
+#ifndef AIRTIME_TOP_TALKERS
+#define AIRTIME_TOP_TALKERS 0
+#endif
+
+/// Ports and nodes tracked.  A new one takes over the least busy entry, adding to its count (a space-saving top-K sketch), so
+/// the busiest ones are kept and a count is at most errMs too high.
+#ifndef AIRTIME_TOP_K
+#define AIRTIME_TOP_K 8
+#endif
+
+/**
+ * Keep the channel's RX and TX time, CAD results and duplicates heard in rings of 1 second, 10 second and 1 minute buckets,
+ * AIRTIME_SERIES_BUCKETS of each, so spikes too short to move channelUtilizationPercent() can be seen and acted on.  Fixed
+ * memory: every event adds to the bucket filling now in each ring.  Read over admin (ADMIN_AIRTIME_SERIES_FLAG), and CSMA sizes
+ * its contention window by recentUtilizationPercent().
+ */
+#ifndef AIRTIME_SERIES
+#define AIRTIME_SERIES 0
+#endif
+
+#define AIRTIME_SERIES_BUCKETS 60
+
+struct __attribute__((packed)) AirtimeBucket {
+    uint16_t rxMs;    // every frame received, mesh packet or not
+    uint16_t txMs;    //
+    uint8_t cadScans; // channel activity checks before sending, these two stop at 255
+    uint8_t cadBusy;  //
+    uint16_t dupes;   // packets heard again
+};
+
+struct AirtimeTalker {
+    uint32_t key;   // NodeNum or meshtastic_PortNum
+    uint32_t ms;    // halved every hour
+    uint32_t errMs; // what the entry held before key took it over
+};
+
 enum reportTypes { TX_LOG, RX_LOG, RX_ALL_LOG };
 
 void logAirtime(reportTypes reportType, uint32_t airtime_ms);
@@ -61,6 +131,55 @@ class AirTime : private concurrency::OSThread
     uint8_t getSilentMinutes(float txPercent, float dutyCycle);
     bool isTxAllowedChannelUtil(bool polite = false);
     bool isTxAllowedAirUtil();
+    uint8_t getPoliteChannelUtilPercent() const { return polite_channel_util_percent; }
+
+    /**
+     * Whether a packet of this priority, taking airtime_ms to send, fits in the TX airtime budget.  The budget refills at
+     * the region's duty cycle and is spent by every transmission; low priority packets need more of it left over, so they are
+     * shed first as we approach the duty cycle limit and the important ones still get through.
+     */
+    bool isTxAllowedBudget(meshtastic_MeshPacket_Priority priority, uint32_t airtime_ms);
+    int32_t getTxBudgetMs() const { return txBudgetMs; }
+
+#if AIRTIME_TOP_TALKERS
+    enum TalkerKind { TALKER_NODE, TALKER_PORT };
+
+    /// Count airtime_ms against a node (the packet's origin) or a port (UNKNOWN_APP for packets we couldn't decode)
+    void noteTalker(TalkerKind kind, uint32_t key, uint32_t airtime_ms);
+
+    /// Copy the busiest entries of a kind to out, busiest first
+    /// @return how many there were, at most max
+    size_t getTopTalkers(TalkerKind kind, AirtimeTalker *out, size_t max) const;
+#endif
+
+#if CONGESTION_AIRTIME_SCALING
+    /// Note the airtime of a packet we originated on port
+    void logPortAirtime(meshtastic_PortNum port, uint32_t airtime_ms);
+
+    /// @return how much to stretch port's broadcast interval by, see CONGESTION_AIRTIME_SCALING
+    float congestionScale(meshtastic_PortNum port) const;
+#endif
+
+#if AIRTIME_SERIES
+    enum SeriesLevel : uint8_t { SERIES_1S, SERIES_10S, SERIES_1MIN, SERIES_LEVELS };
+
+    /// Note a channel activity check before sending, and whether it found the channel busy
+    void logCad(bool busy);
+
+    /// Note a packet heard again
+    void logDuplicate();
+
+    /// The bucket age periods back in a ring, 0 is the one filling now (age < AIRTIME_SERIES_BUCKETS)
+    const AirtimeBucket &getSeriesBucket(SeriesLevel level, uint8_t age) const;
+
+    static uint32_t getSeriesBucketSecs(SeriesLevel level);
+
+    /// How busy (RX and TX) the channel was over the last n complete buckets of a ring, in percent
+    float seriesBusyPercent(SeriesLevel level, uint8_t n) const;
+
+    /// channelUtilizationPercent(), or that of the last 10 seconds if they were busier
+    float recentUtilizationPercent();
+#endif
 
   private:
     bool firstTime = true;
@@ -70,6 +189,40 @@ class AirTime : private concurrency::OSThread
     uint8_t max_channel_util_percent = 40;
     uint8_t polite_channel_util_percent = 25;
     uint8_t polite_duty_cycle_percent = 50; // half of Duty Cycle allowance is ok for metadata
+    int32_t txBudgetMs = INT32_MAX / 2;     // airtime we may still use, see isTxAllowedBudget(). Starts out full.
+
+    int32_t getTxBudgetCapacityMs();
+    void refillTxBudget();
+
+#if AIRTIME_TOP_TALKERS
+    AirtimeTalker talkers[2][AIRTIME_TOP_K] = {};
+
+    void logTopTalkers() const;
+#endif
+
+#if CONGESTION_AIRTIME_SCALING
+    float congestionUtilPercent = 0; // channelUtilizationPercent(), smoothed, see CONGESTION_AIRTIME_SCALING
+
+    struct PortAirtime {
+        meshtastic_PortNum port;
+        uint32_t ms; // loses 1/60 every minute, so it holds about the last hour's worth
+    };
+    PortAirtime portAirtime[CONGESTION_PORTS] = {};
+#endif
+
+#if AIRTIME_SERIES
+    AirtimeBucket series[SERIES_LEVELS][AIRTIME_SERIES_BUCKETS] = {};
+
+    /// Call f(AirtimeBucket &) on the bucket filling now in each ring
+    template <typename Fn> void addToSeries(Fn f)
+    {
+        for (uint8_t level = 0; level < SERIES_LEVELS; level++)
+            f(series[level][(secSinceBoot / getSeriesBucketSecs((SeriesLevel)level)) % AIRTIME_SERIES_BUCKETS]);
+    }
+
+    /// Start the next bucket of each ring whose period just ended, called every second
+    void rotateSeries();
+#endif
 
     struct airtimeStruct {
         uint32_t periodTX[PERIODS_TO_LOG];     // AirTime transmitted
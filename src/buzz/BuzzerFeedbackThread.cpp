@@ -21,7 +21,6 @@ int BuzzerFeedbackThread::handleInputEvent(const InputEvent *event)
 
     // Track last event time for potential future use
     lastEventTime = millis();
-    needsUpdate = true;
 
     // Handle different input events with appropriate buzzer feedback
     switch (event->inputEvent) {
@@ -66,14 +65,6 @@ int BuzzerFeedbackThread::handleInputEvent(const InputEvent *event)
 
 int32_t BuzzerFeedbackThread::runOnce()
 {
-    // This thread is primarily event-driven, but we can use runOnce
-    // for any periodic tasks if needed in the future
-
-    if (needsUpdate) {
-        needsUpdate = false;
-        // Could add any periodic processing here
-    }
-
-    // Run every 100ms when active, less frequently when idle
-    return needsUpdate ? 100 : 1000;
+    // Input events arrive through inputObserver, there is nothing to poll for
+    return disable();
 }
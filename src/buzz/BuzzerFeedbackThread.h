@@ -18,7 +18,6 @@ class BuzzerFeedbackThread : public concurrency::OSThread
 
   private:
     uint32_t lastEventTime = 0;
-    bool needsUpdate = false;
 };
 
 extern BuzzerFeedbackThread *buzzerFeedbackThread;
@@ -1,5 +1,6 @@
 #include "buzz.h"
 #include "NodeDB.h"
+#include "concurrency/OSThread.h"
 #include "configuration.h"
 
 #if !defined(ARCH_ESP32) && !defined(ARCH_RP2040) && !defined(ARCH_PORTDUINO)
@@ -36,7 +37,47 @@ const int DURATION_1_2 = 500;  // 1/2 note
 const int DURATION_3_4 = 750;  // 1/4 note
 const int DURATION_1_1 = 1000; // 1/1 note
 
-void playTones(const ToneDuration *tone_durations, int size)
+#if BUZZ_BACKGROUND
+/**
+ * Plays a melody from the scheduler instead of a blocking loop.  tone() hands each note to the timer/PWM hardware, so the
+ * thread only wakes when the next note is due.
+ */
+class TonePlayer : public concurrency::OSThread
+{
+  public:
+    TonePlayer() : OSThread("TonePlayer") { disable(); }
+
+    // Replaces whatever was still playing, the newest feedback is the one that matters
+    void start(const ToneDuration *tone_durations, int size)
+    {
+        count = size < BUZZ_MAX_NOTES ? size : BUZZ_MAX_NOTES;
+        memcpy(notes, tone_durations, count * sizeof(ToneDuration));
+        next = 0;
+        enabled = true;
+        setIntervalFromNow(0);
+    }
+
+  protected:
+    int32_t runOnce() override
+    {
+        if (next >= count)
+            return disable();
+        const auto &tone_duration = notes[next++];
+        tone(config.device.buzzer_gpio, tone_duration.frequency_khz, tone_duration.duration_ms);
+        // to distinguish the notes, set a minimum time between them.
+        return 1.3 * tone_duration.duration_ms;
+    }
+
+  private:
+    ToneDuration notes[BUZZ_MAX_NOTES];
+    uint8_t count = 0;
+    uint8_t next = 0;
+};
+
+static TonePlayer *tonePlayer;
+#endif
+
+void playTones(const ToneDuration *tone_durations, int size, bool wait = false)
 {
     if (config.device.buzzer_mode == meshtastic_Config_DeviceConfig_BuzzerMode_DISABLED ||
         config.device.buzzer_mode == meshtastic_Config_DeviceConfig_BuzzerMode_NOTIFICATIONS_ONLY) {
@@ -48,6 +89,16 @@ void playTones(const ToneDuration *tone_durations, int size)
         config.device.buzzer_gpio = PIN_BUZZER;
 #endif
     if (config.device.buzzer_gpio) {
+#if BUZZ_BACKGROUND
+        if (!wait) {
+            if (!tonePlayer)
+                tonePlayer = new TonePlayer();
+            tonePlayer->start(tone_durations, size);
+            return;
+        }
+        if (tonePlayer)
+            tonePlayer->disable();
+#endif
         for (int i = 0; i < size; i++) {
             const auto &tone_duration = tone_durations[i];
             tone(config.device.buzzer_gpio, tone_duration.frequency_khz, tone_duration.duration_ms);
@@ -90,7 +141,7 @@ void playStartMelody()
 void playShutdownMelody()
 {
     ToneDuration melody[] = {{NOTE_CS4, DURATION_1_8}, {NOTE_AS3, DURATION_1_8}, {NOTE_FS3, DURATION_1_4}};
-    playTones(melody, sizeof(melody) / sizeof(ToneDuration));
+    playTones(melody, sizeof(melody) / sizeof(ToneDuration), true); // power goes off next, finish first
 }
 
 void playChirp()
@@ -1,5 +1,13 @@
 #pragma once
 
+// Play melodies from a thread instead of blocking the caller for their length
+#ifndef BUZZ_BACKGROUND
+#define BUZZ_BACKGROUND 0
+#endif
+
+// Longest melody the background player holds, longer ones are cut short
+#define BUZZ_MAX_NOTES 8
+
 void playBeep();
 void playLongBeep();
 void playStartMelody();
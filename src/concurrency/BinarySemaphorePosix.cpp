@@ -3,26 +3,83 @@
 
 #ifndef HAS_FREE_RTOS
 
+#if BINARY_SEMAPHORE_EPOLL
+#include <limits.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
 namespace concurrency
 {
 
-BinarySemaphorePosix::BinarySemaphorePosix() {}
+BinarySemaphorePosix::BinarySemaphorePosix()
+{
+#if BINARY_SEMAPHORE_EPOLL
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
 
-BinarySemaphorePosix::~BinarySemaphorePosix() {}
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    if (epollFd < 0 || eventFd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, eventFd, &ev) != 0) {
+        // Can't use the console yet (we are constructed statically), take() just falls back to a plain delay
+        if (epollFd >= 0)
+            ::close(epollFd);
+        if (eventFd >= 0)
+            ::close(eventFd);
+        epollFd = eventFd = -1;
+    }
+#endif
+}
+
+BinarySemaphorePosix::~BinarySemaphorePosix()
+{
+#if BINARY_SEMAPHORE_EPOLL
+    if (epollFd >= 0)
+        ::close(epollFd);
+    if (eventFd >= 0)
+        ::close(eventFd);
+#endif
+}
 
 /**
  * Returns false if we timed out
  */
 bool BinarySemaphorePosix::take(uint32_t msec)
 {
+#if BINARY_SEMAPHORE_EPOLL
+    if (epollFd >= 0) {
+        struct epoll_event event;
+        int n = epoll_wait(epollFd, &event, 1, msec > INT_MAX ? INT_MAX : (int)msec);
+        if (n > 0) {
+            uint64_t count;
+            while (read(eventFd, &count, sizeof(count)) > 0) // reset, we are a binary semaphore
+                ;
+        }
+        return n > 0; // n < 0 with EINTR (a signal) just counts as a timeout, like the callers expect from a spurious wake
+    }
+#endif
     delay(msec); // FIXME
     return false;
 }
 
-void BinarySemaphorePosix::give() {}
+void BinarySemaphorePosix::give()
+{
+#if BINARY_SEMAPHORE_EPOLL
+    if (eventFd >= 0) {
+        uint64_t one = 1;
+        if (write(eventFd, &one, sizeof(one)) < 0) {
+            // EAGAIN means the counter is already huge, i.e. we are already given
+        }
+    }
+#endif
+}
 
-IRAM_ATTR void BinarySemaphorePosix::giveFromISR(BaseType_t *pxHigherPriorityTaskWoken) {}
+IRAM_ATTR void BinarySemaphorePosix::giveFromISR(BaseType_t *pxHigherPriorityTaskWoken)
+{
+    give(); // our "ISRs" are other threads on Linux, and writing an eventfd is safe from any of them
+}
 
 } // namespace concurrency
 
-#endif
\ No newline at end of file
+#endif
@@ -7,9 +7,20 @@ namespace concurrency
 
 #ifndef HAS_FREE_RTOS
 
+#if defined(__linux__) && !defined(BINARY_SEMAPHORE_EPOLL)
+#define BINARY_SEMAPHORE_EPOLL 1
+#endif
+
+/**
+ * On Linux this waits in epoll on an eventfd, so give() (from any thread) ends a take() early.  Elsewhere take() is just a
+ * delay.
+ */
 class BinarySemaphorePosix
 {
-    // SemaphoreHandle_t semaphore;
+#if BINARY_SEMAPHORE_EPOLL
+    int epollFd = -1;
+    int eventFd = -1; // written by give()
+#endif
 
   public:
     BinarySemaphorePosix();
@@ -27,4 +38,4 @@ class BinarySemaphorePosix
 
 #endif
 
-} // namespace concurrency
\ No newline at end of file
+} // namespace concurrency
@@ -0,0 +1,18 @@
+#include "DeferredObservable.h"
+#include "configuration.h"
+#include "main.h"
+
+namespace concurrency
+{
+
+IRAM_ATTR void DeferredNotifyThread::wakeFromISR()
+{
+    enabled = true;
+    setInterval(0); // Run ASAP
+    runASAP = true;
+
+    BaseType_t higherWake = 0;
+    mainDelay.interruptFromISR(&higherWake);
+}
+
+} // namespace concurrency
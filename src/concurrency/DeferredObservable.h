@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Observer.h"
+#include "concurrency/OSThread.h"
+
+namespace concurrency
+{
+
+/**
+ * The thread half of DeferredObservable, kept out of the template so that waking the main loop lives in one IRAM function.
+ */
+class DeferredNotifyThread : public OSThread
+{
+  public:
+    explicit DeferredNotifyThread(const char *name) : OSThread(name) { enabled = false; }
+
+  protected:
+    /// Make us run on the next pass of the main loop, safe from an ISR
+    void wakeFromISR();
+};
+
+/**
+ * An ObservableArray that can also be notified from an ISR.  notifyObserversFromISR only remembers the argument and wakes the
+ * main loop, the observers are then called from our thread like for any other notification.  If a second notification comes in
+ * before we ran, the newer argument replaces the older one.
+ *
+ * Like any OSThread, create it with new in setup() or later.
+ */
+template <class T, uint8_t N> class DeferredObservable : public ObservableArray<T, N>, private DeferredNotifyThread
+{
+    volatile bool pending = false;
+    volatile T pendingArg;
+
+  public:
+    explicit DeferredObservable(const char *name) : DeferredNotifyThread(name) {}
+
+    /// Must be inline or IRAM_ATTR on ESP32, like everything an ISR calls
+    inline void notifyObserversFromISR(T arg)
+    {
+        pendingArg = arg;
+        pending = true;
+        wakeFromISR();
+    }
+
+  protected:
+    virtual int32_t runOnce() override
+    {
+        enabled = false; // only run when notified
+        if (pending) {
+            pending = false;
+            this->notifyObservers(pendingArg);
+        }
+        return RUN_SAME;
+    }
+};
+
+} // namespace concurrency
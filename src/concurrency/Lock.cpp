@@ -2,9 +2,33 @@
 #include "configuration.h"
 #include <cassert>
 
+#if LOCK_STATS
+#include "OSThread.h"
+#include <string.h>
+#endif
+
 namespace concurrency
 {
 
+void Lock::lock()
+{
+#if LOCK_STATS
+    uint32_t asked = micros();
+    take();
+    noteTaken(asked);
+#else
+    take();
+#endif
+}
+
+void Lock::unlock()
+{
+#if LOCK_STATS
+    noteGiven();
+#endif
+    give();
+}
+
 #ifdef HAS_FREE_RTOS
 Lock::Lock() : handle(xSemaphoreCreateBinary())
 {
@@ -14,25 +38,98 @@ Lock::Lock() : handle(xSemaphoreCreateBinary())
     }
 }
 
-void Lock::lock()
+void Lock::take()
 {
     if (xSemaphoreTake(handle, portMAX_DELAY) == false) {
         abort();
     }
 }
 
-void Lock::unlock()
+void Lock::give()
 {
     if (xSemaphoreGive(handle) == false) {
         abort();
     }
 }
+#elif defined(ARCH_PORTDUINO) && PORTDUINO_RADIO_THREAD
+Lock::Lock() {}
+
+void Lock::take()
+{
+    mutex.lock();
+}
+
+void Lock::give()
+{
+    mutex.unlock();
+}
 #else
 Lock::Lock() {}
 
-void Lock::lock() {}
+void Lock::take() {}
+
+void Lock::give() {}
+#endif
+
+#if LOCK_STATS
+void Lock::enableStats(const char *name)
+{
+    if (stats)
+        return;
+    stats = new Stats();
+    memset(stats, 0, sizeof(*stats));
+    stats->name = name;
+}
+
+// Called with the lock held, so the table needs no lock of its own
+void Lock::noteTaken(uint32_t askedMicros)
+{
+    if (!stats)
+        return;
+    uint32_t now = micros();
+    const OSThread *thread = OSThread::currentThread;
+    const char *owner = thread ? thread->ThreadName.c_str() : "other";
 
-void Lock::unlock() {}
+    // The last slot counts whoever did not get a slot of their own
+    OwnerStats *o = &stats->owners[LOCK_STATS_OWNERS - 1];
+    for (uint8_t i = 0; i < LOCK_STATS_OWNERS - 1; i++) {
+        if (!stats->owners[i].owner)
+            stats->owners[i].owner = owner;
+        if (stats->owners[i].owner == owner || strcmp(stats->owners[i].owner, owner) == 0) {
+            o = &stats->owners[i];
+            break;
+        }
+    }
+    o->count++;
+    o->waitMicros += now - askedMicros;
+    stats->holder = o;
+    stats->takenMicros = now;
+}
+
+void Lock::noteGiven()
+{
+    if (!stats || !stats->holder)
+        return;
+    uint32_t held = micros() - stats->takenMicros;
+    stats->holder->holdMicros += held;
+    if (held > stats->holder->maxHoldMicros)
+        stats->holder->maxHoldMicros = held;
+    stats->holder = nullptr;
+}
+
+void Lock::logStats() const
+{
+    if (!stats)
+        return;
+    for (uint8_t i = 0; i < LOCK_STATS_OWNERS; i++) {
+        const OwnerStats &o = stats->owners[i];
+        if (!o.count)
+            continue;
+        LOG_INFO("%s lock by %s: %u times, waited %u ms, held %u ms, longest %u us", stats->name,
+                 i == LOCK_STATS_OWNERS - 1 ? "others" : o.owner, o.count, o.waitMicros / 1000, o.holdMicros / 1000,
+                 o.maxHoldMicros);
+    }
+}
 #endif
 
 } // namespace concurrency
@@ -2,6 +2,18 @@
 
 #include "../freertosinc.h"
 
+#if defined(ARCH_PORTDUINO) && PORTDUINO_RADIO_THREAD
+#include <mutex>
+#endif
+
+/// Let locks record how long each thread waits for and holds them, see Lock::enableStats()
+#ifndef LOCK_STATS
+#define LOCK_STATS 0
+#endif
+
+/// Most distinct threads a lock keeps stats for, the rest are counted together
+#define LOCK_STATS_OWNERS 12
+
 namespace concurrency
 {
 
@@ -26,9 +38,38 @@ class Lock
     // Must not be called from an ISR.
     void unlock();
 
+#if LOCK_STATS
+    /// Start recording wait and hold times per OSThread, name is used in the log
+    void enableStats(const char *name);
+
+    void logStats() const;
+#endif
+
   private:
+    void take();
+    void give();
+
+#if LOCK_STATS
+    struct OwnerStats {
+        const char *owner; // OSThread name, or NULL for the slot that counts everyone else
+        uint32_t count, waitMicros, holdMicros, maxHoldMicros;
+    };
+    struct Stats {
+        const char *name;
+        OwnerStats owners[LOCK_STATS_OWNERS];
+        OwnerStats *holder; // Who has the lock now
+        uint32_t takenMicros;
+    };
+    Stats *stats = nullptr;
+
+    void noteTaken(uint32_t askedMicros);
+    void noteGiven();
+#endif
+
 #ifdef HAS_FREE_RTOS
     SemaphoreHandle_t handle;
+#elif defined(ARCH_PORTDUINO) && PORTDUINO_RADIO_THREAD
+    std::mutex mutex; // Only with the radio in its own thread (see mesh/RadioTask.h), otherwise everything runs in one
 #endif
 };
 
@@ -15,8 +15,15 @@ class NotifiedWorkerThread : public OSThread
      */
     uint32_t notification = 0;
 
+    /// The delay our controller's loop sleeps in, which notifications must end
+    InterruptableDelay *wakeDelay;
+
   public:
-    NotifiedWorkerThread(const char *name) : OSThread(name) {}
+    NotifiedWorkerThread(const char *name, ThreadController *controller = &mainController,
+                         InterruptableDelay *wakeDelay = &mainDelay)
+        : OSThread(name, 0, controller), wakeDelay(wakeDelay)
+    {
+    }
 
     /**
      * Notify this thread so it can run
@@ -1,6 +1,8 @@
 #include "OSThread.h"
+#include "EventTrace.h"
 #include "configuration.h"
 #include "memGet.h"
+#include <algorithm>
 #include <assert.h>
 
 namespace concurrency
@@ -20,6 +22,73 @@ const OSThread *OSThread::currentThread;
 ThreadController mainController, timerController;
 InterruptableDelay mainDelay;
 
+#if OSTHREAD_HEAP_SCHEDULER
+OSThread *OSThread::scheduledThreads;
+std::vector<OSThread::ScheduleEntry> OSThread::schedule;
+uint32_t OSThread::lastResync;
+size_t OSThread::numScheduled;
+
+/// Heap order, earliest first.  Compares the signed difference like Thread::shouldRun, so millis() rollover is handled
+bool OSThread::scheduleEntryLater(const ScheduleEntry &a, const ScheduleEntry &b)
+{
+    return (int32_t)(a.when - b.when) > 0;
+}
+
+void OSThread::reschedule(OSThread *t)
+{
+    if (!t->enabled)
+        return; // will be picked up by a resync once someone enables it
+
+    schedule.push_back({(uint32_t)t->_cached_next_run, t});
+    std::push_heap(schedule.begin(), schedule.end(), scheduleEntryLater);
+
+    if (schedule.size() > 2 * numScheduled + 8)
+        rebuildSchedule(millis()); // too many stale entries
+}
+
+void OSThread::rebuildSchedule(uint32_t now)
+{
+    schedule.clear();
+    for (OSThread *t = scheduledThreads; t; t = t->nextScheduled)
+        if (t->enabled)
+            schedule.push_back({(uint32_t)t->_cached_next_run, t});
+    std::make_heap(schedule.begin(), schedule.end(), scheduleEntryLater);
+    lastResync = now;
+}
+
+int32_t OSThread::runDue(bool resync)
+{
+    uint32_t now = millis();
+    if (resync || (int32_t)(now - lastResync) >= OSTHREAD_RESYNC_MSEC)
+        rebuildSchedule(now);
+
+    while (!schedule.empty()) {
+        ScheduleEntry e = schedule.front();
+        OSThread *t = e.thread;
+        if (!t->enabled || (uint32_t)t->_cached_next_run != e.when) {
+            // Disabled or rescheduled since this entry was made
+            std::pop_heap(schedule.begin(), schedule.end(), scheduleEntryLater);
+            schedule.pop_back();
+            continue;
+        }
+
+        int32_t wait = (int32_t)(e.when - now);
+        if (wait > 0)
+            return std::min(wait, (int32_t)(lastResync + OSTHREAD_RESYNC_MSEC - now));
+
+        if (!t->shouldRun(now))
+            return 1; // not quite due by Thread's own reckoning, look again shortly
+
+        std::pop_heap(schedule.begin(), schedule.end(), scheduleEntryLater);
+        schedule.pop_back();
+        t->run(); // puts its new entry on the heap
+        now = millis();
+    }
+
+    return std::max((int32_t)0, (int32_t)(lastResync + OSTHREAD_RESYNC_MSEC - now));
+}
+#endif
+
 void OSThread::setup()
 {
     mainController.ThreadName = "mainController";
@@ -37,12 +106,38 @@ OSThread::OSThread(const char *_name, uint32_t period, ThreadController *_contro
         bool added = controller->add(this);
         assert(added);
     }
+
+#if OSTHREAD_HEAP_SCHEDULER
+    if (controller == &mainController) {
+        nextScheduled = scheduledThreads;
+        scheduledThreads = this;
+        numScheduled++;
+        reschedule(this);
+    }
+#endif
 }
 
 OSThread::~OSThread()
 {
     if (controller)
         controller->remove(this);
+
+#if OSTHREAD_HEAP_SCHEDULER
+    if (controller == &mainController) {
+        for (OSThread **pp = &scheduledThreads; *pp; pp = &(*pp)->nextScheduled) {
+            if (*pp == this) {
+                *pp = nextScheduled;
+                numScheduled--;
+                break;
+            }
+        }
+        // Entries may still point at us, drop them now rather than validating a dangling pointer later
+        schedule.erase(std::remove_if(schedule.begin(), schedule.end(),
+                                      [this](const ScheduleEntry &e) { return e.thread == this; }),
+                       schedule.end());
+        std::make_heap(schedule.begin(), schedule.end(), scheduleEntryLater);
+    }
+#endif
 }
 
 /**
@@ -55,6 +150,11 @@ void OSThread::setIntervalFromNow(unsigned long _interval)
 
     // Cache the next run based on the last_run
     _cached_next_run = millis() + interval;
+
+#if OSTHREAD_HEAP_SCHEDULER
+    if (controller == &mainController)
+        reschedule(this);
+#endif
 }
 
 bool OSThread::shouldRun(unsigned long time)
@@ -82,7 +182,32 @@ void OSThread::run()
     auto heap = memGet.getFreeHeap();
 #endif
     currentThread = this;
-    auto newDelay = runOnce();
+#if EVENT_TRACE && defined(ARCH_PORTDUINO)
+    int32_t lateMsec = (int32_t)(millis() - _cached_next_run);
+    if (lateMsec > 0)
+        TRACE_COUNTER("OSThread late msec", lateMsec);
+#endif
+#if OSTHREAD_PROFILE
+    int32_t late = (int32_t)(millis() - _cached_next_run);
+    uint32_t started = micros();
+#endif
+    int32_t newDelay;
+    {
+        TRACE_SCOPE(ThreadName.c_str());
+        newDelay = runOnce();
+    }
+#if OSTHREAD_PROFILE
+    uint32_t took = micros() - started;
+    profile.calls++;
+    profile.totalMicros += took;
+    if (took > profile.maxMicros)
+        profile.maxMicros = took;
+    if (late > 0) {
+        profile.totalLateMsec += late;
+        if ((uint32_t)late > profile.maxLateMsec)
+            profile.maxLateMsec = late;
+    }
+#endif
 #ifdef DEBUG_HEAP
     auto newHeap = memGet.getFreeHeap();
     if (newHeap < heap)
@@ -96,6 +221,11 @@ void OSThread::run()
     if (newDelay >= 0)
         setInterval(newDelay);
 
+#if OSTHREAD_HEAP_SCHEDULER
+    if (controller == &mainController)
+        reschedule(this);
+#endif
+
     currentThread = NULL;
 }
 
@@ -118,6 +248,52 @@ int32_t OSThread::disable()
  * in particular, for OSThread that means "all instances must be declared via new() in setup() or later" -
  * this makes it guaranteed that the global mainController is fully constructed first.
  */
+#if OSTHREAD_PROFILE
+/// Call f on every OSThread owned by our controllers
+template <class F> static void forEachThread(F f)
+{
+    ThreadController *controllers[] = {&mainController, &timerController};
+    for (ThreadController *c : controllers) {
+        for (int i = 0; i < MAX_THREADS; i++) {
+            auto thread = c->get(i);
+            if (thread != nullptr)
+                f(static_cast<OSThread *>(thread));
+        }
+    }
+}
+
+const OSThread *OSThread::getBusiest()
+{
+    const OSThread *busiest = NULL;
+    forEachThread([&](OSThread *t) {
+        if (t->profile.calls && (!busiest || t->profile.totalMicros > busiest->profile.totalMicros))
+            busiest = t;
+    });
+    return busiest;
+}
+
+void OSThread::logProfiles()
+{
+    LOG_INFO("Thread profile after %us (calls, avg/max us, avg/max late ms):", (uint32_t)(millis() / 1000));
+    forEachThread([](OSThread *t) {
+        const Profile &p = t->profile;
+        if (p.calls)
+            LOG_INFO("  %s: %u, %u/%u, %u/%u", t->ThreadName.c_str(), p.calls, (uint32_t)(p.totalMicros / p.calls), p.maxMicros,
+                     p.totalLateMsec / p.calls, p.maxLateMsec);
+    });
+}
+
+void OSThread::resetProfiles()
+{
+    forEachThread([](OSThread *t) { t->profile = Profile(); });
+}
+
+void OSThread::forEachProfile(void (*f)(const OSThread *thread, void *context), void *context)
+{
+    forEachThread([&](OSThread *t) { f(t, context); });
+}
+#endif
+
 bool hasBeenSetup;
 
 void assertIsSetup()
@@ -2,6 +2,7 @@
 
 #include <cstdlib>
 #include <stdint.h>
+#include <vector>
 
 #include "Thread.h"
 #include "ThreadController.h"
@@ -15,6 +16,24 @@ extern InterruptableDelay mainDelay;
 
 #define RUN_SAME -1
 
+/**
+ * Set to 1 to drive mainController threads from a min-heap of next run times (see OSThread::runDue) instead of polling every
+ * thread on every loop.
+ */
+#ifndef OSTHREAD_HEAP_SCHEDULER
+#define OSTHREAD_HEAP_SCHEDULER 0
+#endif
+
+/// With the heap scheduler, how often we resynchronise with threads whose schedule was changed behind our back
+#ifndef OSTHREAD_RESYNC_MSEC
+#define OSTHREAD_RESYNC_MSEC 1000
+#endif
+
+/// Set to 1 to collect per thread runtime statistics (see OSThread::Profile), costs two extra timer reads per run
+#ifndef OSTHREAD_PROFILE
+#define OSTHREAD_PROFILE 0
+#endif
+
 /**
  * @brief Base threading
  *
@@ -60,7 +79,65 @@ class OSThread : public Thread
      */
     void setIntervalFromNow(unsigned long _interval);
 
+#if OSTHREAD_HEAP_SCHEDULER
+    /**
+     * Run every mainController thread that is due, without looking at the ones that are not.
+     *
+     * Threads are kept in a min-heap keyed by their next run time.  Changes made through OSThread (running, setIntervalFromNow,
+     * construction) update the heap directly.  Code that flips `enabled` or calls setInterval() from outside the thread should
+     * also wake the main loop (runASAP), the existing convention, which makes us resynchronise; anything else is picked up
+     * within OSTHREAD_RESYNC_MSEC.
+     *
+     * @param resync rescan all threads first, pass true when the main loop was woken early
+     * @return msecs until the next thread is due, so the caller can sleep exactly that long
+     */
+    static int32_t runDue(bool resync);
+#endif
+
+#if OSTHREAD_PROFILE
+    /// Runtime statistics, collected since boot or the last resetProfiles()
+    struct Profile {
+        uint32_t calls;
+        uint32_t maxMicros;     // longest single runOnce()
+        uint64_t totalMicros;   // time spent in runOnce()
+        uint32_t maxLateMsec;   // worst delay between when we were due and when we actually ran
+        uint32_t totalLateMsec;
+    };
+
+    const Profile &getProfile() const { return profile; }
+
+    /// @return the thread that has spent the most time in runOnce(), or NULL if nothing has run
+    static const OSThread *getBusiest();
+
+    /// Write one line per thread that has run to the log
+    static void logProfiles();
+
+    static void resetProfiles();
+
+    /// Call f on every thread, to export the profiles
+    static void forEachProfile(void (*f)(const OSThread *thread, void *context), void *context);
+#endif
+
   protected:
+#if OSTHREAD_HEAP_SCHEDULER
+    /// All heap scheduled threads, linked through this
+    OSThread *nextScheduled = NULL;
+
+    struct ScheduleEntry {
+        uint32_t when;
+        OSThread *thread;
+    };
+    static OSThread *scheduledThreads;
+    static std::vector<ScheduleEntry> schedule;
+    static uint32_t lastResync;
+    static size_t numScheduled;
+
+    /// Add an entry for our current next run time (old entries become stale and are skipped)
+    static void reschedule(OSThread *t);
+    static void rebuildSchedule(uint32_t now);
+    static bool scheduleEntryLater(const ScheduleEntry &a, const ScheduleEntry &b);
+#endif
+
     /**
      * The method that will be called each time our thread gets a chance to run
      *
@@ -69,6 +146,10 @@ class OSThread : public Thread
     virtual int32_t runOnce() = 0;
     bool sleepOnNextExecution = false;
 
+#if OSTHREAD_PROFILE
+    Profile profile = {};
+#endif
+
     // Do not override this
     virtual void run();
 };
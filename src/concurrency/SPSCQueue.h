@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace concurrency
+{
+
+/**
+ * A fixed size lock-free queue for exactly one producer and one consumer, e.g. an ISR (or the portduino GPIO thread) handing
+ * events to a worker thread.
+ *
+ * Only plain atomic loads and stores are used, so it is safe on cores without atomic read-modify-write (RP2040) and never
+ * blocks or allocates.  Size must be a power of two, one slot is never used so the queue holds Size - 1 items.
+ */
+template <class T, size_t Size> class SPSCQueue
+{
+    static_assert(Size >= 2 && (Size & (Size - 1)) == 0, "SPSCQueue size must be a power of two");
+
+    T items[Size];
+    std::atomic<uint32_t> head{0}; // next slot to read, only written by the consumer
+    std::atomic<uint32_t> tail{0}; // next slot to write, only written by the producer
+    std::atomic<uint32_t> dropped{0};
+
+  public:
+    /// Producer side, safe to call from an ISR (always inlined so it ends up in IRAM with its caller on ESP32)
+    /// @return false if the queue was full and the item was dropped
+    inline __attribute__((always_inline)) bool push(const T &item)
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t next = (t + 1) & (Size - 1);
+        if (next == head.load(std::memory_order_acquire)) {
+            dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        items[t] = item;
+        tail.store(next, std::memory_order_release); // publish only after the item is in place
+        return true;
+    }
+
+    /// Consumer side
+    /// @return false if the queue was empty
+    bool pop(T &item)
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        item = items[h];
+        head.store((h + 1) & (Size - 1), std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+    /// Number of items that could not be queued because we were full, only ever increases
+    uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+};
+
+} // namespace concurrency
@@ -457,5 +457,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define HAS_SCREEN 0
 #endif
 
+// The link benchmark is a development tool, builds for measuring set MESHTASTIC_EXCLUDE_LINKBENCH=0 on both ends
+#ifndef MESHTASTIC_EXCLUDE_LINKBENCH
+#define MESHTASTIC_EXCLUDE_LINKBENCH 1
+#endif
+
+// Bulk transfers only work between nodes that both have them, builds that send or take payloads that way set
+// MESHTASTIC_EXCLUDE_BULKTRANSFER=0
+#ifndef MESHTASTIC_EXCLUDE_BULKTRANSFER
+#define MESHTASTIC_EXCLUDE_BULKTRANSFER 1
+#endif
+
 #include "DebugConfiguration.h"
 #include "RF95Configuration.h"
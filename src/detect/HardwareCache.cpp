@@ -0,0 +1,148 @@
+#include "HardwareCache.h"
+
+#if HARDWARE_CACHE && defined(FSCom)
+#include "SafeFile.h"
+#include "SPILock.h"
+#include "concurrency/OSThread.h"
+#if !MESHTASTIC_EXCLUDE_I2C
+#include <Wire.h>
+#endif
+
+static const char *hardwareCacheFileName = "/prefs/hwcache.bin";
+
+HardwareCache hardwareCache;
+
+uint32_t HardwareCache::fingerprint()
+{
+    const char *version = optstr(APP_VERSION);
+    uint32_t hwModel = HW_VENDOR;
+    uint32_t crc = SafeFile::crc32(0, (const uint8_t *)version, strlen(version));
+    return SafeFile::crc32(crc, (const uint8_t *)&hwModel, sizeof(hwModel));
+}
+
+void HardwareCache::load()
+{
+    Data loaded = {};
+    {
+        concurrency::LockGuard g(fsLock);
+        File f = FSCom.open(hardwareCacheFileName, FILE_O_READ);
+        if (!f)
+            return;
+        bool complete = f.read((uint8_t *)&loaded, sizeof(loaded)) == sizeof(loaded);
+        f.close();
+        if (!complete)
+            return;
+    }
+    if (loaded.fingerprint != fingerprint()) {
+        LOG_INFO("Hardware cache is from other firmware, probe everything");
+        return;
+    }
+    data = loaded;
+    LOG_INFO("Use hardware cache: %u+%u i2c devices, GNSS model %u at %u baud", data.i2cCount[0], data.i2cCount[1],
+             data.gnssModel, data.gnssBaud);
+}
+
+void HardwareCache::save()
+{
+    if (!dirty)
+        return;
+    data.fingerprint = fingerprint();
+    fsLock->lock();
+    FSCom.mkdir("/prefs");
+    fsLock->unlock();
+    auto f = SafeFile(hardwareCacheFileName);
+    f.write((const uint8_t *)&data, sizeof(data));
+    if (f.close())
+        dirty = false;
+}
+
+bool HardwareCache::getI2C(ScanI2C::I2CPort port, uint8_t *addresses, uint8_t *count) const
+{
+    if (port == ScanI2C::I2CPort::NO_I2C || !data.i2cKnown[port - 1])
+        return false;
+    *count = data.i2cCount[port - 1];
+    memcpy(addresses, data.i2cAddresses[port - 1], *count);
+    return true;
+}
+
+void HardwareCache::setI2C(ScanI2C::I2CPort port, const uint8_t *addresses, uint8_t count)
+{
+    if (port == ScanI2C::I2CPort::NO_I2C)
+        return;
+    uint8_t i = port - 1;
+    // With more devices than fit we can't tell which ones a cached scan would skip
+    data.i2cKnown[i] = count <= HW_CACHE_MAX_I2C;
+    data.i2cCount[i] = data.i2cKnown[i] ? count : 0;
+    memcpy(data.i2cAddresses[i], addresses, data.i2cCount[i]);
+    dirty = true;
+}
+
+uint32_t HardwareCache::getGnssBaud(uint32_t rx, uint32_t tx) const
+{
+    return (data.gnssRx == rx && data.gnssTx == tx) ? data.gnssBaud : 0;
+}
+
+void HardwareCache::setGnss(uint8_t model, uint32_t baud, uint32_t rx, uint32_t tx)
+{
+    if (data.gnssModel == model && data.gnssBaud == baud && data.gnssRx == rx && data.gnssTx == tx)
+        return;
+    data.gnssModel = model;
+    data.gnssBaud = baud;
+    data.gnssRx = rx;
+    data.gnssTx = tx;
+    dirty = true;
+}
+
+#if !MESHTASTIC_EXCLUDE_I2C && !defined(ARCH_PORTDUINO)
+/**
+ * Once boot is over, check whether anything answers at the addresses the cached scan skipped.  Only an address ACK, nothing is
+ * sent to devices drivers are already using.  If something new turned up, forget the cached addresses so the next boot scans the
+ * bus fully and sets it up properly.
+ */
+class HardwareRescanThread : public concurrency::OSThread
+{
+  public:
+    HardwareRescanThread() : OSThread("HardwareRescan") { setIntervalFromNow(HW_CACHE_RESCAN_DELAY_MS); }
+
+  protected:
+    int32_t runOnce() override
+    {
+        for (uint8_t i = 0; i < 2; i++) {
+            ScanI2C::I2CPort port = (ScanI2C::I2CPort)(i + 1);
+            uint8_t known[HW_CACHE_MAX_I2C];
+            uint8_t count;
+            if (!hardwareCache.getI2C(port, known, &count))
+                continue; // This port had a full scan anyway
+#if WIRE_INTERFACES_COUNT == 2
+            TwoWire *bus = port == ScanI2C::I2CPort::WIRE1 ? &Wire1 : &Wire;
+#else
+            if (port == ScanI2C::I2CPort::WIRE1)
+                continue;
+            TwoWire *bus = &Wire;
+#endif
+            for (uint8_t address = 8; address < 120; address++) {
+                if (memchr(known, address, count))
+                    continue;
+                bus->beginTransmission(address);
+                if (bus->endTransmission() == 0) {
+                    LOG_INFO("New i2c device at 0x%x on port %d, full scan on next boot", address, port);
+                    hardwareCache.setI2C(port, NULL, HW_CACHE_MAX_I2C + 1);
+                    hardwareCache.save();
+                    break;
+                }
+            }
+        }
+        return disable();
+    }
+};
+#endif
+
+void HardwareCache::startRescan()
+{
+#if !MESHTASTIC_EXCLUDE_I2C && !defined(ARCH_PORTDUINO)
+    if (data.i2cKnown[0] || data.i2cKnown[1])
+        new HardwareRescanThread();
+#endif
+}
+
+#endif
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "FSCommon.h"
+#include "ScanI2C.h"
+#include "configuration.h"
+
+/**
+ * Remember the hardware found at boot (the I2C addresses on each bus, the GNSS model and baud rate) so the next boot only has to
+ * probe that.  Nodes that brown out and reboot often then skip the full I2C sweep and the GPS baud rate search.
+ *
+ * The cache is keyed by a fingerprint of the firmware version and hardware model, so it is ignored after an update or on other
+ * hardware.  A device plugged in later is noticed by a background check of the addresses that were empty, which clears the I2C
+ * part of the cache for the next boot.
+ */
+#ifndef HARDWARE_CACHE
+#define HARDWARE_CACHE 0
+#endif
+
+/// Devices remembered per I2C bus, a bus with more gets a full scan every boot
+#define HW_CACHE_MAX_I2C 16
+
+/// How long after boot the background check for new I2C devices runs
+#ifndef HW_CACHE_RESCAN_DELAY_MS
+#define HW_CACHE_RESCAN_DELAY_MS (60 * 1000)
+#endif
+
+#if HARDWARE_CACHE && defined(FSCom)
+
+class HardwareCache
+{
+  public:
+    /// Read the cache from flash, call once the filesystem is up
+    void load();
+
+    /// Write the cache back if anything was learned
+    void save();
+
+    /**
+     * The addresses found on port last boot
+     * @return false if they are not known, then port needs a full scan
+     */
+    bool getI2C(ScanI2C::I2CPort port, uint8_t *addresses, uint8_t *count) const;
+
+    void setI2C(ScanI2C::I2CPort port, const uint8_t *addresses, uint8_t count);
+
+    /// Baud rate the GNSS on these pins answered at last boot, 0 if not known
+    uint32_t getGnssBaud(uint32_t rx, uint32_t tx) const;
+
+    void setGnss(uint8_t model, uint32_t baud, uint32_t rx, uint32_t tx);
+
+    /// Later on, look for I2C devices at the addresses the cached scan skipped
+    void startRescan();
+
+  private:
+    struct Data {
+        uint32_t fingerprint;
+        uint8_t i2cKnown[2]; // per port: 1 if i2cAddresses holds the result of a full scan
+        uint8_t i2cCount[2];
+        uint8_t i2cAddresses[2][HW_CACHE_MAX_I2C];
+        uint8_t gnssModel;
+        uint32_t gnssBaud;
+        uint32_t gnssRx, gnssTx;
+    };
+
+    Data data = {};
+    bool dirty = false;
+
+    static uint32_t fingerprint();
+};
+
+extern HardwareCache hardwareCache;
+
+#endif
@@ -553,6 +553,19 @@ size_t ScanI2CTwoWire::countDevices() const
     return foundDevices.size();
 }
 
+uint8_t ScanI2CTwoWire::getAddresses(ScanI2C::I2CPort port, uint8_t *addresses, uint8_t max) const
+{
+    uint8_t count = 0;
+    for (auto &found : foundDevices) {
+        if (found.first.port != port)
+            continue;
+        if (count < max)
+            addresses[count] = found.first.address;
+        count++;
+    }
+    return count;
+}
+
 void ScanI2CTwoWire::logFoundDevice(const char *device, uint8_t address)
 {
     LOG_INFO("%s found at address 0x%x", device, address);
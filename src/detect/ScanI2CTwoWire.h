@@ -29,6 +29,9 @@ class ScanI2CTwoWire : public ScanI2C
 
     size_t countDevices() const override;
 
+    /// Copy up to max addresses of the devices found on port, returns how many there are
+    uint8_t getAddresses(ScanI2C::I2CPort, uint8_t *addresses, uint8_t max) const;
+
   protected:
     FoundDevice firstOfOrNONE(size_t, DeviceType[]) const override;
 
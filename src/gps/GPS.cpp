@@ -20,6 +20,7 @@
 
 #include "GPSUpdateScheduling.h"
 #include "cas.h"
+#include "detect/HardwareCache.h"
 #include "ubx.h"
 
 #ifdef ARCH_PORTDUINO
@@ -70,6 +71,18 @@ static struct uBloxGnssModelInfo {
 #define GPS_SOL_EXPIRY_MS 5000 // in millis. give 1 second time to combine different sentences. NMEA Frequency isn't higher anyway
 #define NMEA_MSG_GXGSA "GNGSA" // GSA message (GPGSA, GNGSA etc)
 
+// Drop NMEA sentence types that nothing here reads (GSV, VTG, GLL etc) before they reach TinyGPS++
+#ifndef GPS_NMEA_FILTER
+#define GPS_NMEA_FILTER 1
+#endif
+
+// Ask u-blox M8 and later for UBX-NAV-PVT frames, and prefer them to NMEA while they keep arriving
+#ifndef GPS_UBX_NAV_PVT
+#define GPS_UBX_NAV_PVT 1
+#endif
+#define UBX_NAV_PVT_LEN 92  // payload bytes
+#define UBX_MAX_PAYLOAD 512 // longer frames are taken as noise, so they can't swallow the NMEA behind them
+
 // For logging
 static const char *getGPSPowerStateString(GPSPowerState state)
 {
@@ -506,7 +519,16 @@ bool GPS::setup()
             digitalWrite(PIN_GPS_EN, HIGH);
             delay(1000);
 #endif
-            if (probeTries < GPS_PROBETRIES) {
+#if HARDWARE_CACHE && defined(FSCom)
+            if (!triedCachedSpeed) {
+                triedCachedSpeed = true;
+                if (uint32_t cachedSpeed = hardwareCache.getGnssBaud(rx_gpio, tx_gpio)) {
+                    LOG_DEBUG("Probe for GPS at cached %d", cachedSpeed);
+                    gnssModel = probe(cachedSpeed);
+                }
+            }
+#endif
+            if (gnssModel == GNSS_MODEL_UNKNOWN && probeTries < GPS_PROBETRIES) {
                 LOG_DEBUG("Probe for GPS at %d", serialSpeeds[speedSelect]);
                 gnssModel = probe(serialSpeeds[speedSelect]);
                 if (gnssModel == GNSS_MODEL_UNKNOWN) {
@@ -517,7 +539,7 @@ bool GPS::setup()
                 }
             }
             // Rare Serial Speeds
-            if (probeTries == GPS_PROBETRIES) {
+            if (gnssModel == GNSS_MODEL_UNKNOWN && probeTries == GPS_PROBETRIES) {
                 LOG_DEBUG("Probe for GPS at %d", rareSerialSpeeds[speedSelect]);
                 gnssModel = probe(rareSerialSpeeds[speedSelect]);
                 if (gnssModel == GNSS_MODEL_UNKNOWN) {
@@ -531,6 +553,12 @@ bool GPS::setup()
 
         if (gnssModel != GNSS_MODEL_UNKNOWN) {
             setConnected();
+#if HARDWARE_CACHE && defined(FSCom)
+            if (probedSpeed) {
+                hardwareCache.setGnss(gnssModel, probedSpeed, rx_gpio, tx_gpio);
+                hardwareCache.save();
+            }
+#endif
         } else {
             return false;
         }
@@ -729,6 +757,10 @@ bool GPS::setup()
             SEND_UBX_PACKET(0x06, 0x01, _message_VTG, "disable NMEA VTG", 500);
             SEND_UBX_PACKET(0x06, 0x01, _message_RMC, "enable NMEA RMC", 500);
             SEND_UBX_PACKET(0x06, 0x01, _message_GGA, "enable NMEA GGA", 500);
+#if GPS_UBX_NAV_PVT
+            if (gnssModel != GNSS_MODEL_UBLOX7) // NAV-PVT is new with the M8
+                SEND_UBX_PACKET(0x06, 0x01, _message_NAV_PVT, "enable UBX-NAV-PVT", 500);
+#endif
 
             if (ublox_info.protocol_version >= 18) {
                 clearBuffer();
@@ -789,6 +821,12 @@ bool GPS::setup()
             // Next enable wanted NMEA messages in RAM layer
             SEND_UBX_PACKET(0x06, 0x8A, _message_VALSET_ENABLE_NMEA_RAM, "enable messages for M10 GPS RAM", 500);
             delay(750);
+#if GPS_UBX_NAV_PVT
+            SEND_UBX_PACKET(0x06, 0x8A, _message_VALSET_ENABLE_NAV_PVT_BBR, "enable NAV-PVT for M10 GPS BBR", 300);
+            delay(750);
+            SEND_UBX_PACKET(0x06, 0x8A, _message_VALSET_ENABLE_NAV_PVT_RAM, "enable NAV-PVT for M10 GPS RAM", 300);
+            delay(750);
+#endif
 
             // As the M10 has no flash, the best we can do to preserve the config is to set it in RAM and BBR.
             // BBR will survive a restart, and power off for a while, but modules with small backup
@@ -1012,10 +1050,9 @@ void GPS::up()
     setPowerState(GPS_ACTIVE);
 }
 
-// We've got a GPS lock. Enter a low power state, potentially.
+// Done searching, with a lock or having given up. Enter a low power state, potentially.
 void GPS::down()
 {
-    scheduling.informGotLock();
     uint32_t predictedSearchDuration = scheduling.predictedSearchDurationMs();
     uint32_t sleepTime = scheduling.msUntilNextSearch();
     uint32_t updateInterval = Default::getConfiguredOrDefaultMs(config.position.gps_update_interval);
@@ -1134,6 +1171,9 @@ int32_t GPS::runOnce()
             }
             p = meshtastic_Position_init_default;
             hasValidLocation = false;
+            scheduling.informSearchFailed();
+        } else {
+            scheduling.informGotLock();
         }
 
         down();
@@ -1154,6 +1194,8 @@ int32_t GPS::runOnce()
 // clear the GPS rx/tx buffer as quickly as possible
 void GPS::clearBuffer()
 {
+    nmeaLength = 0; // Whatever sentence or frame we were part way through is gone
+    ubxLength = 0;
 #ifdef ARCH_ESP32
     _serial_gps->flush(false);
 #else
@@ -1198,6 +1240,7 @@ static const char *DETECTED_MESSAGE = "%s detected";
 
 GnssModel_t GPS::probe(int serialSpeed)
 {
+    probedSpeed = serialSpeed;
 #if defined(ARCH_NRF52) || defined(ARCH_PORTDUINO) || defined(ARCH_STM32WL)
     _serial_gps->end();
     _serial_gps->begin(serialSpeed);
@@ -1518,6 +1561,22 @@ bool GPS::lookForTime()
         return false;
     }
 #endif
+    // Date and time valid, and fully resolved
+    if (hasFreshPVT() && (navPVT.valid & 0x07) == 0x07) {
+        struct tm t;
+        t.tm_sec = navPVT.sec + round((millis() - navPVT.receivedMsec) / 1000);
+        t.tm_min = navPVT.min;
+        t.tm_hour = navPVT.hour;
+        t.tm_mday = navPVT.day;
+        t.tm_mon = navPVT.month - 1;
+        t.tm_year = navPVT.year - 1900;
+        t.tm_isdst = false;
+        LOG_DEBUG("UBX GPS time %02d-%02d-%02d %02d:%02d:%02d", navPVT.year, navPVT.month, t.tm_mday, t.tm_hour, t.tm_min,
+                  t.tm_sec);
+        perhapsSetRTC(RTCQualityGPS, t);
+        return true;
+    }
+
     auto ti = reader.time;
     auto d = reader.date;
     if (ti.isValid() && d.isValid()) { // Note: we don't check for updated, because we'll only be called if needed
@@ -1576,13 +1635,17 @@ bool GPS::lookForLocation()
     // At a minimum, use the fixQuality indicator in GPGGA (FIXME?)
     fixQual = reader.fixQuality();
 
+    uint32_t checksumFails = nmeaChecksumFails; // Mostly caught by whileActive, before they reach TinyGPS++
 #ifndef TINYGPS_OPTION_NO_STATISTICS
-    if (reader.failedChecksum() > lastChecksumFailCount) {
-        LOG_WARN("%u new GPS checksum failures, for a total of %u", reader.failedChecksum() - lastChecksumFailCount,
-                 reader.failedChecksum());
-        lastChecksumFailCount = reader.failedChecksum();
-    }
+    checksumFails += reader.failedChecksum();
 #endif
+    if (checksumFails > lastChecksumFailCount) {
+        LOG_WARN("%u new GPS checksum failures, for a total of %u", checksumFails - lastChecksumFailCount, checksumFails);
+        lastChecksumFailCount = checksumFails;
+    }
+
+    if (hasFreshPVT())
+        return lookForPVTLocation();
 
 #ifndef TINYGPS_OPTION_NO_CUSTOM_FIELDS
     fixType = atoi(gsafixtype.value()); // will set to zero if no data
@@ -1698,6 +1761,75 @@ bool GPS::lookForLocation()
     return true;
 }
 
+// As lookForLocation, but everything comes from the one NAV-PVT frame, so there are no sentence ages to line up
+bool GPS::lookForPVTLocation()
+{
+    // Map onto the GGA fix quality and GSA fix type that hasLock expects
+    fixQual = (navPVT.flags & 0x01) ? ((navPVT.flags & 0x02) ? 2 : 1) : 0;
+    if (navPVT.fixType == 2)
+        fixType = 2;
+    else if (navPVT.fixType == 3 || navPVT.fixType == 4)
+        fixType = 3;
+    else
+        fixType = 1;
+
+    if (!hasLock())
+        return false;
+
+    // Is this a new point or are we re-reading the previous one?
+    if (!navPVT.updated)
+        return false;
+    navPVT.updated = false;
+
+    if (navPVT.lat > 900000000 || navPVT.lat < -900000000 || navPVT.lon > 1800000000 || navPVT.lon < -1800000000) {
+        LOG_WARN("BOGUS NAV-PVT position REJECTED: %d, %d", navPVT.lat, navPVT.lon);
+        return false;
+    }
+
+#ifdef GPS_DEBUG
+    LOG_DEBUG("NAV-PVT: fixType=%u sats=%u hAcc=%umm vAcc=%umm", navPVT.fixType, navPVT.numSV, navPVT.hAcc, navPVT.vAcc);
+#endif
+
+    p.location_source = meshtastic_Position_LocSource_LOC_INTERNAL;
+
+    // NAV-PVT has PDOP but no HDOP, which GGA still gives us
+    p.PDOP = navPVT.pDOP;
+    p.HDOP = (reader.hdop.isValid() && reader.hdop.age() < GPS_SOL_EXPIRY_MS) ? reader.hdop.value() : navPVT.pDOP;
+
+    p.latitude_i = navPVT.lat;
+    p.longitude_i = navPVT.lon;
+
+    p.altitude = navPVT.hMSL / 1000;
+    p.altitude_hae = navPVT.height / 1000;
+    p.altitude_geoidal_separation = (navPVT.height - navPVT.hMSL) / 1000;
+
+    p.fix_quality = fixQual;
+    p.fix_type = fixType;
+
+    // positional timestamp
+    if ((navPVT.valid & 0x03) == 0x03) {
+        struct tm t;
+        t.tm_sec = navPVT.sec;
+        t.tm_min = navPVT.min;
+        t.tm_hour = navPVT.hour;
+        t.tm_mday = navPVT.day;
+        t.tm_mon = navPVT.month - 1;
+        t.tm_year = navPVT.year - 1900;
+        t.tm_isdst = false;
+        p.timestamp = gm_mktime(&t);
+    }
+
+    p.sats_in_view = navPVT.numSV;
+
+    if (navPVT.headMot >= 0 && navPVT.headMot < 36000000) // Already degrees * 10^-5
+        p.ground_track = navPVT.headMot;
+
+    if (navPVT.gSpeed >= 0)
+        p.ground_speed = navPVT.gSpeed * 36 / 10000; // mm/s to km/h
+
+    return true;
+}
+
 bool GPS::hasLock()
 {
     // Using GPGGA fix quality indicator
@@ -1719,7 +1851,6 @@ bool GPS::hasFlow()
 
 bool GPS::whileActive()
 {
-    unsigned int charsInBuf = 0;
     bool isValid = false;
 #ifdef GPS_DEBUG
     std::string debugmsg = "";
@@ -1734,21 +1865,42 @@ bool GPS::whileActive()
         clearBuffer();
     }
 #endif
-    // First consume any chars that have piled up at the receiver
-    while (_serial_gps->available() > 0) {
-        int c = _serial_gps->read();
-        UBXscratch[charsInBuf] = c;
+    // First consume any chars that have piled up at the receiver, a block at a time
+    uint8_t chunk[64];
+    int waiting;
+    while ((waiting = _serial_gps->available()) > 0) {
+        size_t n = _serial_gps->readBytes(chunk, min(waiting, (int)sizeof(chunk)));
+        if (n == 0)
+            break;
+
+        for (size_t i = 0; i < n; i++) {
+            char c = chunk[i];
 #ifdef GPS_DEBUG
-        debugmsg += vformat("%c", (c >= 32 && c <= 126) ? c : '.');
+            debugmsg += vformat("%c", (c >= 32 && c <= 126) ? c : '.');
+#endif
+#if GPS_UBX_NAV_PVT
+            if (ubxLength == 1 && chunk[i] != 0x62)
+                ubxLength = 0; // Just a stray 0xB5, this byte may still start a sentence
+            if (ubxLength > 0 || chunk[i] == 0xB5) {
+                nmeaLength = 0; // 0xB5 is never part of a sentence
+                isValid |= handleUBXByte(chunk[i]);
+                continue;
+            }
 #endif
-        isValid |= reader.encode(c);
-        if (charsInBuf > sizeof(UBXscratch) - 10 || c == '\r') {
-            if (strnstr((char *)UBXscratch, "$GPTXT,01,01,02,u-blox ag - www.u-blox.com*50", charsInBuf)) {
-                rebootsSeen++;
+            if (c == '$') {
+                nmeaLength = 0; // Start of a sentence, abandon any unfinished one
+            } else if (nmeaLength == 0) {
+                continue; // Between sentences: line endings, binary replies, noise
+            } else if (c == '\r' || c == '\n') {
+                nmeaSentence[nmeaLength] = '\0';
+                isValid |= handleSentence(nmeaSentence, nmeaLength);
+                nmeaLength = 0;
+                continue;
+            } else if (nmeaLength >= sizeof(nmeaSentence) - 1) {
+                nmeaLength = 0; // Too long to be NMEA, drop it
+                continue;
             }
-            charsInBuf = 0;
-        } else {
-            charsInBuf++;
+            nmeaSentence[nmeaLength++] = c;
         }
     }
 #ifdef GPS_DEBUG
@@ -1758,6 +1910,117 @@ bool GPS::whileActive()
 #endif
     return isValid;
 }
+
+// Called by whileActive with a complete sentence, "$" to the end of the checksum
+bool GPS::handleSentence(const char *sentence, uint8_t len)
+{
+    // Checksum is "*HH": XOR of everything between '$' and '*'. TinyGPS++ ignores sentences without one too
+    if (len < 9 || sentence[len - 3] != '*')
+        return false;
+    uint8_t sum = 0;
+    for (uint8_t i = 1; i < len - 3; i++)
+        sum ^= sentence[i];
+    char expected[3];
+    snprintf(expected, sizeof(expected), "%02X", sum);
+    if (strncasecmp(expected, sentence + len - 2, 2) != 0) {
+        nmeaChecksumFails++;
+        return false;
+    }
+
+    // "$GPRMC", "$GNGGA" etc: two letter talker, then the type
+    const char *type = sentence + 3;
+    if (strncmp(type, "TXT", 3) == 0) {
+        if (strstr(sentence, "u-blox ag - www.u-blox.com"))
+            rebootsSeen++;
+        return false;
+    }
+    // While NAV-PVT keeps arriving it has everything RMC and GSA would give, but not HDOP, so keep GGA for that
+    if (hasFreshPVT() && strncmp(type, "GGA", 3) != 0)
+        return false;
+#if GPS_NMEA_FILTER
+    if (strncmp(type, "RMC", 3) != 0 && strncmp(type, "GGA", 3) != 0 && strncmp(type, "GSA", 3) != 0)
+        return false;
+#endif
+
+    bool isValid = false;
+    for (uint8_t i = 0; i < len; i++)
+        isValid |= reader.encode(sentence[i]);
+    isValid |= reader.encode('\r');
+    isValid |= reader.encode('\n');
+    return isValid;
+}
+
+static uint16_t ubxU2(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t ubxU4(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Called by whileActive with each byte of a UBX frame, from the 0xB5 sync char on. We only keep NAV-PVT, any other frame is skipped over
+bool GPS::handleUBXByte(uint8_t c)
+{
+    if (ubxLength < sizeof(ubxFrame))
+        ubxFrame[ubxLength] = c;
+    ubxLength++;
+
+    // Header: sync chars, class, ID, then the payload length
+    if (ubxLength < 6)
+        return false;
+    uint16_t payloadLen = ubxU2(&ubxFrame[4]);
+    if (payloadLen > UBX_MAX_PAYLOAD) {
+        ubxLength = 0;
+        return false;
+    }
+    if (ubxLength < payloadLen + 8u) // payload and checksum still to come
+        return false;
+    ubxLength = 0;
+
+    if (ubxFrame[2] != 0x01 || ubxFrame[3] != 0x07 || payloadLen != UBX_NAV_PVT_LEN)
+        return false;
+    uint8_t CK_A = 0, CK_B = 0;
+    for (uint16_t i = 2; i < payloadLen + 6; i++) {
+        CK_A += ubxFrame[i];
+        CK_B += CK_A;
+    }
+    if (CK_A != ubxFrame[payloadLen + 6] || CK_B != ubxFrame[payloadLen + 7]) {
+        nmeaChecksumFails++;
+        return false;
+    }
+
+    const uint8_t *pvt = &ubxFrame[6];
+    navPVT.year = ubxU2(&pvt[4]);
+    navPVT.month = pvt[6];
+    navPVT.day = pvt[7];
+    navPVT.hour = pvt[8];
+    navPVT.min = pvt[9];
+    navPVT.sec = pvt[10];
+    navPVT.valid = pvt[11];
+    navPVT.fixType = pvt[20];
+    navPVT.flags = pvt[21];
+    navPVT.numSV = pvt[23];
+    navPVT.lon = ubxU4(&pvt[24]);
+    navPVT.lat = ubxU4(&pvt[28]);
+    navPVT.height = ubxU4(&pvt[32]);
+    navPVT.hMSL = ubxU4(&pvt[36]);
+    navPVT.hAcc = ubxU4(&pvt[40]);
+    navPVT.vAcc = ubxU4(&pvt[44]);
+    navPVT.gSpeed = ubxU4(&pvt[60]);
+    navPVT.headMot = ubxU4(&pvt[64]);
+    navPVT.pDOP = ubxU2(&pvt[76]);
+    navPVT.receivedMsec = millis();
+    navPVT.updated = true;
+    return true;
+}
+
+bool GPS::hasFreshPVT()
+{
+    return navPVT.receivedMsec != 0 && Throttle::isWithinTimespanMs(navPVT.receivedMsec, GPS_SOL_EXPIRY_MS);
+}
+
 void GPS::enable()
 {
     // Clear the old scheduling info (reset the lock-time prediction)
@@ -74,7 +74,7 @@ class GPS : private concurrency::OSThread
     virtual ~GPS();
 
     /** We will notify this observable anytime GPS state has changed meaningfully */
-    Observable<const meshtastic::GPSStatus *> newStatus;
+    ObservableArray<const meshtastic::GPSStatus *, 2> newStatus;
 
     /**
      * Returns true if we succeeded
@@ -165,6 +165,8 @@ class GPS : private concurrency::OSThread
 
     uint8_t speedSelect = 0;
     uint8_t probeTries = 0;
+    bool triedCachedSpeed = false; // HARDWARE_CACHE: probed at the speed that worked last boot
+    int probedSpeed = 0;           // serial speed of the last probe()
 
     /**
      * hasValidLocation - indicates that the position variables contain a complete
@@ -203,6 +205,47 @@ class GPS : private concurrency::OSThread
 
     int rebootsSeen = 0;
 
+    // NMEA sentence being received by whileActive, from '$' up to (not including) the line ending
+    char nmeaSentence[100] = {0};
+    uint8_t nmeaLength = 0;         // 0 when between sentences
+    uint32_t nmeaChecksumFails = 0; // sentences (and UBX frames) we dropped before TinyGPS++ could count them
+
+    /// Check a complete NMEA sentence, then pass it to TinyGPS++ if it is one we use
+    /// @return true if TinyGPS++ parsed a valid sentence
+    bool handleSentence(const char *sentence, uint8_t len);
+
+    // The fields of a UBX-NAV-PVT frame that we use, as sent by u-blox M8 and later
+    struct NavPVT {
+        uint32_t receivedMsec = 0; // millis() when it arrived, 0 if none yet
+        bool updated = false;      // not yet read by lookForLocation
+        uint16_t year = 0;
+        uint8_t month = 0, day = 0, hour = 0, min = 0, sec = 0;
+        uint8_t valid = 0;   // bit 0 date valid, bit 1 time valid, bit 2 fully resolved
+        uint8_t fixType = 0; // 0 none, 1 dead reckoning, 2 2D, 3 3D, 4 GNSS + dead reckoning, 5 time only
+        uint8_t flags = 0;   // bit 0 gnssFixOK, bit 1 differential
+        uint8_t numSV = 0;
+        int32_t lon = 0, lat = 0;     // 1e-7 degrees
+        int32_t height = 0, hMSL = 0; // mm, above the ellipsoid and above mean sea level
+        uint32_t hAcc = 0, vAcc = 0;  // mm
+        int32_t gSpeed = 0;           // mm/s
+        int32_t headMot = 0;          // 1e-5 degrees
+        uint16_t pDOP = 0;            // 1e-2
+    } navPVT;
+
+    // UBX frame being received by whileActive, from the 0xB5 sync char
+    uint8_t ubxFrame[100] = {0}; // Big enough for NAV-PVT, the only frame we decode
+    uint32_t ubxLength = 0;      // 0 when not in a frame
+
+    /// Add a byte to the UBX frame being received
+    /// @return true if it completed a valid NAV-PVT frame
+    bool handleUBXByte(uint8_t c);
+
+    /// Whether navPVT is recent enough to be used instead of the NMEA sentences
+    bool hasFreshPVT();
+
+    /// lookForLocation, from the latest NAV-PVT frame
+    bool lookForPVTLocation();
+
     int getACK(uint8_t *buffer, uint16_t size, uint8_t requestedClass, uint8_t requestedID, uint32_t waitMillis);
     GPS_RESPONSE getACK(uint8_t c, uint8_t i, uint32_t waitMillis);
     GPS_RESPONSE getACK(const char *message, uint32_t waitMillis);
@@ -1,11 +1,23 @@
 #include "GPSUpdateScheduling.h"
 
 #include "Default.h"
+#include "main.h" // accelerometerThread
+
+// Below this long since the last lock, expect the GPS's ephemeris to still be current: a hot start
+#ifndef GPS_HOT_START_MAX_MS
+#define GPS_HOT_START_MAX_MS (2 * 60 * 60 * 1000UL)
+#endif
+
+// While the accelerometer says we haven't moved, stretch the time between locks to this (if gps_update_interval is shorter)
+#ifndef GPS_STATIONARY_INTERVAL_MS
+#define GPS_STATIONARY_INTERVAL_MS (60 * 60 * 1000UL)
+#endif
 
 // Mark the time when searching for GPS position begins
 void GPSUpdateScheduling::informSearching()
 {
     searchStartedMs = millis();
+    searchStartState = hasLocked ? startStateAfter(searchStartedMs - lastLockMs) : START_COLD;
 }
 
 // Mark the time when searching for GPS is complete,
@@ -13,8 +25,24 @@ void GPSUpdateScheduling::informSearching()
 void GPSUpdateScheduling::informGotLock()
 {
     searchEndedMs = millis();
-    LOG_DEBUG("Took %us to get lock", (searchEndedMs - searchStartedMs) / 1000);
+    LOG_DEBUG("Took %us to get lock (%s start)", (searchEndedMs - searchStartedMs) / 1000,
+              searchStartState == START_HOT ? "hot" : searchStartState == START_WARM ? "warm" : "cold");
     updateLockTimePrediction();
+
+    lastLockMs = searchEndedMs;
+    hasLocked = true;
+    lastSearchLocked = true;
+#if !defined(ARCH_STM32WL) && !MESHTASTIC_EXCLUDE_I2C
+    motionCountAtLock = MotionSensor::motionCount;
+#endif
+}
+
+// Mark the time when we gave up searching
+// Time spent not getting a lock tells us nothing about how long a lock takes, so don't learn from it
+void GPSUpdateScheduling::informSearchFailed()
+{
+    searchEndedMs = millis();
+    lastSearchLocked = false;
 }
 
 // Clear old lock-time prediction data.
@@ -23,8 +51,43 @@ void GPSUpdateScheduling::reset()
 {
     searchStartedMs = 0;
     searchEndedMs = 0;
-    searchCount = 0;
-    predictedMsToGetLock = 0;
+    lastLockMs = 0;
+    hasLocked = false;
+    lastSearchLocked = false;
+    searchStartState = START_COLD;
+    for (uint8_t i = 0; i < 2; i++) {
+        searchCount[i] = 0;
+        predictedMsToGetLock[i] = 0;
+    }
+}
+
+// What sort of start will the GPS make, if it starts searching this long after a lock?
+GPSUpdateScheduling::StartState GPSUpdateScheduling::startStateAfter(uint32_t msSinceLock)
+{
+    return (msSinceLock < GPS_HOT_START_MAX_MS) ? START_HOT : START_WARM;
+}
+
+// Target interval between GPS updates
+// Stretched while we're stationary: there's nothing new for another lock to tell us
+uint32_t GPSUpdateScheduling::targetIntervalMs()
+{
+    uint32_t updateInterval = Default::getConfiguredOrDefaultMs(config.position.gps_update_interval, default_gps_update_interval);
+    if (isStationary() && updateInterval < GPS_STATIONARY_INTERVAL_MS)
+        return GPS_STATIONARY_INTERVAL_MS;
+    return updateInterval;
+}
+
+// Have we kept still since our last lock, so that our position can't have changed?
+// Only trusted if the motion sensor has reported movement at some point: some never do (magnetometers, tap-only configs)
+bool GPSUpdateScheduling::isStationary()
+{
+#if !defined(ARCH_STM32WL) && !MESHTASTIC_EXCLUDE_I2C
+    if (!accelerometerThread || !accelerometerThread->enabled || MotionSensor::motionCount == 0)
+        return false;
+    return lastSearchLocked && MotionSensor::motionCount == motionCountAtLock;
+#else
+    return false;
+#endif
 }
 
 // How many milliseconds before we should next search for GPS position
@@ -33,12 +96,10 @@ uint32_t GPSUpdateScheduling::msUntilNextSearch()
 {
     uint32_t now = millis();
 
-    // Target interval (seconds), between GPS updates
-    uint32_t updateInterval = Default::getConfiguredOrDefaultMs(config.position.gps_update_interval, default_gps_update_interval);
-
     // Check how long until we should start searching, to hopefully hit our target interval
-    uint32_t dueAtMs = searchEndedMs + updateInterval;
-    uint32_t compensatedStart = dueAtMs - predictedMsToGetLock;
+    // If the accelerometer sees us move, we stop being stationary and this falls back to gps_update_interval
+    uint32_t dueAtMs = searchEndedMs + targetIntervalMs();
+    uint32_t compensatedStart = dueAtMs - predictedSearchDurationMs();
     int32_t remainingMs = compensatedStart - now;
 
     // If we should have already started (negative value), start ASAP
@@ -96,23 +157,32 @@ void GPSUpdateScheduling::updateLockTimePrediction()
     if (lockTime < 0)
         lockTime = 0;
 
-    // Ignore the first lock-time: likely to be long, will skew data
+    // Ignore cold starts: likely to be long, will skew data
+    if (searchStartState == START_COLD)
+        return;
 
-    // Second locktime: likely stable. Use to initialize the smoothing filter
-    if (searchCount == 1)
-        predictedMsToGetLock = lockTime;
+    uint32_t &count = searchCount[searchStartState];
+    uint32_t &predicted = predictedMsToGetLock[searchStartState];
 
-    // Third locktime and after: predict using exponential smoothing. Respond slowly to changes
-    else if (searchCount > 1)
-        predictedMsToGetLock = (lockTime * weighting) + (predictedMsToGetLock * (1 - weighting));
+    // First locktime of this kind: use to initialize the smoothing filter
+    if (count == 0)
+        predicted = lockTime;
+
+    // Later locktimes: predict using exponential smoothing. Respond slowly to changes
+    else
+        predicted = (lockTime * weighting) + (predicted * (1 - weighting));
 
-    searchCount++; // Only tracked so we can disregard initial lock-times
+    count++;
 
-    LOG_DEBUG("Predict %us to get next lock", predictedMsToGetLock / 1000);
+    LOG_DEBUG("Predict %us to get next %s lock", predicted / 1000, searchStartState == START_HOT ? "hot" : "warm");
 }
 
-// How long do we expect to spend searching for a lock?
+// How long do we expect to spend searching for our next lock?
+// Depends on whether that will be a hot or warm start. If we haven't seen one of those yet, go by the other.
 uint32_t GPSUpdateScheduling::predictedSearchDurationMs()
 {
-    return GPSUpdateScheduling::predictedMsToGetLock;
+    StartState next = startStateAfter(targetIntervalMs());
+    if (searchCount[next] == 0)
+        next = (next == START_HOT) ? START_WARM : START_HOT;
+    return searchCount[next] ? predictedMsToGetLock[next] : 0;
 }
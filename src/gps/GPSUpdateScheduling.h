@@ -8,7 +8,8 @@ class GPSUpdateScheduling
   public:
     // Marks the time of these events, for calculation use
     void informSearching();
-    void informGotLock(); // Predicted lock-time is recalculated here
+    void informGotLock();      // Predicted lock-time is recalculated here
+    void informSearchFailed(); // Gave up without a lock, nothing to learn from this search
 
     void reset();           // Reset the prediction - after GPS::disable() / GPS::enable()
     bool isUpdateDue();     // Is it time to begin searching for a GPS position?
@@ -16,14 +17,32 @@ class GPSUpdateScheduling
 
     uint32_t msUntilNextSearch(); // How long until we need to begin searching for a GPS? Info provided to GPS hardware for sleep
     uint32_t elapsedSearchMs();   // How long have we been searching so far?
-    uint32_t predictedSearchDurationMs(); // How long do we expect to spend searching for a lock?
+    uint32_t predictedSearchDurationMs(); // How long do we expect to spend searching for our next lock?
+    bool isStationary();                  // Has the accelerometer seen us keep still since our last lock?
 
   private:
+    // How much the GPS still remembers from its last lock, when it starts searching. Decides how long a lock takes.
+    enum StartState : uint8_t {
+        START_HOT,  // Ephemeris still current
+        START_WARM, // Ephemeris stale, but time, rough position and almanac are still good
+        START_COLD, // No lock since reset(), nothing to go on. Not learned from: too unpredictable
+    };
+    StartState startStateAfter(uint32_t msSinceLock);
+    uint32_t targetIntervalMs(); // How long we aim to leave between locks
+
     void updateLockTimePrediction(); // Called from informGotLock
     uint32_t searchStartedMs = 0;
     uint32_t searchEndedMs = 0;
-    uint32_t searchCount = 0;
-    uint32_t predictedMsToGetLock = 0;
+    uint32_t lastLockMs = 0;
+    bool hasLocked = false; // Have we locked since reset()?
+    bool lastSearchLocked = false;
+    StartState searchStartState = START_COLD;
+
+    // Learned separately for hot and warm starts
+    uint32_t searchCount[2] = {0, 0};
+    uint32_t predictedMsToGetLock[2] = {0, 0};
+
+    uint32_t motionCountAtLock = 0; // MotionSensor::motionCount when we last got a lock
 
     const float weighting = 0.2; // Controls exponential smoothing of lock-times prediction. 20% weighting of "latest lock-time".
-};
\ No newline at end of file
+};
@@ -375,6 +375,48 @@ void GeoCoord::convertWGS84ToOSGB36(const double lat, const double lon, double &
     //(airyA*airyA/(airyA / sqrt(1 - airyEcc*sin(osgb.latitude)*sin(osgb.latitude)))); // Not used, no OSTN data
 }
 
+// Radius latLongToMeter() has always used
+#define EARTH_RADIUS_METERS 6366000
+
+/**
+ * Distance and bearing for points close together, treating the earth as flat around them.  float only.
+ * @return false if the points are more than GEO_FLAT_MAX_DEG apart, the caller then needs the great circle math
+ */
+static bool flatDistanceAndBearing(float lat_a, float dLat, float dLng, float *meters, float *bearingRadians)
+{
+    const float degToRad = (float)(PI / 180);
+    if (dLng > 180)
+        dLng -= 360;
+    else if (dLng < -180)
+        dLng += 360;
+    if (fabsf(dLat) > GEO_FLAT_MAX_DEG || fabsf(dLng) > GEO_FLAT_MAX_DEG)
+        return false;
+
+    float east = dLng * cosf((lat_a + dLat / 2) * degToRad);
+    float north = dLat;
+    if (meters)
+        *meters = EARTH_RADIUS_METERS * degToRad * sqrtf(east * east + north * north);
+    if (bearingRadians)
+        *bearingRadians = atan2f(east, north);
+    return true;
+}
+
+void GeoCoord::distanceAndBearing(int32_t lat_a_i, int32_t lng_a_i, int32_t lat_b_i, int32_t lng_b_i, float *meters,
+                                  float *bearingRadians)
+{
+    // The differences in integer math, exact however far from the equator and meridian
+    float dLat = ((int64_t)lat_b_i - lat_a_i) * 1e-7f;
+    float dLng = ((int64_t)lng_b_i - lng_a_i) * 1e-7f;
+    if (flatDistanceAndBearing(lat_a_i * 1e-7f, dLat, dLng, meters, bearingRadians))
+        return;
+
+    double lat_a = lat_a_i * 1e-7, lng_a = lng_a_i * 1e-7, lat_b = lat_b_i * 1e-7, lng_b = lng_b_i * 1e-7;
+    if (meters)
+        *meters = latLongToMeter(lat_a, lng_a, lat_b, lng_b);
+    if (bearingRadians)
+        *bearingRadians = bearing(lat_a, lng_a, lat_b, lng_b);
+}
+
 /// Ported from my old java code, returns distance in meters along the globe
 /// surface (by Haversine formula)
 float GeoCoord::latLongToMeter(double lat_a, double lng_a, double lat_b, double lng_b)
@@ -383,6 +425,10 @@ float GeoCoord::latLongToMeter(double lat_a, double lng_a, double lat_b, double
     if (lat_a == lat_b && lng_a == lng_b)
         return 0.0;
 
+    float meters;
+    if (flatDistanceAndBearing(lat_a, lat_b - lat_a, lng_b - lng_a, &meters, NULL))
+        return meters;
+
     double a1 = lat_a / DEG_CONVERT;
     double a2 = lng_a / DEG_CONVERT;
     double b1 = lat_b / DEG_CONVERT;
@@ -396,7 +442,7 @@ float GeoCoord::latLongToMeter(double lat_a, double lng_a, double lat_b, double
     if (std::isnan(tt))
         tt = 0.0; // Must have been the same point?
 
-    return (float)(6366000 * tt);
+    return (float)(EARTH_RADIUS_METERS * tt);
 }
 
 /**
@@ -416,6 +462,10 @@ float GeoCoord::latLongToMeter(double lat_a, double lng_a, double lat_b, double
  */
 float GeoCoord::bearing(double lat1, double lon1, double lat2, double lon2)
 {
+    float b;
+    if (flatDistanceAndBearing(lat1, lat2 - lat1, lon2 - lon1, NULL, &b))
+        return b;
+
     double lat1Rad = toRadians(lat1);
     double lat2Rad = toRadians(lat2);
     double deltaLonRad = toRadians(lon2 - lon1);
@@ -13,6 +13,13 @@
 #define OLC_CODE_LEN 11
 #define DEG_CONVERT (180 / PI)
 
+// Points closer than this many degrees in latitude and longitude (about 50km) get their distance and bearing from the
+// equirectangular approximation, in float, which is off by far less than a GPS fix.  The great circle math needs double
+// precision, which nRF52 and ESP32 do in software.
+#ifndef GEO_FLAT_MAX_DEG
+#define GEO_FLAT_MAX_DEG 0.5f
+#endif
+
 // GeoCoord structs/classes
 // A struct to hold the data for a DMS coordinate.
 struct DMS {
@@ -93,6 +100,9 @@ class GeoCoord
     static void convertWGS84ToOSGB36(const double lat, const double lon, double &osgb_Latitude, double &osgb_Longitude);
     static float latLongToMeter(double lat_a, double lng_a, double lat_b, double lng_b);
     static float bearing(double lat1, double lon1, double lat2, double lon2);
+    // Both at once, from positions in 1e-7 degrees as they come in packets.  Bearing in radians, like bearing()
+    static void distanceAndBearing(int32_t lat_a_i, int32_t lng_a_i, int32_t lat_b_i, int32_t lng_b_i, float *meters,
+                                   float *bearingRadians);
     static float rangeRadiansToMeters(double range_radians);
     static float rangeMetersToRadians(double range_meters);
     static unsigned int bearingToDegrees(const char *bearing);
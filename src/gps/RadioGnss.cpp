@@ -0,0 +1,80 @@
+#include "RadioGnss.h"
+#if !MESHTASTIC_EXCLUDE_GPS && LR11X0_GNSS
+
+#include "NodeDB.h"
+#include "RTC.h"
+#include "TypeConversions.h"
+#include "modules/PositionModule.h"
+
+/// While positions are off, look again this often to see whether they have been turned on
+static constexpr uint32_t DISABLED_CHECK_MS = 60 * 1000;
+
+/// A radio busy with a packet is asked again this soon
+static constexpr uint32_t BUSY_RETRY_MS = 2000;
+
+RadioGnss *radioGnss;
+
+RadioGnss::RadioGnss(RadioInterface *radio) : concurrency::OSThread("RadioGnss"), radio(radio)
+{
+    scheduling.reset();
+}
+
+bool RadioGnss::getAssistPosition(meshtastic_Position &assist)
+{
+    if (hasFix) {
+        assist = last;
+        return true;
+    }
+    const meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(nodeDB->getNodeNum());
+    if (!node || !node->has_position || (!node->position.latitude_i && !node->position.longitude_i))
+        return false;
+    assist = TypeConversions::ConvertToPosition(node->position);
+    return true;
+}
+
+int32_t RadioGnss::runOnce()
+{
+    if (config.position.gps_mode != meshtastic_Config_PositionConfig_GpsMode_ENABLED || config.position.fixed_position)
+        return DISABLED_CHECK_MS;
+    if (!scheduling.isUpdateDue())
+        return scheduling.msUntilNextSearch();
+
+    meshtastic_Position assist = meshtastic_Position_init_default;
+    bool haveAssist = getAssistPosition(assist);
+    meshtastic_Position fix = meshtastic_Position_init_default;
+
+    scheduling.informSearching();
+    switch (radio->gnssScan(haveAssist ? &assist : NULL, fix)) {
+    case RadioInterface::GNSS_SCAN_UNSUPPORTED:
+        LOG_WARN("Radio has no GNSS scanner, no positions");
+        return disable();
+    case RadioInterface::GNSS_SCAN_BUSY:
+        return BUSY_RETRY_MS;
+    case RadioInterface::GNSS_SCAN_NO_FIX:
+        LOG_INFO("Radio GNSS scan found no position");
+        scheduling.informSearchFailed();
+        break;
+    case RadioInterface::GNSS_SCAN_FIX:
+        scheduling.informGotLock();
+        last = fix;
+        hasFix = true;
+        publish();
+        break;
+    }
+    return scheduling.msUntilNextSearch();
+}
+
+void RadioGnss::publish()
+{
+    last.location_source = meshtastic_Position_LocSource_LOC_INTERNAL;
+    last.time = getValidTime(RTCQualityFromNet);
+    last.timestamp = last.time;
+    LOG_DEBUG("Radio GNSS pos@%x lat=%d lon=%d sats=%u", last.timestamp, last.latitude_i, last.longitude_i, last.sats_in_view);
+
+    nodeDB->updatePosition(nodeDB->getNodeNum(), last, RX_SRC_LOCAL);
+    const meshtastic::GPSStatus status = meshtastic::GPSStatus(true, true, true, last);
+    newStatus.notifyObservers(&status);
+    if (positionModule)
+        positionModule->handleNewPosition();
+}
+#endif
@@ -0,0 +1,48 @@
+#pragma once
+#include "configuration.h"
+#include "mesh/RadioInterface.h"
+#if !MESHTASTIC_EXCLUDE_GPS && LR11X0_GNSS
+
+#include "GPSStatus.h"
+#include "GPSUpdateScheduling.h"
+#include "Observer.h"
+#include "concurrency/OSThread.h"
+
+/// Use the radio's GNSS scanner even on boards with a GPS, which is then left off: a scan costs far less energy per fix
+#ifndef LR11X0_GNSS_PREFERRED
+#define LR11X0_GNSS_PREFERRED 0
+#endif
+
+/**
+ * Positions from the GNSS scanner built into LR1110 and LR1120 radios, for trackers that have no GPS of their own.
+ *
+ * The scanner only listens for a few seconds and the radio solves the position from what it caught, instead of a GPS running
+ * until it has tracked satellites for a lock, so each fix costs a fraction of the energy.  The catch is that LoRa receive
+ * stops while it scans, so a scan waits until no packet is on its way in or out.  Scans follow
+ * config.position.gps_update_interval through GPSUpdateScheduling as the GPS does, and each is assisted with the last fix.
+ */
+class RadioGnss : private concurrency::OSThread
+{
+  public:
+    explicit RadioGnss(RadioInterface *radio);
+
+    /** We will notify this observable anytime we have a new position, as GPS::newStatus does */
+    ObservableArray<const meshtastic::GPSStatus *, 2> newStatus;
+
+  protected:
+    virtual int32_t runOnce() override;
+
+  private:
+    RadioInterface *radio;
+    GPSUpdateScheduling scheduling;
+    meshtastic_Position last = meshtastic_Position_init_default; // our last fix, to assist the next scan
+    bool hasFix = false;
+
+    /// Where the scan should start from: our last fix, else whatever position NodeDB has for us
+    bool getAssistPosition(meshtastic_Position &assist);
+
+    void publish();
+};
+
+extern RadioGnss *radioGnss;
+#endif
@@ -1,5 +1,6 @@
 #include "Throttle.h"
 #include "configuration.h"
+#include "memGet.h"
 
 #if defined(USE_EINK) && defined(USE_EINK_DYNAMICDISPLAY)
 #include "EInkDynamicDisplay.h"
@@ -10,7 +11,8 @@ EInkDynamicDisplay::EInkDynamicDisplay(uint8_t address, int sda, int scl, OLEDDI
 {
     // If tracking ghost pixels, grab memory
 #ifdef EINK_LIMIT_GHOSTING_PX
-    dirtyPixels = new uint8_t[EInkDisplay::displayBufferSize](); // Init with zeros
+    dirtyPixels = (uint8_t *)memGet.allocCold(EInkDisplay::displayBufferSize); // Never drawn from an ISR, may go to PSRAM
+    memset(dirtyPixels, 0, EInkDisplay::displayBufferSize);
 #endif
 }
 
@@ -19,7 +21,7 @@ EInkDynamicDisplay::~EInkDynamicDisplay()
 {
     // If we were tracking ghost pixels, free the memory
 #ifdef EINK_LIMIT_GHOSTING_PX
-    delete[] dirtyPixels;
+    free(dirtyPixels);
 #endif
 }
 
@@ -0,0 +1,175 @@
+#include "NodeListModel.h"
+#if HAS_SCREEN || defined(MESHTASTIC_INCLUDE_INKHUD)
+#include "gps/GeoCoord.h"
+#include "gps/RTC.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+namespace graphics
+{
+
+NodeListModel nodeListModel;
+
+static bool numBefore(const NodeListEntry &e, NodeNum n)
+{
+    return e.num < n;
+}
+
+void NodeListModel::formatName(const meshtastic_NodeInfoLite *node, char *name, size_t size)
+{
+    if (!node->has_user || !node->user.short_name[0]) {
+        snprintf(name, size, "?");
+        return;
+    }
+
+    for (const char *c = node->user.short_name; *c; c++) {
+        if ((uint8_t)*c < 32 || (uint8_t)*c > 126) {
+            snprintf(name, size, "%04X", (uint16_t)(node->num & 0xFFFF));
+            return;
+        }
+    }
+    snprintf(name, size, "%s", node->user.short_name);
+}
+
+void NodeListModel::refresh()
+{
+    meshtastic_NodeInfoLite *ourNode = nodeDB->getMeshNode(nodeDB->getNodeNum());
+    bool validOrigin = ourNode && nodeDB->hasValidPosition(ourNode);
+    int32_t lat = validOrigin ? ourNode->position.latitude_i : 0;
+    int32_t lon = validOrigin ? ourNode->position.longitude_i : 0;
+    int units = config.display.units;
+
+    bool originChanged = validOrigin != haveOrigin || lat != originLat || lon != originLon || units != builtUnits;
+    haveOrigin = validOrigin;
+    originLat = lat;
+    originLon = lon;
+    builtUnits = units;
+
+    bool nodesChanged = !built || nodeDB->getChangeCount() != builtChangeCount;
+    if (nodesChanged)
+        rebuild(!originChanged);
+    else if (originChanged)
+        for (NodeListEntry &e : entries)
+            updateDistance(e);
+
+    uint32_t now = getTime();
+    if (nodesChanged || now / 60 != builtMinute) {
+        builtMinute = now / 60;
+        for (NodeListEntry &e : entries)
+            updateAge(e, now);
+    }
+}
+
+void NodeListModel::rebuild(bool keepDistances)
+{
+    // Index the last list by node number, so unmoved nodes can keep their distances
+    previous.swap(entries);
+    entries.clear();
+    if (keepDistances)
+        std::sort(previous.begin(), previous.end(),
+                  [](const NodeListEntry &a, const NodeListEntry &b) { return a.num < b.num; });
+
+    size_t numNodes = nodeDB->getNumMeshNodes();
+    entries.reserve(numNodes);
+    for (size_t i = 0; i < numNodes; i++) {
+        const meshtastic_NodeInfoLite *node = nodeDB->getMeshNodeByIndex(i);
+        if (node->num == nodeDB->getNodeNum())
+            continue;
+
+        entries.emplace_back();
+        NodeListEntry &e = entries.back();
+        e.num = node->num;
+        e.lastHeard = node->last_heard;
+        e.snr = node->snr;
+        e.hasHops = node->has_hops_away;
+        e.hopsAway = node->hops_away;
+        e.isFavorite = node->is_favorite;
+        formatName(node, e.name, sizeof(e.name));
+
+        e.hasPosition = nodeDB->hasValidPosition(node);
+        e.latitude_i = e.hasPosition ? node->position.latitude_i : 0;
+        e.longitude_i = e.hasPosition ? node->position.longitude_i : 0;
+
+        auto old = std::lower_bound(previous.begin(), previous.end(), e.num, numBefore);
+        if (keepDistances && old != previous.end() && old->num == e.num && old->hasPosition == e.hasPosition &&
+            old->latitude_i == e.latitude_i && old->longitude_i == e.longitude_i) {
+            e.distanceMeters = old->distanceMeters;
+            e.bearing = old->bearing;
+            memcpy(e.distance, old->distance, sizeof(e.distance));
+        } else {
+            updateDistance(e);
+        }
+    }
+
+    built = true;
+    builtChangeCount = nodeDB->getChangeCount();
+}
+
+void NodeListModel::updateDistance(NodeListEntry &e)
+{
+    e.distanceMeters = NodeListEntry::DISTANCE_UNKNOWN;
+    e.bearing = 0;
+    e.distance[0] = '\0';
+    if (!haveOrigin || !e.hasPosition)
+        return;
+
+    float meters, bearing;
+    GeoCoord::distanceAndBearing(originLat, originLon, e.latitude_i, e.longitude_i, &meters, &bearing);
+    e.distanceMeters = meters;
+    e.bearing = bearing * (float)RAD_TO_DEG;
+
+    // At most 4 characters, to fit beside the name
+    if (builtUnits == meshtastic_Config_DisplayConfig_DisplayUnits_IMPERIAL) {
+        double miles = e.distanceMeters / 1609.344;
+        if (miles < 0.1) {
+            int feet = (int)(miles * 5280);
+            if (feet < 1000)
+                snprintf(e.distance, sizeof(e.distance), "%dft", feet);
+            else
+                snprintf(e.distance, sizeof(e.distance), "¼mi"); // 4-char max
+        } else {
+            int roundedMiles = (int)(miles + 0.5);
+            if (roundedMiles < 1000)
+                snprintf(e.distance, sizeof(e.distance), "%dmi", roundedMiles);
+            else
+                snprintf(e.distance, sizeof(e.distance), "999"); // Max display cap
+        }
+    } else {
+        if (e.distanceMeters < 1000) {
+            snprintf(e.distance, sizeof(e.distance), "%um", (unsigned)e.distanceMeters);
+        } else {
+            unsigned km = (e.distanceMeters + 500) / 1000;
+            if (km < 1000)
+                snprintf(e.distance, sizeof(e.distance), "%uk", km);
+            else
+                snprintf(e.distance, sizeof(e.distance), "999");
+        }
+    }
+}
+
+void NodeListModel::updateAge(NodeListEntry &e, uint32_t now)
+{
+    int delta = (int)(now - e.lastHeard); // as sinceLastSeen()
+    uint32_t seconds = delta < 0 ? 0 : delta;
+    uint32_t minutes = seconds / 60, hours = minutes / 60, days = hours / 24;
+    if (seconds == 0 || days > 365)
+        snprintf(e.age, sizeof(e.age), "?");
+    else if (days)
+        snprintf(e.age, sizeof(e.age), "%ud", (unsigned)days);
+    else if (hours)
+        snprintf(e.age, sizeof(e.age), "%uh", (unsigned)hours);
+    else
+        snprintf(e.age, sizeof(e.age), "%um", (unsigned)minutes);
+}
+
+const NodeListEntry *NodeListModel::find(NodeNum n) const
+{
+    for (const NodeListEntry &e : entries)
+        if (e.num == n)
+            return &e;
+    return NULL;
+}
+
+} // namespace graphics
+#endif
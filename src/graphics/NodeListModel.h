@@ -0,0 +1,73 @@
+#pragma once
+
+#include "configuration.h"
+#include "mesh/NodeDB.h"
+#include <vector>
+
+namespace graphics
+{
+
+/**
+ * Everything the node list screens draw for one node, worked out once instead of on every frame
+ */
+struct NodeListEntry {
+    static constexpr uint32_t DISTANCE_UNKNOWN = UINT32_MAX;
+
+    NodeNum num = 0;
+    uint32_t lastHeard = 0;
+    float snr = 0;
+    bool hasHops = false;
+    uint8_t hopsAway = 0;
+    bool isFavorite = false;
+
+    char name[sizeof(meshtastic_User::short_name)] = ""; // short name, or the low 16 bits of num in hex
+    char age[6] = "";                                    // time since last heard: "5m", "2h", "3d" or "?"
+
+    bool hasPosition = false;
+    int32_t latitude_i = 0, longitude_i = 0; // the node position distance and bearing were worked out from
+    uint32_t distanceMeters = DISTANCE_UNKNOWN;
+    float bearing = 0;     // degrees true from our position, only valid if distanceMeters is known
+    char distance[8] = ""; // distanceMeters in the display units, empty if unknown
+};
+
+/**
+ * A view of the NodeDB shared by the node list screens (and InkHUD's node list applets).
+ *
+ * The list is in NodeDB order with our own node left out.  It is only rebuilt when NodeDB::getChangeCount() says a node
+ * changed, and even then distances and bearings are carried over for nodes that haven't moved.  They are recomputed for
+ * everyone only when our own position or the display units change, and the age strings once a minute.
+ */
+class NodeListModel
+{
+  public:
+    /// Bring the list up to date, cheap when nothing has changed since the last call
+    void refresh();
+
+    size_t size() const { return entries.size(); }
+    const NodeListEntry &operator[](size_t i) const { return entries[i]; }
+
+    /// @return the entry for n, NULL if it isn't in the list (as of the last refresh)
+    const NodeListEntry *find(NodeNum n) const;
+
+    /// Write a printable short name for node into name, falling back to its node number in hex
+    static void formatName(const meshtastic_NodeInfoLite *node, char *name, size_t size);
+
+  private:
+    std::vector<NodeListEntry> entries;
+    std::vector<NodeListEntry> previous; // the last list, kept for its capacity and to carry distances over
+
+    bool built = false;
+    uint32_t builtChangeCount = 0;
+    bool haveOrigin = false; // whether we had a valid position of our own
+    int32_t originLat = 0, originLon = 0;
+    int builtUnits = -1;
+    uint32_t builtMinute = 0;
+
+    void rebuild(bool keepDistances);
+    void updateDistance(NodeListEntry &e);
+    void updateAge(NodeListEntry &e, uint32_t now);
+};
+
+extern NodeListModel nodeListModel;
+
+} // namespace graphics
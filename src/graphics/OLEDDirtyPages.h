@@ -0,0 +1,136 @@
+#pragma once
+
+#include "configuration.h"
+
+/// Set to 1 to send SSD1306 and SH1106 panels only the pages that changed since the last frame, through I2CBus
+#ifndef OLED_DIRTY_PAGES
+#define OLED_DIRTY_PAGES 0
+#endif
+
+/// I2C clock for the panel with OLED_DIRTY_PAGES, set 1000000 for panels (and buses) that do Fast-mode Plus
+#ifndef OLED_I2C_CLOCK_HZ
+#define OLED_I2C_CLOCK_HZ 700000 // what the OLED library runs them at
+#endif
+
+#if OLED_DIRTY_PAGES && !defined(USE_SH1107) && !defined(USE_SH1107_128_64) && (defined(USE_SH1106) || defined(USE_SSD1306))
+
+#include "I2CBus.h"
+#include <OLEDDisplay.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef USE_SH1106
+#include <SH1106Wire.h>
+#else
+#include <SSD1306Wire.h>
+#endif
+
+namespace graphics
+{
+
+/**
+ * An SSD1306Wire or SH1106Wire whose display() compares each 8 pixel high page with what was last sent and sends only the
+ * changed columns of changed pages, instead of the one box around every change (or, without OLEDDISPLAY_DOUBLE_BUFFER, the
+ * whole panel) the library sends.  A clock ticking over in one corner costs a page or two rather than the frame.
+ *
+ * Each page goes in its own I2CBus transactions, at OLED_I2C_CLOCK_HZ for the panel only, so sensors and keyboards on the
+ * same bus get it between pages and keep their own clocks.  Setup and on/off commands still go through the library.
+ */
+template <class Base> class DirtyPageOLED : public Base
+{
+  public:
+    DirtyPageOLED(uint8_t address, OLEDDISPLAY_GEOMETRY geometry, HW_I2C i2cBus)
+        : Base(address, -1, -1, geometry, i2cBus), address(address)
+    {
+#if WIRE_INTERFACES_COUNT == 2
+        bus = I2CBus::get(i2cBus == HW_I2C::I2C_TWO ? &Wire1 : &Wire);
+#else
+        bus = I2CBus::get(&Wire);
+#endif
+        bus->setDeviceClock(address, OLED_I2C_CLOCK_HZ);
+    }
+
+    ~DirtyPageOLED() { free(sent); }
+
+    virtual void display(void) override
+    {
+        const uint16_t w = this->width(), pages = this->height() / 8;
+        if (!sent) {
+            sent = (uint8_t *)malloc(w * pages);
+            if (!sent) {
+                Base::display();
+                return;
+            }
+            memset(sent, 0, w * pages);
+            sendAll = true; // whatever the panel holds now, it isn't known to be what we last sent
+        }
+
+        for (uint16_t page = 0; page < pages; page++) {
+            const uint8_t *now = this->buffer + page * w;
+            uint8_t *before = sent + page * w;
+            int16_t x0 = 0, x1 = w - 1;
+            if (!sendAll) {
+                while (x0 < w && now[x0] == before[x0])
+                    x0++;
+                if (x0 == w)
+                    continue; // page unchanged
+                while (now[x1] == before[x1])
+                    x1--;
+            }
+
+            setWindow(page, x0, x1);
+            for (int16_t x = x0; x <= x1;) {
+                uint8_t data[1 + CHUNK] = {0x40}; // Co = 0, D/C# = 1: display data follows
+                uint8_t n = 0;
+                while (n < CHUNK && x <= x1)
+                    data[1 + n++] = now[x++];
+                bus->write(address, data, 1 + n);
+            }
+            memcpy(before + x0, now + x0, x1 - x0 + 1);
+        }
+        sendAll = false;
+    }
+
+    /// Send the whole frame next time, after anything that may have changed the panel's memory behind our back
+    void invalidate() { sendAll = true; }
+
+  private:
+    static constexpr uint8_t CHUNK = 16; // data bytes per transaction, fits the smallest Wire buffers
+
+    const uint8_t address;
+    I2CBus *bus;
+    uint8_t *sent = NULL; // the frame as the panel has it, page by page
+    bool sendAll = true;
+
+    /// Point the panel's RAM at columns x0..x1 of page
+    void setWindow(uint8_t page, uint8_t x0, uint8_t x1);
+
+    void sendCommands(const uint8_t *commands, uint8_t len)
+    {
+        uint8_t data[8] = {0x00}; // Co = 0, D/C# = 0: commands follow
+        memcpy(data + 1, commands, len);
+        bus->write(address, data, 1 + len);
+    }
+};
+
+#ifdef USE_SH1106
+// Page addressing, the 132 column RAM has the panel's 128 in the middle
+template <> inline void DirtyPageOLED<SH1106Wire>::setWindow(uint8_t page, uint8_t x0, uint8_t x1)
+{
+    const uint8_t col = x0 + 2;
+    const uint8_t commands[] = {(uint8_t)(0xB0 | page), (uint8_t)(col & 0x0F), (uint8_t)(0x10 | (col >> 4))};
+    sendCommands(commands, sizeof(commands));
+}
+#else
+// Horizontal addressing as the library sets it up, narrower panels are centered in the 128 columns
+template <> inline void DirtyPageOLED<SSD1306Wire>::setWindow(uint8_t page, uint8_t x0, uint8_t x1)
+{
+    const uint8_t offset = (128 - width()) / 2;
+    const uint8_t commands[] = {COLUMNADDR, (uint8_t)(x0 + offset), (uint8_t)(x1 + offset), PAGEADDR, page, page};
+    sendCommands(commands, sizeof(commands));
+}
+#endif
+
+} // namespace graphics
+
+#endif
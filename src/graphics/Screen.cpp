@@ -49,6 +49,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "error.h"
 #include "gps/GeoCoord.h"
 #include "gps/RTC.h"
+#include "graphics/OLEDDirtyPages.h"
 #include "graphics/ScreenFonts.h"
 #include "graphics/SharedUIDisplay.h"
 #include "graphics/emotes.h"
@@ -90,7 +91,7 @@ namespace graphics
 #define IDLE_FRAMERATE 1 // in fps
 
 // DEBUG
-#define NUM_EXTRA_FRAMES 3 // text message and debug frame
+#define NUM_EXTRA_FRAMES 4 // text message, debug and airtime frames
 // if defined a pixel will blink to show redraws
 // #define SHOW_REDRAWS
 
@@ -230,7 +231,10 @@ Screen::Screen(ScanI2C::DeviceAddress address, meshtastic_Config_DisplayConfig_O
     : concurrency::OSThread("Screen"), address_found(address), model(screenType), geometry(geometry), cmdQueue(32)
 {
     graphics::normalFrames = new FrameCallback[MAX_NUM_NODES + NUM_EXTRA_FRAMES];
-#if defined(USE_SH1106) || defined(USE_SH1107) || defined(USE_SH1107_128_64)
+#if OLED_DIRTY_PAGES && defined(USE_SH1106) && !defined(USE_SH1107) && !defined(USE_SH1107_128_64)
+    dispdev = new DirtyPageOLED<SH1106Wire>(address.address, geometry,
+                                            (address.port == ScanI2C::I2CPort::WIRE1) ? HW_I2C::I2C_TWO : HW_I2C::I2C_ONE);
+#elif defined(USE_SH1106) || defined(USE_SH1107) || defined(USE_SH1107_128_64)
     dispdev = new SH1106Wire(address.address, -1, -1, geometry,
                              (address.port == ScanI2C::I2CPort::WIRE1) ? HW_I2C::I2C_TWO : HW_I2C::I2C_ONE);
 #elif defined(USE_ST7789)
@@ -241,6 +245,9 @@ Screen::Screen(ScanI2C::DeviceAddress address, meshtastic_Config_DisplayConfig_O
     dispdev = new ST7789Spi(&SPI1, ST7789_RESET, ST7789_RS, ST7789_NSS, GEOMETRY_RAWMODE, TFT_WIDTH, TFT_HEIGHT);
     static_cast<ST7789Spi *>(dispdev)->setRGB(COLOR565(255, 255, 128));
 #endif
+#elif OLED_DIRTY_PAGES && defined(USE_SSD1306)
+    dispdev = new DirtyPageOLED<SSD1306Wire>(address.address, geometry,
+                                             (address.port == ScanI2C::I2CPort::WIRE1) ? HW_I2C::I2C_TWO : HW_I2C::I2C_ONE);
 #elif defined(USE_SSD1306)
     dispdev = new SSD1306Wire(address.address, -1, -1, geometry,
                               (address.port == ScanI2C::I2CPort::WIRE1) ? HW_I2C::I2C_TWO : HW_I2C::I2C_ONE);
@@ -655,7 +662,8 @@ int32_t Screen::runOnce()
 
     // this must be before the frameState == FIXED check, because we always
     // want to draw at least one FIXED frame before doing forceDisplay
-    ui->update();
+    if (needsRedraw())
+        ui->update();
 
     // Switch to a low framerate (to save CPU) when we are not in transition
     // but we should only call setTargetFPS when framestate changes, because
@@ -834,6 +842,10 @@ void Screen::setFrames(FrameFocus focus)
         fsi.positions.lora = numframes;
         normalFrames[numframes++] = graphics::DebugRenderer::drawLoRaFocused;
         indicatorIcons.push_back(icon_radio);
+#if AIRTIME_TOP_TALKERS
+        normalFrames[numframes++] = graphics::DebugRenderer::drawAirtimeTalkers;
+        indicatorIcons.push_back(icon_radio);
+#endif
     }
     if (!dismissedFrames.memory) {
         fsi.positions.memory = numframes;
@@ -1105,6 +1117,88 @@ void Screen::handleShowNextFrame()
 #define SCREEN_TRANSITION_FRAMERATE 30 // fps
 #endif
 
+// Never skip redraws for this long after switching frames, the navigation bar hides itself and E-Ink cleans up ghosting
+#ifndef SCREEN_SETTLE_MSEC
+#define SCREEN_SETTLE_MSEC 15000
+#endif
+
+// Redraw a frame at least this often even if nothing it depends on seems to have changed
+#ifndef SCREEN_MAX_SKIP_MSEC
+#define SCREEN_MAX_SKIP_MSEC 30000
+#endif
+
+uint8_t Screen::getRenderDependencies(FrameCallback frame)
+{
+    if (frame == graphics::UIRenderer::drawDeviceFocused)
+        return RENDER_DEP_NODEDB | RENDER_DEP_GPS;
+#ifdef USE_EINK
+    if (frame == graphics::NodeListRenderer::drawLastHeardScreen || frame == graphics::NodeListRenderer::drawHopSignalScreen ||
+        frame == graphics::NodeListRenderer::drawDistanceScreen)
+        return RENDER_DEP_NODEDB | RENDER_DEP_GPS;
+#endif
+    // Everything else has animations, seconds counters, compass headings or live radio stats
+    return RENDER_DEP_ALWAYS;
+}
+
+uint32_t Screen::getRenderKey(uint8_t deps)
+{
+    uint32_t key = 2166136261u; // FNV-1a
+    auto mix = [&key](uint32_t v) { key = (key ^ v) * 16777619u; };
+
+    // The header: battery, clock and the unread / muted icons, plus anything shown to the minute (uptime, last heard)
+    bool isCharging = powerStatus->getIsCharging() == meshtastic::OptionalBool::OptTrue;
+    mix(powerStatus->getBatteryChargePercent());
+    mix(isCharging);
+#ifndef USE_EINK
+    if (isCharging)
+        mix(millis() / 500); // the bolt blinks
+#endif
+    mix(getValidTime(RTCQuality::RTCQualityDevice, true) / 60);
+    mix(millis() / 60000);
+    mix(hasUnreadMessage);
+    mix(isMuted);
+
+    if (deps & RENDER_DEP_NODEDB)
+        mix(nodeDB->getChangeCount());
+    if (deps & RENDER_DEP_GPS) {
+        mix(gpsStatus->getHasLock());
+        mix(gpsStatus->getIsConnected());
+        mix(gpsStatus->getLatitude());
+        mix(gpsStatus->getLongitude());
+        mix(gpsStatus->getAltitude());
+        mix(gpsStatus->getNumSatellites());
+        mix(gpsStatus->getDOP());
+        if (config.position.fixed_position)
+            mix(millis() / 10000); // alternates with "Fixed GPS"
+    }
+    return key;
+}
+
+bool Screen::needsRedraw()
+{
+    const OLEDDisplayUiState *state = ui->getUiState();
+    uint32_t now = millis();
+    if (state->currentFrame != lastRenderFrame) {
+        lastRenderFrame = state->currentFrame;
+        lastFrameSwitchMsec = now;
+    }
+
+    // Skipping is only safe for our own frames while they sit still, with no banner or transition on top
+    uint8_t deps = RENDER_DEP_ALWAYS;
+    if (showingNormalScreen && state->frameState == FIXED && targetFramerate == IDLE_FRAMERATE &&
+        state->currentFrame < framesetInfo.frameCount && !NotificationRenderer::isOverlayBannerShowing() &&
+        now - lastFrameSwitchMsec > SCREEN_SETTLE_MSEC && now - lastRenderMsec < SCREEN_MAX_SKIP_MSEC)
+        deps = getRenderDependencies(normalFrames[state->currentFrame]);
+
+    uint32_t key = (deps == RENDER_DEP_ALWAYS) ? 0 : getRenderKey(deps);
+    if (deps != RENDER_DEP_ALWAYS && key == lastRenderKey)
+        return false;
+
+    lastRenderKey = key;
+    lastRenderMsec = now;
+    return true;
+}
+
 void Screen::setFastFramerate()
 {
     // We are about to start a transition so speed up fps
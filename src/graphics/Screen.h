@@ -648,6 +648,25 @@ class Screen : public concurrency::OSThread
     /// Try to start drawing ASAP
     void setFastFramerate();
 
+    /// What a frame shows, beyond the header every frame has, so runOnce() can skip redrawing it when none of that changed
+    enum RenderDependency : uint8_t {
+        RENDER_DEP_NODEDB = 1 << 0, // any node heard, changed, added or removed
+        RENDER_DEP_GPS = 1 << 1,    // our own position and fix
+        RENDER_DEP_ALWAYS = 0xFF    // animated or otherwise unpredictable, redraw at the normal framerate
+    };
+    static uint8_t getRenderDependencies(FrameCallback frame);
+
+    /// @return a hash of everything a frame with these dependencies shows
+    uint32_t getRenderKey(uint8_t deps);
+
+    /// @return false if the current frame would look exactly like it did last time we drew it
+    bool needsRedraw();
+
+    uint32_t lastRenderKey = 0;
+    uint32_t lastRenderMsec = 0;
+    uint32_t lastFrameSwitchMsec = 0;
+    int16_t lastRenderFrame = -1;
+
     // Sets frame up for immediate drawing
     void setFrameImmediateDraw(FrameCallback *drawFrames);
 
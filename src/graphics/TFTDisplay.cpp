@@ -18,6 +18,12 @@ extern SX1509 gpioExtender;
 #define TFT_MESH COLOR565(0x67, 0xEA, 0x94)
 #endif
 
+// Give up the SPI lock after this many rows of a frame, so a radio on the same bus can get in. 0 holds it for the whole frame
+// With RADIO_YIELD a radio handled by the main loop also gets to read out a received packet there
+#ifndef TFT_LOCK_CHUNK_ROWS
+#define TFT_LOCK_CHUNK_ROWS 0
+#endif
+
 #if defined(ST7735S)
 #include <LovyanGFX.hpp> // Graphics and font library for ST7735 driver chip
 
@@ -961,6 +967,7 @@ static LGFX *tft = nullptr;
 
 #if defined(ST7701_CS) || defined(ST7735_CS) || defined(ST7789_CS) || defined(ILI9341_DRIVER) || defined(ILI9342_DRIVER) ||      \
     defined(RAK14014) || defined(HX8357_CS) || defined(ILI9488_CS) || defined(ST72xx_DE) || (ARCH_PORTDUINO && HAS_SCREEN != 0)
+#include "RadioTask.h"
 #include "SPILock.h"
 #include "TFTDisplay.h"
 #include <SPI.h>
@@ -1005,6 +1012,9 @@ TFTDisplay::TFTDisplay(uint8_t address, int sda, int scl, OLEDDISPLAY_GEOMETRY g
 }
 
 // Write the buffer to the display memory
+// One row of RGB565 pixels, in the byte order pushImage() expects
+static uint16_t *lineBuf = nullptr;
+
 void TFTDisplay::display(bool fromBlank)
 {
     if (fromBlank)
@@ -1012,29 +1022,50 @@ void TFTDisplay::display(bool fromBlank)
     // tft->clear();
     concurrency::LockGuard g(spiLock);
 
-    uint16_t x, y;
-
-    for (y = 0; y < displayHeight; y++) {
-        for (x = 0; x < displayWidth; x++) {
-            auto isset = buffer[x + (y / 8) * displayWidth] & (1 << (y & 7));
-            if (!fromBlank) {
-                // get src pixel in the page based ordering the OLED lib uses FIXME, super inefficent
-                auto dblbuf_isset = buffer_back[x + (y / 8) * displayWidth] & (1 << (y & 7));
-                if (isset != dblbuf_isset) {
-                    tft->drawPixel(x, y, isset ? TFT_MESH : TFT_BLACK);
-                }
-            } else if (isset) {
-                tft->drawPixel(x, y, TFT_MESH);
+    if (!lineBuf)
+        lineBuf = new uint16_t[displayWidth];
+
+    // pushImage() sends the 16 bit words as they are, unless the library has been told to swap them (like we do for RAK14014)
+    const uint16_t on = tft->getSwapBytes() ? TFT_MESH : __builtin_bswap16(TFT_MESH);
+    const uint16_t off = TFT_BLACK;
+
+    // Only send the changed part of each row, in one go rather than a transaction per pixel.  After a fillScreen() everything
+    // that is set has changed.
+    tft->startWrite();
+    for (uint16_t y = 0; y < displayHeight; y++) {
+#if TFT_LOCK_CHUNK_ROWS
+        if (y && y % TFT_LOCK_CHUNK_ROWS == 0) {
+            tft->endWrite();
+            spiLock->unlock(); // A waiting radio takes the bus here
+            yieldToRadio();
+            spiLock->lock();
+            tft->startWrite();
+        }
+#endif
+        const uint8_t *page = buffer + (y / 8) * displayWidth;
+        const uint8_t *backPage = buffer_back + (y / 8) * displayWidth;
+        const uint8_t mask = 1 << (y & 7);
+
+        int16_t first = -1, last = -1;
+        for (uint16_t x = 0; x < displayWidth; x++) {
+            uint8_t changed = fromBlank ? page[x] : page[x] ^ backPage[x];
+            if (changed & mask) {
+                if (first < 0)
+                    first = x;
+                last = x;
             }
         }
+        if (first < 0)
+            continue;
+
+        for (int16_t x = first; x <= last; x++)
+            lineBuf[x - first] = (page[x] & mask) ? on : off;
+        tft->pushImage(first, y, last - first + 1, 1, lineBuf);
     }
+    tft->endWrite();
+
     // Copy the Buffer to the Back Buffer
-    for (y = 0; y < (displayHeight / 8); y++) {
-        for (x = 0; x < displayWidth; x++) {
-            uint16_t pos = x + y * displayWidth;
-            buffer_back[pos] = buffer[pos];
-        }
-    }
+    memcpy(buffer_back, buffer, displayWidth * (displayHeight / 8));
 }
 
 // Send a command to the display (low level function)
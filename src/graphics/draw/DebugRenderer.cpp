@@ -7,6 +7,7 @@
 #include "Throttle.h"
 #include "UIRenderer.h"
 #include "airtime.h"
+#include "concurrency/OSThread.h"
 #include "gps/RTC.h"
 #include "graphics/ScreenFonts.h"
 #include "graphics/SharedUIDisplay.h"
@@ -89,7 +90,7 @@ void drawFrame(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t x, int16
     // Draw the channel name
     display->drawString(x, y + FONT_HEIGHT_SMALL, channelStr);
     // Draw our hardware ID to assist with bluetooth pairing. Either prefix with Info or S&F Logo
-    if (moduleConfig.store_forward.enabled) {
+    if (moduleConfig.store_forward.enabled && storeForwardModule) {
 #ifdef ARCH_ESP32
         if (!Throttle::isWithinTimespanMs(storeForwardModule->lastHeartbeat,
                                           (storeForwardModule->heartbeatInterval * 1200))) { // no heartbeat, overlap a bit
@@ -482,6 +483,42 @@ void drawLoRaFocused(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t x,
                         chUtilPercentage);
 }
 
+#if AIRTIME_TOP_TALKERS
+// ****************************
+// *      Airtime Screen      *
+// ****************************
+void drawAirtimeTalkers(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t x, int16_t y)
+{
+    display->clear();
+    display->setFont(FONT_SMALL);
+    graphics::drawCommonHeader(display, x, y, "Airtime");
+
+    // Busiest ports on the left, busiest nodes on the right, seconds of airtime in about the last hour
+    const int rows = 4;
+    AirtimeTalker ports[rows], nodes[rows];
+    size_t numPorts = airTime->getTopTalkers(AirTime::TALKER_PORT, ports, rows);
+    size_t numNodes = airTime->getTopTalkers(AirTime::TALKER_NODE, nodes, rows);
+    for (int i = 0; i < rows; i++) {
+        int rowY = getTextPositions(display)[i + 1];
+        char text[24];
+        if ((size_t)i < numPorts) {
+            snprintf(text, sizeof(text), "Port %u %us", ports[i].key, ports[i].ms / 1000);
+            display->setTextAlignment(TEXT_ALIGN_LEFT);
+            display->drawString(x, rowY, text);
+        }
+        if ((size_t)i < numNodes) {
+            const meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(nodes[i].key);
+            if (node && node->has_user && node->user.short_name[0])
+                snprintf(text, sizeof(text), "%s %us", node->user.short_name, nodes[i].ms / 1000);
+            else
+                snprintf(text, sizeof(text), "%04x %us", nodes[i].key & 0xffff, nodes[i].ms / 1000);
+            display->setTextAlignment(TEXT_ALIGN_RIGHT);
+            display->drawString(x + SCREEN_WIDTH, rowY, text);
+        }
+    }
+}
+#endif
+
 // ****************************
 // *      Memory Screen       *
 // ****************************
@@ -613,6 +650,21 @@ void drawMemoryUsage(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t x,
         nameX = (SCREEN_WIDTH - textWidth) / 2;
         display->drawString(nameX, getTextPositions(display)[line], uptimeStr);
     }
+
+#if OSTHREAD_PROFILE
+    // The thread using the most CPU, and how much of our uptime that is
+    const concurrency::OSThread *busiest = concurrency::OSThread::getBusiest();
+    if (busiest && SCREEN_HEIGHT > 64 && line < 6) {
+        line += 1;
+        uint32_t uptimeMs = millis();
+        uint32_t permille = uptimeMs ? (uint32_t)(busiest->getProfile().totalMicros / uptimeMs) : 0;
+        char busyStr[40];
+        snprintf(busyStr, sizeof(busyStr), "Busy: %s %u.%u%%", busiest->ThreadName.c_str(), permille / 10, permille % 10);
+        textWidth = display->getStringWidth(busyStr);
+        nameX = (SCREEN_WIDTH - textWidth) / 2;
+        display->drawString(nameX, getTextPositions(display)[line], busyStr);
+    }
+#endif
 }
 } // namespace DebugRenderer
 } // namespace graphics
@@ -31,6 +31,9 @@ void drawDebugInfoWiFiTrampoline(OLEDDisplay *display, OLEDDisplayUiState *state
 // LoRa information display
 void drawLoRaFocused(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t x, int16_t y);
 
+// Airtime by port and node, see AIRTIME_TOP_TALKERS
+void drawAirtimeTalkers(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t x, int16_t y);
+
 // Memory screen display
 void drawMemoryUsage(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t x, int16_t y);
 } // namespace DebugRenderer
@@ -52,25 +52,7 @@ static int scrollIndex = 0;
 const char *getSafeNodeName(meshtastic_NodeInfoLite *node)
 {
     static char nodeName[16] = "?";
-    if (node->has_user && strlen(node->user.short_name) > 0) {
-        bool valid = true;
-        const char *name = node->user.short_name;
-        for (size_t i = 0; i < strlen(name); i++) {
-            uint8_t c = (uint8_t)name[i];
-            if (c < 32 || c > 126) {
-                valid = false;
-                break;
-            }
-        }
-        if (valid) {
-            strncpy(nodeName, name, sizeof(nodeName) - 1);
-            nodeName[sizeof(nodeName) - 1] = '\0';
-        } else {
-            snprintf(nodeName, sizeof(nodeName), "%04X", (uint16_t)(node->num & 0xFFFF));
-        }
-    } else {
-        strcpy(nodeName, "?");
-    }
+    NodeListModel::formatName(node, nodeName, sizeof(nodeName));
     return nodeName;
 }
 
@@ -132,32 +114,18 @@ void drawScrollbar(OLEDDisplay *display, int visibleNodeRows, int totalEntries,
 // Entry Renderers
 // =============================
 
-void drawEntryLastHeard(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16_t x, int16_t y, int columnWidth)
+void drawEntryLastHeard(OLEDDisplay *display, const NodeListEntry &entry, int16_t x, int16_t y, int columnWidth)
 {
     bool isLeftCol = (x < SCREEN_WIDTH / 2);
     int timeOffset = (isHighResolution) ? (isLeftCol ? 7 : 10) : (isLeftCol ? 3 : 7);
 
-    const char *nodeName = getSafeNodeName(node);
-
-    char timeStr[10];
-    uint32_t seconds = sinceLastSeen(node);
-    if (seconds == 0 || seconds == UINT32_MAX) {
-        snprintf(timeStr, sizeof(timeStr), "?");
-    } else {
-        uint32_t minutes = seconds / 60, hours = minutes / 60, days = hours / 24;
-        snprintf(timeStr, sizeof(timeStr), (days > 365 ? "?" : "%d%c"),
-                 (days    ? days
-                  : hours ? hours
-                          : minutes),
-                 (days    ? 'd'
-                  : hours ? 'h'
-                          : 'm'));
-    }
+    const char *nodeName = entry.name;
+    const char *timeStr = entry.age;
 
     display->setTextAlignment(TEXT_ALIGN_LEFT);
     display->setFont(FONT_SMALL);
     display->drawString(x + ((isHighResolution) ? 6 : 3), y, nodeName);
-    if (node->is_favorite) {
+    if (entry.isFavorite) {
         if (isHighResolution) {
             drawScaledXBitmap16x16(x, y + 6, smallbulletpoint_width, smallbulletpoint_height, smallbulletpoint, display);
         } else {
@@ -172,7 +140,7 @@ void drawEntryLastHeard(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int
     display->drawString(rightEdge - textWidth, y, timeStr);
 }
 
-void drawEntryHopSignal(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16_t x, int16_t y, int columnWidth)
+void drawEntryHopSignal(OLEDDisplay *display, const NodeListEntry &entry, int16_t x, int16_t y, int columnWidth)
 {
     bool isLeftCol = (x < SCREEN_WIDTH / 2);
 
@@ -182,13 +150,13 @@ void drawEntryHopSignal(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int
 
     int barsXOffset = columnWidth - barsOffset;
 
-    const char *nodeName = getSafeNodeName(node);
+    const char *nodeName = entry.name;
 
     display->setTextAlignment(TEXT_ALIGN_LEFT);
     display->setFont(FONT_SMALL);
 
     display->drawStringMaxWidth(x + ((isHighResolution) ? 6 : 3), y, nameMaxWidth, nodeName);
-    if (node->is_favorite) {
+    if (entry.isFavorite) {
         if (isHighResolution) {
             drawScaledXBitmap16x16(x, y + 6, smallbulletpoint_width, smallbulletpoint_height, smallbulletpoint, display);
         } else {
@@ -197,7 +165,7 @@ void drawEntryHopSignal(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int
     }
 
     // Draw signal strength bars
-    int bars = (node->snr > 5) ? 4 : (node->snr > 0) ? 3 : (node->snr > -5) ? 2 : (node->snr > -10) ? 1 : 0;
+    int bars = (entry.snr > 5) ? 4 : (entry.snr > 0) ? 3 : (entry.snr > -5) ? 2 : (entry.snr > -10) ? 1 : 0;
     int barWidth = 2;
     int barStartX = x + barsXOffset;
     int barStartY = y + 1 + (FONT_HEIGHT_SMALL / 2) + 2;
@@ -211,8 +179,8 @@ void drawEntryHopSignal(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int
 
     // Draw hop count
     char hopStr[6] = "";
-    if (node->has_hops_away && node->hops_away > 0)
-        snprintf(hopStr, sizeof(hopStr), "[%d]", node->hops_away);
+    if (entry.hasHops && entry.hopsAway > 0)
+        snprintf(hopStr, sizeof(hopStr), "[%d]", entry.hopsAway);
 
     if (hopStr[0] != '\0') {
         int rightEdge = x + columnWidth - hopOffset;
@@ -221,66 +189,18 @@ void drawEntryHopSignal(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int
     }
 }
 
-void drawNodeDistance(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16_t x, int16_t y, int columnWidth)
+void drawNodeDistance(OLEDDisplay *display, const NodeListEntry &entry, int16_t x, int16_t y, int columnWidth)
 {
     bool isLeftCol = (x < SCREEN_WIDTH / 2);
     int nameMaxWidth = columnWidth - (isHighResolution ? (isLeftCol ? 25 : 28) : (isLeftCol ? 20 : 22));
 
-    const char *nodeName = getSafeNodeName(node);
-    char distStr[10] = "";
-
-    meshtastic_NodeInfoLite *ourNode = nodeDB->getMeshNode(nodeDB->getNodeNum());
-    if (nodeDB->hasValidPosition(ourNode) && nodeDB->hasValidPosition(node)) {
-        double lat1 = ourNode->position.latitude_i * 1e-7;
-        double lon1 = ourNode->position.longitude_i * 1e-7;
-        double lat2 = node->position.latitude_i * 1e-7;
-        double lon2 = node->position.longitude_i * 1e-7;
-
-        double earthRadiusKm = 6371.0;
-        double dLat = (lat2 - lat1) * DEG_TO_RAD;
-        double dLon = (lon2 - lon1) * DEG_TO_RAD;
-
-        double a =
-            sin(dLat / 2) * sin(dLat / 2) + cos(lat1 * DEG_TO_RAD) * cos(lat2 * DEG_TO_RAD) * sin(dLon / 2) * sin(dLon / 2);
-        double c = 2 * atan2(sqrt(a), sqrt(1 - a));
-        double distanceKm = earthRadiusKm * c;
-
-        if (config.display.units == meshtastic_Config_DisplayConfig_DisplayUnits_IMPERIAL) {
-            double miles = distanceKm * 0.621371;
-            if (miles < 0.1) {
-                int feet = (int)(miles * 5280);
-                if (feet < 1000)
-                    snprintf(distStr, sizeof(distStr), "%dft", feet);
-                else
-                    snprintf(distStr, sizeof(distStr), "¼mi"); // 4-char max
-            } else {
-                int roundedMiles = (int)(miles + 0.5);
-                if (roundedMiles < 1000)
-                    snprintf(distStr, sizeof(distStr), "%dmi", roundedMiles);
-                else
-                    snprintf(distStr, sizeof(distStr), "999"); // Max display cap
-            }
-        } else {
-            if (distanceKm < 1.0) {
-                int meters = (int)(distanceKm * 1000);
-                if (meters < 1000)
-                    snprintf(distStr, sizeof(distStr), "%dm", meters);
-                else
-                    snprintf(distStr, sizeof(distStr), "1k");
-            } else {
-                int km = (int)(distanceKm + 0.5);
-                if (km < 1000)
-                    snprintf(distStr, sizeof(distStr), "%dk", km);
-                else
-                    snprintf(distStr, sizeof(distStr), "999");
-            }
-        }
-    }
+    const char *nodeName = entry.name;
+    const char *distStr = entry.distance;
 
     display->setTextAlignment(TEXT_ALIGN_LEFT);
     display->setFont(FONT_SMALL);
     display->drawStringMaxWidth(x + ((isHighResolution) ? 6 : 3), y, nameMaxWidth, nodeName);
-    if (node->is_favorite) {
+    if (entry.isFavorite) {
         if (isHighResolution) {
             drawScaledXBitmap16x16(x, y + 6, smallbulletpoint_width, smallbulletpoint_height, smallbulletpoint, display);
         } else {
@@ -288,7 +208,7 @@ void drawNodeDistance(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16
         }
     }
 
-    if (strlen(distStr) > 0) {
+    if (distStr[0] != '\0') {
         int offset = (isHighResolution) ? (isLeftCol ? 7 : 10) // Offset for Wide Screens (Left Column:Right Column)
                                         : (isLeftCol ? 4 : 7); // Offset for Narrow Screens (Left Column:Right Column)
         int rightEdge = x + columnWidth - offset;
@@ -297,36 +217,36 @@ void drawNodeDistance(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16
     }
 }
 
-void drawEntryDynamic(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16_t x, int16_t y, int columnWidth)
+void drawEntryDynamic(OLEDDisplay *display, const NodeListEntry &entry, int16_t x, int16_t y, int columnWidth)
 {
     switch (currentMode) {
     case MODE_LAST_HEARD:
-        drawEntryLastHeard(display, node, x, y, columnWidth);
+        drawEntryLastHeard(display, entry, x, y, columnWidth);
         break;
     case MODE_HOP_SIGNAL:
-        drawEntryHopSignal(display, node, x, y, columnWidth);
+        drawEntryHopSignal(display, entry, x, y, columnWidth);
         break;
     case MODE_DISTANCE:
-        drawNodeDistance(display, node, x, y, columnWidth);
+        drawNodeDistance(display, entry, x, y, columnWidth);
         break;
     default:
         break;
     }
 }
 
-void drawEntryCompass(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16_t x, int16_t y, int columnWidth)
+void drawEntryCompass(OLEDDisplay *display, const NodeListEntry &entry, int16_t x, int16_t y, int columnWidth)
 {
     bool isLeftCol = (x < SCREEN_WIDTH / 2);
 
     // Adjust max text width depending on column and screen width
     int nameMaxWidth = columnWidth - (isHighResolution ? (isLeftCol ? 25 : 28) : (isLeftCol ? 20 : 22));
 
-    const char *nodeName = getSafeNodeName(node);
+    const char *nodeName = entry.name;
 
     display->setTextAlignment(TEXT_ALIGN_LEFT);
     display->setFont(FONT_SMALL);
     display->drawStringMaxWidth(x + ((isHighResolution) ? 6 : 3), y, nameMaxWidth, nodeName);
-    if (node->is_favorite) {
+    if (entry.isFavorite) {
         if (isHighResolution) {
             drawScaledXBitmap16x16(x, y + 6, smallbulletpoint_width, smallbulletpoint_height, smallbulletpoint, display);
         } else {
@@ -335,10 +255,9 @@ void drawEntryCompass(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16
     }
 }
 
-void drawCompassArrow(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16_t x, int16_t y, int columnWidth, float myHeading,
-                      double userLat, double userLon)
+void drawCompassArrow(OLEDDisplay *display, const NodeListEntry &entry, int16_t x, int16_t y, int columnWidth, float myHeading)
 {
-    if (!nodeDB->hasValidPosition(node))
+    if (entry.distanceMeters == NodeListEntry::DISTANCE_UNKNOWN)
         return;
 
     bool isLeftCol = (x < SCREEN_WIDTH / 2);
@@ -347,10 +266,7 @@ void drawCompassArrow(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16
     int centerX = x + columnWidth - arrowXOffset;
     int centerY = y + FONT_HEIGHT_SMALL / 2;
 
-    double nodeLat = node->position.latitude_i * 1e-7;
-    double nodeLon = node->position.longitude_i * 1e-7;
-    float bearing = GeoCoord::bearing(userLat, userLon, nodeLat, nodeLon);
-    float bearingToNode = RAD_TO_DEG * bearing;
+    float bearingToNode = entry.bearing;
     float relativeBearing = fmod((bearingToNode - myHeading + 360), 360);
     float angle = relativeBearing * DEG_TO_RAD;
     // Shrink size by 2px
@@ -389,7 +305,7 @@ void drawCompassArrow(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16
 // =============================
 
 void drawNodeListScreen(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t x, int16_t y, const char *title,
-                        EntryRenderer renderer, NodeExtrasRenderer extras, float heading, double lat, double lon)
+                        EntryRenderer renderer, NodeExtrasRenderer extras, float heading)
 {
     const int COMMON_HEADER_HEIGHT = FONT_HEIGHT_SMALL - 1;
     const int rowYOffset = FONT_HEIGHT_SMALL - 3;
@@ -404,16 +320,14 @@ void drawNodeListScreen(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t
     // Space below header
     y += COMMON_HEADER_HEIGHT;
 
-    int totalEntries = nodeDB->getNumMeshNodes();
+    nodeListModel.refresh();
+    int totalEntries = nodeListModel.size();
     int totalRowsAvailable = (display->getHeight() - y) / rowYOffset;
 
     int visibleNodeRows = totalRowsAvailable;
     int totalColumns = 2;
 
     int startIndex = scrollIndex * visibleNodeRows * totalColumns;
-    if (nodeDB->getMeshNodeByIndex(startIndex)->num == nodeDB->getNodeNum()) {
-        startIndex++; // skip own node
-    }
     int endIndex = std::min(startIndex + visibleNodeRows * totalColumns, totalEntries);
 
     int yOffset = 0;
@@ -425,10 +339,10 @@ void drawNodeListScreen(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t
     for (int i = startIndex; i < endIndex; ++i) {
         int xPos = x + (col * columnWidth);
         int yPos = y + yOffset;
-        renderer(display, nodeDB->getMeshNodeByIndex(i), xPos, yPos, columnWidth);
+        renderer(display, nodeListModel[i], xPos, yPos, columnWidth);
 
         if (extras) {
-            extras(display, nodeDB->getMeshNodeByIndex(i), xPos, yPos, columnWidth, heading, lat, lon);
+            extras(display, nodeListModel[i], xPos, yPos, columnWidth, heading);
         }
 
         lastNodeY = std::max(lastNodeY, yPos + FONT_HEIGHT_SMALL);
@@ -536,7 +450,7 @@ void drawNodeListWithCompasses(OLEDDisplay *display, OLEDDisplayUiState *state,
         if (!validHeading)
             return;
     }
-    drawNodeListScreen(display, state, x, y, "Bearings", drawEntryCompass, drawCompassArrow, heading, lat, lon);
+    drawNodeListScreen(display, state, x, y, "Bearings", drawEntryCompass, drawCompassArrow, heading);
 }
 
 /// Draw a series of fields in a column, wrapping to multiple columns if needed
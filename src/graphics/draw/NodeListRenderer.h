@@ -1,5 +1,6 @@
 #pragma once
 
+#include "graphics/NodeListModel.h"
 #include "graphics/Screen.h"
 #include "mesh/generated/meshtastic/mesh.pb.h"
 #include <OLEDDisplay.h>
@@ -20,27 +21,25 @@ class Screen;
 namespace NodeListRenderer
 {
 // Entry renderer function types
-typedef void (*EntryRenderer)(OLEDDisplay *, meshtastic_NodeInfoLite *, int16_t, int16_t, int);
-typedef void (*NodeExtrasRenderer)(OLEDDisplay *, meshtastic_NodeInfoLite *, int16_t, int16_t, int, float, double, double);
+typedef void (*EntryRenderer)(OLEDDisplay *, const NodeListEntry &, int16_t, int16_t, int);
+typedef void (*NodeExtrasRenderer)(OLEDDisplay *, const NodeListEntry &, int16_t, int16_t, int, float);
 
 // Node list mode enumeration
 enum NodeListMode { MODE_LAST_HEARD = 0, MODE_HOP_SIGNAL = 1, MODE_DISTANCE = 2, MODE_COUNT = 3 };
 
 // Main node list screen function
 void drawNodeListScreen(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t x, int16_t y, const char *title,
-                        EntryRenderer renderer, NodeExtrasRenderer extras = nullptr, float heading = 0, double lat = 0,
-                        double lon = 0);
+                        EntryRenderer renderer, NodeExtrasRenderer extras = nullptr, float heading = 0);
 
 // Entry renderers
-void drawEntryLastHeard(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16_t x, int16_t y, int columnWidth);
-void drawEntryHopSignal(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16_t x, int16_t y, int columnWidth);
-void drawNodeDistance(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16_t x, int16_t y, int columnWidth);
-void drawEntryDynamic(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16_t x, int16_t y, int columnWidth);
-void drawEntryCompass(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16_t x, int16_t y, int columnWidth);
+void drawEntryLastHeard(OLEDDisplay *display, const NodeListEntry &entry, int16_t x, int16_t y, int columnWidth);
+void drawEntryHopSignal(OLEDDisplay *display, const NodeListEntry &entry, int16_t x, int16_t y, int columnWidth);
+void drawNodeDistance(OLEDDisplay *display, const NodeListEntry &entry, int16_t x, int16_t y, int columnWidth);
+void drawEntryDynamic(OLEDDisplay *display, const NodeListEntry &entry, int16_t x, int16_t y, int columnWidth);
+void drawEntryCompass(OLEDDisplay *display, const NodeListEntry &entry, int16_t x, int16_t y, int columnWidth);
 
 // Extras renderers
-void drawCompassArrow(OLEDDisplay *display, meshtastic_NodeInfoLite *node, int16_t x, int16_t y, int columnWidth, float myHeading,
-                      double userLat, double userLon);
+void drawCompassArrow(OLEDDisplay *display, const NodeListEntry &entry, int16_t x, int16_t y, int columnWidth, float myHeading);
 
 // Screen frame functions
 void drawLastHeardScreen(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t x, int16_t y);
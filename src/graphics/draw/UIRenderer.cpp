@@ -442,7 +442,8 @@ void UIRenderer::drawNodeInfo(OLEDDisplay *display, const OLEDDisplayUiState *st
             float d =
                 GeoCoord::latLongToMeter(DegD(p.latitude_i), DegD(p.longitude_i), DegD(op.latitude_i), DegD(op.longitude_i));
             */
-            float bearing = GeoCoord::bearing(DegD(op.latitude_i), DegD(op.longitude_i), DegD(p.latitude_i), DegD(p.longitude_i));
+            float bearing;
+            GeoCoord::distanceAndBearing(op.latitude_i, op.longitude_i, p.latitude_i, p.longitude_i, NULL, &bearing);
             if (screen->ignoreCompass) {
                 myHeading = 0;
             } else {
@@ -499,7 +500,8 @@ void UIRenderer::drawNodeInfo(OLEDDisplay *display, const OLEDDisplayUiState *st
             float d =
                 GeoCoord::latLongToMeter(DegD(p.latitude_i), DegD(p.longitude_i), DegD(op.latitude_i), DegD(op.longitude_i));
             */
-            float bearing = GeoCoord::bearing(DegD(op.latitude_i), DegD(op.longitude_i), DegD(p.latitude_i), DegD(p.longitude_i));
+            float bearing;
+            GeoCoord::distanceAndBearing(op.latitude_i, op.longitude_i, p.latitude_i, p.longitude_i, NULL, &bearing);
             if (!screen->ignoreCompass)
                 bearing -= myHeading;
             graphics::CompassRenderer::drawNodeHeading(display, compassX, compassY, compassRadius * 2, bearing);
@@ -4,6 +4,7 @@
 
 #include <assert.h>
 
+#include "RadioTask.h"
 #include "SPILock.h"
 
 using namespace NicheGraphics::Drivers;
@@ -134,8 +135,10 @@ void LCMEN213EFC1::update(uint8_t *imageData, UpdateTypes type)
 void LCMEN213EFC1::wait()
 {
     // Busy when LOW
-    while (digitalRead(pin_busy) == LOW)
+    while (digitalRead(pin_busy) == LOW) {
+        yieldToRadio();
         yield();
+    }
 }
 
 void LCMEN213EFC1::reset()
@@ -2,6 +2,7 @@
 
 #include "./SSD16XX.h"
 
+#include "RadioTask.h"
 #include "SPILock.h"
 
 using namespace NicheGraphics::Drivers;
@@ -58,6 +59,7 @@ void SSD16XX::wait(uint32_t timeout)
             failed = true;
             break;
         }
+        yieldToRadio();
         yield();
     }
 }
@@ -173,11 +175,53 @@ void SSD16XX::configFullscreen()
     sendData(sy2);
 }
 
+// Narrow the controller IC's memory region to a band of rows, then place the cursor at the start of the band
+// Only needed for updateWindow: for the whole image, configFullscreen has already set this up
+void SSD16XX::configWindow()
+{
+    if (windowFirstRow == 0 && windowLastRow == height - 1)
+        return;
+
+    sendCommand(0x45); // Memory Y start - end
+    sendData(windowFirstRow & 0xFF);
+    sendData((windowFirstRow >> 8) & 0xFF);
+    sendData(windowLastRow & 0xFF);
+    sendData((windowLastRow >> 8) & 0xFF);
+
+    sendCommand(0x4E); // Memory cursor X
+    sendData(bufferOffsetX);
+    sendCommand(0x4F); // Memory cursor y
+    sendData(windowFirstRow & 0xFF);
+    sendData((windowFirstRow >> 8) & 0xFF);
+}
+
+// Change only rows firstRow to lastRow (inclusive) of the display image
+// Controller IC already holds the rest of the image, in both "new" and "old" memory (see finalizeUpdate),
+// so a differential refresh will leave those pixels alone. Only the changed rows need to be sent over SPI.
+void SSD16XX::updateWindow(uint8_t *imageData, UpdateTypes type, uint16_t firstRow, uint16_t lastRow)
+{
+    // A FULL refresh redraws every pixel, so needs the whole image
+    if (type == FAST && firstRow <= lastRow && lastRow < height) {
+        windowFirstRow = firstRow;
+        windowLastRow = lastRow;
+        windowPending = true;
+    }
+
+    update(imageData, type);
+}
+
 void SSD16XX::update(uint8_t *imageData, UpdateTypes type)
 {
     this->updateType = type;
     this->buffer = imageData;
 
+    // Whole image, unless called via updateWindow
+    if (!windowPending) {
+        windowFirstRow = 0;
+        windowLastRow = height - 1;
+    }
+    windowPending = false;
+
     reset();
 
     configFullscreen();
@@ -214,14 +258,16 @@ void SSD16XX::configUpdateSequence()
 
 void SSD16XX::writeNewImage()
 {
+    configWindow();
     sendCommand(0x24);
-    sendData(buffer, bufferSize);
+    sendData(buffer + (windowFirstRow * bufferRowSize), (windowLastRow - windowFirstRow + 1) * bufferRowSize);
 }
 
 void SSD16XX::writeOldImage()
 {
+    configWindow();
     sendCommand(0x26);
-    sendData(buffer, bufferSize);
+    sendData(buffer + (windowFirstRow * bufferRowSize), (windowLastRow - windowFirstRow + 1) * bufferRowSize);
 }
 
 void SSD16XX::detachFromUpdate()
@@ -25,6 +25,8 @@ class SSD16XX : public EInk
     SSD16XX(uint16_t width, uint16_t height, UpdateTypes supported, uint8_t bufferOffsetX = 0);
     virtual void begin(SPIClass *spi, uint8_t pin_dc, uint8_t pin_cs, uint8_t pin_busy, uint8_t pin_rst = -1);
     virtual void update(uint8_t *imageData, UpdateTypes type) override;
+    virtual void updateWindow(uint8_t *imageData, UpdateTypes type, uint16_t firstRow, uint16_t lastRow) override;
+    virtual bool supportsWindow() override { return true; }
 
   protected:
     virtual void wait(uint32_t timeout = 1000);
@@ -33,6 +35,7 @@ class SSD16XX : public EInk
     virtual void sendData(const uint8_t data);
     virtual void sendData(const uint8_t *data, uint32_t size);
     virtual void configFullscreen();     // Select memory region on controller IC
+    virtual void configWindow();         // Narrow memory region to the rows of an updateWindow call
     virtual void configScanning() {}     // Optional. First & last gates, scan direction, etc
     virtual void configVoltages() {}     // Optional. Manual panel voltages, soft-start, etc
     virtual void configWaveform() {}     // Optional. LUT, panel border, temperature sensor, etc
@@ -52,6 +55,9 @@ class SSD16XX : public EInk
     uint32_t bufferSize = 0;   // In bytes. Rows * Columns
     uint8_t *buffer = nullptr;
     UpdateTypes updateType = UpdateTypes::UNSPECIFIED;
+    uint16_t windowFirstRow = 0; // Rows of the image written to the controller IC. Whole image, unless updateWindow
+    uint16_t windowLastRow = 0;
+    bool windowPending = false; // Set by updateWindow, for the update call which follows
 
     uint8_t pin_dc = -1;
     uint8_t pin_cs = -1;
@@ -11,6 +11,7 @@ using namespace NicheGraphics;
 InkHUD::AppletFont InkHUD::Applet::fontLarge;      // General purpose font. Set by setDefaultFonts
 InkHUD::AppletFont InkHUD::Applet::fontSmall;      // General purpose font. Set by setDefaultFonts
 constexpr float InkHUD::Applet::LOGO_ASPECT_RATIO; // Ratio of the Meshtastic logo
+InkHUD::TextRunCache InkHUD::Applet::textRunCache; // Recently drawn text, shared by all applets
 
 InkHUD::Applet::Applet() : GFX(0, 0)
 {
@@ -263,10 +264,15 @@ uint16_t InkHUD::Applet::Y(float f)
 // Print text, specifying the position of any edge / corner of the textbox
 void InkHUD::Applet::printAt(int16_t x, int16_t y, const char *text, HorizontalAlignment ha, VerticalAlignment va)
 {
-    // We do still have to run getTextBounds to find the width
+    // We need the width: from the text cache if we've drawn this text recently, otherwise from getTextBounds
     int16_t textOffsetX, textOffsetY;
     uint16_t textWidth, textHeight;
-    getTextBounds(text, 0, 0, &textOffsetX, &textOffsetY, &textWidth, &textHeight);
+    const TextRunCache::Run *run = textRunCache.get(currentFont.gfxFont, text);
+    if (run) {
+        textOffsetX = run->offsetX;
+        textWidth = run->width;
+    } else
+        getTextBounds(text, 0, 0, &textOffsetX, &textOffsetY, &textWidth, &textHeight);
 
     int16_t cursorX = 0;
     int16_t cursorY = 0;
@@ -297,8 +303,34 @@ void InkHUD::Applet::printAt(int16_t x, int16_t y, const char *text, HorizontalA
         break;
     }
 
-    setCursor(cursorX, cursorY);
-    print(text);
+    // Blit the cached pixels, or have AdafruitGFX draw glyph by glyph
+    if (run) {
+        drawTextRun(cursorX, cursorY, run);
+        setCursor(cursorX + run->advance, cursorY); // Leave the cursor where print would have
+    } else {
+        setCursor(cursorX, cursorY);
+        print(text);
+    }
+}
+
+// Draw a string's cached pixels, with the cursor (left end of the baseline) at x,y
+void InkHUD::Applet::drawTextRun(int16_t x, int16_t y, const TextRunCache::Run *run)
+{
+    const uint16_t stride = (run->width + 7) / 8;
+    const int16_t left = x + run->offsetX;
+    const int16_t top = y + run->offsetY;
+
+    for (uint16_t row = 0; row < run->height; row++) {
+        const uint8_t *bits = &run->bits[row * stride];
+        for (uint16_t byte = 0; byte < stride; byte++) {
+            if (!bits[byte])
+                continue; // Skip 8 blank pixels at once
+            for (uint8_t b = 0; b < 8; b++) {
+                if (bits[byte] & (0x80 >> b))
+                    drawPixel(left + (byte * 8) + b, top + row, textcolor);
+            }
+        }
+    }
 }
 
 // Print text, specifying the position of any edge / corner of the textbox
@@ -367,7 +399,12 @@ bool InkHUD::Applet::isPrintable(std::string text)
 // Wrapper for getTextBounds
 uint16_t InkHUD::Applet::getTextWidth(const char *text)
 {
-    // We do still have to run getTextBounds to find the width
+    // Text we've drawn (or measured) recently
+    const TextRunCache::Run *run = textRunCache.get(currentFont.gfxFont, text);
+    if (run)
+        return run->width;
+
+    // Otherwise we do still have to run getTextBounds to find the width
     int16_t textOffsetX, textOffsetY;
     uint16_t textWidth, textHeight;
     getTextBounds(text, 0, 0, &textOffsetX, &textOffsetY, &textWidth, &textHeight);
@@ -21,6 +21,7 @@
 #include "./Applets/System/Notification/Notification.h" // The notification object, not the applet
 #include "./InkHUD.h"
 #include "./Persistence.h"
+#include "./TextRunCache.h"
 #include "./Tile.h"
 #include "graphics/niche/Drivers/EInk/EInk.h"
 
@@ -164,6 +165,9 @@ class Applet : public GFX
 
     AppletFont currentFont; // As passed to setFont
 
+    static TextRunCache textRunCache;                                     // Recently drawn text, shared by all applets
+    void drawTextRun(int16_t x, int16_t y, const TextRunCache::Run *run); // Blit cached text, as print would at cursor x,y
+
     // As set by setCrop
     int16_t cropLeft = 0;
     int16_t cropTop = 0;
@@ -17,6 +17,7 @@ void InkHUD::MapApplet::onRender()
     // - latitude and longitude
     // - will be placed at X(0.5), Y(0.5)
     getMapCenter(&latCenter, &lngCenter);
+    cosLatCenter = cos(latCenter * DEG_TO_RAD);
 
     // Calculate North+East distance of each node to map center
     // - which nodes to use controlled by virtual shouldDrawNode method
@@ -78,34 +79,20 @@ void InkHUD::MapApplet::getMapCenter(float *lat, float *lng)
     float yAvg = 0;
     float zAvg = 0;
 
-    // For each node in db
-    for (uint32_t i = 0; i < nodeDB->getNumMeshNodes(); i++) {
-        meshtastic_NodeInfoLite *node = nodeDB->getMeshNodeByIndex(i);
-
-        // Skip if no position
-        if (!nodeDB->hasValidPosition(node))
-            continue;
-
+    // For each node with a position
+    // - NodeDB has already converted it to cartesian points, with center of earth at 0, 0, 0
+    // - exact distance from center is irrelevant, as we're only interested in the vector
+    nodeDB->forEachNodePosition([&](meshtastic_NodeInfoLite *node, const NodePositionIndex::Entry &position) {
         // Skip if derived applet doesn't want to show this node on the map
         if (!shouldDrawNode(node))
-            continue;
-
-        // Latitude and Longitude of node, in radians
-        float latRad = node->position.latitude_i * (1e-7) * DEG_TO_RAD;
-        float lngRad = node->position.longitude_i * (1e-7) * DEG_TO_RAD;
-
-        // Convert to cartesian points, with center of earth at 0, 0, 0
-        // Exact distance from center is irrelevant, as we're only interested in the vector
-        float x = cos(latRad) * cos(lngRad);
-        float y = cos(latRad) * sin(lngRad);
-        float z = sin(latRad);
+            return;
 
         // To find mean values shortly
-        xAvg += x;
-        yAvg += y;
-        zAvg += z;
+        xAvg += position.x;
+        yAvg += position.y;
+        zAvg += position.z;
         positionCount++;
-    }
+    });
 
     // All NodeDB processed, find mean values
     xAvg /= positionCount;
@@ -172,31 +159,25 @@ void InkHUD::MapApplet::getMapCenter(float *lat, float *lng)
     float easternmost = lngCenter;
     float westernmost = lngCenter;
 
-    for (uint8_t i = 0; i < nodeDB->getNumMeshNodes(); i++) {
-        meshtastic_NodeInfoLite *node = nodeDB->getMeshNodeByIndex(i);
-
-        // Skip if no position
-        if (!nodeDB->hasValidPosition(node))
-            continue;
-
+    nodeDB->forEachNodePosition([&](meshtastic_NodeInfoLite *node, const NodePositionIndex::Entry &position) {
         // Skip if derived applet doesn't want to show this node on the map
         if (!shouldDrawNode(node))
-            continue;
+            return;
 
         // Check for a new top or bottom latitude
-        float lat = node->position.latitude_i * 1e-7;
+        float lat = position.lat;
         northernmost = max(northernmost, lat);
         southernmost = min(southernmost, lat);
 
         // Longitude is trickier
-        float lng = node->position.longitude_i * 1e-7;
+        float lng = position.lng;
         float degEastward = fmod(((lng - lngCenter) + 360), 360);      // Degrees traveled east from lngCenter to reach node
         float degWestward = abs(fmod(((lng - lngCenter) - 360), 360)); // Degrees traveled west from lngCenter to reach node
         if (degEastward < degWestward)
             easternmost = max(easternmost, lngCenter + degEastward);
         else
             westernmost = min(westernmost, lngCenter - degWestward);
-    }
+    });
 
     // Todo: check for issues with map spans >180 deg. MQTT only..
     latCenter = (northernmost + southernmost) / 2;
@@ -233,14 +214,13 @@ InkHUD::MapApplet::Marker InkHUD::MapApplet::calculateMarker(float lat, float ln
 {
     assert(lat != 0 || lng != 0); // Not null island. Applets should check this before calling.
 
-    // Bearing and distance from map center to node
-    float distanceFromCenter = GeoCoord::latLongToMeter(latCenter, lngCenter, lat, lng);
-    float bearingFromCenter = GeoCoord::bearing(latCenter, lngCenter, lat, lng); // in radians
-
-    // Split into meters north and meters east components (signed)
-    // - signedness of cos / sin automatically sets negative if south or west
-    float northMeters = cos(bearingFromCenter) * distanceFromCenter;
-    float eastMeters = sin(bearingFromCenter) * distanceFromCenter;
+    // Meters north and meters east of map center (signed, negative if south or west)
+    // - projected flat around the map center: a degree east is shorter than a degree north, by cos(latCenter)
+    // - no trig per node, so rendering many markers stays cheap
+    constexpr float METERS_PER_DEG = 6366000 * DEG_TO_RAD; // Earth radius used by GeoCoord::latLongToMeter
+    float degEast = fmod(lng - lngCenter + 540, 360) - 180;  // Shortest way round, across the antimeridian if need be
+    float northMeters = (lat - latCenter) * METERS_PER_DEG;
+    float eastMeters = degEast * cosLatCenter * METERS_PER_DEG;
 
     // Store this as a new marker
     Marker m;
@@ -349,19 +329,15 @@ void InkHUD::MapApplet::drawLabeledMarker(meshtastic_NodeInfoLite *node)
 bool InkHUD::MapApplet::enoughMarkers()
 {
     uint8_t count = 0;
-    for (uint8_t i = 0; i < nodeDB->getNumMeshNodes(); i++) {
-        meshtastic_NodeInfoLite *node = nodeDB->getMeshNodeByIndex(i);
-
+    nodeDB->forEachNodePosition([&](meshtastic_NodeInfoLite *node, const NodePositionIndex::Entry &position) {
         // Count nodes
-        if (nodeDB->hasValidPosition(node) && shouldDrawNode(node))
+        if (count < 2 && shouldDrawNode(node))
             count++;
+    });
 
-        // We need to find two
-        if (count == 2)
-            return true; // Two nodes is enough for a sensible map
-    }
-
-    return false; // No nodes would be drawn (or just the one, uselessly at 0,0)
+    // Two nodes is enough for a sensible map
+    // Otherwise no nodes would be drawn (or just the one, uselessly at 0,0)
+    return count == 2;
 }
 
 // Calculate how far north and east of map center each node is
@@ -371,31 +347,24 @@ void InkHUD::MapApplet::calculateAllMarkers()
     // Clear old markers
     markers.clear();
 
-    // For each node in db
-    for (uint32_t i = 0; i < nodeDB->getNumMeshNodes(); i++) {
-        meshtastic_NodeInfoLite *node = nodeDB->getMeshNodeByIndex(i);
-
-        // Skip if no position
-        if (!nodeDB->hasValidPosition(node))
-            continue;
-
+    // For each node with a position
+    nodeDB->forEachNodePosition([&](meshtastic_NodeInfoLite *node, const NodePositionIndex::Entry &position) {
         // Skip if derived applet doesn't want to show this node on the map
         if (!shouldDrawNode(node))
-            continue;
+            return;
 
         // Skip if our own node
         // - special handling in render()
         if (node->num == nodeDB->getNodeNum())
-            continue;
+            return;
 
         // Calculate marker and store it
-        markers.push_back(
-            calculateMarker(node->position.latitude_i * 1e-7,  // Lat, converted from Meshtastic's internal int32 style
-                            node->position.longitude_i * 1e-7, // Long, converted from Meshtastic's internal int32 style
-                            node->has_hops_away,               // Is the hopsAway number valid
-                            node->hops_away                    // Hops away
-                            ));
-    }
+        markers.push_back(calculateMarker(position.lat,        // Lat, already converted by NodeDB
+                                          position.lng,        // Long, already converted by NodeDB
+                                          node->has_hops_away, // Is the hopsAway number valid
+                                          node->hops_away      // Hops away
+                                          ));
+    });
 }
 
 // Determine the conversion factor between metres, and pixels on screen
@@ -21,6 +21,8 @@ The base applet doesn't handle any events; this is left to the derived applets.
 #include "MeshModule.h"
 #include "gps/GeoCoord.h"
 
+#include <list>
+
 namespace NicheGraphics::InkHUD
 {
 
@@ -51,9 +53,10 @@ class MapApplet : public Applet
     void calculateMapScale();                           // Conversion factor for meters to pixels
     void drawCross(int16_t x, int16_t y, uint8_t size); // Draw the X used for most markers
 
-    float metersToPx = 0; // Conversion factor for meters to pixels
-    float latCenter = 0;  // Map center: latitude
-    float lngCenter = 0;  // Map center: longitude
+    float metersToPx = 0;   // Conversion factor for meters to pixels
+    float latCenter = 0;    // Map center: latitude
+    float lngCenter = 0;    // Map center: longitude
+    float cosLatCenter = 1; // Map center: how much shorter a degree east is than a degree north
 
     std::list<Marker> markers;
     uint32_t widthMeters = 0;  // Map width: meters
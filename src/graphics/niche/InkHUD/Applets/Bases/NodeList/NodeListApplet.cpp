@@ -2,8 +2,8 @@
 
 #include "RTC.h"
 
-#include "GeoCoord.h"
 #include "NodeDB.h"
+#include "graphics/NodeListModel.h"
 
 #include "./NodeListApplet.h"
 
@@ -50,22 +50,13 @@ ProcessMessage InkHUD::NodeListApplet::handleReceived(const meshtastic_MeshPacke
     c.signal = getSignalStrength(mp.rx_snr, mp.rx_rssi);
 
     // Assemble info: from nodeDB (needed to detect changes)
-    meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(c.nodeNum);
-    meshtastic_NodeInfoLite *ourNode = nodeDB->getMeshNode(nodeDB->getNodeNum());
-    if (node) {
-        if (node->has_hops_away)
-            c.hopsAway = node->hops_away;
-
-        if (nodeDB->hasValidPosition(node) && nodeDB->hasValidPosition(ourNode)) {
-            // Get lat and long as float
-            // Meshtastic stores these as integers internally
-            float ourLat = ourNode->position.latitude_i * 1e-7;
-            float ourLong = ourNode->position.longitude_i * 1e-7;
-            float theirLat = node->position.latitude_i * 1e-7;
-            float theirLong = node->position.longitude_i * 1e-7;
-
-            c.distanceMeters = (int32_t)GeoCoord::latLongToMeter(theirLat, theirLong, ourLat, ourLong);
-        }
+    // Shared node list model caches the distances, so we only work them out when a node moves
+    graphics::nodeListModel.refresh();
+    const graphics::NodeListEntry *entry = graphics::nodeListModel.find(c.nodeNum);
+    if (entry) {
+        if (entry->hasHops)
+            c.hopsAway = entry->hopsAway;
+        c.distanceMeters = entry->distanceMeters;
     }
 
     // Pass to the derived applet
@@ -2,7 +2,7 @@
 
 #include "RTC.h"
 
-#include "gps/GeoCoord.h"
+#include "graphics/NodeListModel.h"
 
 #include "./HeardApplet.h"
 
@@ -79,7 +79,8 @@ void InkHUD::HeardApplet::populateFromNodeDB()
         ordered.resize(maxCards());
 
     // Create card info for these (stale) node observations
-    meshtastic_NodeInfoLite *ourNode = nodeDB->getMeshNode(nodeDB->getNodeNum());
+    // Distances come from the shared node list model
+    graphics::nodeListModel.refresh();
     for (meshtastic_NodeInfoLite *node : ordered) {
         CardInfo c;
         c.nodeNum = node->num;
@@ -87,16 +88,9 @@ void InkHUD::HeardApplet::populateFromNodeDB()
         if (node->has_hops_away)
             c.hopsAway = node->hops_away;
 
-        if (nodeDB->hasValidPosition(node) && nodeDB->hasValidPosition(ourNode)) {
-            // Get lat and long as float
-            // Meshtastic stores these as integers internally
-            float ourLat = ourNode->position.latitude_i * 1e-7;
-            float ourLong = ourNode->position.longitude_i * 1e-7;
-            float theirLat = node->position.latitude_i * 1e-7;
-            float theirLong = node->position.longitude_i * 1e-7;
-
-            c.distanceMeters = (int32_t)GeoCoord::latLongToMeter(theirLat, theirLong, ourLat, ourLong);
-        }
+        const graphics::NodeListEntry *entry = graphics::nodeListModel.find(node->num);
+        if (entry)
+            c.distanceMeters = entry->distanceMeters;
 
         // Insert into the card collection (member of base class)
         cards.push_back(c);
@@ -7,12 +7,6 @@
 
 using namespace NicheGraphics;
 
-// Hard limits on how much message data to write to flash
-// Avoid filling the storage if something goes wrong
-// Normal usage should be well below this size
-constexpr uint8_t MAX_MESSAGES_SAVED = 10;
-constexpr uint32_t MAX_MESSAGE_SIZE = 250;
-
 InkHUD::ThreadedMessageApplet::ThreadedMessageApplet(uint8_t channelIndex)
     : SinglePortModule("ThreadedMessageApplet", meshtastic_PortNum_TEXT_MESSAGE_APP), channelIndex(channelIndex)
 {
@@ -203,11 +197,11 @@ ProcessMessage InkHUD::ThreadedMessageApplet::handleReceived(const meshtastic_Me
     newMessage.timestamp = getValidTime(RTCQuality::RTCQualityDevice, true); // Current RTC time
     newMessage.sender = mp.from;
     newMessage.channelIndex = mp.channel;
-    newMessage.text = std::string((const char *)mp.decoded.payload.bytes, mp.decoded.payload.size);
+    newMessage.setText((const char *)mp.decoded.payload.bytes, mp.decoded.payload.size);
 
     // Store newest message at front
-    // These records are used when rendering, and also stored in flash at shutdown
-    store->messages.push_front(newMessage);
+    // These records are used when rendering, and also appended to the log in flash right away
+    store->add(newMessage);
 
     // If this was an incoming message, suggest that our applet becomes foreground, if permitted
     if (getFrom(&mp) != nodeDB->getNodeNum())
@@ -233,9 +227,8 @@ bool InkHUD::ThreadedMessageApplet::approveNotification(Notification &n)
 }
 
 // Save several recent messages to flash
-// Stores the contents of ThreadedMessageApplet::messages
-// Just enough messages to fill the display
-// Messages are packed "back-to-back", to minimize blocks of flash used
+// New messages were already appended to the log as they arrived
+// This compacts it, down to just enough messages to fill the display
 void InkHUD::ThreadedMessageApplet::saveMessagesToFlash()
 {
     // Create a label (will become the filename in flash)
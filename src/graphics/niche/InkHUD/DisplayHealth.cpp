@@ -45,7 +45,9 @@ void InkHUD::DisplayHealth::forceUpdateType(Drivers::EInk::UpdateTypes type)
 
 // Find out which update type the DisplayHealth has chosen for us
 // Calling this method consumes the result, and resets for the next update
-Drivers::EInk::UpdateTypes InkHUD::DisplayHealth::decideUpdateType()
+// If only part of the display will change (Renderer updating a window), a FAST refresh only adds that portion of the debt:
+// pixels outside the window are not driven, so don't accumulate ghosting
+Drivers::EInk::UpdateTypes InkHUD::DisplayHealth::decideUpdateType(float portion)
 {
     LOG_DEBUG("FULL-update debt:%f", debt);
 
@@ -76,9 +78,9 @@ Drivers::EInk::UpdateTypes InkHUD::DisplayHealth::decideUpdateType()
         LOG_DEBUG("Explicit FAST");
         // Add to the FULL refresh debt
         if (debt < 1.0)
-            debt += 1.0 / fastPerFull;
+            debt += portion / fastPerFull;
         else
-            debt += stressMultiplier * (1.0 / fastPerFull); // More debt if too many consecutive FAST refreshes
+            debt += stressMultiplier * (portion / fastPerFull); // More debt if too many consecutive FAST refreshes
 
         // If *significant debt*, begin occasionally refreshing *unprovoked*
         // This maintenance behavior is only triggered here, by periods of user interaction
@@ -96,7 +98,7 @@ Drivers::EInk::UpdateTypes InkHUD::DisplayHealth::decideUpdateType()
     // Not much debt: suggest FAST
     if (debt < 1.0) {
         LOG_DEBUG("UNSPECIFIED: using FAST");
-        debt += 1.0 / fastPerFull;
+        debt += portion / fastPerFull;
         return UpdateTypes::FAST;
     }
 
@@ -186,8 +186,7 @@ int InkHUD::Events::onReceiveTextMessage(const meshtastic_MeshPacket *packet)
 
     // Store the text
     // Need to specify manually how many bytes, because source not null-terminated
-    storedMessage->text =
-        std::string(&packet->decoded.payload.bytes[0], &packet->decoded.payload.bytes[packet->decoded.payload.size]);
+    storedMessage->setText((const char *)packet->decoded.payload.bytes, packet->decoded.payload.size);
 
     return 0; // Tell caller to continue notifying other observers. (No reason to abort this event)
 }
@@ -6,23 +6,71 @@
 
 using namespace NicheGraphics;
 
-// Hard limits on how much message data to write to flash
-// Avoid filling the storage if something goes wrong
-// Normal usage should be well below this size
-constexpr uint8_t MAX_MESSAGES_SAVED = 10;
-constexpr uint32_t MAX_MESSAGE_SIZE = 250;
+// Compact the log once it holds this many times the messages we keep
+// Bounds the file size, and the time spent reading it at boot
+constexpr uint8_t COMPACT_AFTER = 3;
 
-InkHUD::MessageStore::MessageStore(std::string label)
+// Size of a record in the log, before the text
+// timestamp (4), sender (4), channel index (1), text length (1)
+constexpr uint8_t RECORD_HEADER_SIZE = 10;
+
+InkHUD::MessageStore::MessageStore(std::string label, uint8_t capacity) : messages(capacity)
 {
     filename = "";
     filename += "/NicheGraphics";
     filename += "/";
     filename += label;
-    filename += ".msgs";
+    filename += ".mlog";
+}
+
+void InkHUD::MessageStore::Message::setText(const char *bytes, size_t length)
+{
+    length = min(length, (size_t)MAX_TEXT);
+    memcpy(text, bytes, length);
+    text[length] = '\0';
+}
+
+// Write one message to the log
+// Fixed width header, then the text without a null term
+void InkHUD::MessageStore::writeRecord(Print &f, const Message &m)
+{
+    uint8_t length = strnlen(m.text, MAX_TEXT);
+    f.write((uint8_t *)&m.timestamp, sizeof(m.timestamp));       // Write timestamp. 4 bytes
+    f.write((uint8_t *)&m.sender, sizeof(m.sender));             // Write sender NodeId. 4 Bytes
+    f.write((uint8_t *)&m.channelIndex, sizeof(m.channelIndex)); // Write channel index. 1 Byte
+    f.write(length);                                             // Write text length. 1 Byte
+    f.write((uint8_t *)m.text, length);                          // Write message text. Variable length
+}
+
+// Store a new message at the front of the ring, and append it to the log in flash
+// Only the new message is written, the filesystem lock is held just for that
+void InkHUD::MessageStore::add(const Message &m)
+{
+    messages.push_front(m);
+
+#ifdef FSCom
+    // Plenty of old messages in the log: rewrite it instead
+    if (recordsInFile >= messages.max_size() * COMPACT_AFTER) {
+        saveToFlash();
+        return;
+    }
+
+    concurrency::LockGuard guard(fsLock);
+    FSCom.mkdir("/NicheGraphics");
+    auto f = FSCom.open(filename.c_str(), FILE_O_APPEND);
+    if (!f) {
+        LOG_ERROR("Could not append to %s", filename.c_str());
+        return;
+    }
+    writeRecord(f, m);
+    f.close();
+    recordsInFile++;
+    invalidateFileManifest();
+#endif
 }
 
-// Write the contents of the MessageStore::messages object to flash
-// Takes the firmware's SPI lock during FS operations. Implemented for consistency, but only relevant when using SD card.
+// Write the contents of the MessageStore::messages object to flash, replacing the log
+// Takes the firmware's filesystem lock during FS operations.
 // Need to lock and unlock around specific FS methods, as the SafeFile class takes the lock for itself internally
 void InkHUD::MessageStore::saveToFlash()
 {
@@ -31,123 +79,112 @@ void InkHUD::MessageStore::saveToFlash()
 #ifdef FSCom
     // Make the directory, if doesn't already exist
     // This is the same directory accessed by NicheGraphics::FlashData
-    spiLock->lock();
+    fsLock->lock();
     FSCom.mkdir("/NicheGraphics");
-    spiLock->unlock();
+    fsLock->unlock();
 
-    // Open or create the file
-    // No "full atomic": don't save then rename
-    auto f = SafeFile(filename.c_str(), false);
+    // "Full atomic": write a temporary file, then rename
+    // Messages are in the log as soon as they arrive, so a power loss here must not lose it
+    auto f = SafeFile(filename.c_str(), true);
 
     LOG_INFO("Saving messages in %s", filename.c_str());
 
-    // Take firmware's SPI Lock while writing
-    spiLock->lock();
-
-    // 1st byte: how many messages will be written to store
-    f.write(messages.size());
-
-    // For each message
-    for (uint8_t i = 0; i < messages.size() && i < MAX_MESSAGES_SAVED; i++) {
-        Message &m = messages.at(i);
-        f.write((uint8_t *)&m.timestamp, sizeof(m.timestamp));                    // Write timestamp. 4 bytes
-        f.write((uint8_t *)&m.sender, sizeof(m.sender));                          // Write sender NodeId. 4 Bytes
-        f.write((uint8_t *)&m.channelIndex, sizeof(m.channelIndex));              // Write channel index. 1 Byte
-        f.write((uint8_t *)m.text.c_str(), min(MAX_MESSAGE_SIZE, m.text.size())); // Write message text. Variable length
-        f.write('\0');                                                            // Append null term
-        LOG_DEBUG("Wrote message %u, length %u, text \"%s\"", (uint32_t)i, min(MAX_MESSAGE_SIZE, m.text.size()), m.text.c_str());
+    // Take firmware's filesystem lock while writing
+    fsLock->lock();
+
+    // Oldest first, like the log grows
+    for (uint8_t i = messages.size(); i > 0; i--) {
+        Message &m = messages.at(i - 1);
+        writeRecord(f, m);
+        LOG_DEBUG("Wrote message %u, text \"%s\"", (uint32_t)(i - 1), m.text);
     }
 
-    // Release firmware's SPI lock, because SafeFile::close needs it
-    spiLock->unlock();
+    // Release firmware's filesystem lock, because SafeFile::close needs it
+    fsLock->unlock();
 
     bool writeSucceeded = f.close();
 
     if (!writeSucceeded) {
         LOG_ERROR("Can't write data!");
     }
+    recordsInFile = messages.size();
 #else
     LOG_ERROR("ERROR: Filesystem not implemented\n");
 #endif
 }
 
-// Attempt to load the previous contents of the MessageStore:message deque from flash.
+// Attempt to load the previous contents of the MessageStore:message ring from flash.
 // Filename is controlled by the "label" parameter
-// Takes the firmware's SPI lock during FS operations. Implemented for consistency, but only relevant when using SD card.
+// Takes the firmware's filesystem lock during FS operations.
 void InkHUD::MessageStore::loadFromFlash()
 {
     // Hopefully redundant. Initial intention is to only load / save once per boot.
     messages.clear();
+    recordsInFile = 0;
 
 #ifdef FSCom
+    bool damaged = false;
+    {
+        // Take the firmware's filesystem lock
+        concurrency::LockGuard guard(fsLock);
+
+        // Older firmware rewrote the whole store to a .msgs file, the log replaces it
+        std::string oldFilename = filename.substr(0, filename.size() - strlen(".mlog")) + ".msgs";
+        if (FSCom.exists(oldFilename.c_str()))
+            FSCom.remove(oldFilename.c_str());
+
+        // Check that the file *does* actually exist
+        if (!FSCom.exists(filename.c_str())) {
+            LOG_INFO("'%s' not found.", filename.c_str());
+            return;
+        }
 
-    // Take the firmware's SPI Lock, in case filesystem is on SD card
-    concurrency::LockGuard guard(spiLock);
-
-    // Check that the file *does* actually exist
-    if (!FSCom.exists(filename.c_str())) {
-        LOG_WARN("'%s' not found. Using default values", filename.c_str());
-        return;
-    }
-
-    // Check that the file *does* actually exist
-    if (!FSCom.exists(filename.c_str())) {
-        LOG_INFO("'%s' not found.", filename.c_str());
-        return;
-    }
-
-    // Open the file
-    auto f = FSCom.open(filename.c_str(), FILE_O_READ);
-
-    if (f.size() == 0) {
-        LOG_INFO("%s is empty", filename.c_str());
-        f.close();
-        return;
-    }
+        // Open the file
+        auto f = FSCom.open(filename.c_str(), FILE_O_READ);
+        if (!f) {
+            LOG_ERROR("Could not open / read %s", filename.c_str());
+            return;
+        }
 
-    // If opened, start reading
-    if (f) {
         LOG_INFO("Loading threaded messages '%s'", filename.c_str());
 
-        // First byte: how many messages are in the flash store
-        uint8_t flashMessageCount = 0;
-        f.readBytes((char *)&flashMessageCount, 1);
-        LOG_DEBUG("Messages available: %u", (uint32_t)flashMessageCount);
-
-        // For each message
-        for (uint8_t i = 0; i < flashMessageCount && i < MAX_MESSAGES_SAVED; i++) {
+        // Each record, oldest first
+        // Pushing to the front leaves the newest at the front, and drops any older than the ring holds
+        uint8_t header[RECORD_HEADER_SIZE];
+        size_t got;
+        while ((got = f.readBytes((char *)header, sizeof(header))) == sizeof(header)) {
             Message m;
-
-            // Read meta data (fixed width)
-            f.readBytes((char *)&m.timestamp, sizeof(m.timestamp));
-            f.readBytes((char *)&m.sender, sizeof(m.sender));
-            f.readBytes((char *)&m.channelIndex, sizeof(m.channelIndex));
-
-            // Read characters until we find a null term
-            char c;
-            while (m.text.size() < MAX_MESSAGE_SIZE) {
-                f.readBytes(&c, 1);
-                if (c != '\0')
-                    m.text += c;
-                else
-                    break;
+            memcpy(&m.timestamp, header, sizeof(m.timestamp));
+            memcpy(&m.sender, header + 4, sizeof(m.sender));
+            m.channelIndex = header[8];
+            uint8_t length = header[9];
+
+            if (length > MAX_TEXT || f.readBytes(m.text, length) != length) {
+                damaged = true;
+                break;
             }
+            m.text[length] = '\0';
 
-            // Store in RAM
-            messages.push_back(m);
-
-            LOG_DEBUG("#%u, timestamp=%u, sender(num)=%u, text=\"%s\"", (uint32_t)i, m.timestamp, m.sender, m.text.c_str());
+            messages.push_front(m);
+            recordsInFile++;
         }
+        if (got != 0 && got != sizeof(header))
+            damaged = true;
 
         f.close();
-    } else {
-        LOG_ERROR("Could not open / read %s", filename.c_str());
+        LOG_DEBUG("Messages available: %u, of %u in log", (uint32_t)messages.size(), (uint32_t)recordsInFile);
+    }
+
+    // A record was cut short, e.g. power lost while appending
+    // Rewrite the log, or messages appended after the damage would never be read
+    if (damaged) {
+        LOG_WARN("%s damaged, rewriting", filename.c_str());
+        saveToFlash();
     }
 #else
     LOG_ERROR("Filesystem not implemented");
-    state = LoadFileState::NO_FILESYSTEM;
 #endif
     return;
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -6,13 +6,19 @@ We hold a few recent messages, for features like the threaded message applet.
 This class contains a struct for storing those messages,
 and methods for serializing them to flash.
 
+Messages live in a fixed ring of slots, allocated once, with the text held inline.
+Storing a message never touches the heap.
+
+In flash, messages are appended to a log file as they arrive, which is cheap and survives power loss.
+Now and then (and at shutdown) the log is compacted: rewritten with only the messages still held in RAM.
+
 */
 
 #pragma once
 
 #include "configuration.h"
 
-#include <deque>
+#include <assert.h>
 
 #include "mesh/MeshTypes.h"
 
@@ -22,24 +28,87 @@ namespace NicheGraphics::InkHUD
 class MessageStore
 {
   public:
+    // Most messages held, and so written to flash
+    static constexpr uint8_t MAX_MESSAGES = 10;
+
+    // Longest text held. A text message never outgrows one packet
+    static constexpr uint8_t MAX_TEXT = meshtastic_Constants_DATA_PAYLOAD_LEN;
+
     // A stored message
     struct Message {
         uint32_t timestamp; // Epoch seconds
         NodeNum sender = 0;
         uint8_t channelIndex;
-        std::string text;
+        char text[MAX_TEXT + 1] = ""; // Null terminated
+
+        void setText(const char *bytes, size_t length); // Bytes need not be null terminated
+    };
+
+    // Fixed number of messages, index 0 at the front
+    // Pushing to the front of a full ring drops the message at the back
+    class Ring
+    {
+      public:
+        explicit Ring(uint8_t capacity) : slots(new Message[capacity]), capacity(capacity) {}
+        ~Ring() { delete[] slots; }
+        Ring(const Ring &) = delete;
+        Ring &operator=(const Ring &) = delete;
+
+        uint8_t size() const { return count; }
+        uint8_t max_size() const { return capacity; }
+        bool empty() const { return count == 0; }
+
+        Message &at(uint8_t i)
+        {
+            assert(i < count);
+            return slots[(head + i) % capacity];
+        }
+
+        void push_front(const Message &m)
+        {
+            if (count == capacity)
+                count--;
+            head = (head + capacity - 1) % capacity;
+            slots[head] = m;
+            count++;
+        }
+
+        // Does nothing if full: the back is the oldest message
+        void push_back(const Message &m)
+        {
+            if (count < capacity)
+                slots[(head + count++) % capacity] = m;
+        }
+
+        void pop_back()
+        {
+            if (count)
+                count--;
+        }
+
+        void clear() { count = 0; }
+
+      private:
+        Message *slots;
+        uint8_t capacity;
+        uint8_t head = 0;
+        uint8_t count = 0;
     };
 
     MessageStore() = delete;
-    explicit MessageStore(std::string label); // Label determines filename in flash
+    explicit MessageStore(std::string label, uint8_t capacity = MAX_MESSAGES); // Label determines filename in flash
 
-    void saveToFlash();
+    void add(const Message &m); // Store as the newest message, and append to flash
+    void saveToFlash();         // Rewrite flash with the current messages
     void loadFromFlash();
 
-    std::deque<Message> messages; // Interact with this object!
+    Ring messages; // Interact with this object! Newest message at the front, if using add()
 
   private:
     std::string filename;
+    uint8_t recordsInFile = 0; // Messages in the log, including ones since dropped from RAM
+
+    static void writeRecord(Print &f, const Message &m);
 };
 
 } // namespace NicheGraphics::InkHUD
@@ -21,7 +21,7 @@ void InkHUD::Persistence::loadSettings()
 void InkHUD::Persistence::loadLatestMessage()
 {
     // Load previous "latestMessages" data from flash
-    MessageStore store("latest");
+    MessageStore store("latest", 2);
     store.loadFromFlash();
 
     // Place into latestMessage struct, for convenient access
@@ -46,7 +46,7 @@ void InkHUD::Persistence::saveSettings()
 void InkHUD::Persistence::saveLatestMessage()
 {
     // Number of strings saved determines whether last message was broadcast or dm
-    MessageStore store("latest");
+    MessageStore store("latest", 2);
     store.messages.push_back(latestMessage.dm);
     if (latestMessage.wasBroadcast)
         store.messages.push_back(latestMessage.broadcast);
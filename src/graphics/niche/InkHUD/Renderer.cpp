@@ -214,9 +214,13 @@ void InkHUD::Renderer::render(bool async)
     // We don't know this until after autoshow has run, as new applets may now be in foreground
     if (shouldUpdate()) {
 
-        // Decide which technique the display will use to change image
-        // Done early, as rendering resets the Applets' requested types
-        Drivers::EInk::UpdateTypes updateType = decideUpdateType();
+        // Decide which part of the display needs to change, and which technique the display will use to change it
+        // Done early, as rendering resets the Applets' requests
+        uint16_t firstRow = 0;
+        uint16_t lastRow = driver->height - 1;
+        bool windowed = findChangedRows(&firstRow, &lastRow);
+        float portion = windowed ? (float)(lastRow - firstRow + 1) / driver->height : 1.0;
+        Drivers::EInk::UpdateTypes updateType = decideUpdateType(portion);
 
         // Render the new image
         clearBuffer();
@@ -232,8 +236,14 @@ void InkHUD::Renderer::render(bool async)
         }
 
         // Tell display to begin process of drawing new image
-        LOG_INFO("Updating display");
-        driver->update(imageBuffer, updateType);
+        // Only the changed rows, if possible. A FULL refresh always redraws the whole display.
+        if (windowed && updateType == Drivers::EInk::UpdateTypes::FAST) {
+            LOG_INFO("Updating display rows %u-%u", firstRow, lastRow);
+            driver->updateWindow(imageBuffer, updateType, firstRow, lastRow);
+        } else {
+            LOG_INFO("Updating display");
+            driver->update(imageBuffer, updateType);
+        }
 
         // If not async, wait here until the update is complete
         if (!async)
@@ -311,10 +321,56 @@ bool InkHUD::Renderer::shouldUpdate()
     return should;
 }
 
+// Find which rows of the display (in the driver's orientation) will change, if only some user applets asked to render
+// Their tiles are the only part of the image we need to send. Everything else is already on the display.
+// Returns false if the whole display should be updated:
+// - display can't update a window
+// - update was forced (layout change, tile highlight, display health, etc)
+// - a system applet will render; these draw over the top of user tiles
+// - the changed tiles cover the full height anyway
+bool InkHUD::Renderer::findChangedRows(uint16_t *firstRow, uint16_t *lastRow)
+{
+    if (!driver->supportsWindow() || forced || lockRendering || lockRequests)
+        return false;
+
+    for (SystemApplet *sa : inkhud->systemApplets) {
+        if (sa->wantsToRender() && sa->isForeground())
+            return false;
+    }
+
+    int32_t top = INT32_MAX;
+    int32_t bottom = -1;
+    for (Applet *ua : inkhud->userApplets) {
+        if (!ua || !ua->wantsToRender() || !ua->isForeground())
+            continue;
+
+        // Opposite corners of the tile, rotated to match the image buffer
+        Tile *t = ua->getTile();
+        int16_t x1 = t->getLeft();
+        int16_t y1 = t->getTop();
+        int16_t x2 = t->getLeft() + t->getWidth() - 1;
+        int16_t y2 = t->getTop() + t->getHeight() - 1;
+        rotatePixelCoords(&x1, &y1);
+        rotatePixelCoords(&x2, &y2);
+
+        top = min(top, (int32_t)min(y1, y2));
+        bottom = max(bottom, (int32_t)max(y1, y2));
+    }
+
+    // Nothing specific, or everything
+    if (bottom < 0 || (top <= 0 && bottom >= driver->height - 1))
+        return false;
+
+    *firstRow = max(top, (int32_t)0);
+    *lastRow = min(bottom, (int32_t)driver->height - 1);
+    return true;
+}
+
 // Determine which type of E-Ink update the display will perform, to change the image.
 // Considers the needs of the various applets, then weighs against display health.
 // An update type specified by forceUpdate will be granted with no further questioning.
-Drivers::EInk::UpdateTypes InkHUD::Renderer::decideUpdateType()
+// Portion is the fraction of the display which will change, see findChangedRows
+Drivers::EInk::UpdateTypes InkHUD::Renderer::decideUpdateType(float portion)
 {
     // Ask applets which update type they would prefer
     // Some update types take priority over others
@@ -333,7 +389,7 @@ Drivers::EInk::UpdateTypes InkHUD::Renderer::decideUpdateType()
         }
     }
 
-    return displayHealth.decideUpdateType();
+    return displayHealth.decideUpdateType(portion);
 }
 
 // Run the drawing operations of any user applets which are currently displayed
@@ -67,7 +67,8 @@ class Renderer : protected concurrency::OSThread
     void clearBuffer();
     void checkLocks();
     bool shouldUpdate();
-    Drivers::EInk::UpdateTypes decideUpdateType();
+    bool findChangedRows(uint16_t *firstRow, uint16_t *lastRow);
+    Drivers::EInk::UpdateTypes decideUpdateType(float portion);
     void renderUserApplets();
     void renderSystemApplets();
     void renderPlaceholders();
@@ -0,0 +1,133 @@
+#ifdef MESHTASTIC_INCLUDE_INKHUD
+
+#include "./TextRunCache.h"
+
+#include <algorithm>
+
+using namespace NicheGraphics;
+
+// Get the cached run for this text, or rasterise it now
+const InkHUD::TextRunCache::Run *InkHUD::TextRunCache::get(const GFXfont *font, const char *text)
+{
+    // Only AdafruitGFX fonts. The in-built font is drawn differently, and is rarely used by InkHUD
+    if (!font)
+        return nullptr;
+
+    for (Run &r : runs) {
+        if (r.font == font && r.text == text) {
+            r.lastUsed = ++useCounter;
+            return &r;
+        }
+    }
+
+    Run run;
+    run.font = font;
+    run.text = text;
+    if (!rasterise(run))
+        return nullptr;
+
+    makeRoom(run.bits.size());
+    run.lastUsed = ++useCounter;
+    totalBytes += run.bits.size();
+    runs.push_back(std::move(run));
+    return &runs.back();
+}
+
+// Measure the text, then draw its glyphs into the run's bitmap
+// Mirrors AdafruitGFX's getTextBounds and drawChar, for a custom font with text size 1 and no wrapping
+// Fonts live in memory-mapped flash on all InkHUD targets, so no pgm_read_* needed
+bool InkHUD::TextRunCache::rasterise(Run &run)
+{
+    const GFXfont *font = run.font;
+    const uint16_t first = font->first;
+    const uint16_t last = font->last;
+
+    // Pass 1: bounds
+    int16_t cursorX = 0;
+    int16_t minX = INT16_MAX, minY = INT16_MAX, maxX = -1, maxY = -1;
+    for (const char *p = run.text.c_str(); *p; p++) {
+        uint8_t c = *p;
+        if (c == '\n')
+            return false; // Multi-line: leave to AdafruitGFX
+        if (c == '\r' || c < first || c > last)
+            continue;
+
+        const GFXglyph *glyph = &font->glyph[c - first];
+        uint8_t w = glyph->width;
+        uint8_t h = glyph->height;
+        if (w > 0 && h > 0) {
+            int16_t x1 = cursorX + glyph->xOffset;
+            int16_t y1 = glyph->yOffset;
+            minX = std::min<int16_t>(minX, x1);
+            minY = std::min<int16_t>(minY, y1);
+            maxX = std::max<int16_t>(maxX, x1 + w - 1);
+            maxY = std::max<int16_t>(maxY, y1 + h - 1);
+        }
+        cursorX += glyph->xAdvance;
+    }
+    run.advance = cursorX;
+
+    // No visible pixels (empty string, or only spaces)
+    if (maxX < minX || maxY < minY)
+        return true;
+
+    run.offsetX = minX;
+    run.offsetY = minY;
+    run.width = maxX - minX + 1;
+    run.height = maxY - minY + 1;
+
+    // Don't let one long string push everything else out of the cache
+    const uint16_t stride = (run.width + 7) / 8;
+    const size_t bytes = (size_t)stride * run.height;
+    if (bytes > INKHUD_TEXT_CACHE_BYTES / 4)
+        return false;
+    run.bits.assign(bytes, 0);
+
+    // Pass 2: pixels
+    const uint8_t *bitmap = font->bitmap;
+    cursorX = 0;
+    for (const char *p = run.text.c_str(); *p; p++) {
+        uint8_t c = *p;
+        if (c == '\r' || c < first || c > last)
+            continue;
+
+        const GFXglyph *glyph = &font->glyph[c - first];
+        uint16_t bo = glyph->bitmapOffset;
+        uint8_t w = glyph->width;
+        uint8_t h = glyph->height;
+        int16_t left = cursorX + glyph->xOffset - minX;
+        int16_t top = glyph->yOffset - minY;
+
+        // Glyph bitmaps are packed: consecutive bits, rows not padded
+        uint8_t bits = 0, bit = 0;
+        for (uint8_t yy = 0; yy < h; yy++) {
+            uint8_t *row = &run.bits[(top + yy) * stride];
+            for (uint8_t xx = 0; xx < w; xx++) {
+                if (!(bit++ & 7))
+                    bits = bitmap[bo++];
+                if (bits & 0x80)
+                    row[(left + xx) / 8] |= 0x80 >> ((left + xx) % 8);
+                bits <<= 1;
+            }
+        }
+        cursorX += glyph->xAdvance;
+    }
+
+    return true;
+}
+
+// Evict least recently used runs until there is space for another
+void InkHUD::TextRunCache::makeRoom(size_t bytes)
+{
+    while (!runs.empty() && (runs.size() >= INKHUD_TEXT_CACHE_RUNS || totalBytes + bytes > INKHUD_TEXT_CACHE_BYTES)) {
+        auto oldest = runs.begin();
+        for (auto r = runs.begin(); r != runs.end(); ++r) {
+            if (r->lastUsed < oldest->lastUsed)
+                oldest = r;
+        }
+        totalBytes -= oldest->bits.size();
+        runs.erase(oldest);
+    }
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifdef MESHTASTIC_INCLUDE_INKHUD
+
+/*
+
+Small LRU cache of rasterised text, shared by all applets
+
+- Applet::printAt and Applet::getTextWidth look text up here by font + string
+- a cached run holds the text's bounds (as getTextBounds would give) and its pixels as a 1-bit bitmap
+- repeated text (headers, node names, clock) is blitted from the bitmap, instead of re-measured and redrawn glyph by glyph
+
+Only single-line text in an AdafruitGFX font is cached. Anything else is left to AdafruitGFX.
+
+*/
+
+#pragma once
+
+#include "configuration.h"
+
+#include <GFX.h> // GFXRoot drawing lib
+
+#include <string>
+#include <vector>
+
+// Total size of the cached bitmaps
+#ifndef INKHUD_TEXT_CACHE_BYTES
+#define INKHUD_TEXT_CACHE_BYTES 2048
+#endif
+
+// Max number of cached strings
+#ifndef INKHUD_TEXT_CACHE_RUNS
+#define INKHUD_TEXT_CACHE_RUNS 16
+#endif
+
+namespace NicheGraphics::InkHUD
+{
+
+class TextRunCache
+{
+  public:
+    // One rasterised string
+    struct Run {
+        const GFXfont *font = nullptr;
+        std::string text;
+
+        // Bounds relative to the cursor, as getTextBounds(text, 0, 0, ...)
+        int16_t offsetX = 0;
+        int16_t offsetY = 0;
+        uint16_t width = 0;
+        uint16_t height = 0;
+
+        int16_t advance = 0;       // How far printing the text moves the cursor
+        std::vector<uint8_t> bits; // Row-major, each row padded to whole bytes, MSB is leftmost pixel
+
+        uint32_t lastUsed = 0;
+    };
+
+    // Get the run for this text, rasterising it if not yet cached
+    // Returns nullptr if the text can't be cached; caller should fall back to AdafruitGFX
+    const Run *get(const GFXfont *font, const char *text);
+
+  private:
+    bool rasterise(Run &run);
+    void makeRoom(size_t bytes); // Evict least recently used runs
+
+    std::vector<Run> runs;
+    size_t totalBytes = 0;
+    uint32_t useCounter = 0;
+};
+
+} // namespace NicheGraphics::InkHUD
+
+#endif
@@ -190,6 +190,19 @@ void InkHUD::Tile::handleAppletPixel(int16_t x, int16_t y, Color c)
     }
 }
 
+// Position of the tile's left edge on the display, before rotation
+// Used by Renderer, to find which part of the display changed
+int16_t InkHUD::Tile::getLeft()
+{
+    return left;
+}
+
+// Position of the tile's top edge on the display, before rotation
+int16_t InkHUD::Tile::getTop()
+{
+    return top;
+}
+
 // Called by Applet base class, when setting applet dimensions, immediately before render
 uint16_t InkHUD::Tile::getWidth()
 {
@@ -123,9 +123,9 @@ void CannedMessageStore::handleSet(const meshtastic_AdminMessage *request)
 
     // Ensure the directory exists
 #ifdef FSCom
-    spiLock->lock();
+    fsLock->lock();
     FSCom.mkdir("/prefs");
-    spiLock->unlock();
+    fsLock->unlock();
 #endif
 
     // Write to flash
@@ -47,8 +47,8 @@ template <typename T> class FlashData
   public:
     static bool load(T *data, const char *label)
     {
-        // Take firmware's SPI lock
-        concurrency::LockGuard guard(spiLock);
+        // Take firmware's filesystem lock
+        concurrency::LockGuard guard(fsLock);
 
         // Set false if we run into issues
         bool okay = true;
@@ -108,7 +108,7 @@ template <typename T> class FlashData
     }
 
     // Save module's custom data (settings?) to flash. Doesn't use protobufs
-    // Takes the firmware's SPI lock, in case the files are stored on SD card
+    // Takes the firmware's filesystem lock
     // Need to lock and unlock around specific FS methods, as the SafeFile class takes the lock for itself internally.
     static void save(T *data, const char *label)
     {
@@ -116,9 +116,9 @@ template <typename T> class FlashData
         std::string filename = getFilename(label);
 
 #ifdef FSCom
-        spiLock->lock();
+        fsLock->lock();
         FSCom.mkdir("/NicheGraphics");
-        spiLock->unlock();
+        fsLock->unlock();
 
         auto f = SafeFile(filename.c_str(), true); // "true": full atomic. Write new data to temp file, then rename.
 
@@ -127,10 +127,10 @@ template <typename T> class FlashData
         // Calculate a hash of the data
         uint32_t hash = getHash(data);
 
-        spiLock->lock();
+        fsLock->lock();
         f.write((uint8_t *)data, sizeof(T));     // Write the actual data
         f.write((uint8_t *)&hash, sizeof(hash)); // Append the hash
-        spiLock->unlock();
+        fsLock->unlock();
 
         bool writeSucceeded = f.close();
 
@@ -147,8 +147,8 @@ template <typename T> class FlashData
 inline void clearFlashData()
 {
 
-    // Take firmware's SPI lock, in case the files are stored on SD card
-    concurrency::LockGuard guard(spiLock);
+    // Take firmware's filesystem lock
+    concurrency::LockGuard guard(fsLock);
 
 #ifdef FSCom
     File dir = FSCom.open("/NicheGraphics"); // Open the directory
@@ -164,6 +164,7 @@ inline void clearFlashData()
 
         file = dir.openNextFile();
     }
+    invalidateFileManifest();
 #else
     LOG_ERROR("ERROR: Filesystem not implemented\n");
 #endif
@@ -35,14 +35,14 @@
 #define KEY_NUMLOCK (1 << 6)
 #define KEY_COUNT_MASK (0x1F)
 
-BBQ10Keyboard::BBQ10Keyboard() : m_wire(nullptr), m_addr(0), readCallback(nullptr), writeCallback(nullptr) {}
+BBQ10Keyboard::BBQ10Keyboard() : m_bus(nullptr), m_addr(0), readCallback(nullptr), writeCallback(nullptr) {}
 
 void BBQ10Keyboard::begin(uint8_t addr, TwoWire *wire)
 {
     m_addr = addr;
-    m_wire = wire;
+    m_bus = I2CBus::get(wire);
 
-    m_wire->begin();
+    wire->begin();
 
     reset();
 }
@@ -50,7 +50,7 @@ void BBQ10Keyboard::begin(uint8_t addr, TwoWire *wire)
 void BBQ10Keyboard::begin(i2c_com_fptr_t r, i2c_com_fptr_t w, uint8_t addr)
 {
     m_addr = addr;
-    m_wire = nullptr;
+    m_bus = nullptr;
     writeCallback = w;
     readCallback = r;
     reset();
@@ -58,10 +58,9 @@ void BBQ10Keyboard::begin(i2c_com_fptr_t r, i2c_com_fptr_t w, uint8_t addr)
 
 void BBQ10Keyboard::reset()
 {
-    if (m_wire) {
-        m_wire->beginTransmission(m_addr);
-        m_wire->write(_REG_RST);
-        m_wire->endTransmission();
+    if (m_bus) {
+        uint8_t reg = _REG_RST;
+        m_bus->write(m_addr, &reg, 1);
     }
     if (writeCallback) {
         uint8_t data = 0;
@@ -124,16 +123,10 @@ void BBQ10Keyboard::setBacklight(float value)
 
 uint8_t BBQ10Keyboard::readRegister8(uint8_t reg) const
 {
-    if (m_wire) {
-        m_wire->beginTransmission(m_addr);
-        m_wire->write(reg);
-        m_wire->endTransmission();
-
-        m_wire->requestFrom(m_addr, (uint8_t)1);
-        if (m_wire->available() < 1)
-            return 0;
-
-        return m_wire->read();
+    if (m_bus) {
+        uint8_t value = 0;
+        m_bus->readRegister(m_addr, reg, value);
+        return value;
     }
     if (readCallback) {
         uint8_t data;
@@ -147,16 +140,9 @@ uint16_t BBQ10Keyboard::readRegister16(uint8_t reg) const
 {
     uint8_t data[2] = {0};
     // uint8_t low = 0, high = 0;
-    if (m_wire) {
-        m_wire->beginTransmission(m_addr);
-        m_wire->write(reg);
-        m_wire->endTransmission();
-
-        m_wire->requestFrom(m_addr, (uint8_t)2);
-        if (m_wire->available() < 2)
+    if (m_bus) {
+        if (!m_bus->readRegisters(m_addr, reg, data, 2))
             return 0;
-        data[0] = m_wire->read();
-        data[1] = m_wire->read();
     }
     if (readCallback) {
         readCallback(m_addr, reg, data, 2);
@@ -170,10 +156,8 @@ void BBQ10Keyboard::writeRegister(uint8_t reg, uint8_t value)
     data[0] = reg | _WRITE_MASK;
     data[1] = value;
 
-    if (m_wire) {
-        m_wire->beginTransmission(m_addr);
-        m_wire->write(data, sizeof(uint8_t) * 2);
-        m_wire->endTransmission();
+    if (m_bus) {
+        m_bus->write(m_addr, data, sizeof(uint8_t) * 2);
     }
     if (writeCallback) {
         writeCallback(m_addr, data[0], &(data[1]), 1);
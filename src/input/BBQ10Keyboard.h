@@ -1,5 +1,6 @@
 // Based on arturo182 arduino_bbq10kbd library https://github.com/arturo182/arduino_bbq10kbd
 
+#include "I2CBus.h"
 #include "configuration.h"
 #include <Wire.h>
 
@@ -44,7 +45,7 @@ class BBQ10Keyboard
     void writeRegister(uint8_t reg, uint8_t value);
 
   private:
-    TwoWire *m_wire;
+    I2CBus *m_bus;
     uint8_t m_addr;
     i2c_com_fptr_t readCallback;
     i2c_com_fptr_t writeCallback;
@@ -9,6 +9,7 @@
 #include "RadioLibInterface.h"
 #include "buzz.h"
 #include "input/InputBroker.h"
+#include "input/InputInterrupt.h"
 #include "main.h"
 #include "modules/CannedMessageModule.h"
 #include "modules/ExternalNotificationModule.h"
@@ -272,6 +273,10 @@ int32_t ButtonThread::runOnce()
         }
     }
     btnEvent = BUTTON_EVENT_NONE;
+
+    // Our interrupt routine wakes us on the next edge, until then there is nothing to tick
+    if (canSleep && !buttonCurrentlyPressed && !waitingForLongPress)
+        return INPUT_IDLE_POLL_MS;
     return 50;
 }
 
@@ -309,6 +314,7 @@ int ButtonThread::beforeLightSleep(void *unused)
 int ButtonThread::afterLightSleep(esp_sleep_wakeup_cause_t cause)
 {
     attachButtonInterrupts();
+    setIntervalFromNow(0); // The press that woke us did not go through our interrupt
     return 0; // Indicates success
 }
 
@@ -0,0 +1,86 @@
+#include "InputInterrupt.h"
+#include "main.h"
+
+#ifdef ARCH_ESP32
+#include "sleep.h"
+#endif
+
+InputInterrupt *InputInterrupt::slots[INPUT_INTERRUPT_SLOTS];
+
+IRAM_ATTR void InputInterrupt::isr0()
+{
+    slots[0]->onEdge();
+}
+
+IRAM_ATTR void InputInterrupt::isr1()
+{
+    slots[1]->onEdge();
+}
+
+IRAM_ATTR void InputInterrupt::isr2()
+{
+    slots[2]->onEdge();
+}
+
+void (*const InputInterrupt::isrs[INPUT_INTERRUPT_SLOTS])() = {isr0, isr1, isr2};
+
+IRAM_ATTR void InputInterrupt::onEdge()
+{
+    lastEdgeMs = millis();
+    edgeCount++;
+    thread->enabled = true;
+    thread->setInterval(0); // Run ASAP, msecToSettle() holds it off until the line is quiet
+    runASAP = true;
+
+    BaseType_t higherWake = 0;
+    concurrency::mainDelay.interruptFromISR(&higherWake);
+}
+
+bool InputInterrupt::attach(uint8_t _pin, int _mode, concurrency::OSThread *_thread, uint32_t _debounceMs)
+{
+    detach();
+    for (int8_t i = 0; i < INPUT_INTERRUPT_SLOTS; i++) {
+        if (!slots[i]) {
+            slot = i;
+            pin = _pin;
+            mode = _mode;
+            thread = _thread;
+            debounceMs = _debounceMs;
+            slots[i] = this;
+            attachInterrupt(digitalPinToInterrupt(pin), isrs[i], mode);
+#ifdef ARCH_ESP32
+            lsEndObserver.observe(&notifyLightSleepEnd);
+#endif
+            LOG_DEBUG("%s waits for interrupts on pin %d", thread->ThreadName.c_str(), pin);
+            return true;
+        }
+    }
+    LOG_WARN("No interrupt slot left for pin %d, keep polling", _pin);
+    return false;
+}
+
+void InputInterrupt::detach()
+{
+    if (slot < 0)
+        return;
+    detachInterrupt(digitalPinToInterrupt(pin));
+#ifdef ARCH_ESP32
+    lsEndObserver.unobserve(&notifyLightSleepEnd);
+#endif
+    slots[slot] = NULL;
+    slot = -1;
+}
+
+int32_t InputInterrupt::msecToSettle() const
+{
+    uint32_t quiet = millis() - lastEdgeMs;
+    return quiet >= debounceMs ? 0 : debounceMs - quiet;
+}
+
+#ifdef ARCH_ESP32
+int InputInterrupt::afterLightSleep(esp_sleep_wakeup_cause_t cause)
+{
+    attachInterrupt(digitalPinToInterrupt(pin), isrs[slot], mode);
+    return 0;
+}
+#endif
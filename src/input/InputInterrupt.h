@@ -0,0 +1,73 @@
+#pragma once
+
+#include "concurrency/OSThread.h"
+#include "configuration.h"
+
+#ifdef ARCH_ESP32
+#include "Observer.h"
+#include <esp_sleep.h>
+#endif
+
+/// Edges closer together than this are folded into one wakeup
+#ifndef INPUT_DEBOUNCE_MS
+#define INPUT_DEBOUNCE_MS 5
+#endif
+
+/// How often a source with an interrupt line still looks while idle, in case an edge got lost (e.g. across light sleep)
+#ifndef INPUT_IDLE_POLL_MS
+#define INPUT_IDLE_POLL_MS 10000
+#endif
+
+/// How many pins can wake input threads at once
+#define INPUT_INTERRUPT_SLOTS 3
+
+/**
+ * Wakes an input thread from the INT line of a keyboard controller or touch panel, so the thread can sleep while nothing happens
+ * instead of polling the bus every few hundred msecs, and the CPU with it.
+ *
+ * The ISR only notes the time and makes the thread run ASAP.  The thread then asks msecToSettle() and, if the line has not been
+ * quiet for the debounce time yet, waits that much longer, so a burst of edges costs one bus read.
+ */
+class InputInterrupt
+{
+  public:
+    /**
+     * Wake thread on mode (FALLING, CHANGE...) edges of pin
+     * @return false if all INPUT_INTERRUPT_SLOTS are taken, the caller then keeps polling
+     */
+    bool attach(uint8_t pin, int mode, concurrency::OSThread *thread, uint32_t debounceMs = INPUT_DEBOUNCE_MS);
+
+    void detach();
+
+    bool isAttached() const { return slot >= 0; }
+
+    /// 0 if the last edge has settled and should be handled now, else how many msecs to wait first
+    int32_t msecToSettle() const;
+
+    /// millis() of the last edge
+    uint32_t getLastEdgeMs() const { return lastEdgeMs; }
+
+    /// Edges seen since attach(), wraps around
+    uint32_t getEdgeCount() const { return edgeCount; }
+
+  private:
+    int8_t slot = -1;
+    uint8_t pin = 0;
+    int mode = 0;
+    concurrency::OSThread *thread = NULL;
+    uint32_t debounceMs = 0;
+    volatile uint32_t lastEdgeMs = 0;
+    volatile uint32_t edgeCount = 0;
+
+    static InputInterrupt *slots[INPUT_INTERRUPT_SLOTS];
+    static void isr0(), isr1(), isr2();
+    static void (*const isrs[INPUT_INTERRUPT_SLOTS])();
+    void onEdge();
+
+#ifdef ARCH_ESP32
+    // Light sleep reprograms the GPIO interrupts of its wake pins, attach again afterwards
+    int afterLightSleep(esp_sleep_wakeup_cause_t cause);
+    CallbackObserver<InputInterrupt, esp_sleep_wakeup_cause_t> lsEndObserver =
+        CallbackObserver<InputInterrupt, esp_sleep_wakeup_cause_t>(this, &InputInterrupt::afterLightSleep);
+#endif
+};
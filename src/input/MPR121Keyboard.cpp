@@ -87,7 +87,7 @@ unsigned char MPR121_LongPressMap[12] = {MPR121_ESC,  ' ',         MPR121_NONE,
 // Rotated Layout
 uint8_t MPR121_KeyMap[12] = {2, 5, 8, 11, 1, 4, 7, 10, 0, 3, 6, 9};
 
-MPR121Keyboard::MPR121Keyboard() : m_wire(nullptr), m_addr(0), readCallback(nullptr), writeCallback(nullptr)
+MPR121Keyboard::MPR121Keyboard() : m_bus(nullptr), m_addr(0), readCallback(nullptr), writeCallback(nullptr)
 {
     // LOG_DEBUG("MPR121 @ %02x", m_addr);
     state = Init;
@@ -100,9 +100,9 @@ MPR121Keyboard::MPR121Keyboard() : m_wire(nullptr), m_addr(0), readCallback(null
 void MPR121Keyboard::begin(uint8_t addr, TwoWire *wire)
 {
     m_addr = addr;
-    m_wire = wire;
+    m_bus = I2CBus::get(wire);
 
-    m_wire->begin();
+    wire->begin();
 
     reset();
 }
@@ -110,7 +110,7 @@ void MPR121Keyboard::begin(uint8_t addr, TwoWire *wire)
 void MPR121Keyboard::begin(i2c_com_fptr_t r, i2c_com_fptr_t w, uint8_t addr)
 {
     m_addr = addr;
-    m_wire = nullptr;
+    m_bus = nullptr;
     writeCallback = w;
     readCallback = r;
     reset();
@@ -120,10 +120,9 @@ void MPR121Keyboard::reset()
 {
     LOG_DEBUG("MPR121 Reset");
     // Trigger a MPR121 Soft Reset
-    if (m_wire) {
-        m_wire->beginTransmission(m_addr);
-        m_wire->write(_MPR121_REG_SOFT_RESET);
-        m_wire->endTransmission();
+    if (m_bus) {
+        uint8_t reg = _MPR121_REG_SOFT_RESET;
+        m_bus->write(m_addr, &reg, 1);
     }
     if (writeCallback) {
         uint8_t data = 0;
@@ -376,16 +375,10 @@ void MPR121Keyboard::released()
 
 uint8_t MPR121Keyboard::readRegister8(uint8_t reg) const
 {
-    if (m_wire) {
-        m_wire->beginTransmission(m_addr);
-        m_wire->write(reg);
-        m_wire->endTransmission();
-
-        m_wire->requestFrom(m_addr, (uint8_t)1);
-        if (m_wire->available() < 1)
-            return 0;
-
-        return m_wire->read();
+    if (m_bus) {
+        uint8_t value = 0;
+        m_bus->readRegister(m_addr, reg, value);
+        return value;
     }
     if (readCallback) {
         uint8_t data;
@@ -399,16 +392,9 @@ uint16_t MPR121Keyboard::readRegister16(uint8_t reg) const
 {
     uint8_t data[2] = {0};
     // uint8_t low = 0, high = 0;
-    if (m_wire) {
-        m_wire->beginTransmission(m_addr);
-        m_wire->write(reg);
-        m_wire->endTransmission();
-
-        m_wire->requestFrom(m_addr, (uint8_t)2);
-        if (m_wire->available() < 2)
+    if (m_bus) {
+        if (!m_bus->readRegisters(m_addr, reg, data, 2))
             return 0;
-        data[0] = m_wire->read();
-        data[1] = m_wire->read();
     }
     if (readCallback) {
         readCallback(m_addr, reg, data, 2);
@@ -422,10 +408,8 @@ void MPR121Keyboard::writeRegister(uint8_t reg, uint8_t value)
     data[0] = reg;
     data[1] = value;
 
-    if (m_wire) {
-        m_wire->beginTransmission(m_addr);
-        m_wire->write(data, sizeof(uint8_t) * 2);
-        m_wire->endTransmission();
+    if (m_bus) {
+        m_bus->write(m_addr, data, sizeof(uint8_t) * 2);
     }
     if (writeCallback) {
         writeCallback(m_addr, data[0], &(data[1]), 1);
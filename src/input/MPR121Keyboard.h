@@ -1,5 +1,6 @@
 // Based on the BBQ10 Keyboard
 
+#include "I2CBus.h"
 #include "concurrency/NotifiedWorkerThread.h"
 #include "configuration.h"
 #include <Wire.h>
@@ -49,7 +50,7 @@ class MPR121Keyboard
     void writeRegister(uint8_t reg, uint8_t value);
 
   private:
-    TwoWire *m_wire;
+    I2CBus *m_bus;
     uint8_t m_addr;
     i2c_com_fptr_t readCallback;
     i2c_com_fptr_t writeCallback;
@@ -143,7 +143,7 @@ unsigned char TCA8418LongPressMap[_TCA8418_NUM_KEYS] = {
 #define _TCA8418_LONG_PRESS_THRESHOLD 2000
 #define _TCA8418_MULTI_TAP_THRESHOLD 750
 
-TCA8418Keyboard::TCA8418Keyboard() : m_wire(nullptr), m_addr(0), readCallback(nullptr), writeCallback(nullptr)
+TCA8418Keyboard::TCA8418Keyboard() : m_bus(nullptr), m_addr(0), readCallback(nullptr), writeCallback(nullptr)
 {
     state = Init;
     last_key = -1;
@@ -158,9 +158,9 @@ TCA8418Keyboard::TCA8418Keyboard() : m_wire(nullptr), m_addr(0), readCallback(nu
 void TCA8418Keyboard::begin(uint8_t addr, TwoWire *wire)
 {
     m_addr = addr;
-    m_wire = wire;
+    m_bus = I2CBus::get(wire);
 
-    m_wire->begin();
+    wire->begin();
 
     reset();
 }
@@ -168,7 +168,7 @@ void TCA8418Keyboard::begin(uint8_t addr, TwoWire *wire)
 void TCA8418Keyboard::begin(i2c_com_fptr_t r, i2c_com_fptr_t w, uint8_t addr)
 {
     m_addr = addr;
-    m_wire = nullptr;
+    m_bus = nullptr;
     writeCallback = w;
     readCallback = r;
     reset();
@@ -524,16 +524,10 @@ void TCA8418Keyboard::setBacklight(bool on)
 
 uint8_t TCA8418Keyboard::readRegister(uint8_t reg) const
 {
-    if (m_wire) {
-        m_wire->beginTransmission(m_addr);
-        m_wire->write(reg);
-        m_wire->endTransmission();
-
-        m_wire->requestFrom(m_addr, (uint8_t)1);
-        if (m_wire->available() < 1)
-            return 0;
-
-        return m_wire->read();
+    if (m_bus) {
+        uint8_t value = 0;
+        m_bus->readRegister(m_addr, reg, value);
+        return value;
     }
     if (readCallback) {
         uint8_t data;
@@ -549,10 +543,8 @@ void TCA8418Keyboard::writeRegister(uint8_t reg, uint8_t value)
     data[0] = reg;
     data[1] = value;
 
-    if (m_wire) {
-        m_wire->beginTransmission(m_addr);
-        m_wire->write(data, sizeof(uint8_t) * 2);
-        m_wire->endTransmission();
+    if (m_bus) {
+        m_bus->write(m_addr, data, sizeof(uint8_t) * 2);
     }
     if (writeCallback) {
         writeCallback(m_addr, data[0], &(data[1]), 1);
@@ -1,4 +1,5 @@
 // Based on the MPR121 Keyboard and Adafruit TCA8418 library
+#include "I2CBus.h"
 #include "configuration.h"
 #include <Wire.h>
 
@@ -75,7 +76,7 @@ class TCA8418Keyboard
     void writeRegister(uint8_t reg, uint8_t value);
 
   private:
-    TwoWire *m_wire;
+    I2CBus *m_bus;
     uint8_t m_addr;
     i2c_com_fptr_t readCallback;
     i2c_com_fptr_t writeCallback;
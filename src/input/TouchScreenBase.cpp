@@ -29,6 +29,9 @@ void TouchScreenBase::init(bool hasTouch)
     if (hasTouch) {
         LOG_INFO("TouchScreen initialized %d %d", TOUCH_THRESHOLD_X, TOUCH_THRESHOLD_Y);
         this->setInterval(100);
+#ifdef TOUCH_INTERRUPT_PIN
+        touchInterrupt.attach(TOUCH_INTERRUPT_PIN, FALLING, this);
+#endif
     } else {
         disable();
         this->setInterval(UINT_MAX);
@@ -37,6 +40,11 @@ void TouchScreenBase::init(bool hasTouch)
 
 int32_t TouchScreenBase::runOnce()
 {
+#ifdef TOUCH_INTERRUPT_PIN
+    if (int32_t wait = touchInterrupt.msecToSettle())
+        return wait;
+#endif
+
     TouchEvent e;
     e.touchEvent = static_cast<char>(TOUCH_ACTION_NONE);
 
@@ -146,6 +154,10 @@ int32_t TouchScreenBase::runOnce()
         onEvent(e);
     }
 
+#ifdef TOUCH_INTERRUPT_PIN
+    if (touchInterrupt.isAttached() && !touched && !_tapped)
+        return INPUT_IDLE_POLL_MS; // the next touch wakes us
+#endif
     return interval;
 }
 
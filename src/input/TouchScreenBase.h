@@ -1,10 +1,19 @@
 #pragma once
 
 #include "InputBroker.h"
+#include "InputInterrupt.h"
 #include "concurrency/OSThread.h"
 #include "mesh/NodeDB.h"
 #include "time.h"
 
+/**
+ * Touch controllers that signal touches on SCREEN_TOUCH_INT wake us through it instead of being polled while untouched.  The
+ * RAK14014 driver has its own handler on that pin, and pins behind an IO expander can't interrupt.
+ */
+#if defined(SCREEN_TOUCH_INT) && !defined(RAK14014) && !defined(IO_EXPANDER)
+#define TOUCH_INTERRUPT_PIN SCREEN_TOUCH_INT
+#endif
+
 typedef struct _TouchEvent {
     const char *source;
     char touchEvent;
@@ -52,4 +61,8 @@ class TouchScreenBase : public Observable<const InputEvent *>, public concurrenc
     bool _tapped;              // for DOUBLE_TAP
 
     const char *_originName;
+
+#ifdef TOUCH_INTERRUPT_PIN
+    InputInterrupt touchInterrupt;
+#endif
 };
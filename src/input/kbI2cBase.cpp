@@ -13,19 +13,11 @@ KbI2cBase::KbI2cBase(const char *name) : concurrency::OSThread(name)
 
 uint8_t read_from_14004(TwoWire *i2cBus, uint8_t reg, uint8_t *data, uint8_t length)
 {
-    uint8_t readflag = 0;
-    i2cBus->beginTransmission(CARDKB_ADDR);
-    i2cBus->write(reg);
-    i2cBus->endTransmission(); // stop transmitting
+    I2CBus *bus = I2CBus::get(i2cBus);
+    bus->write(CARDKB_ADDR, &reg, 1);
     delay(20);
-    i2cBus->requestFrom(CARDKB_ADDR, (int)length);
-    int i = 0;
-    while (i2cBus->available()) // slave may send less than requested
-    {
-        data[i++] = i2cBus->read(); // receive a byte as a proper uint8_t
-        readflag = 1;
-    }
-    return readflag;
+    // slave may send less than requested
+    return bus->read(CARDKB_ADDR, data, length) > 0 ? 1 : 0;
 }
 
 int32_t KbI2cBase::runOnce()
@@ -68,6 +60,15 @@ int32_t KbI2cBase::runOnce()
         }
     }
 
+#ifdef KB_INT
+    if (i2cBus && !kbInterrupt.isAttached()) {
+        pinMode(KB_INT, INPUT_PULLUP);
+        kbInterrupt.attach(KB_INT, FALLING, this);
+    }
+    if (int32_t wait = kbInterrupt.msecToSettle())
+        return wait;
+#endif
+
     switch (kb_model) {
     case 0x11: { // BB Q10
         int keyCount = Q10keyboard.keyCount();
@@ -320,10 +321,8 @@ int32_t KbI2cBase::runOnce()
     case 0x00:   // CARDKB
     case 0x10: { // T-DECK
 
-        i2cBus->requestFrom((int)cardkb_found.address, 1);
-
-        if (i2cBus->available()) {
-            char c = i2cBus->read();
+        char c;
+        if (I2CBus::get(i2cBus)->read(cardkb_found.address, (uint8_t *)&c, 1)) {
             InputEvent e;
             e.inputEvent = INPUT_BROKER_NONE;
             e.source = this->_originName;
@@ -477,5 +476,9 @@ int32_t KbI2cBase::runOnce()
     default:
         LOG_WARN("Unknown kb_model 0x%02x", kb_model);
     }
+#ifdef KB_INT
+    if (kbInterrupt.isAttached() && digitalRead(KB_INT) == HIGH)
+        return INPUT_IDLE_POLL_MS; // nothing pending, the next key press wakes us
+#endif
     return 300;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "BBQ10Keyboard.h"
 #include "InputBroker.h"
+#include "InputInterrupt.h"
 #include "MPR121Keyboard.h"
 #include "TCA8418Keyboard.h"
 #include "Wire.h"
@@ -24,4 +25,9 @@ class KbI2cBase : public Observable<const InputEvent *>, public concurrency::OST
     MPR121Keyboard MPRkeyboard;
     TCA8418Keyboard TCAKeyboard;
     bool is_sym = false;
+
+#ifdef KB_INT
+    // The variant's KB_INT is the controller's active low INT line, it stays low while the controller has events for us
+    InputInterrupt kbInterrupt;
+#endif
 };
\ No newline at end of file
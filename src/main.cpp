@@ -18,6 +18,7 @@
 #include "Throttle.h"
 #include "concurrency/OSThread.h"
 #include "concurrency/Periodic.h"
+#include "detect/HardwareCache.h"
 #include "detect/ScanI2C.h"
 #include "error.h"
 #include "power.h"
@@ -27,9 +28,11 @@
 #include <Wire.h>
 #endif
 #include "detect/einkScan.h"
+#include "gps/RadioGnss.h"
 #include "graphics/RAKled.h"
 #include "graphics/Screen.h"
 #include "main.h"
+#include "mesh/RadioTask.h"
 #include "mesh/generated/meshtastic/config.pb.h"
 #include "meshUtils.h"
 #include "modules/Modules.h"
@@ -90,7 +93,10 @@ NRF52Bluetooth *nrf52Bluetooth = nullptr;
 #ifdef ARCH_PORTDUINO
 #include "linux/LinuxHardwareI2C.h"
 #include "mesh/raspihttp/PiWebServer.h"
+#include "EventTrace.h"
+#include "platform/portduino/PacketCapture.h"
 #include "platform/portduino/PortduinoGlue.h"
+#include "platform/portduino/ShmAPI.h"
 #include "platform/portduino/USBHal.h"
 #include <cstdlib>
 #include <fstream>
@@ -265,6 +271,9 @@ static OSThread *ambientLightingThread;
 
 RadioInterface *rIf = NULL;
 #ifdef ARCH_PORTDUINO
+RadioInterface *rIf2 = NULL; // the Lora2 radio from config.yaml, if any
+#endif
+#ifdef ARCH_PORTDUINO
 RadioLibHal *RadioLibHAL = NULL;
 #endif
 
@@ -289,6 +298,30 @@ void printInfo()
     LOG_INFO("S:B:%d,%s", HW_VENDOR, optstr(APP_VERSION));
 }
 #ifndef PIO_UNIT_TESTING
+#if !MESHTASTIC_EXCLUDE_I2C
+/// Scan an I2C port, only at the addresses the hardware cache remembers if it has them.  Returns true if the cache was used.
+static bool scanI2CPort(ScanI2CTwoWire *scanner, ScanI2C::I2CPort port)
+{
+#if HARDWARE_CACHE && defined(FSCom)
+    uint8_t addresses[HW_CACHE_MAX_I2C];
+    uint8_t count;
+    if (hardwareCache.getI2C(port, addresses, &count)) {
+        LOG_INFO("Probe %u cached i2c addresses on port %d", count, port);
+        if (count)
+            scanner->scanPort(port, addresses, count);
+        return true;
+    }
+    scanner->scanPort(port);
+    count = scanner->getAddresses(port, addresses, HW_CACHE_MAX_I2C);
+    hardwareCache.setI2C(port, addresses, count);
+    return false;
+#else
+    scanner->scanPort(port);
+    return false;
+#endif
+}
+#endif
+
 void setup()
 {
 
@@ -455,6 +488,9 @@ void setup()
 #endif
 
     fsInit();
+#if HARDWARE_CACHE && defined(FSCom)
+    hardwareCache.load();
+#endif
 
 #if !MESHTASTIC_EXCLUDE_I2C
 #if defined(I2C_SDA1) && defined(ARCH_RP2040)
@@ -511,6 +547,7 @@ void setup()
     // We need to scan here to decide if we have a screen for nodeDB.init() and because power has been applied to
     // accessories
     auto i2cScanner = std::unique_ptr<ScanI2CTwoWire>(new ScanI2CTwoWire());
+    bool i2cFromCache = false;
 #if HAS_WIRE
     LOG_INFO("Scan for i2c devices");
 #endif
@@ -519,29 +556,35 @@ void setup()
     Wire1.setSDA(I2C_SDA1);
     Wire1.setSCL(I2C_SCL1);
     Wire1.begin();
-    i2cScanner->scanPort(ScanI2C::I2CPort::WIRE1);
+    i2cFromCache |= scanI2CPort(i2cScanner.get(), ScanI2C::I2CPort::WIRE1);
 #elif defined(I2C_SDA1) && !defined(ARCH_RP2040)
     Wire1.begin(I2C_SDA1, I2C_SCL1);
-    i2cScanner->scanPort(ScanI2C::I2CPort::WIRE1);
+    i2cFromCache |= scanI2CPort(i2cScanner.get(), ScanI2C::I2CPort::WIRE1);
 #elif defined(NRF52840_XXAA) && (WIRE_INTERFACES_COUNT == 2)
-    i2cScanner->scanPort(ScanI2C::I2CPort::WIRE1);
+    i2cFromCache |= scanI2CPort(i2cScanner.get(), ScanI2C::I2CPort::WIRE1);
 #endif
 
 #if defined(I2C_SDA) && defined(ARCH_RP2040)
     Wire.setSDA(I2C_SDA);
     Wire.setSCL(I2C_SCL);
     Wire.begin();
-    i2cScanner->scanPort(ScanI2C::I2CPort::WIRE);
+    i2cFromCache |= scanI2CPort(i2cScanner.get(), ScanI2C::I2CPort::WIRE);
 #elif defined(I2C_SDA) && !defined(ARCH_RP2040)
     Wire.begin(I2C_SDA, I2C_SCL);
-    i2cScanner->scanPort(ScanI2C::I2CPort::WIRE);
+    i2cFromCache |= scanI2CPort(i2cScanner.get(), ScanI2C::I2CPort::WIRE);
 #elif defined(ARCH_PORTDUINO)
     if (settingsStrings[i2cdev] != "") {
         LOG_INFO("Scan for i2c devices");
-        i2cScanner->scanPort(ScanI2C::I2CPort::WIRE);
+        i2cFromCache |= scanI2CPort(i2cScanner.get(), ScanI2C::I2CPort::WIRE);
     }
 #elif HAS_WIRE
-    i2cScanner->scanPort(ScanI2C::I2CPort::WIRE);
+    i2cFromCache |= scanI2CPort(i2cScanner.get(), ScanI2C::I2CPort::WIRE);
+#endif
+
+#if HARDWARE_CACHE && defined(FSCom)
+    hardwareCache.save();
+    if (i2cFromCache)
+        hardwareCache.startRescan();
 #endif
 
     auto i2cCount = i2cScanner->countDevices();
@@ -873,7 +916,11 @@ void setup()
         if (HAS_GPS) {
             if (config.device.role != meshtastic_Config_DeviceConfig_Role_REPEATER &&
                 config.position.gps_mode != meshtastic_Config_PositionConfig_GpsMode_NOT_PRESENT) {
+#if LR11X0_GNSS && LR11X0_GNSS_PREFERRED
+                LOG_INFO("Leave the GPS off, positions come from the radio's GNSS scanner");
+#else
                 gps = GPS::createGps();
+#endif
                 if (gps) {
                     gpsStatus->observe(&gps->newStatus);
                 } else {
@@ -941,6 +988,7 @@ void setup()
             config.pullupSense = INPUT_PULLUP;
             config.intRoutine = []() {
                 UserButtonThread->userButton.tick();
+                UserButtonThread->setInterval(0); // it sleeps while the button is idle
                 runASAP = true;
                 BaseType_t higherWake = 0;
                 mainDelay.interruptFromISR(&higherWake);
@@ -961,6 +1009,7 @@ void setup()
     touchConfig.pullupSense = pullup_sense;
     touchConfig.intRoutine = []() {
         TouchButtonThread->userButton.tick();
+        TouchButtonThread->setInterval(0); // it sleeps while the button is idle
         runASAP = true;
         BaseType_t higherWake = 0;
         mainDelay.interruptFromISR(&higherWake);
@@ -980,6 +1029,7 @@ void setup()
     cancelConfig.pullupSense = pullup_sense;
     cancelConfig.intRoutine = []() {
         CancelButtonThread->userButton.tick();
+        CancelButtonThread->setInterval(0); // it sleeps while the button is idle
         runASAP = true;
         BaseType_t higherWake = 0;
         mainDelay.interruptFromISR(&higherWake);
@@ -1000,6 +1050,7 @@ void setup()
     backConfig.pullupSense = pullup_sense;
     backConfig.intRoutine = []() {
         BackButtonThread->userButton.tick();
+        BackButtonThread->setInterval(0); // it sleeps while the button is idle
         runASAP = true;
         BaseType_t higherWake = 0;
         mainDelay.interruptFromISR(&higherWake);
@@ -1034,6 +1085,7 @@ void setup()
         userConfig.pullupSense = pullup_sense;
         userConfig.intRoutine = []() {
             UserButtonThread->userButton.tick();
+            UserButtonThread->setInterval(0); // it sleeps while the button is idle
             runASAP = true;
             BaseType_t higherWake = 0;
             mainDelay.interruptFromISR(&higherWake);
@@ -1051,6 +1103,7 @@ void setup()
         userConfigNoScreen.pullupSense = pullup_sense;
         userConfigNoScreen.intRoutine = []() {
             UserButtonThread->userButton.tick();
+            UserButtonThread->setInterval(0); // it sleeps while the button is idle
             runASAP = true;
             BaseType_t higherWake = 0;
             mainDelay.interruptFromISR(&higherWake);
@@ -1157,6 +1210,25 @@ void setup()
             }
         }
     }
+    if (rIf && settingsMap[lora2_module]) {
+        RadioInterface::LoraOverride lora2;
+        lora2.channelNum = settingsMap[lora2_channel_num];
+        lora2.modemPreset = settingsMap[lora2_modem_preset];
+        lora2.frequency = settingsMap[lora2_frequency_khz] / 1000.0;
+        lora2.bridge = settingsMap[lora2_bridge];
+
+        rIf2 = loraModuleInterface((configNames)settingsMap[lora2_module], (LockingArduinoHal *)RadioLibHAL,
+                                   settingsMap[lora2_cs_pin], settingsMap[lora2_irq_pin], settingsMap[lora2_reset_pin],
+                                   settingsMap[lora2_busy_pin]);
+        rIf2->setLoraOverride(lora2);
+        if (!rIf2->init()) {
+            LOG_WARN("No second radio");
+            delete rIf2;
+            rIf2 = NULL;
+        } else {
+            LOG_INFO("Second radio init success");
+        }
+    }
 #elif defined(HW_SPI1_DEVICE)
     LockingArduinoHal *RadioLibHAL = new LockingArduinoHal(SPI1, spiSettings);
 #else // HW_SPI1_DEVICE
@@ -1408,6 +1480,19 @@ void setup()
     }
 #endif
     initApiServer(TCPPort);
+    if (settingsStrings[shmAPIName] != "") {
+        shmAPI = ShmAPI::create(settingsStrings[shmAPIName], settingsMap[maxnodes]);
+        if (shmAPI)
+            std::atexit([] { delete shmAPI; });
+    }
+    if (settingsStrings[pcapFilename] != "") {
+        packetCapture = new PacketCapture(settingsStrings[pcapFilename], settingsMap[pcapMaxMB] * 1024 * 1024);
+        std::atexit([] { delete packetCapture; });
+    }
+#if EVENT_TRACE && defined(ARCH_PORTDUINO)
+    if (settingsStrings[eventTraceFilename] != "" && EventTrace::start(settingsStrings[eventTraceFilename].c_str()))
+        std::atexit([] { EventTrace::stop(); });
+#endif
 #endif
 
     // Start airtime logger thread.
@@ -1417,6 +1502,21 @@ void setup()
         RECORD_CRITICALERROR(meshtastic_CriticalErrorCode_NO_RADIO);
     else {
         router->addInterface(rIf);
+#ifdef ARCH_PORTDUINO
+        if (rIf2)
+            router->addInterface(rIf2);
+#endif
+#if !MESHTASTIC_EXCLUDE_GPS && LR11X0_GNSS
+        // Trackers without a GPS, or choosing to save its power, can still have positions from the radio
+        if (!gps && config.device.role != meshtastic_Config_DeviceConfig_Role_REPEATER &&
+            config.position.gps_mode != meshtastic_Config_PositionConfig_GpsMode_NOT_PRESENT) {
+            radioGnss = new RadioGnss(rIf);
+            gpsStatus->observe(&radioGnss->newStatus);
+        }
+#endif
+#if RADIO_OWN_THREAD
+        concurrency::startRadioTask();
+#endif
 
         // Log bit rate to debug output
         LOG_DEBUG("LoRA bitrate = %f bytes / sec", (float(meshtastic_Constants_DATA_PAYLOAD_LEN) /
@@ -1523,6 +1623,9 @@ void scannerToSensorsMap(const std::unique_ptr<ScanI2CTwoWire> &i2cScanner, Scan
 #ifndef PIO_UNIT_TESTING
 void loop()
 {
+#if OSTHREAD_HEAP_SCHEDULER
+    bool wokeEarly = runASAP; // someone may have changed a thread's schedule, let the scheduler resync
+#endif
     runASAP = false;
 
 #ifdef ARCH_ESP32
@@ -1543,10 +1646,18 @@ void loop()
 
     service->loop();
 
+#if OSTHREAD_HEAP_SCHEDULER
+    long delayMsec = concurrency::OSThread::runDue(wokeEarly);
+#else
     long delayMsec = mainController.runOrDelay();
+#endif
 
     // We want to sleep as long as possible here - because it saves power
     if (!runASAP && loopCanSleep()) {
+#if POWER_NB_LIGHT_SLEEP && defined(ARCH_ESP32) && !MESHTASTIC_EXCLUDE_POWER_FSM
+        if (PowerFSM_idleSleep(delayMsec))
+            return;
+#endif
         mainDelay.delay(delayMsec);
     }
 }
@@ -9,6 +9,9 @@
  */
 #include "memGet.h"
 #include "configuration.h"
+#if PSRAM_PLACEMENT && defined(ARCH_ESP32)
+#include <esp_heap_caps.h>
+#endif
 
 MemGet memGet;
 
@@ -48,6 +51,32 @@ uint32_t MemGet::getHeapSize()
 #endif
 }
 
+/**
+ * Returns the least free heap there has been since boot, in bytes.
+ * @return uint32_t The low water mark, or UINT32_MAX if the platform doesn't track it.
+ */
+uint32_t MemGet::getMinFreeHeap()
+{
+#ifdef ARCH_ESP32
+    return ESP.getMinFreeHeap();
+#else
+    return UINT32_MAX;
+#endif
+}
+
+/**
+ * Returns the largest block that could be allocated right now, which with getFreeHeap() shows how fragmented the heap is.
+ * @return uint32_t The largest free block in bytes, or UINT32_MAX if the platform can't tell.
+ */
+uint32_t MemGet::getLargestFreeBlock()
+{
+#ifdef ARCH_ESP32
+    return ESP.getMaxAllocHeap();
+#else
+    return UINT32_MAX;
+#endif
+}
+
 /**
  * Returns the amount of free psram memory in bytes.
  *
@@ -78,4 +107,19 @@ uint32_t MemGet::getPsramSize()
 #else
     return 0;
 #endif
-}
\ No newline at end of file
+}
+
+/**
+ * Allocates size bytes for data no ISR looks at: in PSRAM with PSRAM_PLACEMENT, falling back to internal RAM if there is no
+ * PSRAM or it is full.
+ * @return NULL if there is no memory at all
+ */
+void *MemGet::allocCold(size_t size)
+{
+#if PSRAM_PLACEMENT && defined(ARCH_ESP32)
+    void *p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (p)
+        return p;
+#endif
+    return malloc(size);
+}
@@ -4,13 +4,29 @@
 
 #include <Arduino.h>
 
+/**
+ * On ESP32 boards with PSRAM, put big buffers that are never touched from an interrupt (the phone API objects with their
+ * FromRadio scratch and stream buffers, the MQTT queue, e-ink ghosting bitmaps, the web server's file chunk buffer) in PSRAM,
+ * see MemGet::allocCold().  The ESP32 heap only moves allocations of 4 KB and more there by itself, these are smaller and there
+ * are several of them.  Frees internal RAM for the WiFi and Bluetooth stacks.
+ */
+#ifndef PSRAM_PLACEMENT
+#define PSRAM_PLACEMENT 0
+#endif
+
 class MemGet
 {
   public:
     uint32_t getFreeHeap();
     uint32_t getHeapSize();
+    uint32_t getMinFreeHeap();
+    uint32_t getLargestFreeBlock();
     uint32_t getFreePsram();
     uint32_t getPsramSize();
+
+    /// Allocate a buffer that is only used from task context, in PSRAM with PSRAM_PLACEMENT if there is some, else like malloc()
+    /// Release it with free()
+    void *allocCold(size_t size);
 };
 
 extern MemGet memGet;
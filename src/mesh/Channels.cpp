@@ -293,7 +293,14 @@ void Channels::onConfigChanged()
         if (ch.role == meshtastic_Channel_Role_PRIMARY)
             primaryIndex = i;
     }
+    rebuildHashOrder();
+
+    // Keys may have changed, don't keep using stale AES key schedules
+    if (crypto)
+        crypto->invalidateKeyCache();
 #if !MESHTASTIC_EXCLUDE_MQTT
+    if (mqtt)
+        mqtt->onChannelsChanged();
     if (channels.anyMqttEnabled() && mqtt && !mqtt->isEnabled()) {
         LOG_DEBUG("MQTT is enabled on at least one channel, so set MQTT thread to run immediately");
         mqtt->start();
@@ -422,6 +429,70 @@ bool Channels::decryptForHash(ChannelIndex chIndex, ChannelHash channelHash)
     }
 }
 
+void Channels::rebuildHashOrder()
+{
+    hashOrderCount = 0;
+    memset(decodeHits, 0, sizeof(decodeHits));
+    for (ChannelIndex i = 0; i < getNumChannels() && i < MAX_NUM_CHANNELS; i++) {
+        if (getHash(i) < 0)
+            continue;
+        // Insertion sort by hash, channels with equal hashes keep index order until they earn hits
+        uint8_t pos = hashOrderCount++;
+        while (pos > 0 && getHash(hashOrder[pos - 1]) > getHash(i)) {
+            hashOrder[pos] = hashOrder[pos - 1];
+            pos--;
+        }
+        hashOrder[pos] = i;
+    }
+}
+
+uint8_t Channels::getCandidatesForHash(ChannelHash channelHash, ChannelIndex *candidates)
+{
+    uint8_t n = 0;
+    decodeStats.lookups++;
+    for (uint8_t i = 0; i < hashOrderCount; i++) {
+        int16_t h = getHash(hashOrder[i]);
+        if (h == channelHash)
+            candidates[n++] = hashOrder[i];
+        else if (h > channelHash)
+            break; // sorted by hash, nothing further can match
+    }
+    return n;
+}
+
+void Channels::noteDecodeAttempt(ChannelIndex chIndex, bool success)
+{
+    decodeStats.attempts++;
+    if (!success) {
+        decodeStats.failedAttempts++;
+        return;
+    }
+    if (chIndex >= MAX_NUM_CHANNELS)
+        return;
+
+    if (decodeHits[chIndex] == UINT16_MAX) {
+        // Halve all counts rather than saturate, so the ordering keeps tracking recent traffic
+        for (size_t i = 0; i < MAX_NUM_CHANNELS; i++)
+            decodeHits[i] >>= 1;
+    }
+    decodeHits[chIndex]++;
+
+    // Bubble this channel ahead of any channel with the same hash that has fewer hits
+    for (uint8_t i = 1; i < hashOrderCount; i++) {
+        if (hashOrder[i] != chIndex)
+            continue;
+        while (i > 0 && getHash(hashOrder[i - 1]) == getHash(chIndex) && decodeHits[hashOrder[i - 1]] < decodeHits[chIndex]) {
+            hashOrder[i] = hashOrder[i - 1];
+            hashOrder[--i] = chIndex;
+        }
+        break;
+    }
+
+    if (decodeStats.failedAttempts && (decodeStats.attempts % 100) == 0)
+        LOG_DEBUG("Channel decode stats: %u lookups, %u trial decrypts, %u wasted", decodeStats.lookups, decodeStats.attempts,
+                  decodeStats.failedAttempts);
+}
+
 /** Given a channel index setup crypto for encoding that channel (or the primary channel if that channel is unsecured)
  *
  * This method is called before encoding outbound packets
@@ -28,7 +28,21 @@ class Channels
     /// the precomputed hashes for each of our channels, or -1 for invalid
     int16_t hashes[MAX_NUM_CHANNELS] = {};
 
+    /// The channels with a valid hash, grouped by hash and within a group ordered by recent decode hits (best first)
+    ChannelIndex hashOrder[MAX_NUM_CHANNELS] = {};
+    uint8_t hashOrderCount = 0;
+
+    /// Recent successful decodes per channel, decayed so the ordering follows current traffic
+    uint16_t decodeHits[MAX_NUM_CHANNELS] = {};
+
   public:
+    /// Counters for inbound channel decoding, so wasted trial decrypts can be observed
+    struct DecodeStats {
+        uint32_t lookups;        // packets we tried to match against our channels
+        uint32_t attempts;       // trial decrypts performed
+        uint32_t failedAttempts; // trial decrypts that did not yield a valid protobuf (wasted work)
+    };
+
     Channels() {}
 
     /// Well known channel names
@@ -75,6 +89,18 @@ class Channels
      */
     bool decryptForHash(ChannelIndex chIndex, ChannelHash channelHash);
 
+    /** Find the channels that could have produced a packet with this channel hash
+     *
+     * @param candidates filled with up to MAX_NUM_CHANNELS channel indexes, the channel most likely to decode first
+     * @return the number of candidates
+     */
+    uint8_t getCandidatesForHash(ChannelHash channelHash, ChannelIndex *candidates);
+
+    /// Record the outcome of a trial decrypt on chIndex, successful channels move ahead of others sharing their hash
+    void noteDecodeAttempt(ChannelIndex chIndex, bool success);
+
+    const DecodeStats &getDecodeStats() const { return decodeStats; }
+
     /** Given a channel index setup crypto for encoding that channel (or the primary channel if that channel is unsecured)
      *
      * This method is called before encoding outbound packets
@@ -95,6 +121,11 @@ class Channels
     bool ensureLicensedOperation();
 
   private:
+    DecodeStats decodeStats = {};
+
+    /// Rebuild hashOrder from the current channel hashes, called when the channel config changes
+    void rebuildHashOrder();
+
     /** Given a channel index, change to use the crypto key specified by that index
      *
      * @eturn the (0 to 255) hash for that channel - if no suitable channel could be found, return -1
@@ -1,4 +1,5 @@
 #include "CryptoEngine.h"
+#include "EventTrace.h"
 // #include "NodeDB.h"
 #include "architecture.h"
 
@@ -33,6 +34,7 @@ void CryptoEngine::generateKeyPair(uint8_t *pubKey, uint8_t *privKey)
 
     LOG_DEBUG("Generate Curve25519 keypair");
     Curve25519::dh1(public_key, private_key);
+    clearSharedKeyCache();
     memcpy(pubKey, public_key, sizeof(public_key));
     memcpy(privKey, private_key, sizeof(private_key));
 }
@@ -54,6 +56,7 @@ bool CryptoEngine::regeneratePublicKey(uint8_t *pubKey, uint8_t *privKey)
         }
         memcpy(private_key, privKey, sizeof(private_key));
         memcpy(public_key, pubKey, sizeof(public_key));
+        clearSharedKeyCache();
     } else {
         LOG_WARN("X25519 key generation failed due to blank private key");
         return false;
@@ -65,6 +68,43 @@ void CryptoEngine::clearKeys()
 {
     memset(public_key, 0, sizeof(public_key));
     memset(private_key, 0, sizeof(private_key));
+    clearSharedKeyCache();
+}
+
+void CryptoEngine::clearSharedKeyCache()
+{
+    memset(sharedKeyCache, 0, sizeof(sharedKeyCache));
+    memset(shared_key, 0, sizeof(shared_key));
+    sharedKeyClock = 0;
+}
+
+bool CryptoEngine::deriveSharedKey(const uint8_t *remotePublic)
+{
+    SharedKeyCacheEntry *victim = &sharedKeyCache[0];
+    if (++sharedKeyClock == 0)
+        sharedKeyClock = 1; // 0 is reserved for unused entries
+    for (int i = 0; i < PKI_SHARED_KEY_CACHE_SIZE; i++) {
+        SharedKeyCacheEntry &e = sharedKeyCache[i];
+        if (e.lastUse && memcmp(e.remotePublic, remotePublic, sizeof(e.remotePublic)) == 0) {
+            e.lastUse = sharedKeyClock;
+            memcpy(shared_key, e.sharedKey, sizeof(shared_key));
+            return true;
+        }
+        if (victim->lastUse && (!e.lastUse || sharedKeyClock - e.lastUse > sharedKeyClock - victim->lastUse))
+            victim = &e;
+    }
+
+    uint8_t pub[32];
+    memcpy(pub, remotePublic, sizeof(pub)); // setDHPublicKey takes a mutable buffer
+    if (!crypto->setDHPublicKey(pub)) {
+        return false;
+    }
+    crypto->hash(shared_key, 32);
+
+    memcpy(victim->remotePublic, remotePublic, sizeof(victim->remotePublic));
+    memcpy(victim->sharedKey, shared_key, sizeof(victim->sharedKey));
+    victim->lastUse = sharedKeyClock;
+    return true;
 }
 
 /**
@@ -82,6 +122,7 @@ void CryptoEngine::clearKeys()
 bool CryptoEngine::encryptCurve25519(uint32_t toNode, uint32_t fromNode, meshtastic_UserLite_public_key_t remotePublic,
                                      uint64_t packetNum, size_t numBytes, const uint8_t *bytes, uint8_t *bytesOut)
 {
+    TRACE_SCOPE("CryptoEngine::encryptCurve25519");
     uint8_t *auth;
     long extraNonceTmp = random();
     auth = bytesOut + numBytes;
@@ -92,10 +133,9 @@ bool CryptoEngine::encryptCurve25519(uint32_t toNode, uint32_t fromNode, meshtas
         LOG_DEBUG("Node %d or their public_key not found", toNode);
         return false;
     }
-    if (!crypto->setDHPublicKey(remotePublic.bytes)) {
+    if (!deriveSharedKey(remotePublic.bytes)) {
         return false;
     }
-    crypto->hash(shared_key, 32);
     initNonce(fromNode, packetNum, extraNonceTmp);
 
     // Calculate the shared secret with the destination node and encrypt
@@ -122,6 +162,7 @@ bool CryptoEngine::encryptCurve25519(uint32_t toNode, uint32_t fromNode, meshtas
 bool CryptoEngine::decryptCurve25519(uint32_t fromNode, meshtastic_UserLite_public_key_t remotePublic, uint64_t packetNum,
                                      size_t numBytes, const uint8_t *bytes, uint8_t *bytesOut)
 {
+    TRACE_SCOPE("CryptoEngine::decryptCurve25519");
     const uint8_t *auth = bytes + numBytes - 12; // set to last 8 bytes of text?
     uint32_t extraNonce;                         // pointer was not really used
     memcpy(&extraNonce, auth + 8,
@@ -134,10 +175,9 @@ bool CryptoEngine::decryptCurve25519(uint32_t fromNode, meshtastic_UserLite_publ
     }
 
     // Calculate the shared secret with the sending node and decrypt
-    if (!crypto->setDHPublicKey(remotePublic.bytes)) {
+    if (!deriveSharedKey(remotePublic.bytes)) {
         return false;
     }
-    crypto->hash(shared_key, 32);
 
     initNonce(fromNode, packetNum, extraNonce);
     printBytes("Attempt decrypt with nonce: ", nonce, 13);
@@ -147,6 +187,8 @@ bool CryptoEngine::decryptCurve25519(uint32_t fromNode, meshtastic_UserLite_publ
 
 void CryptoEngine::setDHPrivateKey(uint8_t *_private_key)
 {
+    if (memcmp(private_key, _private_key, 32) != 0)
+        clearSharedKeyCache();
     memcpy(private_key, _private_key, 32);
 }
 
@@ -187,6 +229,89 @@ void CryptoEngine::aesEncrypt(uint8_t *in, uint8_t *out)
     aes->encryptBlock(out, in);
 }
 
+bool CryptoEngine::aesSelfTest()
+{
+    // FIPS-197 appendix C.3 and RFC 3686 test vector #7
+    static const uint8_t ecbKey[32] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a,
+                                       0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15,
+                                       0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f};
+    static const uint8_t ecbPlain[16] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                                         0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff};
+    static const uint8_t ecbExpected[16] = {0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf,
+                                            0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89};
+    static const uint8_t ctrKey[32] = {0x77, 0x6b, 0xef, 0xf2, 0x85, 0x1d, 0xb0, 0x6f, 0x4c, 0x8a, 0x05,
+                                       0x42, 0xc8, 0x69, 0x6f, 0x6c, 0x6a, 0x81, 0xaf, 0x1e, 0xec, 0x96,
+                                       0xb4, 0xd3, 0x7f, 0xc1, 0xd6, 0x89, 0xe6, 0xc1, 0xc1, 0x04};
+    static const uint8_t ctrNonce[16] = {0x00, 0x00, 0x00, 0x60, 0xdb, 0x56, 0x72, 0xc9,
+                                         0x7a, 0xa8, 0xf0, 0xb2, 0x00, 0x00, 0x00, 0x01};
+    static const uint8_t ctrExpected[16] = {0x14, 0x5a, 0xd0, 0x1d, 0xbf, 0x82, 0x4e, 0xc7,
+                                            0x56, 0x08, 0x63, 0xdc, 0x71, 0xe3, 0xe0, 0xc0};
+
+    uint8_t block[16];
+    memcpy(block, ecbPlain, sizeof(block));
+    aesSetKey(ecbKey, sizeof(ecbKey));
+    aesEncrypt(block, block);
+    bool ok = memcmp(block, ecbExpected, sizeof(block)) == 0;
+    aesSetKey(NULL, 0);
+
+    CryptoKey k;
+    memcpy(k.bytes, ctrKey, sizeof(ctrKey));
+    k.length = sizeof(ctrKey);
+    uint8_t nonceCopy[16];
+    memcpy(nonceCopy, ctrNonce, sizeof(nonceCopy));
+    memcpy(block, "Single block msg", sizeof(block));
+    encryptAESCtr(k, nonceCopy, sizeof(block), block);
+    ok = ok && memcmp(block, ctrExpected, sizeof(block)) == 0;
+    invalidateKeyCache(); // don't leave the test key in the schedule cache
+
+    if (!ok)
+        LOG_ERROR("AES self test failed!");
+    return ok;
+}
+
+void CryptoEngine::aesBenchmark()
+{
+    const int iterations = 64;
+    uint8_t key_bytes[32], buf[MAX_BLOCKSIZE], nonceCopy[16];
+    for (size_t i = 0; i < sizeof(key_bytes); i++)
+        key_bytes[i] = i;
+    memset(buf, 0x5a, sizeof(buf));
+
+    // Qualified calls always run the portable software implementation, virtual calls whatever this platform provides
+    uint32_t start = benchmarkTicks();
+    CryptoEngine::aesSetKey(key_bytes, sizeof(key_bytes));
+    for (int i = 0; i < iterations; i++)
+        CryptoEngine::aesEncrypt(buf, buf);
+    uint32_t swBlock = benchmarkTicks() - start;
+
+    start = benchmarkTicks();
+    aesSetKey(key_bytes, sizeof(key_bytes));
+    for (int i = 0; i < iterations; i++)
+        aesEncrypt(buf, buf);
+    uint32_t hwBlock = benchmarkTicks() - start;
+    aesSetKey(NULL, 0);
+
+    CryptoKey k;
+    memcpy(k.bytes, key_bytes, sizeof(key_bytes));
+    k.length = sizeof(key_bytes);
+    memset(nonceCopy, 0, sizeof(nonceCopy));
+    invalidateKeyCache();
+    start = benchmarkTicks();
+    for (int i = 0; i < iterations; i++)
+        CryptoEngine::encryptAESCtr(k, nonceCopy, MAX_BLOCKSIZE, buf, buf);
+    uint32_t swCtr = benchmarkTicks() - start;
+
+    invalidateKeyCache();
+    start = benchmarkTicks();
+    for (int i = 0; i < iterations; i++)
+        encryptAESCtr(k, nonceCopy, MAX_BLOCKSIZE, buf);
+    uint32_t hwCtr = benchmarkTicks() - start;
+    invalidateKeyCache();
+
+    LOG_INFO("AES256 benchmark (%d runs, ticks): block sw=%u platform=%u, ctr %d bytes sw=%u platform=%u", iterations, swBlock,
+             hwBlock, MAX_BLOCKSIZE, swCtr, hwCtr);
+}
+
 bool CryptoEngine::setDHPublicKey(uint8_t *pubKey)
 {
     uint8_t local_priv[32];
@@ -217,7 +342,12 @@ void CryptoEngine::setKey(const CryptoKey &k)
  */
 void CryptoEngine::encryptPacket(uint32_t fromNode, uint64_t packetId, size_t numBytes, uint8_t *bytes)
 {
+    TRACE_SCOPE("CryptoEngine::encryptPacket");
     if (key.length > 0) {
+#if CRYPTO_KEYSTREAM_PRECOMPUTE
+        if (applyKeystream(fromNode, packetId, numBytes, bytes, bytes))
+            return;
+#endif
         initNonce(fromNode, packetId);
         if (numBytes <= MAX_BLOCKSIZE) {
             encryptAESCtr(key, nonce, numBytes, bytes);
@@ -227,30 +357,139 @@ void CryptoEngine::encryptPacket(uint32_t fromNode, uint64_t packetId, size_t nu
     }
 }
 
+void CryptoEngine::encryptPacketTo(uint32_t fromNode, uint64_t packetId, size_t numBytes, const uint8_t *in, uint8_t *out)
+{
+    TRACE_SCOPE("CryptoEngine::encryptPacketTo");
+    if (key.length == 0) {
+        if (out != in)
+            memcpy(out, in, numBytes);
+        return;
+    }
+#if CRYPTO_KEYSTREAM_PRECOMPUTE
+    if (applyKeystream(fromNode, packetId, numBytes, in, out))
+        return;
+#endif
+    initNonce(fromNode, packetId);
+    if (numBytes <= MAX_BLOCKSIZE) {
+        encryptAESCtr(key, nonce, numBytes, in, out);
+    } else {
+        LOG_ERROR("Packet too large for crypto engine: %d. noop encryption!", numBytes);
+        if (out != in)
+            memcpy(out, in, numBytes);
+    }
+}
+
 void CryptoEngine::decrypt(uint32_t fromNode, uint64_t packetId, size_t numBytes, uint8_t *bytes)
 {
     // For CTR, the implementation is the same
     encryptPacket(fromNode, packetId, numBytes, bytes);
 }
 
-// Generic implementation of AES-CTR encryption.
-void CryptoEngine::encryptAESCtr(CryptoKey _key, uint8_t *_nonce, size_t numBytes, uint8_t *bytes)
+int CryptoEngine::findKeySlot(const CryptoKey &k, bool &isNew)
+{
+    int victim = 0;
+    keyCacheClock++;
+    for (int i = 0; i < CRYPTO_KEY_CACHE_SIZE; i++) {
+        if (cachedKeys[i].length == k.length && memcmp(cachedKeys[i].bytes, k.bytes, k.length) == 0) {
+            cachedKeyLastUse[i] = keyCacheClock;
+            isNew = false;
+            return i;
+        }
+        // Prefer an unused slot, otherwise the one that has gone unused the longest
+        if (cachedKeys[victim].length != 0 &&
+            (cachedKeys[i].length == 0 || keyCacheClock - cachedKeyLastUse[i] > keyCacheClock - cachedKeyLastUse[victim]))
+            victim = i;
+    }
+
+    cachedKeys[victim] = k;
+    cachedKeyLastUse[victim] = keyCacheClock;
+    isNew = true;
+    return victim;
+}
+
+void CryptoEngine::invalidateKeyCache()
+{
+    for (int i = 0; i < CRYPTO_KEY_CACHE_SIZE; i++) {
+        if (ctrCache[i])
+            ctrCache[i]->clear();
+        delete ctrCache[i];
+        ctrCache[i] = NULL;
+    }
+    memset(cachedKeys, 0, sizeof(cachedKeys));
+    memset(cachedKeyLastUse, 0, sizeof(cachedKeyLastUse));
+#if CRYPTO_KEYSTREAM_PRECOMPUTE
+    memset(keystreams, 0, sizeof(keystreams)); // worked out with keys that may be gone now
+#endif
+}
+
+#if CRYPTO_KEYSTREAM_PRECOMPUTE
+void CryptoEngine::precomputeKeystream(const CryptoKey &k, uint32_t fromNode, uint64_t packetId)
 {
-    delete ctr;
-    ctr = nullptr;
-    if (_key.length == 16)
-        ctr = new CTR<AES128>();
-    else
-        ctr = new CTR<AES256>();
-    ctr->setKey(_key.bytes, _key.length);
-    static uint8_t scratch[MAX_BLOCKSIZE];
-    memcpy(scratch, bytes, numBytes);
-    memset(scratch + numBytes, 0,
-           sizeof(scratch) - numBytes); // Fill rest of buffer with zero (in case cypher looks at it)
+    TRACE_SCOPE("CryptoEngine::precomputeKeystream");
+    if (k.length <= 0)
+        return;
 
+    Keystream *victim = &keystreams[0];
+    for (Keystream &s : keystreams) {
+        if (s.key.length == 0) {
+            victim = &s;
+            break;
+        }
+        if (keystreamClock - s.made > keystreamClock - victim->made)
+            victim = &s;
+    }
+
+    // CTR encrypting zeros leaves the keystream itself
+    memset(victim->bytes, 0, sizeof(victim->bytes));
+    initNonce(fromNode, packetId);
+    encryptAESCtr(k, nonce, sizeof(victim->bytes), victim->bytes);
+    victim->key = k;
+    victim->fromNode = fromNode;
+    victim->packetId = packetId;
+    victim->made = ++keystreamClock;
+}
+
+bool CryptoEngine::applyKeystream(uint32_t fromNode, uint64_t packetId, size_t numBytes, const uint8_t *in, uint8_t *out)
+{
+    if (numBytes > MAX_BLOCKSIZE)
+        return false;
+    for (Keystream &s : keystreams) {
+        if (s.key.length != key.length || s.packetId != packetId || s.fromNode != fromNode ||
+            memcmp(s.key.bytes, key.bytes, key.length) != 0)
+            continue;
+        for (size_t i = 0; i < numBytes; i++)
+            out[i] = in[i] ^ s.bytes[i];
+        memset(&s, 0, sizeof(s)); // a keystream is never used twice
+        return true;
+    }
+    return false;
+}
+#endif
+
+// Generic implementation of AES-CTR encryption.
+void CryptoEngine::encryptAESCtr(CryptoKey _key, uint8_t *_nonce, size_t numBytes, const uint8_t *in, uint8_t *out)
+{
+    bool isNew;
+    int slot = findKeySlot(_key, isNew);
+    CTRCommon *ctr = ctrCache[slot];
+    if (isNew || !ctr) {
+        // Only expand the key schedule when this key was not cached, the cipher type has to follow the key length
+        if (ctr && ctr->keySize() != (size_t)_key.length) {
+            delete ctr;
+            ctr = NULL;
+        }
+        if (!ctr) {
+            if (_key.length == 16)
+                ctr = new CTR<AES128>();
+            else
+                ctr = new CTR<AES256>();
+            ctrCache[slot] = ctr;
+        }
+        ctr->setKey(_key.bytes, _key.length);
+    }
     ctr->setIV(_nonce, 16);
     ctr->setCounterSize(4);
-    ctr->encrypt(bytes, scratch, numBytes);
+    ctr->encrypt(out, in, numBytes); // CTR only xors the keystream in, so this is safe in place
 }
 
 /**
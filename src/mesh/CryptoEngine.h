@@ -21,6 +21,26 @@ struct CryptoKey {
  */
 
 #define MAX_BLOCKSIZE 256
+
+/// How many Curve25519 derived shared keys we remember, each one saves a scalar multiplication per DM with that peer
+#ifndef PKI_SHARED_KEY_CACHE_SIZE
+#define PKI_SHARED_KEY_CACHE_SIZE 8
+#endif
+
+/// How many expanded AES key schedules we keep around, one per channel key in regular use is plenty
+#ifndef CRYPTO_KEY_CACHE_SIZE
+#define CRYPTO_KEY_CACHE_SIZE 4
+#endif
+/// Work out the channel keystream for our next few packet ids while idle, so sending only has to XOR it in (see
+/// Router::precomputeKeystreams)
+#ifndef CRYPTO_KEYSTREAM_PRECOMPUTE
+#define CRYPTO_KEYSTREAM_PRECOMPUTE 0
+#endif
+
+/// Packet ids kept ready with their keystreams, each costs MAX_BLOCKSIZE bytes of RAM
+#ifndef CRYPTO_KEYSTREAM_SLOTS
+#define CRYPTO_KEYSTREAM_SLOTS 4
+#endif
 #define TEST_CURVE25519_FIELD_OPS // Exposes Curve25519::isWeakPoint() for testing keys
 
 class CryptoEngine
@@ -51,6 +71,19 @@ class CryptoEngine
     virtual void aesEncrypt(uint8_t *in, uint8_t *out);
     AESSmall256 *aes = NULL;
 
+    /**
+     * Run AES known answer tests (ECB block and CTR) against whichever backend this engine uses.
+     *
+     * @return true if every vector matched
+     */
+    bool aesSelfTest();
+
+    /// Log how many benchmarkTicks() the software and the platform AES block and CTR paths take, for comparing backends
+    void aesBenchmark();
+
+    /// A free running counter for aesBenchmark, platforms with a CPU cycle counter override this
+    virtual uint32_t benchmarkTicks() { return micros(); }
+
 #endif
 
     /**
@@ -70,18 +103,93 @@ class CryptoEngine
      * @param bytes is updated in place
      */
     virtual void encryptPacket(uint32_t fromNode, uint64_t packetId, size_t numBytes, uint8_t *bytes);
+
+    /// Like encryptPacket(), but reads the plaintext from in and writes the ciphertext to out, so nothing has to be copied
+    /// into place first.  in and out may be the same buffer, but must not otherwise overlap
+    void encryptPacketTo(uint32_t fromNode, uint64_t packetId, size_t numBytes, const uint8_t *in, uint8_t *out);
+
     virtual void decrypt(uint32_t fromNode, uint64_t packetId, size_t numBytes, uint8_t *bytes);
-    virtual void encryptAESCtr(CryptoKey key, uint8_t *nonce, size_t numBytes, uint8_t *bytes);
+    void encryptAESCtr(CryptoKey key, uint8_t *nonce, size_t numBytes, uint8_t *bytes)
+    {
+        encryptAESCtr(key, nonce, numBytes, bytes, bytes);
+    }
+    virtual void encryptAESCtr(CryptoKey key, uint8_t *nonce, size_t numBytes, const uint8_t *in, uint8_t *out);
+
+    /**
+     * Forget (and wipe) all cached AES key schedules.
+     *
+     * Must be called whenever the channel keys may have changed, so a stale schedule is never used.
+     */
+    virtual void invalidateKeyCache();
+
+#if CRYPTO_KEYSTREAM_PRECOMPUTE
+    /**
+     * Work out the AES-CTR keystream a packet (fromNode, packetId) sent with key k will use, so encrypting it later is only
+     * an XOR.  Takes the place of the oldest keystream not used yet.
+     */
+    void precomputeKeystream(const CryptoKey &k, uint32_t fromNode, uint64_t packetId);
+#endif
 #ifndef PIO_UNIT_TESTING
   protected:
 #endif
     /** Our per packet nonce */
     uint8_t nonce[16] = {0};
     CryptoKey key = {};
-    CTRCommon *ctr = NULL;
+
+    /** The keys whose expanded schedules are currently cached, a length of 0 marks an unused slot */
+    CryptoKey cachedKeys[CRYPTO_KEY_CACHE_SIZE] = {};
+    uint32_t cachedKeyLastUse[CRYPTO_KEY_CACHE_SIZE] = {};
+    uint32_t keyCacheClock = 0;
+
+    /** The generic AES-CTR contexts, one per cache slot and created on first use */
+    CTRCommon *ctrCache[CRYPTO_KEY_CACHE_SIZE] = {};
+
+    /**
+     * Find the cache slot holding the schedule for k.  On a miss the least recently used slot is handed over to k and isNew is
+     * set, in which case the caller must (re)run its key setup for that slot.
+     */
+    int findKeySlot(const CryptoKey &k, bool &isNew);
+
+#if CRYPTO_KEYSTREAM_PRECOMPUTE
+    struct Keystream {
+        CryptoKey key; // a length of 0 marks an unused slot
+        uint32_t fromNode;
+        uint64_t packetId;
+        uint32_t made; // keystreamClock when it was worked out
+        uint8_t bytes[MAX_BLOCKSIZE];
+    };
+    Keystream keystreams[CRYPTO_KEYSTREAM_SLOTS] = {};
+    uint32_t keystreamClock = 0;
+
+    /**
+     * If the keystream for (key, fromNode, packetId) was worked out ahead, XOR it over in and free its slot
+     *
+     * @return false if it wasn't, the caller encrypts as usual
+     */
+    bool applyKeystream(uint32_t fromNode, uint64_t packetId, size_t numBytes, const uint8_t *in, uint8_t *out);
+#endif
 #if !(MESHTASTIC_EXCLUDE_PKI)
     uint8_t shared_key[32] = {0};
     uint8_t private_key[32] = {0};
+
+    /// A derived (hashed) shared key for one remote public key, only ever held in RAM
+    struct SharedKeyCacheEntry {
+        uint8_t remotePublic[32];
+        uint8_t sharedKey[32];
+        uint32_t lastUse; // 0 for an unused entry
+    };
+    SharedKeyCacheEntry sharedKeyCache[PKI_SHARED_KEY_CACHE_SIZE] = {};
+    uint32_t sharedKeyClock = 0;
+
+    /**
+     * Set shared_key to the hashed Curve25519 shared secret for remotePublic, from the cache if we talked to this peer recently
+     *
+     * @return false if the key exchange failed
+     */
+    bool deriveSharedKey(const uint8_t *remotePublic);
+
+    /// Wipe all cached shared keys, must be called whenever our private key changes
+    void clearSharedKeyCache();
 #endif
     /**
      * Init our 128 bit nonce for a new packet
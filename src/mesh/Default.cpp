@@ -1,5 +1,6 @@
 #include "Default.h"
 
+#include "airtime.h"
 #include "meshUtils.h"
 
 uint32_t Default::getConfiguredOrDefaultMs(uint32_t configuredInterval, uint32_t defaultInterval)
@@ -23,7 +24,8 @@ uint32_t Default::getConfiguredOrDefault(uint32_t configured, uint32_t defaultVa
     return defaultValue;
 }
 /**
- * Calculates the scaled value of the configured or default value in ms based on the number of online nodes.
+ * Calculates the scaled value of the configured or default value in ms based on the number of online nodes, or with
+ * CONGESTION_AIRTIME_SCALING on the measured channel utilization and port's own airtime.
  *
  * For example a default of 30 minutes (1800 seconds * 1000) would yield:
  *   45 nodes = 2475 * 1000
@@ -33,9 +35,11 @@ uint32_t Default::getConfiguredOrDefault(uint32_t configured, uint32_t defaultVa
  * @param configured The configured value.
  * @param defaultValue The default value.
  * @param numOnlineNodes The number of online nodes.
+ * @param port The port the broadcasts go out on.
  * @return The scaled value of the configured or default value.
  */
-uint32_t Default::getConfiguredOrDefaultMsScaled(uint32_t configured, uint32_t defaultValue, uint32_t numOnlineNodes)
+uint32_t Default::getConfiguredOrDefaultMsScaled(uint32_t configured, uint32_t defaultValue, uint32_t numOnlineNodes,
+                                                 meshtastic_PortNum port)
 {
     // If we are a router, we don't scale the value. It's already significantly higher.
     if (config.device.role == meshtastic_Config_DeviceConfig_Role_ROUTER)
@@ -45,6 +49,10 @@ uint32_t Default::getConfiguredOrDefaultMsScaled(uint32_t configured, uint32_t d
     if (IS_ONE_OF(config.device.role, meshtastic_Config_DeviceConfig_Role_SENSOR, meshtastic_Config_DeviceConfig_Role_TRACKER))
         return getConfiguredOrDefaultMs(configured, defaultValue);
 
+#if CONGESTION_AIRTIME_SCALING
+    if (airTime)
+        return getConfiguredOrDefaultMs(configured, defaultValue) * airTime->congestionScale(port);
+#endif
     return getConfiguredOrDefaultMs(configured, defaultValue) * congestionScalingCoefficient(numOnlineNodes);
 }
 
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Finalizer of murmur3, spreads sequential keys (node numbers, packet ids, port numbers) over the whole table
+inline uint32_t flatHashMix32(uint32_t h)
+{
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+/// Default hash for FlatHashMap, works for any key that converts to an integer of up to 32 bits (including plain enums)
+struct FlatHashMixHash {
+    uint32_t operator()(uint32_t k) const { return flatHashMix32(k); }
+};
+
+/**
+ * A fixed capacity hash map stored in a single flat array, so there is no per entry heap allocation and lookups stay within a
+ * few cache lines.
+ *
+ * Uses linear probing with backward-shift deletion (no tombstones).  TableSize must be a power of two, and at most 3/4 of it
+ * is ever filled so probe sequences stay short; inserting beyond that fails and returns NULL.
+ *
+ * K and V must be default constructible and copyable.  Pointers returned by find() and insert() are only valid until the next
+ * insert or erase, and the map must not be modified from inside forEach().
+ */
+template <class K, class V, size_t TableSize, class Hash = FlatHashMixHash> class FlatHashMap
+{
+    static_assert(TableSize >= 4 && (TableSize & (TableSize - 1)) == 0, "FlatHashMap size must be a power of two");
+
+    enum : size_t { MASK = TableSize - 1, MAX_ENTRIES = TableSize - TableSize / 4 };
+
+    K keys[TableSize];
+    V values[TableSize];
+    bool used[TableSize] = {};
+    size_t count = 0;
+
+    size_t home(const K &k) const { return Hash()(k) & MASK; }
+
+    /// @return the slot holding k, or the empty slot where it would go
+    size_t probe(const K &k) const
+    {
+        size_t i = home(k);
+        while (used[i] && !(keys[i] == k))
+            i = (i + 1) & MASK;
+        return i;
+    }
+
+  public:
+    size_t size() const { return count; }
+
+    bool empty() const { return count == 0; }
+
+    bool full() const { return count >= MAX_ENTRIES; }
+
+    /// The most entries this map will hold
+    static size_t capacity() { return MAX_ENTRIES; }
+
+    void clear()
+    {
+        for (size_t i = 0; i < TableSize; i++)
+            used[i] = false;
+        count = 0;
+    }
+
+    /// @return the value for k, or NULL if not present
+    V *find(const K &k)
+    {
+        size_t i = probe(k);
+        return used[i] ? &values[i] : NULL;
+    }
+
+    const V *find(const K &k) const
+    {
+        size_t i = probe(k);
+        return used[i] ? &values[i] : NULL;
+    }
+
+    /// @return the value for k, adding a default constructed one if needed, or NULL if the map is full
+    V *findOrInsert(const K &k)
+    {
+        size_t i = probe(k);
+        if (!used[i]) {
+            if (full())
+                return NULL;
+            used[i] = true;
+            keys[i] = k;
+            values[i] = V();
+            count++;
+        }
+        return &values[i];
+    }
+
+    /// Insert or replace the value for k
+    /// @return the stored value, or NULL if the map is full
+    V *insert(const K &k, const V &v)
+    {
+        V *slot = findOrInsert(k);
+        if (slot)
+            *slot = v;
+        return slot;
+    }
+
+    /// @return true if k was present and has been removed
+    bool erase(const K &k)
+    {
+        size_t hole = probe(k);
+        if (!used[hole])
+            return false;
+
+        for (size_t j = (hole + 1) & MASK; used[j]; j = (j + 1) & MASK) {
+            size_t h = home(keys[j]);
+            // Move j into the hole unless its home slot lies cyclically within (hole, j]
+            bool inRange = (hole <= j) ? (hole < h && h <= j) : (hole < h || h <= j);
+            if (!inRange) {
+                keys[hole] = keys[j];
+                values[hole] = values[j];
+                hole = j;
+            }
+        }
+        used[hole] = false;
+        count--;
+        return true;
+    }
+
+    /// Call f(key, value) for every entry, in no particular order
+    template <class F> void forEach(F f)
+    {
+        for (size_t i = 0; i < TableSize; i++)
+            if (used[i])
+                f(keys[i], values[i]);
+    }
+};
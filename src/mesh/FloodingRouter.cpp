@@ -1,7 +1,10 @@
 #include "FloodingRouter.h"
 
+#include "RadioTask.h"
+#include "airtime.h"
 #include "configuration.h"
 #include "mesh-pb-constants.h"
+#include "meshtastic/telemetry.pb.h"
 
 FloodingRouter::FloodingRouter() {}
 
@@ -24,6 +27,10 @@ bool FloodingRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
     if (wasSeenRecently(p)) { // Note: this will also add a recent packet record
         printPacket("Ignore dupe incoming msg", p);
         rxDupe++;
+#if AIRTIME_SERIES
+        if (airTime)
+            airTime->logDuplicate();
+#endif
 
         /* If the original transmitter is doing retransmissions (hopStart equals hopLimit) for a reliable transmission, e.g., when
         the ACK got lost, we will handle the packet again to make sure it gets an implicit ACK. */
@@ -45,29 +52,111 @@ bool FloodingRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
 
 void FloodingRouter::perhapsCancelDupe(const meshtastic_MeshPacket *p)
 {
-    if (config.device.role != meshtastic_Config_DeviceConfig_Role_ROUTER &&
-        config.device.role != meshtastic_Config_DeviceConfig_Role_REPEATER &&
-        config.device.role != meshtastic_Config_DeviceConfig_Role_ROUTER_LATE) {
+    if (routingRole() != meshtastic_Config_DeviceConfig_Role_ROUTER &&
+        routingRole() != meshtastic_Config_DeviceConfig_Role_REPEATER &&
+        routingRole() != meshtastic_Config_DeviceConfig_Role_ROUTER_LATE) {
         // cancel rebroadcast of this message *if* there was already one, unless we're a router/repeater!
         if (Router::cancelSending(p->from, p->id))
             txRelayCanceled++;
     }
-    if (config.device.role == meshtastic_Config_DeviceConfig_Role_ROUTER_LATE && iface) {
-        iface->clampToLateRebroadcastWindow(getFrom(p), p->id);
+#if RELAY_SUPPRESSION_THRESHOLD
+    else if (shouldSuppressRelay(p)) {
+        if (Router::cancelSending(p->from, p->id)) {
+            LOG_DEBUG("Enough relays overheard, cancel rebroadcast");
+            txRelayCanceled++;
+        }
+        return;
+    }
+#endif
+    if (routingRole() == meshtastic_Config_DeviceConfig_Role_ROUTER_LATE) {
+        RadioLockGuard guard;
+        for (uint8_t i = 0; i < numInterfaces; i++)
+            interfaces[i]->clampToLateRebroadcastWindow(getFrom(p), p->id);
     }
 }
 
-bool FloodingRouter::isRebroadcaster()
+#if RELAY_SUPPRESSION_THRESHOLD
+bool FloodingRouter::shouldSuppressRelay(const meshtastic_MeshPacket *p)
 {
-    return config.device.role != meshtastic_Config_DeviceConfig_Role_CLIENT_MUTE &&
-           config.device.rebroadcast_mode != meshtastic_Config_DeviceConfig_RebroadcastMode_NONE;
+    // wasSeenRecently() already added this dupe's relayer to the history
+    uint8_t relayers = countRelayers(p->id, getFrom(p));
+
+    bool allBetter = false;
+    for (PendingRelay &r : pendingRelays) {
+        if (r.id == p->id && r.from == p->from) {
+            r.allBetter &= p->rx_snr > r.snr;
+            allBetter = r.allBetter;
+            break;
+        }
+    }
+
+    LOG_DEBUG("Dupe from relayer 0x%x, %d relayers so far, all stronger=%d", p->relay_node, relayers, allBetter);
+    return relayers >= RELAY_SUPPRESSION_THRESHOLD || (allBetter && relayers >= 2);
+}
+#endif
+
+bool FloodingRouter::shouldDownsampleRelay(const meshtastic_MeshPacket *p)
+{
+#if RELAY_DOWNSAMPLE
+    if (!isBroadcast(p->to) || p->which_payload_variant != meshtastic_MeshPacket_decoded_tag)
+        return false;
+
+    uint32_t secs = 0;
+    switch (p->decoded.portnum) {
+    case meshtastic_PortNum_TELEMETRY_APP:
+        secs = RELAY_DOWNSAMPLE_TELEMETRY_SECS;
+        break;
+    case meshtastic_PortNum_POSITION_APP:
+        secs = RELAY_DOWNSAMPLE_POSITION_SECS;
+        break;
+    case meshtastic_PortNum_NODEINFO_APP:
+        secs = RELAY_DOWNSAMPLE_NODEINFO_SECS;
+        break;
+    case meshtastic_PortNum_NEIGHBORINFO_APP:
+        secs = RELAY_DOWNSAMPLE_NEIGHBORINFO_SECS;
+        break;
+    default:
+        break;
+    }
+    if (!secs)
+        return false;
+
+    uint16_t key = p->decoded.portnum << 8;
+    if (p->decoded.portnum == meshtastic_PortNum_TELEMETRY_APP) {
+        // Device and environment telemetry share the port, one shouldn't hold back the other
+        meshtastic_Telemetry t = meshtastic_Telemetry_init_zero;
+        if (pb_decode_from_bytes(p->decoded.payload.bytes, p->decoded.payload.size, &meshtastic_Telemetry_msg, &t))
+            key |= t.which_variant;
+    }
+
+    uint32_t now = millis();
+    RelayedBroadcast *slot = &relayedBroadcasts[0]; // the least recently relayed, for a node/port we didn't track yet
+    for (RelayedBroadcast &r : relayedBroadcasts) {
+        if (r.from == getFrom(p) && r.key == key) {
+            if (now - r.lastMs < secs * 1000) {
+                LOG_DEBUG("No rebroadcast: relayed port %d from 0x%x %us ago", p->decoded.portnum, r.from,
+                          (now - r.lastMs) / 1000);
+                txRelayDownsampled++;
+                return true;
+            }
+            r.lastMs = now;
+            return false;
+        }
+        if (now - r.lastMs > now - slot->lastMs)
+            slot = &r;
+    }
+    slot->from = getFrom(p);
+    slot->key = key;
+    slot->lastMs = now;
+#endif
+    return false;
 }
 
 void FloodingRouter::perhapsRebroadcast(const meshtastic_MeshPacket *p)
 {
     if (!isToUs(p) && (p->hop_limit > 0) && !isFromUs(p)) {
         if (p->id != 0) {
-            if (isRebroadcaster()) {
+            if (isRebroadcaster() && !shouldDownsampleRelay(p)) {
                 meshtastic_MeshPacket *tosend = packetPool.allocCopy(*p); // keep a copy because we will be sending it
 
                 tosend->hop_limit--; // bump down the hop count
@@ -80,11 +169,20 @@ void FloodingRouter::perhapsRebroadcast(const meshtastic_MeshPacket *p)
 #endif
                 tosend->next_hop = NO_NEXT_HOP_PREFERENCE; // this should already be the case, but just in case
 
+#if RELAY_SUPPRESSION_THRESHOLD
+                PendingRelay &r = pendingRelays[nextPendingRelay];
+                nextPendingRelay = (nextPendingRelay + 1) % RELAY_SUPPRESSION_TRACKED;
+                r.from = p->from;
+                r.id = p->id;
+                r.snr = p->rx_snr;
+                r.allBetter = true;
+#endif
+
                 LOG_INFO("Rebroadcast received floodmsg");
                 // Note: we are careful to resend using the original senders node id
                 // We are careful not to call our hooked version of send() - because we don't want to check this again
                 Router::send(tosend);
-            } else {
+            } else if (!isRebroadcaster()) {
                 LOG_DEBUG("No rebroadcast: Role = CLIENT_MUTE or Rebroadcast Mode = NONE");
             }
         } else {
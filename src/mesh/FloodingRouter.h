@@ -1,7 +1,38 @@
 #pragma once
 
+#include "NodeDB.h"
 #include "Router.h"
 
+#ifndef RELAY_SUPPRESSION_THRESHOLD
+// Routers and repeaters drop their pending rebroadcast once this many other nodes relayed the packet, 0 to always relay
+#define RELAY_SUPPRESSION_THRESHOLD 0
+#endif
+
+#if RELAY_SUPPRESSION_THRESHOLD > NUM_RELAYERS
+#error "RELAY_SUPPRESSION_THRESHOLD can't be more than the NUM_RELAYERS PacketHistory keeps"
+#endif
+
+#define RELAY_SUPPRESSION_TRACKED 8 // pending rebroadcasts we remember the SNR of
+
+// Relay broadcasts on these ports at most once per this many seconds from each node, 0 relays every one.  The first one is
+// relayed, the ones that follow within the interval are not.  Telemetry is limited per kind (device, environment...).
+#ifndef RELAY_DOWNSAMPLE_TELEMETRY_SECS
+#define RELAY_DOWNSAMPLE_TELEMETRY_SECS 0
+#endif
+#ifndef RELAY_DOWNSAMPLE_POSITION_SECS
+#define RELAY_DOWNSAMPLE_POSITION_SECS 0
+#endif
+#ifndef RELAY_DOWNSAMPLE_NODEINFO_SECS
+#define RELAY_DOWNSAMPLE_NODEINFO_SECS 0
+#endif
+#ifndef RELAY_DOWNSAMPLE_NEIGHBORINFO_SECS
+#define RELAY_DOWNSAMPLE_NEIGHBORINFO_SECS 0
+#endif
+#define RELAY_DOWNSAMPLE                                                                                                         \
+    (RELAY_DOWNSAMPLE_TELEMETRY_SECS || RELAY_DOWNSAMPLE_POSITION_SECS || RELAY_DOWNSAMPLE_NODEINFO_SECS ||                      \
+     RELAY_DOWNSAMPLE_NEIGHBORINFO_SECS)
+#define RELAY_DOWNSAMPLE_TRACKED 32 // (node, port) pairs we remember the last relay of
+
 /**
  * This is a mixin that extends Router with the ability to do Naive Flooding (in the standard mesh protocol sense)
  *
@@ -24,6 +55,17 @@
 
   Any entries in recentBroadcasts that are older than X seconds (longer than the
   max time a flood can take) will be discarded.
+
+  A client that hears someone else rebroadcast a packet before it got to do so
+  itself cancels its own rebroadcast.  Routers and repeaters always rebroadcast,
+  unless RELAY_SUPPRESSION_THRESHOLD is set: then they cancel once that many
+  distinct nodes relayed the packet, or once two have and every relay we overheard
+  was stronger than the copy we are about to repeat (so those relayers are nearer
+  to us than where we heard it from, and already cover our neighbourhood).
+
+  With RELAY_DOWNSAMPLE_*_SECS set, periodic broadcasts (telemetry, positions...)
+  are relayed at most once per interval from each node, the rest only reach the
+  nodes that hear the sender directly.
  */
 class FloodingRouter : public Router
 {
@@ -31,6 +73,29 @@ class FloodingRouter : public Router
     /* Check if we should rebroadcast this packet, and do so if needed */
     void perhapsRebroadcast(const meshtastic_MeshPacket *p);
 
+#if RELAY_SUPPRESSION_THRESHOLD
+    struct PendingRelay {
+        NodeNum from;
+        PacketId id;
+        float snr;      // of the copy we queued
+        bool allBetter; // every relay overheard since was received with a higher SNR
+    };
+    PendingRelay pendingRelays[RELAY_SUPPRESSION_TRACKED] = {};
+    uint8_t nextPendingRelay = 0;
+
+    /* Check whether enough other nodes relayed this dupe that a router doesn't need to */
+    bool shouldSuppressRelay(const meshtastic_MeshPacket *p);
+#endif
+
+#if RELAY_DOWNSAMPLE
+    struct RelayedBroadcast {
+        NodeNum from;
+        uint16_t key; // portnum << 8, plus the kind of telemetry
+        uint32_t lastMs;
+    };
+    RelayedBroadcast relayedBroadcasts[RELAY_DOWNSAMPLE_TRACKED] = {};
+#endif
+
   public:
     /**
      * Constructor
@@ -62,6 +127,13 @@ class FloodingRouter : public Router
     /* Call when receiving a duplicate packet to check whether we should cancel a packet in the Tx queue */
     void perhapsCancelDupe(const meshtastic_MeshPacket *p);
 
-    // Return true if we are a rebroadcaster
-    bool isRebroadcaster();
+    // Return true if we are a rebroadcaster, a constant with ROUTER_FIXED_ROLE set to CLIENT_MUTE
+    bool isRebroadcaster()
+    {
+        return routingRole() != meshtastic_Config_DeviceConfig_Role_CLIENT_MUTE &&
+               config.device.rebroadcast_mode != meshtastic_Config_DeviceConfig_RebroadcastMode_NONE;
+    }
+
+    /* Check whether we relayed a broadcast on this port from this node too recently to relay another (RELAY_DOWNSAMPLE_*) */
+    bool shouldDownsampleRelay(const meshtastic_MeshPacket *p);
 };
\ No newline at end of file
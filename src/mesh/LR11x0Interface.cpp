@@ -251,7 +251,7 @@ template <typename T> void LR11x0Interface<T>::startReceive()
     RadioLibInterface::startReceive();
 
     // Must be done AFTER, starting transmit, because startTransmit clears (possibly stale) interrupt pending register bits
-    enableInterrupt(isrRxLevel0);
+    enableInterrupt(rxIsr());
 #endif
 }
 
@@ -287,6 +287,47 @@ template <typename T> bool LR11x0Interface<T>::isActivelyReceiving()
                            RADIOLIB_LR11X0_IRQ_PREAMBLE_DETECTED);
 }
 
+#if LR11X0_GNSS
+template <typename T>
+RadioInterface::GnssScanResult LR11x0Interface<T>::gnssScan(const meshtastic_Position *assist, meshtastic_Position &fix)
+{
+    if (lora.isGnssScanCapable() != RADIOLIB_ERR_NONE)
+        return GNSS_SCAN_UNSUPPORTED; // an LR1121, or GNSS firmware we can't use
+
+    // The scan keeps the radio for seconds, don't cut off a packet for it
+    if (sendingPacket || (isReceiving && isActivelyReceiving()) || !txQueue.empty())
+        return GNSS_SCAN_BUSY;
+
+    setStandby();
+#if RADIOLIB_GODMODE || RADIOLIB_LOW_LEVEL
+    // RadioLib only offers the assistance position as a low level command
+    if (assist && (assist->latitude_i || assist->longitude_i)) {
+        int16_t err = lora.gnssSetAssistancePosition(assist->latitude_i * 1e-7f, assist->longitude_i * 1e-7f);
+        if (err != RADIOLIB_ERR_NONE)
+            LOG_WARN("LR11x0 GNSS assistance position %s%d", radioLibErr, err);
+    }
+#endif
+
+    uint32_t start = millis();
+    LR11x0GnssResult_t res = {};
+    LR11x0GnssPosition_t pos = {};
+    int16_t err = lora.runGnssScan(&res);
+    if (err == RADIOLIB_ERR_NONE)
+        err = lora.getGnssPosition(&pos);
+    LOG_DEBUG("LR11x0 GNSS scan took %ums, %d sats, result %d", millis() - start, res.numSatsDet, err);
+
+    reconfigure(); // the scan leaves the radio set up for GNSS, put LoRa back and receive again
+
+    if (err != RADIOLIB_ERR_NONE || pos.numSatsUsed == 0)
+        return GNSS_SCAN_NO_FIX;
+    fix.latitude_i = (int32_t)(pos.latitude * 1e7);
+    fix.longitude_i = (int32_t)(pos.longitude * 1e7);
+    fix.has_latitude_i = fix.has_longitude_i = true;
+    fix.sats_in_view = pos.numSatsUsed;
+    return GNSS_SCAN_FIX;
+}
+#endif
+
 template <typename T> bool LR11x0Interface<T>::sleep()
 {
     // \todo Display actual typename of the adapter, not just `LR11x0`
@@ -27,6 +27,10 @@ template <class T> class LR11x0Interface : public RadioLibInterface
 
     bool isIRQPending() override { return lora.getIrqFlags() != 0; }
 
+#if LR11X0_GNSS
+    virtual GnssScanResult gnssScan(const meshtastic_Position *assist, meshtastic_Position &fix) override;
+#endif
+
   protected:
     /**
      * Specific module instance
@@ -2,6 +2,7 @@
 
 #include <Arduino.h>
 #include <assert.h>
+#include <atomic>
 #include <functional>
 #include <memory>
 
@@ -65,6 +66,20 @@ template <class T> class Allocator
     /// Return a buffer for use by others
     virtual void release(T *p) = 0;
 
+    /**
+     * Return a handle to the same contents as p for another reader.  Allocators that reference count share the buffer, the
+     * others make a copy.  Either way the result must be released on its own, and must not be modified without makeWritable().
+     */
+    virtual T *share(T *p) { return allocCopy(*p); }
+
+    /// std::unique_ptr wrapped variant of share()
+    UniqueAllocation shareUnique(T *p) { return UniqueAllocation(share(p), deleter); }
+
+    /**
+     * Copy on write: if p is shared with other holders, give up our reference and return a private copy, otherwise return p.
+     */
+    virtual T *makeWritable(T *p) { return p; }
+
   protected:
     // Alloc some storage
     virtual T *alloc(TickType_t maxWait) = 0;
@@ -96,3 +111,159 @@ template <class T> class MemoryDynamic : public Allocator<T>
         return p;
     }
 };
+
+/**
+ * What every MemoryPool counts, with a list of all of them so they can be reported together (see HeapTracker::logStats()).
+ */
+class MemoryPoolStats
+{
+  public:
+    explicit MemoryPoolStats(const char *name) : name(name), next(head()) { head() = this; }
+
+    virtual ~MemoryPoolStats()
+    {
+        for (MemoryPoolStats **p = &head(); *p; p = &(*p)->next)
+            if (*p == this) {
+                *p = next;
+                break;
+            }
+    }
+
+    const char *getName() const { return name; }
+
+    virtual size_t getFree() const = 0;
+    virtual size_t getMaxSize() const = 0;
+    virtual size_t getHighWaterMark() const = 0;
+    virtual uint32_t getHeapFallbacks() const = 0;
+
+    static const MemoryPoolStats *first() { return head(); }
+    const MemoryPoolStats *nextPool() const { return next; }
+
+  private:
+    const char *name;
+    MemoryPoolStats *next;
+
+    // Constant initialised, so pools made by static constructors in any order can add themselves
+    static MemoryPoolStats *&head()
+    {
+        static MemoryPoolStats *pools = NULL;
+        return pools;
+    }
+};
+
+/**
+ * A fixed capacity slab allocator, so long running nodes don't fragment their heap with packet sized malloc/free.
+ *
+ * Free blocks are kept on a lock-free (Treiber) stack: the head packs a 16 bit block index with a 16 bit tag that changes on every
+ * update, which avoids the ABA problem without needing a lock.  That makes alloc and release safe from ISRs and any thread.
+ *
+ * If the slab is exhausted we fall back to the heap (and count it), so a burst of traffic degrades instead of asserting.  Note
+ * that fallback allocation is not ISR safe, which matches MemoryDynamic.
+ */
+template <class T, size_t MaxSize> class MemoryPool : public Allocator<T>, public MemoryPoolStats
+{
+    static_assert(MaxSize > 0 && MaxSize < 0xffff, "MemoryPool size must fit a 16 bit index");
+
+    enum : uint16_t { NIL = 0xffff };
+
+    T items[MaxSize];
+    volatile uint16_t nextFree[MaxSize];
+    std::atomic<uint8_t> refs[MaxSize]; // holders of each slab block, see share()
+    std::atomic<uint32_t> freeHead; // tag << 16 | index of the first free block
+
+    std::atomic<uint16_t> inUse;
+    std::atomic<uint16_t> highWater;
+    std::atomic<uint32_t> heapAllocs;
+
+    bool owns(const T *p) const { return p >= items && p < items + MaxSize; }
+
+  public:
+    explicit MemoryPool(const char *name = "pool") : MemoryPoolStats(name), freeHead(0), inUse(0), highWater(0), heapAllocs(0)
+    {
+        for (size_t i = 0; i < MaxSize; i++) {
+            nextFree[i] = (i + 1 < MaxSize) ? i + 1 : NIL;
+            refs[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /// Return a buffer for use by others
+    virtual void release(T *p) override
+    {
+        assert(p);
+        if (!owns(p)) {
+            free(p); // came from the heap fallback
+            return;
+        }
+
+        uint16_t idx = p - items;
+        if (refs[idx].fetch_sub(1, std::memory_order_acq_rel) > 1)
+            return; // still shared with someone else
+
+        uint32_t old = freeHead.load(std::memory_order_relaxed);
+        uint32_t updated;
+        do {
+            nextFree[idx] = old & 0xffff;
+            updated = ((old + 0x10000) & 0xffff0000) | idx;
+        } while (!freeHead.compare_exchange_weak(old, updated, std::memory_order_release, std::memory_order_relaxed));
+        inUse.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /// Slab blocks are reference counted, so sharing one costs no copy
+    virtual T *share(T *p) override
+    {
+        assert(p);
+        if (owns(p)) {
+            std::atomic<uint8_t> &r = refs[p - items];
+            uint8_t n = r.load(std::memory_order_relaxed);
+            while (n < UINT8_MAX)
+                if (r.compare_exchange_weak(n, n + 1, std::memory_order_relaxed))
+                    return p;
+        }
+        return Allocator<T>::share(p); // heap fallback blocks (or a saturated count) get copied
+    }
+
+    virtual T *makeWritable(T *p) override
+    {
+        if (!owns(p) || refs[p - items].load(std::memory_order_acquire) <= 1)
+            return p;
+
+        T *copy = this->allocCopy(*p);
+        release(p);
+        return copy;
+    }
+
+    /// Number of slab blocks currently free
+    size_t getFree() const override { return MaxSize - inUse.load(std::memory_order_relaxed); }
+
+    size_t getMaxSize() const override { return MaxSize; }
+
+    /// The most slab blocks that were ever in use at once
+    size_t getHighWaterMark() const override { return highWater.load(std::memory_order_relaxed); }
+
+    /// How many allocations had to fall back to the heap because the slab was full
+    uint32_t getHeapFallbacks() const override { return heapAllocs.load(std::memory_order_relaxed); }
+
+  protected:
+    // Alloc some storage
+    virtual T *alloc(TickType_t maxWait) override
+    {
+        uint32_t old = freeHead.load(std::memory_order_acquire);
+        while ((old & 0xffff) != NIL) {
+            uint16_t idx = old & 0xffff;
+            uint32_t updated = ((old + 0x10000) & 0xffff0000) | nextFree[idx];
+            if (freeHead.compare_exchange_weak(old, updated, std::memory_order_acquire, std::memory_order_acquire)) {
+                refs[idx].store(1, std::memory_order_relaxed);
+                uint16_t used = inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+                uint16_t seen = highWater.load(std::memory_order_relaxed);
+                while (used > seen && !highWater.compare_exchange_weak(seen, used, std::memory_order_relaxed))
+                    ;
+                return &items[idx];
+            }
+        }
+
+        heapAllocs.fetch_add(1, std::memory_order_relaxed);
+        T *p = (T *)malloc(sizeof(T));
+        assert(p);
+        return p;
+    }
+};
@@ -2,12 +2,16 @@
 #include "Channels.h"
 #include "MeshService.h"
 #include "NodeDB.h"
+#include "PacketLatency.h"
 #include "configuration.h"
 #include "modules/RoutingModule.h"
 #include <algorithm>
 #include <assert.h>
 
 std::vector<MeshModule *> *MeshModule::modules;
+std::vector<MeshModule::PortDispatch> MeshModule::portDispatch;
+std::vector<MeshModule *> MeshModule::anyPortModules, MeshModule::encryptedModules;
+bool MeshModule::dispatchDirty = true;
 
 const meshtastic_MeshPacket *MeshModule::currentRequest;
 uint8_t MeshModule::numPeriodicModules = 0;
@@ -25,6 +29,7 @@ MeshModule::MeshModule(const char *_name) : name(_name)
         modules = new std::vector<MeshModule *>();
 
     modules->push_back(this);
+    dispatchDirty = true;
 }
 
 void MeshModule::setup() {}
@@ -34,6 +39,7 @@ MeshModule::~MeshModule()
     auto it = std::find(modules->begin(), modules->end(), this);
     assert(it != modules->end());
     modules->erase(it);
+    dispatchDirty = true;
 }
 
 // ⚠️ **Only call once** to set the initial delay before a module starts broadcasting periodically
@@ -85,8 +91,49 @@ meshtastic_MeshPacket *MeshModule::allocErrorResponse(meshtastic_Routing_Error e
     return r;
 }
 
+void MeshModule::rebuildDispatch()
+{
+    portDispatch.clear();
+    anyPortModules.clear();
+    encryptedModules.clear();
+
+    for (auto pi : *modules) {
+        int port = pi->dispatchPortNum();
+        if (port != MESHMODULE_ANY_PORT) {
+            auto it = std::lower_bound(portDispatch.begin(), portDispatch.end(), port,
+                                       [](const PortDispatch &d, int p) { return d.portNum < p; });
+            if (it == portDispatch.end() || it->portNum != port)
+                it = portDispatch.insert(it, PortDispatch{port, anyPortModules}); // any port modules registered so far
+        }
+        // Add to every list that can contain this module, which keeps each list in registration order
+        for (auto &d : portDispatch)
+            if (port == MESHMODULE_ANY_PORT || d.portNum == port)
+                d.modules.push_back(pi);
+        if (port == MESHMODULE_ANY_PORT)
+            anyPortModules.push_back(pi);
+        if (pi->encryptedOk)
+            encryptedModules.push_back(pi);
+    }
+    dispatchDirty = false;
+}
+
+const std::vector<MeshModule *> &MeshModule::getDispatch(const meshtastic_MeshPacket &mp)
+{
+    if (dispatchDirty)
+        rebuildDispatch();
+
+    if (mp.which_payload_variant != meshtastic_MeshPacket_decoded_tag)
+        return encryptedModules;
+
+    int port = mp.decoded.portnum;
+    auto it = std::lower_bound(portDispatch.begin(), portDispatch.end(), port,
+                               [](const PortDispatch &d, int p) { return d.portNum < p; });
+    return (it != portDispatch.end() && it->portNum == port) ? it->modules : anyPortModules;
+}
+
 void MeshModule::callModules(meshtastic_MeshPacket &mp, RxSource src)
 {
+    PacketLatency::stamp(PacketLatency::Dispatch, &mp);
     // LOG_DEBUG("In call modules");
     bool moduleFound = false;
 
@@ -101,7 +148,9 @@ void MeshModule::callModules(meshtastic_MeshPacket &mp, RxSource src)
     auto ourNodeNum = nodeDB->getNodeNum();
     bool toUs = isBroadcast(mp.to) || isToUs(&mp);
 
-    for (auto i = modules->begin(); i != modules->end(); ++i) {
+    // Only the modules that could want this packet, in the same order as in modules
+    const std::vector<MeshModule *> &candidates = getDispatch(mp);
+    for (auto i = candidates.begin(); i != candidates.end(); ++i) {
         auto &pi = **i;
 
         pi.currentRequest = &mp;
@@ -142,9 +191,15 @@ void MeshModule::callModules(meshtastic_MeshPacket &mp, RxSource src)
                 } else
                     printPacket("packet on wrong channel, but can't respond", &mp);
             } else {
+                uint32_t started = micros();
                 ProcessMessage handled = pi.handleReceived(mp);
 
                 pi.alterReceived(mp);
+                uint32_t took = micros() - started;
+                pi.handleStats.calls++;
+                pi.handleStats.totalMicros += took;
+                if (took > pi.handleStats.maxMicros)
+                    pi.handleStats.maxMicros = took;
 
                 // Possibly send replies (but only if the message was directed to us specifically, i.e. not for promiscious
                 // sniffing) also: we only let the one module send a reply, once that happens, remaining modules are not
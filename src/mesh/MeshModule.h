@@ -11,6 +11,7 @@
 
 #define MESHMODULE_MIN_BROADCAST_DELAY_MS 30 * 1000 // Min. delay after boot before sending first broadcast by any module
 #define MESHMODULE_BROADCAST_SPACING_MS 15 * 1000   // Initial spacing between broadcasts of different modules
+#define MESHMODULE_ANY_PORT -1                      // dispatchPortNum() for modules that don't filter on a single portnum
 
 /** handleReceived return enumeration
  *
@@ -63,7 +64,28 @@ class MeshModule
 {
     static std::vector<MeshModule *> *modules;
 
+    /// Modules that might want a decoded packet for one portnum, in registration order, see dispatchPortNum()
+    struct PortDispatch {
+        int portNum;
+        std::vector<MeshModule *> modules;
+    };
+    static std::vector<PortDispatch> portDispatch; // sorted by portNum
+    static std::vector<MeshModule *> anyPortModules, encryptedModules;
+    static bool dispatchDirty;
+
+    /// Build the dispatch lists, deferred until the first packet because dispatchPortNum() is virtual
+    static void rebuildDispatch();
+
+    /// @return the modules to consider for this packet, in the order they must be called
+    static const std::vector<MeshModule *> &getDispatch(const meshtastic_MeshPacket &mp);
+
   public:
+    /// Time spent in this module's receive handlers
+    struct HandleStats {
+        uint32_t calls;
+        uint32_t maxMicros;
+        uint32_t totalMicros;
+    };
     /** Constructor
      * name is for debugging output
      */
@@ -80,6 +102,13 @@ class MeshModule
     static AdminMessageHandleResult handleAdminMessageForAllModules(const meshtastic_MeshPacket &mp,
                                                                     meshtastic_AdminMessage *request,
                                                                     meshtastic_AdminMessage *response);
+
+    const char *getName() const { return name; }
+
+    const HandleStats &getHandleStats() const { return handleStats; }
+
+    /// Every module, in registration order
+    static const std::vector<MeshModule *> *getModules() { return modules; }
 #if HAS_SCREEN
     virtual void drawFrame(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t x, int16_t y) { return; }
     virtual bool isRequestingFocus();                          // Checked by screen, when regenerating frameset
@@ -144,6 +173,12 @@ class MeshModule
      */
     virtual bool wantPacket(const meshtastic_MeshPacket *p) = 0;
 
+    /**
+     * @return the only portnum wantPacket() can accept for a decoded packet, or MESHMODULE_ANY_PORT.  callModules() does not
+     * call modules for packets on other ports, so override this if you widen wantPacket() beyond a single port.
+     */
+    virtual int dispatchPortNum() const { return MESHMODULE_ANY_PORT; }
+
     /** Called to handle a particular incoming message
 
     @return ProcessMessage::STOP if you've guaranteed you've handled this message and no other handlers should be considered for
@@ -207,6 +242,8 @@ class MeshModule
 #endif
 
   private:
+    HandleStats handleStats = {};
+
     /**
      * If any of the current chain of modules has already sent a reply, it will be here.  This is useful to allow
      * the RoutingModule to avoid sending redundant acks
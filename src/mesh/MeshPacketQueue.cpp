@@ -1,5 +1,8 @@
 #include "MeshPacketQueue.h"
 #include "NodeDB.h"
+#include "PacketLatency.h"
+#include "RadioInterface.h"
+#include "airtime.h"
 #include "configuration.h"
 #include <assert.h>
 
@@ -28,11 +31,75 @@ bool CompareMeshPacketFunc(const meshtastic_MeshPacket *p1, const meshtastic_Mes
     return (p1p != p2p) ? (p1p > p2p) : (!isFromUs(p1) && isFromUs(p2));
 }
 
-MeshPacketQueue::MeshPacketQueue(size_t _maxLen) : maxLen(_maxLen) {}
+MeshPacketQueue::MeshPacketQueue(size_t _maxLen) : maxLen(_maxLen)
+{
+    assert(maxLen < NIL);
+    slots.resize(maxLen);
+    for (size_t i = 0; i < maxLen; i++)
+        slots[i].next = (i + 1 < maxLen) ? i + 1 : NIL;
+    freeSlots = maxLen ? 0 : NIL;
+    lanes.reserve(maxLen);
+
+    size_t indexSize = 8;
+    while (indexSize < maxLen * 2)
+        indexSize <<= 1;
+    index.assign(indexSize, NIL);
+    indexMask = indexSize - 1;
+}
 
 bool MeshPacketQueue::empty()
 {
-    return queue.empty();
+    return count == 0;
+}
+
+uint16_t MeshPacketQueue::laneKey(const meshtastic_MeshPacket *p)
+{
+    uint32_t pri = getPriority(p);
+    if (pri > 0xff)
+        pri = 0xff;
+    // Same rules as CompareMeshPacketFunc: not late first, then higher priority, then packets already on mesh
+    return ((p->tx_after ? 0 : 1) << 9) | (pri << 1) | (isFromUs(p) ? 0 : 1);
+}
+
+size_t MeshPacketQueue::indexHash(NodeNum from, PacketId id) const
+{
+    uint32_t h = from * 0x9E3779B1u ^ id;
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    return h & indexMask;
+}
+
+void MeshPacketQueue::indexInsert(uint16_t slot)
+{
+    const meshtastic_MeshPacket *p = slots[slot].p;
+    size_t i = indexHash(getFrom(p), p->id);
+    while (index[i] != NIL)
+        i = (i + 1) & indexMask;
+    index[i] = slot;
+}
+
+void MeshPacketQueue::indexErase(uint16_t slot)
+{
+    const meshtastic_MeshPacket *p = slots[slot].p;
+    size_t i = indexHash(getFrom(p), p->id);
+    while (index[i] != slot) {
+        assert(index[i] != NIL);
+        i = (i + 1) & indexMask;
+    }
+
+    // Backward-shift deletion, so lookups never need tombstones
+    size_t hole = i;
+    for (size_t j = (hole + 1) & indexMask; index[j] != NIL; j = (j + 1) & indexMask) {
+        const meshtastic_MeshPacket *q = slots[index[j]].p;
+        size_t home = indexHash(getFrom(q), q->id);
+        bool inRange = (hole <= j) ? (hole < home && home <= j) : (hole < home || home <= j);
+        if (!inRange) {
+            index[hole] = index[j];
+            hole = j;
+        }
+    }
+    index[hole] = NIL;
 }
 
 /**
@@ -65,31 +132,143 @@ void fixPriority(meshtastic_MeshPacket *p)
 }
 
 /** enqueue a packet, return false if full */
-bool MeshPacketQueue::enqueue(meshtastic_MeshPacket *p)
+bool MeshPacketQueue::enqueue(meshtastic_MeshPacket *p, uint32_t airtimeMsec, AirTime *budget)
 {
+    // Shed low priority packets while the airtime budget is running low, rather than have everything stop at the duty cycle
+    if (!budget)
+        budget = airTime;
+    if (airtimeMsec && budget && !budget->isTxAllowedBudget(p->priority, airtimeMsec))
+        return false;
+
     // no space - try to replace a lower priority packet in the queue
-    if (queue.size() >= maxLen) {
+    if (count >= maxLen) {
         bool replaced = replaceLowerPriorityPacket(p);
         if (!replaced) {
             LOG_WARN("TX queue is full, and there is no lower-priority packet available to evict in favour of 0x%08x", p->id);
+        } else {
+            PacketLatency::stamp(PacketLatency::Queued, p);
         }
         return replaced;
     }
 
-    // Find the correct position using upper_bound to maintain a stable order
-    auto it = std::upper_bound(queue.begin(), queue.end(), p, CompareMeshPacketFunc);
-    queue.insert(it, p); // Insert packet at the found position
+    // Find (or create) the lane, there are only a handful of distinct lanes so this stays cheap
+    uint16_t key = laneKey(p);
+    auto lane = std::lower_bound(lanes.begin(), lanes.end(), key, [](const Lane &l, uint16_t k) { return l.key > k; });
+    if (lane == lanes.end() || lane->key != key) {
+        Lane l = {key, NIL, NIL};
+        lane = lanes.insert(lane, l);
+    }
+
+    uint16_t slot = freeSlots;
+    assert(slot != NIL);
+    freeSlots = slots[slot].next;
+
+    // Append at the tail of its lane to keep a stable order
+    Slot &s = slots[slot];
+    s.p = p;
+    s.lane = key;
+    s.prev = lane->tail;
+    s.next = NIL;
+#if TX_QUEUE_DEADLINES
+    s.deadline = 0;
+    s.port = meshtastic_PortNum_UNKNOWN_APP;
+#endif
+#if TX_QUEUE_AGING
+    s.queuedMs = millis();
+#endif
+    if (lane->tail != NIL)
+        slots[lane->tail].next = slot;
+    else
+        lane->head = slot;
+    lane->tail = slot;
+
+    indexInsert(slot);
+    count++;
+    PacketLatency::stamp(PacketLatency::Queued, p);
     return true;
 }
 
+meshtastic_MeshPacket *MeshPacketQueue::removeSlot(uint16_t slot)
+{
+    Slot &s = slots[slot];
+    auto lane = std::lower_bound(lanes.begin(), lanes.end(), s.lane, [](const Lane &l, uint16_t k) { return l.key > k; });
+    assert(lane != lanes.end() && lane->key == s.lane);
+
+    if (s.prev != NIL)
+        slots[s.prev].next = s.next;
+    else
+        lane->head = s.next;
+    if (s.next != NIL)
+        slots[s.next].prev = s.prev;
+    else
+        lane->tail = s.prev;
+
+    if (lane->head == NIL)
+        lanes.erase(lane);
+
+    indexErase(slot);
+#if TX_QUEUE_DEADLINES
+    if (s.deadline) {
+        s.deadline = 0;
+        numDeadlines--;
+    }
+#endif
+    meshtastic_MeshPacket *p = s.p;
+    s.p = NULL;
+    s.next = freeSlots;
+    freeSlots = slot;
+    count--;
+    return p;
+}
+
+uint16_t MeshPacketQueue::frontSlot() const
+{
+#if TX_QUEUE_AGING
+    // The head of a lane is its oldest packet, and there are only a handful of lanes
+    uint32_t now = millis();
+    uint16_t overdue = NIL;
+    int32_t mostOverdue = 0;
+    for (const Lane &lane : lanes) {
+        const Slot &s = slots[lane.head];
+        if (s.p->tx_after)
+            break; // the late transmit window lanes are last, and wait on purpose
+        uint32_t target = latencyTargetMs(getPriority(s.p));
+        int32_t over = (int32_t)(now - s.queuedMs - target);
+        if (target && over > mostOverdue) {
+            overdue = lane.head;
+            mostOverdue = over;
+        }
+    }
+    if (overdue != NIL)
+        return overdue;
+#endif
+    return lanes.front().head; // the highest-priority packet
+}
+
 meshtastic_MeshPacket *MeshPacketQueue::dequeue()
 {
     if (empty()) {
         return NULL;
     }
 
-    auto *p = queue.front();
-    queue.erase(queue.begin()); // Remove the highest-priority packet
+    uint16_t slot = frontSlot();
+#if TX_QUEUE_AGING
+    const Slot &s = slots[slot];
+    uint32_t waited = millis() - s.queuedMs;
+    if (slot != lanes.front().head) {
+        LOG_DEBUG("Send 0x%08x (priority %u) ahead, it waited %u ms", s.p->id, s.p->priority, waited);
+        boosted++;
+    }
+    uint8_t bucket = 0;
+    while (bucket < TX_QUEUE_WAIT_BUCKETS - 1 && waited >= getWaitBucketLimitMs(bucket))
+        bucket++;
+    WaitClass c = waitClass(getPriority(s.p));
+    waitHistogram[c][bucket]++;
+    waitTotalMs[c] += waited;
+#endif
+
+    meshtastic_MeshPacket *p = removeSlot(slot);
+    PacketLatency::stamp(PacketLatency::Dequeued, p);
     return p;
 }
 
@@ -99,29 +278,45 @@ meshtastic_MeshPacket *MeshPacketQueue::getFront()
         return NULL;
     }
 
-    auto *p = queue.front();
+    auto *p = slots[frontSlot()].p;
     return p;
 }
 
 /** Attempt to find and remove a packet from this queue.  Returns a pointer to the removed packet, or NULL if not found */
 meshtastic_MeshPacket *MeshPacketQueue::remove(NodeNum from, PacketId id, bool tx_normal, bool tx_late)
 {
-    for (auto it = queue.begin(); it != queue.end(); it++) {
-        auto p = (*it);
+    uint16_t found = NIL;
+    for (size_t i = indexHash(from, id); index[i] != NIL; i = (i + 1) & indexMask) {
+        const Slot &s = slots[index[i]];
+        auto p = s.p;
         if (getFrom(p) == from && p->id == id && ((tx_normal && !p->tx_after) || (tx_late && p->tx_after))) {
-            queue.erase(it);
-            return p;
+            // In the rare case of duplicates, remove the one which would have been sent first
+            if (found == NIL || s.lane > slots[found].lane)
+                found = index[i];
         }
     }
 
+    return (found != NIL) ? removeSlot(found) : NULL;
+}
+
+meshtastic_MeshPacket *MeshPacketQueue::removeAggregatable(NodeNum from, NodeNum to, uint8_t channel, size_t maxSize)
+{
+    for (const Lane &lane : lanes) {
+        for (uint16_t i = lane.head; i != NIL; i = slots[i].next) {
+            const meshtastic_MeshPacket *p = slots[i].p;
+            if (p->from == from && p->to == to && p->channel == channel && !p->tx_after &&
+                p->which_payload_variant == meshtastic_MeshPacket_encrypted_tag && p->encrypted.size <= maxSize)
+                return removeSlot(i);
+        }
+    }
     return NULL;
 }
 
 /* Attempt to find a packet from this queue. Return true if it was found. */
 bool MeshPacketQueue::find(const NodeNum from, const PacketId id)
 {
-    for (auto it = queue.begin(); it != queue.end(); it++) {
-        const auto p = (*it);
+    for (size_t i = indexHash(from, id); index[i] != NIL; i = (i + 1) & indexMask) {
+        const auto p = slots[index[i]].p;
         if (getFrom(p) == from && p->id == id) {
             return true;
         }
@@ -137,39 +332,151 @@ bool MeshPacketQueue::find(const NodeNum from, const PacketId id)
 bool MeshPacketQueue::replaceLowerPriorityPacket(meshtastic_MeshPacket *p)
 {
 
-    if (queue.empty()) {
+    if (empty()) {
         return false; // No packets to replace
     }
 
-    // Check if the packet at the back has a lower priority than the new packet
-    auto *backPacket = queue.back();
-    if (!backPacket->tx_after && backPacket->priority < p->priority) {
-        LOG_WARN("Dropping packet 0x%08x to make room in the TX queue for higher-priority packet 0x%08x", backPacket->id, p->id);
-        // Remove the back packet
-        queue.pop_back();
-        packetPool.release(backPacket);
-        // Insert the new packet in the correct order
-        enqueue(p);
-        return true;
-    }
-
-    if (backPacket->tx_after) {
-        // Check if there's a non-late packet with lower priority
-        auto it = queue.end();
-        auto refPacket = *--it;
-        for (; refPacket->tx_after && it != queue.begin(); refPacket = *--it)
-            ;
-        if (!refPacket->tx_after && refPacket->priority < p->priority) {
-            LOG_WARN("Dropping non-late packet 0x%08x to make room in the TX queue for higher-priority packet 0x%08x",
-                     refPacket->id, p->id);
-            queue.erase(it);
-            packetPool.release(refPacket);
-            // Insert the new packet in the correct order
-            enqueue(p);
-            return true;
+    // The last non-late packet is the tail of the last lane outside the late transmit window
+    auto lane = lanes.end();
+    while (lane != lanes.begin()) {
+        --lane;
+        if (!slots[lane->head].p->tx_after) {
+            uint16_t refSlot = lane->tail;
+            auto *refPacket = slots[refSlot].p;
+            if (refPacket->priority < p->priority) {
+                LOG_WARN("Dropping packet 0x%08x to make room in the TX queue for higher-priority packet 0x%08x", refPacket->id,
+                         p->id);
+                removeSlot(refSlot);
+                packetPool.release(refPacket);
+                // Insert the new packet in the correct order
+                enqueue(p);
+                return true;
+            }
+            break;
         }
     }
 
     // If the back packet's priority is not lower, no replacement occurs
     return false;
-}
\ No newline at end of file
+}
+
+uint32_t MeshPacketQueue::getDrainTimeMsec(RadioInterface &radio) const
+{
+    uint32_t total = 0;
+    for (const Slot &s : slots)
+        if (s.p)
+            total += radio.getPacketTime(s.p); // a table lookup, packets in the queue are already encrypted
+    return total;
+}
+
+#if TX_QUEUE_AGING
+static_assert(MeshPacketQueue::WAIT_CLASSES == 4, "waitHistogram is sized for the wait classes");
+
+uint32_t MeshPacketQueue::latencyTargetMs(uint32_t priority)
+{
+    if (priority >= meshtastic_MeshPacket_Priority_HIGH)
+        return 0;
+    if (priority >= meshtastic_MeshPacket_Priority_RELIABLE)
+        return TX_QUEUE_TARGET_MS_RELIABLE;
+    if (priority >= meshtastic_MeshPacket_Priority_DEFAULT)
+        return TX_QUEUE_TARGET_MS_DEFAULT;
+    return TX_QUEUE_TARGET_MS_BACKGROUND;
+}
+
+MeshPacketQueue::WaitClass MeshPacketQueue::waitClass(uint32_t priority)
+{
+    if (priority >= meshtastic_MeshPacket_Priority_HIGH)
+        return WAIT_HIGH;
+    if (priority >= meshtastic_MeshPacket_Priority_RELIABLE)
+        return WAIT_RELIABLE;
+    if (priority >= meshtastic_MeshPacket_Priority_DEFAULT)
+        return WAIT_DEFAULT;
+    return WAIT_BACKGROUND;
+}
+
+const char *MeshPacketQueue::getWaitClassName(WaitClass c)
+{
+    static const char *names[WAIT_CLASSES] = {"background", "default", "reliable", "high"};
+    return names[c];
+}
+
+uint32_t MeshPacketQueue::getWaitBucketLimitMs(uint8_t bucket)
+{
+    return bucket < TX_QUEUE_WAIT_BUCKETS - 1 ? 64u << bucket : UINT32_MAX;
+}
+#endif
+
+#if TX_QUEUE_DEADLINES
+uint32_t MeshPacketQueue::defaultDeadlineMs(meshtastic_PortNum port)
+{
+    switch (port) {
+    case meshtastic_PortNum_POSITION_APP:
+    case meshtastic_PortNum_TELEMETRY_APP:
+    case meshtastic_PortNum_PAXCOUNTER_APP:
+        return TX_QUEUE_DEADLINE_MS;
+    case meshtastic_PortNum_NODEINFO_APP:
+        return 2 * TX_QUEUE_DEADLINE_MS;
+    default:
+        return 0;
+    }
+}
+
+bool MeshPacketQueue::isSupersedable(meshtastic_PortNum port)
+{
+    // Not telemetry: device, environment and power metrics share the port, a newer one of them doesn't replace the others
+    return port == meshtastic_PortNum_POSITION_APP || port == meshtastic_PortNum_NODEINFO_APP ||
+           port == meshtastic_PortNum_PAXCOUNTER_APP;
+}
+
+uint32_t MeshPacketQueue::setDeadline(NodeNum from, PacketId id, meshtastic_PortNum port, uint32_t deadlineMs)
+{
+    uint16_t found = NIL;
+    for (size_t i = indexHash(from, id); index[i] != NIL; i = (i + 1) & indexMask) {
+        const meshtastic_MeshPacket *p = slots[index[i]].p;
+        if (getFrom(p) == from && p->id == id) {
+            found = index[i];
+            break;
+        }
+    }
+    if (found == NIL)
+        return 0; // already sent, or it didn't fit in the queue
+
+    Slot &s = slots[found];
+    s.port = port;
+    if (deadlineMs) {
+        if (!s.deadline)
+            numDeadlines++;
+        s.deadline = (millis() + deadlineMs) | 1; // never 0, that means none
+    }
+
+    uint32_t dropped = 0;
+    if (isBroadcast(s.p->to) && isSupersedable(port)) {
+        for (uint16_t i = 0; i < slots.size(); i++) {
+            const meshtastic_MeshPacket *p = slots[i].p;
+            if (i != found && p && slots[i].port == port && getFrom(p) == from && isBroadcast(p->to)) {
+                LOG_DEBUG("Drop queued packet 0x%08x on port %u, superseded by 0x%08x", p->id, port, id);
+                packetPool.release(removeSlot(i));
+                dropped++;
+            }
+        }
+    }
+    return dropped;
+}
+
+uint32_t MeshPacketQueue::dropExpired()
+{
+    if (!numDeadlines)
+        return 0;
+
+    uint32_t now = millis(), dropped = 0;
+    for (uint16_t i = 0; i < slots.size() && numDeadlines; i++) {
+        const Slot &s = slots[i];
+        if (s.p && s.deadline && (int32_t)(now - s.deadline) >= 0) {
+            LOG_DEBUG("Drop queued packet 0x%08x on port %u, past its deadline", s.p->id, s.port);
+            packetPool.release(removeSlot(i));
+            dropped++;
+        }
+    }
+    return dropped;
+}
+#endif
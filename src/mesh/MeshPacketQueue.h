@@ -4,29 +4,148 @@
 
 #include <queue>
 
+/// Set to 1 to drop our own queued packets once they are stale (see MeshPacketQueue::setDeadline())
+#ifndef TX_QUEUE_DEADLINES
+#define TX_QUEUE_DEADLINES 0
+#endif
+
+/// How long our position, telemetry and paxcounter broadcasts may wait in the TX queue, node info gets twice this
+#ifndef TX_QUEUE_DEADLINE_MS
+#define TX_QUEUE_DEADLINE_MS (2 * 60 * 1000)
+#endif
+
+/**
+ * Set to 1 to bound how long lower priority packets wait behind a steady stream of higher priority ones.  A packet that has
+ * waited longer than the latency target of its priority goes out next, the most overdue first, whatever is queued above it.
+ * Packets held for the late transmit window are left alone.  Also keeps a histogram per priority class of how long packets
+ * waited in the queue, see MeshPacketQueue::getWaitHistogram().
+ */
+#ifndef TX_QUEUE_AGING
+#define TX_QUEUE_AGING 0
+#endif
+
+/// Latency target of RELIABLE and RESPONSE packets.  ACK, ALERT and HIGH have none, they go first anyway
+#ifndef TX_QUEUE_TARGET_MS_RELIABLE
+#define TX_QUEUE_TARGET_MS_RELIABLE (10 * 1000)
+#endif
+
+/// Latency target of DEFAULT packets
+#ifndef TX_QUEUE_TARGET_MS_DEFAULT
+#define TX_QUEUE_TARGET_MS_DEFAULT (20 * 1000)
+#endif
+
+/// Latency target of BACKGROUND and MIN packets
+#ifndef TX_QUEUE_TARGET_MS_BACKGROUND
+#define TX_QUEUE_TARGET_MS_BACKGROUND (60 * 1000)
+#endif
+
+/// Wait histogram buckets: under 64 ms, then doubling, the last one for anything from about 65 s up
+#define TX_QUEUE_WAIT_BUCKETS 12
+
+class AirTime;
+class RadioInterface;
+
 /**
  * A priority queue of packets
+ *
+ * Packets are kept in FIFO lanes, one per (late window, priority, from us) combination, so that dequeue and append are O(1)
+ * while preserving the ordering of CompareMeshPacketFunc: packets in the late transmit window (tx_after) go last, then higher
+ * priority first, then for equal priorities packets already on the mesh before our own, and FIFO within a lane.
+ * A (from, id) index makes find and remove O(1) as well.  All storage is allocated once in the constructor.
  */
 class MeshPacketQueue
 {
+    enum : uint16_t { NIL = 0xffff };
+
+    /// One queued packet, linked into its lane
+    struct Slot {
+        meshtastic_MeshPacket *p;
+        uint16_t lane; // key of the lane this slot is in
+        uint16_t prev, next;
+#if TX_QUEUE_DEADLINES
+        uint32_t deadline; // millis() after which the packet is dropped, 0 for none
+        uint16_t port;     // the packet's portnum once known, UNKNOWN_APP until then
+#endif
+#if TX_QUEUE_AGING
+        uint32_t queuedMs; // millis() when enqueued
+#endif
+    };
+
+    /// A FIFO of packets that all compare equal, lanes are kept sorted from first to last dequeued
+    struct Lane {
+        uint16_t key;
+        uint16_t head, tail;
+    };
+
     size_t maxLen;
-    std::vector<meshtastic_MeshPacket *> queue;
+    size_t count = 0;
+    std::vector<Slot> slots;
+    uint16_t freeSlots = NIL;    // singly linked through Slot::next
+    std::vector<Lane> lanes;     // only non-empty lanes, highest key first
+    std::vector<uint16_t> index; // open addressing (from, id) -> slot, NIL for empty
+    size_t indexMask;
+#if TX_QUEUE_DEADLINES
+    size_t numDeadlines = 0; // slots with a deadline, dropExpired() has nothing to do while 0
+#endif
+#if TX_QUEUE_AGING
+    uint32_t waitHistogram[4][TX_QUEUE_WAIT_BUCKETS] = {}; // by WaitClass
+    uint32_t waitTotalMs[4] = {};
+    uint32_t boosted = 0;
+
+    /// How long a packet of this priority should wait at most, 0 for no limit
+    static uint32_t latencyTargetMs(uint32_t priority);
+#endif
+
+    /// The slot dequeue() takes next
+    uint16_t frontSlot() const;
 
     /** Replace a lower priority package in the queue with 'mp' (provided there are lower pri packages). Return true if replaced.
      */
     bool replaceLowerPriorityPacket(meshtastic_MeshPacket *mp);
 
+    /// @return the lane key for a packet, higher keys are dequeued first
+    static uint16_t laneKey(const meshtastic_MeshPacket *p);
+
+    size_t indexHash(NodeNum from, PacketId id) const;
+    void indexInsert(uint16_t slot);
+    void indexErase(uint16_t slot);
+
+    /// Unlink a slot from its lane, the index and return it to the free list
+    meshtastic_MeshPacket *removeSlot(uint16_t slot);
+
   public:
+#if TX_QUEUE_AGING
+    enum WaitClass : uint8_t { WAIT_BACKGROUND, WAIT_DEFAULT, WAIT_RELIABLE, WAIT_HIGH, WAIT_CLASSES };
+
+    static WaitClass waitClass(uint32_t priority);
+
+    static const char *getWaitClassName(WaitClass c);
+
+    /// How many dequeued packets of class c waited less than getWaitBucketLimitMs() of each bucket (and more than the last)
+    const uint32_t *getWaitHistogram(WaitClass c) const { return waitHistogram[c]; }
+
+    /// How long all the dequeued packets of class c waited together
+    uint32_t getWaitTotalMs(WaitClass c) const { return waitTotalMs[c]; }
+
+    /// Upper limit of a wait histogram bucket, UINT32_MAX for the last one
+    static uint32_t getWaitBucketLimitMs(uint8_t bucket);
+
+    /// Packets sent ahead of higher priority ones because they were past their latency target
+    uint32_t getBoosted() const { return boosted; }
+#endif
+
     explicit MeshPacketQueue(size_t _maxLen);
 
-    /** enqueue a packet, return false if full */
-    bool enqueue(meshtastic_MeshPacket *p);
+    /** enqueue a packet, return false if full.
+     *  If airtimeMsec is given the packet must also fit in the TX airtime budget (see AirTime::isTxAllowedBudget()) of budget,
+     *  or the global airTime if that is NULL */
+    bool enqueue(meshtastic_MeshPacket *p, uint32_t airtimeMsec = 0, AirTime *budget = NULL);
 
     /** return true if the queue is empty */
     bool empty();
 
     /** return amount of free packets in Queue */
-    size_t getFree() { return maxLen - queue.size(); }
+    size_t getFree() { return maxLen - count; }
 
     /** return total size of the Queue */
     size_t getMaxLen() { return maxLen; }
@@ -38,6 +157,33 @@ class MeshPacketQueue
     /** Attempt to find and remove a packet from this queue.  Returns the packet which was removed from the queue */
     meshtastic_MeshPacket *remove(NodeNum from, PacketId id, bool tx_normal = true, bool tx_late = true);
 
+    /** Remove the first packet, in dequeue order, that can share a radio frame with one from 'from' to 'to' on 'channel': it
+     *  is due now (no tx_after), already encrypted and has at most maxSize payload bytes.  See PacketAggregation */
+    meshtastic_MeshPacket *removeAggregatable(NodeNum from, NodeNum to, uint8_t channel, size_t maxSize);
+
     /* Attempt to find a packet from this queue. Return true if it was found. */
     bool find(const NodeNum from, const PacketId id);
-};
\ No newline at end of file
+
+    /** return how long radio will take to send everything in the queue, in msecs (not counting the gaps between packets) */
+    uint32_t getDrainTimeMsec(RadioInterface &radio) const;
+
+#if TX_QUEUE_DEADLINES
+    /**
+     * Tell the queue what the queued packet (from, id) carries, it is encrypted by now.  The packet is dropped if it is still
+     * queued deadlineMs from now (0 for never), and if it is a broadcast where only the latest one matters (see isSupersedable())
+     * any older queued broadcast from the same node on the same port is dropped right away.
+     * @return how many packets were dropped
+     */
+    uint32_t setDeadline(NodeNum from, PacketId id, meshtastic_PortNum port, uint32_t deadlineMs);
+
+    /// Release every packet whose deadline has passed, call before looking at the front of the queue
+    /// @return how many packets were dropped
+    uint32_t dropExpired();
+
+    /// The deadline packets on port get when nobody asks for another one, 0 for none
+    static uint32_t defaultDeadlineMs(meshtastic_PortNum port);
+
+    /// Does a newer broadcast on port make older queued ones from the same node pointless?
+    static bool isSupersedable(meshtastic_PortNum port);
+#endif
+};
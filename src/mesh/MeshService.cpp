@@ -8,6 +8,7 @@
 #include "BluetoothCommon.h" // needed for updateBatteryLevel, FIXME, eventually when we pull mesh out into a lib we shouldn't be whacking bluetooth from here
 #include "MeshService.h"
 #include "NodeDB.h"
+#include "PacketLatency.h"
 #include "PowerFSM.h"
 #include "RTC.h"
 #include "TypeConversions.h"
@@ -45,11 +46,20 @@ the new node can build its node db)
 
 MeshService *service;
 
+#ifdef ARCH_PORTDUINO
 static MemoryDynamic<meshtastic_MqttClientProxyMessage> staticMqttClientProxyMessagePool;
 
 static MemoryDynamic<meshtastic_QueueStatus> staticQueueStatusPool;
 
 static MemoryDynamic<meshtastic_ClientNotification> staticClientNotificationPool;
+#else
+// MQTT proxy messages and notifications are big and rare, keep only a few in the slab and let bursts fall back to the heap
+static MemoryPool<meshtastic_MqttClientProxyMessage, 4> staticMqttClientProxyMessagePool("mqtt proxy");
+
+static MemoryPool<meshtastic_QueueStatus, MAX_RX_TOPHONE> staticQueueStatusPool("queue status");
+
+static MemoryPool<meshtastic_ClientNotification, 4> staticClientNotificationPool("notifications");
+#endif
 
 Allocator<meshtastic_MqttClientProxyMessage> &mqttClientProxyMessagePool = staticMqttClientProxyMessagePool;
 
@@ -104,7 +114,7 @@ int MeshService::handleFromRadio(const meshtastic_MeshPacket *mp)
     }
 
     printPacket("Forwarding to phone", mp);
-    sendToPhone(packetPool.allocCopy(*mp));
+    sendToPhone(packetPool.share(const_cast<meshtastic_MeshPacket *>(mp))); // the phone queue only reads it
 
     return 0;
 }
@@ -133,7 +143,7 @@ void MeshService::reloadConfig(int saveWhat)
     nodeDB->resetRadioConfig(); // Don't let the phone send us fatally bad settings
 
     configChanged.notifyObservers(NULL); // This will cause radio hardware to change freqs etc
-    nodeDB->saveToDisk(saveWhat);
+    nodeDB->saveToDiskSoon(saveWhat);    // Clients often send several changes in a row, write them all at once
 }
 
 /// The owner User record just got updated, update our node DB and broadcast the info into the mesh
@@ -152,17 +162,7 @@ void MeshService::reloadOwner(bool shouldSave)
 // search the queue for a request id and return the matching nodenum
 NodeNum MeshService::getNodenumFromRequestId(uint32_t request_id)
 {
-    NodeNum nodenum = 0;
-    for (int i = 0; i < toPhoneQueue.numUsed(); i++) {
-        meshtastic_MeshPacket *p = toPhoneQueue.dequeuePtr(0);
-        if (p->id == request_id) {
-            nodenum = p->to;
-            // make sure to continue this to make one full loop
-        }
-        // put it right back on the queue
-        toPhoneQueue.enqueue(p, 0);
-    }
-    return nodenum;
+    return toPhoneQueue.findTo(request_id);
 }
 
 /**
@@ -190,7 +190,7 @@ void MeshService::handleToRadio(meshtastic_MeshPacket &p)
                                                  // (so we update our nodedb for the local node)
 
     // Send the packet into the mesh
-
+    PacketLatency::stamp(PacketLatency::FromPhone, &p);
     sendToMesh(packetPool.allocCopy(p), RX_SRC_USER);
 
     bool loopback = false; // if true send any packet the phone sends back itself (for testing)
@@ -281,11 +281,15 @@ bool MeshService::trySendPosition(NodeNum dest, bool wantReplies)
 
 void MeshService::sendToPhone(meshtastic_MeshPacket *p)
 {
-    perhapsDecode(p);
+    PacketLatency::stamp(PacketLatency::ToPhone, p);
+    if (p->which_payload_variant != meshtastic_MeshPacket_decoded_tag) {
+        p = packetPool.makeWritable(p); // decoding happens in place, don't touch a buffer someone else still holds
+        perhapsDecode(p);
+    }
 
-#ifdef ARCH_ESP32
+#if defined(ARCH_ESP32) || defined(ARCH_NRF52) || defined(ARCH_RP2040)
 #if !MESHTASTIC_EXCLUDE_STOREFORWARD
-    if (moduleConfig.store_forward.enabled && storeForwardModule->isServer() &&
+    if (moduleConfig.store_forward.enabled && storeForwardModule && storeForwardModule->isServer() &&
         p->decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_APP) {
         releaseToPool(p); // Copy is already stored in StoreForward history
         fromNum++;        // Notify observers for packet from radio
@@ -294,25 +298,8 @@ void MeshService::sendToPhone(meshtastic_MeshPacket *p)
 #endif
 #endif
 
-    if (toPhoneQueue.numFree() == 0) {
-        if (p->decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_APP ||
-            p->decoded.portnum == meshtastic_PortNum_RANGE_TEST_APP) {
-            LOG_WARN("ToPhone queue is full, discard oldest");
-            meshtastic_MeshPacket *d = toPhoneQueue.dequeuePtr(0);
-            if (d)
-                releaseToPool(d);
-        } else {
-            LOG_WARN("ToPhone queue is full, drop packet");
-            releaseToPool(p);
-            fromNum++; // Make sure to notify observers in case they are reconnected so they can get the packets
-            return;
-        }
-    }
-
-    if (toPhoneQueue.enqueue(p, 0) == false) {
-        LOG_CRIT("Failed to queue a packet into toPhoneQueue!");
-        abort();
-    }
+    // When full this drops a less useful packet, or p itself
+    toPhoneQueue.enqueue(p);
     fromNum++;
 }
 
@@ -364,8 +351,8 @@ meshtastic_NodeInfoLite *MeshService::refreshLocalMeshNode()
     meshtastic_PositionLite &position = node->position;
 
     // Update our local node info with our time (even if we don't decide to update anyone else)
-    node->last_heard =
-        getValidTime(RTCQualityFromNet); // This nodedb timestamp might be stale, so update it if our clock is kinda valid
+    // This nodedb timestamp might be stale, so update it if our clock is kinda valid
+    nodeDB->setLastHeard(node, getValidTime(RTCQualityFromNet));
 
     position.time = getValidTime(RTCQualityFromNet);
 
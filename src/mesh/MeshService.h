@@ -9,6 +9,7 @@
 #include "MeshRadio.h"
 #include "MeshTypes.h"
 #include "Observer.h"
+#include "PhoneQueue.h"
 #include "PointerQueue.h"
 #if defined(ARCH_PORTDUINO)
 #include "../platform/portduino/SimRadio.h"
@@ -34,10 +35,8 @@ class MeshService
         CallbackObserver<MeshService, const meshtastic::GPSStatus *>(this, &MeshService::onGPSChanged);
 #endif
     /// received packets waiting for the phone to process them
-    /// FIXME, change to a DropOldestQueue and keep a count of the number of dropped packets to ensure
-    /// we never hang because android hasn't been there in a while
     /// FIXME - save this to flash on deep sleep
-    PointerQueue<meshtastic_MeshPacket> toPhoneQueue;
+    PhoneQueue toPhoneQueue;
 
     // keep list of QueueStatus packets to be send to the phone
     PointerQueue<meshtastic_QueueStatus> toPhoneQueueStatusQueue;
@@ -82,7 +81,7 @@ class MeshService
 
     /// Return the next packet destined to the phone.  FIXME, somehow use fromNum to allow the phone to retry the
     /// last few packets if needs to.
-    meshtastic_MeshPacket *getForPhone() { return toPhoneQueue.dequeuePtr(0); }
+    meshtastic_MeshPacket *getForPhone() { return toPhoneQueue.dequeue(); }
 
     /// Allows the bluetooth handler to free packets after they have been sent
     void releaseToPool(meshtastic_MeshPacket *p) { packetPool.release(p); }
@@ -150,6 +149,10 @@ class MeshService
 
     bool isToPhoneQueueEmpty();
 
+    /// Packets for the phone we had no room for, and ones replaced by a newer one of the same kind
+    uint32_t getToPhoneDropped() const { return toPhoneQueue.dropped; }
+    uint32_t getToPhoneCoalesced() const { return toPhoneQueue.coalesced; }
+
     ErrorCode sendQueueStatusToPhone(const meshtastic_QueueStatus &qs, ErrorCode res, uint32_t mesh_packet_id);
 
     uint32_t GetTimeSinceMeshPacket(const meshtastic_MeshPacket *mp);
@@ -0,0 +1,58 @@
+#include "NeighborTable.h"
+#include "configuration.h"
+
+NeighborTable neighborTable;
+
+const NeighborEntry *NeighborTable::heard(NodeNum n, float snr, uint32_t now, uint32_t intervalSecs,
+                                          uint32_t defaultIntervalSecs)
+{
+    if (n == 0)
+        return NULL;
+
+    NeighborEntry *e = table.find(n);
+    if (!e) {
+        if (table.size() >= MAX_NUM_NEIGHBORS) {
+            // If we have too many neighbors, replace the one we heard from longest ago
+            NodeNum oldest = 0;
+            uint32_t oldestTime = UINT32_MAX;
+            table.forEach([&](const NodeNum &k, const NeighborEntry &v) {
+                if (v.lastRxTime <= oldestTime) {
+                    oldest = k;
+                    oldestTime = v.lastRxTime;
+                }
+            });
+            LOG_WARN("Neighbor DB is full, replace oldest neighbor 0x%x", oldest);
+            table.erase(oldest);
+        }
+        e = table.findOrInsert(n);
+        e->intervalSecs = defaultIntervalSecs;
+    }
+
+    e->snr = snr;
+    e->lastRxTime = now;
+    if (intervalSecs != 0)
+        e->intervalSecs = intervalSecs;
+    return e;
+}
+
+const NeighborEntry *NeighborTable::findCurrent(NodeNum n, uint32_t now) const
+{
+    const NeighborEntry *e = table.find(n);
+    return e && !isExpired(*e, now) ? e : NULL;
+}
+
+size_t NeighborTable::expire(uint32_t now)
+{
+    // The map can't be changed while walking it, so collect the expired ones first
+    NodeNum expired[MAX_NUM_NEIGHBORS];
+    size_t count = 0;
+    table.forEach([&](const NodeNum &n, const NeighborEntry &e) {
+        if (count < MAX_NUM_NEIGHBORS && isExpired(e, now))
+            expired[count++] = n;
+    });
+    for (size_t i = 0; i < count; i++) {
+        LOG_DEBUG("Remove neighbor with node ID 0x%x", expired[i]);
+        table.erase(expired[i]);
+    }
+    return count;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "FlatHashMap.h"
+#include "MeshTypes.h"
+
+/// The most 0-hop neighbors we keep track of, also the most a NeighborInfo packet can carry
+#ifndef MAX_NUM_NEIGHBORS
+#define MAX_NUM_NEIGHBORS 10 // also defined in NeighborInfo protobuf options
+#endif
+
+/**
+ * What we know about a node we hear directly (0 hops away)
+ */
+struct NeighborEntry {
+    float snr = 0;
+    uint32_t lastRxTime = 0;   // seconds since 1970, from getTime()
+    uint32_t intervalSecs = 0; // how often it sends NeighborInfo, it is dropped if not heard for twice this long
+};
+
+/**
+ * The nodes we hear directly, filled in by NeighborInfoModule and also used by NextHopRouter to pick next hops.
+ *
+ * Kept in a fixed size table indexed by NodeNum, which is only turned into protobufs when a NeighborInfo packet is sent.
+ */
+class NeighborTable
+{
+  public:
+    /**
+     * Note that we just heard n
+     * @param intervalSecs its NeighborInfo broadcast interval if known, or 0 to keep what we had (new entries get
+     * defaultIntervalSecs then)
+     * @return its entry, NULL if n is not a real node
+     */
+    const NeighborEntry *heard(NodeNum n, float snr, uint32_t now, uint32_t intervalSecs, uint32_t defaultIntervalSecs);
+
+    /// @return the entry for n, or NULL if we haven't heard it directly (lately)
+    const NeighborEntry *find(NodeNum n) const { return table.find(n); }
+
+    /// @return the entry for n if it hasn't expired by now, NULL otherwise
+    const NeighborEntry *findCurrent(NodeNum n, uint32_t now) const;
+
+    /// Drop the neighbors we haven't heard from within twice their broadcast interval
+    /// @return how many were dropped
+    size_t expire(uint32_t now);
+
+    void clear() { table.clear(); }
+
+    size_t size() const { return table.size(); }
+
+    /// Call f(node, entry) for every neighbor, in no particular order
+    template <class F> void forEach(F f)
+    {
+        table.forEach([&f](const NodeNum &n, NeighborEntry &e) { f(n, (const NeighborEntry &)e); });
+    }
+
+  private:
+    FlatHashMap<NodeNum, NeighborEntry, 16> table;
+
+    static_assert(MAX_NUM_NEIGHBORS <= 12, "the neighbor table holds at most 3/4 of its size");
+
+    static bool isExpired(const NeighborEntry &e, uint32_t now) { return now - e.lastRxTime > e.intervalSecs * 2; }
+};
+
+extern NeighborTable neighborTable;
@@ -1,7 +1,20 @@
 #include "NextHopRouter.h"
+#include "NeighborTable.h"
+#include "NodeDB.h"
+#include "RTC.h"
+#include "RadioTask.h"
+#include "airtime.h"
+
+#include <algorithm>
 
 NextHopRouter::NextHopRouter() {}
 
+/// Heap order for retransmission timers, earliest on top.  Compares the signed difference so millis() rollover is handled
+static bool retransmissionTimerLater(const RetransmissionTimer &a, const RetransmissionTimer &b)
+{
+    return (int32_t)(a.nextTxMsec - b.nextTxMsec) > 0;
+}
+
 PendingPacket::PendingPacket(meshtastic_MeshPacket *p, uint8_t numRetransmissions)
 {
     packet = p;
@@ -21,9 +34,15 @@ ErrorCode NextHopRouter::send(meshtastic_MeshPacket *p)
     LOG_DEBUG("Setting next hop for packet with dest %x to %x", p->to, p->next_hop);
 
     // If it's from us, ReliableRouter already handles retransmissions if want_ack is set. If a next hop is set and hop limit is
-    // not 0 or want_ack is set, start retransmissions
-    if ((!isFromUs(p) || !p->want_ack) && p->next_hop != NO_NEXT_HOP_PREFERENCE && (p->hop_limit > 0 || p->want_ack))
-        startRetransmission(packetPool.allocCopy(*p)); // start retransmission for relayed packet
+    // not 0 or want_ack is set, start retransmissions.  If the table is full of our own packets this one is just sent once.
+    if ((!isFromUs(p) || !p->want_ack) && p->next_hop != NO_NEXT_HOP_PREFERENCE && (p->hop_limit > 0 || p->want_ack) &&
+        !startRetransmission(packetPool.allocCopy(*p)))
+        LOG_DEBUG("Sending id=0x%x without retransmissions", p->id);
+
+    // Remember which hop this attempt went through, so a retransmission knows who missed it
+    PendingPacket *retx = findPendingPacket(getFrom(p), p->id);
+    if (retx)
+        retx->packet->next_hop = p->next_hop;
 
     return Router::send(p);
 }
@@ -35,6 +54,10 @@ bool NextHopRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
     if (wasSeenRecently(p, true, &wasFallback, &weWereNextHop)) { // Note: this will also add a recent packet record
         printPacket("Ignore dupe incoming msg", p);
         rxDupe++;
+#if AIRTIME_SERIES
+        if (airTime)
+            airTime->logDuplicate();
+#endif
         stopRetransmission(p->from, p->id);
 
         // If it was a fallback to flooding, try to relay again
@@ -75,6 +98,7 @@ void NextHopRouter::sniffReceived(const meshtastic_MeshPacket *p, const meshtast
                 // the destination
                 if (wasRelayer(p->relay_node, p->decoded.request_id, p->to) ||
                     (wasRelayer(ourRelayID, p->decoded.request_id, p->to) && p->hop_start != 0 && p->hop_start == p->hop_limit)) {
+                    routes.delivered(p->from, p->relay_node, p->rx_snr, millis());
                     if (origTx->next_hop != p->relay_node) { // Not already set
                         LOG_INFO("Update next hop of 0x%x to 0x%x based on ACK/reply", p->from, p->relay_node);
                         origTx->next_hop = p->relay_node;
@@ -101,6 +125,8 @@ bool NextHopRouter::perhapsRelay(const meshtastic_MeshPacket *p)
     if (!isToUs(p) && !isFromUs(p) && p->hop_limit > 0) {
         if (p->next_hop == NO_NEXT_HOP_PREFERENCE || p->next_hop == nodeDB->getLastByteOfNodeNum(getNodeNum())) {
             if (isRebroadcaster()) {
+                if (shouldDownsampleRelay(p))
+                    return false;
                 meshtastic_MeshPacket *tosend = packetPool.allocCopy(*p); // keep a copy because we will be sending it
                 LOG_INFO("Relaying received message coming from %x", p->relay_node);
 
@@ -117,6 +143,14 @@ bool NextHopRouter::perhapsRelay(const meshtastic_MeshPacket *p)
     return false;
 }
 
+void NextHopRouter::learnRoute(NodeNum dest, NodeNum via, float snr)
+{
+    if (isBroadcast(dest) || isBroadcast(via) || dest == getNodeNum() || via == getNodeNum())
+        return;
+    LOG_DEBUG("Route to 0x%x through 0x%x learned from a traceroute", dest, via);
+    routes.delivered(dest, nodeDB->getLastByteOfNodeNum(via), snr, millis());
+}
+
 /**
  * Get the next hop for a destination, given the relay node
  * @return the node number of the next hop, 0 if no preference (fallback to FloodingRouter)
@@ -127,6 +161,11 @@ uint8_t NextHopRouter::getNextHop(NodeNum to, uint8_t relay_node)
     if (isBroadcast(to))
         return NO_NEXT_HOP_PREFERENCE;
 
+    // The best of the relays that have been delivering for this destination lately, if we know any
+    uint8_t hop;
+    if (routes.pick(to, relay_node, millis(), hop))
+        return hop;
+
     meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(to);
     if (node && node->next_hop) {
         // We are careful not to return the relay node as the next hop
@@ -135,17 +174,18 @@ uint8_t NextHopRouter::getNextHop(NodeNum to, uint8_t relay_node)
             return node->next_hop;
         } else
             LOG_WARN("Next hop for 0x%x is 0x%x, same as relayer; set no pref", to, node->next_hop);
+    } else if (neighborTable.findCurrent(to, getTime())) {
+        // Not learned from an ACK yet, but we hear the destination directly, so nobody else needs to relay it
+        uint8_t direct = nodeDB->getLastByteOfNodeNum(to);
+        if (direct != relay_node)
+            return direct;
     }
     return NO_NEXT_HOP_PREFERENCE;
 }
 
 PendingPacket *NextHopRouter::findPendingPacket(GlobalPacketId key)
 {
-    auto old = pending.find(key); // If we have an old record, someone messed up because id got reused
-    if (old != pending.end()) {
-        return &old->second;
-    } else
-        return NULL;
+    return pending.find(key);
 }
 
 /**
@@ -166,17 +206,17 @@ bool NextHopRouter::stopRetransmission(GlobalPacketId key)
           to avoid canceling a transmission if it was ACKed super fast via MQTT */
         if (old->numRetransmissions < NUM_RELIABLE_RETX - 1) {
             // We only cancel it if we are the original sender or if we're not a router(_late)/repeater
-            if (isFromUs(p) || (config.device.role != meshtastic_Config_DeviceConfig_Role_ROUTER &&
-                                config.device.role != meshtastic_Config_DeviceConfig_Role_REPEATER &&
-                                config.device.role != meshtastic_Config_DeviceConfig_Role_ROUTER_LATE)) {
+            if (isFromUs(p) || (routingRole() != meshtastic_Config_DeviceConfig_Role_ROUTER &&
+                                routingRole() != meshtastic_Config_DeviceConfig_Role_REPEATER &&
+                                routingRole() != meshtastic_Config_DeviceConfig_Role_ROUTER_LATE)) {
                 // remove the 'original' (identified by originator and packet->id) from the txqueue and free it
                 cancelSending(getFrom(p), p->id);
                 // now free the pooled copy for retransmission too
                 packetPool.release(p);
             }
         }
-        auto numErased = pending.erase(key);
-        assert(numErased == 1);
+        bool erased = pending.erase(key);
+        assert(erased);
         return true;
     } else
         return false;
@@ -188,14 +228,51 @@ bool NextHopRouter::stopRetransmission(GlobalPacketId key)
 PendingPacket *NextHopRouter::startRetransmission(meshtastic_MeshPacket *p, uint8_t numReTx)
 {
     auto id = GlobalPacketId(p);
-    auto rec = PendingPacket(p, numReTx);
 
     stopRetransmission(getFrom(p), p->id);
 
-    setNextTx(&rec);
-    pending[id] = rec;
+    PendingPacket *rec = pending.insert(id, PendingPacket(p, numReTx));
+    if (!rec && evictPendingPacket(isFromUs(p)))
+        rec = pending.insert(id, PendingPacket(p, numReTx));
+    if (!rec) {
+        LOG_WARN("Too many pending retransmissions, not retransmitting id=0x%x", p->id);
+        packetPool.release(p);
+        return NULL;
+    }
+    setNextTx(rec); // after inserting, so the timer entry is valid
 
-    return &pending[id];
+    return rec;
+}
+
+bool NextHopRouter::evictPendingPacket(bool forOurs)
+{
+    GlobalPacketId victim;
+    bool found = false, victimOurs = false;
+    uint8_t victimLeft = 0;
+    pending.forEach([&](const GlobalPacketId &id, PendingPacket &p) {
+        bool ours = isFromUs(p.packet);
+        if (ours && !forOurs)
+            return;
+        if (!found || (victimOurs && !ours) || (victimOurs == ours && p.numRetransmissions < victimLeft)) {
+            victim = id;
+            victimOurs = ours;
+            victimLeft = p.numRetransmissions;
+            found = true;
+        }
+    });
+    if (!found)
+        return false;
+
+    // stopRetransmission() may free the packet, so take what the NAK needs first
+    PendingPacket *p = findPendingPacket(victim);
+    NodeNum from = getFrom(p->packet);
+    PacketId id = p->packet->id;
+    uint8_t channel = p->packet->channel;
+    LOG_WARN("Too many pending retransmissions, giving up on fr=0x%x,id=0x%x with %d tries left", from, id, victimLeft);
+    stopRetransmission(victim);
+    if (victimOurs)
+        sendAckNak(meshtastic_Routing_Error_MAX_RETRANSMIT, from, id, channel);
+    return true;
 }
 
 /**
@@ -204,73 +281,107 @@ PendingPacket *NextHopRouter::startRetransmission(meshtastic_MeshPacket *p, uint
 int32_t NextHopRouter::doRetransmissions()
 {
     uint32_t now = millis();
-    int32_t d = INT32_MAX;
-
-    // FIXME, we should use a better datastructure rather than walking through this map.
-    // for(auto el: pending) {
-    for (auto it = pending.begin(), nextIt = it; it != pending.end(); it = nextIt) {
-        ++nextIt; // we use this odd pattern because we might be deleting it...
-        auto &p = it->second;
-
-        bool stillValid = true; // assume we'll keep this record around
-
-        // FIXME, handle 51 day rolloever here!!!
-        if (p.nextTxMsec <= now) {
-            if (p.numRetransmissions == 0) {
-                if (isFromUs(p.packet)) {
-                    LOG_DEBUG("Reliable send failed, returning a nak for fr=0x%x,to=0x%x,id=0x%x", p.packet->from, p.packet->to,
-                              p.packet->id);
-                    sendAckNak(meshtastic_Routing_Error_MAX_RETRANSMIT, getFrom(p.packet), p.packet->id, p.packet->channel);
-                }
-                // Note: we don't stop retransmission here, instead the Nak packet gets processed in sniffReceived
-                stopRetransmission(it->first);
-                stillValid = false; // just deleted it
-            } else {
-                LOG_DEBUG("Sending retransmission fr=0x%x,to=0x%x,id=0x%x, tries left=%d", p.packet->from, p.packet->to,
-                          p.packet->id, p.numRetransmissions);
-
-                if (!isBroadcast(p.packet->to)) {
-                    if (p.numRetransmissions == 1) {
-                        // Last retransmission, reset next_hop (fallback to FloodingRouter)
-                        p.packet->next_hop = NO_NEXT_HOP_PREFERENCE;
-                        // Also reset it in the nodeDB
-                        meshtastic_NodeInfoLite *sentTo = nodeDB->getMeshNode(p.packet->to);
-                        if (sentTo) {
-                            LOG_INFO("Resetting next hop for packet with dest 0x%x\n", p.packet->to);
-                            sentTo->next_hop = NO_NEXT_HOP_PREFERENCE;
-                        }
-                        FloodingRouter::send(packetPool.allocCopy(*p.packet));
-                    } else {
-                        NextHopRouter::send(packetPool.allocCopy(*p.packet));
+
+    while (!retransmissionTimers.empty()) {
+        RetransmissionTimer t = retransmissionTimers.front();
+        PendingPacket *found = findPendingPacket(t.id);
+        if (!found || found->nextTxMsec != t.nextTxMsec) {
+            // Stopped or rescheduled since this entry was added
+            std::pop_heap(retransmissionTimers.begin(), retransmissionTimers.end(), retransmissionTimerLater);
+            retransmissionTimers.pop_back();
+            continue;
+        }
+
+        int32_t wait = (int32_t)(t.nextTxMsec - now);
+        if (wait > 0)
+            return wait; // nothing else is due yet
+
+        std::pop_heap(retransmissionTimers.begin(), retransmissionTimers.end(), retransmissionTimerLater);
+        retransmissionTimers.pop_back();
+
+        auto &p = *found;
+        if (p.numRetransmissions == 0) {
+            if (isFromUs(p.packet)) {
+                LOG_DEBUG("Reliable send failed, returning a nak for fr=0x%x,to=0x%x,id=0x%x", p.packet->from, p.packet->to,
+                          p.packet->id);
+                sendAckNak(meshtastic_Routing_Error_MAX_RETRANSMIT, getFrom(p.packet), p.packet->id, p.packet->channel);
+            }
+            // Note: we don't stop retransmission here, instead the Nak packet gets processed in sniffReceived
+            stopRetransmission(t.id);
+        } else {
+            LOG_DEBUG("Sending retransmission fr=0x%x,to=0x%x,id=0x%x, tries left=%d", p.packet->from, p.packet->to, p.packet->id,
+                      p.numRetransmissions);
+
+            if (!isBroadcast(p.packet->to)) {
+                // The hop we tried didn't get it through, so getNextHop() may prefer another candidate this time
+                routes.missed(p.packet->to, p.packet->next_hop);
+                if (p.numRetransmissions == 1) {
+                    // Last retransmission, reset next_hop (fallback to FloodingRouter)
+                    p.packet->next_hop = NO_NEXT_HOP_PREFERENCE;
+                    // Also reset it in the nodeDB
+                    meshtastic_NodeInfoLite *sentTo = nodeDB->getMeshNode(p.packet->to);
+                    if (sentTo) {
+                        LOG_INFO("Resetting next hop for packet with dest 0x%x\n", p.packet->to);
+                        sentTo->next_hop = NO_NEXT_HOP_PREFERENCE;
                     }
-                } else {
-                    // Note: we call the superclass version because we don't want to have our version of send() add a new
-                    // retransmission record
                     FloodingRouter::send(packetPool.allocCopy(*p.packet));
+                } else {
+                    NextHopRouter::send(packetPool.allocCopy(*p.packet));
                 }
+            } else {
+                // Note: we call the superclass version because we don't want to have our version of send() add a new
+                // retransmission record
+                FloodingRouter::send(packetPool.allocCopy(*p.packet));
+            }
 
-                // Queue again
-                --p.numRetransmissions;
-                setNextTx(&p);
+            // Queue again, the send above may have added records so look ours up again
+            PendingPacket *again = findPendingPacket(t.id);
+            if (again) {
+                --again->numRetransmissions;
+                setNextTx(again);
             }
         }
+    }
 
-        if (stillValid) {
-            // Update our desired sleep delay
-            int32_t t = p.nextTxMsec - now;
+    return INT32_MAX;
+}
 
-            d = min(t, d);
-        }
-    }
+void NextHopRouter::scheduleRetransmission(const PendingPacket &p)
+{
+    retransmissionTimers.push_back({p.nextTxMsec, GlobalPacketId(p.packet)});
+    std::push_heap(retransmissionTimers.begin(), retransmissionTimers.end(), retransmissionTimerLater);
 
-    return d;
+    // Stopped retransmissions leave stale entries behind, don't let them pile up
+    if (retransmissionTimers.size() > 2 * pending.size() + 8)
+        rebuildRetransmissionTimers();
+}
+
+void NextHopRouter::rebuildRetransmissionTimers()
+{
+    retransmissionTimers.clear();
+    pending.forEach([this](const GlobalPacketId &id, PendingPacket &p) { retransmissionTimers.push_back({p.nextTxMsec, id}); });
+    std::make_heap(retransmissionTimers.begin(), retransmissionTimers.end(), retransmissionTimerLater);
+}
+
+void NextHopRouter::delayRetransmissions(uint32_t delayMsec, PacketId except)
+{
+    pending.forEach([=](const GlobalPacketId &id, PendingPacket &p) {
+        if (id.id != except)
+            p.nextTxMsec += delayMsec;
+    });
+    rebuildRetransmissionTimers();
 }
 
 void NextHopRouter::setNextTx(PendingPacket *pending)
 {
     assert(iface);
-    auto d = iface->getRetransmissionMsec(pending->packet);
+    uint32_t d;
+    {
+        RadioLockGuard guard;
+        d = iface->getRetransmissionMsec(pending->packet);
+    }
     pending->nextTxMsec = millis() + d;
+    scheduleRetransmission(*pending);
     LOG_DEBUG("Setting next retransmission in %u msecs: ", d);
     printPacket("", pending->packet);
     setReceivedMessage(); // Run ASAP, so we can figure out our correct sleep time
@@ -1,7 +1,14 @@
 #pragma once
 
+#include "FlatHashMap.h"
 #include "FloodingRouter.h"
-#include <unordered_map>
+#include "RouteCache.h"
+#include <vector>
+
+/// Size of the pending retransmission table (a power of two, 3/4 of it can be used)
+#ifndef PENDING_RETRANSMISSIONS_TABLE_SIZE
+#define PENDING_RETRANSMISSIONS_TABLE_SIZE 64
+#endif
 
 /**
  * An identifier for a globally unique message - a pair of the sending nodenum and the packet id assigned
@@ -13,6 +20,8 @@ struct GlobalPacketId {
 
     bool operator==(const GlobalPacketId &p) const { return node == p.node && id == p.id; }
 
+    GlobalPacketId() : node(0), id(0) {}
+
     explicit GlobalPacketId(const meshtastic_MeshPacket *p)
     {
         node = getFrom(p);
@@ -42,10 +51,20 @@ struct PendingPacket {
     explicit PendingPacket(meshtastic_MeshPacket *p, uint8_t numRetransmissions);
 };
 
+/**
+ * An entry in the retransmission schedule.  Entries are not removed when a retransmission is stopped or rescheduled, instead
+ * they are recognised as stale (the pending record is gone or has a different nextTxMsec) when they reach the top of the heap.
+ */
+struct RetransmissionTimer {
+    uint32_t nextTxMsec;
+    GlobalPacketId id;
+};
+
 class GlobalPacketIdHashFunction
 {
   public:
-    size_t operator()(const GlobalPacketId &p) const { return (std::hash<NodeNum>()(p.node)) ^ (std::hash<PacketId>()(p.id)); }
+    /// Packet ids are often sequential per node, so mix both halves rather than just xoring them
+    size_t operator()(const GlobalPacketId &p) const { return flatHashMix32(p.node * 0x9e3779b1u ^ p.id); }
 };
 
 /*
@@ -57,6 +76,8 @@ class GlobalPacketIdHashFunction
   NextHopRouter only 1 time). For the final retry, if no one actually relayed the packet, it will reset the next hop in order to
   fall back to the FloodingRouter again. Note that thus also intermediate hops will do a single retransmission if the intended
   next-hop didn’t relay, in order to fix changes in the middle of the route.
+  Every relay that delivered an ACK is kept as a candidate in a RouteCache, so when the current next hop misses a
+  retransmission the next attempt can go through another candidate rather than waiting for the final flood.
 */
 class NextHopRouter : public FloodingRouter
 {
@@ -73,6 +94,8 @@ class NextHopRouter : public FloodingRouter
      */
     virtual ErrorCode send(meshtastic_MeshPacket *p) override;
 
+    virtual void learnRoute(NodeNum dest, NodeNum via, float snr) override;
+
     /** Do our retransmission handling */
     virtual int32_t runOnce() override
     {
@@ -95,7 +118,17 @@ class NextHopRouter : public FloodingRouter
     /**
      * Pending retransmissions
      */
-    std::unordered_map<GlobalPacketId, PendingPacket, GlobalPacketIdHashFunction> pending;
+    FlatHashMap<GlobalPacketId, PendingPacket, PENDING_RETRANSMISSIONS_TABLE_SIZE, GlobalPacketIdHashFunction> pending;
+
+    /**
+     * Candidate next hops per destination, learned from ACKs and replies
+     */
+    RouteCache routes;
+
+    /**
+     * Min-heap of retransmission times, so doRetransmissions only touches entries that are due
+     */
+    std::vector<RetransmissionTimer> retransmissionTimers;
 
     /**
      * Should this incoming filter be dropped?
@@ -118,6 +151,8 @@ class NextHopRouter : public FloodingRouter
 
     /**
      * Add p to the list of packets to retransmit occasionally.  We will free it once we stop retransmitting.
+     * If the pending table is full an entry is evicted to make room (see evictPendingPacket()), and if there is none p is
+     * freed right away and NULL is returned.  That can only happen for a packet we are relaying, never for one of ours.
      */
     PendingPacket *startRetransmission(meshtastic_MeshPacket *p, uint8_t numReTx = NUM_INTERMEDIATE_RETX);
 
@@ -138,7 +173,27 @@ class NextHopRouter : public FloodingRouter
 
     void setNextTx(PendingPacket *pending);
 
+    /**
+     * Push back all pending retransmissions (except those for packet id 'except') by delayMsec
+     */
+    void delayRetransmissions(uint32_t delayMsec, PacketId except);
+
   private:
+    /// Add a timer entry for a pending packet whose nextTxMsec has just been set
+    void scheduleRetransmission(const PendingPacket &p);
+
+    /// Rebuild the timer heap from the pending records, dropping all stale entries
+    void rebuildRetransmissionTimers();
+
+    /**
+     * Make room in the full pending table by stopping the entry with the fewest retransmissions left.  Packets we are only
+     * relaying go first, as their sender retransmits them anyway; one of ours is only evicted for another of ours, and its
+     * sender gets the same MAX_RETRANSMIT NAK as if it had run out of retransmissions.
+     *
+     * @return false if there is nothing that may be evicted for a packet from us (forOurs) or one we relay
+     */
+    bool evictPendingPacket(bool forOurs);
+
     /**
      * Get the next hop for a destination, given the relay node
      * @return the node number of the next hop, 0 if no preference (fallback to FloodingRouter)
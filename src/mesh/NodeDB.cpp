@@ -6,6 +6,7 @@
 #include "Channels.h"
 #include "CryptoEngine.h"
 #include "Default.h"
+#include "EventTrace.h"
 #include "FSCommon.h"
 #include "MeshRadio.h"
 #include "MeshService.h"
@@ -18,6 +19,7 @@
 #include "SafeFile.h"
 #include "TypeConversions.h"
 #include "error.h"
+#include "gps/GeoCoord.h"
 #include "main.h"
 #include "mesh-pb-constants.h"
 #include "meshUtils.h"
@@ -191,11 +193,24 @@ uint32_t error_address = 0;
 
 static uint8_t ourMacAddr[6];
 
+static bool meshNodeBefore(const meshtastic_NodeInfoLite &a, const meshtastic_NodeInfoLite &b);
+
 NodeDB::NodeDB()
 {
     LOG_INFO("Init NodeDB");
+    // Random, so clients can't mistake a generation from before a reboot for one of ours
+    syncGenerationBase = syncGeneration = (uint32_t)random(1, 1 << (NODE_SYNC_GENERATION_BITS - 12)) << 12;
     loadFromDisk();
+#if NODEDB_INCREMENTAL_MAINTENANCE
+    // NodeDBMaintenance purges these once we are running.  Only these: a node first heard since then may not have sent its
+    // user yet
+    for (int i = 0; i < numMeshNodes; i++)
+        if (!meshNodes->at(i).has_user)
+            maintainUnnamed.push_back(meshNodes->at(i).num);
+    std::sort(maintainUnnamed.begin(), maintainUnnamed.end());
+#else
     cleanupMeshDB();
+#endif
 
     uint32_t devicestateCRC = crc32Buffer(&devicestate, sizeof(devicestate));
     uint32_t nodeDatabaseCRC = crc32Buffer(&nodeDatabase, sizeof(nodeDatabase));
@@ -302,6 +317,11 @@ NodeDB::NodeDB()
     meshtastic_NodeInfoLite *info = getOrCreateMeshNode(getNodeNum());
     info->user = TypeConversions::ConvertToUserLite(owner);
     info->has_user = true;
+#if NODEDB_INCREMENTAL_MAINTENANCE
+    // What we saved was in order, and loadFromDisk() indexed it, so this only costs a look at each node
+    if (!std::is_sorted(meshNodes->begin(), meshNodes->begin() + numMeshNodes, meshNodeBefore))
+#endif
+        sortMeshDB(); // Establish the ordering that repositionMeshNode() maintains from here on
 
     // If node database has not been saved for the first time, save it now
 #ifdef FSCom
@@ -458,15 +478,16 @@ bool NodeDB::factoryReset(bool eraseBleBonds)
 {
     LOG_INFO("Perform factory reset!");
     // first, remove the "/prefs" (this removes most prefs)
-    spiLock->lock();
-    rmDir("/prefs"); // this uses spilock internally...
+    fsLock->lock();
+    rmDir("/prefs"); // this uses fsLock internally...
 
 #ifdef FSCom
     if (FSCom.exists("/static/rangetest.csv") && !FSCom.remove("/static/rangetest.csv")) {
         LOG_ERROR("Could not remove rangetest.csv file");
     }
+    invalidateFileManifest();
 #endif
-    spiLock->unlock();
+    fsLock->unlock();
     // second, install default state (this will deal with the duplicate mac address issue)
     installDefaultNodeDatabase();
     installDefaultDeviceState();
@@ -499,6 +520,7 @@ void NodeDB::installDefaultNodeDatabase()
     nodeDatabase.nodes = std::vector<meshtastic_NodeInfoLite>(MAX_NUM_NODES);
     numMeshNodes = 0;
     meshNodes = &nodeDatabase.nodes;
+    rebuildNodeIndex();
 }
 
 void NodeDB::installDefaultConfig(bool preserveKey = false)
@@ -544,6 +566,9 @@ void NodeDB::installDefaultConfig(bool preserveKey = false)
 #else
     config.device.role = meshtastic_Config_DeviceConfig_Role_CLIENT; // Default to client.
 #endif
+#ifdef ROUTER_FIXED_ROLE
+    config.device.role = ROUTER_FIXED_ROLE;
+#endif
 
 #ifdef USERPREFS_CONFIG_LORA_REGION
     config.lora.region = USERPREFS_CONFIG_LORA_REGION;
@@ -956,8 +981,12 @@ void NodeDB::resetNodes()
         clearLocalPosition();
     numMeshNodes = 1;
     std::fill(nodeDatabase.nodes.begin() + 1, nodeDatabase.nodes.end(), meshtastic_NodeInfoLite());
+    rebuildNodeIndex();
     devicestate.has_rx_text_message = false;
     devicestate.has_rx_waypoint = false;
+#if NODEDB_JOURNAL
+    journalValid = false; // Cheaper to write the near empty database than journal removing every node
+#endif
     saveNodeDatabaseToDisk();
     saveDeviceStateToDisk();
     if (neighborInfoModule && moduleConfig.neighbor_info.enabled)
@@ -976,6 +1005,7 @@ void NodeDB::removeNodeByNum(NodeNum nodeNum)
     numMeshNodes -= removed;
     std::fill(nodeDatabase.nodes.begin() + numMeshNodes, nodeDatabase.nodes.begin() + numMeshNodes + 1,
               meshtastic_NodeInfoLite());
+    rebuildNodeIndex();
     LOG_DEBUG("NodeDB::removeNodeByNum purged %d entries. Save changes", removed);
     saveNodeDatabaseToDisk();
 }
@@ -987,6 +1017,7 @@ void NodeDB::clearLocalPosition()
     node->position.longitude_i = 0;
     node->position.altitude = 0;
     node->position.time = 0;
+    indexPosition(node);
     setLocalPosition(meshtastic_Position_init_default);
 }
 
@@ -1008,9 +1039,73 @@ void NodeDB::cleanupMeshDB()
     numMeshNodes -= removed;
     std::fill(nodeDatabase.nodes.begin() + numMeshNodes, nodeDatabase.nodes.begin() + numMeshNodes + removed,
               meshtastic_NodeInfoLite());
+    rebuildNodeIndex();
     LOG_DEBUG("cleanupMeshDB purged %d entries", removed);
 }
 
+void NodeDB::eraseMeshNodeAt(int i)
+{
+    // Only the entries behind the erased one need to move down
+    meshtastic_NodeInfoLite &node = meshNodes->at(i);
+    countOnline(&node, -1);
+    nodeIndex.erase(node.num);
+    if (positionIndex.isAllocated())
+        positionIndex.update(node.num, 0, 0, false);
+    std::move(meshNodes->begin() + i + 1, meshNodes->begin() + numMeshNodes, meshNodes->begin() + i);
+    numMeshNodes--;
+    meshNodes->at(numMeshNodes) = meshtastic_NodeInfoLite();
+    for (int j = i; j < numMeshNodes; j++)
+        nodeIndex.insert(meshNodes->at(j).num, j);
+    changeCount++;
+}
+
+#if NODEDB_INCREMENTAL_MAINTENANCE
+bool NodeDB::maintainNodes(size_t maxNodes)
+{
+    if (maintainCursor < 0) {
+        maintainCursor = numMeshNodes - 1;
+        maintainRemoved = 0;
+    }
+    if (maintainCursor >= numMeshNodes) // nodes were dropped meanwhile
+        maintainCursor = numMeshNodes - 1;
+
+#if NODEDB_EXPIRE_SECS
+    uint32_t now = getValidTime(RTCQualityFromNet);
+#endif
+    for (; maxNodes > 0 && maintainCursor >= 0; maxNodes--, maintainCursor--) {
+        meshtastic_NodeInfoLite &node = meshNodes->at(maintainCursor);
+        if (node.num == getNodeNum())
+            continue;
+
+        bool drop = maintainBootPass && !node.has_user &&
+                    std::binary_search(maintainUnnamed.begin(), maintainUnnamed.end(), node.num);
+#if NODEDB_EXPIRE_SECS
+        // Without the time we can't tell how long ago anything was heard
+        if (now > NODEDB_EXPIRE_SECS && node.last_heard && node.last_heard < now - NODEDB_EXPIRE_SECS && !node.is_favorite &&
+            !node.is_ignored && !(node.bitfield & NODEINFO_BITFIELD_IS_KEY_MANUALLY_VERIFIED_MASK))
+            drop = true;
+#endif
+        if (drop) {
+            eraseMeshNodeAt(maintainCursor);
+            maintainRemoved++;
+        } else if (node.user.public_key.size > 0 && memfll(node.user.public_key.bytes, 0, node.user.public_key.size)) {
+            node.user.public_key.size = 0;
+        }
+    }
+    if (maintainCursor >= 0)
+        return true;
+
+    LOG_DEBUG("NodeDB maintenance purged %u entries", maintainRemoved);
+    if (maintainRemoved) {
+        saveToDiskSoon(SEGMENT_NODEDATABASE);
+        notifyObservers();
+    }
+    maintainBootPass = false;
+    std::vector<NodeNum>().swap(maintainUnnamed);
+    return false;
+}
+#endif
+
 void NodeDB::installDefaultDeviceState()
 {
     LOG_INFO("Install default DeviceState");
@@ -1075,23 +1170,62 @@ void NodeDB::pickNewNodeNum()
 }
 
 /** Load a protobuf from a file, return LoadFileResult */
+#if defined(FSCom) && !SAFEFILE_VERIFY_ON_WRITE
+// Feeds the decoder like readcb while keeping the CRC of everything read, so loading verifies the file without a second pass
+struct VerifyingReader {
+    File *file;
+    uint32_t crc;
+};
+
+static bool verifyingReadcb(pb_istream_t *stream, uint8_t *buf, size_t count)
+{
+    auto reader = (VerifyingReader *)stream->state;
+    uint8_t skipped[16];
+    while (!buf && count) { // Skipping an unknown field, still count it
+        size_t n = std::min(count, sizeof(skipped));
+        if (reader->file->read(skipped, n) != (int)n)
+            return false;
+        reader->crc = SafeFile::crc32(reader->crc, skipped, n);
+        count -= n;
+    }
+    if (!buf)
+        return true;
+
+    stream->state = reader->file;
+    bool status = readcb(stream, buf, count);
+    stream->state = reader;
+    if (status)
+        reader->crc = SafeFile::crc32(reader->crc, buf, count);
+    return status;
+}
+#endif
+
 LoadFileResult NodeDB::loadProto(const char *filename, size_t protoSize, size_t objSize, const pb_msgdesc_t *fields,
                                  void *dest_struct)
 {
     LoadFileResult state = LoadFileResult::OTHER_FAILURE;
 #ifdef FSCom
-    concurrency::LockGuard g(spiLock);
+    concurrency::LockGuard g(fsLock);
 
     auto f = FSCom.open(filename, FILE_O_READ);
 
     if (f) {
         LOG_INFO("Load %s", filename);
+#if !SAFEFILE_VERIFY_ON_WRITE
+        VerifyingReader reader = {&f, 0};
+        pb_istream_t stream = {&verifyingReadcb, &reader, protoSize};
+#else
         pb_istream_t stream = {&readcb, &f, protoSize};
+#endif
 
         memset(dest_struct, 0, objSize);
         if (!pb_decode(&stream, fields, dest_struct)) {
             LOG_ERROR("Error: can't decode protobuf %s", PB_GET_ERROR(&stream));
             state = LoadFileResult::DECODE_FAILED;
+#if !SAFEFILE_VERIFY_ON_WRITE
+        } else if (!SafeFile::checkOnLoad(filename, reader.crc)) {
+            state = LoadFileResult::DECODE_FAILED;
+#endif
         } else {
             LOG_INFO("Loaded %s successfully", filename);
             state = LoadFileResult::LOAD_SUCCESS;
@@ -1116,16 +1250,16 @@ void NodeDB::loadFromDisk()
     meshtastic_Config_SecurityConfig backupSecurity = meshtastic_Config_SecurityConfig_init_zero;
 
 #ifdef ARCH_ESP32
-    spiLock->lock();
+    fsLock->lock();
     // If the legacy deviceState exists, start over with a factory reset
     if (FSCom.exists("/static/static"))
         rmDir("/static/static"); // Remove bad static web files bundle from initial 2.5.13 release
-    spiLock->unlock();
+    fsLock->unlock();
 #endif
 #ifdef FSCom
-    spiLock->lock();
+    fsLock->lock();
     if (FSCom.exists(legacyPrefFileName)) {
-        spiLock->unlock();
+        fsLock->unlock();
         LOG_WARN("Legacy prefs version found, factory resetting");
         if (loadProto(configFileName, meshtastic_LocalConfig_size, sizeof(meshtastic_LocalConfig), &meshtastic_LocalConfig_msg,
                       &config) == LoadFileResult::LOAD_SUCCESS &&
@@ -1133,20 +1267,35 @@ void NodeDB::loadFromDisk()
             LOG_DEBUG("Saving backup of security config and keys");
             backupSecurity = config.security;
         }
-        spiLock->lock();
+        fsLock->lock();
         rmDir("/prefs");
-        spiLock->unlock();
+        fsLock->unlock();
     } else {
-        spiLock->unlock();
+        fsLock->unlock();
     }
 
 #endif
-    auto state = loadProto(nodeDatabaseFileName, getMaxNodesAllocatedSize(), sizeof(meshtastic_NodeDatabase),
-                           &meshtastic_NodeDatabase_msg, &nodeDatabase);
+    bool mapped = false; // the nodes came from nodes.map, see NODEDB_MMAP
+#if NODEDB_MMAP
+    mapped = openNodeMap();
+#endif
+    auto state = mapped ? LoadFileResult::LOAD_SUCCESS
+                        : loadProto(nodeDatabaseFileName, getMaxNodesAllocatedSize(), sizeof(meshtastic_NodeDatabase),
+                                    &meshtastic_NodeDatabase_msg, &nodeDatabase);
+#if NODEDB_JOURNAL
+    uint32_t journalRecords = 0;
+    journalValid = false; // Until we know nodes.proto is good, the next save writes it whole
+#endif
     if (nodeDatabase.version < DEVICESTATE_MIN_VER) {
         LOG_WARN("NodeDatabase %d is old, discard", nodeDatabase.version);
         installDefaultNodeDatabase();
     } else {
+#if NODEDB_JOURNAL
+        if (state == LoadFileResult::LOAD_SUCCESS && !mapped) {
+            journalValid = true;
+            journalRecords = replayNodeJournal();
+        }
+#endif
         meshNodes = &nodeDatabase.nodes;
         numMeshNodes = nodeDatabase.nodes.size();
         LOG_INFO("Loaded saved nodedatabase version %d, with nodes count: %d", nodeDatabase.version, nodeDatabase.nodes.size());
@@ -1157,6 +1306,18 @@ void NodeDB::loadFromDisk()
         numMeshNodes = MAX_NUM_NODES;
     }
     meshNodes->resize(MAX_NUM_NODES + 1); // The rp2040, rp2035, and maybe other targets, have a problem doing a sort() when full
+    rebuildNodeIndex();
+#if NODEDB_JOURNAL
+    if (journalRecords)
+        sortMeshDB(); // Nodes the journal added went on the end
+    snapshotNodeJournal();
+#endif
+#if NODEDB_MMAP
+    if (mapped)
+        sortMeshDB(); // The map holds nodes in no particular order
+    else if (nodeMap.isOpen())
+        saveNodeDatabaseToDisk(); // First boot with the map, fill it from nodes.proto
+#endif
 
     // static DeviceState scratch; We no longer read into a tempbuf because this structure is 15KB of valuable RAM
     state = loadProto(deviceStateFileName, meshtastic_DeviceState_size, sizeof(meshtastic_DeviceState),
@@ -1189,6 +1350,9 @@ void NodeDB::loadFromDisk()
             LOG_INFO("Loaded saved config version %d", config.version);
         }
     }
+#ifdef ROUTER_FIXED_ROLE
+    config.device.role = ROUTER_FIXED_ROLE; // This firmware can't run as anything else
+#endif
     if (backupSecurity.private_key.size > 0) {
         LOG_DEBUG("Restoring backup of security config");
         config.security = backupSecurity;
@@ -1303,6 +1467,7 @@ void NodeDB::loadFromDisk()
 bool NodeDB::saveProto(const char *filename, size_t protoSize, const pb_msgdesc_t *fields, const void *dest_struct,
                        bool fullAtomic)
 {
+    TRACE_SCOPE(filename);
     bool okay = false;
 #ifdef FSCom
     auto f = SafeFile(filename, fullAtomic);
@@ -1315,6 +1480,7 @@ bool NodeDB::saveProto(const char *filename, size_t protoSize, const pb_msgdesc_
     } else {
         okay = true;
     }
+    bytesSaved += stream.bytes_written;
 
     bool writeSucceeded = f.close();
 
@@ -1330,9 +1496,9 @@ bool NodeDB::saveProto(const char *filename, size_t protoSize, const pb_msgdesc_
 bool NodeDB::saveChannelsToDisk()
 {
 #ifdef FSCom
-    spiLock->lock();
+    fsLock->lock();
     FSCom.mkdir("/prefs");
-    spiLock->unlock();
+    fsLock->unlock();
 #endif
     return saveProto(channelFileName, meshtastic_ChannelFile_size, &meshtastic_ChannelFile_msg, &channelFile);
 }
@@ -1340,9 +1506,9 @@ bool NodeDB::saveChannelsToDisk()
 bool NodeDB::saveDeviceStateToDisk()
 {
 #ifdef FSCom
-    spiLock->lock();
+    fsLock->lock();
     FSCom.mkdir("/prefs");
-    spiLock->unlock();
+    fsLock->unlock();
 #endif
     // Note: if MAX_NUM_NODES=100 and meshtastic_NodeInfoLite_size=166, so will be approximately 17KB
     // Because so huge we _must_ not use fullAtomic, because the filesystem is probably too small to hold two copies of this
@@ -1352,22 +1518,244 @@ bool NodeDB::saveDeviceStateToDisk()
 bool NodeDB::saveNodeDatabaseToDisk()
 {
 #ifdef FSCom
-    spiLock->lock();
+    fsLock->lock();
     FSCom.mkdir("/prefs");
-    spiLock->unlock();
+    fsLock->unlock();
+#endif
+#if NODEDB_MMAP
+    if (nodeMap.isOpen()) {
+        uint32_t written;
+        bool okay = nodeMap.save(meshNodes->data(), numMeshNodes, &written);
+        bytesSaved += written;
+        if (written)
+            LOG_INFO("Saved %u bytes of changed nodes to %s", written, nodeMapFileName);
+        return okay;
+    }
+#endif
+#if NODEDB_JOURNAL
+    // Routine changes only append the nodes that changed. Once the journal gets long, the whole database is rewritten
+    if (journalValid && journalBytes < NODEDB_JOURNAL_MAX_BYTES && appendNodeJournal())
+        return true;
+
+    // Before writing the new nodes.proto, so an old journal can never be replayed on top of it
+    fsLock->lock();
+    if (FSCom.exists(nodeJournalFileName))
+        FSCom.remove(nodeJournalFileName);
+    fsLock->unlock();
+    invalidateFileManifest();
 #endif
     size_t nodeDatabaseSize;
     pb_get_encoded_size(&nodeDatabaseSize, meshtastic_NodeDatabase_fields, &nodeDatabase);
-    return saveProto(nodeDatabaseFileName, nodeDatabaseSize, &meshtastic_NodeDatabase_msg, &nodeDatabase, false);
+    bool okay = saveProto(nodeDatabaseFileName, nodeDatabaseSize, &meshtastic_NodeDatabase_msg, &nodeDatabase, false);
+#if NODEDB_JOURNAL
+    snapshotNodeJournal();
+    journalBytes = 0;
+    journalValid = okay;
+#endif
+    return okay;
+}
+
+#if NODEDB_JOURNAL
+/*
+Each journal record is [u8 type][u16 payload length][payload][u32 CRC32 of everything before it], little endian.
+An UPSERT payload is the node's NodeInfoLite protobuf, which replaces any node with the same num. A REMOVE payload is a u32 num.
+A record that fails its CRC (say, power was lost while appending it) ends the journal.
+*/
+#define JOURNAL_UPSERT 1
+#define JOURNAL_REMOVE 2
+#define JOURNAL_HEADER_SIZE 3
+#define JOURNAL_CRC_SIZE 4
+
+static uint32_t journalNodeCRC(const meshtastic_NodeInfoLite &node)
+{
+    return crc32Buffer(&node, sizeof(node));
+}
+
+static size_t writeJournalRecord(File &f, uint8_t type, const uint8_t *payload, uint16_t len)
+{
+    uint8_t record[JOURNAL_HEADER_SIZE + meshtastic_NodeInfoLite_size + JOURNAL_CRC_SIZE];
+    record[0] = type;
+    record[1] = len;
+    record[2] = len >> 8;
+    memcpy(record + JOURNAL_HEADER_SIZE, payload, len);
+    uint32_t crc = crc32Buffer(record, JOURNAL_HEADER_SIZE + len);
+    for (uint8_t i = 0; i < JOURNAL_CRC_SIZE; i++)
+        record[JOURNAL_HEADER_SIZE + len + i] = crc >> (8 * i);
+
+    size_t size = JOURNAL_HEADER_SIZE + len + JOURNAL_CRC_SIZE;
+    return f.write(record, size) == size ? size : 0;
 }
 
+uint32_t NodeDB::replayNodeJournal()
+{
+    concurrency::LockGuard g(fsLock);
+    journalBytes = 0;
+    if (!FSCom.exists(nodeJournalFileName))
+        return 0;
+    auto f = FSCom.open(nodeJournalFileName, FILE_O_READ);
+    if (!f)
+        return 0;
+
+    std::vector<meshtastic_NodeInfoLite> &nodes = nodeDatabase.nodes;
+    uint8_t record[JOURNAL_HEADER_SIZE + meshtastic_NodeInfoLite_size + JOURNAL_CRC_SIZE];
+    uint32_t applied = 0;
+    while (f.read(record, JOURNAL_HEADER_SIZE) == JOURNAL_HEADER_SIZE) {
+        uint16_t len = record[1] | (record[2] << 8);
+        if (len > meshtastic_NodeInfoLite_size ||
+            f.read(record + JOURNAL_HEADER_SIZE, len + JOURNAL_CRC_SIZE) != (size_t)(len + JOURNAL_CRC_SIZE))
+            break;
+        const uint8_t *crcBytes = record + JOURNAL_HEADER_SIZE + len;
+        uint32_t crc = crcBytes[0] | (crcBytes[1] << 8) | (crcBytes[2] << 16) | ((uint32_t)crcBytes[3] << 24);
+        if (crc != crc32Buffer(record, JOURNAL_HEADER_SIZE + len))
+            break;
+
+        const uint8_t *payload = record + JOURNAL_HEADER_SIZE;
+        if (record[0] == JOURNAL_UPSERT) {
+            meshtastic_NodeInfoLite node = meshtastic_NodeInfoLite_init_default;
+            pb_istream_t stream = pb_istream_from_buffer(payload, len);
+            if (!pb_decode(&stream, meshtastic_NodeInfoLite_fields, &node) || node.num == 0)
+                break;
+            auto it = std::find_if(nodes.begin(), nodes.end(),
+                                   [&node](const meshtastic_NodeInfoLite &n) { return n.num == node.num; });
+            if (it == nodes.end()) // New node: into an unused slot, if nodes.proto left one
+                it = std::find_if(nodes.begin(), nodes.end(), [](const meshtastic_NodeInfoLite &n) { return n.num == 0; });
+            if (it != nodes.end())
+                *it = node;
+            else
+                nodes.push_back(node);
+        } else if (record[0] == JOURNAL_REMOVE && len == 4) {
+            NodeNum num = payload[0] | (payload[1] << 8) | (payload[2] << 16) | ((uint32_t)payload[3] << 24);
+            nodes.erase(std::remove_if(nodes.begin(), nodes.end(), [num](const meshtastic_NodeInfoLite &n) { return n.num == num; }),
+                        nodes.end());
+        } else {
+            break;
+        }
+        journalBytes += JOURNAL_HEADER_SIZE + len + JOURNAL_CRC_SIZE;
+        applied++;
+    }
+
+    if (journalBytes < f.size()) {
+        LOG_WARN("Node journal damaged after %u records, ignoring the rest", applied);
+        journalValid = false; // Rewrite nodes.proto, dropping the damaged tail from the journal
+    }
+    f.close();
+    LOG_INFO("Replayed %u node journal records", applied);
+    return applied;
+}
+
+bool NodeDB::appendNodeJournal()
+{
+    // Where each node stands now, compared with what is on flash
+    std::vector<JournalEntry> current;
+    current.reserve(numMeshNodes);
+    for (int i = 0; i < numMeshNodes; i++) {
+        const meshtastic_NodeInfoLite &node = meshNodes->at(i);
+        if (node.num != 0)
+            current.push_back(JournalEntry{node.num, journalNodeCRC(node)});
+    }
+    std::sort(current.begin(), current.end(), [](const JournalEntry &a, const JournalEntry &b) { return a.num < b.num; });
+
+    std::vector<NodeNum> removed, changed;
+    auto old = journalNodes.begin();
+    for (const JournalEntry &e : current) {
+        while (old != journalNodes.end() && old->num < e.num)
+            removed.push_back((old++)->num);
+        if (old != journalNodes.end() && old->num == e.num) {
+            if (old->crc != e.crc)
+                changed.push_back(e.num);
+            ++old;
+        } else {
+            changed.push_back(e.num); // Added
+        }
+    }
+    for (; old != journalNodes.end(); ++old)
+        removed.push_back(old->num);
+
+    if (removed.empty() && changed.empty())
+        return true;
+
+    concurrency::LockGuard g(fsLock);
+    if (!FSCom.exists(nodeDatabaseFileName))
+        return false; // Nothing for the journal to apply to
+    auto f = FSCom.open(nodeJournalFileName, FILE_O_APPEND);
+    if (!f)
+        return false;
+    invalidateFileManifest();
+
+    uint32_t written = 0;
+    bool okay = true;
+    for (NodeNum num : removed) {
+        uint8_t payload[4] = {(uint8_t)num, (uint8_t)(num >> 8), (uint8_t)(num >> 16), (uint8_t)(num >> 24)};
+        size_t size = writeJournalRecord(f, JOURNAL_REMOVE, payload, sizeof(payload));
+        okay &= size != 0;
+        written += size;
+    }
+    uint8_t payload[meshtastic_NodeInfoLite_size];
+    for (NodeNum num : changed) {
+        const meshtastic_NodeInfoLite *node = getMeshNode(num);
+        pb_ostream_t stream = pb_ostream_from_buffer(payload, sizeof(payload));
+        if (!node || !pb_encode(&stream, meshtastic_NodeInfoLite_fields, node)) {
+            okay = false;
+            continue;
+        }
+        size_t size = writeJournalRecord(f, JOURNAL_UPSERT, payload, stream.bytes_written);
+        okay &= size != 0;
+        written += size;
+    }
+    f.close();
+    journalBytes += written;
+    bytesSaved += written;
+
+    if (!okay) {
+        LOG_ERROR("Can't append to node journal");
+        journalValid = false; // Whatever did get written is now stale: it is removed before nodes.proto is rewritten
+        return false;
+    }
+    journalNodes.swap(current);
+    LOG_INFO("Journaled %u changed and %u removed nodes, %u bytes (journal now %u)", (unsigned)changed.size(),
+             (unsigned)removed.size(), written, journalBytes);
+    return true;
+}
+
+void NodeDB::snapshotNodeJournal()
+{
+    journalNodes.clear();
+    journalNodes.reserve(numMeshNodes);
+    for (int i = 0; i < numMeshNodes; i++) {
+        const meshtastic_NodeInfoLite &node = meshNodes->at(i);
+        if (node.num != 0)
+            journalNodes.push_back(JournalEntry{node.num, journalNodeCRC(node)});
+    }
+    std::sort(journalNodes.begin(), journalNodes.end(),
+              [](const JournalEntry &a, const JournalEntry &b) { return a.num < b.num; });
+}
+#endif
+
+#if NODEDB_MMAP
+bool NodeDB::openNodeMap()
+{
+    fsLock->lock();
+    FSCom.mkdir("/prefs");
+    fsLock->unlock();
+    std::string path = std::string(portduinoVFS->mountpoint()) + nodeMapFileName;
+    if (!nodeMap.open(path.c_str(), MAX_NUM_NODES))
+        return false;
+
+    nodeDatabase.version = DEVICESTATE_CUR_VER;
+    nodeDatabase.nodes.clear();
+    uint32_t loaded = nodeMap.load(nodeDatabase.nodes);
+    LOG_INFO("Loaded %u nodes from %s", loaded, nodeMapFileName);
+    return loaded != 0;
+}
+#endif
+
 bool NodeDB::saveToDiskNoRetry(int saveWhat)
 {
     bool success = true;
 #ifdef FSCom
-    spiLock->lock();
+    fsLock->lock();
     FSCom.mkdir("/prefs");
-    spiLock->unlock();
+    fsLock->unlock();
 #endif
     if (saveWhat & SEGMENT_CONFIG) {
         config.has_device = true;
@@ -1417,15 +1805,17 @@ bool NodeDB::saveToDiskNoRetry(int saveWhat)
 
 bool NodeDB::saveToDisk(int saveWhat)
 {
+    TRACE_SCOPE("NodeDB::saveToDisk");
     LOG_DEBUG("Save to disk %d", saveWhat);
+    saveScheduler.saved(saveWhat);
     bool success = saveToDiskNoRetry(saveWhat);
 
     if (!success) {
         LOG_ERROR("Failed to save to disk, retrying");
 #ifdef ARCH_NRF52 // @geeksville is not ready yet to say we should do this on other platforms.  See bug #4184 discussion
-        spiLock->lock();
+        fsLock->lock();
         FSCom.format();
-        spiLock->unlock();
+        fsLock->unlock();
 
 #endif
         success = saveToDiskNoRetry(saveWhat);
@@ -1468,23 +1858,67 @@ uint32_t sinceReceived(const meshtastic_MeshPacket *p)
     return delta;
 }
 
-#define NUM_ONLINE_SECS (60 * 60 * 2) // 2 hrs to consider someone offline
-
 size_t NodeDB::getNumOnlineMeshNodes(bool localOnly)
 {
+    if (!onlineBucketsValid) {
+        memset(onlineBuckets, 0, sizeof(onlineBuckets));
+        for (int i = 0; i < numMeshNodes; i++)
+            countOnline(&meshNodes->at(i), 1);
+        onlineBucketsValid = true;
+    }
+
+    uint32_t now = getTime();
+    uint32_t newest = now / ONLINE_BUCKET_SECS;
+    uint32_t oldest = now > NUM_ONLINE_SECS ? (now - NUM_ONLINE_SECS) / ONLINE_BUCKET_SECS + 1 : 0;
     size_t numseen = 0;
+    bool exact = now > NUM_ONLINE_SECS; // Otherwise even nodes never heard from count, and those aren't in the buckets
+    for (const OnlineBucket &b : onlineBuckets) {
+        if (!b.all)
+            continue;
+        if (b.period > newest)
+            exact = false; // Our clock went back, nodes heard "later" may share slots with ones heard recently
+        else if (b.period >= oldest)
+            numseen += localOnly ? b.all - b.mqtt : b.all;
+    }
+    if (exact)
+        return numseen;
 
-    // FIXME this implementation is kinda expensive
+    numseen = 0;
     for (int i = 0; i < numMeshNodes; i++) {
         if (localOnly && meshNodes->at(i).via_mqtt)
             continue;
         if (sinceLastSeen(&meshNodes->at(i)) < NUM_ONLINE_SECS)
             numseen++;
     }
-
     return numseen;
 }
 
+void NodeDB::countOnline(const meshtastic_NodeInfoLite *node, int delta)
+{
+    if (!onlineBucketsValid || !node->last_heard)
+        return;
+    uint32_t period = node->last_heard / ONLINE_BUCKET_SECS;
+    OnlineBucket &b = onlineBuckets[period % ONLINE_BUCKETS];
+    if (b.period != period) {
+        // Whichever of the two periods is older is offline by now, unless the clock went back (see getNumOnlineMeshNodes())
+        if (delta < 0 || (b.all && b.period > period))
+            return;
+        b = {period, 0, 0};
+    }
+    if (delta < 0 && !b.all)
+        return;
+    b.all += delta;
+    if (node->via_mqtt && (delta > 0 || b.mqtt))
+        b.mqtt += delta;
+}
+
+void NodeDB::setLastHeard(meshtastic_NodeInfoLite *node, uint32_t lastHeard)
+{
+    countOnline(node, -1);
+    node->last_heard = lastHeard;
+    countOnline(node, 1);
+}
+
 #include "MeshModule.h"
 #include "Throttle.h"
 
@@ -1528,7 +1962,9 @@ void NodeDB::updatePosition(uint32_t nodeId, const meshtastic_Position &p, RxSou
             info->position.time = tmp_time;
     }
     info->has_position = true;
-    updateGUIforNode = info;
+    indexPosition(info);
+    updateGUIforNode = NodeHandle(info);
+    markNodeChanged(nodeId);
     notifyObservers(true); // Force an update whether or not our node counts have changed
 }
 
@@ -1551,7 +1987,8 @@ void NodeDB::updateTelemetry(uint32_t nodeId, const meshtastic_Telemetry &t, RxS
     }
     info->device_metrics = t.variant.device_metrics;
     info->has_device_metrics = true;
-    updateGUIforNode = info;
+    updateGUIforNode = NodeHandle(info);
+    markNodeChanged(nodeId);
     notifyObservers(true); // Force an update whether or not our node counts have changed
 }
 
@@ -1567,6 +2004,7 @@ void NodeDB::addFromContact(meshtastic_SharedContact contact)
     info->num = contact.node_num;
     info->has_user = true;
     info->user = TypeConversions::ConvertToUserLite(contact.user);
+    markNodeChanged(contact.node_num);
     if (contact.should_ignore) {
         // If should_ignore is set,
         // we need to clear the public key and other cruft, in addition to setting the node as ignored
@@ -1576,13 +2014,14 @@ void NodeDB::addFromContact(meshtastic_SharedContact contact)
         info->user.public_key.size = 0;
         info->user.public_key.bytes[0] = 0;
     } else {
-        info->last_heard = getValidTime(RTCQualityNTP);
+        setLastHeard(info, getValidTime(RTCQualityNTP));
         info->is_favorite = true;
         info->bitfield |= NODEINFO_BITFIELD_IS_KEY_MANUALLY_VERIFIED_MASK;
+        indexPublicKey(info);
         // Mark the node's key as manually verified to indicate trustworthiness.
-        updateGUIforNode = info;
+        updateGUIforNode = NodeHandle(info);
         // powerFSM.trigger(EVENT_NODEDB_UPDATED); This event has been retired
-        sortMeshDB();
+        repositionMeshNode(info->num);
         notifyObservers(true); // Force an update whether or not our node counts have changed
     }
     saveNodeDatabaseToDisk();
@@ -1622,6 +2061,9 @@ bool NodeDB::updateUser(uint32_t nodeId, meshtastic_User &p, uint8_t channelInde
         memcpy(p.public_key.bytes, info->user.public_key.bytes, 32);
     } else if (p.public_key.size > 0) {
         LOG_INFO("Update Node Pubkey!");
+        NodeNum holder = getNodeByPublicKey(p.public_key.bytes, nodeId);
+        if (holder)
+            LOG_WARN("Node 0x%08x advertised the public key of node 0x%08x", nodeId, holder);
     }
 #endif
 
@@ -1632,6 +2074,7 @@ bool NodeDB::updateUser(uint32_t nodeId, meshtastic_User &p, uint8_t channelInde
     info->user = lite;
     if (info->user.public_key.size == 32) {
         printBytes("Saved Pubkey: ", info->user.public_key.bytes, 32);
+        indexPublicKey(info);
     }
     if (nodeId != getNodeNum())
         info->channel = channelIndex; // Set channel we need to use to reach this node (but don't set our own channel)
@@ -1640,14 +2083,15 @@ bool NodeDB::updateUser(uint32_t nodeId, meshtastic_User &p, uint8_t channelInde
     info->has_user = true;
 
     if (changed) {
-        updateGUIforNode = info;
+        updateGUIforNode = NodeHandle(info);
+        markNodeChanged(nodeId);
         notifyObservers(true); // Force an update whether or not our node counts have changed
 
         // We just changed something about a User,
         // store our DB unless we just did so less than a minute ago
 
         if (!Throttle::isWithinTimespanMs(lastNodeDbSave, ONE_MINUTE_MS)) {
-            saveToDisk(SEGMENT_NODEDATABASE);
+            saveToDiskSoon(SEGMENT_NODEDATABASE);
             lastNodeDbSave = millis();
         } else {
             LOG_DEBUG("Defer NodeDB saveToDisk for now");
@@ -1673,6 +2117,7 @@ void NodeDB::updateFrom(const meshtastic_MeshPacket &mp)
             return;
         }
 
+        countOnline(info, -1);
         if (mp.rx_time) // if the packet has a valid timestamp use it to update our last_heard
             info->last_heard = mp.rx_time;
 
@@ -1680,37 +2125,234 @@ void NodeDB::updateFrom(const meshtastic_MeshPacket &mp)
             info->snr = mp.rx_snr; // keep the most recent SNR we received for this node.
 
         info->via_mqtt = mp.via_mqtt; // Store if we received this packet via MQTT
+        countOnline(info, 1);
 
         // If hopStart was set and there wasn't someone messing with the limit in the middle, add hopsAway
         if (mp.hop_start != 0 && mp.hop_limit <= mp.hop_start) {
             info->has_hops_away = true;
             info->hops_away = mp.hop_start - mp.hop_limit;
         }
-        sortMeshDB();
+        markNodeChanged(info->num);
+        repositionMeshNode(info->num);
     }
 }
 
+void NodeDB::markNodeChanged(NodeNum n)
+{
+    changeCount++;
+    auto it = std::lower_bound(nodeChanges.begin(), nodeChanges.end(), n, nodeChangeBefore);
+    if (it != nodeChanges.end() && it->num == n) {
+        it->generation = syncGeneration;
+        return;
+    }
+
+    if (nodeChanges.size() >= 2 * (size_t)MAX_NUM_NODES) {
+        // Forget nodes that have since been evicted from the DB, so this can't grow forever
+        nodeChanges.erase(std::remove_if(nodeChanges.begin(), nodeChanges.end(),
+                                         [this](const NodeChange &c) { return getMeshNode(c.num) == NULL; }),
+                          nodeChanges.end());
+        it = std::lower_bound(nodeChanges.begin(), nodeChanges.end(), n, nodeChangeBefore);
+    }
+    nodeChanges.insert(it, NodeChange{n, syncGeneration});
+}
+
+uint32_t NodeDB::getNodeChangeGeneration(NodeNum n) const
+{
+    auto it = std::lower_bound(nodeChanges.begin(), nodeChanges.end(), n, nodeChangeBefore);
+    return (it != nodeChanges.end() && it->num == n) ? it->generation : 0;
+}
+
+uint32_t NodeDB::beginNodeSync()
+{
+    uint32_t g = syncGeneration;
+    // Once the sync counter is used up we stop advancing, isValidSyncGeneration() then sends every client everything
+    if (syncGeneration - syncGenerationBase < 0xfff)
+        syncGeneration++;
+    return g;
+}
+
+bool NodeDB::isValidSyncGeneration(uint32_t g) const
+{
+    return syncGeneration - syncGenerationBase < 0xfff && g >= syncGenerationBase && g < syncGeneration;
+}
+
+void NodeDB::setFavorite(bool is_favorite, NodeNum nodeId)
+{
+    meshtastic_NodeInfoLite *lite = getMeshNode(nodeId);
+    if (lite && lite->is_favorite != is_favorite) {
+        lite->is_favorite = is_favorite;
+        markNodeChanged(nodeId);
+        repositionMeshNode(nodeId);
+    }
+}
+
+/// Display/eviction order of meshNodes: ourselves first, then favorites, then most recently heard
+static bool meshNodeBefore(const meshtastic_NodeInfoLite &a, const meshtastic_NodeInfoLite &b)
+{
+    if (a.num == myNodeInfo.my_node_num && b.num == myNodeInfo.my_node_num) // in theory impossible
+        return false;
+    if (a.num == myNodeInfo.my_node_num) {
+        return true;
+    }
+    if (b.num == myNodeInfo.my_node_num) {
+        return false;
+    }
+    bool aFav = a.is_favorite;
+    bool bFav = b.is_favorite;
+    if (aFav != bFav)
+        return aFav;
+    return a.last_heard > b.last_heard;
+}
+
+/// Full re-sort, only needed when the ordering is not yet established (boot, nodenum change) or the index is unusable.
+/// Routine updates go through repositionMeshNode() instead.
 void NodeDB::sortMeshDB()
 {
-    if (!Throttle::isWithinTimespanMs(lastSort, 1000 * 5)) {
-        lastSort = millis();
-        std::sort(meshNodes->begin(), meshNodes->begin() + numMeshNodes,
-                  [](const meshtastic_NodeInfoLite &a, const meshtastic_NodeInfoLite &b) {
-                      if (a.num == myNodeInfo.my_node_num && b.num == myNodeInfo.my_node_num) // in theory impossible
-                          return false;
-                      if (a.num == myNodeInfo.my_node_num) {
-                          return true;
-                      }
-                      if (b.num == myNodeInfo.my_node_num) {
-                          return false;
-                      }
-                      bool aFav = a.is_favorite;
-                      bool bFav = b.is_favorite;
-                      if (aFav != bFav)
-                          return aFav;
-                      return a.last_heard > b.last_heard;
-                  });
+    std::sort(meshNodes->begin(), meshNodes->begin() + numMeshNodes, meshNodeBefore);
+    rebuildNodeIndex();
+}
+
+/**
+ * Move a single node to its correct place after its sort key (last_heard / is_favorite) changed.
+ * The rest of meshNodes is already ordered, so we binary search the new position and rotate the entries in between,
+ * instead of re-sorting the whole array.
+ */
+void NodeDB::repositionMeshNode(NodeNum n)
+{
+    uint16_t slot = NodeNumIndex::NOT_FOUND;
+    if (nodeIndex.isReady())
+        slot = nodeIndex.find(n);
+    if (slot == NodeNumIndex::NOT_FOUND || slot >= numMeshNodes || meshNodes->at(slot).num != n) {
+        // Index not usable, fall back to the full sort
+        sortMeshDB();
+        return;
     }
+
+    auto first = meshNodes->begin();
+    auto last = meshNodes->begin() + numMeshNodes;
+    auto it = first + slot;
+    size_t from, to;
+
+    if (it != first && meshNodeBefore(*it, *(it - 1))) {
+        auto dest = std::upper_bound(first, it, *it, meshNodeBefore);
+        std::rotate(dest, it, it + 1);
+        from = dest - first;
+        to = slot;
+    } else if (it + 1 != last && meshNodeBefore(*(it + 1), *it)) {
+        auto dest = std::lower_bound(it + 1, last, *it, meshNodeBefore);
+        std::rotate(it, it + 1, dest);
+        from = slot;
+        to = (dest - first) - 1;
+    } else {
+        return; // Already in the right place
+    }
+
+    // Only the rotated range moved
+    for (size_t i = from; i <= to; i++)
+        nodeIndex.insert(meshNodes->at(i).num, i);
+}
+
+void NodeDB::rebuildNodeIndex()
+{
+    changeCount++; // nodes were added, removed or reordered
+    onlineBucketsValid = false;
+    if (!nodeIndex.isAllocated() && !nodeIndex.init(MAX_NUM_NODES + 1)) {
+        LOG_WARN("NodeDB index unavailable, using linear lookups");
+        return;
+    }
+
+    nodeIndex.beginRebuild();
+    for (int i = 0; i < numMeshNodes; i++)
+        nodeIndex.insert(meshNodes->at(i).num, i);
+    nodeIndex.endRebuild();
+
+    // Nodes were dropped too, a good time to shed stale keys and positions
+    keyIndex.clear();
+    for (int i = 0; i < numMeshNodes; i++)
+        indexPublicKey(&meshNodes->at(i));
+    if (positionIndex.isAllocated())
+        buildPositionIndex(true);
+}
+
+void NodeDB::indexPublicKey(const meshtastic_NodeInfoLite *node)
+{
+    if (node->user.public_key.size != 32)
+        return;
+    if (!keyIndex.isAllocated() && !keyIndex.init(MAX_NUM_NODES + 1))
+        return;
+    if (keyIndex.insert(node->user.public_key.bytes, node->num))
+        return;
+
+    // Full of nodes that have since gone or changed keys
+    keyIndex.clear();
+    for (int i = 0; i < numMeshNodes; i++) {
+        const meshtastic_NodeInfoLite &n = meshNodes->at(i);
+        if (n.user.public_key.size == 32)
+            keyIndex.insert(n.user.public_key.bytes, n.num);
+    }
+    keyIndex.insert(node->user.public_key.bytes, node->num);
+}
+
+bool NodeDB::buildPositionIndex(bool rebuild)
+{
+    if (positionIndex.isAllocated() && !rebuild)
+        return true;
+    if (!positionIndex.isAllocated() && !positionIndex.init(MAX_NUM_NODES + 1)) {
+        LOG_WARN("NodeDB position index unavailable, using linear scans");
+        return false;
+    }
+
+    positionIndex.clear();
+    for (int i = 0; i < numMeshNodes; i++) {
+        const meshtastic_NodeInfoLite &n = meshNodes->at(i);
+        if (hasValidPosition(&n))
+            positionIndex.update(n.num, n.position.latitude_i, n.position.longitude_i, true);
+    }
+    return true;
+}
+
+void NodeDB::indexPosition(const meshtastic_NodeInfoLite *node)
+{
+    if (!positionIndex.isAllocated())
+        return; // nobody has asked yet, it will be built from scratch when they do
+    if (!positionIndex.update(node->num, node->position.latitude_i, node->position.longitude_i, hasValidPosition(node)))
+        buildPositionIndex(true); // full of nodes that have since gone, node is among those refilled
+}
+
+NodeNum NodeDB::getNearestNode(int32_t latitude_i, int32_t longitude_i, NodeNum except)
+{
+    if (!buildPositionIndex()) {
+        NodeNum best = 0;
+        float bestMeters = 0;
+        for (int i = 0; i < numMeshNodes; i++) {
+            const meshtastic_NodeInfoLite *node = &meshNodes->at(i);
+            if (node->num == except || !hasValidPosition(node))
+                continue;
+            float meters = GeoCoord::latLongToMeter(latitude_i * 1e-7, longitude_i * 1e-7, node->position.latitude_i * 1e-7,
+                                                    node->position.longitude_i * 1e-7);
+            if (!best || meters < bestMeters) {
+                best = node->num;
+                bestMeters = meters;
+            }
+        }
+        return best;
+    }
+
+    const NodePositionIndex::Entry *nearest =
+        positionIndex.nearest(latitude_i, longitude_i, [this, except](const NodePositionIndex::Entry &position) {
+            const meshtastic_NodeInfoLite *node = position.num == except ? NULL : getMeshNode(position.num);
+            return node && hasValidPosition(node) && node->position.latitude_i == position.latitude_i &&
+                   node->position.longitude_i == position.longitude_i;
+        });
+    return nearest ? nearest->num : 0;
+}
+
+NodeNum NodeDB::getNodeByPublicKey(const uint8_t *key, NodeNum except)
+{
+    return keyIndex.find(key, [this, key, except](NodeNum n) {
+        const meshtastic_NodeInfoLite *node = n == except ? NULL : getMeshNode(n);
+        return node && node->user.public_key.size == 32 && memcmp(node->user.public_key.bytes, key, 32) == 0;
+    });
 }
 
 uint8_t NodeDB::getMeshNodeChannel(NodeNum n)
@@ -1726,6 +2368,15 @@ uint8_t NodeDB::getMeshNodeChannel(NodeNum n)
 /// NOTE: This function might be called from an ISR
 meshtastic_NodeInfoLite *NodeDB::getMeshNode(NodeNum n)
 {
+    if (n != 0 && nodeIndex.isReady()) {
+        uint16_t slot = nodeIndex.find(n);
+        if (slot == NodeNumIndex::NOT_FOUND)
+            return NULL;
+        if (slot < numMeshNodes && meshNodes->at(slot).num == n)
+            return &meshNodes->at(slot);
+        // Stale index entry, should never happen but the linear scan below is always correct
+    }
+
     for (int i = 0; i < numMeshNodes; i++)
         if (meshNodes->at(i).num == n)
             return &meshNodes->at(i);
@@ -1748,38 +2399,32 @@ meshtastic_NodeInfoLite *NodeDB::getOrCreateMeshNode(NodeNum n)
         if (isFull()) {
             LOG_INFO("Node database full with %i nodes and %u bytes free. Erasing oldest entry", numMeshNodes,
                      memGet.getFreeHeap());
-            // look for oldest node and erase it
-            uint32_t oldest = UINT32_MAX;
-            uint32_t oldestBoring = UINT32_MAX;
+            // meshNodes is kept ordered by last_heard (after ourselves and favorites), so it doubles as an LRU list: walk it
+            // from the least recently heard end and stop at the first "boring" node, which is the oldest one.
             int oldestIndex = -1;
             int oldestBoringIndex = -1;
-            for (int i = 1; i < numMeshNodes; i++) {
-                // Simply the oldest non-favorite, non-ignored, non-verified node
-                if (!meshNodes->at(i).is_favorite && !meshNodes->at(i).is_ignored &&
-                    !(meshNodes->at(i).bitfield & NODEINFO_BITFIELD_IS_KEY_MANUALLY_VERIFIED_MASK) &&
-                    meshNodes->at(i).last_heard < oldest) {
-                    oldest = meshNodes->at(i).last_heard;
-                    oldestIndex = i;
-                }
+            for (int i = numMeshNodes - 1; i > 0; i--) {
+                const meshtastic_NodeInfoLite &node = meshNodes->at(i);
+                if (node.is_favorite) // Favorites are all at the front, nothing evictable beyond this point
+                    break;
+                if (node.is_ignored)
+                    continue;
                 // The oldest "boring" node
-                if (!meshNodes->at(i).is_favorite && !meshNodes->at(i).is_ignored && meshNodes->at(i).user.public_key.size == 0 &&
-                    meshNodes->at(i).last_heard < oldestBoring) {
-                    oldestBoring = meshNodes->at(i).last_heard;
+                if (node.user.public_key.size == 0) {
                     oldestBoringIndex = i;
+                    break;
                 }
+                // Simply the oldest non-favorite, non-ignored, non-verified node
+                if (oldestIndex == -1 && !(node.bitfield & NODEINFO_BITFIELD_IS_KEY_MANUALLY_VERIFIED_MASK))
+                    oldestIndex = i;
             }
             // if we found a "boring" node, evict it
             if (oldestBoringIndex != -1) {
                 oldestIndex = oldestBoringIndex;
             }
 
-            if (oldestIndex != -1) {
-                // Shove the remaining nodes down the chain
-                for (int i = oldestIndex; i < numMeshNodes - 1; i++) {
-                    meshNodes->at(i) = meshNodes->at(i + 1);
-                }
-                (numMeshNodes)--;
-            }
+            if (oldestIndex != -1)
+                eraseMeshNodeAt(oldestIndex);
         }
         // add the node at the end
         lite = &meshNodes->at((numMeshNodes)++);
@@ -1787,7 +2432,13 @@ meshtastic_NodeInfoLite *NodeDB::getOrCreateMeshNode(NodeNum n)
         // everything is missing except the nodenum
         memset(lite, 0, sizeof(*lite));
         lite->num = n;
+        countOnline(lite, 1);
+        nodeIndex.insert(n, numMeshNodes - 1);
         LOG_INFO("Adding node to database with %i nodes and %u bytes free!", numMeshNodes, memGet.getFreeHeap());
+
+        // A fresh node has never been heard so it normally stays at the end, but ourselves and favorites move up
+        repositionMeshNode(n);
+        lite = getMeshNode(n);
     }
 
     return lite;
@@ -1865,9 +2516,9 @@ bool NodeDB::backupPreferences(meshtastic_AdminMessage_BackupLocation location)
         size_t backupSize;
         pb_get_encoded_size(&backupSize, meshtastic_BackupPreferences_fields, &backup);
 
-        spiLock->lock();
+        fsLock->lock();
         FSCom.mkdir("/backups");
-        spiLock->unlock();
+        fsLock->unlock();
         success = saveProto(backupFileName, backupSize, &meshtastic_BackupPreferences_msg, &backup);
 
         if (success) {
@@ -1887,13 +2538,13 @@ bool NodeDB::restorePreferences(meshtastic_AdminMessage_BackupLocation location,
     bool success = false;
 #ifdef FSCom
     if (location == meshtastic_AdminMessage_BackupLocation_FLASH) {
-        spiLock->lock();
+        fsLock->lock();
         if (!FSCom.exists(backupFileName)) {
-            spiLock->unlock();
+            fsLock->unlock();
             LOG_WARN("Could not restore. No backup file found");
             return false;
         } else {
-            spiLock->unlock();
+            fsLock->unlock();
         }
         meshtastic_BackupPreferences backup = meshtastic_BackupPreferences_init_zero;
         success = loadProto(backupFileName, meshtastic_BackupPreferences_size, sizeof(meshtastic_BackupPreferences),
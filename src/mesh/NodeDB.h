@@ -8,12 +8,21 @@
 #include <vector>
 
 #include "MeshTypes.h"
+#include "NodeDBMaintenance.h"
+#include "NodeNumIndex.h"
 #include "NodeStatus.h"
+#include "NodePositionIndex.h"
+#include "PublicKeyIndex.h"
+#include "SaveScheduler.h"
 #include "configuration.h"
 #include "mesh-pb-constants.h"
 #include "mesh/generated/meshtastic/mesh.pb.h" // For CriticalErrorCode
 
+/// Width of NodeDB sync generations, see NodeDB::markNodeChanged().  The low 12 bits count syncs, the rest is a per boot base
+#define NODE_SYNC_GENERATION_BITS 24
+
 #if ARCH_PORTDUINO
+#include "NodeDBMap.h"
 #include "PortduinoGlue.h"
 #endif
 
@@ -95,6 +104,61 @@ DeviceState versions used to be defined in the .proto file but really only this
 #define DEVICESTATE_CUR_VER 24
 #define DEVICESTATE_MIN_VER 24
 
+// meshtasticd: keep the nodes in a memory-mapped file of fixed size records (see NodeDBMap) instead of nodes.proto, so boot
+// doesn't decode and saves don't re-encode the whole database.  nodes.proto is only read to fill the map the first time.
+#ifndef NODEDB_MMAP
+#define NODEDB_MMAP 0
+#endif
+#if NODEDB_MMAP && !defined(ARCH_PORTDUINO)
+#error "NODEDB_MMAP needs ARCH_PORTDUINO"
+#endif
+
+// Save routine node changes by appending just the changed nodes to a journal, instead of rewriting the whole node database.
+// Needs a filesystem that can append.
+#ifndef NODEDB_JOURNAL
+#if defined(ARCH_ESP32) || defined(ARCH_NRF52) || defined(ARCH_RP2040) || defined(ARCH_PORTDUINO)
+#define NODEDB_JOURNAL 1
+#else
+#define NODEDB_JOURNAL 0
+#endif
+#endif
+
+// Once the journal is this long, the next save rewrites the whole database and starts a new journal
+#ifndef NODEDB_JOURNAL_MAX_BYTES
+#define NODEDB_JOURNAL_MAX_BYTES 4096
+#endif
+
+// Drop the nodes we never got a user for and clear all zero keys a few nodes at a time once we are running (see
+// NodeDBMaintenance), instead of in a pass over the whole database at boot, so a big one doesn't hold up the radio coming up
+#ifndef NODEDB_INCREMENTAL_MAINTENANCE
+#define NODEDB_INCREMENTAL_MAINTENANCE 0
+#endif
+
+// Nodes looked at each time the maintenance thread runs, and how often it runs until it has been through them all
+#ifndef NODEDB_MAINTAIN_PER_RUN
+#define NODEDB_MAINTAIN_PER_RUN 16
+#endif
+#ifndef NODEDB_MAINTAIN_INTERVAL_MS
+#define NODEDB_MAINTAIN_INTERVAL_MS 50
+#endif
+
+// With NODEDB_INCREMENTAL_MAINTENANCE, also drop nodes not heard from for this long, except ourselves, favorites, ignored
+// and manually verified nodes.  0 keeps them until the database is full
+#ifndef NODEDB_EXPIRE_SECS
+#define NODEDB_EXPIRE_SECS 0
+#endif
+
+// How often the maintenance thread goes through the nodes again to expire them
+#ifndef NODEDB_EXPIRE_PASS_MS
+#define NODEDB_EXPIRE_PASS_MS (15 * 60 * 1000)
+#endif
+
+#define NUM_ONLINE_SECS (60 * 60 * 2) // 2 hrs to consider someone offline
+
+/// Resolution of the online node count, see NodeDB::getNumOnlineMeshNodes()
+#define ONLINE_BUCKET_SECS 300
+#define ONLINE_BUCKETS (NUM_ONLINE_SECS / ONLINE_BUCKET_SECS + 1)
+
 extern meshtastic_DeviceState devicestate;
 extern meshtastic_NodeDatabase nodeDatabase;
 extern meshtastic_ChannelFile channelFile;
@@ -105,9 +169,25 @@ extern meshtastic_LocalModuleConfig moduleConfig;
 extern meshtastic_User &owner;
 extern meshtastic_Position localPosition;
 
+/// Define ROUTER_FIXED_ROLE to a meshtastic_Config_DeviceConfig_Role for firmware that only ever runs as that role.  The routers'
+/// role checks then fold to constants, so a REPEATER build inlines its relay path and a CLIENT_MUTE build compiles it out.
+#ifdef ROUTER_FIXED_ROLE
+constexpr meshtastic_Config_DeviceConfig_Role routingRole()
+{
+    return ROUTER_FIXED_ROLE;
+}
+#else
+inline meshtastic_Config_DeviceConfig_Role routingRole()
+{
+    return config.device.role;
+}
+#endif
+
 static constexpr const char *deviceStateFileName = "/prefs/device.proto";
 static constexpr const char *legacyPrefFileName = "/prefs/db.proto";
 static constexpr const char *nodeDatabaseFileName = "/prefs/nodes.proto";
+static constexpr const char *nodeJournalFileName = "/prefs/nodes.log"; // changes since nodes.proto was written
+static constexpr const char *nodeMapFileName = "/prefs/nodes.map";     // with NODEDB_MMAP
 static constexpr const char *configFileName = "/prefs/config.proto";
 static constexpr const char *uiconfigFileName = "/prefs/uiconfig.proto";
 static constexpr const char *moduleConfigFileName = "/prefs/module.proto";
@@ -135,6 +215,34 @@ enum LoadFileResult {
 
 enum UserLicenseStatus { NotKnown, NotLicensed, Licensed };
 
+/**
+ * A reference to a node which stays valid when meshNodes is reordered.
+ *
+ * Raw meshtastic_NodeInfoLite pointers into the DB move whenever an entry is repositioned or evicted, so anything that
+ * keeps a node around between calls (NodeDB::updateGUIforNode, the canned message destination list) holds one of these
+ * instead and resolves it when needed.
+ */
+class NodeHandle
+{
+  public:
+    NodeHandle() {}
+    explicit NodeHandle(NodeNum num) : num(num) {}
+    explicit NodeHandle(const meshtastic_NodeInfoLite *node) : num(node ? node->num : 0) {}
+
+    NodeNum getNodeNum() const { return num; }
+
+    /// @return the current location of the node, or NULL if it has been removed from the DB
+    meshtastic_NodeInfoLite *get() const;
+
+    meshtastic_NodeInfoLite *operator->() const { return get(); }
+    explicit operator bool() const { return get() != NULL; }
+
+    bool operator==(const NodeHandle &other) const { return num == other.num; }
+
+  private:
+    NodeNum num = 0;
+};
+
 class NodeDB
 {
     // NodeNum provisionalNodeNum; // if we are trying to find a node num this is our current attempt
@@ -147,8 +255,8 @@ class NodeDB
   public:
     std::vector<meshtastic_NodeInfoLite> *meshNodes;
     bool updateGUI = false; // we think the gui should definitely be redrawn, screen will clear this once handled
-    meshtastic_NodeInfoLite *updateGUIforNode = NULL; // if currently showing this node, we think you should update the GUI
-    Observable<const meshtastic::NodeStatus *> newStatus;
+    NodeHandle updateGUIforNode; // if currently showing this node, we think you should update the GUI
+    ObservableArray<const meshtastic::NodeStatus *, 2> newStatus;
     pb_size_t numMeshNodes;
 
     bool keyIsLowEntropy = false;
@@ -163,6 +271,21 @@ class NodeDB
     bool saveToDisk(int saveWhat = SEGMENT_CONFIG | SEGMENT_MODULECONFIG | SEGMENT_DEVICESTATE | SEGMENT_CHANNELS |
                                    SEGMENT_NODEDATABASE);
 
+    /// write to flash once things have settled down, along with anything else asked for around the same time
+    /// (see SaveScheduler). Prefer this for changes that come in bursts, such as config from a client.
+    void saveToDiskSoon(int saveWhat = SEGMENT_CONFIG | SEGMENT_MODULECONFIG | SEGMENT_DEVICESTATE | SEGMENT_CHANNELS |
+                                       SEGMENT_NODEDATABASE)
+    {
+        saveScheduler.request(saveWhat);
+    }
+
+    /// write any saveToDiskSoon() changes now
+    /// @return true if there was nothing to write or the save was successful
+    bool flushPendingSaves() { return saveScheduler.flush(); }
+
+    /// Bytes written to flash by saveProto() and the node journal since boot
+    uint32_t getBytesSaved() const { return bytesSaved; }
+
     /** Reinit radio config if needed, because either:
      * a) sometimes a buggy android app might send us bogus settings or
      * b) the client set factory_reset
@@ -191,6 +314,37 @@ class NodeDB
      */
     bool updateUser(uint32_t nodeId, meshtastic_User &p, uint8_t channelIndex = 0);
 
+    /**
+     * Node sync generations, they let a reconnecting client fetch only the nodes that changed since it last synced.
+     *
+     * Every change to a node records the current generation, and each client sync starts a new one.  Generations are
+     * NODE_SYNC_GENERATION_BITS wide and start from a random base at boot, so a generation from before a reboot is (almost
+     * certainly) rejected and the client gets everything.
+     */
+    void markNodeChanged(NodeNum n);
+
+    /// @return the generation n last changed in, 0 if it hasn't changed since boot
+    uint32_t getNodeChangeGeneration(NodeNum n) const;
+
+    /// @return a count that changes whenever any node is changed, added or removed, so UIs can tell when to redraw
+    uint32_t getChangeCount() const { return changeCount; }
+
+#if NODEDB_INCREMENTAL_MAINTENANCE
+    /**
+     * Clean up (and expire) up to maxNodes more nodes of the current maintenance pass, starting a new one if there is none.
+     * Goes from the end of meshNodes down, so the nodes erased only move those already looked at.
+     * @return false once the pass has been through every node
+     */
+    bool maintainNodes(size_t maxNodes);
+#endif
+
+    /// Start a client sync
+    /// @return the generation the client will be up to date with once it has read the nodes
+    uint32_t beginNodeSync();
+
+    /// @return true if we can tell which nodes changed after generation g (one we returned from beginNodeSync() this boot)
+    bool isValidSyncGeneration(uint32_t g) const;
+
     /// @return our node number
     NodeNum getNodeNum() { return myNodeInfo.my_node_num; }
 
@@ -214,11 +368,14 @@ class NodeDB
     // get channel channel index we heard a nodeNum on, defaults to 0 if not found
     uint8_t getMeshNodeChannel(NodeNum n);
 
-    /* Return the number of nodes we've heard from recently (within the last 2 hrs?)
+    /* Return the number of nodes we've heard from recently (within the last 2 hrs, to ONLINE_BUCKET_SECS)
      * @param localOnly if true, ignore nodes heard via MQTT
      */
     size_t getNumOnlineMeshNodes(bool localOnly = false);
 
+    /// Set when node was last heard from, keeping the online count up to date
+    void setLastHeard(meshtastic_NodeInfoLite *node, uint32_t lastHeard);
+
     void initConfigIntervals(), initModuleConfigIntervals(), resetNodes(), removeNodeByNum(NodeNum nodeNum);
 
     bool factoryReset(bool eraseBleBonds = false);
@@ -272,34 +429,170 @@ class NodeDB
 
     bool hasValidPosition(const meshtastic_NodeInfoLite *n);
 
+    /// Set or clear the favorite flag of a node, keeping meshNodes ordered
+    void setFavorite(bool is_favorite, NodeNum nodeId);
+
     bool checkLowEntropyPublicKey(const meshtastic_Config_SecurityConfig_public_key_t keyToTest);
 
+    /// The node other than except whose public key is key (32 bytes), 0 if none
+    NodeNum getNodeByPublicKey(const uint8_t *key, NodeNum except = 0);
+
+    /**
+     * Call f(meshtastic_NodeInfoLite *node, const NodePositionIndex::Entry &position) for every node with a valid position, in
+     * no particular order.  position has the node's coordinates already converted, see NodePositionIndex.
+     */
+    template <typename Fn> void forEachNodePosition(Fn f)
+    {
+        if (!buildPositionIndex()) {
+            // No memory for the index, work it out as we go
+            for (int i = 0; i < numMeshNodes; i++) {
+                meshtastic_NodeInfoLite *node = &meshNodes->at(i);
+                if (!hasValidPosition(node))
+                    continue;
+                NodePositionIndex::Entry position;
+                NodePositionIndex::project(position, node->position.latitude_i, node->position.longitude_i);
+                f(node, position);
+            }
+            return;
+        }
+        positionIndex.forEach([this, &f](const NodePositionIndex::Entry &position) {
+            meshtastic_NodeInfoLite *node = getMeshNode(position.num);
+            if (!node || !hasValidPosition(node))
+                return; // dropped, or lost its position without telling us
+            if (node->position.latitude_i != position.latitude_i || node->position.longitude_i != position.longitude_i)
+                indexPosition(node); // moved without telling us, updates position in place
+            f(node, position);
+        });
+    }
+
+    /// The node with a valid position nearest to latitude_i, longitude_i other than except, 0 if none
+    NodeNum getNearestNode(int32_t latitude_i, int32_t longitude_i, NodeNum except = 0);
+
+    /// Bring node's entry in the positions index up to date, call after changing its position
+    void indexPosition(const meshtastic_NodeInfoLite *node);
+
     bool backupPreferences(meshtastic_AdminMessage_BackupLocation location);
     bool restorePreferences(meshtastic_AdminMessage_BackupLocation location,
                             int restoreWhat = SEGMENT_CONFIG | SEGMENT_MODULECONFIG | SEGMENT_DEVICESTATE | SEGMENT_CHANNELS);
 
   private:
     bool duplicateWarned = false;
+
+    struct NodeChange {
+        NodeNum num;
+        uint32_t generation;
+    };
+    std::vector<NodeChange> nodeChanges; // sorted by num, only nodes changed since boot
+    static bool nodeChangeBefore(const NodeChange &c, NodeNum n) { return c.num < n; }
+    uint32_t syncGenerationBase = 0, syncGeneration = 0;
+    uint32_t changeCount = 0; // see getChangeCount()
+    uint8_t batchDepth = 0; // see beginBatch()
+    bool notifyPending = false, notifyPendingForce = false;
     uint32_t lastNodeDbSave = 0;    // when we last saved our db to flash
+    uint32_t bytesSaved = 0;        // see getBytesSaved()
+    SaveScheduler saveScheduler{*this};
+#if NODEDB_INCREMENTAL_MAINTENANCE
+    NodeDBMaintenance maintenance{*this};
+    int maintainCursor = -1;      // next slot the maintenance pass looks at, -1 between passes
+    bool maintainBootPass = true; // the first pass also does what cleanupMeshDB() would have
+    std::vector<NodeNum> maintainUnnamed; // sorted, the nodes loaded from disk without a user, all the boot pass may purge
+    uint16_t maintainRemoved = 0; // nodes the current pass dropped
+#endif
     uint32_t lastBackupAttempt = 0; // when we last tried a backup automatically or manually
-    uint32_t lastSort = 0;          // When last sorted the nodeDB
+    NodeNumIndex nodeIndex;         // NodeNum -> slot in meshNodes, must be kept in sync with any reordering of meshNodes
+    PublicKeyIndex keyIndex;        // public key -> NodeNum, may hold stale entries, see indexPublicKey()
+    NodePositionIndex positionIndex; // only built once someone asks about positions, see buildPositionIndex()
+
+    /**
+     * How many nodes were last heard in each ONLINE_BUCKET_SECS period, a ring indexed by period, so counting the online ones
+     * doesn't look at every node.  A period's counts are dropped when a newer one takes its slot, by then they are too old to
+     * matter.  Rebuilt after anything that adds or removes nodes wholesale (see rebuildNodeIndex()).
+     */
+    struct OnlineBucket {
+        uint32_t period; // last_heard / ONLINE_BUCKET_SECS
+        uint16_t all, mqtt;
+    };
+    OnlineBucket onlineBuckets[ONLINE_BUCKETS] = {};
+    bool onlineBucketsValid = false;
+
+    /// Add (1) or remove (-1) node from onlineBuckets, call around any change to its last_heard or via_mqtt
+    void countOnline(const meshtastic_NodeInfoLite *node, int delta);
+
+    /// Add node's key to keyIndex, rebuilding it if it filled up
+    void indexPublicKey(const meshtastic_NodeInfoLite *node);
+
+    /// Allocate and fill positionIndex if it isn't yet, or refill it from meshNodes if rebuild
+    /// @return false if there is no memory for it
+    bool buildPositionIndex(bool rebuild = false);
+
+#if NODEDB_JOURNAL
+    // A node as it was when last written to flash, in nodes.proto or the journal after it
+    struct JournalEntry {
+        NodeNum num;
+        uint32_t crc; // of its NodeInfoLite, to tell if it has changed since
+    };
+    std::vector<JournalEntry> journalNodes; // sorted by num
+    bool journalValid = false; // nodes.proto and journalNodes agree, so changes can be appended
+    uint32_t journalBytes = 0; // current length of the journal file
+
+    /// Apply the journal's records to the node database just loaded from nodes.proto
+    /// @return number of records applied
+    uint32_t replayNodeJournal();
+
+    /// Append a record for each node added, changed or removed since the last save
+    /// @return false if the journal couldn't be written, and the whole database should be saved instead
+    bool appendNodeJournal();
+
+    /// Record every node's current state in journalNodes, as now saved on flash
+    void snapshotNodeJournal();
+#endif
+#if NODEDB_MMAP
+    NodeDBMap nodeMap;
+
+    /// Map nodes.map and load the nodes it holds into nodeDatabase
+    /// @return false if it held none, nodes.proto is read instead
+    bool openNodeMap();
+#endif
     /// Find a node in our DB, create an empty NodeInfoLite if missing
     meshtastic_NodeInfoLite *getOrCreateMeshNode(NodeNum n);
 
     /// Notify observers of changes to the DB
     void notifyObservers(bool forceUpdate = false)
     {
+        if (batchDepth) {
+            // Coalesced, endBatch() sends one notification for the whole batch
+            notifyPending = true;
+            notifyPendingForce |= forceUpdate;
+            return;
+        }
+
         // Notify observers of the current node state
         const meshtastic::NodeStatus status = meshtastic::NodeStatus(getNumOnlineMeshNodes(), getNumMeshNodes(), forceUpdate);
         newStatus.notifyObservers(&status);
     }
 
+    /// Hold back notifyObservers() until the matching endBatch(), used while handling a burst of received packets
+    void beginBatch() { batchDepth++; }
+
+    /// Send the notification (if any) that was held back since beginBatch()
+    void endBatch()
+    {
+        if (batchDepth && --batchDepth == 0 && notifyPending) {
+            bool force = notifyPendingForce;
+            notifyPending = notifyPendingForce = false;
+            notifyObservers(force);
+        }
+    }
+
     /// read our db from flash
     void loadFromDisk();
 
     /// purge db entries without user info
     void cleanupMeshDB();
 
+    /// Take the node in slot i out of meshNodes and the indexes, moving the ones behind it down
+    void eraseMeshNodeAt(int i);
+
     /// Reinit device state from scratch (not loading from disk)
     void installDefaultDeviceState(), installDefaultNodeDatabase(), installDefaultChannels(),
         installDefaultConfig(bool preserveKey), installDefaultModuleConfig();
@@ -312,10 +605,21 @@ class NodeDB
     bool saveDeviceStateToDisk();
     bool saveNodeDatabaseToDisk();
     void sortMeshDB();
+
+    /// Move one node to its ordered position after its last_heard or is_favorite changed
+    void repositionMeshNode(NodeNum n);
+
+    /// Repopulate nodeIndex from meshNodes, call after anything that moves entries around
+    void rebuildNodeIndex();
 };
 
 extern NodeDB *nodeDB;
 
+inline meshtastic_NodeInfoLite *NodeHandle::get() const
+{
+    return (num && nodeDB) ? nodeDB->getMeshNode(num) : NULL;
+}
+
 /*
   If is_router is set, we use a number of different default values
 
@@ -348,6 +652,12 @@ extern meshtastic_CriticalErrorCode error_code;
 extern uint32_t error_address;
 #define NODEINFO_BITFIELD_IS_KEY_MANUALLY_VERIFIED_SHIFT 0
 #define NODEINFO_BITFIELD_IS_KEY_MANUALLY_VERIFIED_MASK (1 << NODEINFO_BITFIELD_IS_KEY_MANUALLY_VERIFIED_SHIFT)
+#define NODEINFO_BITFIELD_TEXT_COMPRESSION_SHIFT 1 // their NodeInfo had BITFIELD_TEXT_COMPRESSION
+#define NODEINFO_BITFIELD_TEXT_COMPRESSION_MASK (1 << NODEINFO_BITFIELD_TEXT_COMPRESSION_SHIFT)
+#define NODEINFO_BITFIELD_PAYLOAD_COMPRESSION_SHIFT 2 // their NodeInfo had BITFIELD_PAYLOAD_COMPRESSION
+#define NODEINFO_BITFIELD_PAYLOAD_COMPRESSION_MASK (1 << NODEINFO_BITFIELD_PAYLOAD_COMPRESSION_SHIFT)
+#define NODEINFO_BITFIELD_AGGREGATION_SHIFT 3 // their NodeInfo had BITFIELD_AGGREGATION
+#define NODEINFO_BITFIELD_AGGREGATION_MASK (1 << NODEINFO_BITFIELD_AGGREGATION_SHIFT)
 
 #define Module_Config_size                                                                                                       \
     (ModuleConfig_CannedMessageConfig_size + ModuleConfig_ExternalNotificationConfig_size + ModuleConfig_MQTTConfig_size +       \
@@ -0,0 +1,22 @@
+#include "NodeDBMaintenance.h"
+#include "NodeDB.h"
+
+#if NODEDB_INCREMENTAL_MAINTENANCE
+
+NodeDBMaintenance::NodeDBMaintenance(NodeDB &_db)
+    : concurrency::OSThread("NodeDBMaintenance", NODEDB_MAINTAIN_INTERVAL_MS), db(_db)
+{
+}
+
+int32_t NodeDBMaintenance::runOnce()
+{
+    if (db.maintainNodes(NODEDB_MAINTAIN_PER_RUN))
+        return NODEDB_MAINTAIN_INTERVAL_MS;
+#if NODEDB_EXPIRE_SECS
+    return NODEDB_EXPIRE_PASS_MS;
+#else
+    return disable(); // nothing more to do until the next boot
+#endif
+}
+
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "concurrency/OSThread.h"
+#include "configuration.h"
+
+class NodeDB;
+
+/**
+ * Cleans up the node database a few nodes at a time, with NODEDB_INCREMENTAL_MAINTENANCE.
+ *
+ * At boot NodeDB no longer goes through every node before the radio comes up: this thread makes the first pass instead,
+ * NODEDB_MAINTAIN_PER_RUN nodes every NODEDB_MAINTAIN_INTERVAL_MS, dropping the nodes loaded without a user and clearing
+ * all zero public keys.  With NODEDB_EXPIRE_SECS it then makes a pass every NODEDB_EXPIRE_PASS_MS to drop the nodes not
+ * heard from for that long, otherwise it stops after the first.  See NodeDB::maintainNodes().
+ */
+class NodeDBMaintenance : private concurrency::OSThread
+{
+  public:
+    explicit NodeDBMaintenance(NodeDB &db);
+
+  protected:
+    virtual int32_t runOnce() override;
+
+  private:
+    NodeDB &db;
+};
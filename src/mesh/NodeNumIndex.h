@@ -0,0 +1,157 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include "mesh-pb-constants.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#if NODEDB_PSRAM && defined(ARCH_ESP32)
+#include <esp_heap_caps.h>
+#endif
+
+/**
+ * A compact open-addressing hash table mapping a NodeNum to its slot in the NodeDB array.
+ *
+ * Uses linear probing over a power-of-two table that is at least twice the max node count, so probe sequences stay short.
+ * Keys and values are kept in separate arrays (6 bytes per slot) so a probe touches as little memory as possible.
+ *
+ * NodeNum 0 is used as the empty marker and is never indexed.
+ *
+ * NOTE: find() may be called from an ISR.  Writers only ever publish a key after its value is in place, and while the table
+ * is being rebuilt find() reports "unknown" so the caller can fall back to a linear scan.
+ */
+class NodeNumIndex
+{
+  public:
+    static constexpr uint16_t NOT_FOUND = 0xffff;
+
+    NodeNumIndex() {}
+    ~NodeNumIndex() { release(); }
+
+    /// Size the table for up to maxEntries nodes, discarding any current contents
+    bool init(size_t maxEntries)
+    {
+        release();
+        if (maxEntries == 0 || maxEntries >= NOT_FOUND)
+            return false;
+
+        size_t cap = 8;
+        while (cap < maxEntries * 2)
+            cap <<= 1;
+
+#if NODEDB_PSRAM && defined(ARCH_ESP32)
+        // Every packet looks its sender up here, keep the table out of PSRAM along with the nodes
+        keys = (NodeNum *)heap_caps_calloc(cap, sizeof(NodeNum), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        slots = (uint16_t *)heap_caps_calloc(cap, sizeof(uint16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+        keys = (NodeNum *)calloc(cap, sizeof(NodeNum));
+        slots = (uint16_t *)calloc(cap, sizeof(uint16_t));
+#endif
+        if (!keys || !slots) {
+            release();
+            return false;
+        }
+        mask = cap - 1;
+        return true;
+    }
+
+    bool isAllocated() const { return keys != NULL; }
+
+    bool isReady() const { return keys != NULL && !rebuilding; }
+
+    void clear()
+    {
+        if (keys)
+            memset(keys, 0, (mask + 1) * sizeof(NodeNum));
+    }
+
+    /// Mark the start of a bulk rebuild, lookups during this time report isReady() == false
+    void beginRebuild()
+    {
+        rebuilding = true;
+        clear();
+    }
+
+    void endRebuild() { rebuilding = false; }
+
+    /// Add or update the slot for n
+    /// @return false if the table is full or n can't be indexed
+    bool insert(NodeNum n, uint16_t slot)
+    {
+        if (!keys || n == 0)
+            return false;
+
+        for (size_t i = hash(n), probes = 0; probes <= mask; i = (i + 1) & mask, probes++) {
+            if (keys[i] == n || keys[i] == 0) {
+                slots[i] = slot;
+                keys[i] = n; // publish the key last, so an ISR never sees a key with a stale slot
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Remove n using backward-shift deletion so no tombstones are needed
+    void erase(NodeNum n)
+    {
+        if (!keys || n == 0)
+            return;
+
+        size_t i = hash(n);
+        while (keys[i] != n) {
+            if (keys[i] == 0)
+                return; // not present
+            i = (i + 1) & mask;
+        }
+
+        size_t hole = i;
+        for (size_t j = (hole + 1) & mask; keys[j] != 0; j = (j + 1) & mask) {
+            size_t home = hash(keys[j]);
+            // Move j into the hole unless its home slot lies cyclically within (hole, j]
+            bool inRange = (hole <= j) ? (hole < home && home <= j) : (hole < home || home <= j);
+            if (!inRange) {
+                slots[hole] = slots[j];
+                keys[hole] = keys[j];
+                hole = j;
+            }
+        }
+        keys[hole] = 0;
+    }
+
+    /// @return the slot for n, or NOT_FOUND
+    uint16_t find(NodeNum n) const
+    {
+        if (!keys || n == 0)
+            return NOT_FOUND;
+
+        for (size_t i = hash(n), probes = 0; probes <= mask; i = (i + 1) & mask, probes++) {
+            NodeNum k = keys[i];
+            if (k == n)
+                return slots[i];
+            if (k == 0)
+                break;
+        }
+        return NOT_FOUND;
+    }
+
+  private:
+    NodeNum *keys = NULL;
+    uint16_t *slots = NULL;
+    size_t mask = 0;
+    volatile bool rebuilding = false;
+
+    /// Fibonacci hashing, nodenums are often derived from MAC addresses so the low bits alone are poorly distributed
+    size_t hash(NodeNum n) const { return (size_t)((n * 2654435769u) >> 7) & mask; }
+
+    void release()
+    {
+        free(keys);
+        free(slots);
+        keys = NULL;
+        slots = NULL;
+        mask = 0;
+    }
+
+    NodeNumIndex(const NodeNumIndex &);            // non construction-copyable
+    NodeNumIndex &operator=(const NodeNumIndex &); // non copyable
+};
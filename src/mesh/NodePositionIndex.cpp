@@ -0,0 +1,102 @@
+#include "NodePositionIndex.h"
+#include <string.h>
+
+bool NodePositionIndex::init(size_t maxEntries)
+{
+    release();
+    size_t cap = 8;
+    while (cap * 3 / 4 < maxEntries)
+        cap <<= 1;
+    if (cap > NONE)
+        return false;
+
+    entries = (Entry *)calloc(cap, sizeof(Entry));
+    if (!entries)
+        return false;
+    mask = cap - 1;
+    clear();
+    return true;
+}
+
+void NodePositionIndex::clear()
+{
+    if (entries)
+        memset(entries, 0, (mask + 1) * sizeof(Entry));
+    for (size_t b = 0; b < GRID_BUCKETS; b++)
+        heads[b] = NONE;
+    used = 0;
+    positioned = 0;
+}
+
+size_t NodePositionIndex::find(NodeNum n) const
+{
+    if (!entries || n == 0)
+        return NONE;
+    for (size_t i = (n * 2654435761u) & mask; entries[i].num != 0; i = (i + 1) & mask)
+        if (entries[i].num == n)
+            return i;
+    return NONE;
+}
+
+bool NodePositionIndex::update(NodeNum n, int32_t latitude_i, int32_t longitude_i, bool hasPosition)
+{
+    if (!entries || n == 0)
+        return false;
+
+    size_t i = find(n);
+    if (i == NONE) {
+        if (!hasPosition)
+            return true; // nothing to forget
+        if (used + 1 > (mask + 1) * 3 / 4)
+            return false;
+        for (i = (n * 2654435761u) & mask; entries[i].num != 0; i = (i + 1) & mask)
+            ;
+        entries[i].num = n;
+        used++;
+    }
+
+    Entry &e = entries[i];
+    if (e.hasPosition) {
+        if (hasPosition && e.latitude_i == latitude_i && e.longitude_i == longitude_i)
+            return true;
+        unlink(i);
+    }
+    e.hasPosition = hasPosition;
+    if (!hasPosition)
+        return true;
+
+    project(e, latitude_i, longitude_i);
+    link(i);
+    return true;
+}
+
+void NodePositionIndex::project(Entry &e, int32_t latitude_i, int32_t longitude_i)
+{
+    e.latitude_i = latitude_i;
+    e.longitude_i = longitude_i;
+    e.lat = latitude_i * 1e-7f;
+    e.lng = longitude_i * 1e-7f;
+    float latRad = e.lat * (float)(M_PI / 180), lngRad = e.lng * (float)(M_PI / 180);
+    e.x = cosf(latRad) * cosf(lngRad);
+    e.y = cosf(latRad) * sinf(lngRad);
+    e.z = sinf(latRad);
+    e.cellLat = cellOf(latitude_i);
+    e.cellLng = wrapCellLng(cellOf(longitude_i));
+}
+
+void NodePositionIndex::link(uint16_t i)
+{
+    size_t b = bucketOf(entries[i].cellLat, entries[i].cellLng);
+    entries[i].next = heads[b];
+    heads[b] = i;
+    positioned++;
+}
+
+void NodePositionIndex::unlink(uint16_t i)
+{
+    uint16_t *p = &heads[bucketOf(entries[i].cellLat, entries[i].cellLng)];
+    while (*p != i)
+        p = &entries[*p].next;
+    *p = entries[i].next;
+    positioned--;
+}
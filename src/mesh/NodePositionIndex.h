@@ -0,0 +1,177 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * Node positions with what the map and distance code keeps working out from them precomputed (degrees as floats, a unit
+ * vector from the earth's center), bucketed by a grid of GRID_CELL_E7 square cells so finding the nodes near a point only
+ * looks at those in the cells around it.
+ *
+ * An open-addressing table keyed by NodeNum, no removal: a node that lost its position just leaves the grid, one that was
+ * dropped from the NodeDB stays until the owner rebuilds the index.  Readers check entries against the node they belong to,
+ * see NodeDB::forEachNodePosition().
+ */
+class NodePositionIndex
+{
+  public:
+    /// Grid cell size, in 1e-7 degrees (0.1 degree, about 11 km north to south)
+    static constexpr int32_t GRID_CELL_E7 = 1000000;
+
+    /// Rings of cells nearest() searches around the query before giving up on the grid and looking at every entry
+    static constexpr int GRID_MAX_RINGS = 4;
+
+    static constexpr uint16_t NONE = 0xffff;
+
+    struct Entry {
+        NodeNum num;         // 0 marks an empty slot
+        int32_t latitude_i;  // the position everything below was worked out from
+        int32_t longitude_i; //
+        float lat, lng;      // degrees
+        float x, y, z;       // unit vector from the earth's center, to average positions without trig per node
+        int16_t cellLat, cellLng;
+        uint16_t next; // next entry in the same grid bucket, NONE ends the list
+        bool hasPosition;
+    };
+
+    NodePositionIndex() {}
+    ~NodePositionIndex() { release(); }
+
+    /// Size the table for up to maxEntries nodes, discarding any current contents
+    bool init(size_t maxEntries);
+
+    bool isAllocated() const { return entries != NULL; }
+
+    void clear();
+
+    /**
+     * Index node n at a position, or take it off the grid if hasPosition is false.  Nothing is worked out again if the position
+     * is the one already indexed.
+     * @return false if the table is full of dropped nodes and should be rebuilt
+     */
+    bool update(NodeNum n, int32_t latitude_i, int32_t longitude_i, bool hasPosition);
+
+    /// Work out e's position fields, for a node at latitude_i, longitude_i
+    static void project(Entry &e, int32_t latitude_i, int32_t longitude_i);
+
+    /// The entry of n, NULL if it was never indexed
+    const Entry *get(NodeNum n) const
+    {
+        size_t i = find(n);
+        return i == NONE ? NULL : &entries[i];
+    }
+
+    /// Call f(const Entry &) for every entry with a position, in no particular order
+    template <typename Fn> void forEach(Fn f) const
+    {
+        if (!entries)
+            return;
+        for (size_t i = 0; i <= mask; i++)
+            if (entries[i].num && entries[i].hasPosition)
+                f(entries[i]);
+    }
+
+    /**
+     * The entry with a position nearest to a point that isMatch(const Entry &) accepts, by a flat earth distance good enough
+     * to rank nodes
+     * @return NULL if there is none
+     */
+    template <typename Match> const Entry *nearest(int32_t latitude_i, int32_t longitude_i, Match isMatch) const
+    {
+        if (!entries || !positioned)
+            return NULL;
+        const float cosLat = cosf(latitude_i * 1e-7f * (float)(M_PI / 180));
+        const Entry *best = NULL;
+        float bestDist = 0;
+        auto consider = [&](const Entry &e) {
+            float dist = flatDistance(latitude_i, longitude_i, cosLat, e);
+            if ((!best || dist < bestDist) && isMatch(e)) {
+                best = &e;
+                bestDist = dist;
+            }
+        };
+
+        // Nothing outside ring r is nearer than r cells, at the narrow (east-west) side of a cell
+        const float ringDeg = GRID_CELL_E7 * 1e-7f * (cosLat > 0.01f ? cosLat : 0.01f);
+        int16_t cellLat = cellOf(latitude_i), cellLng = wrapCellLng(cellOf(longitude_i));
+        for (int r = 0; r <= GRID_MAX_RINGS; r++) {
+            for (int dLat = -r; dLat <= r; dLat++) {
+                for (int dLng = -r; dLng <= r; dLng++) {
+                    if (abs(dLat) != r && abs(dLng) != r)
+                        continue; // inside the ring, already searched
+                    int16_t cLat = cellLat + dLat, cLng = wrapCellLng(cellLng + dLng);
+                    for (uint16_t i = heads[bucketOf(cLat, cLng)]; i != NONE; i = entries[i].next)
+                        if (entries[i].cellLat == cLat && entries[i].cellLng == cLng)
+                            consider(entries[i]);
+                }
+            }
+            if (best && bestDist <= r * ringDeg)
+                return best;
+        }
+
+        // Sparse around the point, the nearest could be anywhere
+        best = NULL;
+        forEach(consider);
+        return best;
+    }
+
+  private:
+    static constexpr size_t GRID_BUCKETS = 64;
+
+    Entry *entries = NULL;
+    size_t mask = 0;
+    size_t used = 0;       // slots taken, with or without a position
+    size_t positioned = 0; // entries on the grid
+    uint16_t heads[GRID_BUCKETS];
+
+    size_t find(NodeNum n) const;
+    void link(uint16_t i);
+    void unlink(uint16_t i);
+
+    /// Rounds down, so the cells either side of 0 don't merge
+    static int16_t cellOf(int32_t e7)
+    {
+        int32_t c = e7 / GRID_CELL_E7;
+        return (int16_t)(e7 < 0 && c * GRID_CELL_E7 != e7 ? c - 1 : c);
+    }
+
+    /// Longitude cells wrap around at the antimeridian
+    static int16_t wrapCellLng(int c)
+    {
+        const int cells = 3600000000 / GRID_CELL_E7;
+        c = (c + cells / 2) % cells;
+        return (int16_t)(c < 0 ? c + cells / 2 : c - cells / 2);
+    }
+
+    static size_t bucketOf(int16_t cellLat, int16_t cellLng)
+    {
+        return ((uint32_t)(cellLat * 7919 + cellLng) * 2654435761u) >> 26; // top 6 bits, GRID_BUCKETS
+    }
+
+    /// Distance from a point to e, in degrees of latitude
+    static float flatDistance(int32_t latitude_i, int32_t longitude_i, float cosLat, const Entry &e)
+    {
+        float north = (e.latitude_i - latitude_i) * 1e-7f;
+        int64_t dLng = (int64_t)e.longitude_i - longitude_i;
+        if (dLng > 1800000000)
+            dLng -= 3600000000LL;
+        else if (dLng < -1800000000)
+            dLng += 3600000000LL;
+        float east = dLng * 1e-7f * cosLat;
+        return sqrtf(north * north + east * east);
+    }
+
+    void release()
+    {
+        free(entries);
+        entries = NULL;
+        mask = 0;
+        used = 0;
+        positioned = 0;
+    }
+
+    NodePositionIndex(const NodePositionIndex &);            // non construction-copyable
+    NodePositionIndex &operator=(const NodePositionIndex &); // non copyable
+};
@@ -0,0 +1,138 @@
+#include "PacketAggregation.h"
+#include "MeshPacketQueue.h"
+#include "NodeDB.h"
+#include "RadioInterface.h"
+#include "Router.h"
+#include "configuration.h"
+#include <string.h>
+
+// What a carrier's payload can hold, the carrier's own header takes the rest of the LoRa frame
+#define CARRIER_PAYLOAD_LEN (MAX_LORA_PAYLOAD_LEN - sizeof(PacketHeader))
+#define ENTRY_OVERHEAD (1 + sizeof(PacketHeader))
+
+static size_t appendEntry(uint8_t *buf, size_t len, const meshtastic_MeshPacket *p)
+{
+    PacketHeader h;
+    RadioInterface::packHeader(p, h);
+    buf[len++] = p->encrypted.size;
+    memcpy(buf + len, &h, sizeof(h));
+    len += sizeof(h);
+    memcpy(buf + len, p->encrypted.bytes, p->encrypted.size);
+    return len + p->encrypted.size;
+}
+
+bool PacketAggregation::canAggregate(const meshtastic_MeshPacket *p)
+{
+    if (p->which_payload_variant != meshtastic_MeshPacket_encrypted_tag || !isFromUs(p) || isBroadcast(p->to) ||
+        p->encrypted.size + 2 * ENTRY_OVERHEAD > CARRIER_PAYLOAD_LEN)
+        return false;
+    if (p->next_hop != NO_NEXT_HOP_PREFERENCE && p->next_hop != nodeDB->getLastByteOfNodeNum(p->to))
+        return false;
+    const meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(p->to);
+    return node && node->has_hops_away && node->hops_away == 0 && peerSupports(p->to);
+}
+
+meshtastic_MeshPacket *PacketAggregation::aggregate(meshtastic_MeshPacket *p, MeshPacketQueue &queue)
+{
+    if (!canAggregate(p))
+        return p;
+
+    uint8_t buf[CARRIER_PAYLOAD_LEN];
+    size_t len = 0;
+    buf[len++] = PACKET_AGGREGATION_MAGIC;
+    len = appendEntry(buf, len, p);
+
+    meshtastic_MeshPacket *joined[PACKET_AGGREGATION_MAX - 1];
+    size_t count = 0;
+    while (count < PACKET_AGGREGATION_MAX - 1 && len + ENTRY_OVERHEAD < sizeof(buf)) {
+        meshtastic_MeshPacket *q = queue.removeAggregatable(p->from, p->to, p->channel, sizeof(buf) - len - ENTRY_OVERHEAD);
+        if (!q)
+            break;
+        len = appendEntry(buf, len, q);
+        joined[count++] = q;
+    }
+    if (count == 0)
+        return p;
+
+    meshtastic_MeshPacket *carrier = packetPool.allocZeroed();
+    carrier->from = p->from;
+    carrier->to = p->to;
+    carrier->id = generatePacketId();
+    carrier->channel = PACKET_AGGREGATION_CHANNEL;
+    carrier->priority = p->priority;
+    carrier->next_hop = NO_NEXT_HOP_PREFERENCE;
+    carrier->relay_node = p->relay_node;
+    carrier->which_payload_variant = meshtastic_MeshPacket_encrypted_tag;
+    memcpy(carrier->encrypted.bytes, buf, len);
+    carrier->encrypted.size = len;
+
+    LOG_DEBUG("Aggregate %u packets to 0x%x in one %u byte frame", (unsigned)count + 1, p->to, (unsigned)len);
+    for (size_t i = 0; i < count; i++) {
+        if (joined[i]->priority > carrier->priority)
+            carrier->priority = joined[i]->priority;
+        packetPool.release(joined[i]);
+    }
+    packetPool.release(p);
+    return carrier;
+}
+
+bool PacketAggregation::isCarrier(const meshtastic_MeshPacket *p)
+{
+    return p->which_payload_variant == meshtastic_MeshPacket_encrypted_tag && p->channel == PACKET_AGGREGATION_CHANNEL &&
+           p->hop_start == 0 && p->hop_limit == 0 && p->encrypted.size > ENTRY_OVERHEAD &&
+           p->encrypted.bytes[0] == PACKET_AGGREGATION_MAGIC;
+}
+
+int PacketAggregation::unpack(const meshtastic_MeshPacket *carrier, meshtastic_MeshPacket *out[PACKET_AGGREGATION_MAX])
+{
+    if (!isCarrier(carrier))
+        return -1;
+
+    // Check the whole frame before allocating anything
+    const uint8_t *buf = carrier->encrypted.bytes;
+    size_t len = carrier->encrypted.size;
+    size_t count = 0;
+    for (size_t at = 1; at < len; count++) {
+        if (count == PACKET_AGGREGATION_MAX || len - at < ENTRY_OVERHEAD || len - at - ENTRY_OVERHEAD < buf[at])
+            return -1;
+        PacketHeader h;
+        memcpy(&h, buf + at + 1, sizeof(h));
+        if (h.from != carrier->from) // we only ever pack our own packets
+            return -1;
+        at += ENTRY_OVERHEAD + buf[at];
+    }
+
+    size_t at = 1;
+    for (size_t i = 0; i < count; i++) {
+        PacketHeader h;
+        memcpy(&h, buf + at + 1, sizeof(h));
+        meshtastic_MeshPacket *mp = packetPool.allocZeroed();
+        RadioInterface::unpackHeader(h, mp);
+        mp->rx_time = carrier->rx_time;
+        mp->rx_snr = carrier->rx_snr;
+        mp->rx_rssi = carrier->rx_rssi;
+        mp->which_payload_variant = meshtastic_MeshPacket_encrypted_tag;
+        mp->encrypted.size = buf[at];
+        memcpy(mp->encrypted.bytes, buf + at + ENTRY_OVERHEAD, mp->encrypted.size);
+        at += ENTRY_OVERHEAD + mp->encrypted.size;
+        out[i] = mp;
+    }
+    return count;
+}
+
+bool PacketAggregation::peerSupports(NodeNum n)
+{
+    const meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(n);
+    return node && (node->bitfield & NODEINFO_BITFIELD_AGGREGATION_MASK);
+}
+
+void PacketAggregation::setPeerSupports(NodeNum n, bool supported)
+{
+    meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(n);
+    if (!node)
+        return;
+    if (supported)
+        node->bitfield |= NODEINFO_BITFIELD_AGGREGATION_MASK;
+    else
+        node->bitfield &= ~NODEINFO_BITFIELD_AGGREGATION_MASK;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "MeshTypes.h"
+
+class MeshPacketQueue;
+
+/// Set to 1 to send our small packets to a capable neighbour in one radio frame, and to unpack frames sent to us that way
+#ifndef PACKET_AGGREGATION
+#define PACKET_AGGREGATION 0
+#endif
+#if PACKET_AGGREGATION && !PRIVATE_BITFIELD_FLAGS
+#error "PACKET_AGGREGATION uses a private Data.bitfield flag and needs PRIVATE_BITFIELD_FLAGS, see Router.h"
+#endif
+
+#define PACKET_AGGREGATION_CHANNEL 0xa5 // channel hash of a carrier frame, 0 would look like PKI
+#define PACKET_AGGREGATION_MAGIC 0x01   // first payload byte of a carrier frame, also its format version
+#define PACKET_AGGREGATION_MAX 8        // packets in one carrier frame
+
+/**
+ * Packs several of our encrypted packets for the same neighbour into one carrier frame, so they share one preamble, LoRa
+ * header and contention window wait.  ACKs, position replies and short texts to the same node are often queued together.
+ *
+ * The carrier is an ordinary frame from us to that neighbour with hop_limit 0 and channel PACKET_AGGREGATION_CHANNEL.  Its
+ * payload is PACKET_AGGREGATION_MAGIC then for each packet a length byte, its PacketHeader and its encrypted payload, so the
+ * packets inside are still encrypted end to end.  The receiver hands each of them to the router as if it had heard it on its
+ * own.  Old nodes hear a frame on a channel they don't have and that they must not relay.
+ *
+ * We only aggregate packets we originated, to nodes we hear directly (hops_away 0) whose NodeInfo had BITFIELD_AGGREGATION:
+ * when the destination is a neighbour nobody else is needed to relay the packet.
+ */
+class PacketAggregation
+{
+  public:
+    /// Take more packets that can travel with p out of the queue
+    /// @return p if nothing could join it, otherwise a carrier frame holding them all, and p and the others are released
+    static meshtastic_MeshPacket *aggregate(meshtastic_MeshPacket *p, MeshPacketQueue &queue);
+
+    /// Whether p looks like a carrier frame
+    static bool isCarrier(const meshtastic_MeshPacket *p);
+
+    /// Split a carrier frame into the packets it holds, which still need decoding.  rx metadata is copied from the carrier
+    /// @return the number of packets, or -1 if it isn't a valid carrier (and nothing was allocated)
+    static int unpack(const meshtastic_MeshPacket *carrier, meshtastic_MeshPacket *out[PACKET_AGGREGATION_MAX]);
+
+    /// Whether node n has told us it can unpack carrier frames
+    static bool peerSupports(NodeNum n);
+
+    /// Remember what node n's NodeInfo said
+    static void setPeerSupports(NodeNum n, bool supported);
+
+  private:
+    static bool canAggregate(const meshtastic_MeshPacket *p);
+};
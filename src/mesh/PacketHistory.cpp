@@ -6,13 +6,25 @@
 #include "platform/portduino/PortduinoGlue.h"
 #endif
 #include "Throttle.h"
+#if PACKETHISTORY_PERSIST
+#include "FSCommon.h"
+#include "RTC.h"
+#include "SPILock.h"
+#include "sleep.h"
+#include <ErriezCRC32.h>
+#include <stddef.h>
+#endif
 
+#ifndef PACKETHISTORY_MAX // Lookups are bounded by PACKETHISTORY_WAYS, so routers can raise this freely
 #define PACKETHISTORY_MAX                                                                                                        \
     max((u_int32_t)(MAX_NUM_NODES * 2.0),                                                                                        \
         (u_int32_t)100) // x2..3  Should suffice. Empirical setup. 16B per record malloc'ed, but no less than 100
+#endif
 
 #define RECENT_WARN_AGE (10 * 60 * 1000L) // Warn if the packet that gets removed was more recent than 10 min
 
+#define PACKETHISTORY_ALIGN 64 // Align buckets to cache lines
+
 #define VERBOSE_PACKET_HISTORY 0     // Set to 1 for verbose logging, 2 for heavy debugging
 #define PACKET_HISTORY_TRACE_AGING 1 // Set to 1 to enable logging of the age of re/used history slots
 
@@ -23,24 +35,33 @@ PacketHistory::PacketHistory(uint32_t size) : recentPacketsCapacity(0), recentPa
         size = PACKETHISTORY_MAX; // Use default size if invalid
     }
 
-    // Allocate memory for the recent packets array
-    recentPacketsCapacity = size;
-    recentPackets = new PacketRecord[recentPacketsCapacity];
-    if (!recentPackets) { // No logging here, console/log probably uninitialized yet.
-        LOG_ERROR("Packet History - Memory allocation failed for size=%d entries / %d Bytes", size,
-                  sizeof(PacketRecord) * recentPacketsCapacity);
+    // Allocate memory for the recent packets hash table, rounded up to whole buckets
+    numBuckets = (size + PACKETHISTORY_WAYS - 1) / PACKETHISTORY_WAYS;
+    recentPacketsCapacity = numBuckets * PACKETHISTORY_WAYS;
+    size_t bytes = sizeof(PacketRecord) * recentPacketsCapacity;
+    recentPacketsAlloc = malloc(bytes + PACKETHISTORY_ALIGN - 1);
+    if (!recentPacketsAlloc) { // No logging here, console/log probably uninitialized yet.
+        LOG_ERROR("Packet History - Memory allocation failed for size=%d entries / %d Bytes", size, bytes);
         recentPacketsCapacity = 0; // mark allocation fail
-        return;                    // return early
+        numBuckets = 0;
+        return; // return early
     }
+    uintptr_t aligned = ((uintptr_t)recentPacketsAlloc + PACKETHISTORY_ALIGN - 1) & ~(uintptr_t)(PACKETHISTORY_ALIGN - 1);
+    recentPackets = (PacketRecord *)aligned;
 
     // Initialize the recent packets array to zero
-    memset(recentPackets, 0, sizeof(PacketRecord) * recentPacketsCapacity);
+    memset(recentPackets, 0, bytes);
+#if PACKETHISTORY_PERSIST
+    rebootObserver.observe(&notifyReboot);
+#endif
 }
 
 PacketHistory::~PacketHistory()
 {
     recentPacketsCapacity = 0;
-    delete[] recentPackets;
+    numBuckets = 0;
+    free(recentPacketsAlloc);
+    recentPacketsAlloc = NULL;
     recentPackets = NULL;
 }
 
@@ -59,6 +80,11 @@ bool PacketHistory::wasSeenRecently(const meshtastic_MeshPacket *p, bool withUpd
         return false; // Not a floodable message ID, so we don't care
     }
 
+#if PACKETHISTORY_PERSIST
+    if (restorePending)
+        restoreSnapshot();
+#endif
+
     PacketRecord r;
     memset(&r, 0, sizeof(PacketRecord)); // Initialize the record to zero
 
@@ -139,6 +165,12 @@ bool PacketHistory::wasSeenRecently(const meshtastic_MeshPacket *p, bool withUpd
             // TODO: have direct *found entry - can modify directly without local copy _vs_ not convolute the code by this
         }
         insert(r); // Insert or update the packet record in the history
+#if PACKETHISTORY_PERSIST && defined(ARCH_ESP32)
+        if (millis() - lastSnapshotMs >= PACKETHISTORY_PERSIST_INTERVAL_MS) {
+            takeSnapshot(retained);
+            lastSnapshotMs = millis();
+        }
+#endif
     }
 #if VERBOSE_PACKET_HISTORY
     LOG_DEBUG("Packet History - Was Seen Recently: @exit s=%08x id=%08x (to=%08x) relby=%02x %02x %02x nxthop=%02x rxT=%d "
@@ -161,8 +193,8 @@ PacketHistory::PacketRecord *PacketHistory::find(NodeNum sender, PacketId id)
         return NULL;
     }
 
-    PacketRecord *it = NULL;
-    for (it = recentPackets; it < (recentPackets + recentPacketsCapacity); ++it) {
+    PacketRecord *bucket = bucketFor(sender, id);
+    for (PacketRecord *it = bucket; it < bucket + PACKETHISTORY_WAYS; ++it) {
         if (it->id == id && it->sender == sender) {
 #if VERBOSE_PACKET_HISTORY
             LOG_DEBUG("Packet History - find: s=%08x id=%08x FOUND nh=%02x rby=%02x %02x %02x age=%d slot=%d/%d", it->sender,
@@ -180,7 +212,21 @@ PacketHistory::PacketRecord *PacketHistory::find(NodeNum sender, PacketId id)
     return NULL; // Not found
 }
 
-/** Insert/Replace oldest PacketRecord in recentPackets. */
+/** Hash (sender, id) to a bucket. Packet ids are often sequential per sender, so mix both properly rather than XOR them. */
+PacketHistory::PacketRecord *PacketHistory::bucketFor(NodeNum sender, PacketId id)
+{
+    uint32_t h = sender * 0x9E3779B1u ^ id;
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    // Multiply-shift range reduction, avoids a division and works for any bucket count
+    uint32_t bucket = (uint32_t)(((uint64_t)h * numBuckets) >> 32);
+    return recentPackets + bucket * PACKETHISTORY_WAYS;
+}
+
+/** Insert/Replace oldest PacketRecord in its bucket of recentPackets. */
 void PacketHistory::insert(PacketRecord &r)
 {
     uint32_t now_millis = millis(); // Should not jump with time changes
@@ -188,15 +234,18 @@ void PacketHistory::insert(PacketRecord &r)
     PacketRecord *tu = NULL; // Will insert here.
     PacketRecord *it = NULL;
 
-    // Find a free, matching or oldest used slot in the recentPackets array
-    for (it = recentPackets; it < (recentPackets + recentPacketsCapacity); ++it) {
+    PacketRecord *bucket = bucketFor(r.sender, r.id);
+    PacketRecord *bucketEnd = bucket + PACKETHISTORY_WAYS;
+
+    // Find a free, matching or oldest used slot in the bucket, the rest of the table is never touched
+    for (it = bucket; it < bucketEnd; ++it) {
         if (it->id == 0 && it->sender == 0 /*&& rxTimeMsec == 0*/) { // Record is empty
             tu = it;                                                 // Remember the free slot
 #if VERBOSE_PACKET_HISTORY >= 2
             LOG_DEBUG("Packet History - insert: Free slot@ %d/%d", tu - recentPackets, recentPacketsCapacity);
 #endif
             // We have that, Exit the loop
-            it = (recentPackets + recentPacketsCapacity);
+            it = bucketEnd;
         } else if (it->id == r.id && it->sender == r.sender) { // Record matches the packet we want to insert
             tu = it;                                           // Remember the matching slot
             OldtrxTimeMsec = now_millis - it->rxTimeMsec;      // ..and save current entry's age
@@ -205,7 +254,7 @@ void PacketHistory::insert(PacketRecord &r)
                       OldtrxTimeMsec);
 #endif
             // We have that, Exit the loop
-            it = (recentPackets + recentPacketsCapacity);
+            it = bucketEnd;
         } else {
             if (it->rxTimeMsec == 0) {
                 LOG_WARN(
@@ -220,7 +269,7 @@ void PacketHistory::insert(PacketRecord &r)
                           OldtrxTimeMsec);
 #endif
             }
-            // keep looking for oldest till entire array is checked
+            // keep looking for oldest till entire bucket is checked
         }
     }
 
@@ -321,6 +370,35 @@ bool PacketHistory::wasRelayer(const uint8_t relayer, const uint32_t id, const N
     return wasRelayer(relayer, *found);
 }
 
+/* Count the distinct nodes other than us that relayed a packet in the history given an ID and sender
+ * @return 0 if the packet is not in the history */
+uint8_t PacketHistory::countRelayers(const uint32_t id, const NodeNum sender)
+{
+    if (!initOk()) {
+        LOG_ERROR("PacketHistory - countRelayers: NOT INITIALIZED!");
+        return 0;
+    }
+
+    PacketRecord *found = find(sender, id);
+    if (found == NULL)
+        return 0;
+
+    uint8_t ourRelayID = nodeDB->getLastByteOfNodeNum(nodeDB->getNodeNum());
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < NUM_RELAYERS; i++) {
+        uint8_t relayer = found->relayed_by[i];
+        if (relayer == 0 || relayer == ourRelayID)
+            continue;
+        // The same relayer heard twice is in the list twice, only count its first entry
+        bool earlier = false;
+        for (uint8_t j = 0; j < i; j++)
+            earlier |= found->relayed_by[j] == relayer;
+        if (!earlier)
+            count++;
+    }
+    return count;
+}
+
 /* Check if a certain node was a relayer of a packet in the history given iterator
  * @return true if node was indeed a relayer, false if not */
 bool PacketHistory::wasRelayer(const uint8_t relayer, PacketRecord &r)
@@ -382,3 +460,117 @@ void PacketHistory::removeRelayer(const uint8_t relayer, const uint32_t id, cons
               found->id, found->relayed_by[0], found->relayed_by[1], found->relayed_by[2], relayer, i != j);
 #endif
 }
+
+#if PACKETHISTORY_PERSIST
+#define SNAPSHOT_MAGIC 0x31534850 // "PHS1"
+
+#ifdef ARCH_ESP32
+RTC_NOINIT_ATTR PacketHistory::Snapshot PacketHistory::retained;
+#elif defined(FSCom)
+static const char *packetHistoryFileName = "/prefs/history.bin";
+#endif
+
+/** Copy the newest records into s, with their ages instead of millis() times. */
+void PacketHistory::takeSnapshot(Snapshot &s)
+{
+    uint32_t now = millis();
+    uint16_t oldest = 0; // Record in s with the greatest age, replaced first once s is full
+    s.count = 0;
+    for (uint32_t i = 0; i < recentPacketsCapacity; i++) {
+        const PacketRecord &r = recentPackets[i];
+        uint32_t age = now - r.rxTimeMsec;
+        if (r.rxTimeMsec == 0 || age > PACKETHISTORY_PERSIST_MAX_AGE_SECS * 1000UL)
+            continue;
+        uint16_t slot;
+        if (s.count < PACKETHISTORY_PERSIST_MAX)
+            slot = s.count++;
+        else if (age < s.records[oldest].rxTimeMsec)
+            slot = oldest;
+        else
+            continue;
+        s.records[slot] = r;
+        s.records[slot].rxTimeMsec = age;
+        if (s.count == PACKETHISTORY_PERSIST_MAX) {
+            for (uint16_t j = 0; j < s.count; j++)
+                if (s.records[j].rxTimeMsec > s.records[oldest].rxTimeMsec)
+                    oldest = j;
+        }
+    }
+    s.savedAt = getValidTime(RTCQualityDevice);
+    s.magic = SNAPSHOT_MAGIC;
+    s.crc = crc32Buffer(&s, offsetof(Snapshot, crc));
+}
+
+/** Put back the records saved before the reboot, aged by the time we were down. Waits until the clock is set. */
+void PacketHistory::restoreSnapshot()
+{
+    uint32_t now = getValidTime(RTCQualityDevice);
+    if (!now) {
+        if (millis() > PACKETHISTORY_PERSIST_MAX_AGE_SECS * 1000UL)
+            restorePending = false; // Anything saved is too old by now
+        return;
+    }
+    restorePending = false;
+
+    Snapshot *s = new Snapshot;
+    bool loaded = false;
+#ifdef ARCH_ESP32
+    *s = retained;
+    loaded = true;
+#elif defined(FSCom)
+    {
+        concurrency::LockGuard g(fsLock);
+        auto f = FSCom.open(packetHistoryFileName, FILE_O_READ);
+        if (f) {
+            loaded = f.read((uint8_t *)s, sizeof(*s)) == sizeof(*s);
+            f.close();
+            FSCom.remove(packetHistoryFileName); // Used once
+        }
+    }
+#endif
+    if (!loaded || s->magic != SNAPSHOT_MAGIC || s->crc != crc32Buffer(s, offsetof(Snapshot, crc)) ||
+        s->count > PACKETHISTORY_PERSIST_MAX || !s->savedAt || now < s->savedAt ||
+        now - s->savedAt > PACKETHISTORY_PERSIST_MAX_AGE_SECS) {
+        delete s;
+        return;
+    }
+
+    uint32_t downMsec = (now - s->savedAt) * 1000;
+    uint16_t restored = 0;
+    for (uint16_t i = 0; i < s->count; i++) {
+        PacketRecord r = s->records[i];
+        uint32_t age = r.rxTimeMsec + downMsec;
+        if (age > PACKETHISTORY_PERSIST_MAX_AGE_SECS * 1000UL || find(r.sender, r.id))
+            continue;
+        r.rxTimeMsec = millis() - age; // Wraps below zero just after boot, ages are computed the same way
+        if (r.rxTimeMsec == 0)
+            r.rxTimeMsec = 1;
+        insert(r);
+        restored++;
+    }
+    LOG_INFO("Packet History - restored %u records from before the reboot, %us ago", restored, now - s->savedAt);
+    delete s;
+}
+
+int PacketHistory::onReboot(void *unused)
+{
+    if (!initOk())
+        return 0;
+#ifdef ARCH_ESP32
+    takeSnapshot(retained);
+#elif defined(FSCom)
+    Snapshot *s = new Snapshot;
+    takeSnapshot(*s);
+    if (s->count && s->savedAt) { // Without the time it can't be restored
+        concurrency::LockGuard g(fsLock);
+        auto f = FSCom.open(packetHistoryFileName, FILE_O_WRITE);
+        if (f) {
+            f.write((const uint8_t *)s, sizeof(*s));
+            f.close();
+        }
+    }
+    delete s;
+#endif
+    return 0;
+}
+#endif
@@ -5,6 +5,20 @@
 #define NUM_RELAYERS                                                                                                             \
     3 // Number of relayer we keep track of. Use 3 to be efficient with memory alignment of PacketRecord to 16 bytes
 
+#define PACKETHISTORY_WAYS 4 // Records per hash bucket, 4 x 16B = one 64B cache line. Also the max probe length.
+
+/**
+ * Keep the newest records over a reboot, so a router restarting in heavy traffic doesn't relay again everything still going
+ * around.  ESP32 keeps them in RTC memory, refreshed every PACKETHISTORY_PERSIST_INTERVAL_MS so a crash or brownout is covered
+ * too.  Other platforms write them to flash when rebooting.  They are only restored if the clock shows how long we were down.
+ */
+#ifndef PACKETHISTORY_PERSIST
+#define PACKETHISTORY_PERSIST 0
+#endif
+#define PACKETHISTORY_PERSIST_MAX 64            // Newest records kept
+#define PACKETHISTORY_PERSIST_MAX_AGE_SECS 600  // Records older than this are not worth keeping
+#define PACKETHISTORY_PERSIST_INTERVAL_MS 30000 // ESP32: how often the copy in RTC memory is refreshed
+
 /**
  * This is a mixin that adds a record of past packets we have seen
  */
@@ -21,7 +35,13 @@ class PacketHistory
 
     uint32_t recentPacketsCapacity =
         0; // Can be set in constructor, no need to recompile. Used to allocate memory for mx_recentPackets.
-    PacketRecord *recentPackets = NULL; // Simple and fixed in size. Debloat.
+    PacketRecord *recentPackets = NULL; // Hash table of numBuckets x PACKETHISTORY_WAYS records, cache line aligned
+    void *recentPacketsAlloc = NULL;    // Unaligned allocation backing recentPackets
+    uint32_t numBuckets = 0;
+
+    /** Get the bucket a (sender, id) pair hashes to.
+     * @return pointer to the first of PACKETHISTORY_WAYS records */
+    PacketRecord *bucketFor(NodeNum sender, PacketId id);
 
     /** Find a packet record in history.
      * @param sender NodeNum
@@ -29,7 +49,7 @@ class PacketHistory
      * @return pointer to PacketRecord if found, NULL if not found */
     PacketRecord *find(NodeNum sender, PacketId id);
 
-    /** Insert/Replace oldest PacketRecord in mx_recentPackets.
+    /** Insert/Replace oldest PacketRecord in its bucket of recentPackets.
      * @param r PacketRecord to insert or replace */
     void insert(PacketRecord &r); // Insert or replace a packet record in the history
 
@@ -37,6 +57,31 @@ class PacketHistory
      * @return true if node was indeed a relayer, false if not */
     bool wasRelayer(const uint8_t relayer, PacketRecord &r);
 
+#if PACKETHISTORY_PERSIST
+    struct Snapshot {
+        uint32_t magic;
+        uint32_t savedAt; // Unix time
+        uint16_t count;
+        PacketRecord records[PACKETHISTORY_PERSIST_MAX]; // rxTimeMsec holds the record's age at savedAt
+        uint32_t crc;                                    // of everything before it
+    };
+#ifdef ARCH_ESP32
+    static Snapshot retained; // In RTC memory, survives a reset
+    uint32_t lastSnapshotMs = 0;
+#endif
+    bool restorePending = true;
+
+    /// Copy the newest records into s
+    void takeSnapshot(Snapshot &s);
+
+    /// Put back the records from before the reboot, once the clock is known
+    void restoreSnapshot();
+
+    int onReboot(void *unused);
+    CallbackObserver<PacketHistory, void *> rebootObserver =
+        CallbackObserver<PacketHistory, void *>(this, &PacketHistory::onReboot);
+#endif
+
     PacketHistory(const PacketHistory &);            // non construction-copyable
     PacketHistory &operator=(const PacketHistory &); // non copyable
   public:
@@ -57,6 +102,10 @@ class PacketHistory
      * @return true if node was indeed a relayer, false if not */
     bool wasRelayer(const uint8_t relayer, const uint32_t id, const NodeNum sender);
 
+    /* Count the distinct nodes other than us that relayed a packet in the history given an ID and sender
+     * @return 0 if the packet is not in the history */
+    uint8_t countRelayers(const uint32_t id, const NodeNum sender);
+
     // Remove a relayer from the list of relayers of a packet in the history given an ID and sender
     void removeRelayer(const uint8_t relayer, const uint32_t id, const NodeNum sender);
 
@@ -0,0 +1,98 @@
+#include "PacketLatency.h"
+
+#if PACKET_LATENCY
+#include "concurrency/LockGuard.h"
+#include "configuration.h"
+#include <Arduino.h>
+#include <string.h>
+
+// Made on first use, not by a static constructor
+static concurrency::Lock *latencyLock()
+{
+    static concurrency::Lock lock;
+    return &lock;
+}
+
+PacketLatency::Tracked PacketLatency::tracked[PACKET_LATENCY_TRACKED];
+uint8_t PacketLatency::nextSlot;
+PacketLatency::Histogram PacketLatency::histograms[NUM_STAGES];
+
+static const char *const stageNames[PacketLatency::NUM_STAGES] = {"radio rx", "router rx", "dispatch", "to phone",
+                                                                  "from phone", "queued", "dequeued", "tx start"};
+
+const char *PacketLatency::getStageName(Stage stage)
+{
+    return stageNames[stage];
+}
+
+void PacketLatency::stamp(Stage stage, const meshtastic_MeshPacket *p)
+{
+    if (!p->id)
+        return;
+
+    uint32_t now = micros();
+    NodeNum from = getFrom(p);
+    concurrency::LockGuard g(latencyLock());
+
+    Tracked *t = NULL;
+    for (int i = 0; i < PACKET_LATENCY_TRACKED; i++) {
+        if (tracked[i].id == p->id && tracked[i].from == from) {
+            t = &tracked[i];
+            break;
+        }
+    }
+
+    if (t) {
+        uint32_t us = now - t->lastUs;
+        Histogram &h = histograms[stage];
+        int b = 0;
+        while (b < NUM_BUCKETS - 1 && us >= (1UL << b))
+            b++;
+        h.buckets[b]++;
+        h.count++;
+        h.totalUs += us;
+        if (us > h.maxUs)
+            h.maxUs = us;
+        t->lastUs = now;
+    } else if (stage == RadioRx || stage == FromPhone || stage == Queued) {
+        t = &tracked[nextSlot];
+        nextSlot = (nextSlot + 1) % PACKET_LATENCY_TRACKED;
+        t->from = from;
+        t->id = p->id;
+        t->lastUs = now;
+    }
+
+    if (t && (stage == ToPhone || stage == TxStart))
+        t->id = 0; // done with it, a relay of the same packet starts again at Queued
+}
+
+/// The bucket below which fraction of the counts fall, as microseconds
+static uint32_t percentileUs(const PacketLatency::Histogram &h, uint32_t percent)
+{
+    uint64_t want = (uint64_t)h.count * percent / 100, seen = 0;
+    for (int b = 0; b < PacketLatency::NUM_BUCKETS; b++) {
+        seen += h.buckets[b];
+        if (seen > want)
+            return b < PacketLatency::NUM_BUCKETS - 1 ? (1UL << b) : h.maxUs;
+    }
+    return h.maxUs;
+}
+
+void PacketLatency::logHistograms()
+{
+    concurrency::LockGuard g(latencyLock());
+    LOG_INFO("Packet latency since the previous stage (count, avg/max us, p50/p90/p99 below us):");
+    for (int s = 0; s < NUM_STAGES; s++) {
+        const Histogram &h = histograms[s];
+        if (h.count)
+            LOG_INFO("  %s: %u, %u/%u, %u/%u/%u", stageNames[s], h.count, (uint32_t)(h.totalUs / h.count), h.maxUs,
+                     percentileUs(h, 50), percentileUs(h, 90), percentileUs(h, 99));
+    }
+}
+
+void PacketLatency::reset()
+{
+    concurrency::LockGuard g(latencyLock());
+    memset(histograms, 0, sizeof(histograms));
+}
+#endif
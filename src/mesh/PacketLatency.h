@@ -0,0 +1,70 @@
+#pragma once
+
+#include "MeshTypes.h"
+
+/// Set to 1 to time packets through the stages below (see PacketLatency), costs a timer read and a short search per stage
+#ifndef PACKET_LATENCY
+#define PACKET_LATENCY 0
+#endif
+
+/// How many packets in flight we follow at once, the oldest is forgotten to make room
+#ifndef PACKET_LATENCY_TRACKED
+#define PACKET_LATENCY_TRACKED 16
+#endif
+
+/**
+ * Where the time goes between the radio and the phone, and between the phone and the air.
+ *
+ * Each stage is stamped as a packet passes it, and the time since the packet's previous stage goes into that stage's
+ * histogram of log2 microsecond buckets.  Packets are followed by (from, id), so copies made along the way still count.
+ */
+class PacketLatency
+{
+  public:
+    enum Stage {
+        RadioRx,   // frame read from the radio, starts the receive path
+        RouterRx,  // Router::handleReceived()
+        Dispatch,  // MeshModule::callModules()
+        ToPhone,   // MeshService::sendToPhone(), ends the receive path
+        FromPhone, // MeshService::handleToRadio(), starts the transmit path for phone packets
+        Queued,    // MeshPacketQueue::enqueue(), starts the transmit path for our own packets and continues it for relays
+        Dequeued,  // MeshPacketQueue::dequeue()
+        TxStart,   // RadioLibInterface::startSend(), ends the transmit path
+        NUM_STAGES
+    };
+
+    static const int NUM_BUCKETS = 24; // bucket b counts times < 2^b us, the last one everything longer
+
+    struct Histogram {
+        uint32_t count;
+        uint32_t maxUs;
+        uint64_t totalUs;
+        uint32_t buckets[NUM_BUCKETS];
+    };
+
+#if PACKET_LATENCY
+    static void stamp(Stage stage, const meshtastic_MeshPacket *p);
+
+    static const Histogram &get(Stage stage) { return histograms[stage]; }
+
+    /// Write one line per stage to the log
+    static void logHistograms();
+
+    static void reset();
+
+    static const char *getStageName(Stage stage);
+
+  private:
+    struct Tracked {
+        NodeNum from;
+        PacketId id;
+        uint32_t lastUs; // when it passed its previous stage
+    };
+
+    static Tracked tracked[PACKET_LATENCY_TRACKED];
+    static uint8_t nextSlot;
+    static Histogram histograms[NUM_STAGES];
+#else
+    static void stamp(Stage, const meshtastic_MeshPacket *) {}
+#endif
+};
@@ -0,0 +1,147 @@
+#include "PayloadCompression.h"
+#include "NodeDB.h"
+#include "Router.h"
+#include <string.h>
+
+#define MIN_MATCH 3
+#define MAX_MATCH (MIN_MATCH + 15)
+#define MAX_DISTANCE 4096
+
+// Field keys and length prefixes of the compressible ports, see the .proto files.  Like the wire format this can never change
+// once nodes advertise BITFIELD_PAYLOAD_COMPRESSION, only a new capability bit could bring a new dictionary.
+static const uint8_t dictionary[] = {
+    // Waypoint: name, description, icon
+    0x32, 0x00, 0x3a, 0x00, 0x45,
+    // Telemetry environment_metrics: temperature, relative_humidity, barometric_pressure
+    0x1a, 0x0f, 0x0d, 0x00, 0x00, 0x00, 0x00, 0x15, 0x00, 0x00, 0x00, 0x00, 0x1d,
+    // Telemetry device_metrics: battery_level, voltage, channel_utilization, air_util_tx, uptime_seconds
+    0x12, 0x15, 0x08, 0x65, 0x15, 0x00, 0x00, 0x00, 0x00, 0x1d, 0x00, 0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x00, 0x00, 0x28,
+    // User: id "!xxxxxxxx", long_name, short_name, macaddr, hw_model, role, public_key, and the default long_name
+    0x0a, 0x09, '!', 0x12, 0x00, 0x1a, 0x04, 0x22, 0x06, 0x28, 0x00, 0x38, 0x00, 0x42, 0x20, 0x12, 0x0f, 'M', 'e', 's', 'h', 't',
+    'a', 's', 't', 'i', 'c', ' ',
+    // NeighborInfo: node_broadcast_interval_secs 900, then neighbors with 4 and 5 byte node ids and an snr
+    0x18, 0x84, 0x07, 0x22, 0x09, 0x08, 0x00, 0x00, 0x00, 0x00, 0x15, 0x00, 0x00, 0x00, 0x00, 0x22, 0x0a, 0x08};
+
+bool PayloadCompression::isCompressible(meshtastic_PortNum port)
+{
+    return port == meshtastic_PortNum_NODEINFO_APP || port == meshtastic_PortNum_NEIGHBORINFO_APP ||
+           port == meshtastic_PortNum_WAYPOINT_APP || port == meshtastic_PortNum_TELEMETRY_APP;
+}
+
+/// The byte at position i of the dictionary followed by in, i may be negative to reach into the dictionary
+static inline uint8_t historyAt(const uint8_t *in, int i)
+{
+    return i < 0 ? dictionary[(int)sizeof(dictionary) + i] : in[i];
+}
+
+size_t PayloadCompression::compress(const uint8_t *in, size_t len, uint8_t *out, size_t outSize)
+{
+    size_t ol = 0, flagPos = 0;
+    int items = 8; // start a new group straight away
+    for (int l = 0; l < (int)len;) {
+        if (items == 8) {
+            if (ol >= outSize)
+                return 0;
+            flagPos = ol++;
+            out[flagPos] = 0;
+            items = 0;
+        }
+
+        // Greedy longest match, nearest first
+        int bestLen = 0, bestDist = 0;
+        int maxLen = (int)len - l < MAX_MATCH ? (int)len - l : MAX_MATCH;
+        if (maxLen >= MIN_MATCH) {
+            int limit = l + (int)sizeof(dictionary) < MAX_DISTANCE ? l + (int)sizeof(dictionary) : MAX_DISTANCE;
+            for (int dist = 1; dist <= limit && bestLen < maxLen; dist++) {
+                if (historyAt(in, l - dist) != in[l])
+                    continue;
+                int k = 1;
+                // The match may run on into the bytes it is copying, like any LZ77
+                while (k < maxLen && historyAt(in, l - dist + k) == in[l + k])
+                    k++;
+                if (k > bestLen) {
+                    bestLen = k;
+                    bestDist = dist;
+                }
+            }
+        }
+
+        if (bestLen >= MIN_MATCH) {
+            if (ol + 2 > outSize)
+                return 0;
+            uint16_t code = ((bestLen - MIN_MATCH) << 12) | (bestDist - 1);
+            out[ol++] = code >> 8;
+            out[ol++] = code & 0xff;
+            out[flagPos] |= 0x80 >> items;
+            l += bestLen;
+        } else {
+            if (ol >= outSize)
+                return 0;
+            out[ol++] = in[l++];
+        }
+        items++;
+    }
+    return ol < len ? ol : 0;
+}
+
+int PayloadCompression::decompress(const uint8_t *in, size_t len, uint8_t *out, size_t outSize)
+{
+    size_t il = 0;
+    int ol = 0;
+    while (il < len) {
+        uint8_t flags = in[il++];
+        for (int item = 0; item < 8 && il < len; item++) {
+            if (flags & (0x80 >> item)) {
+                if (il + 2 > len)
+                    return -1;
+                uint16_t code = (in[il] << 8) | in[il + 1];
+                il += 2;
+                int matchLen = (code >> 12) + MIN_MATCH;
+                int dist = (code & 0xfff) + 1;
+                if (dist > ol + (int)sizeof(dictionary) || ol + matchLen > (int)outSize)
+                    return -1;
+                for (int k = 0; k < matchLen; k++, ol++)
+                    out[ol] = historyAt(out, ol - dist);
+            } else {
+                if (ol >= (int)outSize)
+                    return -1;
+                out[ol++] = in[il++];
+            }
+        }
+    }
+    return ol;
+}
+
+bool PayloadCompression::decompressPacket(meshtastic_MeshPacket *mp)
+{
+    if (!mp->decoded.has_bitfield || !(mp->decoded.bitfield & BITFIELD_PAYLOAD_COMPRESSED_MASK))
+        return true;
+
+    uint8_t payload[meshtastic_Constants_DATA_PAYLOAD_LEN];
+    int len = decompress(mp->decoded.payload.bytes, mp->decoded.payload.size, payload, sizeof(payload));
+    if (len < 0) {
+        LOG_WARN("Can't decompress payload from 0x%x", getFrom(mp));
+        return false;
+    }
+    memcpy(mp->decoded.payload.bytes, payload, len);
+    mp->decoded.payload.size = len;
+    mp->decoded.bitfield &= ~BITFIELD_PAYLOAD_COMPRESSED_MASK;
+    return true;
+}
+
+bool PayloadCompression::peerSupports(NodeNum n)
+{
+    const meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(n);
+    return node && (node->bitfield & NODEINFO_BITFIELD_PAYLOAD_COMPRESSION_MASK);
+}
+
+void PayloadCompression::setPeerSupports(NodeNum n, bool supported)
+{
+    meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(n);
+    if (!node)
+        return;
+    if (supported)
+        node->bitfield |= NODEINFO_BITFIELD_PAYLOAD_COMPRESSION_MASK;
+    else
+        node->bitfield &= ~NODEINFO_BITFIELD_PAYLOAD_COMPRESSION_MASK;
+}
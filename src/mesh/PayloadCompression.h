@@ -0,0 +1,46 @@
+#pragma once
+
+#include "MeshTypes.h"
+
+/// Set to 1 to compress NodeInfo, NeighborInfo, Waypoint and Telemetry payloads to nodes that can take them, and to accept them
+#ifndef PAYLOAD_COMPRESSION
+#define PAYLOAD_COMPRESSION 0
+#endif
+#if PAYLOAD_COMPRESSION && !PRIVATE_BITFIELD_FLAGS
+#error "PAYLOAD_COMPRESSION uses a private Data.bitfield flag and needs PRIVATE_BITFIELD_FLAGS, see Router.h"
+#endif
+
+/**
+ * A small LZSS codec for protobuf payloads.  Matches can reach back into a static dictionary of the field keys and length
+ * prefixes these ports send, so even a payload with no repeats of its own gets its common headers for two bytes each.
+ *
+ * A compressed payload has BITFIELD_PAYLOAD_COMPRESSED set in its Data.  As with TextCompression we only compress direct
+ * messages to nodes whose NodeInfo had BITFIELD_PAYLOAD_COMPRESSION, relays pass the payload on compressed and the destination
+ * decompresses it in perhapsDecode.  ProtobufModule decompresses for itself when it sniffs a packet meant for someone else.
+ *
+ * The stream is groups of a flag byte and up to 8 items, a 0 flag bit (MSB first) is a literal byte and a 1 is a 2 byte match:
+ * 4 bits length - MIN_MATCH, 12 bits distance - 1 back from the current position, counting the dictionary as if it came just
+ * before the payload.
+ */
+class PayloadCompression
+{
+  public:
+    /// Whether we compress payloads of this port
+    static bool isCompressible(meshtastic_PortNum port);
+
+    /// @return the compressed length, or 0 if compressing wouldn't make it shorter
+    static size_t compress(const uint8_t *in, size_t len, uint8_t *out, size_t outSize);
+
+    /// @return the decompressed length, or -1 if in isn't valid or doesn't fit
+    static int decompress(const uint8_t *in, size_t len, uint8_t *out, size_t outSize);
+
+    /// Decompress mp's payload in place if it's compressed
+    /// @return false if it was compressed but isn't valid
+    static bool decompressPacket(meshtastic_MeshPacket *mp);
+
+    /// Whether node n has told us it can take compressed payloads
+    static bool peerSupports(NodeNum n);
+
+    /// Remember what node n's NodeInfo said
+    static void setPeerSupports(NodeNum n, bool supported);
+};
@@ -5,6 +5,7 @@
 
 #include "Channels.h"
 #include "Default.h"
+#include "EventTrace.h"
 #include "FSCommon.h"
 #include "MeshService.h"
 #include "NodeDB.h"
@@ -34,7 +35,6 @@
 PhoneAPI::PhoneAPI()
 {
     lastContactMsec = millis();
-    std::fill(std::begin(recentToRadioPacketIds), std::end(recentToRadioPacketIds), 0);
 }
 
 PhoneAPI::~PhoneAPI()
@@ -42,6 +42,15 @@ PhoneAPI::~PhoneAPI()
     close();
 }
 
+#if PSRAM_PLACEMENT
+void *PhoneAPI::operator new(size_t size)
+{
+    void *p = memGet.allocCold(size);
+    assert(p);
+    return p;
+}
+#endif
+
 void PhoneAPI::handleStartConfig()
 {
     // Must be before setting state (because state is how we know !connected)
@@ -62,10 +71,25 @@ void PhoneAPI::handleStartConfig()
         state = STATE_SEND_MY_INFO;
     }
     pauseBluetoothLogging = true;
-    spiLock->lock();
-    filesManifest = getFiles("/", 10);
-    spiLock->unlock();
-    LOG_DEBUG("Got %d files in manifest", filesManifest.size());
+    configStartMsec = millis();
+
+    syncStartGeneration = nodeDB->beginNodeSync();
+    nodesSince = 0;
+    if ((config_nonce & SPECIAL_NONCE_NODES_SINCE_MASK) == SPECIAL_NONCE_NODES_SINCE) {
+        uint32_t since = config_nonce & ~SPECIAL_NONCE_NODES_SINCE_MASK;
+        if (nodeDB->isValidSyncGeneration(since)) {
+            nodesSince = since;
+            LOG_INFO("Client wants nodes changed since generation 0x%x", since);
+        } else if (since) {
+            LOG_INFO("Unknown node sync generation 0x%x, send all nodes", since);
+        }
+    }
+    if (config_nonce != SPECIAL_NONCE_NO_FILES) {
+        fsLock->lock();
+        filesManifest = getFileManifest();
+        fsLock->unlock();
+        LOG_DEBUG("Got %d files in manifest", filesManifest.size());
+    }
 
     LOG_INFO("Start API client config");
     nodeInfoForPhone.num = 0; // Don't keep returning old nodeinfos
@@ -96,6 +120,7 @@ void PhoneAPI::close()
         fromRadioNum = 0;
         config_nonce = 0;
         config_state = 0;
+        nodesSince = 0;
         pauseBluetoothLogging = false;
     }
 }
@@ -188,9 +213,15 @@ bool PhoneAPI::handleToRadio(const uint8_t *buf, size_t bufLength)
 
 size_t PhoneAPI::getFromRadio(uint8_t *buf)
 {
+    TRACE_SCOPE("PhoneAPI::getFromRadio");
     if (!available()) {
         return 0;
     }
+#if PHONEAPI_DIRECT_ENCODE
+    size_t direct = getFromRadioDirect(buf);
+    if (direct)
+        return direct;
+#endif
     // In case we send a FromRadio packet
     memset(&fromRadioScratch, 0, sizeof(fromRadioScratch));
 
@@ -222,7 +253,7 @@ size_t PhoneAPI::getFromRadio(uint8_t *buf)
         LOG_DEBUG("Send My NodeInfo");
         auto us = nodeDB->readNextMeshNode(readIndex);
         if (us) {
-            nodeInfoForPhone = TypeConversions::ConvertToNodeInfo(us);
+            TypeConversions::ConvertToNodeInfo(us, &nodeInfoForPhone);
             nodeInfoForPhone.has_hops_away = false;
             nodeInfoForPhone.is_favorite = true;
             fromRadioScratch.which_payload_variant = meshtastic_FromRadio_node_info_tag;
@@ -316,12 +347,7 @@ size_t PhoneAPI::getFromRadio(uint8_t *buf)
         // So even if we internally use 0 to represent 'use default' we still need to send the value we are
         // using to the app (so that even old phone apps work with new device loads).
 
-        config_state++;
-        // Advance when we have sent all of our config objects
-        if (config_state > (_meshtastic_AdminMessage_ConfigType_MAX + 1)) {
-            state = STATE_SEND_MODULECONFIG;
-            config_state = _meshtastic_AdminMessage_ModuleConfigType_MIN + 1;
-        }
+        nextConfig();
         break;
 
     case STATE_SEND_MODULECONFIG:
@@ -396,19 +422,7 @@ size_t PhoneAPI::getFromRadio(uint8_t *buf)
             LOG_ERROR("Unknown module config type %d", config_state);
         }
 
-        config_state++;
-        // Advance when we have sent all of our ModuleConfig objects
-        if (config_state > (_meshtastic_AdminMessage_ModuleConfigType_MAX + 1)) {
-            // Handle special nonce behaviors:
-            // - SPECIAL_NONCE_ONLY_CONFIG: Skip node info, go directly to file manifest
-            // - SPECIAL_NONCE_ONLY_NODES: After sending nodes, skip to complete
-            if (config_nonce == SPECIAL_NONCE_ONLY_CONFIG) {
-                state = STATE_SEND_FILEMANIFEST;
-            } else {
-                state = STATE_SEND_OTHER_NODEINFOS;
-            }
-            config_state = 0;
-        }
+        nextModuleConfig();
         break;
 
     case STATE_SEND_OTHER_NODEINFOS: {
@@ -499,11 +513,236 @@ size_t PhoneAPI::getFromRadio(uint8_t *buf)
     return 0;
 }
 
+void PhoneAPI::nextConfig()
+{
+    config_state++;
+    // Advance when we have sent all of our config objects
+    if (config_state > (_meshtastic_AdminMessage_ConfigType_MAX + 1)) {
+        state = STATE_SEND_MODULECONFIG;
+        config_state = _meshtastic_AdminMessage_ModuleConfigType_MIN + 1;
+    }
+}
+
+void PhoneAPI::nextModuleConfig()
+{
+    config_state++;
+    // Advance when we have sent all of our ModuleConfig objects
+    if (config_state > (_meshtastic_AdminMessage_ModuleConfigType_MAX + 1)) {
+        // Handle special nonce behaviors:
+        // - SPECIAL_NONCE_ONLY_CONFIG: Skip node info, go directly to file manifest
+        // - SPECIAL_NONCE_ONLY_NODES: After sending nodes, skip to complete
+        if (config_nonce == SPECIAL_NONCE_ONLY_CONFIG) {
+            state = STATE_SEND_FILEMANIFEST;
+        } else {
+            state = STATE_SEND_OTHER_NODEINFOS;
+        }
+        config_state = 0;
+    }
+}
+
+#if PHONEAPI_DIRECT_ENCODE
+/**
+ * Encode a FromRadio whose only field, outerTag, is a message holding only innerTag, a message of type fields at src.  These are
+ * the bytes pb_encode would produce from fromRadioScratch, without src being copied in there first.
+ * @return 0 if it doesn't fit
+ */
+static size_t encodeFromRadioNested(uint8_t *buf, uint32_t outerTag, uint32_t innerTag, const pb_msgdesc_t *fields,
+                                    const void *src)
+{
+    size_t innerSize;
+    if (!pb_get_encoded_size(&innerSize, fields, src))
+        return 0;
+    pb_ostream_t sizing = PB_OSTREAM_SIZING;
+    pb_encode_tag(&sizing, PB_WT_STRING, innerTag);
+    pb_encode_varint(&sizing, innerSize);
+
+    pb_ostream_t stream = pb_ostream_from_buffer(buf, meshtastic_FromRadio_size);
+    if (!pb_encode_tag(&stream, PB_WT_STRING, outerTag) || !pb_encode_varint(&stream, sizing.bytes_written + innerSize) ||
+        !pb_encode_tag(&stream, PB_WT_STRING, innerTag) || !pb_encode_varint(&stream, innerSize) ||
+        !pb_encode(&stream, fields, src))
+        return 0;
+    return stream.bytes_written;
+}
+
+/// Like encodeFromRadioNested(), for a FromRadio whose only field is the message src
+static size_t encodeFromRadio(uint8_t *buf, uint32_t tag, const pb_msgdesc_t *fields, const void *src)
+{
+    pb_ostream_t stream = pb_ostream_from_buffer(buf, meshtastic_FromRadio_size);
+    if (!pb_encode_tag(&stream, PB_WT_STRING, tag) || !pb_encode_submessage(&stream, fields, src))
+        return 0;
+    return stream.bytes_written;
+}
+
+size_t PhoneAPI::getFromRadioDirect(uint8_t *buf)
+{
+    const pb_msgdesc_t *fields = NULL;
+    const void *src = NULL;
+    size_t len = 0;
+
+    switch (state) {
+    case STATE_SEND_CONFIG: {
+        meshtastic_Config_PowerConfig power;
+        switch (config_state) {
+        case meshtastic_Config_device_tag:
+            fields = meshtastic_Config_DeviceConfig_fields;
+            src = &config.device;
+            break;
+        case meshtastic_Config_position_tag:
+            fields = meshtastic_Config_PositionConfig_fields;
+            src = &config.position;
+            break;
+        case meshtastic_Config_power_tag:
+            power = config.power;
+            power.ls_secs = default_ls_secs; // See STATE_SEND_CONFIG in getFromRadio()
+            fields = meshtastic_Config_PowerConfig_fields;
+            src = &power;
+            break;
+        case meshtastic_Config_network_tag:
+            fields = meshtastic_Config_NetworkConfig_fields;
+            src = &config.network;
+            break;
+        case meshtastic_Config_display_tag:
+            fields = meshtastic_Config_DisplayConfig_fields;
+            src = &config.display;
+            break;
+        case meshtastic_Config_lora_tag:
+            fields = meshtastic_Config_LoRaConfig_fields;
+            src = &config.lora;
+            break;
+        case meshtastic_Config_bluetooth_tag:
+            fields = meshtastic_Config_BluetoothConfig_fields;
+            src = &config.bluetooth;
+            break;
+        case meshtastic_Config_security_tag:
+            fields = meshtastic_Config_SecurityConfig_fields;
+            src = &config.security;
+            break;
+        default:
+            return 0; // The empty ones go through fromRadioScratch
+        }
+        LOG_DEBUG("Send config %d", config_state);
+        len = encodeFromRadioNested(buf, meshtastic_FromRadio_config_tag, config_state, fields, src);
+        if (len)
+            nextConfig();
+        return len;
+    }
+
+    case STATE_SEND_MODULECONFIG:
+        switch (config_state) {
+        case meshtastic_ModuleConfig_mqtt_tag:
+            fields = meshtastic_ModuleConfig_MQTTConfig_fields;
+            src = &moduleConfig.mqtt;
+            break;
+        case meshtastic_ModuleConfig_serial_tag:
+            fields = meshtastic_ModuleConfig_SerialConfig_fields;
+            src = &moduleConfig.serial;
+            break;
+        case meshtastic_ModuleConfig_external_notification_tag:
+            fields = meshtastic_ModuleConfig_ExternalNotificationConfig_fields;
+            src = &moduleConfig.external_notification;
+            break;
+        case meshtastic_ModuleConfig_store_forward_tag:
+            fields = meshtastic_ModuleConfig_StoreForwardConfig_fields;
+            src = &moduleConfig.store_forward;
+            break;
+        case meshtastic_ModuleConfig_range_test_tag:
+            fields = meshtastic_ModuleConfig_RangeTestConfig_fields;
+            src = &moduleConfig.range_test;
+            break;
+        case meshtastic_ModuleConfig_telemetry_tag:
+            fields = meshtastic_ModuleConfig_TelemetryConfig_fields;
+            src = &moduleConfig.telemetry;
+            break;
+        case meshtastic_ModuleConfig_canned_message_tag:
+            fields = meshtastic_ModuleConfig_CannedMessageConfig_fields;
+            src = &moduleConfig.canned_message;
+            break;
+        case meshtastic_ModuleConfig_audio_tag:
+            fields = meshtastic_ModuleConfig_AudioConfig_fields;
+            src = &moduleConfig.audio;
+            break;
+        case meshtastic_ModuleConfig_remote_hardware_tag:
+            fields = meshtastic_ModuleConfig_RemoteHardwareConfig_fields;
+            src = &moduleConfig.remote_hardware;
+            break;
+        case meshtastic_ModuleConfig_neighbor_info_tag:
+            fields = meshtastic_ModuleConfig_NeighborInfoConfig_fields;
+            src = &moduleConfig.neighbor_info;
+            break;
+        case meshtastic_ModuleConfig_detection_sensor_tag:
+            fields = meshtastic_ModuleConfig_DetectionSensorConfig_fields;
+            src = &moduleConfig.detection_sensor;
+            break;
+        case meshtastic_ModuleConfig_ambient_lighting_tag:
+            fields = meshtastic_ModuleConfig_AmbientLightingConfig_fields;
+            src = &moduleConfig.ambient_lighting;
+            break;
+        case meshtastic_ModuleConfig_paxcounter_tag:
+            fields = meshtastic_ModuleConfig_PaxcounterConfig_fields;
+            src = &moduleConfig.paxcounter;
+            break;
+        default:
+            return 0;
+        }
+        LOG_DEBUG("Send module config %d", config_state);
+        len = encodeFromRadioNested(buf, meshtastic_FromRadio_moduleConfig_tag, config_state, fields, src);
+        if (len)
+            nextModuleConfig();
+        return len;
+
+    case STATE_SEND_OTHER_NODEINFOS:
+        if (nodeInfoForPhone.num == 0)
+            return 0; // Done, getFromRadio() moves on
+        LOG_INFO("nodeinfo: num=0x%x, lastseen=%u, id=%s, name=%s", nodeInfoForPhone.num, nodeInfoForPhone.last_heard,
+                 nodeInfoForPhone.user.id, nodeInfoForPhone.user.long_name);
+        len = encodeFromRadio(buf, meshtastic_FromRadio_node_info_tag, meshtastic_NodeInfo_fields, &nodeInfoForPhone);
+        if (len)
+            nodeInfoForPhone.num = 0; // We just consumed a nodeinfo, will need a new one next time
+        return len;
+
+    case STATE_SEND_PACKETS:
+        // Only when the packet is what getFromRadio() would send next
+        if (!packetForPhone || queueStatusPacketForPhone || mqttClientProxyMessageForPhone ||
+            xmodemPacketForPhone.control != meshtastic_XModem_Control_NUL || clientNotification)
+            return 0;
+        pauseBluetoothLogging = false;
+        printPacket("phone downloaded packet", packetForPhone);
+        len = encodeFromRadio(buf, meshtastic_FromRadio_packet_tag, meshtastic_MeshPacket_fields, packetForPhone);
+        if (len)
+            releasePhonePacket();
+        return len;
+
+    default:
+        return 0;
+    }
+}
+#endif
+
+size_t PhoneAPI::getFromRadioBatch(uint8_t *buf, size_t bufLen, size_t headerLen, void (*frameHeader)(uint8_t *header, size_t len))
+{
+    size_t used = 0;
+    while (bufLen - used >= headerLen + meshtastic_FromRadio_size) {
+        bool wasConfig = !isSendingPackets();
+        size_t len = getFromRadio(buf + used + headerLen);
+        if (!len)
+            break;
+        if (frameHeader)
+            frameHeader(buf + used, len);
+        used += headerLen + len;
+        if (wasConfig && isSendingPackets())
+            break; // end the batch with the config, so callers can tell it apart from packets
+    }
+    return used;
+}
+
 void PhoneAPI::sendConfigComplete()
 {
-    LOG_INFO("Config Send Complete");
+    LOG_INFO("Config Send Complete in %u ms", (unsigned)(millis() - configStartMsec));
     fromRadioScratch.which_payload_variant = meshtastic_FromRadio_config_complete_id_tag;
     fromRadioScratch.config_complete_id = config_nonce;
+    // Tell clients that understand delta syncs where to resume from next time
+    if ((config_nonce & SPECIAL_NONCE_NODES_SINCE_MASK) == SPECIAL_NONCE_NODES_SINCE)
+        fromRadioScratch.id = SPECIAL_NONCE_NODES_SINCE | syncStartGeneration;
     config_nonce = 0;
     state = STATE_SEND_PACKETS;
     pauseBluetoothLogging = false;
@@ -563,8 +802,11 @@ bool PhoneAPI::available()
     case STATE_SEND_OTHER_NODEINFOS:
         if (nodeInfoForPhone.num == 0) {
             auto nextNode = nodeDB->readNextMeshNode(readIndex);
+            // On a delta sync skip the nodes the client already has
+            while (nextNode && nodesSince && nodeDB->getNodeChangeGeneration(nextNode->num) <= nodesSince)
+                nextNode = nodeDB->readNextMeshNode(readIndex);
             if (nextNode) {
-                nodeInfoForPhone = TypeConversions::ConvertToNodeInfo(nextNode);
+                TypeConversions::ConvertToNodeInfo(nextNode, &nodeInfoForPhone);
                 bool isUs = nodeInfoForPhone.num == nodeDB->getNodeNum();
                 nodeInfoForPhone.hops_away = isUs ? 0 : nodeInfoForPhone.hops_away;
                 nodeInfoForPhone.last_heard = isUs ? getValidTime(RTCQualityFromNet) : nodeInfoForPhone.last_heard;
@@ -627,19 +869,24 @@ void PhoneAPI::sendNotification(meshtastic_LogRecord_Level level, uint32_t reply
 
 bool PhoneAPI::wasSeenRecently(uint32_t id)
 {
-    for (int i = 0; i < 20; i++) {
-        if (recentToRadioPacketIds[i] == id) {
-            return true;
-        }
-        if (recentToRadioPacketIds[i] == 0) {
-            recentToRadioPacketIds[i] = id;
-            return false;
-        }
-    }
-    // If the array is full, shift all elements to the left and add the new id at the end
-    memmove(recentToRadioPacketIds, recentToRadioPacketIds + 1, (19) * sizeof(uint32_t));
-    recentToRadioPacketIds[19] = id;
-    return false;
+    return recentToRadioIdSet.find(id) != NULL;
+}
+
+void PhoneAPI::rememberToRadioId(uint32_t id)
+{
+    static_assert(PHONEAPI_RECENT_IDS <= 256 && (PHONEAPI_RECENT_IDS & (PHONEAPI_RECENT_IDS - 1)) == 0,
+                  "PHONEAPI_RECENT_IDS must be a power of two of at most 256");
+
+    if (id == 0 || recentToRadioIdSet.find(id))
+        return;
+
+    // Reuse the oldest ring slot, forgetting the id it held
+    uint32_t &slot = recentToRadioPacketIds[recentToRadioNext];
+    if (slot != 0)
+        recentToRadioIdSet.erase(slot);
+    slot = id;
+    recentToRadioIdSet.insert(id, recentToRadioNext);
+    recentToRadioNext = (recentToRadioNext + 1) & (PHONEAPI_RECENT_IDS - 1);
 }
 
 /**
@@ -658,8 +905,10 @@ bool PhoneAPI::handleToRadioPacket(meshtastic_MeshPacket &p)
             return false;
         }
 
-    if (p.decoded.portnum == meshtastic_PortNum_TRACEROUTE_APP && lastPortNumToRadio[p.decoded.portnum] &&
-        Throttle::isWithinTimespanMs(lastPortNumToRadio[p.decoded.portnum], THIRTY_SECONDS_MS)) {
+    const uint32_t *lastSentPtr = lastPortNumToRadio.find(p.decoded.portnum);
+    uint32_t lastSent = lastSentPtr ? *lastSentPtr : 0;
+    if (p.decoded.portnum == meshtastic_PortNum_TRACEROUTE_APP && lastSent &&
+        Throttle::isWithinTimespanMs(lastSent, THIRTY_SECONDS_MS)) {
         LOG_WARN("Rate limit portnum %d", p.decoded.portnum);
         sendNotification(meshtastic_LogRecord_Level_WARNING, p.id, "TraceRoute can only be sent once every 30 seconds");
         meshtastic_QueueStatus qs = router->getQueueStatus();
@@ -672,8 +921,7 @@ bool PhoneAPI::handleToRadioPacket(meshtastic_MeshPacket &p)
         return false;
     } else if (IS_ONE_OF(p.decoded.portnum, meshtastic_PortNum_POSITION_APP, meshtastic_PortNum_WAYPOINT_APP,
                          meshtastic_PortNum_ALERT_APP, meshtastic_PortNum_TELEMETRY_APP) &&
-               lastPortNumToRadio[p.decoded.portnum] &&
-               Throttle::isWithinTimespanMs(lastPortNumToRadio[p.decoded.portnum], TEN_SECONDS_MS)) {
+               lastSent && Throttle::isWithinTimespanMs(lastSent, TEN_SECONDS_MS)) {
         // TODO: [Issue #6700] Make this rate limit throttling scale up / down with the preset
         LOG_WARN("Rate limit portnum %d", p.decoded.portnum);
         meshtastic_QueueStatus qs = router->getQueueStatus();
@@ -681,15 +929,20 @@ bool PhoneAPI::handleToRadioPacket(meshtastic_MeshPacket &p)
         // FIXME: Figure out why this continues to happen
         // sendNotification(meshtastic_LogRecord_Level_WARNING, p.id, "Position can only be sent once every 5 seconds");
         return false;
-    } else if (p.decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_APP && lastPortNumToRadio[p.decoded.portnum] &&
-               Throttle::isWithinTimespanMs(lastPortNumToRadio[p.decoded.portnum], TWO_SECONDS_MS)) {
+    } else if (p.decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_APP && lastSent &&
+               Throttle::isWithinTimespanMs(lastSent, TWO_SECONDS_MS)) {
         LOG_WARN("Rate limit portnum %d", p.decoded.portnum);
         meshtastic_QueueStatus qs = router->getQueueStatus();
         service->sendQueueStatusToPhone(qs, 0, p.id);
         sendNotification(meshtastic_LogRecord_Level_WARNING, p.id, "Text messages can only be sent once every 2 seconds");
         return false;
     }
-    lastPortNumToRadio[p.decoded.portnum] = millis();
+    if (IS_ONE_OF(p.decoded.portnum, meshtastic_PortNum_TRACEROUTE_APP, meshtastic_PortNum_POSITION_APP,
+                  meshtastic_PortNum_WAYPOINT_APP, meshtastic_PortNum_ALERT_APP, meshtastic_PortNum_TELEMETRY_APP,
+                  meshtastic_PortNum_TEXT_MESSAGE_APP))
+        lastPortNumToRadio.insert(p.decoded.portnum, millis());
+    // Only ids of packets we accepted, so the client can retry a rate limited one with the same id
+    rememberToRadioId(p.id);
     service->handleToRadio(p);
     return true;
 }
@@ -1,11 +1,12 @@
 #pragma once
 
+#include "FlatHashMap.h"
 #include "Observer.h"
+#include "memGet.h"
 #include "mesh-pb-constants.h"
 #include "meshtastic/portnums.pb.h"
 #include <iterator>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 // Make sure that we never let our packets grow too large for one BLE packet
@@ -18,8 +19,25 @@
 #error "meshtastic_ToRadio_size is too large for our BLE packets"
 #endif
 
+/// Encode configs, module configs, node infos and mesh packets for the client straight from where they live, instead of
+/// clearing fromRadioScratch and copying them in first
+#ifndef PHONEAPI_DIRECT_ENCODE
+#define PHONEAPI_DIRECT_ENCODE 0
+#endif
+
+/// How many of the latest ToRadio MeshPacket ids are remembered to drop repeats, a power of two of at most 256
+#ifndef PHONEAPI_RECENT_IDS
+#define PHONEAPI_RECENT_IDS 128
+#endif
+
 #define SPECIAL_NONCE_ONLY_CONFIG 69420
 #define SPECIAL_NONCE_ONLY_NODES 69421 // ( ͡° ͜ʖ ͡°)
+/// Like a normal config request, but without the file manifest at the end
+#define SPECIAL_NONCE_NO_FILES 69422
+/// A want_config_id of SPECIAL_NONCE_NODES_SINCE | generation only sends the nodes that changed after that generation (as
+/// returned to the client in FromRadio.id of its last config_complete_id, 0 for a full sync), see NodeDB::markNodeChanged()
+#define SPECIAL_NONCE_NODES_SINCE 0x4E000000
+#define SPECIAL_NONCE_NODES_SINCE_MASK 0xFF000000
 
 /**
  * Provides our protobuf based API which phone/PC clients can use to talk to our device
@@ -52,9 +70,12 @@ class PhoneAPI
 
     uint8_t config_state = 0;
 
-    // Hashmap of timestamps for last time we received a packet on the API per portnum
-    std::unordered_map<meshtastic_PortNum, uint32_t> lastPortNumToRadio;
-    uint32_t recentToRadioPacketIds[20]; // Last 20 ToRadio MeshPacket IDs we have seen
+    // Hashmap of timestamps for last time we received a packet on the API per rate limited portnum
+    FlatHashMap<meshtastic_PortNum, uint32_t, 16> lastPortNumToRadio;
+    // Last PHONEAPI_RECENT_IDS ToRadio MeshPacket IDs we have seen, in a ring for age order and a set for lookup
+    uint32_t recentToRadioPacketIds[PHONEAPI_RECENT_IDS] = {};
+    uint8_t recentToRadioNext = 0; // ring slot the next id goes in, replacing the oldest
+    FlatHashMap<uint32_t, uint8_t, PHONEAPI_RECENT_IDS * 2> recentToRadioIdSet; // id -> its ring slot
 
     /**
      * Each packet sent to the phone has an incrementing count
@@ -85,6 +106,9 @@ class PhoneAPI
 
     /// Use to ensure that clients don't get confused about old messages from the radio
     uint32_t config_nonce = 0;
+    uint32_t syncStartGeneration = 0; // from NodeDB::beginNodeSync(), when this config download started
+    uint32_t nodesSince = 0;          // a delta sync only sends nodes changed after this generation, 0 for all of them
+    uint32_t configStartMsec = 0;     // when the client asked for its config, to log how long the download took
     uint32_t readIndex = 0;
 
     std::vector<meshtastic_FileInfo> filesManifest = {};
@@ -97,6 +121,12 @@ class PhoneAPI
     /// Destructor - calls close()
     virtual ~PhoneAPI();
 
+#if PSRAM_PLACEMENT
+    /// With their scratch and stream buffers phone APIs are a few KB each and only used from task context, keep them in PSRAM
+    static void *operator new(size_t size);
+    static void operator delete(void *p) { free(p); }
+#endif
+
     // Call this when the client drops the connection, resets the state to STATE_SEND_NOTHING
     // Unregisters our observer.  A closed connection **can** be reopened by calling init again.
     virtual void close();
@@ -120,6 +150,17 @@ class PhoneAPI
      */
     size_t getFromRadio(uint8_t *buf);
 
+    /**
+     * Like getFromRadio(), but packs as many FromRadio packets as will fit into buf, so transports can send them in one write.
+     *
+     * Each packet is preceded by headerLen bytes, which frameHeader(header, packetLen) fills in if it is not NULL.  We stop when
+     * less than a worst case packet (plus header) is left, so bufLen must be at least headerLen + meshtastic_FromRadio_size.
+     * A batch never mixes the end of the config download with the packets that follow it.
+     * Returns the number of bytes used in buf (or 0 if no packet available)
+     */
+    size_t getFromRadioBatch(uint8_t *buf, size_t bufLen, size_t headerLen = 0,
+                             void (*frameHeader)(uint8_t *header, size_t len) = NULL);
+
     void sendConfigComplete();
 
     /**
@@ -129,10 +170,25 @@ class PhoneAPI
 
     bool isConnected() { return state != STATE_SEND_NOTHING; }
 
+    /// @return true once the client has its config and we are just sending it packets
+    bool isSendingPackets() { return state == STATE_SEND_PACKETS; }
+
   protected:
     /// Our fromradio packet while it is being assembled
     meshtastic_FromRadio fromRadioScratch = {};
 
+    /// Move on to the next config, or the module configs after the last one
+    void nextConfig();
+
+    /// Move on to the next module config, or what follows them after the last one
+    void nextModuleConfig();
+
+#if PHONEAPI_DIRECT_ENCODE
+    /// getFromRadio() for the states that can be encoded without fromRadioScratch
+    /// @return 0 if this one has to go through fromRadioScratch
+    size_t getFromRadioDirect(uint8_t *buf);
+#endif
+
     /** the last msec we heard from the client on the other side of this link */
     uint32_t lastContactMsec = 0;
 
@@ -162,8 +218,11 @@ class PhoneAPI
 
     void releaseClientNotification();
 
+    /// @return true if we already accepted a ToRadio MeshPacket with this id, among the last PHONEAPI_RECENT_IDS
     bool wasSeenRecently(uint32_t packetId);
 
+    void rememberToRadioId(uint32_t packetId);
+
     /**
      * Handle a packet that the phone wants us to send.  We can write to it but can not keep a reference to it
      * @return true true if a packet was queued for sending
@@ -0,0 +1,127 @@
+#include "PhoneQueue.h"
+#include "configuration.h"
+#include "concurrency/LockGuard.h"
+
+PhoneQueue::PhoneQueue(size_t maxLen) : slots(maxLen, NULL) {}
+
+void PhoneQueue::removeAt(size_t i)
+{
+    for (; i + 1 < count; i++)
+        at(i) = at(i + 1);
+    at(count - 1) = NULL;
+    count--;
+}
+
+bool PhoneQueue::isImportant(const meshtastic_MeshPacket *p)
+{
+    if (p->which_payload_variant != meshtastic_MeshPacket_decoded_tag)
+        return false;
+    switch (p->decoded.portnum) {
+    case meshtastic_PortNum_TEXT_MESSAGE_APP:
+    case meshtastic_PortNum_TEXT_MESSAGE_COMPRESSED_APP:
+    case meshtastic_PortNum_RANGE_TEST_APP:
+    case meshtastic_PortNum_ADMIN_APP:
+    case meshtastic_PortNum_ROUTING_APP:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/// The Telemetry variant field of a payload, skipping the time field in front of it, or 0 if we can't tell
+static uint8_t telemetryVariant(const meshtastic_Data_payload_t &payload)
+{
+    size_t at = 0;
+    if (at < payload.size && payload.bytes[at] == ((meshtastic_Telemetry_time_tag << 3) | 5)) // fixed32
+        at += 5;
+    // The variant tags are all below 16, so their key is a single byte
+    return at < payload.size ? payload.bytes[at] >> 3 : 0;
+}
+
+bool PhoneQueue::supersedes(const meshtastic_MeshPacket *newer, const meshtastic_MeshPacket *older)
+{
+    if (newer->which_payload_variant != meshtastic_MeshPacket_decoded_tag ||
+        older->which_payload_variant != meshtastic_MeshPacket_decoded_tag || newer->from != older->from ||
+        newer->decoded.portnum != older->decoded.portnum)
+        return false;
+    // A reply to something the phone asked for is never redundant
+    if (newer->decoded.request_id || older->decoded.request_id || !isBroadcast(newer->to) || !isBroadcast(older->to))
+        return false;
+    switch (newer->decoded.portnum) {
+    case meshtastic_PortNum_POSITION_APP:
+    case meshtastic_PortNum_NODEINFO_APP:
+        return true;
+    case meshtastic_PortNum_TELEMETRY_APP: {
+        uint8_t variant = telemetryVariant(newer->decoded.payload);
+        return variant && variant == telemetryVariant(older->decoded.payload);
+    }
+    default:
+        return false;
+    }
+}
+
+void PhoneQueue::enqueue(meshtastic_MeshPacket *p)
+{
+    concurrency::LockGuard guard(&lock);
+
+#if PHONE_QUEUE_COALESCE
+    for (size_t i = 0; i < count; i++) {
+        if (supersedes(p, at(i))) {
+            packetPool.release(at(i));
+            at(i) = p;
+            coalesced++;
+            return;
+        }
+    }
+#endif
+
+    if (count == slots.size()) {
+        size_t victim = count;
+        for (size_t i = 0; i < count && victim == count; i++) {
+            if (!isImportant(at(i)))
+                victim = i;
+        }
+        if (victim == count && isImportant(p))
+            victim = 0;
+        dropped++;
+        if (victim == count) {
+            LOG_WARN("ToPhone queue is full, drop packet");
+            packetPool.release(p);
+            return;
+        }
+        LOG_WARN("ToPhone queue is full, discard an older packet");
+        packetPool.release(at(victim));
+        removeAt(victim);
+    }
+
+    at(count++) = p;
+}
+
+meshtastic_MeshPacket *PhoneQueue::dequeue()
+{
+    concurrency::LockGuard guard(&lock);
+    if (count == 0)
+        return NULL;
+    meshtastic_MeshPacket *p = at(0);
+    at(0) = NULL;
+    head = (head + 1) % slots.size();
+    count--;
+    return p;
+}
+
+bool PhoneQueue::isEmpty()
+{
+    concurrency::LockGuard guard(&lock);
+    return count == 0;
+}
+
+NodeNum PhoneQueue::findTo(PacketId id)
+{
+    concurrency::LockGuard guard(&lock);
+    NodeNum to = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (at(i)->id == id)
+            to = at(i)->to; // the newest one, like the loop this replaced
+    }
+    return to;
+}
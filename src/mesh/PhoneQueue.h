@@ -0,0 +1,55 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include "concurrency/Lock.h"
+
+#include <vector>
+
+/// Set to 1 to replace a queued position, telemetry or NodeInfo broadcast with a newer one from the same node
+#ifndef PHONE_QUEUE_COALESCE
+#define PHONE_QUEUE_COALESCE 0
+#endif
+
+/**
+ * The packets waiting for the phone, in the order they arrived.
+ *
+ * When it is full we drop the oldest packet that isn't a text, admin or routing packet, so with no phone connected the queue
+ * fills up with messages rather than with telemetry.  If there is no such packet an incoming text still replaces the oldest
+ * packet, anything else is dropped.  With PHONE_QUEUE_COALESCE a position, telemetry or NodeInfo broadcast takes the place of
+ * an older one of the same kind from the same node, which the phone would only overwrite anyway.
+ *
+ * Filled from the main thread, emptied from whatever thread the phone connection runs in, so everything is under a lock.
+ */
+class PhoneQueue
+{
+  public:
+    explicit PhoneQueue(size_t maxLen);
+
+    /// Takes ownership of p, which is released right away if there's no room for it
+    void enqueue(meshtastic_MeshPacket *p);
+
+    /// @return the oldest packet, or NULL if there are none
+    meshtastic_MeshPacket *dequeue();
+
+    bool isEmpty();
+
+    /// @return the destination of the queued packet with this id, 0 if there is none
+    NodeNum findTo(PacketId id);
+
+    uint32_t dropped = 0;   // packets we had no room for, either the newest or an older one we made room for it
+    uint32_t coalesced = 0; // packets replaced by a newer one of the same kind
+
+  private:
+    std::vector<meshtastic_MeshPacket *> slots; // ring of maxLen, the oldest at head
+    size_t head = 0, count = 0;
+    concurrency::Lock lock;
+
+    meshtastic_MeshPacket *&at(size_t i) { return slots[(head + i) % slots.size()]; }
+    void removeAt(size_t i);
+
+    /// Text, admin and routing (delivery reports) are what we keep when space runs out
+    static bool isImportant(const meshtastic_MeshPacket *p);
+
+    /// Whether newer makes older redundant
+    static bool supersedes(const meshtastic_MeshPacket *newer, const meshtastic_MeshPacket *older);
+};
@@ -1,4 +1,5 @@
 #pragma once
+#include "PayloadCompression.h"
 #include "SinglePortModule.h"
 
 /**
@@ -12,6 +13,20 @@ template <class T> class ProtobufModule : protected SinglePortModule
 {
     const pb_msgdesc_t *fields;
 
+    /**
+     * One decode buffer per message type, instead of one on the stack for every packet: admin messages, neighbor info and route
+     * discoveries are big enough to decide how large task stacks must be.  Modules are called one at a time, so this is safe; only
+     * a broadcast sent while handling a packet comes back in (Router::sendLocal), that one is decoded on the heap.
+     *
+     * The arena remembers which packet it holds, so the modules sharing a type (the telemetry ones) decode a packet just once.
+     * The payload hash is part of that, so a payload changed by alterReceivedProtobuf is decoded again.
+     */
+    static T arena;
+    static bool arenaBusy;
+    static NodeNum arenaFrom;
+    static PacketId arenaId; // 0 if the arena holds nothing reusable
+    static uint32_t arenaHash;
+
   public:
     uint8_t numOnlineNodes = 0;
     /** Constructor
@@ -71,6 +86,69 @@ template <class T> class ProtobufModule : protected SinglePortModule
     }
 
   private:
+    /// Decode the payload of mp into scratch, decompressing it first if it's compressed
+    /// (only when we sniff a packet for someone else, Router decompresses the ones for us)
+    bool decodePayload(const meshtastic_MeshPacket &mp, T *scratch)
+    {
+        const meshtastic_Data &p = mp.decoded;
+#if PAYLOAD_COMPRESSION
+        if (p.has_bitfield && (p.bitfield & BITFIELD_PAYLOAD_COMPRESSED_MASK)) {
+            uint8_t plain[meshtastic_Constants_DATA_PAYLOAD_LEN];
+            int len = PayloadCompression::decompress(p.payload.bytes, p.payload.size, plain, sizeof(plain));
+            return len >= 0 && pb_decode_from_bytes(plain, len, fields, scratch);
+        }
+#endif
+        return pb_decode_from_bytes(p.payload.bytes, p.payload.size, fields, scratch);
+    }
+
+    /// The decoded payload of mp, from the arena if it is free, NULL if it doesn't decode. Hand it back with releaseDecoded
+    T *acquireDecoded(const meshtastic_MeshPacket &mp)
+    {
+        if (arenaBusy) {
+            T *decoded = new T();
+            if (!decodePayload(mp, decoded)) {
+                delete decoded;
+                return NULL;
+            }
+            return decoded;
+        }
+
+        arenaBusy = true;
+        uint32_t hash = payloadHash(mp.decoded.payload);
+        if (arenaId != 0 && arenaId == mp.id && arenaFrom == mp.from && arenaHash == hash)
+            return &arena;
+
+        memset(&arena, 0, sizeof(arena));
+        arenaId = 0;
+        if (!decodePayload(mp, &arena)) {
+            arenaBusy = false;
+            return NULL;
+        }
+        arenaId = mp.id;
+        arenaFrom = mp.from;
+        arenaHash = hash;
+        return &arena;
+    }
+
+    void releaseDecoded(T *decoded)
+    {
+        if (decoded == &arena)
+            arenaBusy = false;
+        else
+            delete decoded;
+    }
+
+    /// FNV-1a, far cheaper than decoding again
+    static uint32_t payloadHash(const meshtastic_Data_payload_t &payload)
+    {
+        uint32_t h = 2166136261u;
+        for (pb_size_t i = 0; i < payload.size; i++) {
+            h ^= payload.bytes[i];
+            h *= 16777619u;
+        }
+        return h;
+    }
+
     /** Called to handle a particular incoming message
 
     @return ProcessMessage::STOP if you've guaranteed you've handled this message and no other handlers should be considered for
@@ -84,40 +162,55 @@ template <class T> class ProtobufModule : protected SinglePortModule
         auto &p = mp.decoded;
         LOG_INFO("Received %s from=0x%0x, id=0x%x, portnum=%d, payloadlen=%d", name, mp.from, mp.id, p.portnum, p.payload.size);
 
-        T scratch;
         T *decoded = NULL;
         if (mp.which_payload_variant == meshtastic_MeshPacket_decoded_tag && mp.decoded.portnum == ourPortNum) {
-            memset(&scratch, 0, sizeof(scratch));
-            if (pb_decode_from_bytes(p.payload.bytes, p.payload.size, fields, &scratch)) {
-                decoded = &scratch;
-            } else {
+            decoded = acquireDecoded(mp);
+            if (!decoded) {
                 LOG_ERROR("Error decoding proto module!");
                 // if we can't decode it, nobody can process it!
                 return ProcessMessage::STOP;
             }
         }
 
-        return handleReceivedProtobuf(mp, decoded) ? ProcessMessage::STOP : ProcessMessage::CONTINUE;
+        bool handled = handleReceivedProtobuf(mp, decoded);
+        if (decoded)
+            releaseDecoded(decoded);
+        return handled ? ProcessMessage::STOP : ProcessMessage::CONTINUE;
     }
 
     /** Called to alter a particular incoming message
      */
     virtual void alterReceived(meshtastic_MeshPacket &mp) override
     {
-        T scratch;
         T *decoded = NULL;
         if (mp.which_payload_variant == meshtastic_MeshPacket_decoded_tag && mp.decoded.portnum == ourPortNum) {
-            memset(&scratch, 0, sizeof(scratch));
-            const meshtastic_Data &p = mp.decoded;
-            if (pb_decode_from_bytes(p.payload.bytes, p.payload.size, fields, &scratch)) {
-                decoded = &scratch;
-            } else {
+            decoded = acquireDecoded(mp);
+            if (!decoded) {
                 LOG_ERROR("Error decoding proto module!");
                 // if we can't decode it, nobody can process it!
                 return;
             }
 
-            return alterReceivedProtobuf(mp, decoded);
+#if PAYLOAD_COMPRESSION
+            if (mp.decoded.has_bitfield && (mp.decoded.bitfield & BITFIELD_PAYLOAD_COMPRESSED_MASK)) {
+                meshtastic_Data_payload_t compressed = mp.decoded.payload;
+                alterReceivedProtobuf(mp, decoded);
+                // A module that changed the payload encoded it again, uncompressed
+                if (mp.decoded.payload.size != compressed.size ||
+                    memcmp(mp.decoded.payload.bytes, compressed.bytes, compressed.size) != 0)
+                    mp.decoded.bitfield &= ~BITFIELD_PAYLOAD_COMPRESSED_MASK;
+                releaseDecoded(decoded);
+                return;
+            }
+#endif
+            alterReceivedProtobuf(mp, decoded);
+            releaseDecoded(decoded);
         }
     }
-};
\ No newline at end of file
+};
+
+template <class T> T ProtobufModule<T>::arena;
+template <class T> bool ProtobufModule<T>::arenaBusy = false;
+template <class T> NodeNum ProtobufModule<T>::arenaFrom = 0;
+template <class T> PacketId ProtobufModule<T>::arenaId = 0;
+template <class T> uint32_t ProtobufModule<T>::arenaHash = 0;
\ No newline at end of file
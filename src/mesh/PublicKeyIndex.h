@@ -0,0 +1,108 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * A compact open-addressing hash table from a node's public key to its NodeNum, so "does another node already have this key"
+ * doesn't have to compare against every node's key.
+ *
+ * Only a 32 bit tag of each key is stored (its first bytes, keys are uniformly random), so a hit is just a candidate: find()
+ * has the caller check the node's real key.  Entries are never removed, when a node is dropped or its key cleared the check
+ * simply fails.  Once the table fills up with such stale entries insert() fails and the owner rebuilds it from the nodes.
+ */
+class PublicKeyIndex
+{
+  public:
+    PublicKeyIndex() {}
+    ~PublicKeyIndex() { release(); }
+
+    /// Size the table for up to maxEntries keys, discarding any current contents
+    bool init(size_t maxEntries)
+    {
+        release();
+        size_t cap = 8;
+        while (cap < maxEntries * 2)
+            cap <<= 1;
+
+        tags = (uint32_t *)calloc(cap, sizeof(uint32_t));
+        nums = (NodeNum *)calloc(cap, sizeof(NodeNum));
+        if (!tags || !nums) {
+            release();
+            return false;
+        }
+        mask = cap - 1;
+        return true;
+    }
+
+    bool isAllocated() const { return nums != NULL; }
+
+    void clear()
+    {
+        if (nums)
+            memset(nums, 0, (mask + 1) * sizeof(NodeNum));
+        used = 0;
+    }
+
+    /// Remember that n has key, a 32 byte public key
+    /// @return false if the table is full of stale entries and should be rebuilt
+    bool insert(const uint8_t *key, NodeNum n)
+    {
+        if (!nums || n == 0)
+            return false;
+        uint32_t t = tag(key);
+        size_t i = t & mask;
+        for (; nums[i] != 0; i = (i + 1) & mask)
+            if (nums[i] == n && tags[i] == t)
+                return true;
+        if (used + 1 > (mask + 1) * 3 / 4)
+            return false;
+        tags[i] = t;
+        nums[i] = n;
+        used++;
+        return true;
+    }
+
+    /**
+     * The first node that may have key and that isMatch(NodeNum) confirms does
+     * @return 0 if there is none
+     */
+    template <typename Match> NodeNum find(const uint8_t *key, Match isMatch) const
+    {
+        if (!nums)
+            return 0;
+        uint32_t t = tag(key);
+        for (size_t i = t & mask; nums[i] != 0; i = (i + 1) & mask)
+            if (tags[i] == t && isMatch(nums[i]))
+                return nums[i];
+        return 0;
+    }
+
+  private:
+    uint32_t *tags = NULL;
+    NodeNum *nums = NULL; // 0 marks an empty slot
+    size_t mask = 0;
+    size_t used = 0;
+
+    static uint32_t tag(const uint8_t *key)
+    {
+        uint32_t t;
+        memcpy(&t, key, sizeof(t));
+        return t;
+    }
+
+    void release()
+    {
+        free(tags);
+        free(nums);
+        tags = NULL;
+        nums = NULL;
+        mask = 0;
+        used = 0;
+    }
+
+    PublicKeyIndex(const PublicKeyIndex &);            // non construction-copyable
+    PublicKeyIndex &operator=(const PublicKeyIndex &); // non copyable
+};
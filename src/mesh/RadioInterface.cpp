@@ -4,10 +4,12 @@
 #include "MeshRadio.h"
 #include "MeshService.h"
 #include "NodeDB.h"
+#include "RadioTask.h"
 #include "Router.h"
 #include "configuration.h"
 #include "main.h"
 #include "sleep.h"
+#include <Throttle.h>
 #include <assert.h>
 #include <pb_decode.h>
 #include <pb_encode.h>
@@ -212,6 +214,30 @@ separated by 2.16 MHz with respect to the adjacent channels. Channel zero starts
  * @return num msecs for the packet
  */
 uint32_t RadioInterface::getPacketTime(uint32_t pl)
+{
+    // Some radios change the preamble length after applyModemConfig()
+    if (airtimePreambleLength != preambleLength)
+        buildAirtimeTable();
+    if (pl > MAX_LORA_PAYLOAD_LEN)
+        return computePacketTime(pl);
+    return airtimeMsec[pl];
+}
+
+void RadioInterface::buildAirtimeTable()
+{
+    for (uint32_t pl = 0; pl <= MAX_LORA_PAYLOAD_LEN; pl++)
+        airtimeMsec[pl] = computePacketTime(pl);
+    airtimePreambleLength = preambleLength;
+    preambleTimeMsec = airtimeMsec[0];
+    maxPacketTimeMsec = airtimeMsec[meshtastic_Constants_DATA_PAYLOAD_LEN + sizeof(PacketHeader)];
+}
+
+uint32_t RadioInterface::computePacketTime(uint32_t pl)
+{
+    return loraPacketTime(sf, bw, cr, preambleLength, pl);
+}
+
+uint32_t RadioInterface::loraPacketTime(uint8_t sf, float bw, uint8_t cr, uint16_t preambleLength, uint32_t pl)
 {
     float bandwidthHz = bw * 1000.0f;
     bool headDisable = false; // we currently always use the header
@@ -242,6 +268,16 @@ uint32_t RadioInterface::getPacketTime(const meshtastic_MeshPacket *p)
     return getPacketTime(pl);
 }
 
+/// The channel utilization CSMA sizes its contention window by
+static float csmaChannelUtilPercent(AirTime *airtime)
+{
+#if AIRTIME_SERIES
+    return airtime->recentUtilizationPercent(); // a burst of traffic widens the window at once
+#else
+    return airtime->channelUtilizationPercent();
+#endif
+}
+
 /** The delay to use for retransmitting dropped packets */
 uint32_t RadioInterface::getRetransmissionMsec(const meshtastic_MeshPacket *p)
 {
@@ -249,7 +285,7 @@ uint32_t RadioInterface::getRetransmissionMsec(const meshtastic_MeshPacket *p)
     uint32_t packetAirtime = getPacketTime(numbytes + sizeof(PacketHeader));
     // Make sure enough time has elapsed for this packet to be sent and an ACK is received.
     // LOG_DEBUG("Waiting for flooding message with airtime %d and slotTime is %d", packetAirtime, slotTimeMsec);
-    float channelUtil = airTime->channelUtilizationPercent();
+    float channelUtil = csmaChannelUtilPercent(getAirTime());
     uint8_t CWsize = map(channelUtil, 0, 100, CWmin, CWmax);
     // Assuming we pick max. of CWsize and there will be a client with SNR at half the range
     return 2 * packetAirtime + (pow_of_2(CWsize) + 2 * CWmax + pow_of_2(int((CWmax + CWmin) / 2))) * slotTimeMsec +
@@ -262,7 +298,8 @@ uint32_t RadioInterface::getTxDelayMsec()
     /** We wait a random multiple of 'slotTimes' (see definition in header file) in order to avoid collisions.
     The pool to take a random multiple from is the contention window (CW), which size depends on the
     current channel utilization. */
-    float channelUtil = airTime->channelUtilizationPercent();
+    adaptContentionWindow();
+    float channelUtil = csmaChannelUtilPercent(getAirTime());
     uint8_t CWsize = map(channelUtil, 0, 100, CWmin, CWmax);
     // LOG_DEBUG("Current channel utilization is %f so setting CWsize to %d", channelUtil, CWsize);
     return random(0, pow_of_2(CWsize)) * slotTimeMsec;
@@ -270,6 +307,12 @@ uint32_t RadioInterface::getTxDelayMsec()
 
 /** The CW size to use when calculating SNR_based delays */
 uint8_t RadioInterface::getCWsize(float snr)
+{
+    adaptContentionWindow();
+    return cwSizeForSnr(snr, CWmin, CWmax);
+}
+
+uint8_t RadioInterface::cwSizeForSnr(float snr, uint8_t cwMin, uint8_t cwMax)
 {
     // The minimum value for a LoRa SNR
     const uint32_t SNR_MIN = -20;
@@ -277,7 +320,55 @@ uint8_t RadioInterface::getCWsize(float snr)
     // The maximum value for a LoRa SNR
     const uint32_t SNR_MAX = 10;
 
-    return map(snr, SNR_MIN, SNR_MAX, CWmin, CWmax);
+    return map(snr, SNR_MIN, SNR_MAX, cwMin, cwMax);
+}
+
+void RadioInterface::adaptContentionWindow()
+{
+#if ADAPTIVE_CONTENTION_WINDOW
+    if (Throttle::isWithinTimespanMs(lastCWAdapt, 60 * 1000))
+        return;
+    lastCWAdapt = millis();
+    if (!router)
+        return;
+
+    // Each packet we hear again means another neighbor relayed it, so extra copies per packet is roughly how many others
+    // are contending with us for each relay
+    uint32_t heard = router->rxHeard - lastRxHeard, dupes = router->rxDupe - lastRxDupe;
+    lastRxHeard = router->rxHeard;
+    lastRxDupe = router->rxDupe;
+    float copies = heard > dupes ? (float)dupes / (heard - dupes) : 0;
+    float channelUtil = getAirTime()->channelUtilizationPercent();
+
+#if AIRTIME_SERIES
+    // Most of the last minute's channel checks finding it busy is contention too, even if we heard little airtime
+    uint32_t scans = 0, busy = 0;
+    for (uint8_t age = 1; age <= 6; age++) {
+        const AirtimeBucket &b = getAirTime()->getSeriesBucket(AirTime::SERIES_10S, age);
+        scans += b.cadScans;
+        busy += b.cadBusy;
+    }
+    bool cadCrowded = scans >= 5 && busy * 2 > scans;
+#else
+    bool cadCrowded = false;
+#endif
+
+    // Neighbors see about the same load, so they tend to move together and routers still go before clients
+    int shift = 0;
+    if (channelUtil > 40 || (heard >= 10 && copies > 4))
+        shift = 2;
+    else if (channelUtil > 25 || cadCrowded || (heard >= 10 && copies > 2))
+        shift = 1;
+    else if (channelUtil < 10 && copies < 1)
+        shift = -1;
+
+    if (CWmin != 3 + shift) {
+        LOG_INFO("Contention window %d..%d, channel utilization %.1f%%, %.1f copies of each packet heard", 3 + shift, 8 + shift,
+                 channelUtil, copies);
+        CWmin = 3 + shift;
+        CWmax = 8 + shift;
+    }
+#endif
 }
 
 /** The worst-case SNR_based packet delay */
@@ -394,12 +485,36 @@ bool RadioInterface::init()
     return true;
 }
 
+void RadioInterface::setLoraOverride(const LoraOverride &o)
+{
+    loraOverride = o;
+    overridden = true;
+    if (!ownAirTime)
+        ownAirTime = new AirTime();
+}
+
+// The observer callbacks below run on the main loop
+
+int RadioInterface::preflightSleepCb(void *unused)
+{
+    RadioLockGuard guard;
+    return canSleep() ? 0 : 1;
+}
+
 int RadioInterface::notifyDeepSleepCb(void *unused)
 {
+    RadioLockGuard guard;
     sleep();
     return 0;
 }
 
+int RadioInterface::reloadConfig(void *unused)
+{
+    RadioLockGuard guard;
+    reconfigure();
+    return 0;
+}
+
 /** hash a string into an integer
  *
  * djb2 by Dan Bernstein.
@@ -455,7 +570,18 @@ void RadioInterface::applyModemConfig()
 {
     // Set up default configuration
     // No Sync Words in LORA mode
-    meshtastic_Config_LoRaConfig &loraConfig = config.lora;
+    meshtastic_Config_LoRaConfig &loraConfig = overridden ? overriddenLoraConfig : config.lora;
+    if (overridden) {
+        overriddenLoraConfig = config.lora;
+        if (loraOverride.channelNum)
+            overriddenLoraConfig.channel_num = loraOverride.channelNum;
+        if (loraOverride.modemPreset >= 0) {
+            overriddenLoraConfig.use_preset = true;
+            overriddenLoraConfig.modem_preset = (meshtastic_Config_LoRaConfig_ModemPreset)loraOverride.modemPreset;
+        }
+        if (loraOverride.frequency)
+            overriddenLoraConfig.override_frequency = loraOverride.frequency;
+    }
     bool validConfig = false; // We need to check for a valid configuration
     while (!validConfig) {
         if (loraConfig.use_preset) {
@@ -560,9 +686,10 @@ void RadioInterface::applyModemConfig()
     // channel_num is actually (channel_num - 1), since modulus (%) returns values from 0 to (numChannels - 1)
     uint32_t channel_num = (loraConfig.channel_num ? loraConfig.channel_num - 1 : hash(channelName)) % numChannels;
 
-    // Check if we use the default frequency slot
-    RadioInterface::uses_default_frequency_slot =
-        channel_num == hash(DisplayFormatters::getModemPresetDisplayName(config.lora.modem_preset, false)) % numChannels;
+    // Check if we use the default frequency slot, that is about config.lora so extra radios leave it alone
+    if (!overridden)
+        RadioInterface::uses_default_frequency_slot =
+            channel_num == hash(DisplayFormatters::getModemPresetDisplayName(config.lora.modem_preset, false)) % numChannels;
 
     // Old frequency selection formula
     // float freq = myRegion->freqStart + ((((myRegion->freqEnd - myRegion->freqStart) / numChannels) / 2) * channel_num);
@@ -580,8 +707,15 @@ void RadioInterface::applyModemConfig()
     saveFreq(freq + loraConfig.frequency_offset);
 
     slotTimeMsec = computeSlotTimeMsec();
-    preambleTimeMsec = getPacketTime((uint32_t)0);
-    maxPacketTimeMsec = getPacketTime(meshtastic_Constants_DATA_PAYLOAD_LEN + sizeof(PacketHeader));
+    buildAirtimeTable(); // also sets preambleTimeMsec and maxPacketTimeMsec
+
+#if RX_DUTY_CYCLE
+    // A sender's preamble is preambleLength symbols, so waking for less than half of it between sleeps still overlaps every
+    // preamble.  The shorter the radio listens, the more weak or late packets it misses, so only nodes that asked to save
+    // power take that trade.
+    bool savePower = config.device.role == meshtastic_Config_DeviceConfig_Role_CLIENT_MUTE || config.power.is_power_saving;
+    rxDutyCycleMinSymbols = savePower ? max(preambleLength / 4, 2) : 8;
+#endif
 
     LOG_INFO("Radio freq=%.3f, config.lora.frequency_offset=%.3f", freq, loraConfig.frequency_offset);
     LOG_INFO("Set radio: region=%s, name=%s, config=%u, ch=%d, power=%d", myRegion->name, channelName, loraConfig.modem_preset,
@@ -592,6 +726,7 @@ void RadioInterface::applyModemConfig()
     LOG_INFO("channel_num: %d", channel_num + 1);
     LOG_INFO("frequency: %f", getFreq());
     LOG_INFO("Slot time: %u msec", slotTimeMsec);
+    LOG_INFO("RX duty cycle: listening %.0f%% of the time", getRxDutyCycle() * 100);
 }
 
 /** Slottime is the time to detect a transmission has started, consisting of:
@@ -600,11 +735,16 @@ void RadioInterface::applyModemConfig()
   - Tx/Rx turnaround time (maximum of SX126x and SX127x);
   - MAC processing time (measured on T-beam) */
 uint32_t RadioInterface::computeSlotTimeMsec()
+{
+    return loraSlotTimeMsec(sf, bw, myRegion->wideLora);
+}
+
+uint32_t RadioInterface::loraSlotTimeMsec(uint8_t sf, float bw, bool wideLora)
 {
     float sumPropagationTurnaroundMACTime = 0.2 + 0.4 + 7; // in milliseconds
     float symbolTime = pow_of_2(sf) / bw;                  // in milliseconds
 
-    if (myRegion->wideLora) {
+    if (wideLora) {
         // CAD duration derived from AN1200.22 of SX1280
         return (NUM_SYM_CAD_24GHZ + (2 * sf + 3) / 32) * symbolTime + sumPropagationTurnaroundMACTime;
     } else {
@@ -650,6 +790,51 @@ void RadioInterface::deliverToReceiver(meshtastic_MeshPacket *p)
         router->enqueueReceivedMessage(p);
 }
 
+void RadioInterface::packHeader(const meshtastic_MeshPacket *p, PacketHeader &h)
+{
+    h.from = p->from;
+    h.to = p->to;
+    h.id = p->id;
+    h.channel = p->channel;
+    h.next_hop = p->next_hop;
+    h.relay_node = p->relay_node;
+    h.flags = p->hop_limit | (p->want_ack ? PACKET_FLAGS_WANT_ACK_MASK : 0) | (p->via_mqtt ? PACKET_FLAGS_VIA_MQTT_MASK : 0);
+    h.flags |= (p->hop_start << PACKET_FLAGS_HOP_START_SHIFT) & PACKET_FLAGS_HOP_START_MASK;
+}
+
+void RadioInterface::unpackHeader(const PacketHeader &h, meshtastic_MeshPacket *mp)
+{
+    // Keep the assigned fields in sync with src/mqtt/MQTT.cpp:onReceiveProto
+    mp->from = h.from;
+    mp->to = h.to;
+    mp->id = h.id;
+    mp->channel = h.channel;
+    assert(HOP_MAX <= PACKET_FLAGS_HOP_LIMIT_MASK); // If hopmax changes, carefully check this code
+    mp->hop_limit = h.flags & PACKET_FLAGS_HOP_LIMIT_MASK;
+    mp->hop_start = (h.flags & PACKET_FLAGS_HOP_START_MASK) >> PACKET_FLAGS_HOP_START_SHIFT;
+    mp->want_ack = !!(h.flags & PACKET_FLAGS_WANT_ACK_MASK);
+    mp->via_mqtt = !!(h.flags & PACKET_FLAGS_VIA_MQTT_MASK);
+    // If hop_start is not set, next_hop and relay_node are invalid (firmware <2.3)
+    mp->next_hop = mp->hop_start == 0 ? NO_NEXT_HOP_PREFERENCE : h.next_hop;
+    mp->relay_node = mp->hop_start == 0 ? NO_RELAY_NODE : h.relay_node;
+}
+
+RadioInterface::HeaderReject RadioInterface::checkHeader(const PacketHeader &h, size_t payloadLen)
+{
+    if (h.from == 0 || h.to == 0 || h.from == NODENUM_BROADCAST)
+        return HEADER_BAD_ADDRESS;
+
+    // hop_start is 0 from firmware <2.3, otherwise a relay only ever lowers hop_limit from it
+    uint8_t hopLimit = h.flags & PACKET_FLAGS_HOP_LIMIT_MASK;
+    uint8_t hopStart = (h.flags & PACKET_FLAGS_HOP_START_MASK) >> PACKET_FLAGS_HOP_START_SHIFT;
+    if (hopStart != 0 && hopLimit > hopStart)
+        return HEADER_BAD_HOPS;
+
+    if (payloadLen < MIN_ENCODED_DATA_LEN)
+        return HEADER_TOO_SHORT;
+    return HEADER_OK;
+}
+
 /***
  * given a packet set sendingPacket and decode the protobufs into radiobuf.  Returns # of payload bytes to send
  */
@@ -660,19 +845,11 @@ size_t RadioInterface::beginSending(meshtastic_MeshPacket *p)
     // LOG_DEBUG("Send queued packet on mesh (txGood=%d,rxGood=%d,rxBad=%d)", rf95.txGood(), rf95.rxGood(), rf95.rxBad());
     assert(p->which_payload_variant == meshtastic_MeshPacket_encrypted_tag); // It should have already been encoded by now
 
-    radioBuffer.header.from = p->from;
-    radioBuffer.header.to = p->to;
-    radioBuffer.header.id = p->id;
-    radioBuffer.header.channel = p->channel;
-    radioBuffer.header.next_hop = p->next_hop;
-    radioBuffer.header.relay_node = p->relay_node;
     if (p->hop_limit > HOP_MAX) {
         LOG_WARN("hop limit %d is too high, setting to %d", p->hop_limit, HOP_RELIABLE);
         p->hop_limit = HOP_RELIABLE;
     }
-    radioBuffer.header.flags =
-        p->hop_limit | (p->want_ack ? PACKET_FLAGS_WANT_ACK_MASK : 0) | (p->via_mqtt ? PACKET_FLAGS_VIA_MQTT_MASK : 0);
-    radioBuffer.header.flags |= (p->hop_start << PACKET_FLAGS_HOP_START_SHIFT) & PACKET_FLAGS_HOP_START_MASK;
+    packHeader(p, radioBuffer.header);
 
     // if the sender nodenum is zero, that means uninitialized
     assert(radioBuffer.header.from);
@@ -1,13 +1,48 @@
 #pragma once
 
 #include "MemoryPool.h"
+#include "MeshPacketQueue.h"
 #include "MeshTypes.h"
 #include "Observer.h"
 #include "PointerQueue.h"
 #include "airtime.h"
 #include "error.h"
 
+#ifndef MAX_TX_QUEUE
 #define MAX_TX_QUEUE 16 // max number of packets which can be waiting for transmission
+#endif
+
+/// How many LoRa radios one node can drive (see Router::addInterface), meshtasticd can be given a second one in config.yaml
+#ifndef MAX_RADIO_INTERFACES
+#ifdef ARCH_PORTDUINO
+#define MAX_RADIO_INTERFACES 2
+#else
+#define MAX_RADIO_INTERFACES 1
+#endif
+#endif
+
+/// Set to 1 to widen the contention window on busy meshes and narrow it on quiet ones, 0 keeps it at 3..8
+#ifndef ADAPTIVE_CONTENTION_WINDOW
+#define ADAPTIVE_CONTENTION_WINDOW 0
+#endif
+
+/// Set to 1 to let CLIENT_MUTE and power saving nodes sleep between preamble checks while receiving (SX126x only)
+#ifndef RX_DUTY_CYCLE
+#define RX_DUTY_CYCLE 0
+#endif
+
+/// Set to 1 to drop received frames whose header can't be from a Meshtastic node before trying to decrypt them
+#ifndef RX_HEADER_PREFILTER
+#define RX_HEADER_PREFILTER 0
+#endif
+
+/// Set to 1 to take position fixes with the radio's own GNSS scanner (LR1110, LR1120) when there is no GPS, see RadioGnss
+#ifndef LR11X0_GNSS
+#define LR11X0_GNSS 0
+#endif
+
+/// The shortest payload a real packet has: an encoded Data holds at least its portnum, a field tag and a varint
+#define MIN_ENCODED_DATA_LEN 2
 
 #define MAX_LORA_PAYLOAD_LEN 255 // max length of 255 per Semtech's datasheets on SX12xx
 #define MESHTASTIC_HEADER_LENGTH 16
@@ -84,21 +119,30 @@ class RadioInterface
     uint8_t sf = 9;
     uint8_t cr = 5;
 
-    const uint8_t NUM_SYM_CAD = 2;       // Number of symbols used for CAD, 2 is the default since RadioLib 6.3.0 as per AN1200.48
-    const uint8_t NUM_SYM_CAD_24GHZ = 4; // Number of symbols used for CAD in 2.4 GHz, 4 is recommended in AN1200.22 of SX1280
+    // Number of symbols used for CAD, 2 is the default since RadioLib 6.3.0 as per AN1200.48
+    static const uint8_t NUM_SYM_CAD = 2;
+    // Number of symbols used for CAD in 2.4 GHz, 4 is recommended in AN1200.22 of SX1280
+    static const uint8_t NUM_SYM_CAD_24GHZ = 4;
     uint32_t slotTimeMsec = computeSlotTimeMsec();
     uint16_t preambleLength = 16;      // 8 is default, but we use longer to increase the amount of sleep time when receiving
     uint32_t preambleTimeMsec = 165;   // calculated on startup, this is the default for LongFast
     uint32_t maxPacketTimeMsec = 3246; // calculated on startup, this is the default for LongFast
+    uint32_t airtimeMsec[MAX_LORA_PAYLOAD_LEN + 1]; // time on air by packet length, for the current modem settings
+    uint16_t airtimePreambleLength = 0;             // preambleLength the table was built for, 0 if not built yet
+    uint16_t rxDutyCycleMinSymbols = 8;             // preamble symbols to listen for after waking, see applyModemConfig
     const uint32_t PROCESSING_TIME_MSEC =
         4500;                // time to construct, process and construct a packet again (empirically determined)
-    const uint8_t CWmin = 3; // minimum CWsize
-    const uint8_t CWmax = 8; // maximum CWsize
+    uint8_t CWmin = 3; // minimum CWsize, see adaptContentionWindow()
+    uint8_t CWmax = 8; // maximum CWsize
+#if ADAPTIVE_CONTENTION_WINDOW
+    uint32_t lastCWAdapt = 0;                  // millis() when adaptContentionWindow() last looked
+    uint32_t lastRxHeard = 0, lastRxDupe = 0; // router counts it last saw
+#endif
 
     meshtastic_MeshPacket *sendingPacket = NULL; // The packet we are currently sending
     uint32_t lastTxStart = 0L;
 
-    uint32_t computeSlotTimeMsec();
+    virtual uint32_t computeSlotTimeMsec();
 
     /**
      * A temporary buffer used for sending/receiving packets, sized to hold the biggest buffer we might need
@@ -125,6 +169,20 @@ class RadioInterface
 
     virtual bool wideLora() { return false; }
 
+    enum GnssScanResult { GNSS_SCAN_UNSUPPORTED, GNSS_SCAN_BUSY, GNSS_SCAN_NO_FIX, GNSS_SCAN_FIX };
+
+    /**
+     * Take a position fix with the radio's own GNSS scanner.  LoRa receive stops for the seconds the scan takes, so radios
+     * answer GNSS_SCAN_BUSY while a packet is on its way in or waiting to go out.
+     *
+     * @param assist where we were last, NULL if we don't know; a scanner told roughly where it is solves much faster
+     * @param fix gets latitude_i, longitude_i and sats_in_view on GNSS_SCAN_FIX
+     */
+    virtual GnssScanResult gnssScan(const meshtastic_Position *assist, meshtastic_Position &fix)
+    {
+        return GNSS_SCAN_UNSUPPORTED;
+    }
+
     /// Prepare hardware for sleep.  Call this _only_ for deep sleep, not needed for light sleep.
     virtual bool sleep() { return true; }
 
@@ -156,6 +214,12 @@ class RadioInterface
     /** Attempt to find a packet in the TxQueue. Returns true if the packet was found. */
     virtual bool findInTxQueue(NodeNum from, PacketId id) { return false; }
 
+#if TX_QUEUE_DEADLINES
+    /** Tell the TX queue the port of our queued packet (from, id), so it can expire or be superseded. See
+     * MeshPacketQueue::setDeadline() */
+    virtual void setTxDeadline(NodeNum from, PacketId id, meshtastic_PortNum port) {}
+#endif
+
     // methods from radiohead
 
     /// Initialise the Driver transport hardware and software.
@@ -174,6 +238,9 @@ class RadioInterface
     /** The delay to use when we want to send something */
     uint32_t getTxDelayMsec();
 
+    /** Every minute, move CWmin and CWmax with channel utilization and how often we hear packets again */
+    void adaptContentionWindow();
+
     /** The CW to use when calculating SNR_based delays */
     uint8_t getCWsize(float snr);
 
@@ -196,6 +263,21 @@ class RadioInterface
     uint32_t getPacketTime(const meshtastic_MeshPacket *p);
     uint32_t getPacketTime(uint32_t totalPacketLen);
 
+    /// LoRa time on air of pl bytes, in msecs, for any modem settings (what computePacketTime() uses for ours)
+    static uint32_t loraPacketTime(uint8_t sf, float bw, uint8_t cr, uint16_t preambleLength, uint32_t pl);
+
+    /// Slot time for any modem settings (what computeSlotTimeMsec() uses for ours), see computeSlotTimeMsec()
+    static uint32_t loraSlotTimeMsec(uint8_t sf, float bw, bool wideLora);
+
+    /// The CW size an SNR maps to between cwMin and cwMax, what getCWsize() uses
+    static uint8_t cwSizeForSnr(float snr, uint8_t cwMin, uint8_t cwMax);
+
+    /// How long the packets waiting to be sent will keep the radio busy, in msecs
+    virtual uint32_t getTxQueueDrainMsec() { return 0; }
+
+    /// Roughly what fraction of the time the receiver is on while waiting for a packet, 1 if it never sleeps in between
+    virtual float getRxDutyCycle() { return 1; }
+
     /**
      * Get the channel we saved.
      */
@@ -212,6 +294,23 @@ class RadioInterface
     // Whether we use the default frequency slot given our LoRa config (region and modem preset)
     static bool uses_default_frequency_slot;
 
+    /// What an extra radio uses instead of config.lora, so it can sit on another frequency slot or preset
+    struct LoraOverride {
+        uint32_t channelNum = 0; // 1 based like config.lora.channel_num, 0 keeps that
+        int modemPreset = -1;    // -1 keeps config.lora's preset
+        float frequency = 0;     // MHz, 0 keeps config.lora.override_frequency
+        bool bridge = true;      // false to only send our own packets here, not relay those heard on the other radios
+    };
+
+    /// Call before init().  Also gives this radio its own airtime accounting, separate from the global airTime.
+    void setLoraOverride(const LoraOverride &o);
+
+    bool hasLoraOverride() const { return overridden; }
+    const LoraOverride &getLoraOverride() const { return loraOverride; }
+
+    /// The airtime accounting this radio logs into and checks its channel use and TX budget against
+    AirTime *getAirTime() { return ownAirTime ? ownAirTime : airTime; }
+
   protected:
     int8_t power = 17; // Set by applyModemConfig()
 
@@ -226,6 +325,25 @@ class RadioInterface
      */
     size_t beginSending(meshtastic_MeshPacket *p);
 
+  public:
+    /// Fill in the on air header for an encrypted packet
+    static void packHeader(const meshtastic_MeshPacket *p, PacketHeader &h);
+
+    /// Set the packet fields an on air header carries
+    static void unpackHeader(const PacketHeader &h, meshtastic_MeshPacket *mp);
+
+    /// Why a received frame was rejected before decryption, see checkHeader()
+    enum HeaderReject { HEADER_OK, HEADER_BAD_ADDRESS, HEADER_BAD_HOPS, HEADER_TOO_SHORT, NUM_HEADER_REJECTS };
+
+    /**
+     * Cheap sanity checks of a received frame, so noise and frames from other meshes that happen to share a channel hash don't
+     * cost a trial decryption and a protobuf decode: no sender or recipient 0, no broadcast sender, no more hops left than
+     * the packet started with, and room for at least an encoded Data.
+     */
+    static HeaderReject checkHeader(const PacketHeader &h, size_t payloadLen);
+
+  protected:
+
     /**
      * Some regulatory regions limit xmit power.
      * This function should be called by subclasses after setting their desired power.  It might lower it
@@ -243,6 +361,11 @@ class RadioInterface
     virtual void saveChannelNum(uint32_t savedChannelNum);
 
   private:
+    bool overridden = false;
+    LoraOverride loraOverride;
+    meshtastic_Config_LoRaConfig overriddenLoraConfig; // config.lora with loraOverride applied, see applyModemConfig()
+    AirTime *ownAirTime = NULL;
+
     /**
      * Convert our modemConfig enum into wf, sf, etc...
      *
@@ -250,16 +373,18 @@ class RadioInterface
      */
     void applyModemConfig();
 
+    /// Fill airtimeMsec[] for the current bw, sf, cr and preambleLength
+    void buildAirtimeTable();
+
+    /// Time on air of a packet of pl bytes, the slow way
+    virtual uint32_t computePacketTime(uint32_t pl);
+
     /// Return 0 if sleep is okay
-    int preflightSleepCb(void *unused = NULL) { return canSleep() ? 0 : 1; }
+    int preflightSleepCb(void *unused = NULL);
 
     int notifyDeepSleepCb(void *unused = NULL);
 
-    int reloadConfig(void *unused)
-    {
-        reconfigure();
-        return 0;
-    }
+    int reloadConfig(void *unused);
 };
 
 /// Debug printing for packets
@@ -1,7 +1,12 @@
 #include "RadioLibInterface.h"
+#include "EventTrace.h"
 #include "MeshTypes.h"
 #include "NodeDB.h"
+#include "PacketAggregation.h"
+#include "PacketLatency.h"
 #include "PowerMon.h"
+#include "RTC.h"
+#include "RadioTask.h"
 #include "SPILock.h"
 #include "Throttle.h"
 #include "configuration.h"
@@ -15,9 +20,22 @@
 #include "PortduinoGlue.h"
 #include "meshUtils.h"
 #endif
+#if RADIO_SPI_STATS
+uint32_t LockingArduinoHal::spiCommands, LockingArduinoHal::spiMicrosTotal, LockingArduinoHal::spiMicrosMax;
+
+void LockingArduinoHal::logSpiStats()
+{
+    LOG_INFO("Radio SPI: %u commands, avg %u us, max %u us", spiCommands, spiCommands ? spiMicrosTotal / spiCommands : 0,
+             spiMicrosMax);
+}
+#endif
+
 void LockingArduinoHal::spiBeginTransaction()
 {
     spiLock->lock();
+#if RADIO_SPI_STATS
+    spiStartedMicros = micros();
+#endif
 
     ArduinoHal::spiBeginTransaction();
 }
@@ -26,6 +44,13 @@ void LockingArduinoHal::spiEndTransaction()
 {
     ArduinoHal::spiEndTransaction();
 
+#if RADIO_SPI_STATS
+    uint32_t took = micros() - spiStartedMicros;
+    spiCommands++;
+    spiMicrosTotal += took;
+    if (took > spiMicrosMax)
+        spiMicrosMax = took;
+#endif
     spiLock->unlock();
 }
 #if ARCH_PORTDUINO
@@ -37,9 +62,21 @@ void LockingArduinoHal::spiTransfer(uint8_t *out, size_t len, uint8_t *in)
 
 RadioLibInterface::RadioLibInterface(LockingArduinoHal *hal, RADIOLIB_PIN_TYPE cs, RADIOLIB_PIN_TYPE irq, RADIOLIB_PIN_TYPE rst,
                                      RADIOLIB_PIN_TYPE busy, PhysicalLayer *_iface)
-    : NotifiedWorkerThread("RadioIf"), module(hal, cs, irq, rst, busy), iface(_iface)
+    :
+#if RADIO_OWN_THREAD
+      NotifiedWorkerThread("RadioIf", &concurrency::radioController, &concurrency::radioDelay),
+#else
+      NotifiedWorkerThread("RadioIf"),
+#endif
+      module(hal, cs, irq, rst, busy), iface(_iface)
 {
-    instance = this;
+    // Radios that fail init() are deleted again, so take the first free slot rather than counting
+    while (radioIndex < MAX_RADIO_INTERFACES - 1 && instances[radioIndex])
+        radioIndex++;
+    assert(!instances[radioIndex]);
+    instances[radioIndex] = this;
+    if (radioIndex == 0)
+        instance = this;
 #if defined(ARCH_STM32WL) && defined(USE_SX1262)
     module.setCb_digitalWrite(stm32wl_emulate_digitalWrite);
     module.setCb_digitalRead(stm32wl_emulate_digitalRead);
@@ -53,12 +90,20 @@ RadioLibInterface::RadioLibInterface(LockingArduinoHal *hal, RADIOLIB_PIN_TYPE c
 #define YIELD_FROM_ISR(x) portYIELD_FROM_ISR(x)
 #endif
 
-void INTERRUPT_ATTR RadioLibInterface::isrLevel0Common(PendingISR cause)
+RadioLibInterface::~RadioLibInterface()
+{
+    instances[radioIndex] = NULL;
+    if (instance == this)
+        instance = NULL;
+}
+
+void INTERRUPT_ATTR RadioLibInterface::isrLevel0Common(RadioLibInterface *radio, PendingISR cause)
 {
-    instance->disableInterrupt();
+    radio->disableInterrupt();
+    radio->isrEvents.push({cause, (uint32_t)millis()});
 
     BaseType_t xHigherPriorityTaskWoken;
-    instance->notifyFromISR(&xHigherPriorityTaskWoken, cause, true);
+    radio->notifyFromISR(&xHigherPriorityTaskWoken, cause, true);
 
     /* Force a context switch if xHigherPriorityTaskWoken is now set to pdTRUE.
     The macro used to do this is dependent on the port and may be called
@@ -68,17 +113,47 @@ void INTERRUPT_ATTR RadioLibInterface::isrLevel0Common(PendingISR cause)
 
 void INTERRUPT_ATTR RadioLibInterface::isrRxLevel0()
 {
-    isrLevel0Common(ISR_RX);
+    isrLevel0Common(instances[0], ISR_RX);
 }
 
 void INTERRUPT_ATTR RadioLibInterface::isrTxLevel0()
 {
-    isrLevel0Common(ISR_TX);
+    isrLevel0Common(instances[0], ISR_TX);
+}
+
+#if MAX_RADIO_INTERFACES > 1
+void INTERRUPT_ATTR RadioLibInterface::isrRxLevel1()
+{
+    isrLevel0Common(instances[1], ISR_RX);
+}
+
+void INTERRUPT_ATTR RadioLibInterface::isrTxLevel1()
+{
+    isrLevel0Common(instances[1], ISR_TX);
+}
+#endif
+static_assert(MAX_RADIO_INTERFACES <= 2, "add ISR glue functions for the extra radios");
+
+void (*RadioLibInterface::rxIsr())()
+{
+#if MAX_RADIO_INTERFACES > 1
+    if (radioIndex == 1)
+        return isrRxLevel1;
+#endif
+    return isrRxLevel0;
+}
+
+void (*RadioLibInterface::txIsr())()
+{
+#if MAX_RADIO_INTERFACES > 1
+    if (radioIndex == 1)
+        return isrTxLevel1;
+#endif
+    return isrTxLevel0;
 }
 
-/** Our ISR code currently needs this to find our active instance
- */
 RadioLibInterface *RadioLibInterface::instance;
+RadioLibInterface *RadioLibInterface::instances[MAX_RADIO_INTERFACES];
 
 /** Could we send right now (i.e. either not actively receiving or transmitting)? */
 bool RadioLibInterface::canSendImmediately()
@@ -103,6 +178,7 @@ bool RadioLibInterface::canSendImmediately()
         }
         if (busyRx) {
             LOG_WARN("Can not send yet, busyRx");
+            txDeferredRx++;
         }
         return false;
     } else
@@ -172,7 +248,7 @@ ErrorCode RadioLibInterface::send(meshtastic_MeshPacket *p)
     printPacket("enqueue for send", p);
 
     LOG_DEBUG("txGood=%d,txRelay=%d,rxGood=%d,rxBad=%d", txGood, txRelay, rxGood, rxBad);
-    ErrorCode res = txQueue.enqueue(p) ? ERRNO_OK : ERRNO_UNKNOWN;
+    ErrorCode res = txQueue.enqueue(p, getPacketTime(p), getAirTime()) ? ERRNO_OK : ERRNO_UNKNOWN;
 
     if (res != ERRNO_OK) { // we weren't able to queue it, so we must drop it to prevent leaks
         packetPool.release(p);
@@ -236,6 +312,13 @@ bool RadioLibInterface::findInTxQueue(NodeNum from, PacketId id)
     return txQueue.find(from, id);
 }
 
+#if TX_QUEUE_DEADLINES
+void RadioLibInterface::setTxDeadline(NodeNum from, PacketId id, meshtastic_PortNum port)
+{
+    txQueue.setDeadline(from, id, port, MeshPacketQueue::defaultDeadlineMs(port));
+}
+#endif
+
 /** radio helper thread callback.
 We never immediately transmit after any operation (either Rx or Tx). Instead we should wait a random multiple of
 'slotTimes' (see definition in RadioInterface.h) taken from a contention window (CW) to lower the chance of collision.
@@ -245,18 +328,16 @@ currently active.
 */
 void RadioLibInterface::onNotify(uint32_t notification)
 {
+    TRACE_SCOPE("RadioLibInterface::onNotify");
     switch (notification) {
     case ISR_TX:
-        handleTransmitInterrupt();
-        startReceive();
-        setTransmitDelay();
-        break;
     case ISR_RX:
-        handleReceiveInterrupt();
-        startReceive();
-        setTransmitDelay();
+        handleIsrEvents();
         break;
     case TRANSMIT_DELAY_COMPLETED:
+#if TX_QUEUE_DEADLINES
+        txQueue.dropExpired();
+#endif
 
         // If we are not currently in receive mode, then restart the random delay (this can happen if the main thread
         // has placed the unit into standby)  FIXME, how will this work if the chipset is in sleep mode?
@@ -271,21 +352,35 @@ void RadioLibInterface::onNotify(uint32_t notification)
                     // There's still some delay pending on this packet, so resume waiting for it to elapse
                     notifyLater(delay_remaining, TRANSMIT_DELAY_COMPLETED, false);
                 } else {
-                    if (isChannelActive()) { // check if there is currently a LoRa packet on the channel
-                        startReceive();      // try receiving this packet, afterwards we'll be trying to transmit again
+                    cadScans++;
+                    bool busy = isChannelActive(); // check if there is currently a LoRa packet on the channel
+#if AIRTIME_SERIES
+                    getAirTime()->logCad(busy);
+#endif
+                    if (busy) {
+                        LOG_DEBUG("Channel busy, back off");
+                        txDeferredCad++;
+                        startReceive(); // try receiving this packet, afterwards we'll be trying to transmit again
                         setTransmitDelay();
                     } else {
                         // Send any outgoing packets we have ready as fast as possible to keep the time between channel scan and
                         // actual transmission as short as possible
                         txp = txQueue.dequeue();
                         assert(txp);
+#if PACKET_AGGREGATION
+                        txp = PacketAggregation::aggregate(txp, txQueue);
+#endif
                         bool sent = startSend(txp);
                         if (sent) {
                             // Packet has been sent, count it toward our TX airtime utilization.
                             uint32_t xmitMsec = getPacketTime(txp);
-                            airTime->logAirtime(TX_LOG, xmitMsec);
+                            getAirTime()->logAirtime(TX_LOG, xmitMsec);
+#if AIRTIME_TOP_TALKERS
+                            getAirTime()->noteTalker(AirTime::TALKER_NODE, txp->from, xmitMsec);
+#endif
                         }
-                        LOG_DEBUG("%d packets remain in the TX queue", txQueue.getMaxLen() - txQueue.getFree());
+                        LOG_DEBUG("%d packets remain in the TX queue, %u ms of airtime", txQueue.getMaxLen() - txQueue.getFree(),
+                                  getTxQueueDrainMsec());
                     }
                 }
             }
@@ -298,6 +393,45 @@ void RadioLibInterface::onNotify(uint32_t notification)
     }
 }
 
+void yieldToRadio()
+{
+#if RADIO_YIELD && !RADIO_OWN_THREAD
+    static bool yielding = false;
+    if (yielding)
+        return;
+    yielding = true;
+    for (uint8_t i = 0; i < MAX_RADIO_INTERFACES; i++) {
+        RadioLibInterface *radio = RadioLibInterface::instances[i];
+        // Not from inside the radio's own work, it may be half way through what we would run
+        if (radio && radio != concurrency::OSThread::currentThread && !radio->isrEvents.empty())
+            radio->handleIsrEvents();
+    }
+    yielding = false;
+#endif
+}
+
+/// Handle every queued interrupt in the order they happened, the notification that woke us only tells us there is at least one
+void RadioLibInterface::handleIsrEvents()
+{
+    IsrEvent e;
+    while (isrEvents.pop(e)) {
+        if (e.cause == ISR_TX) {
+            handleTransmitInterrupt();
+        } else {
+            rxIsrMsec = e.when;
+            handleReceiveInterrupt();
+        }
+        startReceive();
+        setTransmitDelay();
+    }
+
+    uint32_t dropped = isrEvents.getDropped();
+    if (dropped != isrEventsDropped) {
+        LOG_ERROR("Radio interrupt queue overflowed, lost %u events", dropped - isrEventsDropped);
+        isrEventsDropped = dropped;
+    }
+}
+
 void RadioLibInterface::setTransmitDelay()
 {
     meshtastic_MeshPacket *p = txQueue.getFront();
@@ -410,22 +544,26 @@ void RadioLibInterface::handleReceiveInterrupt()
 #ifndef DISABLE_WELCOME_UNSET
     if (config.lora.region == meshtastic_Config_LoRaConfig_RegionCode_UNSET) {
         LOG_WARN("lora rx disabled: Region unset");
-        airTime->logAirtime(RX_ALL_LOG, xmitMsec);
+        getAirTime()->logAirtime(RX_ALL_LOG, xmitMsec);
         return;
     }
 #endif
 
-    int state = iface->readData((uint8_t *)&radioBuffer, length);
+    // Read the frame straight into the packet it will be delivered in, rather than into radioBuffer and then copying it over
+    meshtastic_MeshPacket *mp = packetPool.allocZeroed();
+    uint8_t *frame = mp->encrypted.bytes;
+    int state = length <= sizeof(mp->encrypted.bytes) ? iface->readData(frame, length) : RADIOLIB_ERR_PACKET_TOO_LONG;
 #if ARCH_PORTDUINO
-    if (settingsMap[logoutputlevel] == level_trace) {
-        printBytes("Raw incoming packet: ", (uint8_t *)&radioBuffer, length);
+    if (state == RADIOLIB_ERR_NONE && settingsMap[logoutputlevel] == level_trace) {
+        printBytes("Raw incoming packet: ", frame, length);
     }
 #endif
     if (state != RADIOLIB_ERR_NONE) {
         LOG_ERROR("Ignore received packet due to error=%d", state);
         rxBad++;
+        packetPool.release(mp);
 
-        airTime->logAirtime(RX_ALL_LOG, xmitMsec);
+        getAirTime()->logAirtime(RX_ALL_LOG, xmitMsec);
 
     } else {
         // Skip the 4 headers that are at the beginning of the rxBuf
@@ -435,45 +573,57 @@ void RadioLibInterface::handleReceiveInterrupt()
         if (payloadLen < 0) {
             LOG_WARN("Ignore received packet too short");
             rxBad++;
-            airTime->logAirtime(RX_ALL_LOG, xmitMsec);
+            packetPool.release(mp);
+            getAirTime()->logAirtime(RX_ALL_LOG, xmitMsec);
         } else {
+            // The header sits in front of the payload, take it out (memcpy, the frame bytes have no alignment guarantee)
+            PacketHeader header;
+            memcpy(&header, frame, sizeof(header));
+
+#if RX_HEADER_PREFILTER
+            if (HeaderReject reject = checkHeader(header, payloadLen)) {
+                LOG_DEBUG("Ignore received frame with impossible header, reason %d", reject);
+                rxRejected[reject]++;
+                rxBad++;
+                packetPool.release(mp);
+                getAirTime()->logAirtime(RX_ALL_LOG, xmitMsec);
+                return;
+            }
+#endif
             rxGood++;
+
             // altered packet with "from == 0" can do Remote Node Administration without permission
-            if (radioBuffer.header.from == 0) {
+            if (header.from == 0) {
                 LOG_WARN("Ignore received packet without sender");
+                packetPool.release(mp);
                 return;
             }
 
             // Note: we deliver _all_ packets to our router (i.e. our interface is intentionally promiscuous).
             // This allows the router and other apps on our node to sniff packets (usually routing) between other
             // nodes.
-            meshtastic_MeshPacket *mp = packetPool.allocZeroed();
-
-            // Keep the assigned fields in sync with src/mqtt/MQTT.cpp:onReceiveProto
-            mp->from = radioBuffer.header.from;
-            mp->to = radioBuffer.header.to;
-            mp->id = radioBuffer.header.id;
-            mp->channel = radioBuffer.header.channel;
-            assert(HOP_MAX <= PACKET_FLAGS_HOP_LIMIT_MASK); // If hopmax changes, carefully check this code
-            mp->hop_limit = radioBuffer.header.flags & PACKET_FLAGS_HOP_LIMIT_MASK;
-            mp->hop_start = (radioBuffer.header.flags & PACKET_FLAGS_HOP_START_MASK) >> PACKET_FLAGS_HOP_START_SHIFT;
-            mp->want_ack = !!(radioBuffer.header.flags & PACKET_FLAGS_WANT_ACK_MASK);
-            mp->via_mqtt = !!(radioBuffer.header.flags & PACKET_FLAGS_VIA_MQTT_MASK);
-            // If hop_start is not set, next_hop and relay_node are invalid (firmware <2.3)
-            mp->next_hop = mp->hop_start == 0 ? NO_NEXT_HOP_PREFERENCE : radioBuffer.header.next_hop;
-            mp->relay_node = mp->hop_start == 0 ? NO_RELAY_NODE : radioBuffer.header.relay_node;
+
+            unpackHeader(header, mp);
 
             addReceiveMetadata(mp);
 
+            // Timestamp from the interrupt, rather than from whenever we got around to reading the radio
+            mp->rx_time = getValidTime(RTCQualityFromNet);
+            if (mp->rx_time)
+                mp->rx_time -= (millis() - rxIsrMsec + 500) / 1000;
+
             mp->which_payload_variant =
                 meshtastic_MeshPacket_encrypted_tag; // Mark that the payload is still encrypted at this point
-            assert(((uint32_t)payloadLen) <= sizeof(mp->encrypted.bytes));
-            memcpy(mp->encrypted.bytes, radioBuffer.payload, payloadLen);
+            memmove(mp->encrypted.bytes, frame + sizeof(PacketHeader), payloadLen); // drop the header, in place
             mp->encrypted.size = payloadLen;
 
             printPacket("Lora RX", mp);
 
-            airTime->logAirtime(RX_LOG, xmitMsec);
+            getAirTime()->logAirtime(RX_LOG, xmitMsec);
+#if AIRTIME_TOP_TALKERS
+            getAirTime()->noteTalker(AirTime::TALKER_NODE, mp->from, xmitMsec);
+#endif
+            PacketLatency::stamp(PacketLatency::RadioRx, mp);
 
             deliverToReceiver(mp);
         }
@@ -524,8 +674,9 @@ bool RadioLibInterface::startSend(meshtastic_MeshPacket *txp)
         } else {
             // Must be done AFTER, starting transmit, because startTransmit clears (possibly stale) interrupt pending register
             // bits
-            enableInterrupt(isrTxLevel0);
+            enableInterrupt(txIsr());
             lastTxStart = millis();
+            PacketLatency::stamp(PacketLatency::TxStart, txp);
             printPacket("Started Tx", txp);
         }
 
@@ -3,6 +3,7 @@
 #include "MeshPacketQueue.h"
 #include "RadioInterface.h"
 #include "concurrency/NotifiedWorkerThread.h"
+#include "concurrency/SPSCQueue.h"
 
 #include <RadioLib.h>
 #include <sys/types.h>
@@ -19,6 +20,11 @@
 // In addition to the default Rx flags, we need the PREAMBLE_DETECTED flag to detect whether we are actively receiving
 #define MESHTASTIC_RADIOLIB_IRQ_RX_FLAGS (RADIOLIB_IRQ_RX_DEFAULT_FLAGS | (1 << RADIOLIB_IRQ_PREAMBLE_DETECTED))
 
+// Time each radio SPI command (CS toggles and transfer) and log the totals with the local stats
+#ifndef RADIO_SPI_STATS
+#define RADIO_SPI_STATS 0
+#endif
+
 /**
  * We need to override the RadioLib ArduinoHal class to add mutex protection for SPI bus access
  */
@@ -33,6 +39,16 @@ class LockingArduinoHal : public ArduinoHal
     void spiTransfer(uint8_t *out, size_t len, uint8_t *in) override;
 
 #endif
+
+#if RADIO_SPI_STATS
+    // Shared by all radios, they share the SPI lock too
+    static uint32_t spiCommands, spiMicrosTotal, spiMicrosMax;
+
+    static void logSpiStats();
+
+  private:
+    uint32_t spiStartedMicros = 0;
+#endif
 };
 
 #if defined(USE_STM32WLx)
@@ -53,10 +69,31 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
     /// Used as our notification from the ISR
     enum PendingISR { ISR_NONE = 0, ISR_RX, ISR_TX, TRANSMIT_DELAY_COMPLETED };
 
+    /// An interrupt and when it happened.  Notifications overwrite each other, so the ISR queues these and only uses the
+    /// notification to wake us up
+    struct IsrEvent {
+        PendingISR cause;
+        uint32_t when; // millis() at interrupt time
+    };
+    concurrency::SPSCQueue<IsrEvent, 8> isrEvents;
+    uint32_t isrEventsDropped = 0; // last isrEvents.getDropped() we reported
+
+    /// millis() when the receive interrupt for the packet we are reading fired
+    uint32_t rxIsrMsec = 0;
+
+    void handleIsrEvents();
+    friend void yieldToRadio();
+
     /**
      * Raw ISR handler that just calls our polymorphic method
      */
-    static void isrTxLevel0(), isrLevel0Common(PendingISR code);
+    static void isrTxLevel0(), isrLevel0Common(RadioLibInterface *radio, PendingISR code);
+#if MAX_RADIO_INTERFACES > 1
+    static void isrRxLevel1(), isrTxLevel1();
+#endif
+
+    /// Our slot in instances[], which picks the ISR glue functions we hand to RadioLib
+    uint8_t radioIndex = 0;
 
     MeshPacketQueue txQueue = MeshPacketQueue(MAX_TX_QUEUE);
 
@@ -87,10 +124,13 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
     bool isReceiving = false;
 
   public:
-    /** Our ISR code currently needs this to find our active instance
+    /** The first radio, the one the status and telemetry code reports on
      */
     static RadioLibInterface *instance;
 
+    /// Every radio, by radioIndex, for our ISR code (plain functions) to find theirs
+    static RadioLibInterface *instances[MAX_RADIO_INTERFACES];
+
     /**
      * Glue functions called from ISR land
      */
@@ -106,10 +146,23 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
      */
     uint32_t rxBad = 0, rxGood = 0, txGood = 0, txRelay = 0;
 
+#if RX_HEADER_PREFILTER
+    /// Received frames checkHeader() turned away, by reason, they count as rxBad too
+    uint32_t rxRejected[NUM_HEADER_REJECTS] = {};
+#endif
+
+    /**
+     * Channel access counts: CAD scans run just before sending, how many found a preamble on the channel, and how many
+     * times we held off because we were part way through receiving.  Each of those backs off and tries again.
+     */
+    uint32_t cadScans = 0, txDeferredCad = 0, txDeferredRx = 0;
+
   public:
     RadioLibInterface(LockingArduinoHal *hal, RADIOLIB_PIN_TYPE cs, RADIOLIB_PIN_TYPE irq, RADIOLIB_PIN_TYPE rst,
                       RADIOLIB_PIN_TYPE busy, PhysicalLayer *iface = NULL);
 
+    virtual ~RadioLibInterface();
+
     virtual ErrorCode send(meshtastic_MeshPacket *p) override;
 
     /**
@@ -146,6 +199,10 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
     /** Attempt to find a packet in the TxQueue. Returns true if the packet was found. */
     virtual bool findInTxQueue(NodeNum from, PacketId id) override;
 
+#if TX_QUEUE_DEADLINES
+    virtual void setTxDeadline(NodeNum from, PacketId id, meshtastic_PortNum port) override;
+#endif
+
   private:
     /** if we have something waiting to send, start a short (random) timer so we can come check for collision before actually
      * doing the transmit */
@@ -178,6 +235,10 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
 
     meshtastic_QueueStatus getQueueStatus();
 
+    virtual uint32_t getTxQueueDrainMsec() override { return txQueue.getDrainTimeMsec(*this); }
+
+    const MeshPacketQueue &getTxQueue() const { return txQueue; }
+
   protected:
     uint32_t activeReceiveStart = 0;
 
@@ -195,6 +256,10 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
      */
     static void isrRxLevel0();
 
+    /// The RX and TX ISR glue functions for this radio
+    void (*rxIsr())();
+    void (*txIsr())();
+
     /**
      * If a send was in progress finish it and return the buffer to the pool */
     void completeSending();
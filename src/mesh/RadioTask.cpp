@@ -0,0 +1,84 @@
+#include "RadioTask.h"
+
+#if RADIO_OWN_THREAD
+#include "configuration.h"
+
+#if PORTDUINO_RADIO_THREAD
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+#endif
+
+namespace concurrency
+{
+
+ThreadController radioController;
+InterruptableDelay radioDelay;
+
+Lock *radioLock()
+{
+    static Lock lock;
+    return &lock;
+}
+
+static void radioLoop()
+{
+    for (;;) {
+        long delayMsec;
+        {
+            LockGuard guard(radioLock());
+            delayMsec = radioController.runOrDelay();
+        }
+        radioDelay.delay(delayMsec);
+    }
+}
+
+#if RADIO_DUAL_CORE
+static void radioTask(void *unused)
+{
+    radioLoop();
+}
+
+void startRadioTask()
+{
+    radioController.ThreadName = "radioController";
+#ifdef ARCH_ESP32
+    BaseType_t res = xTaskCreatePinnedToCore(radioTask, "radio", RADIO_TASK_STACK, NULL, RADIO_TASK_PRIORITY, NULL,
+                                             RADIO_TASK_CORE);
+#else
+    // arduino-pico runs FreeRTOS SMP, received packets cross to core 0 through Router's fromRadioQueue like on ESP32
+    BaseType_t res = xTaskCreateAffinitySet(radioTask, "radio", RADIO_TASK_STACK, NULL, RADIO_TASK_PRIORITY,
+                                            1 << RADIO_TASK_CORE, NULL);
+#endif
+    assert(res == pdPASS);
+    LOG_INFO("Radio runs in its own task on core %d", RADIO_TASK_CORE);
+}
+#else
+void startRadioTask()
+{
+    radioController.ThreadName = "radioController";
+    std::thread radioThread(radioLoop);
+    pthread_t handle = radioThread.native_handle();
+    pthread_setname_np(handle, "radio");
+
+#if RADIO_THREAD_CPU >= 0
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(RADIO_THREAD_CPU, &cpus);
+    if (pthread_setaffinity_np(handle, sizeof(cpus), &cpus) != 0)
+        LOG_WARN("Can't pin the radio thread to CPU %d", RADIO_THREAD_CPU);
+#endif
+#if RADIO_THREAD_RT_PRIORITY > 0
+    struct sched_param param = {};
+    param.sched_priority = RADIO_THREAD_RT_PRIORITY;
+    if (pthread_setschedparam(handle, SCHED_FIFO, &param) != 0)
+        LOG_WARN("Can't give the radio thread SCHED_FIFO priority %d, needs CAP_SYS_NICE", RADIO_THREAD_RT_PRIORITY);
+#endif
+
+    radioThread.detach(); // Runs until we exit
+    LOG_INFO("Radio runs in its own thread");
+}
+#endif
+
+} // namespace concurrency
+#endif
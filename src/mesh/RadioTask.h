@@ -0,0 +1,120 @@
+#pragma once
+
+#include "concurrency/LockGuard.h"
+#include "concurrency/OSThread.h"
+
+/**
+ * Set to 1 on ESP32, RP2040 or RP2350 to run the radio thread (RadioLibInterface: interrupts, CAD, starting transmissions,
+ * reading received frames) in its own FreeRTOS task pinned to RADIO_TASK_CORE, so slow WiFi, MQTT, HTTP or BLE work in the
+ * main loop no longer delays it.  On the Picos, which run the whole firmware on core 0, this puts the otherwise idle core 1 to
+ * work.
+ *
+ * Router and the modules stay on the main loop, they share NodeDB, the phone queues and everything else with the rest of the
+ * firmware.  Received packets reach them through Router's fromRadioQueue as before, a FreeRTOS queue.  In the other
+ * direction the main loop holds radioLock() (a RadioLockGuard) around every call into the interface, and the radio task holds
+ * it while it runs.
+ */
+#ifndef RADIO_DUAL_CORE
+#define RADIO_DUAL_CORE 0
+#endif
+
+/**
+ * The same for meshtasticd: the radio thread runs in its own pthread, so the API, MQTT and the web server in the main loop
+ * can't hold up SPI reads.  This also makes concurrency::Lock and the portduino TypedQueue real (mutex backed) instead of
+ * no-ops.
+ */
+#ifndef PORTDUINO_RADIO_THREAD
+#define PORTDUINO_RADIO_THREAD 0
+#endif
+
+#if RADIO_DUAL_CORE && !defined(ARCH_ESP32) && !defined(ARCH_RP2040)
+#error "RADIO_DUAL_CORE needs ESP32 or RP2xx0"
+#endif
+#if PORTDUINO_RADIO_THREAD && !defined(ARCH_PORTDUINO)
+#error "PORTDUINO_RADIO_THREAD needs portduino"
+#endif
+
+#define RADIO_OWN_THREAD (RADIO_DUAL_CORE || PORTDUINO_RADIO_THREAD)
+
+/// Let long work on the main loop read out received packets part way through, see yieldToRadio()
+#ifndef RADIO_YIELD
+#define RADIO_YIELD 0
+#endif
+
+#if RADIO_DUAL_CORE && defined(ARCH_ESP32)
+/// The WiFi and Bluetooth stacks run on core 0 and the Arduino loop on core 1, we sit with the stacks at a lower priority
+#ifndef RADIO_TASK_CORE
+#define RADIO_TASK_CORE 0
+#endif
+
+/// Above the loop task (1), below the WiFi and Bluetooth tasks
+#ifndef RADIO_TASK_PRIORITY
+#define RADIO_TASK_PRIORITY 5
+#endif
+
+/// In bytes
+#ifndef RADIO_TASK_STACK
+#define RADIO_TASK_STACK 8192
+#endif
+#elif RADIO_DUAL_CORE
+/// The Arduino loop runs on core 0, core 1 has nothing else to do
+#ifndef RADIO_TASK_CORE
+#define RADIO_TASK_CORE 1
+#endif
+
+/// Above the loop task, in case RADIO_TASK_CORE is set to 0
+#ifndef RADIO_TASK_PRIORITY
+#define RADIO_TASK_PRIORITY (configMAX_PRIORITIES - 2)
+#endif
+
+/// In words, as vanilla FreeRTOS counts them
+#ifndef RADIO_TASK_STACK
+#define RADIO_TASK_STACK 2048
+#endif
+#endif
+
+#if PORTDUINO_RADIO_THREAD
+/// CPU to pin the radio thread to, -1 to let the kernel choose
+#ifndef RADIO_THREAD_CPU
+#define RADIO_THREAD_CPU -1
+#endif
+
+/// SCHED_FIFO priority for the radio thread, 0 to keep normal scheduling.  Needs root or CAP_SYS_NICE, we only warn without.
+#ifndef RADIO_THREAD_RT_PRIORITY
+#define RADIO_THREAD_RT_PRIORITY 0
+#endif
+#endif
+
+#if RADIO_OWN_THREAD
+namespace concurrency
+{
+extern ThreadController radioController;
+extern InterruptableDelay radioDelay;
+/// Made on first use, not by a static constructor
+Lock *radioLock();
+
+/// Start running radioController, once the radio interface and airTime exist
+void startRadioTask();
+} // namespace concurrency
+#endif
+
+/**
+ * Called between chunks of long blocking work on the main loop: a full TFT frame, waiting out an e-ink refresh, a NodeDB save.
+ * With RADIO_YIELD, a radio interrupt that came in meanwhile is handled now rather than after the work, so the packet is read
+ * out before another one overwrites it.  Must be called without spiLock held.  Does nothing if the radio has its own thread.
+ */
+void yieldToRadio();
+
+/// Taken by the main loop around calls into the radio interface, does nothing without RADIO_OWN_THREAD
+class RadioLockGuard
+{
+#if RADIO_OWN_THREAD
+    concurrency::LockGuard guard;
+
+  public:
+    RadioLockGuard() : guard(concurrency::radioLock()) {}
+#else
+  public:
+    RadioLockGuard() {}
+#endif
+};
@@ -22,21 +22,59 @@ ErrorCode ReliableRouter::send(meshtastic_MeshPacket *p)
             p->hop_limit = Default::getConfiguredOrDefaultHopLimit(config.lora.hop_limit);
         }
 
-        auto copy = packetPool.allocCopy(*p);
-        startRetransmission(copy, NUM_RELIABLE_RETX);
+        // Without a pending record no ack could ever be matched, so don't leave the sender waiting for one
+        if (!startRetransmission(packetPool.allocCopy(*p), NUM_RELIABLE_RETX)) {
+            sendAckNak(meshtastic_Routing_Error_MAX_RETRANSMIT, getFrom(p), p->id, p->channel);
+            packetPool.release(p);
+            return ERRNO_UNKNOWN;
+        }
     }
 
     /* If we have pending retransmissions, add the airtime of this packet to it, because during that time we cannot receive an
        (implicit) ACK. Otherwise, we might retransmit too early.
      */
-    for (auto i = pending.begin(); i != pending.end(); i++) {
-        if (i->first.id != p->id) {
-            i->second.nextTxMsec += iface->getPacketTime(p);
+    if (!pending.empty())
+        delayRetransmissions(iface->getPacketTime(p), p->id);
+
+#if PIGGYBACK_ACKS
+    if (p->which_payload_variant == meshtastic_MeshPacket_decoded_tag && p->decoded.request_id && !isBroadcast(p->to))
+        perhapsPiggybackAck(p);
+#endif
+
+    return isBroadcast(p->to) ? FloodingRouter::send(p) : NextHopRouter::send(p);
+}
+
+#if PIGGYBACK_ACKS
+void ReliableRouter::perhapsPiggybackAck(const meshtastic_MeshPacket *p)
+{
+    if (p->decoded.portnum == meshtastic_PortNum_ROUTING_APP) {
+        meshtastic_Routing r = meshtastic_Routing_init_zero;
+        if (pb_decode_from_bytes(p->decoded.payload.bytes, p->decoded.payload.size, &meshtastic_Routing_msg, &r) &&
+            r.which_variant == meshtastic_Routing_error_reason_tag && r.error_reason == meshtastic_Routing_Error_NONE) {
+            QueuedAck &a = queuedAcks[nextQueuedAck];
+            nextQueuedAck = (nextQueuedAck + 1) % PIGGYBACK_ACKS_TRACKED;
+            a.to = p->to;
+            a.requestId = p->decoded.request_id;
+            a.id = p->id;
+            a.channel = p->channel;
+            a.hopLimit = p->hop_limit;
         }
+        return;
     }
 
-    return isBroadcast(p->to) ? FloodingRouter::send(p) : NextHopRouter::send(p);
+    // Any other reply acks the request implicitly, if it reaches as far as our ACK would have
+    for (QueuedAck &a : queuedAcks) {
+        if (a.id && a.to == p->to && a.requestId == p->decoded.request_id && a.channel == p->channel &&
+            a.hopLimit <= p->hop_limit) {
+            if (cancelSending(getNodeNum(), a.id)) {
+                LOG_DEBUG("Reply to 0x%x acks 0x%x, drop the queued ACK", p->to, a.requestId);
+                txAckPiggybacked++;
+            }
+            a.id = 0;
+        }
+    }
 }
+#endif
 
 bool ReliableRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
 {
@@ -2,10 +2,21 @@
 
 #include "NextHopRouter.h"
 
+/// Set to 1 to drop a queued ACK when a reply to the same request, which acks it implicitly, is sent before the ACK went out
+#ifndef PIGGYBACK_ACKS
+#define PIGGYBACK_ACKS 0
+#endif
+
+#define PIGGYBACK_ACKS_TRACKED 4 // queued ACKs we remember
+
 /**
  * This is a mixin that extends Router with the ability to do (one hop only) reliable message sends.
+ *
+ * A reply carries the id of the request in Data.request_id, and the requester takes that as an ACK.  A reply made while the
+ * modules handle the request goes out instead of an ACK (see MeshModule::currentReply).  With PIGGYBACK_ACKS a reply made later,
+ * while the ACK is still waiting in the TX queue, takes the ACK's place as well.
  */
-class ReliableRouter : public NextHopRouter
+class ReliableRouter final : public NextHopRouter
 {
   public:
     /**
@@ -22,6 +33,21 @@ class ReliableRouter : public NextHopRouter
     virtual ErrorCode send(meshtastic_MeshPacket *p) override;
 
   protected:
+#if PIGGYBACK_ACKS
+    struct QueuedAck {
+        NodeNum to;
+        PacketId requestId; // the packet acked
+        PacketId id;        // of the ACK itself
+        uint8_t channel;
+        uint8_t hopLimit;
+    };
+    QueuedAck queuedAcks[PIGGYBACK_ACKS_TRACKED] = {};
+    uint8_t nextQueuedAck = 0;
+
+    /// Remember the ACKs we send, and drop one that a reply to the same request makes unnecessary
+    void perhapsPiggybackAck(const meshtastic_MeshPacket *p);
+#endif
+
     /**
      * Look for acks/naks or someone retransmitting us
      */
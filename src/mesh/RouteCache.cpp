@@ -0,0 +1,114 @@
+#include "RouteCache.h"
+#include "configuration.h"
+
+// Candidates start off as if delivering 3 of every 4 attempts, then each outcome moves the rate a quarter of the way
+static const uint8_t INITIAL_DELIVERY_RATE = 192;
+static const uint8_t MAX_MISSES = 2;
+
+int32_t RouteCache::score(const Candidate &c, uint32_t now)
+{
+    uint32_t age = now - c.lastDeliveredMs;
+    if (c.relay == NO_NEXT_HOP_PREFERENCE || c.misses >= MAX_MISSES || age > ROUTE_MAX_AGE_MS)
+        return -1;
+
+    // Delivery rate counts most, a strong link breaks ties and routes fade as they haven't been confirmed for a while
+    int32_t snr = c.snr < -20 ? -20 : (c.snr > 10 ? 10 : c.snr);
+    return 2 * c.deliveryRate + 2 * (snr + 20) + 64 - (int32_t)((uint64_t)age * 64 / ROUTE_MAX_AGE_MS);
+}
+
+void RouteCache::delivered(NodeNum dest, uint8_t relay, float snr, uint32_t now)
+{
+    if (relay == NO_NEXT_HOP_PREFERENCE)
+        return;
+
+    if (!routes.find(dest) && routes.full())
+        evictStalest(now);
+    Route *r = routes.findOrInsert(dest);
+    if (!r)
+        return;
+
+    Candidate *c = NULL;
+    for (auto &cand : r->candidates) {
+        if (cand.relay == relay) {
+            c = &cand;
+            break;
+        }
+    }
+    int8_t snrDb = snr < -128 ? -128 : (snr > 127 ? 127 : (int8_t)snr);
+    if (c) {
+        c->deliveryRate += (255 - c->deliveryRate) / 4;
+        c->snr = (3 * c->snr + snrDb) / 4;
+    } else {
+        // Replace the worst (or an unused) candidate
+        c = &r->candidates[0];
+        for (auto &cand : r->candidates)
+            if (score(cand, now) < score(*c, now))
+                c = &cand;
+        if (c->relay != NO_NEXT_HOP_PREFERENCE)
+            LOG_DEBUG("Route to 0x%x: replace relay 0x%x with 0x%x", dest, c->relay, relay);
+        c->relay = relay;
+        c->deliveryRate = INITIAL_DELIVERY_RATE;
+        c->snr = snrDb;
+    }
+    c->misses = 0;
+    c->lastDeliveredMs = now;
+}
+
+void RouteCache::missed(NodeNum dest, uint8_t relay)
+{
+    Route *r = routes.find(dest);
+    if (!r || relay == NO_NEXT_HOP_PREFERENCE)
+        return;
+    for (auto &c : r->candidates) {
+        if (c.relay == relay) {
+            c.deliveryRate -= c.deliveryRate / 4;
+            if (c.misses < UINT8_MAX)
+                c.misses++;
+            LOG_DEBUG("Route to 0x%x: relay 0x%x missed %u times, delivery rate now %u/255", dest, relay, c.misses,
+                      c.deliveryRate);
+            return;
+        }
+    }
+}
+
+bool RouteCache::pick(NodeNum dest, uint8_t exclude, uint32_t now, uint8_t &hop) const
+{
+    const Route *r = routes.find(dest);
+    if (!r)
+        return false;
+
+    hop = NO_NEXT_HOP_PREFERENCE;
+    int32_t best = -1;
+    bool known = false;
+    for (const auto &c : r->candidates) {
+        if (c.relay == NO_NEXT_HOP_PREFERENCE || now - c.lastDeliveredMs > ROUTE_MAX_AGE_MS)
+            continue;
+        known = true; // even if we can't use it right now
+        int32_t s = score(c, now);
+        if (c.relay != exclude && s > best) {
+            best = s;
+            hop = c.relay;
+        }
+    }
+    return known;
+}
+
+void RouteCache::evictStalest(uint32_t now)
+{
+    NodeNum stalest = 0;
+    uint32_t stalestAge = 0;
+    bool found = false;
+    routes.forEach([&](const NodeNum &dest, Route &r) {
+        uint32_t age = UINT32_MAX;
+        for (const auto &c : r.candidates)
+            if (c.relay != NO_NEXT_HOP_PREFERENCE && now - c.lastDeliveredMs < age)
+                age = now - c.lastDeliveredMs;
+        if (!found || age > stalestAge) {
+            stalest = dest;
+            stalestAge = age;
+            found = true;
+        }
+    });
+    if (found)
+        routes.erase(stalest);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "FlatHashMap.h"
+#include "MeshTypes.h"
+#include "configuration.h"
+
+/// Destinations we remember routes for (a power of two, 3/4 of it can be used)
+#ifndef ROUTE_CACHE_SIZE
+#if defined(ARCH_ESP32) || defined(ARCH_PORTDUINO)
+#define ROUTE_CACHE_SIZE 256
+#else
+#define ROUTE_CACHE_SIZE 128
+#endif
+#endif
+
+/// Candidate relays kept per destination
+#ifndef ROUTE_CANDIDATES
+#define ROUTE_CANDIDATES 3
+#endif
+
+/// A relay that hasn't delivered an ACK for this long is no longer trusted
+#ifndef ROUTE_MAX_AGE_MS
+#define ROUTE_MAX_AGE_MS (60 * 60 * 1000)
+#endif
+
+/// Set to 1 to also learn routes from the traceroute replies that pass through us (see TraceRouteModule)
+#ifndef ROUTES_FROM_TRACEROUTE
+#define ROUTES_FROM_TRACEROUTE 0
+#endif
+
+/**
+ * The relays that got ACKs (or replies) back to us from each destination, so NextHopRouter can pick the best of several and
+ * move on to another quickly when one stops working, instead of going straight back to flooding.
+ *
+ * Each candidate has a rolling delivery rate (the inverse of its ETX, the expected number of transmissions per delivery), the
+ * rolling SNR we hear it with and when it last delivered.  A candidate that misses twice in a row is skipped until it delivers
+ * again.
+ */
+class RouteCache
+{
+  public:
+    /// An ACK or reply from dest reached us through relay, heard with snr
+    void delivered(NodeNum dest, uint8_t relay, float snr, uint32_t now);
+
+    /// A packet for dest sent through relay wasn't relayed or ACKed in time
+    void missed(NodeNum dest, uint8_t relay);
+
+    /**
+     * Choose the relay for a packet to dest, never picking exclude (the node we got the packet from)
+     * @return true if we know routes to dest, with hop set to the best one, or NO_NEXT_HOP_PREFERENCE if none of them can be
+     * used right now (so we should flood). false if we know nothing about dest.
+     */
+    bool pick(NodeNum dest, uint8_t exclude, uint32_t now, uint8_t &hop) const;
+
+    void clear() { routes.clear(); }
+
+    size_t size() const { return routes.size(); }
+
+  private:
+    struct Candidate {
+        uint8_t relay = NO_NEXT_HOP_PREFERENCE;
+        uint8_t deliveryRate = 0; // rolling share of attempts that got through, 255 = all of them
+        uint8_t misses = 0;       // attempts without an ACK since the last one that got through
+        int8_t snr = 0;           // rolling, in dB
+        uint32_t lastDeliveredMs = 0;
+    };
+
+    struct Route {
+        Candidate candidates[ROUTE_CANDIDATES];
+    };
+
+    FlatHashMap<NodeNum, Route, ROUTE_CACHE_SIZE> routes;
+
+    /// @return how good c is now, higher is better, or a negative value if it shouldn't be used
+    static int32_t score(const Candidate &c, uint32_t now);
+
+    /// Make room for dest by forgetting the destination we heard from longest ago
+    void evictStalest(uint32_t now);
+};
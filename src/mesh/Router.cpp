@@ -1,10 +1,16 @@
 #include "Router.h"
 #include "Channels.h"
 #include "CryptoEngine.h"
+#include "EventTrace.h"
 #include "MeshRadio.h"
 #include "MeshService.h"
 #include "NodeDB.h"
+#include "PacketAggregation.h"
+#include "PacketLatency.h"
+#include "PayloadCompression.h"
 #include "RTC.h"
+#include "RadioTask.h"
+#include "TextCompression.h"
 #include "configuration.h"
 #include "detect/LoRaRadioType.h"
 #include "main.h"
@@ -16,6 +22,7 @@
 #endif
 #include "Default.h"
 #if ARCH_PORTDUINO
+#include "platform/portduino/PacketCapture.h"
 #include "platform/portduino/PortduinoGlue.h"
 #endif
 #if ENABLE_JSON_LOGGING || ARCH_PORTDUINO
@@ -25,19 +32,54 @@
 #define MAX_RX_FROMRADIO                                                                                                         \
     4 // max number of packets destined to our queue, we dispatch packets quickly so it doesn't need to be big
 
+/// Max number of received packets handled before NodeDB observers are told about the changes they made
+#ifndef ROUTER_RX_BATCH_SIZE
+#define ROUTER_RX_BATCH_SIZE 8
+#endif
+
 // I think this is right, one packet for each of the three fifos + one packet being currently assembled for TX or RX
 // And every TX packet might have a retransmission packet or an ack alive at any moment
 #define MAX_PACKETS                                                                                                              \
     (MAX_RX_TOPHONE + MAX_RX_FROMRADIO + 2 * MAX_TX_QUEUE +                                                                      \
      2) // max number of packets which can be in flight (either queued from reception or queued for sending)
 
-// static MemoryPool<MeshPacket> staticPool(MAX_PACKETS);
+#ifndef PACKET_POOL_SIZE
+#define PACKET_POOL_SIZE MAX_PACKETS
+#endif
+
+#if MESHTASTIC_COMPACT
+namespace compactRam
+{
+constexpr uint32_t packetPool = PACKET_POOL_SIZE * sizeof(meshtastic_MeshPacket);
+constexpr uint32_t total = nodeDB + packetHistory + phoneQueues + packetPool;
+} // namespace compactRam
+static_assert(compactRam::total <= MESHTASTIC_COMPACT_RAM_BUDGET,
+              "MESHTASTIC_COMPACT sizes exceed MESHTASTIC_COMPACT_RAM_BUDGET, shrink the profile in mesh-pb-constants.h");
+#endif
+
+#ifdef ARCH_PORTDUINO
+// Queue sizes are runtime settings on portduino, and there is no heap fragmentation to worry about
 static MemoryDynamic<meshtastic_MeshPacket> staticPool;
+#else
+static MemoryPool<meshtastic_MeshPacket, PACKET_POOL_SIZE> staticPool("packets");
+#endif
 
 Allocator<meshtastic_MeshPacket> &packetPool = staticPool;
 
 static uint8_t bytes[MAX_LORA_PAYLOAD_LEN + 1] __attribute__((__aligned__));
 
+#if CRYPTO_KEYSTREAM_PRECOMPUTE
+/// How long the router waits between keystreams while it has more to work out, so other threads get the CPU
+#define KEYSTREAM_PRECOMPUTE_GAP_MSEC 20
+
+// Packet ids picked ahead of time, oldest first, with their keystreams on the primary channel already in crypto
+static PacketId readyIds[CRYPTO_KEYSTREAM_SLOTS];
+static size_t readyIdCount;
+static concurrency::Lock *readyIdsLock;
+
+static PacketId newPacketId();
+#endif
+
 /**
  * Constructor
  *
@@ -56,8 +98,40 @@ Router::Router() : concurrency::OSThread("Router"), fromRadioQueue(MAX_RX_FROMRA
     // init Lockguard for crypt operations
     assert(!cryptLock);
     cryptLock = new concurrency::Lock();
+#if CRYPTO_KEYSTREAM_PRECOMPUTE
+    readyIdsLock = new concurrency::Lock();
+#endif
 }
 
+#if CRYPTO_KEYSTREAM_PRECOMPUTE
+/**
+ * Pick one more packet id for what we will send and work out its keystream on the primary channel, so encrypting the packet
+ * it goes to is just an XOR.  Packets on other channels or sent with PKI simply miss, their id's keystream gets replaced later.
+ *
+ * @return true if there are more to do
+ */
+static bool precomputeKeystream()
+{
+    {
+        concurrency::LockGuard g(readyIdsLock);
+        if (readyIdCount >= CRYPTO_KEYSTREAM_SLOTS)
+            return false;
+    }
+    CryptoKey k = channels.getKey(channels.getPrimaryIndex());
+    if (k.length <= 0)
+        return false; // nothing to work out without encryption
+
+    PacketId id = newPacketId();
+    {
+        concurrency::LockGuard g(cryptLock);
+        crypto->precomputeKeystream(k, nodeDB->getNodeNum(), id);
+    }
+    concurrency::LockGuard g(readyIdsLock);
+    readyIds[readyIdCount++] = id; // only this thread adds, so there is still room
+    return readyIdCount < CRYPTO_KEYSTREAM_SLOTS;
+}
+#endif
+
 /**
  * do idle processing
  * Mostly looking in our incoming rxPacket queue and calling handleReceived.
@@ -65,10 +139,23 @@ Router::Router() : concurrency::OSThread("Router"), fromRadioQueue(MAX_RX_FROMRA
 int32_t Router::runOnce()
 {
     meshtastic_MeshPacket *mp;
-    while ((mp = fromRadioQueue.dequeuePtr(0)) != NULL) {
-        // printPacket("handle fromRadioQ", mp);
-        perhapsHandleReceived(mp);
-    }
+    size_t handled;
+    do {
+        // Handle a burst of packets as one batch, so NodeDB observers (screen, status) hear about it once instead of per
+        // packet.  Bounded, so we still update them regularly while a flood is coming in.
+        nodeDB->beginBatch();
+        for (handled = 0; handled < ROUTER_RX_BATCH_SIZE && (mp = fromRadioQueue.dequeuePtr(0)) != NULL; handled++) {
+            // printPacket("handle fromRadioQ", mp);
+            perhapsHandleReceived(mp);
+        }
+        nodeDB->endBatch();
+    } while (handled == ROUTER_RX_BATCH_SIZE);
+
+#if CRYPTO_KEYSTREAM_PRECOMPUTE
+    // Nothing received left to handle, a good time to get ahead on what we will send
+    if (precomputeKeystream())
+        return KEYSTREAM_PRECOMPUTE_GAP_MSEC;
+#endif
 
     // LOG_DEBUG("Sleep forever!");
     return INT32_MAX; // Wait a long time - until we get woken for the message queue
@@ -95,7 +182,27 @@ void Router::enqueueReceivedMessage(meshtastic_MeshPacket *p)
 
 /// Generate a unique packet id
 // FIXME, move this someplace better
+#if CRYPTO_KEYSTREAM_PRECOMPUTE
 PacketId generatePacketId()
+{
+    // Hand out the ids picked ahead first, their keystreams are waiting
+    if (readyIdsLock) {
+        concurrency::LockGuard g(readyIdsLock);
+        if (readyIdCount) {
+            PacketId id = readyIds[0];
+            memmove(readyIds, readyIds + 1, --readyIdCount * sizeof(readyIds[0]));
+            if (router)
+                router->setReceivedMessage(); // wake the router to work out a replacement
+            return id;
+        }
+    }
+    return newPacketId();
+}
+
+static PacketId newPacketId()
+#else
+PacketId generatePacketId()
+#endif
 {
     static uint32_t rollingPacketId; // Note: trying to keep this in noinit didn't help for working across reboots
     static bool didInit = false;
@@ -152,6 +259,9 @@ void Router::setReceivedMessage()
     // LOG_DEBUG("set interval to ASAP");
     setInterval(0); // Run ASAP, so we can figure out our correct sleep time
     runASAP = true;
+#if RADIO_OWN_THREAD
+    concurrency::mainDelay.interrupt(); // May be called from the radio task while the main loop sleeps
+#endif
 }
 
 meshtastic_QueueStatus Router::getQueueStatus()
@@ -160,8 +270,10 @@ meshtastic_QueueStatus Router::getQueueStatus()
         meshtastic_QueueStatus qs;
         qs.res = qs.mesh_packet_id = qs.free = qs.maxlen = 0;
         return qs;
-    } else
+    } else {
+        RadioLockGuard guard;
         return iface->getQueueStatus();
+    }
 }
 
 ErrorCode Router::sendLocal(meshtastic_MeshPacket *p, RxSource src)
@@ -202,9 +314,56 @@ ErrorCode Router::sendLocal(meshtastic_MeshPacket *p, RxSource src)
  * Send a packet on a suitable interface.
  */
 ErrorCode Router::rawSend(meshtastic_MeshPacket *p)
+{
+    return sendToInterfaces(p);
+}
+
+void Router::addInterface(RadioInterface *_iface)
+{
+    assert(numInterfaces < MAX_RADIO_INTERFACES);
+    interfaces[numInterfaces++] = _iface;
+    if (!iface) {
+        iface = _iface;
+#if MESHTASTIC_COMPACT
+        LOG_INFO("Compact RAM: nodes %u, history %u, phone %u, packets %u, %u of %u bytes", compactRam::nodeDB,
+                 compactRam::packetHistory, compactRam::phoneQueues, compactRam::packetPool, compactRam::total,
+                 (uint32_t)MESHTASTIC_COMPACT_RAM_BUDGET);
+#endif
+    }
+}
+
+ErrorCode Router::sendToInterfaces(meshtastic_MeshPacket *p, meshtastic_PortNum port)
 {
     assert(iface); // This should have been detected already in sendLocal (or we just received a packet from outside)
+    RadioLockGuard guard;
+#if TX_QUEUE_DEADLINES
+    // Only our own packets that nobody waits on an ACK for, a reliable one is retried or NAKed by the router instead
+    bool deadline = port != meshtastic_PortNum_UNKNOWN_APP && isFromUs(p) && !p->want_ack;
+    NodeNum from = p->from;
+    PacketId id = p->id;
+#endif
+
+    // Each extra radio queues and times its own copy, iface takes p itself
+    for (uint8_t i = 1; i < numInterfaces; i++) {
+        if (!interfaces[i]->getLoraOverride().bridge && !isFromUs(p))
+            continue;
+        meshtastic_MeshPacket *copy = packetPool.allocCopy(*p, 0);
+        if (copy) {
+            interfaces[i]->send(copy);
+#if TX_QUEUE_DEADLINES
+            if (deadline)
+                interfaces[i]->setTxDeadline(from, id, port);
+#endif
+        }
+    }
+#if TX_QUEUE_DEADLINES
+    ErrorCode res = iface->send(p);
+    if (deadline)
+        iface->setTxDeadline(from, id, port);
+    return res;
+#else
     return iface->send(p);
+#endif
 }
 
 /**
@@ -272,7 +431,9 @@ ErrorCode Router::send(meshtastic_MeshPacket *p)
     fixPriority(p); // Before encryption, fix the priority if it's unset
 
     // If the packet is not yet encrypted, do so now
+    meshtastic_PortNum port = meshtastic_PortNum_UNKNOWN_APP;
     if (p->which_payload_variant == meshtastic_MeshPacket_decoded_tag) {
+        port = p->decoded.portnum;
         ChannelIndex chIndex = p->channel; // keep as a local because we are about to change it
         meshtastic_MeshPacket *p_decoded = packetPool.allocCopy(*p);
 
@@ -283,6 +444,14 @@ ErrorCode Router::send(meshtastic_MeshPacket *p)
             abortSendAndNak(encodeResult, p);
             return encodeResult; // FIXME - this isn't a valid ErrorCode
         }
+#if CONGESTION_AIRTIME_SCALING
+        if (isFromUs(p) && iface)
+            airTime->logPortAirtime(p_decoded->decoded.portnum, iface->getPacketTime(p));
+#endif
+#if AIRTIME_TOP_TALKERS
+        if (iface)
+            airTime->noteTalker(AirTime::TALKER_PORT, p_decoded->decoded.portnum, iface->getPacketTime(p));
+#endif
 #if !MESHTASTIC_EXCLUDE_MQTT
         // Only publish to MQTT if we're the original transmitter of the packet
         if (moduleConfig.mqtt.enabled && isFromUs(p) && mqtt) {
@@ -298,14 +467,23 @@ ErrorCode Router::send(meshtastic_MeshPacket *p)
     }
 #endif
 
-    assert(iface); // This should have been detected already in sendLocal (or we just received a packet from outside)
-    return iface->send(p);
+#if ARCH_PORTDUINO
+    if (packetCapture)
+        packetCapture->capture(p, PacketCapture::TX, port, iface ? iface->getFreq() : 0);
+#endif
+    return sendToInterfaces(p, port);
 }
 
 /** Attempt to cancel a previously sent packet.  Returns true if a packet was found we could cancel */
 bool Router::cancelSending(NodeNum from, PacketId id)
 {
-    if (iface && iface->cancelSending(from, id)) {
+    bool cancelled = false;
+    {
+        RadioLockGuard guard;
+        for (uint8_t i = 0; i < numInterfaces; i++)
+            cancelled |= interfaces[i]->cancelSending(from, id);
+    }
+    if (cancelled) {
         // We are not a relayer of this packet anymore
         removeRelayer(nodeDB->getLastByteOfNodeNum(nodeDB->getNodeNum()), id, from);
         return true;
@@ -316,7 +494,11 @@ bool Router::cancelSending(NodeNum from, PacketId id)
 /** Attempt to find a packet in the TxQueue. Returns true if the packet was found. */
 bool Router::findInTxQueue(NodeNum from, PacketId id)
 {
-    return iface->findInTxQueue(from, id);
+    RadioLockGuard guard;
+    for (uint8_t i = 0; i < numInterfaces; i++)
+        if (interfaces[i]->findInTxQueue(from, id))
+            return true;
+    return false;
 }
 
 /**
@@ -332,7 +514,7 @@ DecodeState perhapsDecode(meshtastic_MeshPacket *p)
 {
     concurrency::LockGuard g(cryptLock);
 
-    if (config.device.role == meshtastic_Config_DeviceConfig_Role_REPEATER &&
+    if (routingRole() == meshtastic_Config_DeviceConfig_Role_REPEATER &&
         config.device.rebroadcast_mode == meshtastic_Config_DeviceConfig_RebroadcastMode_ALL_SKIP_DECODING)
         return DecodeState::DECODE_FAILURE;
 
@@ -363,8 +545,7 @@ DecodeState perhapsDecode(meshtastic_MeshPacket *p)
                                       bytes)) {
             LOG_INFO("PKI Decryption worked!");
 
-            meshtastic_Data decodedtmp;
-            memset(&decodedtmp, 0, sizeof(decodedtmp));
+            meshtastic_Data decodedtmp; // pb_decode sets all fields to their defaults, no need to clear it first
             rawSize -= MESHTASTIC_PKC_OVERHEAD;
             if (pb_decode_from_bytes(bytes, rawSize, &meshtastic_Data_msg, &decodedtmp) &&
                 decodedtmp.portnum != meshtastic_PortNum_UNKNOWN_APP) {
@@ -387,8 +568,11 @@ DecodeState perhapsDecode(meshtastic_MeshPacket *p)
 
     // assert(p->which_payloadVariant == MeshPacket_encrypted_tag);
     if (!decrypted) {
-        // Try to find a channel that works with this hash
-        for (chIndex = 0; chIndex < channels.getNumChannels(); chIndex++) {
+        // Only try the channels that match this hash, the one that most recently worked first
+        ChannelIndex candidates[MAX_NUM_CHANNELS];
+        uint8_t numCandidates = channels.getCandidatesForHash(p->channel, candidates);
+        for (uint8_t c = 0; c < numCandidates; c++) {
+            chIndex = candidates[c];
             // Try to use this hash/channel pair
             if (channels.decryptForHash(chIndex, p->channel)) {
                 // we have to copy into a scratch buffer, because these bytes are a union with the decoded protobuf. Create a
@@ -400,13 +584,15 @@ DecodeState perhapsDecode(meshtastic_MeshPacket *p)
                 // printBytes("plaintext", bytes, p->encrypted.size);
 
                 // Take those raw bytes and convert them back into a well structured protobuf we can understand
-                meshtastic_Data decodedtmp;
-                memset(&decodedtmp, 0, sizeof(decodedtmp));
+                meshtastic_Data decodedtmp; // pb_decode sets all fields to their defaults, no need to clear it first
                 if (!pb_decode_from_bytes(bytes, rawSize, &meshtastic_Data_msg, &decodedtmp)) {
                     LOG_ERROR("Invalid protobufs in received mesh packet id=0x%08x (bad psk?)!", p->id);
+                    channels.noteDecodeAttempt(chIndex, false);
                 } else if (decodedtmp.portnum == meshtastic_PortNum_UNKNOWN_APP) {
                     LOG_ERROR("Invalid portnum (bad psk?)!");
+                    channels.noteDecodeAttempt(chIndex, false);
                 } else {
+                    channels.noteDecodeAttempt(chIndex, true);
                     p->decoded = decodedtmp;
                     p->which_payload_variant = meshtastic_MeshPacket_decoded_tag; // change type to decoded
                     decrypted = true;
@@ -421,25 +607,24 @@ DecodeState perhapsDecode(meshtastic_MeshPacket *p)
         if (p->decoded.has_bitfield)
             p->decoded.want_response |= p->decoded.bitfield & BITFIELD_WANT_RESPONSE_MASK;
 
-        /* Not actually ever used.
-        // Decompress if needed. jm
-        if (p->decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_COMPRESSED_APP) {
-            // Decompress the payload
-            char compressed_in[meshtastic_Constants_DATA_PAYLOAD_LEN] = {};
-            char decompressed_out[meshtastic_Constants_DATA_PAYLOAD_LEN] = {};
-            int decompressed_len;
-
-            memcpy(compressed_in, p->decoded.payload.bytes, p->decoded.payload.size);
-
-            decompressed_len = unishox2_decompress_simple(compressed_in, p->decoded.payload.size, decompressed_out);
-
-            // LOG_DEBUG("**Decompressed length - %d ", decompressed_len);
-
-            memcpy(p->decoded.payload.bytes, decompressed_out, decompressed_len);
-
-            // Switch the port from PortNum_TEXT_MESSAGE_COMPRESSED_APP to PortNum_TEXT_MESSAGE_APP
+#if TEXT_COMPRESSION
+        // Relays pass it on compressed, only the node it's for needs to read it
+        if (p->decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_COMPRESSED_APP && isToUs(p)) {
+            uint8_t text[meshtastic_Constants_DATA_PAYLOAD_LEN];
+            int len = TextCompression::decompress(p->decoded.payload.bytes, p->decoded.payload.size, text, sizeof(text));
+            if (len < 0) {
+                LOG_WARN("Can't decompress text from 0x%x", getFrom(p));
+                return DecodeState::DECODE_FAILURE;
+            }
+            memcpy(p->decoded.payload.bytes, text, len);
+            p->decoded.payload.size = len;
             p->decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
-        } */
+        }
+#endif
+#if PAYLOAD_COMPRESSION
+        if (isToUs(p) && !PayloadCompression::decompressPacket(p))
+            return DecodeState::DECODE_FAILURE;
+#endif
 
         printPacket("decoded message", p);
 #if ENABLE_JSON_LOGGING
@@ -472,42 +657,37 @@ meshtastic_Routing_Error perhapsEncode(meshtastic_MeshPacket *p)
             p->decoded.bitfield |= (p->decoded.want_response << BITFIELD_WANT_RESPONSE_SHIFT);
         }
 
-        size_t numbytes = pb_encode_to_bytes(bytes, sizeof(bytes), &meshtastic_Data_msg, &p->decoded);
-
-        /* Not actually used, so save the cycles
-        //  TODO: Allow modules to opt into compression.
-        if (p->decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_APP) {
-
-            char original_payload[meshtastic_Constants_DATA_PAYLOAD_LEN];
-            memcpy(original_payload, p->decoded.payload.bytes, p->decoded.payload.size);
-
-            char compressed_out[meshtastic_Constants_DATA_PAYLOAD_LEN] = {0};
-
-            int compressed_len;
-            compressed_len = unishox2_compress_simple(original_payload, p->decoded.payload.size, compressed_out);
-
-            LOG_DEBUG("Original length - %d ", p->decoded.payload.size);
-            LOG_DEBUG("Compressed length - %d ", compressed_len);
-            LOG_DEBUG("Original message - %s ", p->decoded.payload.bytes);
-
-            // If the compressed length is greater than or equal to the original size, don't use the compressed form
-            if (compressed_len >= p->decoded.payload.size) {
-
-                LOG_DEBUG("Not using compressing message");
-                // Set the uncompressed payload variant anyway. Shouldn't hurt?
-                // p->decoded.which_payloadVariant = Data_payload_tag;
-
-                // Otherwise we use the compressor
-            } else {
-                LOG_DEBUG("Use compressed message");
-                // Copy the compressed data into the meshpacket
-
-                p->decoded.payload.size = compressed_len;
-                memcpy(p->decoded.payload.bytes, compressed_out, compressed_len);
-
+#if TEXT_COMPRESSION
+        // Only direct messages, everyone on a channel would have to be able to read a broadcast
+        if (isFromUs(p) && p->decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_APP && !isBroadcast(p->to) &&
+            TextCompression::peerSupports(p->to)) {
+            uint8_t compressed[meshtastic_Constants_DATA_PAYLOAD_LEN];
+            size_t len = TextCompression::compress(p->decoded.payload.bytes, p->decoded.payload.size, compressed,
+                                                   sizeof(compressed));
+            if (len) {
+                LOG_DEBUG("Compressed text %u -> %u bytes", p->decoded.payload.size, len);
+                memcpy(p->decoded.payload.bytes, compressed, len);
+                p->decoded.payload.size = len;
                 p->decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_COMPRESSED_APP;
             }
-        } */
+        }
+#endif
+#if PAYLOAD_COMPRESSION
+        if (isFromUs(p) && PayloadCompression::isCompressible(p->decoded.portnum) && !isBroadcast(p->to) &&
+            !(p->decoded.bitfield & BITFIELD_PAYLOAD_COMPRESSED_MASK) && PayloadCompression::peerSupports(p->to)) {
+            uint8_t compressed[meshtastic_Constants_DATA_PAYLOAD_LEN];
+            size_t len = PayloadCompression::compress(p->decoded.payload.bytes, p->decoded.payload.size, compressed,
+                                                      sizeof(compressed));
+            if (len) {
+                LOG_DEBUG("Compressed payload %u -> %u bytes", p->decoded.payload.size, len);
+                memcpy(p->decoded.payload.bytes, compressed, len);
+                p->decoded.payload.size = len;
+                p->decoded.bitfield |= BITFIELD_PAYLOAD_COMPRESSED_MASK;
+            }
+        }
+#endif
+
+        size_t numbytes = pb_encode_to_bytes(bytes, sizeof(bytes), &meshtastic_Data_msg, &p->decoded);
 
         if (numbytes + MESHTASTIC_HEADER_LENGTH > MAX_LORA_PAYLOAD_LEN)
             return meshtastic_Routing_Error_TOO_LARGE;
@@ -575,8 +755,8 @@ meshtastic_Routing_Error perhapsEncode(meshtastic_MeshPacket *p)
                 // No suitable channel could be found for sending
                 return meshtastic_Routing_Error_NO_CHANNEL;
             }
-            crypto->encryptPacket(getFrom(p), p->id, numbytes, bytes);
-            memcpy(p->encrypted.bytes, bytes, numbytes);
+            // Straight into the packet, decoded shares its memory but is already encoded into bytes
+            crypto->encryptPacketTo(getFrom(p), p->id, numbytes, bytes, p->encrypted.bytes);
         }
 #else
         if (p->pki_encrypted == true) {
@@ -591,8 +771,7 @@ meshtastic_Routing_Error perhapsEncode(meshtastic_MeshPacket *p)
             // No suitable channel could be found for sending
             return meshtastic_Routing_Error_NO_CHANNEL;
         }
-        crypto->encryptPacket(getFrom(p), p->id, numbytes, bytes);
-        memcpy(p->encrypted.bytes, bytes, numbytes);
+        crypto->encryptPacketTo(getFrom(p), p->id, numbytes, bytes, p->encrypted.bytes);
 #endif
 
         // Copy back into the packet and set the variant type
@@ -614,14 +793,49 @@ NodeNum Router::getNodeNum()
  */
 void Router::handleReceived(meshtastic_MeshPacket *p, RxSource src)
 {
+    TRACE_SCOPE("Router::handleReceived");
+#if PACKET_AGGREGATION
+    // A carrier frame for us: handle what it holds as if we had heard each packet on its own
+    if (src == RX_SRC_RADIO && isToUs(p) && PacketAggregation::isCarrier(p)) {
+        meshtastic_MeshPacket *packets[PACKET_AGGREGATION_MAX];
+        int count = PacketAggregation::unpack(p, packets);
+        if (count >= 0) {
+            LOG_DEBUG("Unpack %d packets from carrier 0x%x", count, p->id);
+            for (int i = 0; i < count; i++)
+                enqueueReceivedMessage(packets[i]);
+            return;
+        }
+        LOG_WARN("Invalid carrier frame from 0x%x", p->from);
+    }
+#endif
+    PacketLatency::stamp(PacketLatency::RouterRx, p);
     bool skipHandle = false;
-    // Also, we should set the time from the ISR and it should have msec level resolution
-    p->rx_time = getValidTime(RTCQualityFromNet); // store the arrival timestamp for the phone
-    // Store a copy of encrypted packet for MQTT
-    meshtastic_MeshPacket *p_encrypted = packetPool.allocCopy(*p);
+    // store the arrival timestamp for the phone, unless the interface already took it when the packet arrived
+    if (!p->rx_time)
+        p->rx_time = getValidTime(RTCQualityFromNet);
+    // Keep the encrypted packet for MQTT.  Only an encrypted packet gets modified by decoding, otherwise sharing it is enough
+    meshtastic_MeshPacket *p_encrypted = NULL;
+#if !MESHTASTIC_EXCLUDE_MQTT
+    if (moduleConfig.mqtt.enabled && mqtt)
+        p_encrypted = p->which_payload_variant == meshtastic_MeshPacket_encrypted_tag ? packetPool.allocCopy(*p)
+                                                                                       : packetPool.share(p);
+#endif
+
+#if AIRTIME_TOP_TALKERS
+    // While it is still encrypted, the size is what went over the air
+    uint32_t airtimeMs = (src == RX_SRC_RADIO && iface && p->which_payload_variant == meshtastic_MeshPacket_encrypted_tag)
+                             ? iface->getPacketTime(p)
+                             : 0;
+#endif
 
     // Take those raw bytes and convert them back into a well structured protobuf we can understand
     auto decodedState = perhapsDecode(p);
+#if AIRTIME_TOP_TALKERS
+    if (airtimeMs)
+        airTime->noteTalker(AirTime::TALKER_PORT,
+                            decodedState == DecodeState::DECODE_SUCCESS ? p->decoded.portnum : meshtastic_PortNum_UNKNOWN_APP,
+                            airtimeMs);
+#endif
     if (decodedState == DecodeState::DECODE_FATAL) {
         // Fatal decoding error, we can't do anything with this packet
         LOG_WARN("Fatal decode error, dropping packet");
@@ -670,17 +884,18 @@ void Router::handleReceived(meshtastic_MeshPacket *p, RxSource src)
 #if !MESHTASTIC_EXCLUDE_MQTT
         // Mark as pki_encrypted if it is not yet decoded and MQTT encryption is also enabled, hash matches and it's a DM not to
         // us (because we would be able to decrypt it)
-        if (decodedState == DecodeState::DECODE_FAILURE && moduleConfig.mqtt.encryption_enabled && p->channel == 0x00 &&
-            !isBroadcast(p->to) && !isToUs(p))
+        if (p_encrypted && decodedState == DecodeState::DECODE_FAILURE && moduleConfig.mqtt.encryption_enabled &&
+            p->channel == 0x00 && !isBroadcast(p->to) && !isToUs(p))
             p_encrypted->pki_encrypted = true;
         // After potentially altering it, publish received message to MQTT if we're not the original transmitter of the packet
-        if ((decodedState == DecodeState::DECODE_SUCCESS || p_encrypted->pki_encrypted) && moduleConfig.mqtt.enabled &&
-            !isFromUs(p) && mqtt)
+        if (p_encrypted && (decodedState == DecodeState::DECODE_SUCCESS || p_encrypted->pki_encrypted) &&
+            moduleConfig.mqtt.enabled && !isFromUs(p) && mqtt)
             mqtt->onSend(*p_encrypted, *p, p->channel);
 #endif
     }
 
-    packetPool.release(p_encrypted); // Release the encrypted packet
+    if (p_encrypted)
+        packetPool.release(p_encrypted); // Release the encrypted packet
 }
 
 void Router::perhapsHandleReceived(meshtastic_MeshPacket *p)
@@ -695,6 +910,10 @@ void Router::perhapsHandleReceived(meshtastic_MeshPacket *p)
         p->rx_time = getValidTime(RTCQualityFromNet); // store the arrival timestamp for the phone
         LOG_TRACE("%s", MeshPacketSerializer::JsonSerializeEncrypted(p).c_str());
     }
+#endif
+#if ARCH_PORTDUINO
+    if (packetCapture)
+        packetCapture->capture(p, PacketCapture::RX, 0, iface ? iface->getFreq() : 0);
 #endif
     // assert(radioConfig.has_preferences);
     if (is_in_repeated(config.lora.ignore_incoming, p->from)) {
@@ -722,6 +941,7 @@ void Router::perhapsHandleReceived(meshtastic_MeshPacket *p)
         return;
     }
 
+    rxHeard++;
     if (shouldFilterReceived(p)) {
         LOG_DEBUG("Incoming msg was filtered from 0x%x", p->from);
         packetPool.release(p);
@@ -20,7 +20,11 @@ class Router : protected concurrency::OSThread, protected PacketHistory
     PointerQueue<meshtastic_MeshPacket> fromRadioQueue;
 
   protected:
-    RadioInterface *iface = NULL;
+    RadioInterface *iface = NULL; // The first radio, the one config.lora describes
+
+    /// Every radio, iface first
+    RadioInterface *interfaces[MAX_RADIO_INTERFACES] = {};
+    uint8_t numInterfaces = 0;
 
   public:
     /**
@@ -30,9 +34,10 @@ class Router : protected concurrency::OSThread, protected PacketHistory
     Router();
 
     /**
-     * Currently we only allow one interface, that may change in the future
+     * The first interface added is the main one.  Extra radios (see RadioInterface::setLoraOverride) get a copy of everything we
+     * send, so one node can serve two meshes or bridge them, and what they hear comes in through the same fromRadioQueue.
      */
-    void addInterface(RadioInterface *_iface) { iface = _iface; }
+    void addInterface(RadioInterface *_iface);
 
     /**
      * do idle processing
@@ -77,6 +82,9 @@ class Router : protected concurrency::OSThread, protected PacketHistory
      */
     virtual void enqueueReceivedMessage(meshtastic_MeshPacket *p);
 
+    /// Received packets waiting for runOnce()
+    int getRxQueueDepth() { return fromRadioQueue.numUsed(); }
+
     /**
      * Send a packet on a suitable interface.  This routine will
      * later free() the packet to pool.  This routine is not allowed to stall.
@@ -87,13 +95,22 @@ class Router : protected concurrency::OSThread, protected PacketHistory
     virtual ErrorCode send(meshtastic_MeshPacket *p);
     virtual ErrorCode rawSend(meshtastic_MeshPacket *p);
 
+    /// A completed traceroute showed packets for dest get through when we hand them to our neighbour via, whose link from us
+    /// has snr.  Routers that choose next hops remember it
+    virtual void learnRoute(NodeNum dest, NodeNum via, float snr) {}
+
     /* Statistics for the amount of duplicate received packets and the amount of times we cancel a relay because someone did it
-        before us */
-    uint32_t rxDupe = 0, txRelayCanceled = 0;
+        before us, all the packets we checked for duplicates, queued ACKs a reply took the place of, and broadcasts we didn't
+        relay because we relayed one from the same node on the same port recently */
+    uint32_t rxDupe = 0, txRelayCanceled = 0, rxHeard = 0, txAckPiggybacked = 0, txRelayDownsampled = 0;
 
   protected:
     friend class RoutingModule;
 
+    /// Hand p to iface, and copies of it to the extra radios that should carry it
+    /// @param port what the now encrypted p carries, if we know (see RadioInterface::setTxDeadline())
+    ErrorCode sendToInterfaces(meshtastic_MeshPacket *p, meshtastic_PortNum port = meshtastic_PortNum_UNKNOWN_APP);
+
     /**
      * Should this incoming filter be dropped?
      *
@@ -159,7 +176,28 @@ extern Router *router;
 // FIXME, move this someplace better
 PacketId generatePacketId();
 
+/**
+ * Data.bitfield bits 2 to 5 and 7 are flags of our own.  The protobufs don't reserve them, so firmware that gives any of them
+ * another meaning would misread our packets, and we theirs.  Every feature that sets or reads them (TEXT_COMPRESSION,
+ * PAYLOAD_COMPRESSION, PACKET_AGGREGATION, and the AIRTIME_SERIES and OSTHREAD_PROFILE admin answers) needs
+ * PRIVATE_BITFIELD_FLAGS.  Setting it BREAKS WIRE COMPATIBILITY with other firmware: only use it on a mesh (and with clients)
+ * built to the same flags.  Without it the bits are never set, and ignored when received.
+ */
+#ifndef PRIVATE_BITFIELD_FLAGS
+#define PRIVATE_BITFIELD_FLAGS 0
+#endif
+
+#define BITFIELD_ADMIN_RAW_ANSWER_SHIFT 7    // on ADMIN_APP, the payload is the raw answer to a private request (AdminModule.h)
+#define BITFIELD_AGGREGATION_SHIFT 5         // on NodeInfo, the sender can unpack PacketAggregation carrier frames
+#define BITFIELD_PAYLOAD_COMPRESSED_SHIFT 4  // the payload is PayloadCompression compressed
+#define BITFIELD_PAYLOAD_COMPRESSION_SHIFT 3 // on NodeInfo, the sender can decompress PayloadCompression
+#define BITFIELD_TEXT_COMPRESSION_SHIFT 2    // on NodeInfo, the sender can decompress TextCompression
 #define BITFIELD_WANT_RESPONSE_SHIFT 1
 #define BITFIELD_OK_TO_MQTT_SHIFT 0
+#define BITFIELD_ADMIN_RAW_ANSWER_MASK (1 << BITFIELD_ADMIN_RAW_ANSWER_SHIFT)
+#define BITFIELD_AGGREGATION_MASK (1 << BITFIELD_AGGREGATION_SHIFT)
+#define BITFIELD_PAYLOAD_COMPRESSED_MASK (1 << BITFIELD_PAYLOAD_COMPRESSED_SHIFT)
+#define BITFIELD_PAYLOAD_COMPRESSION_MASK (1 << BITFIELD_PAYLOAD_COMPRESSION_SHIFT)
+#define BITFIELD_TEXT_COMPRESSION_MASK (1 << BITFIELD_TEXT_COMPRESSION_SHIFT)
 #define BITFIELD_WANT_RESPONSE_MASK (1 << BITFIELD_WANT_RESPONSE_SHIFT)
 #define BITFIELD_OK_TO_MQTT_MASK (1 << BITFIELD_OK_TO_MQTT_SHIFT)
\ No newline at end of file
@@ -274,7 +274,7 @@ template <typename T> void SX126xInterface<T>::startReceive()
     setStandby();
 
     // We use a 16 bit preamble so this should save some power by letting radio sit in standby mostly.
-    int err = lora.startReceiveDutyCycleAuto(preambleLength, 8, MESHTASTIC_RADIOLIB_IRQ_RX_FLAGS);
+    int err = lora.startReceiveDutyCycleAuto(preambleLength, rxDutyCycleMinSymbols, MESHTASTIC_RADIOLIB_IRQ_RX_FLAGS);
     if (err != RADIOLIB_ERR_NONE)
         LOG_ERROR("SX126X startReceiveDutyCycleAuto %s%d", radioLibErr, err);
     assert(err == RADIOLIB_ERR_NONE);
@@ -282,10 +282,24 @@ template <typename T> void SX126xInterface<T>::startReceive()
     RadioLibInterface::startReceive();
 
     // Must be done AFTER, starting transmit, because startTransmit clears (possibly stale) interrupt pending register bits
-    enableInterrupt(isrRxLevel0);
+    enableInterrupt(rxIsr());
 #endif
 }
 
+/** The periods startReceiveDutyCycleAuto() picks, it falls back to receiving continuously when there is no time to sleep */
+template <typename T> float SX126xInterface<T>::getRxDutyCycle()
+{
+    uint32_t symbolUs = ((uint32_t)(10 * 1000) << sf) / (10 * bw);
+    if (2 * rxDutyCycleMinSymbols >= preambleLength)
+        return 1;
+    uint32_t sleepUs = symbolUs * (preambleLength - 2 * rxDutyCycleMinSymbols);
+    uint32_t tcxoDelayUs = tcxoVoltage > 0 ? 5000 : 0; // what RadioLib allows a TCXO to start
+    if (sleepUs < tcxoDelayUs + 1016)
+        return 1;
+    uint32_t wakeUs = max((symbolUs * (preambleLength + 1) - (sleepUs - 1000)) / 2, symbolUs * (rxDutyCycleMinSymbols + 1));
+    return (float)wakeUs / (wakeUs + sleepUs);
+}
+
 /** Is the channel currently active? */
 template <typename T> bool SX126xInterface<T>::isChannelActive()
 {
@@ -28,6 +28,8 @@ template <class T> class SX126xInterface : public RadioLibInterface
 
     bool isIRQPending() override { return lora.getIrqFlags() != 0; }
 
+    virtual float getRxDutyCycle() override;
+
     void setTCXOVoltage(float voltage) { tcxoVoltage = voltage; }
 
   protected:
@@ -64,11 +64,21 @@ template <typename T> bool SX128xInterface<T>::init()
 
     limitPower(SX128X_MAX_POWER);
 
+#if SX128X_MODEM == SX128X_MODEM_FLRC
+    preambleLength = 32; // in bits outside LoRa, the longest the chip takes
+    int res = lora.beginFLRC(getFreq(), SX128X_FLRC_BITRATE, SX128X_FLRC_CR, power, preambleLength);
+    LOG_INFO("SX128x FLRC init result %d, %d kbps", res, SX128X_FLRC_BITRATE);
+#elif SX128X_MODEM == SX128X_MODEM_GFSK
+    preambleLength = 32;
+    int res = lora.beginGFSK(getFreq(), SX128X_GFSK_BITRATE, SX128X_GFSK_FREQ_DEV, power, preambleLength);
+    LOG_INFO("SX128x GFSK init result %d, %d kbps", res, SX128X_GFSK_BITRATE);
+#else
     preambleLength = 12; // 12 is the default for this chip, 32 does not RX at all
 
     int res = lora.begin(getFreq(), bw, sf, cr, syncWord, power, preambleLength);
     // \todo Display actual typename of the adapter, not just `SX128x`
     LOG_INFO("SX128x init result %d", res);
+#endif
 
     if ((config.lora.region != meshtastic_Config_LoRaConfig_RegionCode_LORA_24) && (res == RADIOLIB_ERR_INVALID_FREQUENCY)) {
         LOG_WARN("Radio only supports 2.4GHz LoRa. Adjusting Region and rebooting");
@@ -114,6 +124,25 @@ template <typename T> bool SX128xInterface<T>::reconfigure()
     // set mode to standby
     setStandby();
 
+#if SX128X_MODEM == SX128X_MODEM_FLRC
+    // The modem preset's spreading factor and bandwidth mean nothing to FLRC, and its sync word is 4 bytes, so the chip's
+    // default stays
+    int err = lora.setBitRate(SX128X_FLRC_BITRATE);
+    if (err != RADIOLIB_ERR_NONE)
+        RECORD_CRITICALERROR(meshtastic_CriticalErrorCode_INVALID_RADIO_SETTING);
+
+    err = lora.setCodingRate(SX128X_FLRC_CR);
+    if (err != RADIOLIB_ERR_NONE)
+        RECORD_CRITICALERROR(meshtastic_CriticalErrorCode_INVALID_RADIO_SETTING);
+#elif SX128X_MODEM == SX128X_MODEM_GFSK
+    int err = lora.setBitRate(SX128X_GFSK_BITRATE);
+    if (err != RADIOLIB_ERR_NONE)
+        RECORD_CRITICALERROR(meshtastic_CriticalErrorCode_INVALID_RADIO_SETTING);
+
+    err = lora.setFrequencyDeviation(SX128X_GFSK_FREQ_DEV);
+    if (err != RADIOLIB_ERR_NONE)
+        RECORD_CRITICALERROR(meshtastic_CriticalErrorCode_INVALID_RADIO_SETTING);
+#else
     // configure publicly accessible settings
     int err = lora.setSpreadingFactor(sf);
     if (err != RADIOLIB_ERR_NONE)
@@ -131,6 +160,7 @@ template <typename T> bool SX128xInterface<T>::reconfigure()
     if (err != RADIOLIB_ERR_NONE)
         LOG_ERROR("SX128X setSyncWord %s%d", radioLibErr, err);
     assert(err == RADIOLIB_ERR_NONE);
+#endif
 
     err = lora.setPreambleLength(preambleLength);
     if (err != RADIOLIB_ERR_NONE)
@@ -266,13 +296,17 @@ template <typename T> void SX128xInterface<T>::startReceive()
     RadioLibInterface::startReceive();
 
     // Must be done AFTER, starting transmit, because startTransmit clears (possibly stale) interrupt pending register bits
-    enableInterrupt(isrRxLevel0);
+    enableInterrupt(rxIsr());
 #endif
 }
 
 /** Is the channel currently active? */
 template <typename T> bool SX128xInterface<T>::isChannelActive()
 {
+#if SX128X_MODEM != SX128X_MODEM_LORA
+    // CAD only finds LoRa preambles.  canSendImmediately() has already checked no frame is coming in, which is all we can know
+    return false;
+#else
     // check if we can detect a LoRa preamble on the current channel
     ChannelScanConfig_t cfg = {.cad = {.symNum = NUM_SYM_CAD_24GHZ,
                                        .detPeak = 0,
@@ -292,14 +326,44 @@ template <typename T> bool SX128xInterface<T>::isChannelActive()
     assert(result != RADIOLIB_ERR_WRONG_MODEM);
 
     return false;
+#endif
 }
 
 /** Could we send right now (i.e. either not actively receiving or transmitting)? */
 template <typename T> bool SX128xInterface<T>::isActivelyReceiving()
 {
+#if SX128X_MODEM != SX128X_MODEM_LORA
+    // No header IRQ outside LoRa, a valid sync word is the sign of a real frame
+    return receiveDetected(lora.getIrqStatus(), RADIOLIB_SX128X_IRQ_SYNC_WORD_VALID, RADIOLIB_SX128X_IRQ_PREAMBLE_DETECTED);
+#else
     return receiveDetected(lora.getIrqStatus(), RADIOLIB_SX128X_IRQ_HEADER_VALID, RADIOLIB_SX128X_IRQ_PREAMBLE_DETECTED);
+#endif
+}
+
+#if SX128X_MODEM != SX128X_MODEM_LORA
+template <typename T> uint32_t SX128xInterface<T>::computePacketTime(uint32_t pl)
+{
+    // Preamble (preambleLength is in bits here), 32 bit sync word and the 16 bit variable length header, then the payload
+    // and its 16 bit CRC
+    float bits = preambleLength + 32 + 16;
+#if SX128X_MODEM == SX128X_MODEM_FLRC
+    const float codeRate[] = {2.0f, 4.0f / 3.0f, 1.0f}; // SX128X_FLRC_CR 2, 3, 4
+    bits += (8.0f * (pl + 2) + (SX128X_FLRC_CR < 4 ? 6 : 0)) * codeRate[SX128X_FLRC_CR - 2]; // 6 tail bits when coded
+    float bitsPerMsec = SX128X_FLRC_BITRATE;
+#else
+    bits += 8.0f * (pl + 2);
+    float bitsPerMsec = SX128X_GFSK_BITRATE;
+#endif
+    // Our timers count whole msec, a frame never takes none
+    return max(1.0f, ceilf(bits / bitsPerMsec));
 }
 
+template <typename T> uint32_t SX128xInterface<T>::computeSlotTimeMsec()
+{
+    return 0.2 + 0.4 + 7; // propagation, turnaround and MAC processing as in RadioInterface::computeSlotTimeMsec()
+}
+#endif
+
 template <typename T> bool SX128xInterface<T>::sleep()
 {
     // Not keeping config is busted - next time nrf52 board boots lora sending fails  tcxo related? - see datasheet
@@ -2,6 +2,35 @@
 
 #include "RadioLibInterface.h"
 
+/// Modems the SX1280 can run.  Only LoRa meshes with other nodes, FLRC and GFSK are for fast point to point links (a backbone
+/// between 2.4 GHz gateways) where every node is built with the same SX128X_MODEM
+#define SX128X_MODEM_LORA 0
+#define SX128X_MODEM_FLRC 1 // up to 1.3 Mbps and the better sensitivity, but frames of at most 127 bytes
+#define SX128X_MODEM_GFSK 2 // up to 2 Mbps, full size frames
+#ifndef SX128X_MODEM
+#define SX128X_MODEM SX128X_MODEM_LORA
+#endif
+
+/// FLRC bit rate in kbps: 260, 325, 520, 650, 1000 or 1300
+#ifndef SX128X_FLRC_BITRATE
+#define SX128X_FLRC_BITRATE 1300
+#endif
+
+/// FLRC coding rate: 2 for 1/2, 3 for 3/4 or 4 for uncoded
+#ifndef SX128X_FLRC_CR
+#define SX128X_FLRC_CR 3
+#endif
+
+/// GFSK bit rate in kbps: 125, 250, 400, 500, 800, 1000, 1600 or 2000
+#ifndef SX128X_GFSK_BITRATE
+#define SX128X_GFSK_BITRATE 1000
+#endif
+
+/// GFSK frequency deviation in kHz, about half the bit rate
+#ifndef SX128X_GFSK_FREQ_DEV
+#define SX128X_GFSK_FREQ_DEV 500
+#endif
+
 /**
  * \brief Adapter for SX128x radio family. Implements common logic for child classes.
  * \tparam T RadioLib module type for SX128x: SX1280.
@@ -67,4 +96,12 @@ template <class T> class SX128xInterface : public RadioLibInterface
     virtual void addReceiveMetadata(meshtastic_MeshPacket *mp) override;
 
     virtual void setStandby() override;
+
+#if SX128X_MODEM != SX128X_MODEM_LORA
+    /// Airtime of a FLRC or GFSK frame, from its bit rate instead of LoRa symbols
+    virtual uint32_t computePacketTime(uint32_t pl) override;
+
+    /// No CAD to wait for outside LoRa, a slot is only the turnaround and processing time
+    virtual uint32_t computeSlotTimeMsec() override;
+#endif
 };
@@ -0,0 +1,63 @@
+#include "SaveScheduler.h"
+#include "NodeDB.h"
+#include "sleep.h"
+
+SaveScheduler::SaveScheduler(NodeDB &_db) : concurrency::OSThread("SaveScheduler"), db(_db)
+{
+    rebootObserver.observe(&notifyReboot);
+    disable(); // Nothing to do until the first request
+}
+
+void SaveScheduler::request(int saveWhat)
+{
+    uint32_t now = millis();
+    if (!pending) {
+        // Only schedule for the first change of a burst, runOnce() works out when the burst has ended. Rescheduling on
+        // every request would let a steady trickle of changes put the save off forever.
+        firstRequestMs = now;
+        enabled = true;
+        setIntervalFromNow(SAVE_QUIET_MS);
+    }
+    pending |= saveWhat;
+    lastRequestMs = now;
+    requestsSinceFlush++;
+    requestCount++;
+}
+
+int32_t SaveScheduler::runOnce()
+{
+    if (!pending) // Someone saved it all already
+        return disable();
+
+    uint32_t now = millis();
+    uint32_t quietFor = now - lastRequestMs;
+    uint32_t waited = now - firstRequestMs;
+    if (quietFor < SAVE_QUIET_MS && waited < SAVE_MAX_DELAY_MS)
+        return min(SAVE_QUIET_MS - quietFor, SAVE_MAX_DELAY_MS - waited);
+
+    flush();
+    return disable();
+}
+
+bool SaveScheduler::flush()
+{
+    if (!pending)
+        return true;
+
+    int saveWhat = pending;
+    uint32_t requests = requestsSinceFlush;
+    uint32_t bytesBefore = db.getBytesSaved();
+    uint32_t start = millis();
+
+    bool okay = db.saveToDisk(saveWhat); // also clears pending
+
+    uint32_t took = millis() - start;
+    uint32_t bytes = db.getBytesSaved() - bytesBefore;
+    requestsSinceFlush = 0;
+    flushCount++;
+    bytesWritten += bytes;
+    msSpent += took;
+    LOG_INFO("Saved segments 0x%x for %u requests, %u bytes in %u ms (since boot: %u saves, %u requests, %u bytes, %u ms)",
+             saveWhat, requests, bytes, took, flushCount, requestCount, bytesWritten, msSpent);
+    return okay;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Observer.h"
+#include "concurrency/OSThread.h"
+#include "configuration.h"
+
+class NodeDB;
+
+/// How long saveToDiskSoon() waits for further changes before writing
+#ifndef SAVE_QUIET_MS
+#define SAVE_QUIET_MS (5 * 1000)
+#endif
+
+/// The longest a change is held back, even if more keep arriving
+#ifndef SAVE_MAX_DELAY_MS
+#define SAVE_MAX_DELAY_MS (30 * 1000)
+#endif
+
+/**
+ * Coalesces NodeDB saves.
+ *
+ * Segments passed to request() are marked dirty and written together once no further request has arrived for SAVE_QUIET_MS
+ * (or SAVE_MAX_DELAY_MS after the first one), so a client pushing a dozen config changes costs one save instead of a dozen.
+ * Anything still pending is written before a reboot; deep sleep already saves everything through NodeDB::saveToDisk(),
+ * which clears the pending bits for whatever it writes.
+ *
+ * NOTE: changes made inside the quiet window are lost if power is cut before it ends.
+ */
+class SaveScheduler : private concurrency::OSThread
+{
+  public:
+    explicit SaveScheduler(NodeDB &db);
+
+    /// Mark these segments (SEGMENT_* bits) dirty and (re)start the quiet period
+    void request(int saveWhat);
+
+    /// Write anything pending right away
+    /// @return false if the save failed
+    bool flush();
+
+    /// Called by NodeDB::saveToDisk(), these segments no longer need writing
+    void saved(int saveWhat) { pending &= ~saveWhat; }
+
+    int getPending() const { return pending; }
+
+    // Totals since boot
+    uint32_t getFlushCount() const { return flushCount; }
+    uint32_t getRequestCount() const { return requestCount; }
+    uint32_t getBytesWritten() const { return bytesWritten; }
+    uint32_t getMsSpent() const { return msSpent; }
+
+  protected:
+    virtual int32_t runOnce() override;
+
+  private:
+    NodeDB &db;
+    int pending = 0;                  // SEGMENT_* bits waiting to be written
+    uint32_t firstRequestMs = 0;      // when the oldest pending change was requested
+    uint32_t lastRequestMs = 0;       // when the newest one was
+    uint32_t requestsSinceFlush = 0;  // how many requests the next flush covers
+    uint32_t flushCount = 0, requestCount = 0, bytesWritten = 0, msSpent = 0;
+
+    int onReboot(void *unused)
+    {
+        flush();
+        return 0;
+    }
+    CallbackObserver<SaveScheduler, void *> rebootObserver =
+        CallbackObserver<SaveScheduler, void *>(this, &SaveScheduler::onReboot);
+};
@@ -22,58 +22,82 @@ int32_t StreamAPI::runOncePart()
 int32_t StreamAPI::readStream()
 {
     if (!stream->available()) {
-        // Nothing available this time, if the computer has talked to us recently, poll often, otherwise let CPU sleep a long time
-        bool recentRx = Throttle::isWithinTimespanMs(lastRxMsec, 2000);
-        return recentRx ? 5 : 250;
+        // Nothing available this time, if the computer has talked to us recently, poll often, otherwise back off gradually so
+        // the CPU can sleep
+        if (Throttle::isWithinTimespanMs(lastRxMsec, 2000))
+            pollIntervalMsec = STREAM_POLL_MIN_MSEC;
+        else if (pollIntervalMsec < STREAM_POLL_MAX_MSEC)
+            pollIntervalMsec = min(pollIntervalMsec * 2, (uint32_t)STREAM_POLL_MAX_MSEC);
+        return pollIntervalMsec;
     } else {
-        while (stream->available()) { // Currently we never want to block
-            int cInt = stream->read();
-            if (cInt < 0)
+        int avail;
+        while ((avail = stream->available()) > 0) { // Currently we never want to block
+            size_t want = min((size_t)avail, sizeof(rxBuf) - rxPtr);
+            size_t got = stream->readBytes(rxBuf + rxPtr, want);
+            if (got == 0)
                 break; // We ran out of characters (even though available said otherwise) - this can happen on rf52 adafruit
                        // arduino
 
-            uint8_t c = (uint8_t)cInt;
-
-            // Use the read pointer for a little state machine, first look for framing, then length bytes, then payload
-            size_t ptr = rxPtr;
-
-            rxPtr++;        // assume we will probably advance the rxPtr
-            rxBuf[ptr] = c; // store all bytes (including framing)
-
-            // console->printf("rxPtr %d ptr=%d c=0x%x\n", rxPtr, ptr, c);
+            rxPtr += got;
+            parseRxBuf();
+        }
 
-            if (ptr == 0) { // looking for START1
-                if (c != START1)
-                    rxPtr = 0;     // failed to find framing
-            } else if (ptr == 1) { // looking for START2
-                if (c != START2)
-                    rxPtr = 0;                             // failed to find framing
-            } else if (ptr >= HEADER_LEN - 1) {            // we have at least read our 4 byte framing
-                uint32_t len = (rxBuf[2] << 8) + rxBuf[3]; // big endian 16 bit length follows framing
+        // we had bytes available this time, so assume we might have them next time also
+        lastRxMsec = millis();
+        pollIntervalMsec = STREAM_POLL_MIN_MSEC;
+        return 0;
+    }
+}
 
-                // console->printf("len %d\n", len);
+/**
+ * Hand every complete frame in rxBuf to handleToRadio, then move any partial frame to the start of the buffer
+ */
+void StreamAPI::parseRxBuf()
+{
+    size_t pos = handleFrames(this, rxBuf, rxPtr);
 
-                if (ptr == HEADER_LEN - 1) {
-                    // we _just_ finished our 4 byte header, validate length now (note: a length of zero is a valid
-                    // protobuf also)
-                    if (len > MAX_TO_FROM_RADIO_SIZE)
-                        rxPtr = 0; // length is bogus, restart search for framing
-                }
+    // A partial frame is at most MAX_STREAM_BUF_SIZE, so after this there is always room to read the rest of it
+    if (pos) {
+        rxPtr -= pos;
+        memmove(rxBuf, rxBuf + pos, rxPtr);
+    }
+}
 
-                if (rxPtr != 0)                        // Is packet still considered 'good'?
-                    if (ptr + 1 >= len + HEADER_LEN) { // have we received all of the payload?
-                        rxPtr = 0;                     // start over again on the next packet
+size_t StreamAPI::handleFrames(PhoneAPI *api, const uint8_t *buf, size_t len)
+{
+    size_t pos = 0;
+    while (pos < len) {
+        // Skip anything that can't be the start of a frame (i.e. debug output)
+        if (buf[pos] != START1) {
+            const uint8_t *start = (const uint8_t *)memchr(buf + pos, START1, len - pos);
+            if (!start)
+                return len;
+            pos = start - buf;
+        }
 
-                        // If we didn't just fail the packet and we now have the right # of bytes, parse it
-                        handleToRadio(rxBuf + HEADER_LEN, len);
-                    }
-            }
+        size_t remaining = len - pos;
+        if (remaining < 2)
+            break; // need more bytes
+        if (buf[pos + 1] != START2) {
+            pos++; // failed to find framing
+            continue;
+        }
+        if (remaining < HEADER_LEN)
+            break;
+
+        uint32_t frameLen = (buf[pos + 2] << 8) + buf[pos + 3]; // big endian 16 bit length follows framing
+        // note: a length of zero is a valid protobuf also
+        if (frameLen > MAX_TO_FROM_RADIO_SIZE) {
+            pos++; // length is bogus, restart search for framing
+            continue;
         }
+        if (remaining < HEADER_LEN + frameLen)
+            break; // have not received all of the payload yet
 
-        // we had bytes available this time, so assume we might have them next time also
-        lastRxMsec = millis();
-        return 0;
+        api->handleToRadio(buf + pos + HEADER_LEN, frameLen);
+        pos += HEADER_LEN + frameLen;
     }
+    return pos;
 }
 
 /**
@@ -82,25 +106,38 @@ int32_t StreamAPI::readStream()
 void StreamAPI::writeStream()
 {
     if (canWrite) {
-        uint32_t len;
+        size_t len;
         do {
-            // Send every packet we can
-            len = getFromRadio(txBuf + HEADER_LEN);
-            emitTxBuffer(len);
+            // Send every packet we can, as many per write as fit (this is what makes downloading a big NodeDB quick)
+            len = fillTxBatch();
+            if (len) {
+                stream->write(txBatch, len);
+                stream->flush();
+            }
         } while (len);
     }
 }
 
+size_t StreamAPI::fillTxBatch()
+{
+    return getFromRadioBatch(txBatch, sizeof(txBatch), HEADER_LEN, writeFrameHeader);
+}
+
+void StreamAPI::writeFrameHeader(uint8_t *header, size_t len)
+{
+    header[0] = START1;
+    header[1] = START2;
+    header[2] = (len >> 8) & 0xff;
+    header[3] = len & 0xff;
+}
+
 /**
  * Send the current txBuffer over our stream
  */
 void StreamAPI::emitTxBuffer(size_t len)
 {
     if (len != 0) {
-        txBuf[0] = START1;
-        txBuf[1] = START2;
-        txBuf[2] = (len >> 8) & 0xff;
-        txBuf[3] = len & 0xff;
+        writeFrameHeader(txBuf, len);
 
         auto totalLen = len + HEADER_LEN;
         stream->write(txBuf, totalLen);
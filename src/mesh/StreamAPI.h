@@ -8,6 +8,19 @@
 // A To/FromRadio packet + our 32 bit header
 #define MAX_STREAM_BUF_SIZE (MAX_TO_FROM_RADIO_SIZE + sizeof(uint32_t))
 
+/// How many bytes of framed FromRadio packets writeStream() collects before writing them out in one go, at least one packet
+#ifndef STREAM_TX_BATCH_SIZE
+#define STREAM_TX_BATCH_SIZE (2 * MAX_STREAM_BUF_SIZE)
+#endif
+
+/// readStream() polls this often while a client is talking to us, and backs off to STREAM_POLL_MAX_MSEC while it is quiet
+#ifndef STREAM_POLL_MIN_MSEC
+#define STREAM_POLL_MIN_MSEC 5
+#endif
+#ifndef STREAM_POLL_MAX_MSEC
+#define STREAM_POLL_MAX_MSEC 250
+#endif
+
 /**
  * A version of our 'phone' API that talks over a Stream.  So therefore well suited to use with serial links
  * or TCP connections.
@@ -42,9 +55,22 @@ class StreamAPI : public PhoneAPI
     /// time of last rx, used, to slow down our polling if we haven't heard from anyone
     uint32_t lastRxMsec = 0;
 
+    /// current idle poll interval, see STREAM_POLL_MIN_MSEC
+    uint32_t pollIntervalMsec = STREAM_POLL_MIN_MSEC;
+
   public:
     StreamAPI(Stream *_stream) : stream(_stream) {}
 
+    /// Fill in the 4 byte framing for a packet of len bytes
+    static void writeFrameHeader(uint8_t *header, size_t len);
+
+    /**
+     * Give every complete frame in buf to api->handleToRadio, skipping whatever is between frames.  Also used by the HTTP API for
+     * batched PUTs.
+     * @return how many bytes were used, anything after that is the start of a frame still waiting for the rest of its bytes
+     */
+    static size_t handleFrames(PhoneAPI *api, const uint8_t *buf, size_t len);
+
     /**
      * Currently we require frequent invocation from loop() to check for arrived serial packets and to send new packets to the
      * phone.
@@ -57,12 +83,22 @@ class StreamAPI : public PhoneAPI
      */
     int32_t readStream();
 
+    /// Handle the complete frames in rxBuf, keeping any partial frame for next time
+    void parseRxBuf();
+
+  protected:
     /**
      * call getFromRadio() and deliver encapsulated packets to the Stream
      */
-    void writeStream();
+    virtual void writeStream();
+
+    /// Packets for the phone, collected by writeStream().  Separate from txBuf because log records can be emitted while we fill it
+    uint8_t txBatch[STREAM_TX_BATCH_SIZE];
+
+    /// Fill txBatch with as many framed FromRadio packets as fit
+    /// @return the number of bytes used, 0 if there was nothing to send
+    size_t fillTxBatch();
 
-  protected:
     /**
      * Send a FromRadio.rebooted = true packet to the phone
      */
@@ -0,0 +1,38 @@
+#include "TextCompression.h"
+#include "NodeDB.h"
+#include "compression/unishox2.h"
+
+// Frequent sequences for short chat messages, in place of unishox2's USX_FREQ_SEQ_TXT which is tuned for prose.  Changing
+// these breaks compatibility with every node already advertising BITFIELD_TEXT_COMPRESSION.
+static const char *meshFreqSeq[] = {" the ", " you", "ing", " at ", " is ", " to "};
+
+#define MESH_PSET USX_HCODES_DFLT, USX_HCODE_LENS_DFLT, meshFreqSeq, USX_TEMPLATES
+
+size_t TextCompression::compress(const uint8_t *in, size_t len, uint8_t *out, size_t outSize)
+{
+    int n = unishox2_compress((const char *)in, len, (char *)out, outSize, MESH_PSET);
+    return (n > 0 && (size_t)n < len && (size_t)n <= outSize) ? n : 0;
+}
+
+int TextCompression::decompress(const uint8_t *in, size_t len, uint8_t *out, size_t outSize)
+{
+    int n = unishox2_decompress((const char *)in, len, (char *)out, outSize, MESH_PSET);
+    return (n >= 0 && (size_t)n <= outSize) ? n : -1;
+}
+
+bool TextCompression::peerSupports(NodeNum n)
+{
+    const meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(n);
+    return node && (node->bitfield & NODEINFO_BITFIELD_TEXT_COMPRESSION_MASK);
+}
+
+void TextCompression::setPeerSupports(NodeNum n, bool supported)
+{
+    meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(n);
+    if (!node)
+        return;
+    if (supported)
+        node->bitfield |= NODEINFO_BITFIELD_TEXT_COMPRESSION_MASK;
+    else
+        node->bitfield &= ~NODEINFO_BITFIELD_TEXT_COMPRESSION_MASK;
+}
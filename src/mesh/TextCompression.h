@@ -0,0 +1,34 @@
+#pragma once
+
+#include "MeshTypes.h"
+
+/// Set to 1 to send text messages to nodes that can take them as TEXT_MESSAGE_COMPRESSED_APP, and to accept them
+#ifndef TEXT_COMPRESSION
+#define TEXT_COMPRESSION 0
+#endif
+#if TEXT_COMPRESSION && !PRIVATE_BITFIELD_FLAGS
+#error "TEXT_COMPRESSION uses a private Data.bitfield flag and needs PRIVATE_BITFIELD_FLAGS, see Router.h"
+#endif
+
+/**
+ * unishox2 compression of text messages, with frequent sequences picked for short mesh chat rather than prose.
+ *
+ * Both ends must use the same sequences, so nodes say they can decompress with BITFIELD_TEXT_COMPRESSION in the Data of their
+ * NodeInfo, and we only compress direct messages to nodes that have said so.  Relays pass the packet on as it came, and the
+ * destination turns it back into TEXT_MESSAGE_APP before modules and the phone see it.
+ */
+class TextCompression
+{
+  public:
+    /// @return the compressed length, or 0 if compressing wouldn't make it shorter
+    static size_t compress(const uint8_t *in, size_t len, uint8_t *out, size_t outSize);
+
+    /// @return the decompressed length, or -1 if in isn't valid compressed text or doesn't fit
+    static int decompress(const uint8_t *in, size_t len, uint8_t *out, size_t outSize);
+
+    /// Whether node n has told us it can take compressed text
+    static bool peerSupports(NodeNum n);
+
+    /// Remember what node n's NodeInfo said
+    static void setPeerSupports(NodeNum n, bool supported);
+};
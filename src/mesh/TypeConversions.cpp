@@ -5,47 +5,38 @@
 meshtastic_NodeInfo TypeConversions::ConvertToNodeInfo(const meshtastic_NodeInfoLite *lite)
 {
     meshtastic_NodeInfo info = meshtastic_NodeInfo_init_default;
+    ConvertToNodeInfo(lite, &info);
+    return info;
+}
 
-    info.num = lite->num;
-    info.snr = lite->snr;
-    info.last_heard = lite->last_heard;
-    info.channel = lite->channel;
-    info.via_mqtt = lite->via_mqtt;
-    info.is_favorite = lite->is_favorite;
-    info.is_ignored = lite->is_ignored;
-    info.is_key_manually_verified = lite->bitfield & NODEINFO_BITFIELD_IS_KEY_MANUALLY_VERIFIED_MASK;
+void TypeConversions::ConvertToNodeInfo(const meshtastic_NodeInfoLite *lite, meshtastic_NodeInfo *info)
+{
+    info->num = lite->num;
+    info->snr = lite->snr;
+    info->last_heard = lite->last_heard;
+    info->channel = lite->channel;
+    info->via_mqtt = lite->via_mqtt;
+    info->is_favorite = lite->is_favorite;
+    info->is_ignored = lite->is_ignored;
+    info->is_key_manually_verified = lite->bitfield & NODEINFO_BITFIELD_IS_KEY_MANUALLY_VERIFIED_MASK;
 
-    if (lite->has_hops_away) {
-        info.has_hops_away = true;
-        info.hops_away = lite->hops_away;
-    }
+    info->has_hops_away = lite->has_hops_away;
+    info->hops_away = lite->has_hops_away ? lite->hops_away : 0;
 
-    if (lite->has_position) {
-        info.has_position = true;
-        if (lite->position.latitude_i != 0)
-            info.position.has_latitude_i = true;
-        info.position.latitude_i = lite->position.latitude_i;
-        if (lite->position.longitude_i != 0)
-            info.position.has_longitude_i = true;
-        info.position.longitude_i = lite->position.longitude_i;
-        if (lite->position.altitude != 0)
-            info.position.has_altitude = true;
-        info.position.altitude = lite->position.altitude;
-        info.position.location_source = lite->position.location_source;
-        info.position.time = lite->position.time;
-    }
-    if (lite->has_user) {
-        info.has_user = true;
-        info.user = ConvertToUser(lite->num, lite->user);
-    }
-    if (lite->has_device_metrics) {
-        info.has_device_metrics = true;
-        info.device_metrics = lite->device_metrics;
-    }
-    return info;
+    info->has_position = lite->has_position;
+    if (lite->has_position)
+        ConvertToPosition(lite->position, &info->position);
+
+    info->has_user = lite->has_user;
+    if (lite->has_user)
+        ConvertToUser(lite->num, lite->user, &info->user);
+
+    info->has_device_metrics = lite->has_device_metrics;
+    if (lite->has_device_metrics)
+        info->device_metrics = lite->device_metrics;
 }
 
-meshtastic_PositionLite TypeConversions::ConvertToPositionLite(meshtastic_Position position)
+meshtastic_PositionLite TypeConversions::ConvertToPositionLite(const meshtastic_Position &position)
 {
     meshtastic_PositionLite lite = meshtastic_PositionLite_init_default;
     lite.latitude_i = position.latitude_i;
@@ -57,25 +48,28 @@ meshtastic_PositionLite TypeConversions::ConvertToPositionLite(meshtastic_Positi
     return lite;
 }
 
-meshtastic_Position TypeConversions::ConvertToPosition(meshtastic_PositionLite lite)
+meshtastic_Position TypeConversions::ConvertToPosition(const meshtastic_PositionLite &lite)
 {
-    meshtastic_Position position = meshtastic_Position_init_default;
-    if (lite.latitude_i != 0)
-        position.has_latitude_i = true;
-    position.latitude_i = lite.latitude_i;
-    if (lite.longitude_i != 0)
-        position.has_longitude_i = true;
-    position.longitude_i = lite.longitude_i;
-    if (lite.altitude != 0)
-        position.has_altitude = true;
-    position.altitude = lite.altitude;
-    position.location_source = lite.location_source;
-    position.time = lite.time;
-
+    meshtastic_Position position;
+    ConvertToPosition(lite, &position);
     return position;
 }
 
-meshtastic_UserLite TypeConversions::ConvertToUserLite(meshtastic_User user)
+void TypeConversions::ConvertToPosition(const meshtastic_PositionLite &lite, meshtastic_Position *position)
+{
+    // Position has many fields the lite one doesn't keep, they must all be cleared
+    memset(position, 0, sizeof(*position));
+    position->has_latitude_i = lite.latitude_i != 0;
+    position->latitude_i = lite.latitude_i;
+    position->has_longitude_i = lite.longitude_i != 0;
+    position->longitude_i = lite.longitude_i;
+    position->has_altitude = lite.altitude != 0;
+    position->altitude = lite.altitude;
+    position->location_source = lite.location_source;
+    position->time = lite.time;
+}
+
+meshtastic_UserLite TypeConversions::ConvertToUserLite(const meshtastic_User &user)
 {
     meshtastic_UserLite lite = meshtastic_UserLite_init_default;
 
@@ -85,28 +79,33 @@ meshtastic_UserLite TypeConversions::ConvertToUserLite(meshtastic_User user)
     lite.role = user.role;
     lite.is_licensed = user.is_licensed;
     memcpy(lite.macaddr, user.macaddr, sizeof(lite.macaddr));
-    memcpy(lite.public_key.bytes, user.public_key.bytes, sizeof(lite.public_key.bytes));
+    memcpy(lite.public_key.bytes, user.public_key.bytes, user.public_key.size);
     lite.public_key.size = user.public_key.size;
     lite.has_is_unmessagable = user.has_is_unmessagable;
     lite.is_unmessagable = user.is_unmessagable;
     return lite;
 }
 
-meshtastic_User TypeConversions::ConvertToUser(uint32_t nodeNum, meshtastic_UserLite lite)
+meshtastic_User TypeConversions::ConvertToUser(uint32_t nodeNum, const meshtastic_UserLite &lite)
 {
-    meshtastic_User user = meshtastic_User_init_default;
-
-    snprintf(user.id, sizeof(user.id), "!%08x", nodeNum);
-    strncpy(user.long_name, lite.long_name, sizeof(user.long_name));
-    strncpy(user.short_name, lite.short_name, sizeof(user.short_name));
-    user.hw_model = lite.hw_model;
-    user.role = lite.role;
-    user.is_licensed = lite.is_licensed;
-    memcpy(user.macaddr, lite.macaddr, sizeof(user.macaddr));
-    memcpy(user.public_key.bytes, lite.public_key.bytes, sizeof(user.public_key.bytes));
-    user.public_key.size = lite.public_key.size;
-    user.has_is_unmessagable = lite.has_is_unmessagable;
-    user.is_unmessagable = lite.is_unmessagable;
-
+    meshtastic_User user;
+    ConvertToUser(nodeNum, lite, &user);
     return user;
-}
\ No newline at end of file
+}
+
+void TypeConversions::ConvertToUser(uint32_t nodeNum, const meshtastic_UserLite &lite, meshtastic_User *user)
+{
+    memset(user, 0, sizeof(*user));
+    snprintf(user->id, sizeof(user->id), "!%08x", nodeNum);
+    strncpy(user->long_name, lite.long_name, sizeof(user->long_name) - 1);
+    strncpy(user->short_name, lite.short_name, sizeof(user->short_name) - 1);
+    user->hw_model = lite.hw_model;
+    user->role = lite.role;
+    user->is_licensed = lite.is_licensed;
+    memcpy(user->macaddr, lite.macaddr, sizeof(user->macaddr));
+    // Only the bytes of the key, the rest of the buffer isn't encoded
+    memcpy(user->public_key.bytes, lite.public_key.bytes, lite.public_key.size);
+    user->public_key.size = lite.public_key.size;
+    user->has_is_unmessagable = lite.has_is_unmessagable;
+    user->is_unmessagable = lite.is_unmessagable;
+}
@@ -8,8 +8,16 @@ class TypeConversions
 {
   public:
     static meshtastic_NodeInfo ConvertToNodeInfo(const meshtastic_NodeInfoLite *lite);
-    static meshtastic_PositionLite ConvertToPositionLite(meshtastic_Position position);
-    static meshtastic_Position ConvertToPosition(meshtastic_PositionLite lite);
-    static meshtastic_UserLite ConvertToUserLite(meshtastic_User user);
-    static meshtastic_User ConvertToUser(uint32_t nodeNum, meshtastic_UserLite lite);
+    static meshtastic_PositionLite ConvertToPositionLite(const meshtastic_Position &position);
+    static meshtastic_Position ConvertToPosition(const meshtastic_PositionLite &lite);
+    static meshtastic_UserLite ConvertToUserLite(const meshtastic_User &user);
+    static meshtastic_User ConvertToUser(uint32_t nodeNum, const meshtastic_UserLite &lite);
+
+    /**
+     * Fill info in place, for callers converting every node (the phone's node download).  Submessages lite doesn't have are
+     * left as they were with their has_ flag cleared, so only what the node has is written.
+     */
+    static void ConvertToNodeInfo(const meshtastic_NodeInfoLite *lite, meshtastic_NodeInfo *info);
+    static void ConvertToPosition(const meshtastic_PositionLite &lite, meshtastic_Position *position);
+    static void ConvertToUser(uint32_t nodeNum, const meshtastic_UserLite &lite, meshtastic_User *user);
 };
@@ -66,6 +66,13 @@ template <class T> class TypedQueue
 
 #include <queue>
 
+#if defined(ARCH_PORTDUINO) && PORTDUINO_RADIO_THREAD
+#include <mutex>
+#define TYPED_QUEUE_GUARD std::lock_guard<std::mutex> guard(mutex)
+#else
+#define TYPED_QUEUE_GUARD
+#endif
+
 /**
  * A wrapper for freertos queues.  Note: each element object should be small
  * and POD (Plain Old Data type) as elements are memcpied by value.
@@ -75,6 +82,9 @@ template <class T> class TypedQueue
     std::queue<T> q;
     concurrency::OSThread *reader = NULL;
     int maxElements;
+#if defined(ARCH_PORTDUINO) && PORTDUINO_RADIO_THREAD
+    std::mutex mutex; // The radio thread enqueues while the main loop dequeues
+#endif
 
   public:
     explicit TypedQueue(int _maxElements) : maxElements(_maxElements) {}
@@ -86,21 +96,31 @@ template <class T> class TypedQueue
         return maxElements - numUsed();
     }
 
-    bool isEmpty() { return q.empty(); }
+    bool isEmpty()
+    {
+        TYPED_QUEUE_GUARD;
+        return q.empty();
+    }
 
-    int numUsed() { return q.size(); }
+    int numUsed()
+    {
+        TYPED_QUEUE_GUARD;
+        return q.size();
+    }
 
     bool enqueue(T x, TickType_t maxWait = portMAX_DELAY)
     {
-        if (numFree() <= 0)
-            return false;
+        {
+            TYPED_QUEUE_GUARD;
+            if (maxElements > 0 && (int)q.size() >= maxElements)
+                return false;
+            q.push(x);
+        }
 
         if (reader) {
             reader->setInterval(0);
             concurrency::mainDelay.interrupt();
         }
-
-        q.push(x);
         return true;
     }
 
@@ -108,7 +128,8 @@ template <class T> class TypedQueue
 
     bool dequeue(T *p, TickType_t maxWait = portMAX_DELAY)
     {
-        if (isEmpty())
+        TYPED_QUEUE_GUARD;
+        if (q.empty())
             return false;
         else {
             *p = q.front();
@@ -2,23 +2,90 @@
 #include "configuration.h"
 #include <Arduino.h>
 
+// We do our own coalescing, so turn off Nagle's algorithm where the client type allows it: otherwise the last short write of a
+// burst waits for the client's delayed ack of the one before
+template <typename C> static auto setNoDelay(C &c, int) -> decltype(c.setNoDelay(true), void())
+{
+    c.setNoDelay(true);
+}
+template <typename C> static void setNoDelay(C &, long) {}
+
 template <typename T>
 ServerAPI<T>::ServerAPI(T &_client) : StreamAPI(&client), concurrency::OSThread("ServerAPI"), client(_client)
 {
     LOG_INFO("Incoming API connection");
+    fanoutReader.thread = this;
+    setNoDelay(client, 0);
 }
 
 template <typename T> ServerAPI<T>::~ServerAPI()
 {
+    leaveFanout();
     client.stop();
 }
 
 template <typename T> void ServerAPI<T>::close()
 {
+    leaveFanout();
     client.stop(); // drop tcp connection
     StreamAPI::close();
 }
 
+template <typename T> void ServerAPI<T>::leaveFanout()
+{
+    if (inFanout) {
+        LOG_DEBUG("API client queue: max %u bytes, dropped %u bytes", fanoutReader.maxDepth, fanoutReader.droppedBytes);
+        ServerAPIFanout::get()->leave(fanoutReader);
+        inFanout = false;
+    }
+}
+
+template <typename T> void ServerAPI<T>::writeStream()
+{
+    if (!canWrite)
+        return;
+
+    if (!isSendingPackets()) {
+        // The config download is just for us (and getFromRadioBatch() ends the last batch of it before any packets).  It all
+        // comes out in this one pass, so there is nothing to wait for: write each buffer full as soon as it is
+        leaveFanout();
+        size_t len;
+        while ((len = getFromRadioBatch(txCoalesce, sizeof(txCoalesce), sizeof(uint32_t), writeFrameHeader)) != 0)
+            client.write(txCoalesce, len);
+        if (!isSendingPackets())
+            return;
+    }
+
+    auto fanout = ServerAPIFanout::get();
+    if (!inFanout) {
+        fanout->join(fanoutReader);
+        inFanout = true;
+    }
+
+    // Whatever we pull from MeshService is encoded once and then written to every client from the fan-out
+    size_t len;
+    while ((len = fillTxBatch()) != 0)
+        fanout->publish(txBatch, len, &fanoutReader);
+    drainCoalesced();
+}
+
+template <typename T> void ServerAPI<T>::drainCoalesced()
+{
+    auto fanout = ServerAPIFanout::get();
+    if (!fanout->getDepth(fanoutReader)) {
+        txWaitingSinceMsec = 0;
+        return;
+    }
+    if (!txWaitingSinceMsec)
+        txWaitingSinceMsec = millis() | 1; // 0 means nothing is waiting
+    if (fanout->getDepth(fanoutReader) < SERVER_API_TX_COALESCE_SIZE && millis() - txWaitingSinceMsec < SERVER_API_TX_FLUSH_MSEC)
+        return; // runOnce() comes back in time
+
+    fanout->drain(fanoutReader, client);
+    if (!fanout->getDepth(fanoutReader))
+        txWaitingSinceMsec = 0; // else the client is behind, and what is left is written as soon as it will take it
+}
+
 /// Check the current underlying physical link to see if the client is currently connected
 template <typename T> bool ServerAPI<T>::checkIsConnected()
 {
@@ -28,7 +95,11 @@ template <typename T> bool ServerAPI<T>::checkIsConnected()
 template <class T> int32_t ServerAPI<T>::runOnce()
 {
     if (client.connected()) {
-        return StreamAPI::runOncePart();
+        int32_t result = StreamAPI::runOncePart();
+        // Come back for packets that are waiting to be coalesced with others
+        if (txWaitingSinceMsec && result > SERVER_API_TX_FLUSH_MSEC)
+            result = SERVER_API_TX_FLUSH_MSEC;
+        return result;
     } else {
         LOG_INFO("Client dropped connection, suspend API service");
         enabled = false; // we no longer need to run
@@ -38,13 +109,31 @@ template <class T> int32_t ServerAPI<T>::runOnce()
 
 template <class T, class U> APIServerPort<T, U>::APIServerPort(int port) : U(port), concurrency::OSThread("ApiServer") {}
 
+template <class T, class U> APIServerPort<T, U>::~APIServerPort()
+{
+    while (numOpen)
+        closeClient(numOpen - 1);
+}
+
 template <class T, class U> void APIServerPort<T, U>::init()
 {
     U::begin();
 }
 
+template <class T, class U> void APIServerPort<T, U>::closeClient(size_t i)
+{
+    delete openAPIs[i];
+    for (size_t j = i + 1; j < numOpen; j++)
+        openAPIs[j - 1] = openAPIs[j];
+    openAPIs[--numOpen] = NULL;
+}
+
 template <class T, class U> int32_t APIServerPort<T, U>::runOnce()
 {
+    for (size_t i = numOpen; i-- > 0;)
+        if (openAPIs[i]->hasDropped())
+            closeClient(i);
+
 #ifdef ARCH_ESP32
 #if ESP_ARDUINO_VERSION >= ESP_ARDUINO_VERSION_VAL(3, 0, 0)
     auto client = U::accept();
@@ -57,8 +146,8 @@ template <class T, class U> int32_t APIServerPort<T, U>::runOnce()
     auto client = U::available();
 #endif
     if (client) {
-        // Close any previous connection (see FIXME in header file)
-        if (openAPI) {
+        // Make room by closing the oldest connection
+        if (numOpen == SERVER_API_MAX_CLIENTS) {
 #if RAK_4631
             // RAK13800 Ethernet requests periodically take more time
             // This backoff addresses most cases keeping max wait < 1s
@@ -69,15 +158,16 @@ template <class T, class U> int32_t APIServerPort<T, U>::runOnce()
                 return waitTime;
             }
 #endif
-            LOG_INFO("Force close previous TCP connection");
-            delete openAPI;
+            LOG_INFO("Too many TCP connections, force close oldest");
+            closeClient(0);
         }
 
-        openAPI = new T(client);
+        openAPIs[numOpen++] = new T(client);
+        LOG_INFO("%u TCP API clients connected", numOpen);
     }
 
 #if RAK_4631
     waitTime = 100;
 #endif
     return 100; // only check occasionally for incoming connections
-}
\ No newline at end of file
+}
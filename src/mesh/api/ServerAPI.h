@@ -1,9 +1,33 @@
 #pragma once
 
+#include "ServerAPIFanout.h"
 #include "StreamAPI.h"
 
 #define SERVER_API_DEFAULT_PORT 4403
 
+/// How many TCP API clients can be connected at once, a new connection beyond this closes the oldest one
+#ifndef SERVER_API_MAX_CLIENTS
+#ifdef ARCH_PORTDUINO
+#define SERVER_API_MAX_CLIENTS 8
+#else
+#define SERVER_API_MAX_CLIENTS 3
+#endif
+#endif
+
+/// Bytes of framed FromRadio packets collected for one socket write, a full sized TCP segment or more
+#ifndef SERVER_API_TX_COALESCE_SIZE
+#ifdef ARCH_PORTDUINO
+#define SERVER_API_TX_COALESCE_SIZE 16384
+#else
+#define SERVER_API_TX_COALESCE_SIZE (2 * 1460)
+#endif
+#endif
+
+/// Longest a packet waits for others to share its socket write with, once the config download is over
+#ifndef SERVER_API_TX_FLUSH_MSEC
+#define SERVER_API_TX_FLUSH_MSEC 10
+#endif
+
 /**
  * Provides both debug printing and, if the client starts sending protobufs to us, switches to send/receive protobufs
  * (and starts dropping debug printing - FIXME, eventually those prints should be encapsulated in protobufs).
@@ -13,6 +37,21 @@ template <class T> class ServerAPI : public StreamAPI, private concurrency::OSTh
   private:
     T client;
 
+    /// Where we are in the packets shared with the other clients, once we have our config
+    ServerAPIFanout::Reader fanoutReader;
+    bool inFanout = false;
+
+    /// The config download, collected so it goes out in a few large writes rather than one per couple of frames
+    uint8_t txCoalesce[SERVER_API_TX_COALESCE_SIZE];
+
+    /// When the oldest packet not yet written to the client was published, 0 if there is none
+    uint32_t txWaitingSinceMsec = 0;
+
+    void leaveFanout();
+
+    /// Write what the fan-out has for us once there is SERVER_API_TX_COALESCE_SIZE of it, or the oldest has waited long enough
+    void drainCoalesced();
+
   public:
     explicit ServerAPI(T &_client);
 
@@ -21,6 +60,18 @@ template <class T> class ServerAPI : public StreamAPI, private concurrency::OSTh
     /// override close to also shutdown the TCP link
     virtual void close();
 
+    /// @return true if the TCP connection has gone away and we can be deleted
+    bool hasDropped() { return !client.connected(); }
+
+    /// @return bytes of packets waiting to be written to this client
+    uint32_t getQueueDepth() { return inFanout ? ServerAPIFanout::get()->getDepth(fanoutReader) : 0; }
+
+    /// @return the most bytes of packets that were ever waiting for this client
+    uint32_t getMaxQueueDepth() { return fanoutReader.maxDepth; }
+
+    /// @return bytes of packets this client missed because it fell too far behind
+    uint32_t getDroppedBytes() { return fanoutReader.droppedBytes; }
+
   protected:
     /// We override this method to prevent publishing EVENT_SERIAL_CONNECTED/DISCONNECTED for wifi links (we want the board to
     /// stay in the POWERED state to prevent disabling wifi)
@@ -28,6 +79,9 @@ template <class T> class ServerAPI : public StreamAPI, private concurrency::OSTh
 
     virtual int32_t runOnce() override; // Check for dropped client connections
 
+    /// Send our config directly, and packets through the fan-out shared with the other clients
+    virtual void writeStream() override;
+
     /// Check the current underlying physical link to see if the client is currently connected
     virtual bool checkIsConnected() override;
 };
@@ -37,20 +91,22 @@ template <class T> class ServerAPI : public StreamAPI, private concurrency::OSTh
  */
 template <class T, class U> class APIServerPort : public U, private concurrency::OSThread
 {
-    /** The currently open port
-     *
-     * FIXME: We currently only allow one open TCP connection at a time, because we depend on the loop() call in this class to
-     * delegate to the worker.  Once coroutines are implemented we can relax this restriction.
-     */
-    T *openAPI = NULL;
+    /// The currently open clients, oldest first.  Each is its own OSThread, so we only have to accept and clean up
+    T *openAPIs[SERVER_API_MAX_CLIENTS] = {};
+    size_t numOpen = 0;
 #if defined(RAK_4631) || defined(RAK11310)
     // Track wait time for RAK13800 Ethernet requests
     int32_t waitTime = 100;
 #endif
 
+    /// Close and forget the client at index i
+    void closeClient(size_t i);
+
   public:
     explicit APIServerPort(int port);
 
+    virtual ~APIServerPort();
+
     void init();
 
   protected:
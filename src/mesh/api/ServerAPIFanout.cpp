@@ -0,0 +1,72 @@
+#include "ServerAPIFanout.h"
+#include "configuration.h"
+#include <algorithm>
+#include <string.h>
+
+#define FRAME_HEADER_LEN 4
+
+ServerAPIFanout *ServerAPIFanout::get()
+{
+    static ServerAPIFanout *fanout;
+    if (!fanout)
+        fanout = new ServerAPIFanout();
+    return fanout;
+}
+
+void ServerAPIFanout::join(Reader &r)
+{
+    r.readPos = writePos;
+    if (std::find(readers.begin(), readers.end(), &r) == readers.end())
+        readers.push_back(&r);
+}
+
+void ServerAPIFanout::leave(Reader &r)
+{
+    readers.erase(std::remove(readers.begin(), readers.end(), &r), readers.end());
+}
+
+void ServerAPIFanout::publish(const uint8_t *frames, size_t len, const Reader *from)
+{
+    if (len == 0 || len > SERVER_API_FANOUT_SIZE)
+        return;
+
+    // Make room by forgetting whole frames, the length is in bytes 2-3 of each header
+    while (writePos + len - oldestPos > SERVER_API_FANOUT_SIZE) {
+        uint32_t frameLen = (at(oldestPos + 2) << 8) + at(oldestPos + 3);
+        oldestPos += FRAME_HEADER_LEN + frameLen;
+    }
+
+    uint32_t start = writePos & (SERVER_API_FANOUT_SIZE - 1);
+    size_t first = std::min(len, (size_t)(SERVER_API_FANOUT_SIZE - start));
+    memcpy(buf + start, frames, first);
+    memcpy(buf, frames + first, len - first);
+    writePos += len;
+
+    for (Reader *r : readers)
+        if (r != from && r->thread)
+            r->thread->setIntervalFromNow(0);
+}
+
+void ServerAPIFanout::drain(Reader &r, Print &out)
+{
+    if ((int32_t)(oldestPos - r.readPos) > 0) {
+        if (!r.droppedBytes) // only once per client, the total is logged when it goes
+            LOG_WARN("API client too slow, dropping packets");
+        r.droppedBytes += oldestPos - r.readPos;
+        r.readPos = oldestPos;
+    }
+
+    uint32_t depth = getDepth(r);
+    if (depth > r.maxDepth)
+        r.maxDepth = depth;
+
+    while (r.readPos != writePos) {
+        uint32_t start = r.readPos & (SERVER_API_FANOUT_SIZE - 1);
+        size_t len = std::min((size_t)(writePos - r.readPos), (size_t)(SERVER_API_FANOUT_SIZE - start));
+        size_t written = out.write(buf + start, len);
+        r.readPos += written;
+        if (written < len)
+            break; // the client isn't keeping up, leave the rest for next time
+    }
+    // No flush(): a socket sends what it is given, and on some cores flush() throws away what the client sent us instead
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "concurrency/OSThread.h"
+#include <Print.h>
+#include <stdint.h>
+#include <vector>
+
+/// Bytes of framed FromRadio packets kept for TCP API clients that are slower than the others, must be a power of two
+#ifndef SERVER_API_FANOUT_SIZE
+#ifdef ARCH_PORTDUINO
+#define SERVER_API_FANOUT_SIZE 16384
+#else
+#define SERVER_API_FANOUT_SIZE 4096
+#endif
+#endif
+
+/**
+ * Shares the packets for the phone between all TCP API clients that have finished downloading their config.
+ *
+ * MeshService has a single queue of packets for the phone, so with several clients connected each packet would only reach
+ * whichever client happened to poll first.  Instead the client that pulls a packet encodes and frames it once and publishes
+ * it here, and every client writes it from here at its own pace.
+ *
+ * The newest SERVER_API_FANOUT_SIZE bytes are kept.  Publishing never waits for a slow client: a client that falls further
+ * behind than that skips ahead to the oldest frame still kept (and relies on the 0x94C3 framing to resync).
+ */
+class ServerAPIFanout
+{
+    static_assert((SERVER_API_FANOUT_SIZE & (SERVER_API_FANOUT_SIZE - 1)) == 0, "SERVER_API_FANOUT_SIZE must be a power of two");
+
+  public:
+    /// One client's position in the fan-out
+    struct Reader {
+        concurrency::OSThread *thread = NULL; // woken when there is something new to write
+        uint32_t readPos = 0;                 // next byte to write to this client
+        uint32_t maxDepth = 0;                // most bytes that were ever waiting for this client
+        uint32_t droppedBytes = 0;            // bytes this client fell too far behind to get
+    };
+
+    /// The shared instance, allocated on first use so targets without a TCP API don't pay for the buffer
+    static ServerAPIFanout *get();
+
+    /// Start sending the frames published from now on to r
+    void join(Reader &r);
+
+    void leave(Reader &r);
+
+    /// Add complete frames (4 byte header + FromRadio each) and wake every other reader
+    void publish(const uint8_t *frames, size_t len, const Reader *from);
+
+    /// Write whatever r hasn't seen yet to out, as much of it as out will take
+    void drain(Reader &r, Print &out);
+
+    /// @return the number of bytes waiting for r
+    uint32_t getDepth(const Reader &r) const { return writePos - r.readPos; }
+
+  private:
+    uint8_t buf[SERVER_API_FANOUT_SIZE];
+    uint32_t writePos = 0;  // total bytes ever published, positions wrap around buf
+    uint32_t oldestPos = 0; // start of the oldest frame still in buf
+    std::vector<Reader *> readers;
+
+    uint8_t at(uint32_t pos) const { return buf[pos & (SERVER_API_FANOUT_SIZE - 1)]; }
+};
@@ -122,6 +122,10 @@ const int UTF8_PREFIX[] = {0xC0, 0xE0, 0xF0};
 /// global to indicate whether initialization is complete or not
 uint8_t is_inited = 0;
 
+/// Vertical decoder lookup indexed by the next 8 bits of input, filled by init_coder() \n
+/// 3 bits code len (one less, as 8 cannot be accommodated in 3 bits), 5 bits vertical pos
+uint8_t usx_vcode_lookup[256];
+
 /// Fills the usx_code_94 94 letter array based on sets of characters at usx_sets \n
 /// For each element in usx_code_94, first 3 msb bits is set (USX_ALPHA / USX_SYM / USX_NUM) \n
 /// and the rest 5 bits indicate the vertical position in the corresponding set
@@ -140,6 +144,11 @@ void init_coder()
             }
         }
     }
+    // The vertical codes are a complete prefix code, so every 8 bit value starts with exactly one of them
+    for (int v = 0; v < 28; v++) {
+        int span = 1 << (8 - usx_vcode_lens[v]);
+        memset(usx_vcode_lookup + usx_vcodes[v], ((usx_vcode_lens[v] - 1) << 5) + v, span);
+    }
     is_inited = 1;
 }
 
@@ -148,34 +157,30 @@ unsigned int usx_mask[] = {0x80, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC, 0xFE, 0xFF};
 
 /// Appends specified number of bits to the output (out) \n
 /// If maximum limit (olen) is reached, -1 is returned \n
-/// Otherwise clen bits in code are appended to out starting with MSB
+/// Otherwise clen bits in code are appended to out starting with MSB \n
+/// clen is at most 8, so the code lands in at most two bytes
 int append_bits(char *out, int olen, int ol, uint8_t code, int clen)
 {
 
     // printf("%d,%x,%d,%d\n", ol, code, clen, state);
 
-    while (clen > 0) {
-        int oidx;
-        unsigned char a_byte;
-
-        uint8_t cur_bit = ol % 8;
-        uint8_t blen = clen;
-        a_byte = code & usx_mask[blen - 1];
-        a_byte >>= cur_bit;
-        if (blen + cur_bit > 8)
-            blen = (8 - cur_bit);
-        oidx = ol / 8;
-        if (oidx < 0 || olen <= oidx)
+    if (clen <= 0)
+        return ol;
+    int oidx = ol / 8;
+    if (oidx < 0 || olen <= oidx)
+        return -1;
+    uint8_t cur_bit = ol % 8;
+    uint8_t a_byte = code & usx_mask[clen - 1];
+    if (cur_bit == 0)
+        out[oidx] = a_byte;
+    else
+        out[oidx] |= a_byte >> cur_bit;
+    if (cur_bit + clen > 8) {
+        if (olen <= oidx + 1)
             return -1;
-        if (cur_bit == 0)
-            out[oidx] = a_byte;
-        else
-            out[oidx] |= a_byte;
-        code <<= blen;
-        ol += blen;
-        clen -= blen;
+        out[oidx + 1] = a_byte << (8 - cur_bit);
     }
-    return ol;
+    return ol + clen;
 }
 
 /// This is a safe call to append_bits() making sure it does not write past olen
@@ -346,6 +351,8 @@ int matchOccurance(const char *in, int len, int l, char *out, int olen, int *ol,
     int longest_dist = 0;
     int longest_len = 0;
     for (j = l - NICE_LEN; j >= 0; j--) {
+        if (in[j] != in[l])
+            continue; // can't be a match, and this is most of them
         for (k = l; k < len && j + k - l < l; k++) {
             if (in[k] != in[j + k - l])
                 break;
@@ -547,6 +554,18 @@ int unishox2_compress_lines(const char *in, int len, UNISHOX_API_OUT_AND_LEN(cha
     }
 #endif
 
+    // Looked up for every input character otherwise
+    int template_lens[5];
+    if (usx_templates != NULL) {
+        for (int i = 0; i < 5; i++)
+            template_lens[i] = usx_templates[i] ? (int)strlen(usx_templates[i]) : 0;
+    }
+    int freq_seq_lens[6];
+    if (usx_freq_seq != NULL) {
+        for (int i = 0; i < 6; i++)
+            freq_seq_lens[i] = (int)strlen(usx_freq_seq[i]);
+    }
+
     init_coder();
     ol = 0;
     prev_uni = 0;
@@ -656,7 +675,7 @@ int unishox2_compress_lines(const char *in, int len, UNISHOX_API_OUT_AND_LEN(cha
             int i;
             for (i = 0; i < 5; i++) {
                 if (usx_templates[i]) {
-                    int rem = (int)strlen(usx_templates[i]);
+                    int rem = template_lens[i];
                     int j = 0;
                     for (; j < rem && l + j < len; j++) {
                         char c_t = usx_templates[i][j];
@@ -702,9 +721,10 @@ int unishox2_compress_lines(const char *in, int len, UNISHOX_API_OUT_AND_LEN(cha
         if (usx_freq_seq != NULL) {
             int i;
             for (i = 0; i < 6; i++) {
-                int seq_len = (int)strlen(usx_freq_seq[i]);
+                int seq_len = freq_seq_lens[i];
                 if (len - seq_len >= 0 && l <= len - seq_len) {
-                    if (memcmp(usx_freq_seq[i], in + l, seq_len) == 0 && usx_hcode_lens[usx_freq_codes[i] >> 5]) {
+                    if (usx_freq_seq[i][0] == in[l] && memcmp(usx_freq_seq[i], in + l, seq_len) == 0 &&
+                        usx_hcode_lens[usx_freq_codes[i] >> 5]) {
                         SAFE_APPEND_BITS2(rawolen,
                                           ol = append_code(out, olen, ol, usx_freq_codes[i], &state, usx_hcodes, usx_hcode_lens));
                         l += seq_len;
@@ -897,49 +917,18 @@ int read8bitCode(const char *in, int len, int bit_no)
     return code;
 }
 
-/// The list of veritical codes is split into 5 sections. Used by readVCodeIdx()
-#define SECTION_COUNT 5
-/// Used by readVCodeIdx() for finding the section under which the code read using read8bitCode() falls
-uint8_t usx_vsections[] = {0x7F, 0xBF, 0xDF, 0xEF, 0xFF};
-/// Used by readVCodeIdx() for finding the section vertical position offset
-uint8_t usx_vsection_pos[] = {0, 4, 8, 12, 20};
-/// Used by readVCodeIdx() for masking the code read by read8bitCode()
-uint8_t usx_vsection_mask[] = {0x7F, 0x3F, 0x1F, 0x0F, 0x0F};
-/// Used by readVCodeIdx() for shifting the code read by read8bitCode() to obtain the vpos
-uint8_t usx_vsection_shift[] = {5, 4, 3, 1, 0};
-
-/// Vertical decoder lookup table - 3 bits code len, 5 bytes vertical pos
-/// code len is one less as 8 cannot be accommodated in 3 bits
-uint8_t usx_vcode_lookup[36] = {(1 << 5) + 0,  (1 << 5) + 0,  (2 << 5) + 1,  (2 << 5) + 2,  // Section 1
-                                (3 << 5) + 3,  (3 << 5) + 4,  (3 << 5) + 5,  (3 << 5) + 6,  // Section 2
-                                (3 << 5) + 7,  (3 << 5) + 7,  (4 << 5) + 8,  (4 << 5) + 9,  // Section 3
-                                (5 << 5) + 10, (5 << 5) + 10, (5 << 5) + 11, (5 << 5) + 11, // Section 4
-                                (5 << 5) + 12, (5 << 5) + 12, (6 << 5) + 13, (6 << 5) + 14, (6 << 5) + 15, (6 << 5) + 15,
-                                (6 << 5) + 16, (6 << 5) + 16, // Section 5
-                                (6 << 5) + 17, (6 << 5) + 17, (7 << 5) + 18, (7 << 5) + 19, (7 << 5) + 20, (7 << 5) + 21,
-                                (7 << 5) + 22, (7 << 5) + 23, (7 << 5) + 24, (7 << 5) + 25, (7 << 5) + 26, (7 << 5) + 27};
-
 /// Decodes the vertical code from the given bitstream at in \n
-/// This is designed to use less memory using a 36 uint8_t buffer \n
-/// compared to using a 256 uint8_t buffer to decode the next 8 bits read by read8bitCode() \n
-/// by splitting the list of vertical codes. \n
-/// Decoder is designed for using less memory, not speed. \n
+/// using usx_vcode_lookup, one lookup of the next 8 bits read by read8bitCode() \n
 /// Returns the veritical code index or 99 if match could not be found. \n
 /// Also updates bit_no_p with how many ever bits used by the vertical code.
 int readVCodeIdx(const char *in, int len, int *bit_no_p)
 {
     if (*bit_no_p < len) {
-        uint8_t code = read8bitCode(in, len, *bit_no_p);
-        int i = 0;
-        do {
-            if (code <= usx_vsections[i]) {
-                uint8_t vcode = usx_vcode_lookup[usx_vsection_pos[i] + ((code & usx_vsection_mask[i]) >> usx_vsection_shift[i])];
-                (*bit_no_p) += ((vcode >> 5) + 1);
-                if (*bit_no_p > len)
-                    return 99;
-                return vcode & 0x1F;
-            }
-        } while (++i < SECTION_COUNT);
+        uint8_t vcode = usx_vcode_lookup[read8bitCode(in, len, *bit_no_p)];
+        (*bit_no_p) += ((vcode >> 5) + 1);
+        if (*bit_no_p > len)
+            return 99;
+        return vcode & 0x1F;
     }
     return 99;
 }
@@ -984,15 +973,22 @@ int getStepCodeIdx(const char *in, int len, int *bit_no_p, int limit)
     return idx;
 }
 
-/// Reads specified number of bits and builds the corresponding integer
+/// Reads specified number of bits and builds the corresponding integer \n
+/// Returns -1 if there aren't that many bits left
 int32_t getNumFromBits(const char *in, int len, int bit_no, int count)
 {
+    if (count > 0 && bit_no + count > len)
+        return -1;
     int32_t ret = 0;
-    while (count-- && bit_no < len) {
-        ret += (readBit(in, bit_no) ? 1 << count : 0);
-        bit_no++;
+    // A byte at a time rather than a bit at a time
+    while (count > 0) {
+        int avail = 8 - (bit_no & 7);
+        int take = count < avail ? count : avail;
+        ret = (ret << take) | ((((uint8_t)in[bit_no >> 3]) >> (avail - take)) & ((1 << take) - 1));
+        bit_no += take;
+        count -= take;
     }
-    return count < 0 ? ret : -1;
+    return ret;
 }
 
 /// Decodes the count from the given bit stream at in. Also updates bit_no_p
@@ -2,8 +2,10 @@
 #include "NodeDB.h"
 #include "PowerFSM.h"
 #include "RadioLibInterface.h"
+#include "StreamAPI.h"
 #include "airtime.h"
 #include "main.h"
+#include "memGet.h"
 #include "mesh/http/ContentHelper.h"
 #include "mesh/http/WebServer.h"
 #if HAS_WIFI
@@ -13,6 +15,7 @@
 #include "SPILock.h"
 #include "power.h"
 #include "serialization/JSON.h"
+#include "serialization/NodeListSerializer.h"
 #include <FSCommon.h>
 #include <HTTPBodyParser.hpp>
 #include <HTTPMultipartBodyParser.hpp>
@@ -64,6 +67,30 @@ char contentTypes[][2][32] = {{".txt", "text/plain"},     {".html", "text/html"}
 
 // const char *certificate = NULL; // change this as needed, leave as is for no TLS check (yolo security)
 
+/// Bytes of a static file we read from flash per write to the connection, more where the buffer can live in PSRAM
+#ifndef WEB_STATIC_CHUNK_SIZE
+#if PSRAM_PLACEMENT
+#define WEB_STATIC_CHUNK_SIZE 8192
+#else
+#define WEB_STATIC_CHUNK_SIZE 2048
+#endif
+#endif
+
+/// index.html(.gz) up to this size is kept in RAM once served, 0 disables
+#ifndef WEB_STATIC_CACHE_MAX
+#define WEB_STATIC_CACHE_MAX 8192
+#endif
+
+// The index files we keep in RAM, usually just index.html.gz (also what we serve for unknown paths)
+#define WEB_STATIC_CACHE_FILES 2
+struct StaticCacheEntry {
+    std::string path;
+    std::string etag;
+    std::vector<uint8_t> data;
+};
+static StaticCacheEntry staticCache[WEB_STATIC_CACHE_FILES];
+static uint8_t staticCacheNext;
+
 // Our API to handle messages to and from the radio.
 HttpAPI webAPI;
 
@@ -175,16 +202,31 @@ void handleAPIv1FromRadio(HTTPRequest *req, HTTPResponse *res)
         return;
     }
 
-    uint8_t txBuf[MAX_STREAM_BUF_SIZE];
+    static uint8_t txBuf[STREAM_TX_BATCH_SIZE]; // too big for the stack, the http server handles one request at a time
     uint32_t len = 1;
 
+    // ?framed=true: each FromRadio gets the 4 byte header StreamAPI uses, so one response can carry several of them.  Together
+    // with all=true that is everything available, else as many as fit in one batch.
+    std::string valueFramed;
+    if (params->getQueryParameter("framed", valueFramed) && valueFramed == "true") {
+        bool all = params->getQueryParameter("all", valueAll) && valueAll == "true";
+        size_t total = 0;
+        do {
+            len = webAPI.getFromRadioBatch(txBuf, sizeof(txBuf), sizeof(uint32_t), StreamAPI::writeFrameHeader);
+            res->write(txBuf, len);
+            total += len;
+        } while (all && len);
+        LOG_DEBUG("webAPI handleAPIv1FromRadio, framed len %d", total);
+        return;
+    }
+
     if (params->getQueryParameter("all", valueAll)) {
 
         // If all is true, return all the buffers we have available
         //   to us at this point in time.
         if (valueAll == "true") {
             while (len) {
-                len = webAPI.getFromRadio(txBuf);
+                len = webAPI.getFromRadioBatch(txBuf, sizeof(txBuf));
                 res->write(txBuf, len);
             }
 
@@ -225,6 +267,24 @@ void handleAPIv1ToRadio(HTTPRequest *req, HTTPResponse *res)
         return;
     }
 
+    // ?framed=true: the body is any number of ToRadios, each with the 4 byte header StreamAPI uses
+    ResourceParameters *params = req->getParams();
+    std::string valueFramed;
+    if (params->getQueryParameter("framed", valueFramed) && valueFramed == "true") {
+        static uint8_t rxBuf[MAX_STREAM_BUF_SIZE]; // too big for the stack, the http server handles one request at a time
+        size_t rxLen = 0, total = 0, got;
+        while ((got = req->readBytes(rxBuf + rxLen, sizeof(rxBuf) - rxLen)) > 0) {
+            rxLen += got;
+            total += got;
+            // What is left is part of a frame, so there is always room to read the rest of it
+            size_t used = StreamAPI::handleFrames(&webAPI, rxBuf, rxLen);
+            rxLen -= used;
+            memmove(rxBuf, rxBuf + used, rxLen);
+        }
+        LOG_DEBUG("Received %d framed bytes from PUT request", total);
+        return;
+    }
+
     byte buffer[MAX_TO_FROM_RADIO_SIZE];
     size_t s = req->readBytes(buffer, MAX_TO_FROM_RADIO_SIZE);
 
@@ -263,6 +323,7 @@ void htmlDeleteDir(const char *dirname)
     }
     root.flush();
     root.close();
+    invalidateFileManifest();
 }
 
 JSONArray htmlListDir(const char *dirname, uint8_t levels)
@@ -320,7 +381,7 @@ void handleFsBrowseStatic(HTTPRequest *req, HTTPResponse *res)
     res->setHeader("Access-Control-Allow-Origin", "*");
     res->setHeader("Access-Control-Allow-Methods", "GET");
 
-    concurrency::LockGuard g(spiLock);
+    concurrency::LockGuard g(fsLock);
     auto fileList = htmlListDir("/static", 10);
 
     // create json output structure
@@ -355,8 +416,9 @@ void handleFsDeleteStatic(HTTPRequest *req, HTTPResponse *res)
 
     if (params->getQueryParameter("delete", paramValDelete)) {
         std::string pathDelete = "/" + paramValDelete;
-        concurrency::LockGuard g(spiLock);
+        concurrency::LockGuard g(fsLock);
         if (FSCom.remove(pathDelete.c_str())) {
+            invalidateFileManifest();
 
             LOG_INFO("%s", pathDelete.c_str());
             JSONObject jsonObjOuter;
@@ -392,6 +454,7 @@ void handleStatic(HTTPRequest *req, HTTPResponse *res)
 
         // Try to open the file
         File file;
+        std::string opened;
 
         bool has_set_content_type = false;
 
@@ -400,15 +463,17 @@ void handleStatic(HTTPRequest *req, HTTPResponse *res)
             filenameGzip = "/static/index.html.gz";
         }
 
-        concurrency::LockGuard g(spiLock);
+        concurrency::LockGuard g(fsLock);
 
         if (FSCom.exists(filename.c_str())) {
             file = FSCom.open(filename.c_str());
+            opened = filename;
             if (!file.available()) {
                 LOG_WARN("File not available - %s", filename.c_str());
             }
         } else if (FSCom.exists(filenameGzip.c_str())) {
             file = FSCom.open(filenameGzip.c_str());
+            opened = filenameGzip;
             res->setHeader("Content-Encoding", "gzip");
             if (!file.available()) {
                 LOG_WARN("File not available - %s", filenameGzip.c_str());
@@ -417,6 +482,7 @@ void handleStatic(HTTPRequest *req, HTTPResponse *res)
             has_set_content_type = true;
             filenameGzip = "/static/index.html.gz";
             file = FSCom.open(filenameGzip.c_str());
+            opened = filenameGzip;
             res->setHeader("Content-Type", "text/html");
             if (!file.available()) {
 
@@ -431,7 +497,23 @@ void handleStatic(HTTPRequest *req, HTTPResponse *res)
             }
         }
 
-        res->setHeader("Content-Length", httpsserver::intToString(file.size()));
+        // The web client is updated separately from the firmware, so the file's size and time go in too
+        size_t size = file.size();
+        std::string etag = "\"" + std::string(optstr(APP_VERSION)) + "-" + httpsserver::intToString(size) + "-" +
+                           httpsserver::intToString((int)file.getLastWrite()) + "\"";
+        res->setHeader("ETag", etag);
+        // The browser asks again for the index every time, assets are good for an hour
+        bool isIndex = opened.rfind("/static/index.", 0) == 0;
+        res->setHeader("Cache-Control", isIndex ? "no-cache" : "max-age=3600");
+
+        if (req->getHeader("If-None-Match") == etag) {
+            res->setStatusCode(304);
+            res->setStatusText("Not Modified");
+            file.close();
+            return;
+        }
+
+        res->setHeader("Content-Length", httpsserver::intToString(size));
 
         // Content-Type is guessed using the definition of the contentTypes-table defined above
         int cTypeIdx = 0;
@@ -449,17 +531,54 @@ void handleStatic(HTTPRequest *req, HTTPResponse *res)
             res->setHeader("Content-Type", "application/octet-stream");
         }
 
-        // Read the file and write it to the HTTP response body
+        StaticCacheEntry *cached = NULL;
+        for (auto &entry : staticCache) {
+            if (entry.path == opened && entry.etag == etag)
+                cached = &entry;
+        }
+        if (cached) {
+            file.close();
+            res->write(cached->data.data(), cached->data.size());
+            return;
+        }
+
+        // Read the file and write it straight to the HTTP response body.  The buffer is too big for the stack and is kept
+        // once allocated, the http server handles one request at a time
+        static uint8_t *buffer = NULL;
+        if (!buffer)
+            buffer = (uint8_t *)memGet.allocCold(WEB_STATIC_CHUNK_SIZE);
+        if (!buffer) {
+            file.close();
+            LOG_ERROR("No memory to serve %s", opened.c_str());
+            res->setStatusCode(503);
+            res->setStatusText("Service Unavailable");
+            return;
+        }
+        StaticCacheEntry *filling = NULL;
+        if (isIndex && size <= WEB_STATIC_CACHE_MAX) {
+            filling = &staticCache[staticCacheNext];
+            staticCacheNext = (staticCacheNext + 1) % WEB_STATIC_CACHE_FILES;
+            filling->path = opened;
+            filling->etag = etag;
+            filling->data.clear();
+            filling->data.reserve(size);
+        }
         size_t length = 0;
         do {
-            char buffer[256];
-            length = file.read((uint8_t *)buffer, 256);
-            std::string bufferString(buffer, length);
-            res->write((uint8_t *)bufferString.c_str(), bufferString.size());
+            length = file.read(buffer, WEB_STATIC_CHUNK_SIZE);
+            res->write(buffer, length);
+            if (filling)
+                filling->data.insert(filling->data.end(), buffer, buffer + length);
         } while (length > 0);
 
         file.close();
 
+        if (filling && filling->data.size() != size) {
+            filling->path.clear(); // a short read, don't serve it again
+            filling->data.clear();
+            filling->data.shrink_to_fit();
+        }
+
         return;
     } else {
         LOG_ERROR("This should not have happened");
@@ -545,11 +664,12 @@ void handleFormUpload(HTTPRequest *req, HTTPResponse *res)
         // concepts of the body parser functionality easier to understand.
         std::string pathname = "/static/" + filename;
 
-        concurrency::LockGuard g(spiLock);
+        concurrency::LockGuard g(fsLock);
         // Create a new file to stream the data into
         File file = FSCom.open(pathname.c_str(), FILE_O_WRITE);
         size_t fileLength = 0;
         didwrite = true;
+        invalidateFileManifest();
 
         // With endOfField you can check whether the end of field has been reached or if there's
         // still data pending. With multipart bodies, you cannot know the field size in advance.
@@ -654,11 +774,11 @@ void handleReport(HTTPRequest *req, HTTPResponse *res)
     jsonObjMemory["heap_free"] = new JSONValue((int)memGet.getFreeHeap());
     jsonObjMemory["psram_total"] = new JSONValue((int)memGet.getPsramSize());
     jsonObjMemory["psram_free"] = new JSONValue((int)memGet.getFreePsram());
-    spiLock->lock();
+    fsLock->lock();
     jsonObjMemory["fs_total"] = new JSONValue((int)FSCom.totalBytes());
     jsonObjMemory["fs_used"] = new JSONValue((int)FSCom.usedBytes());
     jsonObjMemory["fs_free"] = new JSONValue(int(FSCom.totalBytes() - FSCom.usedBytes()));
-    spiLock->unlock();
+    fsLock->unlock();
 
     // data->power
     JSONObject jsonObjPower;
@@ -677,6 +797,15 @@ void handleReport(HTTPRequest *req, HTTPResponse *res)
     jsonObjRadio["frequency"] = new JSONValue(RadioLibInterface::instance->getFreq());
     jsonObjRadio["lora_channel"] = new JSONValue((int)RadioLibInterface::instance->getChannelNum() + 1);
 
+    // data->https
+    JSONObject jsonObjHttps;
+    jsonObjHttps["certificate"] = new JSONValue(WEBSERVER_ECDSA_CERT ? "ecdsa_p256" : "rsa_2048");
+    jsonObjHttps["handshakes"] = new JSONValue((int)webServerTlsStats.handshakes);
+    jsonObjHttps["handshake_ms_avg"] =
+        new JSONValue(webServerTlsStats.handshakes ? (int)(webServerTlsStats.totalMsec / webServerTlsStats.handshakes) : 0);
+    jsonObjHttps["handshake_ms_max"] = new JSONValue((int)webServerTlsStats.maxMsec);
+    jsonObjHttps["handshake_ms_last"] = new JSONValue((int)webServerTlsStats.lastMsec);
+
     // collect data to inner data object
     JSONObject jsonObjInner;
     jsonObjInner["airtime"] = new JSONValue(jsonObjAirtime);
@@ -685,6 +814,7 @@ void handleReport(HTTPRequest *req, HTTPResponse *res)
     jsonObjInner["power"] = new JSONValue(jsonObjPower);
     jsonObjInner["device"] = new JSONValue(jsonObjDevice);
     jsonObjInner["radio"] = new JSONValue(jsonObjRadio);
+    jsonObjInner["https"] = new JSONValue(jsonObjHttps);
 
     // create json output structure
     JSONObject jsonObjOuter;
@@ -714,57 +844,17 @@ void handleNodes(HTTPRequest *req, HTTPResponse *res)
         res->println("<pre>");
     }
 
-    JSONArray nodesArray;
-
-    uint32_t readIndex = 0;
-    const meshtastic_NodeInfoLite *tempNodeInfo = nodeDB->readNextMeshNode(readIndex);
-    while (tempNodeInfo != NULL) {
-        if (tempNodeInfo->has_user) {
-            JSONObject node;
-
-            char id[16];
-            snprintf(id, sizeof(id), "!%08x", tempNodeInfo->num);
-
-            node["id"] = new JSONValue(id);
-            node["snr"] = new JSONValue(tempNodeInfo->snr);
-            node["via_mqtt"] = new JSONValue(BoolToString(tempNodeInfo->via_mqtt));
-            node["last_heard"] = new JSONValue((int)tempNodeInfo->last_heard);
-            node["position"] = new JSONValue();
-
-            if (nodeDB->hasValidPosition(tempNodeInfo)) {
-                JSONObject position;
-                position["latitude"] = new JSONValue((float)tempNodeInfo->position.latitude_i * 1e-7);
-                position["longitude"] = new JSONValue((float)tempNodeInfo->position.longitude_i * 1e-7);
-                position["altitude"] = new JSONValue((int)tempNodeInfo->position.altitude);
-                node["position"] = new JSONValue(position);
-            }
-
-            node["long_name"] = new JSONValue(tempNodeInfo->user.long_name);
-            node["short_name"] = new JSONValue(tempNodeInfo->user.short_name);
-            char macStr[18];
-            snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X", tempNodeInfo->user.macaddr[0],
-                     tempNodeInfo->user.macaddr[1], tempNodeInfo->user.macaddr[2], tempNodeInfo->user.macaddr[3],
-                     tempNodeInfo->user.macaddr[4], tempNodeInfo->user.macaddr[5]);
-            node["mac_address"] = new JSONValue(macStr);
-            node["hw_model"] = new JSONValue(tempNodeInfo->user.hw_model);
-
-            nodesArray.push_back(new JSONValue(node));
-        }
-        tempNodeInfo = nodeDB->readNextMeshNode(readIndex);
-    }
-
-    // collect data to inner data object
-    JSONObject jsonObjInner;
-    jsonObjInner["nodes"] = new JSONValue(nodesArray);
-
-    // create json output structure
-    JSONObject jsonObjOuter;
-    jsonObjOuter["data"] = new JSONValue(jsonObjInner);
-    jsonObjOuter["status"] = new JSONValue("ok");
-    // serialize and write it to the stream
-    JSONValue *value = new JSONValue(jsonObjOuter);
-    res->print(value->Stringify().c_str());
-    delete value;
+    // ?offset=&limit= page through the nodes, without limit we send all of them
+    std::string value;
+    uint32_t offset = params->getQueryParameter("offset", value) ? strtoul(value.c_str(), NULL, 10) : 0;
+    uint32_t limit = params->getQueryParameter("limit", value) ? strtoul(value.c_str(), NULL, 10) : UINT32_MAX;
+
+    // Written one node at a time, so the size of NodeDB doesn't matter
+    static char piece[NodeListSerializer::PIECE_MAX]; // the http server handles one request at a time
+    NodeListSerializer nodes(offset, limit);
+    size_t len;
+    while ((len = nodes.next(piece, sizeof(piece))) > 0)
+        res->write((uint8_t *)piece, len);
 }
 
 /*
@@ -800,7 +890,7 @@ void handleDeleteFsContent(HTTPRequest *req, HTTPResponse *res)
 
     LOG_INFO("Delete files from /static/* : ");
 
-    concurrency::LockGuard g(spiLock);
+    concurrency::LockGuard g(fsLock);
     htmlDeleteDir("/static");
 
     res->println("<p><hr><p><a href=/admin>Back to admin</a>");
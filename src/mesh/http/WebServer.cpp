@@ -45,6 +45,14 @@ Preferences prefs;
 #include <HTTPServer.hpp>
 #include <SSLCert.hpp>
 
+#if WEBSERVER_ECDSA_CERT
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/ecp.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/pk.h>
+#include <mbedtls/x509_crt.h>
+#endif
+
 // The HTTPS Server comes in a separate namespace. For easier use, include it here.
 using namespace httpsserver;
 #include "mesh/http/ContentHandler.h"
@@ -56,18 +64,107 @@ static HTTPServer *insecureServer;
 volatile bool isWebServerReady;
 volatile bool isCertReady;
 
+WebServerTlsStats webServerTlsStats;
+
+#if WEBSERVER_ECDSA_CERT
+// The certificate and key are under their own names, so changing WEBSERVER_ECDSA_CERT doesn't pick up the other kind
+static const char *prefsKeyName = "PK_EC";
+static const char *prefsCertName = "cert_EC";
+#else
+static const char *prefsKeyName = "PK";
+static const char *prefsCertName = "cert";
+#endif
+
 static void handleWebResponse()
 {
     if (isWifiAvailable()) {
 
         if (isWebServerReady) {
-            if (secureServer)
+            if (secureServer) {
+                // A new connection is accepted and its handshake run inside loop(), nothing else it does usually takes
+                // this long (a large static file can)
+                uint32_t start = millis();
                 secureServer->loop();
+                uint32_t took = millis() - start;
+                if (took >= WEBSERVER_HANDSHAKE_MIN_MSEC) {
+                    webServerTlsStats.handshakes++;
+                    webServerTlsStats.totalMsec += took;
+                    webServerTlsStats.lastMsec = took;
+                    if (took > webServerTlsStats.maxMsec)
+                        webServerTlsStats.maxMsec = took;
+                    LOG_DEBUG("HTTPS handshake took %u ms", took);
+                }
+            }
             insecureServer->loop();
         }
     }
 }
 
+#if WEBSERVER_ECDSA_CERT
+/// Make a self-signed P-256 certificate for cert, as createSelfSignedCert() does for RSA
+/// @return 0 on success, else an mbedtls error
+static int createSelfSignedEcdsaCert(SSLCert &cert)
+{
+    mbedtls_pk_context key;
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context drbg;
+    mbedtls_x509write_cert crt;
+    mbedtls_mpi serial;
+    mbedtls_pk_init(&key);
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+    mbedtls_x509write_crt_init(&crt);
+    mbedtls_mpi_init(&serial);
+
+    // Both DER encoders write at the end of the buffer
+    const size_t bufSize = 1024;
+    uint8_t *buf = new uint8_t[bufSize];
+    const char *name = "CN=meshtastic.local,O=Meshtastic,C=US";
+    int result;
+    if ((result = mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, (const uint8_t *)name, strlen(name))) != 0 ||
+        (result = mbedtls_pk_setup(&key, mbedtls_pk_info_from_type(MBEDTLS_PK_ECKEY))) != 0 ||
+        (result = mbedtls_ecp_gen_key(MBEDTLS_ECP_DP_SECP256R1, mbedtls_pk_ec(key), mbedtls_ctr_drbg_random, &drbg)) != 0 ||
+        (result = mbedtls_mpi_lset(&serial, 1)) != 0 || (result = mbedtls_x509write_crt_set_serial(&crt, &serial)) != 0 ||
+        (result = mbedtls_x509write_crt_set_subject_name(&crt, name)) != 0 ||
+        (result = mbedtls_x509write_crt_set_issuer_name(&crt, name)) != 0 ||
+        (result = mbedtls_x509write_crt_set_validity(&crt, "20190101000000", "20300101000000")) != 0 ||
+        (result = mbedtls_x509write_crt_set_basic_constraints(&crt, 0, -1)) != 0)
+        goto done;
+    mbedtls_x509write_crt_set_version(&crt, MBEDTLS_X509_CRT_VERSION_3);
+    mbedtls_x509write_crt_set_md_alg(&crt, MBEDTLS_MD_SHA256);
+    mbedtls_x509write_crt_set_subject_key(&crt, &key);
+    mbedtls_x509write_crt_set_issuer_key(&crt, &key);
+
+    if ((result = mbedtls_x509write_crt_der(&crt, buf, bufSize, mbedtls_ctr_drbg_random, &drbg)) < 0)
+        goto done;
+    {
+        // SSLCert keeps the pointers it is given
+        uint8_t *certData = new uint8_t[result];
+        memcpy(certData, buf + bufSize - result, result);
+        uint16_t certLen = result;
+
+        if ((result = mbedtls_pk_write_key_der(&key, buf, bufSize)) < 0) {
+            delete[] certData;
+            goto done;
+        }
+        uint8_t *pkData = new uint8_t[result];
+        memcpy(pkData, buf + bufSize - result, result);
+        cert.setCert(certData, certLen);
+        cert.setPK(pkData, result);
+        result = 0;
+    }
+
+done:
+    delete[] buf;
+    mbedtls_mpi_free(&serial);
+    mbedtls_x509write_crt_free(&crt);
+    mbedtls_ctr_drbg_free(&drbg);
+    mbedtls_entropy_free(&entropy);
+    mbedtls_pk_free(&key);
+    return result;
+}
+#endif
+
 static void taskCreateCert(void *parameter)
 {
     prefs.begin("MeshtasticHTTPS", false);
@@ -76,23 +173,23 @@ static void taskCreateCert(void *parameter)
     // Delete the saved certs (used in debugging)
     LOG_DEBUG("Delete any saved SSL keys");
     // prefs.clear();
-    prefs.remove("PK");
-    prefs.remove("cert");
+    prefs.remove(prefsKeyName);
+    prefs.remove(prefsCertName);
 #endif
 
     LOG_INFO("Checking if we have a saved SSL Certificate");
 
-    size_t pkLen = prefs.getBytesLength("PK");
-    size_t certLen = prefs.getBytesLength("cert");
+    size_t pkLen = prefs.getBytesLength(prefsKeyName);
+    size_t certLen = prefs.getBytesLength(prefsCertName);
 
     if (pkLen && certLen) {
         LOG_INFO("Existing SSL Certificate found!");
 
         uint8_t *pkBuffer = new uint8_t[pkLen];
-        prefs.getBytes("PK", pkBuffer, pkLen);
+        prefs.getBytes(prefsKeyName, pkBuffer, pkLen);
 
         uint8_t *certBuffer = new uint8_t[certLen];
-        prefs.getBytes("cert", certBuffer, certLen);
+        prefs.getBytes(prefsCertName, certBuffer, certLen);
 
         cert = new SSLCert(certBuffer, certLen, pkBuffer, pkLen);
 
@@ -104,8 +201,12 @@ static void taskCreateCert(void *parameter)
         yield();
         cert = new SSLCert();
         yield();
+#if WEBSERVER_ECDSA_CERT
+        int createCertResult = createSelfSignedEcdsaCert(*cert);
+#else
         int createCertResult = createSelfSignedCert(*cert, KEYSIZE_2048, "CN=meshtastic.local,O=Meshtastic,C=US",
                                                     "20190101000000", "20300101000000");
+#endif
         yield();
 
         if (createCertResult != 0) {
@@ -117,8 +218,8 @@ static void taskCreateCert(void *parameter)
 
             LOG_DEBUG("Created Certificate: %d Bytes", cert->getCertLength());
 
-            prefs.putBytes("PK", (uint8_t *)cert->getPKData(), cert->getPKLength());
-            prefs.putBytes("cert", (uint8_t *)cert->getCertData(), cert->getCertLength());
+            prefs.putBytes(prefsKeyName, (uint8_t *)cert->getPKData(), cert->getPKLength());
+            prefs.putBytes(prefsCertName, (uint8_t *)cert->getCertData(), cert->getCertLength());
         }
     }
 
@@ -5,9 +5,29 @@
 #include <Arduino.h>
 #include <functional>
 
+/// Set to 1 to serve HTTPS with a P-256 ECDSA certificate rather than RSA 2048, a cheaper handshake for the ESP32
+#ifndef WEBSERVER_ECDSA_CERT
+#define WEBSERVER_ECDSA_CERT 0
+#endif
+
+/// A pass of the HTTPS server's loop taking this long is counted as a TLS handshake
+#ifndef WEBSERVER_HANDSHAKE_MIN_MSEC
+#define WEBSERVER_HANDSHAKE_MIN_MSEC 100
+#endif
+
 void initWebServer();
 void createSSLCert();
 
+/// What the HTTPS server's TLS handshakes cost, for /json/report
+struct WebServerTlsStats {
+    uint32_t handshakes;
+    uint32_t totalMsec;
+    uint32_t maxMsec;
+    uint32_t lastMsec;
+};
+
+extern WebServerTlsStats webServerTlsStats;
+
 class WebServerThread : private concurrency::OSThread
 {
 
@@ -1,6 +1,7 @@
 #include "configuration.h"
 
 #include "FSCommon.h"
+#include "RadioTask.h"
 #include "SPILock.h"
 #include "mesh-pb-constants.h"
 #include <Arduino.h>
@@ -56,11 +57,12 @@ bool readcb(pb_istream_t *stream, uint8_t *buf, size_t count)
 /// Write to an arduino file
 bool writecb(pb_ostream_t *stream, const uint8_t *buf, size_t count)
 {
-    spiLock->lock();
+    fsLock->lock();
     auto file = (Print *)stream->state;
     // LOG_DEBUG("writing %d bytes to protobuf file", count);
     bool status = file->write(buf, count) == count;
-    spiLock->unlock();
+    fsLock->unlock();
+    yieldToRadio(); // A NodeDB save takes a while
     return status;
 }
 #endif
@@ -11,6 +11,57 @@
 // Tricky macro to let you find the sizeof a type member
 #define member_size(type, member) sizeof(((type *)0)->member)
 
+/**
+ * Size the nodeDB, packet history, transmit queue and phone queues for targets with little RAM (STM32WL, the smaller nRF52s)
+ * from the per-target table below, instead of the defaults meant for ESP32s.  The RAM each of them takes statically is checked
+ * against MESHTASTIC_COMPACT_RAM_BUDGET at build time.  Any of the sizes can still be set with its own -D.
+ */
+#ifndef MESHTASTIC_COMPACT
+#define MESHTASTIC_COMPACT 0
+#endif
+
+#if MESHTASTIC_COMPACT
+struct CompactProfile {
+    uint16_t maxNodes;
+    uint16_t packetHistory; // records, 16 bytes each
+    uint8_t txQueue;
+    uint8_t rxToPhone;
+    uint32_t ramBudget; // bytes for all of the above and the packet pool
+};
+
+#if defined(ARCH_STM32WL)
+constexpr CompactProfile compactProfile = {10, 32, 4, 4, 16 * 1024};
+#elif defined(ARCH_NRF52)
+constexpr CompactProfile compactProfile = {40, 100, 8, 16, 40 * 1024};
+#else
+constexpr CompactProfile compactProfile = {40, 100, 8, 16, 48 * 1024};
+#endif
+
+#ifndef MAX_NUM_NODES
+#define MAX_NUM_NODES (compactProfile.maxNodes)
+#endif
+#ifndef MAX_RX_TOPHONE
+#define MAX_RX_TOPHONE (compactProfile.rxToPhone)
+#endif
+#ifndef MAX_TX_QUEUE
+#define MAX_TX_QUEUE (compactProfile.txQueue)
+#endif
+#ifndef PACKETHISTORY_MAX
+#define PACKETHISTORY_MAX ((uint32_t)compactProfile.packetHistory)
+#endif
+#ifndef MESHTASTIC_COMPACT_RAM_BUDGET
+#define MESHTASTIC_COMPACT_RAM_BUDGET (compactProfile.ramBudget)
+#endif
+
+/// What each subsystem takes, see the static_assert in Router.cpp
+namespace compactRam
+{
+constexpr uint32_t nodeDB = (MAX_NUM_NODES + 1) * sizeof(meshtastic_NodeInfoLite);
+constexpr uint32_t packetHistory = PACKETHISTORY_MAX * 16;
+constexpr uint32_t phoneQueues = MAX_RX_TOPHONE * sizeof(meshtastic_QueueStatus);
+} // namespace compactRam
+#endif
+
 /// max number of packets which can be waiting for delivery to android - note, this value comes from mesh.options protobuf
 // FIXME - max_count is actually 32 but we save/load this as one long string of preencoded MeshPacket bytes - not a big array in
 // RAM #define MAX_RX_TOPHONE (member_size(DeviceState, receive_queue) / member_size(DeviceState, receive_queue[0]))
@@ -22,9 +73,43 @@
 /// the impact of its memory footprint, notably on MAX_NUM_NODES.
 static_assert(sizeof(meshtastic_NodeInfoLite) <= 200, "NodeInfoLite size increased. Reconsider impact on MAX_NUM_NODES.");
 
+/**
+ * On ESP32 boards with PSRAM, size the nodeDB from the PSRAM instead of internal RAM.  The node array is one large allocation,
+ * which the ESP32 heap already places in PSRAM, so only the NodeNum index the routing code looks nodes up through has to stay
+ * in internal RAM.  Lets routers remember NODEDB_PSRAM_MAX_NODES nodes instead of 100 to 250.
+ */
+#ifndef NODEDB_PSRAM
+#define NODEDB_PSRAM 0
+#endif
+
+/// Nodes kept with NODEDB_PSRAM, nodes.proto grows by up to meshtastic_NodeInfoLite_size for each one
+#ifndef NODEDB_PSRAM_MAX_NODES
+#define NODEDB_PSRAM_MAX_NODES 1000
+#endif
+
+/// PSRAM needed before NODEDB_PSRAM raises the node count, a quarter of it at most goes to the nodes
+#define NODEDB_PSRAM_MIN_BYTES (4 * NODEDB_PSRAM_MAX_NODES * sizeof(meshtastic_NodeInfoLite))
+
 /// max number of nodes allowed in the nodeDB
 #ifndef MAX_NUM_NODES
-#if defined(ARCH_STM32WL)
+#if NODEDB_PSRAM && defined(ARCH_ESP32)
+#include "Esp.h"
+static inline int get_max_num_nodes()
+{
+    if (ESP.getPsramSize() >= NODEDB_PSRAM_MIN_BYTES)
+        return NODEDB_PSRAM_MAX_NODES;
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+    uint32_t flash_size = ESP.getFlashChipSize() / (1024 * 1024); // Convert Bytes to MB
+    if (flash_size >= 15) {
+        return 250;
+    } else if (flash_size >= 7) {
+        return 200;
+    }
+#endif
+    return 100;
+}
+#define MAX_NUM_NODES get_max_num_nodes()
+#elif defined(ARCH_STM32WL)
 #define MAX_NUM_NODES 10
 #elif defined(ARCH_NRF52)
 #define MAX_NUM_NODES 80
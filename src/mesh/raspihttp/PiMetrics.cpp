@@ -0,0 +1,191 @@
+#ifdef PORTDUINO_LINUX_HARDWARE
+#if __has_include(<ulfius.h>)
+#include "PiMetrics.h"
+#include "MeshModule.h"
+#include "NodeDB.h"
+#include "PacketLatency.h"
+#include "RadioLibInterface.h"
+#include "Router.h"
+#include "airtime.h"
+#include "memGet.h"
+#include <stdarg.h>
+
+PiMetrics *piMetrics;
+
+PiMetrics::PiMetrics() : concurrency::OSThread("Metrics") {}
+
+std::string PiMetrics::get()
+{
+    lastScrapeMs = millis();
+    std::lock_guard<std::mutex> guard(textLock);
+    return text;
+}
+
+int32_t PiMetrics::runOnce()
+{
+    bool empty;
+    {
+        std::lock_guard<std::mutex> guard(textLock);
+        empty = text.empty();
+    }
+    if (empty || millis() - lastScrapeMs < METRICS_IDLE_MSEC) {
+        std::string out;
+        out.reserve(4096);
+        render(out);
+        std::lock_guard<std::mutex> guard(textLock);
+        text.swap(out);
+    }
+    return METRICS_REFRESH_MSEC;
+}
+
+/// printf onto the end of out
+static void appendf(std::string &out, const char *format, ...)
+{
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (n > 0)
+        out.append(line, std::min((size_t)n, sizeof(line) - 1));
+}
+
+static void family(std::string &out, const char *name, const char *type, const char *help)
+{
+    appendf(out, "# HELP meshtastic_%s %s\n# TYPE meshtastic_%s %s\n", name, help, name, type);
+}
+
+void PiMetrics::render(std::string &out)
+{
+    if (airTime) {
+        family(out, "channel_utilization_percent", "gauge", "Channel busy time over the last minute");
+        appendf(out, "meshtastic_channel_utilization_percent %.2f\n", airTime->channelUtilizationPercent());
+        family(out, "tx_utilization_percent", "gauge", "Our transmit time over the last hour");
+        appendf(out, "meshtastic_tx_utilization_percent %.2f\n", airTime->utilizationTXPercent());
+    }
+
+    family(out, "radio_packets_total", "counter", "Packets through each radio by outcome");
+    for (uint8_t i = 0; i < MAX_RADIO_INTERFACES; i++) {
+        RadioLibInterface *radio = RadioLibInterface::instances[i];
+        if (!radio)
+            continue;
+        appendf(out, "meshtastic_radio_packets_total{radio=\"%u\",result=\"rx_good\"} %u\n", i, radio->rxGood);
+        appendf(out, "meshtastic_radio_packets_total{radio=\"%u\",result=\"rx_bad\"} %u\n", i, radio->rxBad);
+        appendf(out, "meshtastic_radio_packets_total{radio=\"%u\",result=\"tx_good\"} %u\n", i, radio->txGood);
+        appendf(out, "meshtastic_radio_packets_total{radio=\"%u\",result=\"tx_relay\"} %u\n", i, radio->txRelay);
+    }
+
+#if TX_QUEUE_AGING
+    family(out, "tx_queue_wait_ms", "histogram", "Time packets waited in the transmit queue, by priority class");
+    for (uint8_t i = 0; i < MAX_RADIO_INTERFACES; i++) {
+        RadioLibInterface *radio = RadioLibInterface::instances[i];
+        if (!radio)
+            continue;
+        const MeshPacketQueue &q = radio->getTxQueue();
+        for (uint8_t c = 0; c < MeshPacketQueue::WAIT_CLASSES; c++) {
+            const char *name = MeshPacketQueue::getWaitClassName((MeshPacketQueue::WaitClass)c);
+            const uint32_t *histogram = q.getWaitHistogram((MeshPacketQueue::WaitClass)c);
+            uint32_t total = 0;
+            for (uint8_t b = 0; b < TX_QUEUE_WAIT_BUCKETS - 1; b++) {
+                total += histogram[b];
+                appendf(out, "meshtastic_tx_queue_wait_ms_bucket{radio=\"%u\",priority=\"%s\",le=\"%u\"} %u\n", i, name,
+                        MeshPacketQueue::getWaitBucketLimitMs(b), total);
+            }
+            total += histogram[TX_QUEUE_WAIT_BUCKETS - 1];
+            appendf(out, "meshtastic_tx_queue_wait_ms_bucket{radio=\"%u\",priority=\"%s\",le=\"+Inf\"} %u\n", i, name, total);
+            appendf(out, "meshtastic_tx_queue_wait_ms_sum{radio=\"%u\",priority=\"%s\"} %u\n", i, name,
+                    q.getWaitTotalMs((MeshPacketQueue::WaitClass)c));
+            appendf(out, "meshtastic_tx_queue_wait_ms_count{radio=\"%u\",priority=\"%s\"} %u\n", i, name, total);
+        }
+    }
+    family(out, "tx_queue_boosted_total", "counter", "Packets sent ahead of higher priorities for waiting past their target");
+    for (uint8_t i = 0; i < MAX_RADIO_INTERFACES; i++) {
+        RadioLibInterface *radio = RadioLibInterface::instances[i];
+        if (radio)
+            appendf(out, "meshtastic_tx_queue_boosted_total{radio=\"%u\"} %u\n", i, radio->getTxQueue().getBoosted());
+    }
+#endif
+
+    if (router) {
+        meshtastic_QueueStatus qs = router->getQueueStatus();
+        family(out, "tx_queue_free", "gauge", "Free slots in the transmit queue");
+        appendf(out, "meshtastic_tx_queue_free %u\n", qs.free);
+        family(out, "tx_queue_size", "gauge", "Slots in the transmit queue");
+        appendf(out, "meshtastic_tx_queue_size %u\n", qs.maxlen);
+
+        family(out, "router_packets_total", "counter", "Router decisions");
+        appendf(out, "meshtastic_router_packets_total{event=\"heard\"} %u\n", router->rxHeard);
+        appendf(out, "meshtastic_router_packets_total{event=\"duplicate\"} %u\n", router->rxDupe);
+        appendf(out, "meshtastic_router_packets_total{event=\"relay_canceled\"} %u\n", router->txRelayCanceled);
+        appendf(out, "meshtastic_router_packets_total{event=\"relay_downsampled\"} %u\n", router->txRelayDownsampled);
+        appendf(out, "meshtastic_router_packets_total{event=\"ack_piggybacked\"} %u\n", router->txAckPiggybacked);
+    }
+
+    if (nodeDB) {
+        family(out, "nodes", "gauge", "Nodes in NodeDB");
+        appendf(out, "meshtastic_nodes %u\n", (uint32_t)nodeDB->getNumMeshNodes());
+        family(out, "nodes_online", "gauge", "Nodes heard recently");
+        appendf(out, "meshtastic_nodes_online %u\n", (uint32_t)nodeDB->getNumOnlineMeshNodes());
+    }
+
+    family(out, "heap_free_bytes", "gauge", "Free heap");
+    appendf(out, "meshtastic_heap_free_bytes %u\n", memGet.getFreeHeap());
+    family(out, "heap_size_bytes", "gauge", "Heap size");
+    appendf(out, "meshtastic_heap_size_bytes %u\n", memGet.getHeapSize());
+
+    const std::vector<MeshModule *> *modules = MeshModule::getModules();
+    if (modules) {
+        family(out, "module_calls_total", "counter", "Packets handed to each module");
+        for (MeshModule *m : *modules)
+            appendf(out, "meshtastic_module_calls_total{module=\"%s\"} %u\n", m->getName(), m->getHandleStats().calls);
+        family(out, "module_seconds_total", "counter", "Time spent handling packets in each module");
+        for (MeshModule *m : *modules)
+            appendf(out, "meshtastic_module_seconds_total{module=\"%s\"} %.6f\n", m->getName(),
+                    m->getHandleStats().totalMicros / 1e6);
+    }
+
+#if OSTHREAD_PROFILE
+    family(out, "thread_runs_total", "counter", "Runs of each thread");
+    concurrency::OSThread::forEachProfile(
+        [](const concurrency::OSThread *t, void *context) {
+            appendf(*(std::string *)context, "meshtastic_thread_runs_total{thread=\"%s\"} %u\n", t->ThreadName.c_str(),
+                    t->getProfile().calls);
+        },
+        &out);
+    family(out, "thread_seconds_total", "counter", "Time spent running each thread");
+    concurrency::OSThread::forEachProfile(
+        [](const concurrency::OSThread *t, void *context) {
+            appendf(*(std::string *)context, "meshtastic_thread_seconds_total{thread=\"%s\"} %.6f\n", t->ThreadName.c_str(),
+                    t->getProfile().totalMicros / 1e6);
+        },
+        &out);
+    family(out, "thread_late_seconds_total", "counter", "How late each thread ran, summed over its runs");
+    concurrency::OSThread::forEachProfile(
+        [](const concurrency::OSThread *t, void *context) {
+            appendf(*(std::string *)context, "meshtastic_thread_late_seconds_total{thread=\"%s\"} %.3f\n", t->ThreadName.c_str(),
+                    t->getProfile().totalLateMsec / 1e3);
+        },
+        &out);
+#endif
+
+#if PACKET_LATENCY
+    // Bucket b holds times under 2^b us, Prometheus buckets count everything up to their bound
+    family(out, "packet_stage_seconds", "histogram", "Time a packet took to reach each stage from the one before");
+    for (int s = 0; s < PacketLatency::NUM_STAGES; s++) {
+        const PacketLatency::Histogram &h = PacketLatency::get((PacketLatency::Stage)s);
+        const char *stage = PacketLatency::getStageName((PacketLatency::Stage)s);
+        uint32_t cumulative = 0;
+        for (int b = 0; b < PacketLatency::NUM_BUCKETS - 1; b++) {
+            cumulative += h.buckets[b];
+            appendf(out, "meshtastic_packet_stage_seconds_bucket{stage=\"%s\",le=\"%g\"} %u\n", stage, (1u << b) / 1e6,
+                    cumulative);
+        }
+        appendf(out, "meshtastic_packet_stage_seconds_bucket{stage=\"%s\",le=\"+Inf\"} %u\n", stage, h.count);
+        appendf(out, "meshtastic_packet_stage_seconds_sum{stage=\"%s\"} %.6f\n", stage, h.totalUs / 1e6);
+        appendf(out, "meshtastic_packet_stage_seconds_count{stage=\"%s\"} %u\n", stage, h.count);
+    }
+#endif
+}
+
+#endif
+#endif
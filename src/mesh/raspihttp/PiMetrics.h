@@ -0,0 +1,45 @@
+#pragma once
+#ifdef PORTDUINO_LINUX_HARDWARE
+#if __has_include(<ulfius.h>)
+#include "concurrency/OSThread.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+
+/// How often the metrics are gathered while someone scrapes them
+#define METRICS_REFRESH_MSEC 5000
+/// Stop gathering when nobody has scraped for this long
+#define METRICS_IDLE_MSEC (2 * 60 * 1000)
+
+/**
+ * The counters meshtasticd already keeps, in the Prometheus text format, for GET /metrics: airtime, radio and router counts,
+ * queue depth, NodeDB size and heap, plus thread profiles (OSTHREAD_PROFILE), module handler times and packet stage
+ * latencies (PACKET_LATENCY) when those are built in.
+ *
+ * The text is written straight into a string on the main thread, where the counters are updated and threads and modules can
+ * be walked safely, and the web server's thread hands out the latest copy.  It is refreshed every METRICS_REFRESH_MSEC while
+ * scrapes keep coming, so scrapes see figures at most that old.
+ */
+class PiMetrics : private concurrency::OSThread
+{
+  public:
+    PiMetrics();
+
+    /// The latest metrics, called from the web server's thread
+    std::string get();
+
+  protected:
+    virtual int32_t runOnce() override;
+
+  private:
+    void render(std::string &out);
+
+    std::mutex textLock;
+    std::string text;
+    std::atomic<uint32_t> lastScrapeMs{0};
+};
+
+extern PiMetrics *piMetrics;
+
+#endif
+#endif
@@ -38,6 +38,7 @@ mail:   marchammermann@googlemail.com
 #if __has_include(<ulfius.h>)
 #include "PiWebServer.h"
 #include "NodeDB.h"
+#include "PiMetrics.h"
 #include "PhoneAPI.h"
 #include "PowerFSM.h"
 #include "RadioLibInterface.h"
@@ -56,10 +57,14 @@ mail:   marchammermann@googlemail.com
 #include <ulfius.h>
 #include <yder.h>
 
+#include <algorithm>
 #include <cstring>
+#include <mutex>
 #include <string>
+#include <unistd.h>
 
 #include "PortduinoFS.h"
+#include "serialization/NodeListSerializer.h"
 #include "platform/portduino/PortduinoGlue.h"
 
 #define DEFAULT_REALM "default_realm"
@@ -87,6 +92,9 @@ volatile bool isCertReady;
 
 PiWebServerThread *piwebServerThread;
 
+/// Serializes the request threads' use of webAPI, its PhoneAPI state machine is not thread safe
+static std::mutex webAPILock;
+
 /**
  * Return the filename extension
  */
@@ -240,28 +248,85 @@ int handleAPIv1ToRadio(const struct _u_request *req, struct _u_response *res, vo
 
     byte buffer[MAX_TO_FROM_RADIO_SIZE];
     size_t s = req->binary_body_length;
+    // ?framed=true: the body is any number of ToRadios, each with the 4 byte header StreamAPI uses
+    const char *valueFramed = u_map_get(req->map_url, "framed");
+    bool framed = valueFramed && strcmp(valueFramed, "true") == 0;
 
-    memcpy(buffer, req->binary_body, MAX_TO_FROM_RADIO_SIZE);
+    if (!framed)
+        memcpy(buffer, req->binary_body, MAX_TO_FROM_RADIO_SIZE);
 
     // FIXME* Problem with portdunio loosing mountpoint maybe because of running in a real sep. thread
 
     portduinoVFS->mountpoint(configWeb.rootPath);
 
     LOG_DEBUG("Received %d bytes from PUT request", s);
-    static_cast<HttpAPI *>(user_data)->handleToRadio(buffer, s);
+    {
+        std::lock_guard<std::mutex> guard(webAPILock);
+        if (framed)
+            StreamAPI::handleFrames(static_cast<HttpAPI *>(user_data), (const uint8_t *)req->binary_body, s);
+        else
+            static_cast<HttpAPI *>(user_data)->handleToRadio(buffer, s);
+    }
     LOG_DEBUG("end web->radio  ");
     return U_CALLBACK_COMPLETE;
 }
 
+/// State of one ?stream=true response, FromRadios are framed like StreamAPI does over serial and TCP.  Packets that didn't fit in the last block MHD asked for are kept here
+struct FromRadioStream {
+    HttpAPI *api;
+    uint8_t buf[STREAM_TX_BATCH_SIZE];
+    size_t len = 0, pos = 0;
+};
+
+/**
+ * Streaming callback for ?stream=true, runs on the connection's own thread so it may wait for packets
+ */
+static ssize_t callback_fromradio_stream(void *cls, uint64_t pos, char *buf, size_t max)
+{
+    (void)(pos);
+    FromRadioStream *stream = (FromRadioStream *)cls;
+    uint32_t start = millis();
+    while (stream->pos == stream->len) {
+        {
+            std::lock_guard<std::mutex> guard(webAPILock);
+            stream->len = stream->api->getFromRadioBatch(stream->buf, sizeof(stream->buf), sizeof(uint32_t),
+                                                       StreamAPI::writeFrameHeader);
+            stream->pos = 0;
+        }
+        if (stream->len == 0) {
+            // End idle streams now and then, so connections the client has given up on don't stay with us forever
+            if (millis() - start > FROMRADIO_MAX_WAIT_MSEC)
+                return U_STREAM_END;
+            usleep(FROMRADIO_POLL_MSEC * 1000);
+        }
+    }
+
+    size_t n = std::min(max, stream->len - stream->pos);
+    memcpy(buf, stream->buf + stream->pos, n);
+    stream->pos += n;
+    return n;
+}
+
+static void callback_fromradio_stream_free(void *cls)
+{
+    delete (FromRadioStream *)cls;
+}
+
 /*
  * Adapt the radioapi to the Webservice handleAPIv1FromRadio
  * Trigger : WebGui(POLL)->handleAPIv1FromRadio->phoneapi->Meshtastic(Radio) events
+ *
+ * Besides plain polling (one FromRadio per request) clients can use:
+ *  ?all=true   every FromRadio available right now, back to back
+ *  ?framed=true  several FromRadios per response, each framed like the serial API; with all=true every one available
+ *  ?wait=msec  long-poll, if nothing is available yet wait up to msec (at most FROMRADIO_MAX_WAIT_MSEC) for something
+ *  ?stream=true  a chunked response that stays open and delivers each FromRadio as it arrives, framed like the serial API
  */
 int handleAPIv1FromRadio(const struct _u_request *req, struct _u_response *res, void *user_data)
 {
 
     // LOG_DEBUG("handleAPIv1FromRadio radio -> web");
-    std::string valueAll;
+    HttpAPI *api = static_cast<HttpAPI *>(user_data);
 
     // Status code is 200 OK by default.
     ulfius_add_header_to_response(res, "Content-Type", "application/x-protobuf");
@@ -275,33 +340,132 @@ int handleAPIv1FromRadio(const struct _u_request *req, struct _u_response *res,
         return U_CALLBACK_COMPLETE;
     }
 
-    uint8_t txBuf[MAX_STREAM_BUF_SIZE];
-    uint32_t len = 1;
-
-    if (valueAll == "true") {
-        while (len) {
-            len = static_cast<HttpAPI *>(user_data)->getFromRadio(txBuf);
-            ulfius_set_response_properties(res, U_OPT_STATUS, 200, U_OPT_BINARY_BODY, txBuf, len);
-            const char *tmpa = (const char *)txBuf;
-            ulfius_set_string_body_response(res, 200, tmpa);
-            // LOG_DEBUG("\n----webAPI response all:----");
-            // LOG_DEBUG(tmpa);
-            // LOG_DEBUG("");
+    const char *valueAll = u_map_get(req->map_url, "all");
+    const char *valueStream = u_map_get(req->map_url, "stream");
+    const char *valueWait = u_map_get(req->map_url, "wait");
+    const char *valueFramed = u_map_get(req->map_url, "framed");
+    bool all = valueAll && strcmp(valueAll, "true") == 0;
+    bool framed = valueFramed && strcmp(valueFramed, "true") == 0;
+
+    if (valueStream && strcmp(valueStream, "true") == 0) {
+        FromRadioStream *stream = new FromRadioStream();
+        stream->api = api;
+        if (ulfius_set_stream_response(res, 200, callback_fromradio_stream, callback_fromradio_stream_free, MHD_SIZE_UNKNOWN,
+                                       STREAM_TX_BATCH_SIZE, stream) != U_OK) {
+            LOG_DEBUG("handleAPIv1FromRadio - Error ulfius_set_stream_response");
+            delete stream;
+            ulfius_set_response_properties(res, U_OPT_STATUS, 500);
         }
-        // Otherwise, just return one protobuf
-    } else {
-        len = static_cast<HttpAPI *>(user_data)->getFromRadio(txBuf);
-        const char *tmpa = (const char *)txBuf;
-        ulfius_set_binary_body_response(res, 200, tmpa, len);
-        // LOG_DEBUG("\n----webAPI response:");
-        // LOG_DEBUG(tmpa);
-        // LOG_DEBUG("");
+        return U_CALLBACK_COMPLETE;
     }
 
+    if (framed && all) {
+        std::string body;
+        uint8_t txBuf[STREAM_TX_BATCH_SIZE];
+        size_t len;
+        do {
+            std::lock_guard<std::mutex> guard(webAPILock);
+            len = api->getFromRadioBatch(txBuf, sizeof(txBuf), sizeof(uint32_t), StreamAPI::writeFrameHeader);
+            body.append((const char *)txBuf, len);
+        } while (len);
+        ulfius_set_binary_body_response(res, 200, body.data(), body.size());
+        return U_CALLBACK_COMPLETE;
+    }
+
+    uint8_t txBuf[STREAM_TX_BATCH_SIZE];
+    uint32_t waitMsec = valueWait ? std::min((uint32_t)strtoul(valueWait, NULL, 10), (uint32_t)FROMRADIO_MAX_WAIT_MSEC) : 0;
+    uint32_t start = millis();
+    size_t len;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> guard(webAPILock);
+            if (framed)
+                len = api->getFromRadioBatch(txBuf, sizeof(txBuf), sizeof(uint32_t), StreamAPI::writeFrameHeader);
+            else if (all)
+                len = api->getFromRadioBatch(txBuf, sizeof(txBuf));
+            else
+                len = api->getFromRadio(txBuf);
+        }
+        if (len || millis() - start >= waitMsec)
+            break;
+        usleep(FROMRADIO_POLL_MSEC * 1000);
+    }
+
+    ulfius_set_binary_body_response(res, 200, (const char *)txBuf, len);
+
     // LOG_DEBUG("end radio->web", len);
     return U_CALLBACK_COMPLETE;
 }
 
+/// State of one /json/nodes response, the part of the current piece MHD had no room for yet
+struct NodesStream {
+    NodeListSerializer nodes;
+    char piece[NodeListSerializer::PIECE_MAX];
+    size_t len = 0, pos = 0;
+
+    NodesStream(uint32_t offset, uint32_t limit) : nodes(offset, limit) {}
+};
+
+static ssize_t callback_nodes_stream(void *cls, uint64_t pos, char *buf, size_t max)
+{
+    (void)(pos);
+    NodesStream *stream = (NodesStream *)cls;
+    if (stream->pos == stream->len) {
+        stream->len = stream->nodes.next(stream->piece, sizeof(stream->piece));
+        stream->pos = 0;
+        if (stream->len == 0)
+            return U_STREAM_END;
+    }
+
+    size_t n = std::min(max, stream->len - stream->pos);
+    memcpy(buf, stream->piece + stream->pos, n);
+    stream->pos += n;
+    return n;
+}
+
+static void callback_nodes_stream_free(void *cls)
+{
+    delete (NodesStream *)cls;
+}
+
+/*
+ * The node list as JSON, like /json/nodes on ESP32.  ?offset=&limit= page through it, without limit every node is sent.
+ * Streamed a node at a time, so the response takes the same memory however big NodeDB is.
+ */
+int handleNodes(const struct _u_request *req, struct _u_response *res, void *user_data)
+{
+    (void)(user_data);
+    const char *valueOffset = u_map_get(req->map_url, "offset");
+    const char *valueLimit = u_map_get(req->map_url, "limit");
+    uint32_t offset = valueOffset ? strtoul(valueOffset, NULL, 10) : 0;
+    uint32_t limit = valueLimit ? strtoul(valueLimit, NULL, 10) : UINT32_MAX;
+
+    ulfius_add_header_to_response(res, "Content-Type", "application/json");
+    ulfius_add_header_to_response(res, "Access-Control-Allow-Methods", "GET");
+
+    NodesStream *stream = new NodesStream(offset, limit);
+    if (ulfius_set_stream_response(res, 200, callback_nodes_stream, callback_nodes_stream_free, MHD_SIZE_UNKNOWN,
+                                   STATIC_FILE_CHUNK, stream) != U_OK) {
+        LOG_DEBUG("handleNodes - Error ulfius_set_stream_response");
+        delete stream;
+        ulfius_set_response_properties(res, U_OPT_STATUS, 500);
+    }
+    return U_CALLBACK_COMPLETE;
+}
+
+/*
+ * Counters and timings for Prometheus, see PiMetrics
+ */
+int handleMetrics(const struct _u_request *req, struct _u_response *res, void *user_data)
+{
+    (void)(req);
+    (void)(user_data);
+    std::string text = piMetrics->get();
+    ulfius_add_header_to_response(res, "Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+    ulfius_set_binary_body_response(res, 200, text.data(), text.size());
+    return U_CALLBACK_COMPLETE;
+}
+
 /*
 OpenSSL RSA Key Gen
 */
@@ -503,6 +667,10 @@ PiWebServerThread::PiWebServerThread()
         ulfius_add_endpoint_by_val(&instanceWeb, "OPTIONS", PREFIX, "/api/v1/fromradio/*", 1, &handleAPIv1FromRadio, &webAPI);
         ulfius_add_endpoint_by_val(&instanceWeb, "PUT", PREFIX, "/api/v1/toradio/*", 1, &handleAPIv1ToRadio, &webAPI);
         ulfius_add_endpoint_by_val(&instanceWeb, "OPTIONS", PREFIX, "/api/v1/toradio/*", 1, &handleAPIv1ToRadio, &webAPI);
+        ulfius_add_endpoint_by_val(&instanceWeb, "GET", PREFIX, "/json/nodes", 1, &handleNodes, NULL);
+        if (!piMetrics)
+            piMetrics = new PiMetrics();
+        ulfius_add_endpoint_by_val(&instanceWeb, "GET", PREFIX, "/metrics", 1, &handleMetrics, NULL);
 
         // Add callback function to all endpoints for the Web Server
         ulfius_add_endpoint_by_val(&instanceWeb, "GET", NULL, "/*", 2, &callback_static_file, &configWeb);
@@ -2,6 +2,7 @@
 #ifdef PORTDUINO_LINUX_HARDWARE
 #if __has_include(<ulfius.h>)
 #include "PhoneAPI.h"
+#include "StreamAPI.h"
 #include "ulfius-cfg.h"
 #include "ulfius.h"
 #include <Arduino.h>
@@ -9,6 +10,11 @@
 
 #define STATIC_FILE_CHUNK 256
 
+/// Longest a /api/v1/fromradio long-poll (?wait=) or idle stream (?stream=true) is kept open
+#define FROMRADIO_MAX_WAIT_MSEC 30000
+/// How often a waiting /api/v1/fromradio request checks for new packets
+#define FROMRADIO_POLL_MSEC 20
+
 void initWebServer();
 void createSSLCert();
 int callback_static_file(const struct _u_request *request, struct _u_response *response, void *user_data);
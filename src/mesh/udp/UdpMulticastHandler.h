@@ -1,8 +1,13 @@
 #pragma once
 #if HAS_UDP_MULTICAST
 #include "configuration.h"
+#include "concurrency/Lock.h"
+#include "concurrency/LockGuard.h"
+#include "concurrency/OSThread.h"
 #include "main.h"
+#include "mesh/PacketHistory.h"
 #include "mesh/Router.h"
+#include "mesh/StreamAPI.h"
 
 #include <AsyncUDP.h>
 #include <WiFi.h>
@@ -14,10 +19,27 @@
 
 #define UDP_MULTICAST_DEFAUL_PORT 4403 // Default port for UDP multicast is same as TCP api server
 
-class UdpMulticastHandler final
+/**
+ * How long outgoing packets wait for others to share a datagram with, framed like the serial API.  0 sends each packet in a
+ * datagram of its own like older firmware, which can only read those; batches from others are understood either way.
+ */
+#ifndef UDP_MULTICAST_BATCH_MS
+#define UDP_MULTICAST_BATCH_MS 0
+#endif
+
+/// Largest datagram we build, below the ethernet MTU so it is never fragmented
+#define UDP_MULTICAST_MAX_DATAGRAM 1400
+
+/// Packets remembered to drop the copies other gateways on the LAN send back to us
+#define UDP_MULTICAST_HISTORY_SIZE 64
+
+class UdpMulticastHandler final : private concurrency::OSThread
 {
   public:
-    UdpMulticastHandler() { udpIpAddress = IPAddress(224, 0, 0, 69); }
+    UdpMulticastHandler() : concurrency::OSThread("UdpMulticast"), history(UDP_MULTICAST_HISTORY_SIZE)
+    {
+        udpIpAddress = IPAddress(224, 0, 0, 69);
+    }
 
     void start()
     {
@@ -41,18 +63,20 @@ class UdpMulticastHandler final
         // FIXME(PORTDUINO): arduino lacks IPAddress::toString()
         LOG_DEBUG("UDP broadcast from: %s, len=%u", packet.remoteIP().toString().c_str(), packetLength);
 #endif
-        meshtastic_MeshPacket mp;
-        LOG_DEBUG("Decoding MeshPacket from UDP len=%u", packetLength);
-        bool isPacketDecoded = pb_decode_from_bytes(packet.data(), packetLength, &meshtastic_MeshPacket_msg, &mp);
-        if (isPacketDecoded && router && mp.which_payload_variant == meshtastic_MeshPacket_encrypted_tag) {
-            mp.pki_encrypted = false;
-            mp.public_key.size = 0;
-            memset(mp.public_key.bytes, 0, sizeof(mp.public_key.bytes));
-            UniquePacketPoolPacket p = packetPool.allocUniqueCopy(mp);
-            // Unset received SNR/RSSI
-            p->rx_snr = 0;
-            p->rx_rssi = 0;
-            router->enqueueReceivedMessage(p.release());
+        const uint8_t *data = packet.data();
+        if (packetLength < 4 || data[0] != 0x94 || data[1] != 0xc3) {
+            receivePacket(data, packetLength);
+            return;
+        }
+
+        // A batch: each packet framed like StreamAPI does, a protobuf never starts with these bytes
+        size_t pos = 0;
+        while (pos + 4 <= packetLength && data[pos] == 0x94 && data[pos + 1] == 0xc3) {
+            size_t len = (data[pos + 2] << 8) + data[pos + 3];
+            if (pos + 4 + len > packetLength)
+                break;
+            receivePacket(data + pos + 4, len);
+            pos += 4 + len;
         }
     }
 
@@ -66,15 +90,83 @@ class UdpMulticastHandler final
             return false;
         }
 #endif
+        {
+            // Remember it, so we drop it when another gateway sends it back to us
+            concurrency::LockGuard g(&historyLock);
+            history.wasSeenRecently(mp);
+        }
         LOG_DEBUG("Broadcasting packet over UDP (id=%u)", mp->id);
+#if UDP_MULTICAST_BATCH_MS
+        if (txLen + 4 + meshtastic_MeshPacket_size > sizeof(txBuf))
+            flush();
+        size_t encodedLength = pb_encode_to_bytes(txBuf + txLen + 4, meshtastic_MeshPacket_size, &meshtastic_MeshPacket_msg, mp);
+        StreamAPI::writeFrameHeader(txBuf + txLen, encodedLength);
+        if (txLen == 0)
+            setIntervalFromNow(UDP_MULTICAST_BATCH_MS);
+        txLen += 4 + encodedLength;
+#else
         uint8_t buffer[meshtastic_MeshPacket_size];
         size_t encodedLength = pb_encode_to_bytes(buffer, sizeof(buffer), &meshtastic_MeshPacket_msg, mp);
         udp.writeTo(buffer, encodedLength, udpIpAddress, UDP_MULTICAST_DEFAUL_PORT);
+#endif
         return true;
     }
 
+  protected:
+    int32_t runOnce() override
+    {
+#if UDP_MULTICAST_BATCH_MS
+        flush();
+        return INT32_MAX; // until onSend() starts the next batch
+#else
+        return disable();
+#endif
+    }
+
   private:
     IPAddress udpIpAddress;
     AsyncUDP udp;
+
+    /// Packets sent or received over UDP recently, onReceive() runs in the AsyncUDP task so it is shared with the main thread
+    PacketHistory history;
+    concurrency::Lock historyLock;
+
+#if UDP_MULTICAST_BATCH_MS
+    uint8_t txBuf[UDP_MULTICAST_MAX_DATAGRAM];
+    size_t txLen = 0;
+
+    void flush()
+    {
+        if (txLen)
+            udp.writeTo(txBuf, txLen, udpIpAddress, UDP_MULTICAST_DEFAUL_PORT);
+        txLen = 0;
+    }
+#endif
+
+    void receivePacket(const uint8_t *data, size_t len)
+    {
+        meshtastic_MeshPacket mp;
+        LOG_DEBUG("Decoding MeshPacket from UDP len=%u", len);
+        bool isPacketDecoded = pb_decode_from_bytes(data, len, &meshtastic_MeshPacket_msg, &mp);
+        if (!isPacketDecoded || !router || mp.which_payload_variant != meshtastic_MeshPacket_encrypted_tag)
+            return;
+        {
+            // Several gateways on one LAN each send what they hear, don't give the router the same packet over and over
+            concurrency::LockGuard g(&historyLock);
+            if (history.wasSeenRecently(&mp)) {
+                LOG_DEBUG("Drop UDP packet (id=%u) seen before", mp.id);
+                return;
+            }
+        }
+        mp.pki_encrypted = false;
+        mp.public_key.size = 0;
+        memset(mp.public_key.bytes, 0, sizeof(mp.public_key.bytes));
+        UniquePacketPoolPacket p = packetPool.allocUniqueCopy(mp);
+        // Unset received SNR/RSSI and the sender's receive time
+        p->rx_snr = 0;
+        p->rx_rssi = 0;
+        p->rx_time = 0;
+        router->enqueueReceivedMessage(p.release());
+    }
 };
 #endif // HAS_UDP_MULTICAST
\ No newline at end of file
@@ -32,6 +32,11 @@ static void WiFiEvent(WiFiEvent_t event);
 #include <NTPClient.h>
 #endif
 
+#if WIFI_FAST_RECONNECT
+#include <ErriezCRC32.h>
+#include <stddef.h>
+#endif
+
 using namespace concurrency;
 
 // NTP
@@ -62,6 +67,89 @@ Syslog syslog(syslogClient);
 
 Periodic *wifiReconnect;
 
+#if WIFI_FAST_RECONNECT
+/// Where we last joined, kept in RTC memory so it survives a reset or deep sleep
+struct WiFiFastConnect {
+    uint32_t magic;
+    uint32_t credentialsCrc; // of the SSID and PSK this is for
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint32_t ip, gateway, subnet, dns; // DHCP lease, ip is 0 if we have a static address
+    uint32_t leasedAt;                 // Unix time the lease was obtained, 0 if the clock wasn't set
+    uint32_t crc;                      // of everything before it
+};
+static const uint32_t WIFI_FAST_MAGIC = 0x57464331; // "WFC1"
+static RTC_NOINIT_ATTR WiFiFastConnect wifiFast;
+
+static bool wifiFastAttempt = false;  // The connect in progress is a directed one
+static bool wifiFastStaticIp = false; // and uses the remembered lease, DHCP is off until the next full connect
+static uint32_t wifiConnectStartMillis = 0;
+static uint32_t wifiFastConnects = 0, wifiFullConnects = 0;
+
+static uint32_t wifiCredentialsCrc()
+{
+    uint32_t crc = crc32Buffer(config.network.wifi_ssid, strlen(config.network.wifi_ssid));
+    return crc ^ crc32Buffer(config.network.wifi_psk, strlen(config.network.wifi_psk));
+}
+
+static bool wifiFastValid()
+{
+    return wifiFast.magic == WIFI_FAST_MAGIC && wifiFast.crc == crc32Buffer(&wifiFast, offsetof(WiFiFastConnect, crc)) &&
+           wifiFast.credentialsCrc == wifiCredentialsCrc();
+}
+
+/** Join the access point directly if we know it, else scan for it like before. */
+static void wifiBegin(const char *wifiName, const char *wifiPsw)
+{
+    wifiConnectStartMillis = millis();
+    wifiFastAttempt = wifiFastValid();
+    if (!wifiFastAttempt) {
+        if (wifiFastStaticIp) {
+            WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE); // Back to DHCP
+            wifiFastStaticIp = false;
+        }
+        WiFi.begin(wifiName, wifiPsw);
+        return;
+    }
+
+    uint32_t now = getValidTime(RTCQualityDevice);
+    if (config.network.address_mode == meshtastic_Config_NetworkConfig_AddressMode_DHCP && wifiFast.ip && wifiFast.leasedAt &&
+        now >= wifiFast.leasedAt && now - wifiFast.leasedAt < WIFI_FAST_LEASE_SECS) {
+        WiFi.config(wifiFast.ip, wifiFast.gateway, wifiFast.subnet, wifiFast.dns);
+        wifiFastStaticIp = true;
+    }
+    LOG_INFO("Join WiFi access point %02x:%02x:%02x:%02x:%02x:%02x directly on channel %u%s", wifiFast.bssid[0],
+             wifiFast.bssid[1], wifiFast.bssid[2], wifiFast.bssid[3], wifiFast.bssid[4], wifiFast.bssid[5], wifiFast.channel,
+             wifiFastStaticIp ? ", reusing DHCP lease" : "");
+    WiFi.begin(wifiName, wifiPsw, wifiFast.channel, wifiFast.bssid);
+}
+
+/** We have an address: remember how we got here for next time, and log how long it took. */
+static void wifiFastRemember()
+{
+    uint32_t took = millis() - wifiConnectStartMillis;
+    (wifiFastAttempt ? wifiFastConnects : wifiFullConnects)++;
+    LOG_INFO("WiFi connected in %u ms (%s), %u direct and %u full connects since boot", took, wifiFastAttempt ? "direct" : "full",
+             wifiFastConnects, wifiFullConnects);
+    wifiFastAttempt = false;
+
+    uint32_t leasedAt = wifiFast.leasedAt; // A reused lease is no newer than it was
+    memset(&wifiFast, 0, sizeof(wifiFast));
+    wifiFast.credentialsCrc = wifiCredentialsCrc();
+    memcpy(wifiFast.bssid, WiFi.BSSID(), sizeof(wifiFast.bssid));
+    wifiFast.channel = WiFi.channel();
+    if (config.network.address_mode == meshtastic_Config_NetworkConfig_AddressMode_DHCP) {
+        wifiFast.ip = WiFi.localIP();
+        wifiFast.gateway = WiFi.gatewayIP();
+        wifiFast.subnet = WiFi.subnetMask();
+        wifiFast.dns = WiFi.dnsIP();
+        wifiFast.leasedAt = wifiFastStaticIp ? leasedAt : getValidTime(RTCQualityDevice);
+    }
+    wifiFast.magic = WIFI_FAST_MAGIC;
+    wifiFast.crc = crc32Buffer(&wifiFast, offsetof(WiFiFastConnect, crc));
+}
+#endif
+
 #ifdef USE_WS5500
 // Startup Ethernet
 bool initEthernet()
@@ -149,6 +237,16 @@ static void onNetworkConnected()
 #endif
 }
 
+/// @return how long to let the old connection go before connecting again
+static uint32_t reconnectWait()
+{
+#if WIFI_FAST_RECONNECT
+    if (wifiFastValid())
+        return WIFI_FAST_RECONNECT_WAIT_MS;
+#endif
+    return 5000;
+}
+
 static int32_t reconnectWiFi()
 {
     const char *wifiName = config.network.wifi_ssid;
@@ -170,23 +268,27 @@ static int32_t reconnectWiFi()
 #endif
         LOG_INFO("Reconnecting to WiFi access point %s", wifiName);
 
-        // Start the non-blocking wait for 5 seconds
+        // Start the non-blocking wait, 5 seconds unless we can join the access point directly
         wifiReconnectStartMillis = millis();
         wifiReconnectPending = true;
         // Do not attempt to connect yet, wait for the next invocation
-        return 5000; // Schedule next check soon
+        return reconnectWait(); // Schedule next check soon
     }
 
-    // Check if we are ready to proceed with the WiFi connection after the 5s wait
+    // Check if we are ready to proceed with the WiFi connection after the wait
     if (wifiReconnectPending) {
-        if (millis() - wifiReconnectStartMillis >= 5000) {
+        if (millis() - wifiReconnectStartMillis >= reconnectWait()) {
             if (!WiFi.isConnected()) {
 #ifdef CONFIG_IDF_TARGET_ESP32C3
                 WiFi.mode(WIFI_MODE_NULL);
                 WiFi.useStaticBuffers(true);
                 WiFi.mode(WIFI_STA);
 #endif
+#if WIFI_FAST_RECONNECT
+                wifiBegin(wifiName, wifiPsw);
+#else
                 WiFi.begin(wifiName, wifiPsw);
+#endif
             }
             isReconnecting = false;
             wifiReconnectPending = false;
@@ -356,6 +458,13 @@ static void WiFiEvent(WiFiEvent_t event)
         LOG_INFO("Disconnected from WiFi access point");
 #ifdef WIFI_LED
         digitalWrite(WIFI_LED, LOW);
+#endif
+#if WIFI_FAST_RECONNECT
+        if (wifiFastAttempt) {
+            LOG_INFO("Joining the remembered access point failed, scan next time");
+            wifiFast.magic = 0;
+            wifiFastAttempt = false;
+        }
 #endif
         if (!isReconnecting) {
             WiFi.disconnect(false, true);
@@ -369,6 +478,9 @@ static void WiFiEvent(WiFiEvent_t event)
         break;
     case ARDUINO_EVENT_WIFI_STA_GOT_IP:
         LOG_INFO("Obtained IP address: %s", WiFi.localIP().toString().c_str());
+#if WIFI_FAST_RECONNECT
+        wifiFastRemember();
+#endif
         onNetworkConnected();
         break;
     case ARDUINO_EVENT_WIFI_STA_GOT_IP6:
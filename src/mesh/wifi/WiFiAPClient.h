@@ -14,6 +14,17 @@
 #define ETH ETH2
 #endif // HAS_ETHERNET
 
+/// ESP32: remember the access point (BSSID and channel) and the DHCP lease of the last connection in RTC memory, so the next
+/// connect, also after a reboot or deep sleep, joins that access point directly instead of scanning, and skips DHCP
+#ifndef WIFI_FAST_RECONNECT
+#define WIFI_FAST_RECONNECT 0
+#endif
+#define WIFI_FAST_LEASE_SECS 3600     // Only reuse a DHCP lease this recent, the server may give the address away after that
+#define WIFI_FAST_RECONNECT_WAIT_MS 1000 // Settle time after dropping the old connection, instead of 5s, when joining directly
+#if WIFI_FAST_RECONNECT && HAS_WIFI && !defined(ARCH_ESP32)
+#error "WIFI_FAST_RECONNECT is only implemented for ESP32"
+#endif
+
 extern bool needReconnect;
 extern concurrency::Periodic *wifiReconnect;
 
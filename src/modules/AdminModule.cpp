@@ -2,9 +2,11 @@
 #include "Channels.h"
 #include "MeshService.h"
 #include "NodeDB.h"
+#include "PayloadCompression.h"
 #include "PowerFSM.h"
 #include "RTC.h"
 #include "SPILock.h"
+#include "concurrency/OSThread.h"
 #include "input/InputBroker.h"
 #include "meshUtils.h"
 #include <FSCommon.h>
@@ -32,6 +34,10 @@
 #include "mqtt/MQTT.h"
 #endif
 
+#if ADMIN_BULK_CONFIG
+#include "modules/BulkTransferModule.h"
+#endif
+
 #if !MESHTASTIC_EXCLUDE_GPS
 #include "GPS.h"
 #endif
@@ -134,6 +140,24 @@ bool AdminModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, meshta
 
     case meshtastic_AdminMessage_get_config_request_tag:
         LOG_DEBUG("Client got config");
+#if OSTHREAD_PROFILE && PRIVATE_BITFIELD_FLAGS
+        if ((uint32_t)r->get_config_request & ADMIN_THREAD_PROFILE_FLAG) {
+            handleGetThreadProfiles(mp, r->get_config_request);
+            break;
+        }
+#endif
+#if AIRTIME_SERIES && PRIVATE_BITFIELD_FLAGS
+        if (r->get_config_request & ADMIN_AIRTIME_SERIES_FLAG) {
+            handleGetAirtimeSeries(mp, r->get_config_request);
+            break;
+        }
+#endif
+#if ADMIN_BULK_CONFIG
+        if ((r->get_config_request & ADMIN_BULK_REQUEST_FLAG) && mp.from != 0 && bulkTransferModule) {
+            handleGetConfigBulk(mp);
+            break;
+        }
+#endif
         handleGetConfig(mp, r->get_config_request);
         break;
 
@@ -321,7 +345,7 @@ bool AdminModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, meshta
         LOG_INFO("Client received set_favorite_node command");
         meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(r->set_favorite_node);
         if (node != NULL) {
-            node->is_favorite = true;
+            nodeDB->setFavorite(true, r->set_favorite_node);
             saveChanges(SEGMENT_NODEDATABASE, false);
             if (screen)
                 screen->setFrames(graphics::Screen::FOCUS_PRESERVE); // <-- Rebuild screens
@@ -332,7 +356,7 @@ bool AdminModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, meshta
         LOG_INFO("Client received remove_favorite_node command");
         meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(r->remove_favorite_node);
         if (node != NULL) {
-            node->is_favorite = false;
+            nodeDB->setFavorite(false, r->remove_favorite_node);
             saveChanges(SEGMENT_NODEDATABASE, false);
             if (screen)
                 screen->setFrames(graphics::Screen::FOCUS_PRESERVE); // <-- Rebuild screens
@@ -344,6 +368,7 @@ bool AdminModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, meshta
         meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(r->set_ignored_node);
         if (node != NULL) {
             node->is_ignored = true;
+            nodeDB->markNodeChanged(node->num);
             node->has_device_metrics = false;
             node->has_position = false;
             node->user.public_key.size = 0;
@@ -357,6 +382,7 @@ bool AdminModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, meshta
         meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(r->remove_ignored_node);
         if (node != NULL) {
             node->is_ignored = false;
+            nodeDB->markNodeChanged(node->num);
             saveChanges(SEGMENT_NODEDATABASE, false);
         }
         break;
@@ -366,6 +392,7 @@ bool AdminModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, meshta
         meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(nodeDB->getNodeNum());
         node->has_position = true;
         node->position = TypeConversions::ConvertToPositionLite(r->set_fixed_position);
+        nodeDB->indexPosition(node);
         nodeDB->setLocalPosition(r->set_fixed_position);
         config.position.fixed_position = true;
         saveChanges(SEGMENT_NODEDATABASE | SEGMENT_CONFIG, false);
@@ -404,13 +431,14 @@ bool AdminModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, meshta
         LOG_DEBUG("Client requesting to delete file: %s", r->delete_file_request);
 
 #ifdef FSCom
-        spiLock->lock();
+        fsLock->lock();
         if (FSCom.remove(r->delete_file_request)) {
             LOG_DEBUG("Successfully deleted file");
+            invalidateFileManifest();
         } else {
             LOG_DEBUG("Failed to delete file");
         }
-        spiLock->unlock();
+        fsLock->unlock();
 #endif
         break;
     }
@@ -440,9 +468,10 @@ bool AdminModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, meshta
         LOG_INFO("Client requesting to remove backup preferences");
 #ifdef FSCom
         if (r->remove_backup_preferences == meshtastic_AdminMessage_BackupLocation_FLASH) {
-            spiLock->lock();
+            fsLock->lock();
             FSCom.remove(backupFileName);
-            spiLock->unlock();
+            fsLock->unlock();
+            invalidateFileManifest();
         } else if (r->remove_backup_preferences == meshtastic_AdminMessage_BackupLocation_SD) {
             // TODO: After more mainline SD card support
             LOG_ERROR("SD backup removal not implemented yet");
@@ -633,6 +662,14 @@ void AdminModule::handleSetConfig(const meshtastic_Config &c)
             config.device.role == meshtastic_Config_DeviceConfig_Role_REPEATER) {
             config.device.role = meshtastic_Config_DeviceConfig_Role_CLIENT;
         }
+#endif
+#ifdef ROUTER_FIXED_ROLE
+        if (config.device.role != ROUTER_FIXED_ROLE) {
+            config.device.role = ROUTER_FIXED_ROLE;
+            const char *warning = "This firmware is built for one role only, it can't be changed";
+            LOG_WARN(warning);
+            sendWarning(warning);
+        }
 #endif
         break;
     case meshtastic_Config_position_tag:
@@ -1186,6 +1223,282 @@ void AdminModule::handleGetDeviceUIConfig(const meshtastic_MeshPacket &req)
     myReply = allocDataProtobuf(r);
 }
 
+bool AdminModule::wantPacket(const meshtastic_MeshPacket *p)
+{
+#if PRIVATE_BITFIELD_FLAGS
+    return SinglePortModule::wantPacket(p) &&
+           !(p->decoded.has_bitfield &&
+             (p->decoded.bitfield & BITFIELD_ADMIN_RAW_ANSWER_MASK));
+#else
+    return SinglePortModule::wantPacket(p);
+#endif
+}
+
+#if AIRTIME_SERIES && PRIVATE_BITFIELD_FLAGS
+/// Answer a request for AirTime's series (see ADMIN_AIRTIME_SERIES_FLAG), as many buckets as fit in one packet
+void AdminModule::handleGetAirtimeSeries(const meshtastic_MeshPacket &req, uint32_t request)
+{
+    if (!req.decoded.want_response)
+        return;
+
+    uint8_t level = request & 0xff;
+    uint8_t start = (request >> 8) & 0xff;
+    if (!airTime || level >= AirTime::SERIES_LEVELS || start >= AIRTIME_SERIES_BUCKETS - 1) {
+        myReply = allocErrorResponse(meshtastic_Routing_Error_BAD_REQUEST, &req);
+        return;
+    }
+
+    // Leaves room for PKI encryption
+    const size_t fits = (meshtastic_Constants_DATA_PAYLOAD_LEN - MESHTASTIC_PKC_OVERHEAD - ADMIN_AIRTIME_SERIES_HEADER_SIZE) /
+                        sizeof(AirtimeBucket);
+    uint8_t count = min(fits, (size_t)(AIRTIME_SERIES_BUCKETS - 1 - start)); // bucket 0 is still filling
+
+    meshtastic_MeshPacket *p = allocDataPacket();
+    uint8_t *bytes = p->decoded.payload.bytes;
+    bytes[0] = level;
+    bytes[1] = start;
+    bytes[2] = count;
+    bytes[3] = AirTime::getSeriesBucketSecs((AirTime::SeriesLevel)level);
+    for (uint8_t i = 0; i < count; i++)
+        memcpy(bytes + ADMIN_AIRTIME_SERIES_HEADER_SIZE + i * sizeof(AirtimeBucket),
+               &airTime->getSeriesBucket((AirTime::SeriesLevel)level, 1 + start + i), sizeof(AirtimeBucket));
+    p->decoded.payload.size = ADMIN_AIRTIME_SERIES_HEADER_SIZE + count * sizeof(AirtimeBucket);
+    p->decoded.has_bitfield = true;
+    p->decoded.bitfield |= BITFIELD_ADMIN_RAW_ANSWER_MASK;
+    setReplyTo(p, req);
+    myReply = p;
+}
+#endif
+
+#if OSTHREAD_PROFILE && PRIVATE_BITFIELD_FLAGS
+/// Answer a request for the thread profiles (see ADMIN_THREAD_PROFILE_FLAG), as many threads as fit in one packet
+void AdminModule::handleGetThreadProfiles(const meshtastic_MeshPacket &req, uint32_t request)
+{
+    if (!req.decoded.want_response)
+        return;
+
+    struct Page {
+        uint8_t first, count, ran, fits;
+        AdminThreadProfile *out;
+    };
+    // Leaves room for PKI encryption
+    const size_t fits = (meshtastic_Constants_DATA_PAYLOAD_LEN - MESHTASTIC_PKC_OVERHEAD - ADMIN_THREAD_PROFILE_HEADER_SIZE) /
+                        sizeof(AdminThreadProfile);
+
+    meshtastic_MeshPacket *p = allocDataPacket();
+    uint8_t *bytes = p->decoded.payload.bytes;
+    Page page = {(uint8_t)(request & 0xff), 0, 0, (uint8_t)fits,
+                 (AdminThreadProfile *)(bytes + ADMIN_THREAD_PROFILE_HEADER_SIZE)};
+    concurrency::OSThread::forEachProfile(
+        [](const concurrency::OSThread *t, void *context) {
+            Page *page = (Page *)context;
+            const concurrency::OSThread::Profile &profile = t->getProfile();
+            if (!profile.calls)
+                return;
+            if (page->ran++ < page->first || page->count >= page->fits)
+                return;
+            AdminThreadProfile out = {};
+            strncpy(out.name, t->ThreadName.c_str(), sizeof(out.name));
+            out.calls = profile.calls;
+            out.avgMicros = profile.totalMicros / profile.calls;
+            out.maxMicros = profile.maxMicros;
+            out.avgLateMsec = profile.totalLateMsec / profile.calls;
+            out.maxLateMsec = profile.maxLateMsec;
+            memcpy(&page->out[page->count++], &out, sizeof(out));
+        },
+        &page);
+    if (request & ADMIN_THREAD_PROFILE_RESET)
+        concurrency::OSThread::resetProfiles();
+
+    bytes[0] = page.first;
+    bytes[1] = page.count;
+    bytes[2] = page.ran;
+    bytes[3] = 0;
+    p->decoded.payload.size = ADMIN_THREAD_PROFILE_HEADER_SIZE + page.count * sizeof(AdminThreadProfile);
+    p->decoded.has_bitfield = true;
+    p->decoded.bitfield |= BITFIELD_ADMIN_RAW_ANSWER_MASK;
+    setReplyTo(p, req);
+    myReply = p;
+}
+#endif
+
+#if ADMIN_BULK_CONFIG
+#define ADMIN_BULK_DELIVERY_INTERVAL_MS 20
+
+/**
+ * Hands the responses in a bulk config snapshot to the phone, each once the ToPhone queue is empty again, so they don't push
+ * each other (or anything else) out of it.
+ */
+class AdminBulkDelivery : public concurrency::OSThread
+{
+  public:
+    AdminBulkDelivery() : OSThread("AdminBulk") {}
+
+    void start(NodeNum _from, ChannelIndex _channel, uint32_t _requestId, std::vector<uint8_t> &_snapshot)
+    {
+        from = _from;
+        channel = _channel;
+        requestId = _requestId;
+        snapshot.swap(_snapshot);
+        at = 0;
+        enabled = true;
+        setIntervalFromNow(0);
+    }
+
+  protected:
+    int32_t runOnce() override
+    {
+        if (!service->isToPhoneQueueEmpty())
+            return ADMIN_BULK_DELIVERY_INTERVAL_MS;
+
+        size_t size = at + 2 <= snapshot.size() ? snapshot[at] | (snapshot[at + 1] << 8) : 0;
+        if (!size || size > meshtastic_Constants_DATA_PAYLOAD_LEN || at + 2 + size > snapshot.size()) {
+            if (at != snapshot.size())
+                LOG_WARN("Bulk config snapshot from 0x%x is damaged at %u", from, (unsigned)at);
+            std::vector<uint8_t>().swap(snapshot);
+            return disable();
+        }
+
+        meshtastic_MeshPacket *p = router->allocForSending();
+        p->from = from;
+        p->to = nodeDB->getNodeNum();
+        p->channel = channel;
+        p->decoded.portnum = meshtastic_PortNum_ADMIN_APP;
+        p->decoded.request_id = requestId;
+        memcpy(p->decoded.payload.bytes, snapshot.data() + at + 2, size);
+        p->decoded.payload.size = size;
+        service->sendToPhone(p);
+        at += 2 + size;
+        return ADMIN_BULK_DELIVERY_INTERVAL_MS;
+    }
+
+  private:
+    NodeNum from = 0;
+    ChannelIndex channel = 0;
+    uint32_t requestId = 0;
+    std::vector<uint8_t> snapshot;
+    size_t at = 0;
+};
+
+static AdminBulkDelivery *bulkDelivery;
+
+/// Answer a bulk config request (see ADMIN_BULK_REQUEST_FLAG) with a snapshot sent by BulkTransferModule
+void AdminModule::handleGetConfigBulk(const meshtastic_MeshPacket &req)
+{
+    if (!req.decoded.want_response)
+        return;
+
+    uint8_t *data = (uint8_t *)malloc(ADMIN_BULK_HEADER_SIZE + ADMIN_BULK_MAX_SIZE);
+    size_t len = data ? buildBulkSnapshot(req, data + ADMIN_BULK_HEADER_SIZE) : 0;
+    if (!len) {
+        free(data);
+        myReply = allocErrorResponse(meshtastic_Routing_Error_TOO_LARGE, &req);
+        return;
+    }
+    data[0] = req.id;
+    data[1] = req.id >> 8;
+    data[2] = req.id >> 16;
+    data[3] = req.id >> 24;
+    data[4] = 0;
+    uint8_t *packed = (uint8_t *)malloc(ADMIN_BULK_HEADER_SIZE + len);
+    size_t packedLen = packed ? PayloadCompression::compress(data + ADMIN_BULK_HEADER_SIZE, len, packed + ADMIN_BULK_HEADER_SIZE,
+                                                             len)
+                              : 0;
+    if (packedLen) {
+        memcpy(packed, data, ADMIN_BULK_HEADER_SIZE);
+        packed[4] = 1;
+        free(data);
+        data = packed;
+        len = packedLen;
+    } else {
+        free(packed);
+    }
+
+    if (bulkXfer)
+        bulkTransferModule->cancel(bulkXfer); // Asked again, the requester gave up on that one
+    bulkXfer = bulkTransferModule->send(getFrom(&req), req.channel, BulkTransferModule::KIND_ADMIN, data,
+                                        ADMIN_BULK_HEADER_SIZE + len, [](uint16_t xfer, bool delivered) {
+                                            if (adminModule && adminModule->bulkXfer == xfer)
+                                                adminModule->bulkXfer = 0;
+                                        });
+    free(data);
+    LOG_INFO("Bulk config snapshot for 0x%x: %u bytes in transfer %u", getFrom(&req), ADMIN_BULK_HEADER_SIZE + (unsigned)len,
+             bulkXfer);
+    myReply = allocErrorResponse(bulkXfer ? meshtastic_Routing_Error_NONE : meshtastic_Routing_Error_TOO_LARGE, &req);
+}
+
+/// Collect what each get request would have returned into out
+size_t AdminModule::buildBulkSnapshot(const meshtastic_MeshPacket &req, uint8_t *out)
+{
+    // The get handlers leave their answer in myReply, take it from there
+    size_t len = 0;
+    bool fits = true;
+    auto take = [&]() {
+        if (!myReply)
+            return;
+        const meshtastic_Data_payload_t &payload = myReply->decoded.payload;
+        if (len + 2 + payload.size <= ADMIN_BULK_MAX_SIZE) {
+            out[len++] = payload.size & 0xff;
+            out[len++] = payload.size >> 8;
+            memcpy(out + len, payload.bytes, payload.size);
+            len += payload.size;
+        } else {
+            fits = false;
+        }
+        packetPool.release(myReply);
+        myReply = NULL;
+    };
+
+    handleGetOwner(req);
+    take();
+    handleGetDeviceMetadata(req);
+    take();
+    for (uint32_t t = meshtastic_AdminMessage_ConfigType_DEVICE_CONFIG; t <= meshtastic_AdminMessage_ConfigType_SECURITY_CONFIG;
+         t++) {
+        handleGetConfig(req, t);
+        take();
+    }
+    for (uint32_t t = _meshtastic_AdminMessage_ModuleConfigType_MIN; t <= _meshtastic_AdminMessage_ModuleConfigType_MAX; t++) {
+        handleGetModuleConfig(req, t);
+        take();
+    }
+    for (uint32_t i = 0; i < MAX_NUM_CHANNELS; i++) {
+        handleGetChannel(req, i);
+        take();
+    }
+    if (!fits) {
+        LOG_WARN("Bulk config snapshot is over %u bytes", ADMIN_BULK_MAX_SIZE);
+        return 0;
+    }
+    return len;
+}
+
+void AdminModule::handleBulkConfig(NodeNum from, ChannelIndex channel, const uint8_t *data, size_t len)
+{
+    if (len < ADMIN_BULK_HEADER_SIZE)
+        return;
+    uint32_t requestId = data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+    std::vector<uint8_t> snapshot;
+    if (data[4] & 1) {
+        snapshot.resize(ADMIN_BULK_MAX_SIZE);
+        int n = PayloadCompression::decompress(data + ADMIN_BULK_HEADER_SIZE, len - ADMIN_BULK_HEADER_SIZE, snapshot.data(),
+                                               snapshot.size());
+        if (n < 0) {
+            LOG_WARN("Bulk config snapshot from 0x%x doesn't decompress", from);
+            return;
+        }
+        snapshot.resize(n);
+    } else {
+        snapshot.assign(data + ADMIN_BULK_HEADER_SIZE, data + len);
+    }
+
+    LOG_INFO("Bulk config snapshot from 0x%x: %u bytes", from, (unsigned)snapshot.size());
+    if (!bulkDelivery)
+        bulkDelivery = new AdminBulkDelivery();
+    bulkDelivery->start(from, channel, requestId, snapshot);
+}
+#endif
+
 void AdminModule::reboot(int32_t seconds)
 {
     LOG_INFO("Reboot in %d seconds", seconds);
@@ -1198,7 +1511,7 @@ void AdminModule::saveChanges(int saveWhat, bool shouldReboot)
 {
     if (!hasOpenEditTransaction) {
         LOG_INFO("Save changes to disk");
-        service->reloadConfig(saveWhat); // Calls saveToDisk among other things
+        service->reloadConfig(saveWhat); // Schedules the save with saveToDiskSoon(), among other things
     } else {
         LOG_INFO("Delay save of changes to disk until the open transaction is committed");
     }
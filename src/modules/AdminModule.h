@@ -2,10 +2,69 @@
 
 #pragma once
 #include "ProtobufModule.h"
+#include "airtime.h"
 #if HAS_WIFI
 #include "mesh/wifi/WiFiAPClient.h"
 #endif
 
+/// Set to 1 to answer bulk config requests and take their answers, see AdminModule::handleGetConfigBulk
+#ifndef ADMIN_BULK_CONFIG
+#define ADMIN_BULK_CONFIG 0
+#endif
+#if ADMIN_BULK_CONFIG && MESHTASTIC_EXCLUDE_BULKTRANSFER
+#error "ADMIN_BULK_CONFIG sends its snapshots with BulkTransferModule, build with MESHTASTIC_EXCLUDE_BULKTRANSFER=0"
+#endif
+
+/**
+ * A get_config_request with ADMIN_BULK_REQUEST_FLAG set, from another node, asks for the owner, device metadata and every config,
+ * module config and channel at once.  The request is acknowledged, and the answer is a snapshot sent as a BulkTransferModule
+ * transfer of KIND_ADMIN: a 5 byte header (the request's id, 1 if compressed) and the AdminMessage responses a get request
+ * for each would have returned, each prefixed with its length (2 bytes, little endian), compressed with PayloadCompression
+ * when that makes it shorter.  The requesting node hands those responses to its phone one by one, as if each had been
+ * asked for.
+ *
+ * Firmware without this (or a request from our own phone, which has want_config) gets an empty get_config_response, the
+ * requester then falls back to one request per section.
+ */
+#define ADMIN_BULK_REQUEST_FLAG (1 << 30)
+#define ADMIN_BULK_HEADER_SIZE 5
+
+/// Largest snapshot before compression
+#ifndef ADMIN_BULK_MAX_SIZE
+#define ADMIN_BULK_MAX_SIZE (6 * 1024)
+#endif
+
+/**
+ * A get_config_request with ADMIN_AIRTIME_SERIES_FLAG set asks for AirTime's series (AIRTIME_SERIES): the low byte picks the
+ * ring (AirTime::SeriesLevel), the next one how many complete buckets back from the newest to start.  The answer is an ADMIN_APP
+ * packet with BITFIELD_ADMIN_RAW_ANSWER set, whose payload is not an AdminMessage but a 4 byte header (ring, start, bucket count,
+ * seconds per bucket) and that many AirtimeBuckets, newest first.  Ask again with a later start for older ones.  Only answered
+ * with PRIVATE_BITFIELD_FLAGS.
+ */
+#define ADMIN_AIRTIME_SERIES_FLAG (1 << 29)
+#define ADMIN_AIRTIME_SERIES_HEADER_SIZE 4
+
+/**
+ * A get_config_request with ADMIN_THREAD_PROFILE_FLAG set asks for the OSThread profiles (OSTHREAD_PROFILE): the low byte is the
+ * first thread to send, counting only threads that have run, and ADMIN_THREAD_PROFILE_RESET starts the profiles over once
+ * they are sent.  The answer is an ADMIN_APP packet with BITFIELD_ADMIN_RAW_ANSWER set, whose payload is not an AdminMessage but
+ * a 4 byte header (first, count, threads that have run, 0) and that many AdminThreadProfiles.  Ask again with a later first
+ * for the rest.  Only answered with PRIVATE_BITFIELD_FLAGS.
+ */
+#define ADMIN_THREAD_PROFILE_FLAG (1u << 31)
+#define ADMIN_THREAD_PROFILE_RESET (1 << 8)
+#define ADMIN_THREAD_PROFILE_HEADER_SIZE 4
+
+/// One thread of an ADMIN_THREAD_PROFILE_FLAG answer, little endian
+struct __attribute__((packed)) AdminThreadProfile {
+    char name[8]; // truncated, NUL padded
+    uint32_t calls;
+    uint32_t avgMicros;
+    uint32_t maxMicros;
+    uint32_t avgLateMsec;
+    uint32_t maxLateMsec;
+};
+
 /**
  * Datatype passed to Observers by AdminModule, to allow external handling of admin messages
  */
@@ -26,6 +85,11 @@ class AdminModule : public ProtobufModule<meshtastic_AdminMessage>, public Obser
      */
     AdminModule();
 
+#if ADMIN_BULK_CONFIG
+    /// Takes KIND_ADMIN bulk transfers, the answers to bulk config requests, for BulkTransferModule
+    static void handleBulkConfig(NodeNum from, ChannelIndex channel, const uint8_t *data, size_t len);
+#endif
+
   protected:
     /** Called to handle a particular incoming message
 
@@ -33,6 +97,9 @@ class AdminModule : public ProtobufModule<meshtastic_AdminMessage>, public Obser
     */
     virtual bool handleReceivedProtobuf(const meshtastic_MeshPacket &mp, meshtastic_AdminMessage *p) override;
 
+    /// Raw answers aren't AdminMessages, they are only for the phone
+    virtual bool wantPacket(const meshtastic_MeshPacket *p) override;
+
   private:
     bool hasOpenEditTransaction = false;
 
@@ -53,6 +120,19 @@ class AdminModule : public ProtobufModule<meshtastic_AdminMessage>, public Obser
     void handleGetDeviceConnectionStatus(const meshtastic_MeshPacket &req);
     void handleGetNodeRemoteHardwarePins(const meshtastic_MeshPacket &req);
     void handleGetDeviceUIConfig(const meshtastic_MeshPacket &req);
+#if AIRTIME_SERIES
+    void handleGetAirtimeSeries(const meshtastic_MeshPacket &req, uint32_t request);
+#endif
+#if OSTHREAD_PROFILE
+    void handleGetThreadProfiles(const meshtastic_MeshPacket &req, uint32_t request);
+#endif
+#if ADMIN_BULK_CONFIG
+    void handleGetConfigBulk(const meshtastic_MeshPacket &req);
+    /// @return the snapshot's length in out (ADMIN_BULK_MAX_SIZE long), 0 if it doesn't fit
+    size_t buildBulkSnapshot(const meshtastic_MeshPacket &req, uint8_t *out);
+
+    uint16_t bulkXfer = 0; // the snapshot being sent, to cancel it if it is asked for again
+#endif
     /**
      * Setters
      */
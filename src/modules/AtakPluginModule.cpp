@@ -61,6 +61,71 @@ meshtastic_TAKPacket AtakPluginModule::cloneTAKPacketData(meshtastic_TAKPacket *
     return clone;
 }
 
+int AtakPluginModule::compressCached(CompressedField &cache, const char *source, char *out, size_t outSize)
+{
+    if (cache.length < 0 || strncmp(cache.source, source, sizeof(cache.source)) != 0) {
+        cache.length = unishox2_compress_lines(source, strlen(source), cache.compressed, sizeof(cache.compressed) - 1,
+                                               USX_PSET_DFLT, NULL);
+        if (cache.length < 0)
+            return cache.length;
+        cache.compressed[cache.length] = '\0';
+        strncpy(cache.source, source, sizeof(cache.source) - 1);
+    }
+    if ((size_t)cache.length >= outSize)
+        return -1;
+    memcpy(out, cache.compressed, cache.length + 1);
+    return cache.length;
+}
+
+#if ATAK_DELTA_PLI
+void AtakPluginModule::omitUnchanged(meshtastic_TAKPacket &t)
+{
+    bool unchanged = t.has_contact == sentHasContact && t.has_group == sentHasGroup &&
+                     (!t.has_contact || memcmp(&t.contact, &sentContact, sizeof(sentContact)) == 0) &&
+                     (!t.has_group || memcmp(&t.group, &sentGroup, sizeof(sentGroup)) == 0);
+    if (unchanged && (t.has_contact || t.has_group) && plisSinceFull + 1 < ATAK_DELTA_PLI_FULL_EVERY) {
+        LOG_DEBUG("Contact and group unchanged, leave them out of the PLI");
+        t.has_contact = false;
+        t.has_group = false;
+        plisSinceFull++;
+        return;
+    }
+    sentHasContact = t.has_contact;
+    sentHasGroup = t.has_group;
+    sentContact = t.contact;
+    sentGroup = t.group;
+    plisSinceFull = 0;
+}
+
+void AtakPluginModule::restoreOmitted(NodeNum from, meshtastic_TAKPacket *t)
+{
+    PeerContact *peer = NULL;
+    for (PeerContact &p : peers) {
+        if (p.from == from) {
+            peer = &p;
+            break;
+        }
+    }
+
+    if (t->has_contact || t->has_group) {
+        if (!peer) {
+            peer = &peers[nextPeer];
+            nextPeer = (nextPeer + 1) % ATAK_DELTA_PLI_TRACKED;
+            peer->from = from;
+        }
+        peer->hasContact = t->has_contact;
+        peer->hasGroup = t->has_group;
+        peer->contact = t->contact;
+        peer->group = t->group;
+    } else if (peer) {
+        t->has_contact = peer->hasContact;
+        t->has_group = peer->hasGroup;
+        t->contact = peer->contact;
+        t->group = peer->group;
+    }
+}
+#endif
+
 void AtakPluginModule::alterReceivedProtobuf(meshtastic_MeshPacket &mp, meshtastic_TAKPacket *t)
 {
     // From Phone (EUD)
@@ -70,16 +135,15 @@ void AtakPluginModule::alterReceivedProtobuf(meshtastic_MeshPacket &mp, meshtast
         auto compressed = cloneTAKPacketData(t);
         compressed.is_compressed = true;
         if (t->has_contact) {
-            auto length = unishox2_compress_lines(t->contact.callsign, strlen(t->contact.callsign), compressed.contact.callsign,
-                                                  sizeof(compressed.contact.callsign) - 1, USX_PSET_DFLT, NULL);
+            auto length = compressCached(callsignCache, t->contact.callsign, compressed.contact.callsign,
+                                         sizeof(compressed.contact.callsign));
             if (length < 0) {
                 LOG_WARN("Compress overflow contact.callsign. Revert to uncompressed packet");
                 return;
             }
             LOG_DEBUG("Compressed callsign: %d bytes", length);
-            length = unishox2_compress_lines(t->contact.device_callsign, strlen(t->contact.device_callsign),
-                                             compressed.contact.device_callsign, sizeof(compressed.contact.device_callsign) - 1,
-                                             USX_PSET_DFLT, NULL);
+            length = compressCached(deviceCallsignCache, t->contact.device_callsign, compressed.contact.device_callsign,
+                                    sizeof(compressed.contact.device_callsign));
             if (length < 0) {
                 LOG_WARN("Compress overflow contact.device_callsign. Revert to uncompressed packet");
                 return;
@@ -120,6 +184,10 @@ void AtakPluginModule::alterReceivedProtobuf(meshtastic_MeshPacket &mp, meshtast
                 LOG_DEBUG("Compressed chat to_callsign: %d bytes", length);
             }
         }
+#if ATAK_DELTA_PLI
+        if (compressed.which_payload_variant == meshtastic_TAKPacket_pli_tag)
+            omitUnchanged(compressed);
+#endif
         mp.decoded.payload.size = pb_encode_to_bytes(mp.decoded.payload.bytes, sizeof(mp.decoded.payload.bytes),
                                                      meshtastic_TAKPacket_fields, &compressed);
         LOG_DEBUG("Final payload: %d bytes", mp.decoded.payload.size);
@@ -129,6 +197,10 @@ void AtakPluginModule::alterReceivedProtobuf(meshtastic_MeshPacket &mp, meshtast
             LOG_WARN("Received uncompressed TAKPacket over radio! Skip");
             return;
         }
+#if ATAK_DELTA_PLI
+        if (t->which_payload_variant == meshtastic_TAKPacket_pli_tag)
+            restoreOmitted(getFrom(&mp), t);
+#endif
 
         // Decompress for Phone (EUD)
         auto uncompressed = cloneTAKPacketData(t);
@@ -2,6 +2,17 @@
 #include "ProtobufModule.h"
 #include "meshtastic/atak.pb.h"
 
+/// Set to 1 to leave the contact and group out of a PLI from the phone when they are the same as in the one before, receivers
+/// with it set fill them back in from the last full PLI they heard from the sender.  Every ATAK_DELTA_PLI_FULL_EVERY-th PLI is
+/// sent whole, so a receiver that missed one catches up.
+#ifndef ATAK_DELTA_PLI
+#define ATAK_DELTA_PLI 0
+#endif
+#ifndef ATAK_DELTA_PLI_FULL_EVERY
+#define ATAK_DELTA_PLI_FULL_EVERY 8
+#endif
+#define ATAK_DELTA_PLI_TRACKED 8 // senders whose last contact and group we remember
+
 /**
  * Waypoint message handling for meshtastic
  */
@@ -21,6 +32,42 @@ class AtakPluginModule : public ProtobufModule<meshtastic_TAKPacket>, private co
 
   private:
     meshtastic_TAKPacket cloneTAKPacketData(meshtastic_TAKPacket *t);
+
+    /// The last string compressed for a field, and its encoding.  Callsigns hardly ever change from one PLI to the next
+    struct CompressedField {
+        char source[sizeof(meshtastic_Contact::callsign)] = {};
+        char compressed[sizeof(meshtastic_Contact::callsign)] = {};
+        int length = -1; // < 0 if nothing is cached
+    };
+    CompressedField callsignCache, deviceCallsignCache;
+
+    /// unishox2_compress_lines() source into out, reusing the encoding in cache if source is what it was last time
+    /// @return the compressed length, or < 0 if it doesn't fit in outSize - 1 bytes
+    static int compressCached(CompressedField &cache, const char *source, char *out, size_t outSize);
+
+#if ATAK_DELTA_PLI
+    /// The contact and group of the last PLI we sent, compressed
+    meshtastic_Contact sentContact = {};
+    meshtastic_Group sentGroup = {};
+    bool sentHasContact = false, sentHasGroup = false;
+    uint8_t plisSinceFull = 0;
+
+    /// The last contact and group each sender's PLIs carried, compressed
+    struct PeerContact {
+        NodeNum from;
+        bool hasContact, hasGroup;
+        meshtastic_Contact contact;
+        meshtastic_Group group;
+    };
+    PeerContact peers[ATAK_DELTA_PLI_TRACKED] = {};
+    uint8_t nextPeer = 0;
+
+    /// Drop the contact and group from our compressed PLI t if they repeat the last one sent
+    void omitUnchanged(meshtastic_TAKPacket &t);
+
+    /// Put back the contact and group a received PLI t from from left out, or remember them if it has them
+    void restoreOmitted(NodeNum from, meshtastic_TAKPacket *t);
+#endif
 };
 
 extern AtakPluginModule *atakPluginModule;
\ No newline at end of file
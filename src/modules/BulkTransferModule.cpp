@@ -0,0 +1,391 @@
+#include "BulkTransferModule.h"
+#include "MeshService.h"
+#include "NodeDB.h"
+#include "RadioLibInterface.h"
+#include "Router.h"
+#include "airtime.h"
+#include "main.h"
+#include <algorithm>
+#ifdef ARCH_PORTDUINO
+#include "platform/portduino/SimRadio.h"
+#endif
+
+BulkTransferModule *bulkTransferModule;
+
+static_assert(BULK_TRANSFER_WINDOW >= 1 && BULK_TRANSFER_WINDOW <= 32, "The window must fit an Ack's bitmap");
+
+/// A full Ack bitmap of fragments per burst when one takes at most this long to send, as on an SX128x FLRC or GFSK link
+static constexpr uint32_t FAST_LINK_AIRTIME_MS = 20;
+static constexpr uint16_t FAST_LINK_WINDOW = 32;
+
+/// Allowance per hop for the relays' contention windows and processing, on top of the airtime
+static constexpr uint32_t HOP_SLACK_MS = 3000;
+
+/// Back off this long while the channel is too busy to send
+static constexpr uint32_t BUSY_CHANNEL_MS = 5000;
+
+/// While receiving, look for stale transfers this often
+static constexpr uint32_t RX_SWEEP_MS = 10 * 1000;
+
+BulkTransferModule::BulkTransferModule()
+    : SinglePortModule("bulktransfer", (meshtastic_PortNum)BULK_TRANSFER_PORTNUM), concurrency::OSThread("BulkTransfer")
+{
+    lastXfer = random(1, 0x10000); // so a reboot doesn't reuse the ids of transfers the other end may still hold
+    disable();                     // until there is something to send or receive
+}
+
+uint16_t BulkTransferModule::send(NodeNum dest, ChannelIndex channel, uint16_t kind, const uint8_t *data, size_t len, Done done)
+{
+    if (len == 0 || len > BULK_TRANSFER_MAX_SIZE || dest == 0 || isBroadcast(dest) || dest == nodeDB->getNodeNum()) {
+        LOG_WARN("Bulk transfer of %u bytes to 0x%x refused", (unsigned)len, dest);
+        return 0;
+    }
+    Outgoing *o = NULL;
+    for (Outgoing &s : outgoing)
+        if (!s.xfer) {
+            o = &s;
+            break;
+        }
+    if (!o) {
+        LOG_WARN("Bulk transfer to 0x%x refused, %u already in progress", dest, BULK_TRANSFER_SLOTS);
+        return 0;
+    }
+
+    if (++lastXfer == 0)
+        lastXfer = 1;
+    o->xfer = lastXfer;
+    o->dest = dest;
+    o->channel = channel;
+    o->kind = kind;
+    o->data.assign(data, data + len);
+    o->count = (len + FRAGMENT_DATA - 1) / FRAGMENT_DATA;
+    o->acked.assign(o->count, false);
+    o->base = o->next = 0;
+    o->burstEnd = std::min<uint16_t>(o->count, window());
+    o->ackDueMs = 0;
+    o->retries = 0;
+    const meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(dest);
+    o->hops = node && node->has_hops_away ? node->hops_away : config.lora.hop_limit;
+    o->done = done;
+
+    LOG_INFO("Bulk transfer %u: %u bytes of kind %u to 0x%x in %u fragments", o->xfer, (unsigned)len, kind, dest, o->count);
+    enabled = true;
+    setIntervalFromNow(0);
+    return o->xfer;
+}
+
+void BulkTransferModule::cancel(uint16_t xfer)
+{
+    for (Outgoing &o : outgoing)
+        if (o.xfer && o.xfer == xfer) {
+            sendCancel(o.dest, o.channel, xfer);
+            finish(o, false);
+        }
+}
+
+bool BulkTransferModule::setReceiver(uint16_t kind, Receiver r)
+{
+    for (auto it = receivers.begin(); it != receivers.end(); ++it)
+        if (it->kind == kind) {
+            if (r)
+                it->receiver = r;
+            else
+                receivers.erase(it);
+            return true;
+        }
+    if (r)
+        receivers.push_back({kind, r});
+    return true;
+}
+
+BulkTransferModule::Receiver BulkTransferModule::findReceiver(uint16_t kind)
+{
+    for (const Registration &r : receivers)
+        if (r.kind == kind)
+            return r.receiver;
+    return NULL;
+}
+
+ProcessMessage BulkTransferModule::handleReceived(const meshtastic_MeshPacket &mp)
+{
+    const meshtastic_Data &d = mp.decoded;
+    if (d.payload.size < 1 || !isToUs(&mp) || isFromUs(&mp))
+        return ProcessMessage::CONTINUE;
+
+    switch (d.payload.bytes[0]) {
+    case DATA:
+        if (d.payload.size > sizeof(Fragment)) {
+            Fragment f;
+            memcpy(&f, d.payload.bytes, sizeof(f));
+            handleFragment(mp, f, d.payload.bytes + sizeof(f), d.payload.size - sizeof(f));
+        }
+        break;
+
+    case ACK:
+        if (d.payload.size >= sizeof(Ack)) {
+            Ack a;
+            memcpy(&a, d.payload.bytes, sizeof(a));
+            handleAck(mp, a);
+        }
+        break;
+
+    case CANCEL:
+        if (d.payload.size >= sizeof(Cancel)) {
+            Cancel c;
+            memcpy(&c, d.payload.bytes, sizeof(c));
+            handleCancel(mp, c);
+        }
+        break;
+    }
+    return ProcessMessage::STOP;
+}
+
+void BulkTransferModule::handleFragment(const meshtastic_MeshPacket &mp, const Fragment &f, const uint8_t *data, size_t len)
+{
+    if (f.size == 0 || f.size > BULK_TRANSFER_MAX_SIZE || f.count != (f.size + FRAGMENT_DATA - 1) / FRAGMENT_DATA ||
+        f.seq >= f.count || len != (f.seq == f.count - 1 ? f.size - f.seq * FRAGMENT_DATA : FRAGMENT_DATA)) {
+        LOG_WARN("Bulk transfer %u from 0x%x: bad fragment %u", f.xfer, mp.from, f.seq);
+        return;
+    }
+
+    Incoming *in = NULL, *spare = NULL;
+    for (Incoming &s : incoming) {
+        if (s.from == mp.from && s.xfer == f.xfer)
+            in = &s;
+        else if (!s.from || (s.complete && (!spare || spare->from)))
+            spare = &s; // a free slot, or one only kept to acknowledge a finished transfer
+    }
+    if (!in) {
+        if (!findReceiver(f.kind)) {
+            LOG_WARN("Bulk transfer %u from 0x%x: nothing here takes kind %u", f.xfer, mp.from, f.kind);
+            sendCancel(mp.from, mp.channel, f.xfer);
+            return;
+        }
+        if (!spare)
+            return; // busy, the sender tries again later
+        in = spare;
+        in->from = mp.from;
+        in->xfer = f.xfer;
+        in->kind = f.kind;
+        in->count = f.count;
+        in->size = f.size;
+        in->data.assign(f.size, 0);
+        in->have.assign(f.count, false);
+        in->complete = false;
+        LOG_INFO("Bulk transfer %u: receiving %u bytes of kind %u from 0x%x", f.xfer, f.size, f.kind, mp.from);
+        enabled = true;
+        setIntervalFromNow(RX_SWEEP_MS);
+    }
+    in->lastHeardMs = millis();
+
+    bool justCompleted = false;
+    if (!in->complete && in->kind == f.kind && in->size == f.size && !in->have[f.seq]) {
+        memcpy(in->data.data() + f.seq * FRAGMENT_DATA, data, len);
+        in->have[f.seq] = true;
+        if (std::find(in->have.begin(), in->have.end(), false) == in->have.end()) {
+            LOG_INFO("Bulk transfer %u from 0x%x complete", in->xfer, in->from);
+            Receiver r = findReceiver(in->kind);
+            if (r)
+                r(in->from, mp.channel, in->data.data(), in->size);
+            in->complete = justCompleted = true;
+            std::vector<uint8_t>().swap(in->data); // keep just enough to acknowledge repeats
+            std::vector<bool>().swap(in->have);
+        }
+    }
+    if (justCompleted || (f.flags & ACK_REQUESTED))
+        sendAck(*in, mp.channel);
+}
+
+void BulkTransferModule::sendAck(const Incoming &in, ChannelIndex channel)
+{
+    Ack a = {ACK, in.xfer, in.count, 0, in.complete};
+    if (!in.complete) {
+        a.base = std::find(in.have.begin(), in.have.end(), false) - in.have.begin();
+        for (int i = 0; i < 32 && a.base + 1 + i < in.count; i++)
+            if (in.have[a.base + 1 + i])
+                a.bitmap |= 1u << i;
+    }
+
+    meshtastic_MeshPacket *p = allocDataPacket();
+    p->to = in.from;
+    p->channel = channel;
+    p->want_ack = false;
+    p->priority = meshtastic_MeshPacket_Priority_ACK;
+    memcpy(p->decoded.payload.bytes, &a, sizeof(a));
+    p->decoded.payload.size = sizeof(a);
+    service->sendToMesh(p);
+}
+
+void BulkTransferModule::sendCancel(NodeNum to, ChannelIndex channel, uint16_t xfer)
+{
+    Cancel c = {CANCEL, xfer};
+    meshtastic_MeshPacket *p = allocDataPacket();
+    p->to = to;
+    p->channel = channel;
+    p->want_ack = false;
+    memcpy(p->decoded.payload.bytes, &c, sizeof(c));
+    p->decoded.payload.size = sizeof(c);
+    service->sendToMesh(p);
+}
+
+void BulkTransferModule::handleAck(const meshtastic_MeshPacket &mp, const Ack &a)
+{
+    for (Outgoing &o : outgoing) {
+        if (!o.xfer || o.xfer != a.xfer || o.dest != mp.from)
+            continue;
+        if (a.complete || a.base >= o.count) {
+            finish(o, true);
+            return;
+        }
+
+        bool progressed = false;
+        for (uint16_t seq = 0; seq < o.count; seq++) {
+            bool in = seq < a.base || (seq > a.base && seq - a.base - 1 < 32 && (a.bitmap >> (seq - a.base - 1) & 1));
+            if (in && !o.acked[seq])
+                o.acked[seq] = progressed = true;
+        }
+        while (o.base < o.count && o.acked[o.base])
+            o.base++;
+        if (progressed)
+            o.retries = 0;
+        if (mp.hop_start >= mp.hop_limit)
+            o.hops = mp.hop_start - mp.hop_limit;
+
+        // Waiting on this burst's Ack: slide the window and send what is still missing from it
+        if (o.ackDueMs) {
+            o.next = o.base;
+            o.burstEnd = std::min<uint16_t>(o.count, o.base + window());
+            o.ackDueMs = 0;
+            setIntervalFromNow(0);
+        }
+        return;
+    }
+}
+
+void BulkTransferModule::handleCancel(const meshtastic_MeshPacket &mp, const Cancel &c)
+{
+    for (Outgoing &o : outgoing)
+        if (o.xfer && o.xfer == c.xfer && o.dest == mp.from) {
+            LOG_WARN("Bulk transfer %u canceled by 0x%x", o.xfer, mp.from);
+            finish(o, false);
+        }
+    for (Incoming &in : incoming)
+        if (in.from == mp.from && in.xfer == c.xfer) {
+            LOG_INFO("Bulk transfer %u from 0x%x canceled", in.xfer, in.from);
+            in = Incoming();
+        }
+}
+
+int32_t BulkTransferModule::runOnce()
+{
+    int32_t wait = INT32_MAX;
+    for (Outgoing &o : outgoing)
+        if (o.xfer)
+            wait = std::min(wait, sendNext(o));
+
+    bool receiving = false;
+    for (Incoming &in : incoming) {
+        if (!in.from)
+            continue;
+        if (millis() - in.lastHeardMs > BULK_TRANSFER_RX_TIMEOUT_MS) {
+            if (!in.complete)
+                LOG_WARN("Bulk transfer %u from 0x%x timed out", in.xfer, in.from);
+            in = Incoming();
+        } else
+            receiving = true;
+    }
+    if (receiving)
+        wait = std::min<int32_t>(wait, RX_SWEEP_MS);
+
+    return wait == INT32_MAX ? disable() : wait;
+}
+
+int32_t BulkTransferModule::sendNext(Outgoing &o)
+{
+    uint32_t now = millis();
+    if (o.ackDueMs) {
+        if ((int32_t)(now - o.ackDueMs) < 0)
+            return o.ackDueMs - now;
+        if (++o.retries > BULK_TRANSFER_RETRIES) {
+            LOG_WARN("Bulk transfer %u to 0x%x: no Ack after %u tries, giving up", o.xfer, o.dest, BULK_TRANSFER_RETRIES);
+            sendCancel(o.dest, o.channel, o.xfer);
+            finish(o, false);
+            return INT32_MAX;
+        }
+        LOG_DEBUG("Bulk transfer %u: no Ack, send fragments %u.. again", o.xfer, o.base);
+        o.next = o.base;
+        o.burstEnd = std::min<uint16_t>(o.count, o.base + window());
+        o.ackDueMs = 0;
+    }
+
+    // Pace: leave the channel to others while it is busy, and don't fill the TX queue ahead of everyone else's packets
+    if (airTime && !airTime->isTxAllowedChannelUtil(true))
+        return BUSY_CHANNEL_MS;
+    meshtastic_QueueStatus qs = router->getQueueStatus();
+    uint32_t queued = qs.maxlen > qs.free ? qs.maxlen - qs.free : 0;
+    if (queued > 1)
+        return fragmentAirtime();
+
+    while (o.next < o.burstEnd && o.acked[o.next])
+        o.next++;
+    uint16_t last = o.burstEnd;
+    while (last > o.next && o.acked[last - 1])
+        last--;
+    if (o.next >= last) {
+        // Everything in the burst was acknowledged while we were sending it
+        o.next = o.base;
+        o.burstEnd = std::min<uint16_t>(o.count, o.base + window());
+        return 0;
+    }
+
+    uint16_t seq = o.next++;
+    bool endOfBurst = seq == last - 1;
+    size_t len = seq == o.count - 1 ? o.data.size() - seq * FRAGMENT_DATA : FRAGMENT_DATA;
+    Fragment f = {DATA, o.xfer, seq, o.count, (uint32_t)o.data.size(), o.kind, (uint8_t)(endOfBurst ? ACK_REQUESTED : 0)};
+
+    meshtastic_MeshPacket *p = allocDataPacket();
+    p->to = o.dest;
+    p->channel = o.channel;
+    p->want_ack = false;
+    p->priority = meshtastic_MeshPacket_Priority_BACKGROUND;
+    memcpy(p->decoded.payload.bytes, &f, sizeof(f));
+    memcpy(p->decoded.payload.bytes + sizeof(f), o.data.data() + seq * FRAGMENT_DATA, len);
+    p->decoded.payload.size = sizeof(f) + len;
+    service->sendToMesh(p);
+
+    uint32_t airtime = fragmentAirtime();
+    if (endOfBurst) {
+        // Our queue drains, the fragment crosses every hop, the Ack comes back across them
+        o.ackDueMs = now + (queued + 1) * airtime + (o.hops + 1) * 2 * (airtime + HOP_SLACK_MS);
+        if (!o.ackDueMs)
+            o.ackDueMs = 1;
+        return o.ackDueMs - now;
+    }
+    return airtime;
+}
+
+void BulkTransferModule::finish(Outgoing &o, bool delivered)
+{
+    if (delivered)
+        LOG_INFO("Bulk transfer %u to 0x%x delivered", o.xfer, o.dest);
+    Done done = o.done;
+    uint16_t xfer = o.xfer;
+    o = Outgoing();
+    if (done)
+        done(xfer, delivered);
+}
+
+uint16_t BulkTransferModule::window()
+{
+    return fragmentAirtime() <= FAST_LINK_AIRTIME_MS ? FAST_LINK_WINDOW : BULK_TRANSFER_WINDOW;
+}
+
+uint32_t BulkTransferModule::fragmentAirtime()
+{
+    const uint32_t len = sizeof(PacketHeader) + meshtastic_Constants_DATA_PAYLOAD_LEN;
+#ifdef ARCH_PORTDUINO
+    if (SimRadio::instance)
+        return SimRadio::instance->getPacketTime(len);
+#endif
+    return RadioLibInterface::instance ? RadioLibInterface::instance->getPacketTime(len) : 1000;
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "RadioInterface.h"
+#include "SinglePortModule.h"
+#include "concurrency/OSThread.h"
+#include "configuration.h"
+#include <vector>
+
+/// A private application port, bulk transfers have no portnum of their own
+#ifndef BULK_TRANSFER_PORTNUM
+#define BULK_TRANSFER_PORTNUM 289
+#endif
+
+/// Largest payload one transfer carries, both ends hold all of it in RAM
+#ifndef BULK_TRANSFER_MAX_SIZE
+#define BULK_TRANSFER_MAX_SIZE (16 * 1024)
+#endif
+
+/// Fragments sent before waiting for an acknowledgement, at most 32 (one SACK bitmap).  Links where a fragment takes next to
+/// no airtime always use 32
+#ifndef BULK_TRANSFER_WINDOW
+#define BULK_TRANSFER_WINDOW 8
+#endif
+
+/// Transfers we send, and receive, at once
+#ifndef BULK_TRANSFER_SLOTS
+#define BULK_TRANSFER_SLOTS 2
+#endif
+
+/// Times a window is sent again without hearing an acknowledgement before the transfer is given up
+#ifndef BULK_TRANSFER_RETRIES
+#define BULK_TRANSFER_RETRIES 4
+#endif
+
+/// A transfer being received is dropped after this long without a fragment
+#ifndef BULK_TRANSFER_RX_TIMEOUT_MS
+#define BULK_TRANSFER_RX_TIMEOUT_MS (120 * 1000)
+#endif
+
+/**
+ * Sends payloads too big for one packet to one node, such as AdminModule's bulk config snapshots (ADMIN_BULK_CONFIG), so
+ * modules don't each split them by hand and send the pieces stop-and-wait through ReliableRouter.
+ *
+ * The payload goes in numbered fragments, a window of BULK_TRANSFER_WINDOW at a time without want_ack.  The last fragment of
+ * each burst asks for an Ack: the fragments received in order so far plus a bitmap of those after, so only what was lost is
+ * sent again.  Fragments are paced by their airtime and held back while the channel is busy or the radio's TX queue is
+ * filling, and the wait for an Ack grows with the airtime of a window and the hops to the other end.
+ *
+ * A module sending calls send() with a Kind, the module receiving registers for that Kind with setReceiver() and gets the
+ * whole payload once it is in.  All messages are packed little endian structs, led by their Type.
+ */
+class BulkTransferModule : public SinglePortModule, private concurrency::OSThread
+{
+  public:
+    enum Type : uint8_t { DATA = 1, ACK = 2, CANCEL = 3 };
+
+    /// What a transfer carries, picks the receiver.  KIND_USER and up are free for builds of our own
+    enum Kind : uint16_t { KIND_ADMIN = 1, KIND_USER = 0x100 };
+
+    enum Flags : uint8_t { ACK_REQUESTED = 1 };
+
+    struct __attribute__((packed)) Fragment {
+        uint8_t type;
+        uint16_t xfer; // picked by the sender, unique per sender while it lasts
+        uint16_t seq;
+        uint16_t count; // fragments in the transfer
+        uint32_t size;  // bytes in the transfer, the receiver sizes its buffer from whichever fragment comes first
+        uint16_t kind;
+        uint8_t flags;
+        // data follows, FRAGMENT_DATA bytes in all but the last
+    };
+
+    struct __attribute__((packed)) Ack {
+        uint8_t type;
+        uint16_t xfer;
+        uint16_t base;    // fragments 0..base-1 are in, base == count when all of them are
+        uint32_t bitmap;  // bit i: base + 1 + i is in
+        uint8_t complete; // the receiver has handed the payload over
+    };
+
+    struct __attribute__((packed)) Cancel {
+        uint8_t type;
+        uint16_t xfer;
+    };
+
+    /// Leaves room for PKI encryption, which Router uses for direct packets on the primary channel
+    static constexpr size_t FRAGMENT_DATA = meshtastic_Constants_DATA_PAYLOAD_LEN - MESHTASTIC_PKC_OVERHEAD - sizeof(Fragment);
+
+    /// Gets a whole payload of the Kind it registered for
+    typedef void (*Receiver)(NodeNum from, ChannelIndex channel, const uint8_t *data, size_t len);
+
+    /// Told how a transfer we sent ended
+    typedef void (*Done)(uint16_t xfer, bool delivered);
+
+    BulkTransferModule();
+
+    /**
+     * Send len bytes of data (copied) to dest
+     * @return the transfer's id, 0 if it is too big or every slot is busy
+     */
+    uint16_t send(NodeNum dest, ChannelIndex channel, uint16_t kind, const uint8_t *data, size_t len, Done done = NULL);
+
+    /// Give up on a transfer we are sending, and tell the other end
+    void cancel(uint16_t xfer);
+
+    /// Have payloads of kind handed to r, NULL to stop
+    bool setReceiver(uint16_t kind, Receiver r);
+
+  protected:
+    virtual ProcessMessage handleReceived(const meshtastic_MeshPacket &mp) override;
+
+    virtual int32_t runOnce() override;
+
+  private:
+    struct Outgoing {
+        uint16_t xfer = 0; // 0 if the slot is free
+        NodeNum dest;
+        ChannelIndex channel;
+        uint16_t kind;
+        std::vector<uint8_t> data;
+        std::vector<bool> acked; // by seq
+        uint16_t count;
+        uint16_t base;       // first fragment not acked
+        uint16_t next;       // next fragment of the current burst to look at
+        uint16_t burstEnd;   // the burst covers base..burstEnd-1
+        uint32_t ackDueMs;   // give up waiting for the burst's Ack then, 0 while still sending it
+        uint8_t retries;     // bursts in a row without an Ack that moved things on
+        uint8_t hops;        // to dest, as last heard
+        Done done;
+    };
+
+    struct Incoming {
+        NodeNum from = 0; // 0 if the slot is free
+        uint16_t xfer;
+        uint16_t kind;
+        uint16_t count;
+        uint32_t size;
+        std::vector<uint8_t> data;
+        std::vector<bool> have;
+        uint32_t lastHeardMs;
+        bool complete; // handed over, kept a while to acknowledge repeats of the last burst
+    };
+
+    struct Registration {
+        uint16_t kind;
+        Receiver receiver;
+    };
+
+    Outgoing outgoing[BULK_TRANSFER_SLOTS];
+    Incoming incoming[BULK_TRANSFER_SLOTS];
+    std::vector<Registration> receivers;
+    uint16_t lastXfer = 0;
+
+    void handleFragment(const meshtastic_MeshPacket &mp, const Fragment &f, const uint8_t *data, size_t len);
+    void handleAck(const meshtastic_MeshPacket &mp, const Ack &a);
+    void handleCancel(const meshtastic_MeshPacket &mp, const Cancel &c);
+
+    /// Send the next fragment of o's burst, if the channel lets us
+    /// @return how long until o wants to run again
+    int32_t sendNext(Outgoing &o);
+    void sendAck(const Incoming &in, ChannelIndex channel);
+    void sendCancel(NodeNum to, ChannelIndex channel, uint16_t xfer);
+    void finish(Outgoing &o, bool delivered);
+
+    /// Airtime of a full fragment, in ms
+    uint32_t fragmentAirtime();
+
+    /// Fragments per burst, more on a link fast enough that waiting for Acks is most of the time taken
+    uint16_t window();
+
+    Receiver findReceiver(uint16_t kind);
+};
+
+extern BulkTransferModule *bulkTransferModule;
@@ -45,6 +45,62 @@ meshtastic_CannedMessageModuleConfig cannedMessageModuleConfig;
 
 CannedMessageModule *cannedMessageModule;
 
+// Find the emote with this exact label
+static const graphics::Emote *findEmote(const String &label)
+{
+    for (int j = 0; j < graphics::numEmotes; j++) {
+        if (label == graphics::emotes[j].label)
+            return &graphics::emotes[j];
+    }
+    return nullptr;
+}
+
+// Split msg into emote and plain text tokens, preferring the longest emote label at each position
+static void tokenizeEmotes(const char *msg, EmoteTokens &tokens)
+{
+    int msgLen = strlen(msg);
+    int pos = 0;
+    while (pos < msgLen) {
+        const graphics::Emote *foundEmote = nullptr;
+        int foundLen = 0;
+        for (int j = 0; j < graphics::numEmotes; j++) {
+            const char *label = graphics::emotes[j].label;
+            int labelLen = strlen(label);
+            if (labelLen == 0)
+                continue;
+            if (strncmp(msg + pos, label, labelLen) == 0) {
+                if (!foundEmote || labelLen > foundLen) {
+                    foundEmote = &graphics::emotes[j];
+                    foundLen = labelLen;
+                }
+            }
+        }
+        if (foundEmote) {
+            tokens.emplace_back(true, String(foundEmote->label));
+            pos += foundLen;
+        } else {
+            // Find next emote
+            int nextEmote = msgLen;
+            for (int j = 0; j < graphics::numEmotes; j++) {
+                const char *label = graphics::emotes[j].label;
+                if (!label || !*label)
+                    continue;
+                const char *found = strstr(msg + pos, label);
+                if (found && (found - msg) < nextEmote) {
+                    nextEmote = found - msg;
+                }
+            }
+            int textLen = (nextEmote > pos) ? (nextEmote - pos) : (msgLen - pos);
+            if (textLen > 0) {
+                tokens.emplace_back(false, String(msg + pos).substring(0, textLen));
+                pos += textLen;
+            } else {
+                break;
+            }
+        }
+    }
+}
+
 CannedMessageModule::CannedMessageModule()
     : SinglePortModule("canned", meshtastic_PortNum_TEXT_MESSAGE_APP), concurrency::OSThread("CannedMessage")
 {
@@ -150,6 +206,18 @@ int CannedMessageModule::splitConfiguredMessages()
     }
     this->messagesCount = tempCount;
 
+    // Tokenize once here rather than on every frame
+    this->messageTokens.assign(tempCount, EmoteTokens());
+    this->messageEmoteHeights.assign(tempCount, 0);
+    for (int k = 0; k < tempCount; ++k) {
+        tokenizeEmotes(this->messages[k], this->messageTokens[k]);
+        for (auto &token : this->messageTokens[k]) {
+            const graphics::Emote *emote = token.first ? findEmote(token.second) : nullptr;
+            if (emote && emote->height > this->messageEmoteHeights[k])
+                this->messageEmoteHeights[k] = emote->height;
+        }
+    }
+
     return this->messagesCount;
 }
 void CannedMessageModule::drawHeader(OLEDDisplay *display, int16_t x, int16_t y, char *buffer)
@@ -201,15 +269,34 @@ void CannedMessageModule::updateDestinationSelectionList()
     // Early exit if nothing changed
     if (searchQuery == lastSearchQuery && !nodesChanged)
         return;
+    // Typing one more character can only narrow the previous result, so filter that instead of the whole NodeDB
+    bool narrowing = !nodesChanged && lastSearchQuery.length() > 0 && searchQuery.startsWith(lastSearchQuery);
     lastSearchQuery = searchQuery;
     needsUpdate = false;
 
+    String lowerSearchQuery = searchQuery;
+    lowerSearchQuery.toLowerCase();
+
+    if (narrowing) {
+        auto mismatch = [&lowerSearchQuery](const NodeEntry &entry) {
+            const meshtastic_NodeInfoLite *node = entry.node.get();
+            if (!node)
+                return true;
+            String lowerNodeName = node->user.long_name;
+            lowerNodeName.toLowerCase();
+            return lowerNodeName.indexOf(lowerSearchQuery) == -1;
+        };
+        this->filteredNodes.erase(std::remove_if(this->filteredNodes.begin(), this->filteredNodes.end(), mismatch),
+                                  this->filteredNodes.end());
+        scrollIndex = 0;
+        destIndex = 0;
+        return;
+    }
+
     this->filteredNodes.clear();
     this->activeChannelIndices.clear();
 
     NodeNum myNodeNum = nodeDB->getNodeNum();
-    String lowerSearchQuery = searchQuery;
-    lowerSearchQuery.toLowerCase();
 
     // Preallocate space to reduce reallocation
     this->filteredNodes.reserve(numMeshNodes);
@@ -222,14 +309,14 @@ void CannedMessageModule::updateDestinationSelectionList()
         const String &nodeName = node->user.long_name;
 
         if (searchQuery.length() == 0) {
-            this->filteredNodes.push_back({node, sinceLastSeen(node)});
+            this->filteredNodes.push_back({NodeHandle(node), sinceLastSeen(node)});
         } else {
             // Avoid unnecessary lowercase conversion if already matched
             String lowerNodeName = nodeName;
             lowerNodeName.toLowerCase();
 
             if (lowerNodeName.indexOf(lowerSearchQuery) != -1) {
-                this->filteredNodes.push_back({node, sinceLastSeen(node)});
+                this->filteredNodes.push_back({NodeHandle(node), sinceLastSeen(node)});
             }
         }
     }
@@ -472,7 +559,7 @@ int CannedMessageModule::handleDestinationSelectionInput(const InputEvent *event
         } else {
             int nodeIndex = destIndex - static_cast<int>(activeChannelIndices.size());
             if (nodeIndex >= 0 && nodeIndex < static_cast<int>(filteredNodes.size())) {
-                const meshtastic_NodeInfoLite *selectedNode = filteredNodes[nodeIndex].node;
+                const meshtastic_NodeInfoLite *selectedNode = filteredNodes[nodeIndex].node.get();
                 if (selectedNode) {
                     dest = selectedNode->num;
                     channel = selectedNode->channel;
@@ -1354,7 +1441,7 @@ void CannedMessageModule::drawDestinationSelectionScreen(OLEDDisplay *display, O
         else {
             int nodeIndex = itemIndex - numActiveChannels;
             if (nodeIndex >= 0 && nodeIndex < static_cast<int>(this->filteredNodes.size())) {
-                meshtastic_NodeInfoLite *node = this->filteredNodes[nodeIndex].node;
+                meshtastic_NodeInfoLite *node = this->filteredNodes[nodeIndex].node.get();
                 if (node) {
                     if (node->is_favorite) {
                         snprintf(entryText, sizeof(entryText), "* %s", node->user.long_name);
@@ -1383,7 +1470,7 @@ void CannedMessageModule::drawDestinationSelectionScreen(OLEDDisplay *display, O
         if (itemIndex >= numActiveChannels) {
             int nodeIndex = itemIndex - numActiveChannels;
             if (nodeIndex >= 0 && nodeIndex < static_cast<int>(this->filteredNodes.size())) {
-                const meshtastic_NodeInfoLite *node = this->filteredNodes[nodeIndex].node;
+                const meshtastic_NodeInfoLite *node = this->filteredNodes[nodeIndex].node.get();
                 if (node && hasKeyForNode(node)) {
                     int iconX = display->getWidth() - key_symbol_width - 15;
                     int iconY = yOffset + (FONT_HEIGHT_SMALL - key_symbol_height) / 2;
@@ -1491,6 +1578,79 @@ void CannedMessageModule::drawEmotePickerScreen(OLEDDisplay *display, OLEDDispla
     }
 }
 
+/**
+ * Wrap the free text (emotes + text, split by word, wrap by char if needed) to the display width.  The result is kept in
+ * freetextLines and only rebuilt when the text, cursor or width changed, so redrawing an unchanged frame is just drawing.
+ */
+void CannedMessageModule::layoutFreetext(OLEDDisplay *display, const String &msgWithCursor)
+{
+    int maxWidth = display->getWidth();
+    if (msgWithCursor == freetextLaidOut && maxWidth == freetextLayoutWidth && !freetextLines.empty())
+        return;
+    freetextLaidOut = msgWithCursor;
+    freetextLayoutWidth = maxWidth;
+    freetextLines.clear();
+
+    EmoteTokens tokens;
+    tokenizeEmotes(msgWithCursor.c_str(), tokens);
+
+    EmoteTokens currentLine;
+    int lineWidth = 0;
+    for (auto &token : tokens) {
+        if (token.first) {
+            // Emote
+            const graphics::Emote *emote = findEmote(token.second);
+            int tokenWidth = emote ? emote->width + 2 : 0;
+            if (lineWidth + tokenWidth > maxWidth && !currentLine.empty()) {
+                freetextLines.push_back(currentLine);
+                currentLine.clear();
+                lineWidth = 0;
+            }
+            currentLine.push_back(token);
+            lineWidth += tokenWidth;
+        } else {
+            // Text: split by words and wrap inside word if needed
+            String text = token.second;
+            uint16_t pos = 0;
+            while (pos < text.length()) {
+                // Find next space (or end)
+                int spacePos = text.indexOf(' ', pos);
+                int endPos = (spacePos == -1) ? text.length() : spacePos + 1; // Include space
+                String word = text.substring(pos, endPos);
+                int wordWidth = display->getStringWidth(word);
+
+                if (lineWidth + wordWidth > maxWidth && lineWidth > 0) {
+                    freetextLines.push_back(currentLine);
+                    currentLine.clear();
+                    lineWidth = 0;
+                }
+                // If word itself too big, split by character
+                if (wordWidth > maxWidth) {
+                    uint16_t charPos = 0;
+                    while (charPos < word.length()) {
+                        String oneChar = word.substring(charPos, charPos + 1);
+                        int charWidth = display->getStringWidth(oneChar);
+                        if (lineWidth + charWidth > maxWidth && lineWidth > 0) {
+                            freetextLines.push_back(currentLine);
+                            currentLine.clear();
+                            lineWidth = 0;
+                        }
+                        currentLine.push_back({false, oneChar});
+                        lineWidth += charWidth;
+                        charPos++;
+                    }
+                } else {
+                    currentLine.push_back({false, word});
+                    lineWidth += wordWidth;
+                }
+                pos = endPos;
+            }
+        }
+    }
+    if (!currentLine.empty())
+        freetextLines.push_back(currentLine);
+}
+
 void CannedMessageModule::drawFrame(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t x, int16_t y)
 {
     this->displayHeight = display->getHeight(); // Store display height for later use
@@ -1620,131 +1780,16 @@ void CannedMessageModule::drawFrame(OLEDDisplay *display, OLEDDisplayUiState *st
         display->setColor(WHITE);
         {
             int inputY = 0 + y + FONT_HEIGHT_SMALL;
-            String msgWithCursor = this->drawWithCursor(this->freetext, this->cursor);
-
-            // Tokenize input into (isEmote, token) pairs
-            std::vector<std::pair<bool, String>> tokens;
-            const char *msg = msgWithCursor.c_str();
-            int msgLen = strlen(msg);
-            int pos = 0;
-            while (pos < msgLen) {
-                const graphics::Emote *foundEmote = nullptr;
-                int foundLen = 0;
-                for (int j = 0; j < graphics::numEmotes; j++) {
-                    const char *label = graphics::emotes[j].label;
-                    int labelLen = strlen(label);
-                    if (labelLen == 0)
-                        continue;
-                    if (strncmp(msg + pos, label, labelLen) == 0) {
-                        if (!foundEmote || labelLen > foundLen) {
-                            foundEmote = &graphics::emotes[j];
-                            foundLen = labelLen;
-                        }
-                    }
-                }
-                if (foundEmote) {
-                    tokens.emplace_back(true, String(foundEmote->label));
-                    pos += foundLen;
-                } else {
-                    // Find next emote
-                    int nextEmote = msgLen;
-                    for (int j = 0; j < graphics::numEmotes; j++) {
-                        const char *label = graphics::emotes[j].label;
-                        if (!label || !*label)
-                            continue;
-                        const char *found = strstr(msg + pos, label);
-                        if (found && (found - msg) < nextEmote) {
-                            nextEmote = found - msg;
-                        }
-                    }
-                    int textLen = (nextEmote > pos) ? (nextEmote - pos) : (msgLen - pos);
-                    if (textLen > 0) {
-                        tokens.emplace_back(false, String(msg + pos).substring(0, textLen));
-                        pos += textLen;
-                    } else {
-                        break;
-                    }
-                }
-            }
-
-            // ===== Advanced word-wrapping (emotes + text, split by word, wrap by char if needed) =====
-            std::vector<std::vector<std::pair<bool, String>>> lines;
-            std::vector<std::pair<bool, String>> currentLine;
-            int lineWidth = 0;
-            int maxWidth = display->getWidth();
-            for (auto &token : tokens) {
-                if (token.first) {
-                    // Emote
-                    int tokenWidth = 0;
-                    for (int j = 0; j < graphics::numEmotes; j++) {
-                        if (token.second == graphics::emotes[j].label) {
-                            tokenWidth = graphics::emotes[j].width + 2;
-                            break;
-                        }
-                    }
-                    if (lineWidth + tokenWidth > maxWidth && !currentLine.empty()) {
-                        lines.push_back(currentLine);
-                        currentLine.clear();
-                        lineWidth = 0;
-                    }
-                    currentLine.push_back(token);
-                    lineWidth += tokenWidth;
-                } else {
-                    // Text: split by words and wrap inside word if needed
-                    String text = token.second;
-                    uint16_t pos = 0;
-                    while (pos < text.length()) {
-                        // Find next space (or end)
-                        int spacePos = text.indexOf(' ', pos);
-                        int endPos = (spacePos == -1) ? text.length() : spacePos + 1; // Include space
-                        String word = text.substring(pos, endPos);
-                        int wordWidth = display->getStringWidth(word);
-
-                        if (lineWidth + wordWidth > maxWidth && lineWidth > 0) {
-                            lines.push_back(currentLine);
-                            currentLine.clear();
-                            lineWidth = 0;
-                        }
-                        // If word itself too big, split by character
-                        if (wordWidth > maxWidth) {
-                            uint16_t charPos = 0;
-                            while (charPos < word.length()) {
-                                String oneChar = word.substring(charPos, charPos + 1);
-                                int charWidth = display->getStringWidth(oneChar);
-                                if (lineWidth + charWidth > maxWidth && lineWidth > 0) {
-                                    lines.push_back(currentLine);
-                                    currentLine.clear();
-                                    lineWidth = 0;
-                                }
-                                currentLine.push_back({false, oneChar});
-                                lineWidth += charWidth;
-                                charPos++;
-                            }
-                        } else {
-                            currentLine.push_back({false, word});
-                            lineWidth += wordWidth;
-                        }
-                        pos = endPos;
-                    }
-                }
-            }
-            if (!currentLine.empty())
-                lines.push_back(currentLine);
+            layoutFreetext(display, this->drawWithCursor(this->freetext, this->cursor));
 
             // Draw lines with emotes
             int rowHeight = FONT_HEIGHT_SMALL;
             int yLine = inputY;
-            for (auto &line : lines) {
+            for (auto &line : freetextLines) {
                 int nextX = x;
                 for (auto &token : line) {
                     if (token.first) {
-                        const graphics::Emote *emote = nullptr;
-                        for (int j = 0; j < graphics::numEmotes; j++) {
-                            if (token.second == graphics::emotes[j].label) {
-                                emote = &graphics::emotes[j];
-                                break;
-                            }
-                        }
+                        const graphics::Emote *emote = findEmote(token.second);
                         if (emote) {
                             int emoteYOffset = (rowHeight - emote->height) / 2;
                             display->drawXbm(nextX, yLine + emoteYOffset, emote->width, emote->height, emote->bitmap);
@@ -1786,21 +1831,10 @@ void CannedMessageModule::drawFrame(OLEDDisplay *display, OLEDDisplayUiState *st
             (messagesCount > visibleRows && currentMessageIndex >= visibleRows - 1) ? currentMessageIndex - visibleRows + 2 : 0;
         int countRows = std::min(messagesCount, visibleRows);
 
-        // --- Build per-row max height based on all emotes in line ---
+        // --- Row height fits the tallest emote in the message ---
         for (int i = 0; i < countRows; i++) {
-            const char *msg = getMessageByIndex(topMsg + i);
-            int maxEmoteHeight = 0;
-            for (int j = 0; j < graphics::numEmotes; j++) {
-                const char *label = graphics::emotes[j].label;
-                if (!label || !*label)
-                    continue;
-                const char *search = msg;
-                while ((search = strstr(search, label))) {
-                    if (graphics::emotes[j].height > maxEmoteHeight)
-                        maxEmoteHeight = graphics::emotes[j].height;
-                    search += strlen(label); // Advance past this emote
-                }
-            }
+            int msgIdx = topMsg + i;
+            int maxEmoteHeight = (msgIdx < (int)messageEmoteHeights.size()) ? messageEmoteHeights[msgIdx] : 0;
             rowHeights.push_back(std::max(baseRowSpacing, maxEmoteHeight + 2));
         }
 
@@ -1809,56 +1843,10 @@ void CannedMessageModule::drawFrame(OLEDDisplay *display, OLEDDisplayUiState *st
         for (int vis = 0; vis < countRows; vis++) {
             int msgIdx = topMsg + vis;
             int lineY = yCursor;
-            const char *msg = getMessageByIndex(msgIdx);
             int rowHeight = rowHeights[vis];
             bool highlight = (msgIdx == currentMessageIndex);
-
-            // --- Multi-emote tokenization ---
-            std::vector<std::pair<bool, String>> tokens; // (isEmote, token)
-            int pos = 0;
-            int msgLen = strlen(msg);
-            while (pos < msgLen) {
-                const graphics::Emote *foundEmote = nullptr;
-                int foundLen = 0;
-
-                // Look for any emote label at this pos (prefer longest match)
-                for (int j = 0; j < graphics::numEmotes; j++) {
-                    const char *label = graphics::emotes[j].label;
-                    int labelLen = strlen(label);
-                    if (labelLen == 0)
-                        continue;
-                    if (strncmp(msg + pos, label, labelLen) == 0) {
-                        if (!foundEmote || labelLen > foundLen) {
-                            foundEmote = &graphics::emotes[j];
-                            foundLen = labelLen;
-                        }
-                    }
-                }
-                if (foundEmote) {
-                    tokens.emplace_back(true, String(foundEmote->label));
-                    pos += foundLen;
-                } else {
-                    // Find next emote
-                    int nextEmote = msgLen;
-                    for (int j = 0; j < graphics::numEmotes; j++) {
-                        const char *label = graphics::emotes[j].label;
-                        if (label[0] == 0)
-                            continue;
-                        const char *found = strstr(msg + pos, label);
-                        if (found && (found - msg) < nextEmote) {
-                            nextEmote = found - msg;
-                        }
-                    }
-                    int textLen = (nextEmote > pos) ? (nextEmote - pos) : (msgLen - pos);
-                    if (textLen > 0) {
-                        tokens.emplace_back(false, String(msg + pos).substring(0, textLen));
-                        pos += textLen;
-                    } else {
-                        break;
-                    }
-                }
-            }
-            // --- End multi-emote tokenization ---
+            static const EmoteTokens noTokens;
+            const EmoteTokens &tokens = (msgIdx < (int)messageTokens.size()) ? messageTokens[msgIdx] : noTokens;
 
             // Vertically center based on rowHeight
             int textYOffset = (rowHeight - FONT_HEIGHT_SMALL) / 2;
@@ -1880,13 +1868,7 @@ void CannedMessageModule::drawFrame(OLEDDisplay *display, OLEDDisplayUiState *st
             for (auto &token : tokens) {
                 if (token.first) {
                     // Emote
-                    const graphics::Emote *emote = nullptr;
-                    for (int j = 0; j < graphics::numEmotes; j++) {
-                        if (token.second == graphics::emotes[j].label) {
-                            emote = &graphics::emotes[j];
-                            break;
-                        }
-                    }
+                    const graphics::Emote *emote = findEmote(token.second);
                     if (emote) {
                         int emoteYOffset = (rowHeight - emote->height) / 2;
                         display->drawXbm(nextX, lineY + emoteYOffset, emote->width, emote->height, emote->bitmap);
@@ -1980,9 +1962,9 @@ bool CannedMessageModule::saveProtoForModule()
     bool okay = true;
 
 #ifdef FSCom
-    spiLock->lock();
+    fsLock->lock();
     FSCom.mkdir("/prefs");
-    spiLock->unlock();
+    fsLock->unlock();
 #endif
 
     okay &= nodeDB->saveProto(cannedMessagesConfigFile, meshtastic_CannedMessageModuleConfig_size,
@@ -2057,6 +2039,7 @@ void CannedMessageModule::handleSetCannedMessageModuleMessages(const char *from_
 
     if (changed) {
         this->saveProtoForModule();
+        this->splitConfiguredMessages();
     }
 }
 
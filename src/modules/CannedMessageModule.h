@@ -1,5 +1,6 @@
 #pragma once
 #if HAS_SCREEN
+#include "NodeDB.h"
 #include "ProtobufModule.h"
 #include "input/InputBroker.h"
 
@@ -45,10 +46,13 @@ struct Letter {
 };
 
 struct NodeEntry {
-    meshtastic_NodeInfoLite *node;
+    NodeHandle node; // the list is kept while the user scrolls, as the DB may reorder meanwhile
     uint32_t lastHeard;
 };
 
+// A line of text split into (isEmote, token) pairs, emote tokens hold the emote's label
+typedef std::vector<std::pair<bool, String>> EmoteTokens;
+
 // ============================
 //      Main Class
 // ============================
@@ -102,6 +106,7 @@ class CannedMessageModule : public SinglePortModule, public Observable<const UIF
             lastRxSnr = p->rx_snr;
         return (p->decoded.portnum == meshtastic_PortNum_ROUTING_APP) ? waitingForAck : false;
     }
+    virtual int dispatchPortNum() const override { return meshtastic_PortNum_ROUTING_APP; }
 
   protected:
     // === Thread Entry Point ===
@@ -143,6 +148,14 @@ class CannedMessageModule : public SinglePortModule, public Observable<const UIF
     CallbackObserver<CannedMessageModule, const InputEvent *> inputObserver =
         CallbackObserver<CannedMessageModule, const InputEvent *>(this, &CannedMessageModule::handleInputEvent);
 
+    // === Layout caches, rebuilt only when what they were built from changes ===
+    std::vector<EmoteTokens> messageTokens;   // Tokens of each canned message, built by splitConfiguredMessages()
+    std::vector<uint8_t> messageEmoteHeights; // Tallest emote in each canned message, 0 if none
+    std::vector<EmoteTokens> freetextLines;   // Free text wrapped to the display width
+    String freetextLaidOut;                   // The text (with cursor) freetextLines was built for
+    int freetextLayoutWidth = 0;              // ...and the width it was wrapped to
+    void layoutFreetext(OLEDDisplay *display, const String &msgWithCursor);
+
     // === Display and UI ===
     int displayHeight = 64;
     int destIndex = 0;
@@ -6,6 +6,9 @@
 #include "configuration.h"
 #include "main.h"
 #include <Throttle.h>
+#if DETECTION_SENSOR_INTERRUPT && defined(ARCH_ESP32)
+#include "sleep.h"
+#endif
 DetectionSensorModule *detectionSensorModule;
 
 #define GPIO_POLLING_INTERVAL 100
@@ -75,6 +78,15 @@ int32_t DetectionSensorModule::runOnce()
         firstTime = false;
         if (moduleConfig.detection_sensor.monitor_pin > 0) {
             pinMode(moduleConfig.detection_sensor.monitor_pin, moduleConfig.detection_sensor.use_pullup ? INPUT_PULLUP : INPUT);
+#if DETECTION_SENSOR_INTERRUPT
+            if (sensorInterrupt.attach(moduleConfig.detection_sensor.monitor_pin, CHANGE, this)) {
+                seenEdges = sensorInterrupt.getEdgeCount();
+#ifdef ARCH_ESP32
+                lsObserver.observe(&notifyLightSleep);
+                lsEndObserver.observe(&notifyLightSleepEnd);
+#endif
+            }
+#endif
         } else {
             LOG_WARN("Detection Sensor Module: Set to enabled but no monitor pin is set. Disable module");
             return disable();
@@ -89,11 +101,25 @@ int32_t DetectionSensorModule::runOnce()
     if (!Throttle::isWithinTimespanMs(lastSentToMesh,
                                       Default::getConfiguredOrDefaultMs(moduleConfig.detection_sensor.minimum_broadcast_secs))) {
         bool isDetected = hasDetectionEvent();
+        bool observed = isDetected;
+#if DETECTION_SENSOR_INTERRUPT
+        // A pulse shorter than our reaction time is already over, but it left its edges behind
+        uint32_t edges = sensorInterrupt.getEdgeCount();
+        if (edges != seenEdges && !isDetected && !wasDetected)
+            observed = true;
+        seenEdges = edges;
+#endif
         DetectionSensorTriggerVerdict verdict =
-            handlers[moduleConfig.detection_sensor.detection_trigger_type](wasDetected, isDetected);
+            handlers[moduleConfig.detection_sensor.detection_trigger_type](wasDetected, observed);
         wasDetected = isDetected;
         switch (verdict) {
         case DetectionSensorVerdictDetected:
+#if DETECTION_SENSOR_INTERRUPT
+            detections++;
+            if (sensorInterrupt.isAttached())
+                LOG_INFO("Detection Sensor Module: reported %u ms after the pin changed, %u detections from %u edges",
+                         millis() - sensorInterrupt.getLastEdgeMs(), detections, edges);
+#endif
             sendDetectionMessage();
             return DELAYED_INTERVAL;
         case DetectionSensorVerdictSendState:
@@ -113,9 +139,59 @@ int32_t DetectionSensorModule::runOnce()
         sendCurrentStateMessage(hasDetectionEvent());
         return DELAYED_INTERVAL;
     }
+#if DETECTION_SENSOR_INTERRUPT
+    if (sensorInterrupt.isAttached())
+        return idleInterval();
+#endif
     return GPIO_POLLING_INTERVAL;
 }
 
+#if DETECTION_SENSOR_INTERRUPT
+int32_t DetectionSensorModule::idleInterval()
+{
+    uint32_t wait = INPUT_IDLE_POLL_MS; // In case an edge got lost
+    uint32_t sinceSent = millis() - lastSentToMesh;
+
+    // Look again when the minimum broadcast interval is over, a level trigger that is still active is reported then
+    uint32_t minimumMs = Default::getConfiguredOrDefaultMs(moduleConfig.detection_sensor.minimum_broadcast_secs);
+    if (sinceSent < minimumMs)
+        wait = std::min(wait, minimumMs - sinceSent);
+
+    if (moduleConfig.detection_sensor.state_broadcast_secs > 0) {
+        uint32_t stateMs = Default::getConfiguredOrDefaultMs(moduleConfig.detection_sensor.state_broadcast_secs,
+                                                             default_telemetry_broadcast_interval_secs);
+        wait = std::min(wait, sinceSent < stateMs ? stateMs - sinceSent : 0);
+    }
+    return wait;
+}
+
+#ifdef ARCH_ESP32
+int DetectionSensorModule::beforeLightSleep(void *unused)
+{
+    // Only while the pin is inactive, an active level would wake us right away
+    if (!hasDetectionEvent()) {
+        bool activeHigh = moduleConfig.detection_sensor.detection_trigger_type & 1;
+        gpio_wakeup_enable((gpio_num_t)moduleConfig.detection_sensor.monitor_pin,
+                           activeHigh ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+        wakeEnabled = true;
+    }
+    return 0;
+}
+
+int DetectionSensorModule::afterLightSleep(esp_sleep_wakeup_cause_t cause)
+{
+    if (!wakeEnabled)
+        return 0;
+    gpio_wakeup_disable((gpio_num_t)moduleConfig.detection_sensor.monitor_pin);
+    wakeEnabled = false;
+    // The pin may have woken us while its GPIO interrupt was off, so no edge was counted: look at it now
+    if (cause == ESP_SLEEP_WAKEUP_GPIO)
+        setIntervalFromNow(0);
+    return 0;
+}
+#endif
+#endif
+
 void DetectionSensorModule::sendDetectionMessage()
 {
     LOG_DEBUG("Detected event observed. Send message");
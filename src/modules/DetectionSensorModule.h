@@ -1,6 +1,20 @@
 #pragma once
 #include "SinglePortModule.h"
 
+/// Wake the module from an interrupt on the monitor pin instead of reading it every 100ms, so pulses shorter than that are seen
+/// and the module doesn't keep the CPU busy.  On ESP32 the pin also wakes us from light sleep.
+#ifndef DETECTION_SENSOR_INTERRUPT
+#define DETECTION_SENSOR_INTERRUPT 0
+#endif
+
+#if DETECTION_SENSOR_INTERRUPT
+#include "input/InputInterrupt.h"
+#ifdef ARCH_ESP32
+#include "Observer.h"
+#include <esp_sleep.h>
+#endif
+#endif
+
 class DetectionSensorModule : public SinglePortModule, private concurrency::OSThread
 {
   public:
@@ -18,6 +32,26 @@ class DetectionSensorModule : public SinglePortModule, private concurrency::OSTh
     void sendDetectionMessage();
     void sendCurrentStateMessage(bool state);
     bool hasDetectionEvent();
+
+#if DETECTION_SENSOR_INTERRUPT
+    InputInterrupt sensorInterrupt;
+    uint32_t seenEdges = 0; // sensorInterrupt's edge count when we last looked
+    uint32_t detections = 0;
+
+    /// How long runOnce() can sleep when the interrupt will wake it for any change of the pin
+    int32_t idleInterval();
+
+#ifdef ARCH_ESP32
+    // The active level of the pin wakes us from light sleep
+    int beforeLightSleep(void *unused);
+    int afterLightSleep(esp_sleep_wakeup_cause_t cause);
+    CallbackObserver<DetectionSensorModule, void *> lsObserver =
+        CallbackObserver<DetectionSensorModule, void *>(this, &DetectionSensorModule::beforeLightSleep);
+    CallbackObserver<DetectionSensorModule, esp_sleep_wakeup_cause_t> lsEndObserver =
+        CallbackObserver<DetectionSensorModule, esp_sleep_wakeup_cause_t>(this, &DetectionSensorModule::afterLightSleep);
+    bool wakeEnabled = false;
+#endif
+#endif
 };
 
 extern DetectionSensorModule *detectionSensorModule;
\ No newline at end of file
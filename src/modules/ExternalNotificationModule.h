@@ -64,6 +64,7 @@ class ExternalNotificationModule : public SinglePortModule, private concurrency:
     virtual int32_t runOnce() override;
 
     virtual bool wantPacket(const meshtastic_MeshPacket *p) override;
+    virtual int dispatchPortNum() const override { return MESHMODULE_ANY_PORT; }
 
     bool isNagging = false;
 
@@ -0,0 +1,195 @@
+#include "LinkBenchModule.h"
+#include "DisplayFormatters.h"
+#include "MeshService.h"
+#include "NodeDB.h"
+#include "RadioLibInterface.h"
+#include "Router.h"
+#include "main.h"
+#include <algorithm>
+#ifdef ARCH_PORTDUINO
+#include "platform/portduino/SimRadio.h"
+#endif
+
+LinkBenchModule *linkBenchModule;
+
+static constexpr uint16_t DEFAULT_INTERVAL_MS = 5000;
+
+LinkBenchModule::LinkBenchModule()
+    : SinglePortModule("linkbench", (meshtastic_PortNum)LINK_BENCH_PORTNUM), concurrency::OSThread("LinkBench")
+{
+    disable(); // until the phone starts a run
+}
+
+ProcessMessage LinkBenchModule::handleReceived(const meshtastic_MeshPacket &mp)
+{
+    const meshtastic_Data &d = mp.decoded;
+    if (d.payload.size < 1)
+        return ProcessMessage::CONTINUE;
+
+    switch (d.payload.bytes[0]) {
+    case START:
+        if (mp.from == 0 && d.payload.size >= sizeof(Command)) {
+            Command c;
+            memcpy(&c, d.payload.bytes, sizeof(c));
+            start(c);
+        }
+        break;
+
+    case STOP:
+        if (mp.from == 0 && run) {
+            LOG_INFO("Link bench run %u stopped by the phone", run);
+            report();
+        }
+        break;
+
+    case PROBE:
+        if (!isFromUs(&mp) && d.payload.size >= sizeof(Probe)) {
+            Probe probe;
+            memcpy(&probe, d.payload.bytes, sizeof(probe));
+            if (probe.target == nodeDB->getNodeNum())
+                echo(mp, probe);
+        }
+        break;
+
+    case ECHO:
+        if (run && isToUs(&mp) && d.payload.size >= sizeof(Echo)) {
+            Echo e;
+            memcpy(&e, d.payload.bytes, sizeof(e));
+            if (e.run != run || e.seq >= sent || echoed[e.seq])
+                break; // an earlier run's, or a duplicate
+            echoed[e.seq] = true;
+            rtts.push_back(millis() - e.sentMs);
+            snrX4Sum += e.snrX4;
+            hopsSum += e.hops;
+            if (sent == cmd.count && rtts.size() == sent)
+                setIntervalFromNow(0); // all back, no need to wait out the drain
+        }
+        break;
+    }
+    return ProcessMessage::STOP;
+}
+
+void LinkBenchModule::start(const Command &c)
+{
+    if (c.count == 0 || c.count > LINK_BENCH_MAX_PACKETS || c.mode > BROADCAST || c.dest == 0 || c.dest == NODENUM_BROADCAST ||
+        c.dest == nodeDB->getNodeNum()) {
+        LOG_WARN("Link bench: bad command (count=%u mode=%u dest=0x%x)", c.count, c.mode, c.dest);
+        return;
+    }
+    if (run)
+        LOG_WARN("Link bench run %u abandoned for a new one", run);
+
+    cmd = c;
+    cmd.intervalMs = cmd.intervalMs ? cmd.intervalMs : DEFAULT_INTERVAL_MS;
+    cmd.size = std::max<uint8_t>(cmd.size, sizeof(Probe));
+    cmd.size = std::min<uint8_t>(cmd.size, meshtastic_Constants_DATA_PAYLOAD_LEN);
+    run = random(1, 0x10000); // so late echoes of an earlier run aren't counted
+    sent = 0;
+    rtts.clear();
+    rtts.reserve(cmd.count);
+    echoed.assign(cmd.count, false);
+    snrX4Sum = 0;
+    hopsSum = 0;
+    startMs = millis();
+    txAtStart = transmissions();
+
+    LOG_INFO("Link bench run %u: %u probes of %u bytes to 0x%x every %u ms, mode %u", run, cmd.count, cmd.size, cmd.dest,
+             cmd.intervalMs, cmd.mode);
+    enabled = true;
+    setIntervalFromNow(0);
+}
+
+int32_t LinkBenchModule::runOnce()
+{
+    if (!run)
+        return disable();
+
+    if (sent < cmd.count) {
+        sendProbe();
+        return sent < cmd.count ? cmd.intervalMs : LINK_BENCH_DRAIN_MS;
+    }
+
+    // Waited out the drain, or everything is back
+    report();
+    return disable();
+}
+
+void LinkBenchModule::sendProbe()
+{
+    meshtastic_MeshPacket *p = allocDataPacket();
+    p->to = cmd.mode == BROADCAST ? NODENUM_BROADCAST : cmd.dest;
+    p->want_ack = cmd.mode == UNICAST_ACK;
+
+    Probe probe = {PROBE, run, sent, millis(), cmd.dest};
+    memset(p->decoded.payload.bytes, 0, cmd.size);
+    memcpy(p->decoded.payload.bytes, &probe, sizeof(probe));
+    p->decoded.payload.size = cmd.size;
+
+    lastSentMs = probe.sentMs;
+    sent++;
+    service->sendToMesh(p);
+}
+
+void LinkBenchModule::echo(const meshtastic_MeshPacket &mp, const Probe &probe)
+{
+    meshtastic_MeshPacket *p = allocDataPacket();
+    p->to = getFrom(&mp);
+    p->channel = mp.channel;
+    p->want_ack = false;
+
+    Echo e = {ECHO, probe.run, probe.seq, probe.sentMs, (int8_t)(mp.rx_snr * 4), (int16_t)mp.rx_rssi,
+              (uint8_t)(mp.hop_start >= mp.hop_limit ? mp.hop_start - mp.hop_limit : 0)};
+    memcpy(p->decoded.payload.bytes, &e, sizeof(e));
+    p->decoded.payload.size = sizeof(e);
+    service->sendToMesh(p);
+}
+
+void LinkBenchModule::report()
+{
+    uint32_t elapsedMs = millis() - startMs;
+    uint32_t got = rtts.size();
+    uint32_t lossPct = sent ? (sent - got) * 100 / sent : 0;
+    uint32_t goodputBps = elapsedMs ? (uint64_t)got * cmd.size * 8 * 1000 / elapsedMs : 0;
+    uint32_t tx = transmissions() - txAtStart; // probes, retransmissions and echoes we relayed, plus anything else we sent
+
+    uint32_t rttMin = 0, rtt50 = 0, rtt90 = 0, rttMax = 0;
+    if (got) {
+        std::vector<uint32_t> sorted = rtts;
+        std::sort(sorted.begin(), sorted.end());
+        rttMin = sorted.front();
+        rtt50 = sorted[(got - 1) / 2];
+        rtt90 = sorted[(got - 1) * 9 / 10];
+        rttMax = sorted.back();
+    }
+    int32_t snr10 = got ? snrX4Sum * 10 / 4 / (int32_t)got : 0; // tenths of a dB
+    uint32_t hops10 = got ? hopsSum * 10 / got : 0;
+    static const char *modes[] = {"unicast", "unicast+ack", "broadcast"};
+    const char *preset =
+        config.lora.use_preset ? DisplayFormatters::getModemPresetDisplayName(config.lora.modem_preset, false) : "Custom";
+
+    char summary[meshtastic_Constants_DATA_PAYLOAD_LEN];
+    int len = snprintf(summary, sizeof(summary),
+                       "Link bench run %u to !%08x, %s, %s, %u B: sent %u, echoed %u, loss %u%%, goodput %u bit/s, "
+                       "RTT ms min %u p50 %u p90 %u max %u, %u transmissions, SNR there %s%d.%d dB, %u.%u hops",
+                       run, cmd.dest, preset, modes[cmd.mode], cmd.size, sent, got, lossPct, goodputBps, rttMin, rtt50, rtt90,
+                       rttMax, tx, snr10 < 0 ? "-" : "", abs(snr10) / 10, abs(snr10) % 10, hops10 / 10, hops10 % 10);
+    LOG_INFO("%s", summary);
+
+    meshtastic_MeshPacket *p = allocDataPacket();
+    p->to = nodeDB->getNodeNum();
+    p->decoded.payload.size = std::min<int>(len, sizeof(summary) - 1);
+    memcpy(p->decoded.payload.bytes, summary, p->decoded.payload.size);
+    service->sendToPhone(p);
+
+    run = 0;
+    echoed.clear();
+}
+
+uint32_t LinkBenchModule::transmissions()
+{
+#ifdef ARCH_PORTDUINO
+    if (SimRadio::instance)
+        return SimRadio::instance->txGood;
+#endif
+    return RadioLibInterface::instance ? RadioLibInterface::instance->txGood : 0;
+}
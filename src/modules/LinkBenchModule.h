@@ -0,0 +1,96 @@
+#pragma once
+
+#include "SinglePortModule.h"
+#include "concurrency/OSThread.h"
+#include "configuration.h"
+#include <vector>
+
+/// A private application port, the benchmark has no portnum of its own
+#ifndef LINK_BENCH_PORTNUM
+#define LINK_BENCH_PORTNUM 288
+#endif
+
+/// Most probes one run sends
+#ifndef LINK_BENCH_MAX_PACKETS
+#define LINK_BENCH_MAX_PACKETS 200
+#endif
+
+/// How long after the last probe a run waits for stragglers before reporting
+#ifndef LINK_BENCH_DRAIN_MS
+#define LINK_BENCH_DRAIN_MS (30 * 1000)
+#endif
+
+/**
+ * A radio link benchmark between this node and another one running it too.
+ *
+ * The phone starts a run by sending this node a Command on LINK_BENCH_PORTNUM: a burst of count probes of size bytes to dest,
+ * one every intervalMs, unicast with or without want_ack or broadcast.  dest echoes each probe straight back to us (a
+ * broadcast probe too, the echo is always unicast and never wants an ack).  Once every probe is echoed, or LINK_BENCH_DRAIN_MS
+ * after the last was sent, the phone gets a text summary on the same port: the preset, probes sent and echoed, loss, goodput
+ * of probe payload that made it there and back, the round trip time distribution, how many times our radio transmitted
+ * during the run (retransmissions included) and the SNR the far end heard us at.  The summary is logged too.
+ *
+ * All messages are packed little endian structs, led by their Type.
+ */
+class LinkBenchModule : public SinglePortModule, private concurrency::OSThread
+{
+  public:
+    enum Type : uint8_t { START = 1, STOP = 2, PROBE = 3, ECHO = 4 };
+    enum Mode : uint8_t { UNICAST = 0, UNICAST_ACK = 1, BROADCAST = 2 };
+
+    /// From the phone, to start (or with STOP, abandon) a run
+    struct __attribute__((packed)) Command {
+        uint8_t type;
+        uint32_t dest;       // the node that echoes
+        uint16_t count;      // probes, up to LINK_BENCH_MAX_PACKETS
+        uint16_t intervalMs; // between probes, 0 for the default
+        uint8_t mode;        // Mode
+        uint8_t size;        // payload bytes per probe, padded with zeros, 0 for the smallest
+    };
+
+    struct __attribute__((packed)) Probe {
+        uint8_t type;
+        uint16_t run;
+        uint16_t seq;
+        uint32_t sentMs; // our clock, echoed back so the round trip needs no state per probe
+        uint32_t target; // the node that should echo, for broadcast probes
+    };
+
+    struct __attribute__((packed)) Echo {
+        uint8_t type;
+        uint16_t run;
+        uint16_t seq;
+        uint32_t sentMs;
+        int8_t snrX4; // the probe as the far end heard it
+        int16_t rssi;
+        uint8_t hops; // the probe took to get there
+    };
+
+    LinkBenchModule();
+
+  protected:
+    virtual ProcessMessage handleReceived(const meshtastic_MeshPacket &mp) override;
+
+    virtual int32_t runOnce() override;
+
+  private:
+    uint16_t run = 0; // current run, 0 if there is none
+    Command cmd = {};
+    uint16_t sent = 0;
+    uint32_t startMs = 0, lastSentMs = 0;
+    uint32_t txAtStart = 0;
+    std::vector<uint32_t> rtts; // of the probes echoed so far, in arrival order
+    std::vector<bool> echoed;   // by seq, duplicates don't count twice
+    int32_t snrX4Sum = 0;       // over the echoes
+    uint32_t hopsSum = 0;
+
+    void start(const Command &c);
+    void sendProbe();
+    void echo(const meshtastic_MeshPacket &mp, const Probe &probe);
+    void report();
+
+    /// Frames our radio has sent since boot
+    static uint32_t transmissions();
+};
+
+extern LinkBenchModule *linkBenchModule;
@@ -43,6 +43,12 @@
 #if !MESHTASTIC_EXCLUDE_POWERSTRESS
 #include "modules/PowerStressModule.h"
 #endif
+#if !MESHTASTIC_EXCLUDE_LINKBENCH
+#include "modules/LinkBenchModule.h"
+#endif
+#if !MESHTASTIC_EXCLUDE_BULKTRANSFER
+#include "modules/BulkTransferModule.h"
+#endif
 #include "modules/RoutingModule.h"
 #include "modules/TextMessageModule.h"
 #if !MESHTASTIC_EXCLUDE_TRACEROUTE
@@ -104,6 +110,9 @@
 
 /**
  * Create module instances here.  If you are adding a new module, you must 'new' it here (or somewhere else)
+ *
+ * Modules that do nothing unless switched on in moduleConfig are only created when they are enabled, so a disabled one costs
+ * no RAM and no OSThread for the scheduler to look at.  Changing moduleConfig reboots the node, which then creates them.
  */
 void setupModules()
 {
@@ -137,7 +146,8 @@ void setupModules()
         neighborInfoModule = new NeighborInfoModule();
 #endif
 #if !MESHTASTIC_EXCLUDE_DETECTIONSENSOR
-        detectionSensorModule = new DetectionSensorModule();
+        if (moduleConfig.detection_sensor.enabled)
+            detectionSensorModule = new DetectionSensorModule();
 #endif
 #if !MESHTASTIC_EXCLUDE_ATAK
         atakPluginModule = new AtakPluginModule();
@@ -159,6 +169,15 @@ void setupModules()
 #endif
 #if !MESHTASTIC_EXCLUDE_POWERSTRESS
         new PowerStressModule();
+#endif
+#if !MESHTASTIC_EXCLUDE_LINKBENCH
+        linkBenchModule = new LinkBenchModule();
+#endif
+#if !MESHTASTIC_EXCLUDE_BULKTRANSFER
+        bulkTransferModule = new BulkTransferModule();
+#if ADMIN_BULK_CONFIG
+        bulkTransferModule->setReceiver(BulkTransferModule::KIND_ADMIN, AdminModule::handleBulkConfig);
+#endif
 #endif
         // Example: Put your module here
         // new ReplyModule();
@@ -234,8 +253,8 @@ void setupModules()
 #if (defined(ARCH_ESP32) || defined(ARCH_NRF52) || defined(ARCH_RP2040)) && !defined(CONFIG_IDF_TARGET_ESP32S2) &&               \
     !defined(CONFIG_IDF_TARGET_ESP32C3)
 #if !MESHTASTIC_EXCLUDE_SERIAL
-        if (config.display.displaymode != meshtastic_Config_DisplayConfig_DisplayMode_COLOR) {
-            new SerialModule();
+        if (config.display.displaymode != meshtastic_Config_DisplayConfig_DisplayMode_COLOR && moduleConfig.serial.enabled) {
+            serialModule = new SerialModule();
         }
 #endif
 #endif
@@ -245,12 +264,14 @@ void setupModules()
         audioModule = new AudioModule();
 #endif
 #if !MESHTASTIC_EXCLUDE_PAXCOUNTER
-        paxcounterModule = new PaxcounterModule();
+        if (moduleConfig.paxcounter.enabled)
+            paxcounterModule = new PaxcounterModule();
 #endif
 #endif
-#if defined(ARCH_ESP32) || defined(ARCH_PORTDUINO)
+#if defined(ARCH_ESP32) || defined(ARCH_PORTDUINO) || defined(ARCH_NRF52) || defined(ARCH_RP2040)
 #if !MESHTASTIC_EXCLUDE_STOREFORWARD
-        storeForwardModule = new StoreForwardModule();
+        if (moduleConfig.store_forward.enabled)
+            storeForwardModule = new StoreForwardModule();
 #endif
 #endif
 #if defined(ARCH_ESP32) || defined(ARCH_NRF52) || defined(ARCH_RP2040) || defined(ARCH_PORTDUINO)
@@ -258,7 +279,8 @@ void setupModules()
         externalNotificationModule = new ExternalNotificationModule();
 #endif
 #if !MESHTASTIC_EXCLUDE_RANGETEST && !MESHTASTIC_EXCLUDE_GPS
-        new RangeTestModule();
+        if (moduleConfig.range_test.enabled)
+            rangeTestModule = new RangeTestModule();
 #endif
 #endif
     } else {
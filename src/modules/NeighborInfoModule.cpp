@@ -28,10 +28,9 @@ NOTE: for debugging only
 */
 void NeighborInfoModule::printNodeDBNeighbors()
 {
-    LOG_DEBUG("Our NodeDB contains %d neighbors", neighbors.size());
-    for (size_t i = 0; i < neighbors.size(); i++) {
-        LOG_DEBUG("Node %d: node_id=0x%x, snr=%.2f", i, neighbors[i].node_id, neighbors[i].snr);
-    }
+    LOG_DEBUG("Our NodeDB contains %d neighbors", neighborTable.size());
+    neighborTable.forEach(
+        [](NodeNum n, const NeighborEntry &e) { LOG_DEBUG("Node: node_id=0x%x, snr=%.2f", n, e.snr); });
 }
 
 /* Send our initial owner announcement 35 seconds after we start (to give network time to setup) */
@@ -67,15 +66,15 @@ uint32_t NeighborInfoModule::collectNeighborInfo(meshtastic_NeighborInfo *neighb
 
     cleanUpNeighbors();
 
-    for (auto nbr : neighbors) {
-        if ((neighborInfo->neighbors_count < MAX_NUM_NEIGHBORS) && (nbr.node_id != my_node_id)) {
-            neighborInfo->neighbors[neighborInfo->neighbors_count].node_id = nbr.node_id;
-            neighborInfo->neighbors[neighborInfo->neighbors_count].snr = nbr.snr;
+    neighborTable.forEach([&](NodeNum n, const NeighborEntry &e) {
+        if ((neighborInfo->neighbors_count < MAX_NUM_NEIGHBORS) && (n != my_node_id)) {
+            neighborInfo->neighbors[neighborInfo->neighbors_count].node_id = n;
+            neighborInfo->neighbors[neighborInfo->neighbors_count].snr = e.snr;
             // Note: we don't set the last_rx_time and node_broadcast_intervals_secs here, because we don't want to send this over
             // the mesh
             neighborInfo->neighbors_count++;
         }
-    }
+    });
     printNodeDBNeighbors();
     return neighborInfo->neighbors_count;
 }
@@ -85,19 +84,8 @@ uint32_t NeighborInfoModule::collectNeighborInfo(meshtastic_NeighborInfo *neighb
 */
 void NeighborInfoModule::cleanUpNeighbors()
 {
-    uint32_t now = getTime();
-    NodeNum my_node_id = nodeDB->getNodeNum();
-    for (auto it = neighbors.rbegin(); it != neighbors.rend();) {
-        // We will remove a neighbor if we haven't heard from them in twice the broadcast interval
-        // cannot use isWithinTimespanMs() as it->last_rx_time is seconds since 1970
-        if ((now - it->last_rx_time > it->node_broadcast_interval_secs * 2) && (it->node_id != my_node_id)) {
-            LOG_DEBUG("Remove neighbor with node ID 0x%x", it->node_id);
-            it = std::vector<meshtastic_Neighbor>::reverse_iterator(
-                neighbors.erase(std::next(it).base())); // Erase the element and update the iterator
-        } else {
-            ++it;
-        }
-    }
+    // We will remove a neighbor if we haven't heard from them in twice the broadcast interval
+    neighborTable.expire(getTime());
 }
 
 /* Send neighbor info to the mesh */
@@ -162,7 +150,7 @@ void NeighborInfoModule::alterReceivedProtobuf(meshtastic_MeshPacket &p, meshtas
 
 void NeighborInfoModule::resetNeighbors()
 {
-    neighbors.clear();
+    neighborTable.clear();
 }
 
 void NeighborInfoModule::updateNeighbors(const meshtastic_MeshPacket &mp, const meshtastic_NeighborInfo *np)
@@ -174,44 +162,13 @@ void NeighborInfoModule::updateNeighbors(const meshtastic_MeshPacket &mp, const
     }
 }
 
-meshtastic_Neighbor *NeighborInfoModule::getOrCreateNeighbor(NodeNum originalSender, NodeNum n,
-                                                             uint32_t node_broadcast_interval_secs, float snr)
+void NeighborInfoModule::getOrCreateNeighbor(NodeNum originalSender, NodeNum n, uint32_t node_broadcast_interval_secs, float snr)
 {
     // our node and the phone are the same node (not neighbors)
-    if (n == 0) {
-        n = nodeDB->getNodeNum();
-    }
-    // look for one in the existing list
-    for (size_t i = 0; i < neighbors.size(); i++) {
-        if (neighbors[i].node_id == n) {
-            // if found, update it
-            neighbors[i].snr = snr;
-            neighbors[i].last_rx_time = getTime();
-            // Only if this is the original sender, the broadcast interval corresponds to it
-            if (originalSender == n && node_broadcast_interval_secs != 0)
-                neighbors[i].node_broadcast_interval_secs = node_broadcast_interval_secs;
-            return &neighbors[i];
-        }
-    }
-    // otherwise, allocate one and assign data to it
-
-    meshtastic_Neighbor new_nbr = meshtastic_Neighbor_init_zero;
-    new_nbr.node_id = n;
-    new_nbr.snr = snr;
-    new_nbr.last_rx_time = getTime();
+    if (n == 0 || n == nodeDB->getNodeNum())
+        return;
     // Only if this is the original sender, the broadcast interval corresponds to it
-    if (originalSender == n && node_broadcast_interval_secs != 0)
-        new_nbr.node_broadcast_interval_secs = node_broadcast_interval_secs;
-    else // Assume the same broadcast interval as us for the neighbor if we don't know it
-        new_nbr.node_broadcast_interval_secs = moduleConfig.neighbor_info.update_interval;
-
-    if (neighbors.size() < MAX_NUM_NEIGHBORS) {
-        neighbors.push_back(new_nbr);
-    } else {
-        // If we have too many neighbors, replace the oldest one
-        LOG_WARN("Neighbor DB is full, replace oldest neighbor");
-        neighbors.erase(neighbors.begin());
-        neighbors.push_back(new_nbr);
-    }
-    return &neighbors.back();
-}
\ No newline at end of file
+    uint32_t interval = originalSender == n ? node_broadcast_interval_secs : 0;
+    // Assume the same broadcast interval as us for the neighbor if we don't know it
+    neighborTable.heard(n, snr, getTime(), interval, moduleConfig.neighbor_info.update_interval);
+}
@@ -1,6 +1,6 @@
 #pragma once
+#include "NeighborTable.h"
 #include "ProtobufModule.h"
-#define MAX_NUM_NEIGHBORS 10 // also defined in NeighborInfo protobuf options
 
 /*
  * Neighborinfo module for sending info on each node's 0-hop neighbors to the mesh
@@ -10,8 +10,6 @@ class NeighborInfoModule : public ProtobufModule<meshtastic_NeighborInfo>, priva
     CallbackObserver<NeighborInfoModule, const meshtastic::Status *> nodeStatusObserver =
         CallbackObserver<NeighborInfoModule, const meshtastic::Status *>(this, &NeighborInfoModule::handleStatusUpdate);
 
-    std::vector<meshtastic_Neighbor> neighbors;
-
   public:
     /*
      * Expose the constructor
@@ -42,8 +40,8 @@ class NeighborInfoModule : public ProtobufModule<meshtastic_NeighborInfo>, priva
     /* Allocate a new NeighborInfo packet */
     meshtastic_NeighborInfo *allocateNeighborInfoPacket();
 
-    // Find a neighbor in our DB, create an empty neighbor if missing
-    meshtastic_Neighbor *getOrCreateNeighbor(NodeNum originalSender, NodeNum n, uint32_t node_broadcast_interval_secs, float snr);
+    // Update a neighbor in our DB, adding it if missing
+    void getOrCreateNeighbor(NodeNum originalSender, NodeNum n, uint32_t node_broadcast_interval_secs, float snr);
 
     /*
      * Send info on our node's neighbors into the mesh
@@ -62,6 +60,7 @@ class NeighborInfoModule : public ProtobufModule<meshtastic_NeighborInfo>, priva
     /* Override wantPacket to say we want to see all packets when enabled, not just those for our port number.
       Exception is when the packet came via MQTT */
     virtual bool wantPacket(const meshtastic_MeshPacket *p) override { return enabled && !p->via_mqtt; }
+    virtual int dispatchPortNum() const override { return MESHMODULE_ANY_PORT; }
 
     /* These are for debugging only */
     void printNeighborInfo(const char *header, const meshtastic_NeighborInfo *np);
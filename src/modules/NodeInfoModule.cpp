@@ -3,7 +3,10 @@
 #include "MeshService.h"
 #include "NodeDB.h"
 #include "RTC.h"
+#include "PacketAggregation.h"
+#include "PayloadCompression.h"
 #include "Router.h"
+#include "TextCompression.h"
 #include "configuration.h"
 #include "main.h"
 #include <Throttle.h>
@@ -18,24 +21,91 @@ bool NodeInfoModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, mes
     snprintf(p.id, sizeof(p.id), "!%08x", getFrom(&mp));
 
     bool hasChanged = nodeDB->updateUser(getFrom(&mp), p, mp.channel);
+#if TEXT_COMPRESSION
+    TextCompression::setPeerSupports(getFrom(&mp), mp.decoded.has_bitfield &&
+                                                       (mp.decoded.bitfield & BITFIELD_TEXT_COMPRESSION_MASK));
+#endif
+#if PAYLOAD_COMPRESSION
+    PayloadCompression::setPeerSupports(getFrom(&mp), mp.decoded.has_bitfield &&
+                                                          (mp.decoded.bitfield & BITFIELD_PAYLOAD_COMPRESSION_MASK));
+#endif
+#if PACKET_AGGREGATION
+    PacketAggregation::setPeerSupports(getFrom(&mp),
+                                       mp.decoded.has_bitfield && (mp.decoded.bitfield & BITFIELD_AGGREGATION_MASK));
+#endif
+
+#if NODEINFO_REPLY_SUPPRESSION
+    overheardReply(mp);
+#endif
 
     bool wasBroadcast = isBroadcast(mp.to);
 
     // if user has changed while packet was not for us, inform phone
     if (hasChanged && !wasBroadcast && !isToUs(&mp))
-        service->sendToPhone(packetPool.allocCopy(mp));
+        service->sendToPhone(packetPool.share(const_cast<meshtastic_MeshPacket *>(&mp)));
 
     // LOG_DEBUG("did handleReceived");
     return false; // Let others look at this message also if they want
 }
 
+#if NODEINFO_REPLY_SUPPRESSION
+bool NodeInfoModule::recentlySentTo(NodeNum dest) const
+{
+    for (const SentTo &s : sentTo)
+        if (s.to == dest && Throttle::isWithinTimespanMs(s.ms, NODEINFO_REPLY_CACHE_SECS * 1000))
+            return true;
+    return false;
+}
+
+void NodeInfoModule::noteSentTo(NodeNum dest)
+{
+    for (SentTo &s : sentTo) {
+        if (s.to == dest) {
+            s.ms = millis();
+            return;
+        }
+    }
+    sentTo[nextSentTo] = {dest, millis()};
+    nextSentTo = (nextSentTo + 1) % NODEINFO_REPLY_TRACKED;
+}
+
+void NodeInfoModule::overheardReply(const meshtastic_MeshPacket &mp)
+{
+    PendingReply &r = pendingReply;
+    if (!r.id || isFromUs(&mp) || mp.decoded.request_id != r.requestId || mp.to != r.requester)
+        return;
+    if (++r.overheard < NODEINFO_REPLY_SUPPRESS_AFTER)
+        return;
+
+    if (service->cancelSending(r.id)) {
+        LOG_DEBUG("Drop our NodeInfo reply to 0x%x, %u others answered already", r.requester, r.overheard);
+        lastSentToMesh = r.prevSentToMesh;
+        if (prevPacketId == r.id)
+            prevPacketId = 0;
+    }
+    r.id = 0;
+}
+#endif
+
 void NodeInfoModule::sendOurNodeInfo(NodeNum dest, bool wantReplies, uint8_t channel, bool _shorterTimeout)
 {
+#if NODEINFO_REPLY_SUPPRESSION
+    if (!isBroadcast(dest) && recentlySentTo(dest)) {
+        LOG_DEBUG("Skip send NodeInfo to 0x%x, sent it recently", dest);
+        return;
+    }
+#endif
     // cancel any not yet sent (now stale) position packets
     if (prevPacketId) // if we wrap around to zero, we'll simply fail to cancel in that rare case (no big deal)
         service->cancelSending(prevPacketId);
     shorterTimeout = _shorterTimeout;
+#if NODEINFO_REPLY_SUPPRESSION
+    sendingOurs = true;
     meshtastic_MeshPacket *p = allocReply();
+    sendingOurs = false;
+#else
+    meshtastic_MeshPacket *p = allocReply();
+#endif
     if (p) { // Check whether we didn't ignore it
         p->to = dest;
         p->decoded.want_response = (config.device.role != meshtastic_Config_DeviceConfig_Role_TRACKER &&
@@ -51,6 +121,10 @@ void NodeInfoModule::sendOurNodeInfo(NodeNum dest, bool wantReplies, uint8_t cha
         }
 
         prevPacketId = p->id;
+#if NODEINFO_REPLY_SUPPRESSION
+        if (!isBroadcast(dest))
+            noteSentTo(dest);
+#endif
 
         service->sendToMesh(p);
         shorterTimeout = false;
@@ -64,6 +138,15 @@ meshtastic_MeshPacket *NodeInfoModule::allocReply()
         LOG_DEBUG("Skip send NodeInfo > 40%% ch. util");
         return NULL;
     }
+#if NODEINFO_REPLY_SUPPRESSION
+    // Answering a request, sendOurNodeInfo() checks its own destination
+    const meshtastic_MeshPacket *request = sendingOurs ? NULL : currentRequest;
+    if (request && recentlySentTo(getFrom(request))) {
+        LOG_DEBUG("Skip send NodeInfo to 0x%x, sent it recently", getFrom(request));
+        ignoreRequest = true;
+        return NULL;
+    }
+#endif
     // If we sent our NodeInfo less than 5 min. ago, don't send it again as it may be still underway.
     if (!shorterTimeout && lastSentToMesh && Throttle::isWithinTimespanMs(lastSentToMesh, 5 * 60 * 1000)) {
         LOG_DEBUG("Skip send NodeInfo since we sent it <5min ago");
@@ -89,8 +172,38 @@ meshtastic_MeshPacket *NodeInfoModule::allocReply()
         }
 
         LOG_INFO("Send owner %s/%s/%s", u.id, u.long_name, u.short_name);
+#if NODEINFO_REPLY_SUPPRESSION
+        uint32_t prevSentToMesh = lastSentToMesh;
+#endif
         lastSentToMesh = millis();
-        return allocDataProtobuf(u);
+        meshtastic_MeshPacket *p = allocDataProtobuf(u);
+#if NODEINFO_REPLY_SUPPRESSION
+        if (p && request) {
+            noteSentTo(getFrom(request));
+            // Others nearby heard a broadcast request too, ours may not be needed
+            if (isBroadcast(request->to))
+                pendingReply = {getFrom(request), request->id, p->id, prevSentToMesh, 0};
+        }
+#endif
+#if TEXT_COMPRESSION
+        if (p) {
+            p->decoded.has_bitfield = true;
+            p->decoded.bitfield |= BITFIELD_TEXT_COMPRESSION_MASK;
+        }
+#endif
+#if PAYLOAD_COMPRESSION
+        if (p) {
+            p->decoded.has_bitfield = true;
+            p->decoded.bitfield |= BITFIELD_PAYLOAD_COMPRESSION_MASK;
+        }
+#endif
+#if PACKET_AGGREGATION
+        if (p) {
+            p->decoded.has_bitfield = true;
+            p->decoded.bitfield |= BITFIELD_AGGREGATION_MASK;
+        }
+#endif
+        return p;
     }
 }
 
@@ -113,5 +226,10 @@ int32_t NodeInfoModule::runOnce()
         LOG_INFO("Send our nodeinfo to mesh (wantReplies=%d)", requestReplies);
         sendOurNodeInfo(NODENUM_BROADCAST, requestReplies); // Send our info (don't request replies)
     }
+#if CONGESTION_AIRTIME_SCALING
+    return Default::getConfiguredOrDefaultMsScaled(config.device.node_info_broadcast_secs, default_node_info_broadcast_secs,
+                                                   nodeDB->getNumOnlineMeshNodes(), meshtastic_PortNum_NODEINFO_APP);
+#else
     return Default::getConfiguredOrDefaultMs(config.device.node_info_broadcast_secs, default_node_info_broadcast_secs);
+#endif
 }
\ No newline at end of file
@@ -1,6 +1,20 @@
 #pragma once
 #include "ProtobufModule.h"
 
+/// Set to 1 to cut the bursts of NodeInfo replies a node joining a dense mesh triggers: we don't answer the same node twice
+/// within NODEINFO_REPLY_CACHE_SECS, and drop our queued answer to a broadcast request once others answered it
+#ifndef NODEINFO_REPLY_SUPPRESSION
+#define NODEINFO_REPLY_SUPPRESSION 0
+#endif
+#ifndef NODEINFO_REPLY_CACHE_SECS
+#define NODEINFO_REPLY_CACHE_SECS (10 * 60)
+#endif
+/// How many other nodes' answers to the same broadcast request we wait to overhear before dropping ours
+#ifndef NODEINFO_REPLY_SUPPRESS_AFTER
+#define NODEINFO_REPLY_SUPPRESS_AFTER 2
+#endif
+#define NODEINFO_REPLY_TRACKED 8 // nodes we remember sending our NodeInfo to
+
 /**
  * NodeInfo module for sending/receiving NodeInfos into the mesh
  */
@@ -40,6 +54,33 @@ class NodeInfoModule : public ProtobufModule<meshtastic_User>, private concurren
   private:
     uint32_t lastSentToMesh = 0; // Last time we sent our NodeInfo to the mesh
     bool shorterTimeout = false;
+
+#if NODEINFO_REPLY_SUPPRESSION
+    struct SentTo {
+        NodeNum to;
+        uint32_t ms;
+    };
+    SentTo sentTo[NODEINFO_REPLY_TRACKED] = {};
+    uint8_t nextSentTo = 0;
+
+    /// Our queued answer to a broadcast request, and how many answers from others to it we overheard
+    struct PendingReply {
+        NodeNum requester;
+        PacketId requestId;
+        PacketId id;
+        uint32_t prevSentToMesh; // lastSentToMesh before, restored if we drop the answer
+        uint8_t overheard;
+    };
+    PendingReply pendingReply = {};
+    bool sendingOurs = false; // allocReply() is called by sendOurNodeInfo(), not to answer currentRequest
+
+    /// Did we send our NodeInfo to dest in the last NODEINFO_REPLY_CACHE_SECS?
+    bool recentlySentTo(NodeNum dest) const;
+    void noteSentTo(NodeNum dest);
+
+    /// Count an answer from someone else to the broadcast request we answered too, drop ours once there are enough
+    void overheardReply(const meshtastic_MeshPacket &mp);
+#endif
 };
 
 extern NodeInfoModule *nodeInfoModule;
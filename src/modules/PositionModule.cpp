@@ -406,7 +406,8 @@ int32_t PositionModule::runOnce()
     // We limit our GPS broadcasts to a max rate
     uint32_t now = millis();
     uint32_t intervalMs = Default::getConfiguredOrDefaultMsScaled(config.position.position_broadcast_secs,
-                                                                  default_broadcast_interval_secs, numOnlineNodes);
+                                                                  default_broadcast_interval_secs, numOnlineNodes,
+                                                                  meshtastic_PortNum_POSITION_APP);
     uint32_t msSinceLastSend = now - lastGpsSend;
     // Only send packets if the channel util. is less than 25% utilized or we're a tracker with less than 40% utilized.
     if (!airTime->isTxAllowedChannelUtil(config.device.role != meshtastic_Config_DeviceConfig_Role_TRACKER &&
@@ -418,8 +419,7 @@ int32_t PositionModule::runOnce()
         if (nodeDB->hasValidPosition(node)) {
             lastGpsSend = now;
 
-            lastGpsLatitude = node->position.latitude_i;
-            lastGpsLongitude = node->position.longitude_i;
+            rememberSentPosition(node->position);
 
             sendOurPosition();
             if (config.device.role == meshtastic_Config_DeviceConfig_Role_LOST_AND_FOUND) {
@@ -446,8 +446,7 @@ int32_t PositionModule::runOnce()
                           msSinceLastSend, minimumTimeThreshold);
 
                 // Set the current coords as our last ones, after we've compared distance with current and decided to send
-                lastGpsLatitude = node->position.latitude_i;
-                lastGpsLongitude = node->position.longitude_i;
+                rememberSentPosition(node->position);
             }
         }
     }
@@ -477,8 +476,17 @@ struct SmartPosition PositionModule::getDistanceTraveledSinceLastSend(meshtastic
         Default::getConfiguredOrDefault(config.position.broadcast_smart_minimum_distance, 100);
 
     // Determine the distance in meters between two points on the globe
-    float distanceTraveledSinceLastSend = GeoCoord::latLongToMeter(
-        lastGpsLatitude * 1e-7, lastGpsLongitude * 1e-7, currentPosition.latitude_i * 1e-7, currentPosition.longitude_i * 1e-7);
+    float distanceTraveledSinceLastSend, bearing;
+    GeoCoord::distanceAndBearing(lastGpsLatitude, lastGpsLongitude, currentPosition.latitude_i, currentPosition.longitude_i,
+                                 &distanceTraveledSinceLastSend, &bearing);
+
+    // With dead reckoning, how far we are from where a receiver thinks we have got to by now
+    if (motion.sentEast != 0 || motion.sentNorth != 0) {
+        float secs = (millis() - lastGpsSend) / 1000.0f;
+        float east = distanceTraveledSinceLastSend * sinf(bearing) - motion.sentEast * secs;
+        float north = distanceTraveledSinceLastSend * cosf(bearing) - motion.sentNorth * secs;
+        distanceTraveledSinceLastSend = sqrtf(east * east + north * north);
+    }
 
     return SmartPosition{.distanceTraveled = abs(distanceTraveledSinceLastSend),
                          .distanceThreshold = distanceTravelThreshold,
@@ -491,6 +499,7 @@ void PositionModule::handleNewPosition()
     const meshtastic_NodeInfoLite *node2 = service->refreshLocalMeshNode(); // should guarantee there is now a position
     // We limit our GPS broadcasts to a max rate
     if (nodeDB->hasValidPosition(node2)) {
+        updateMotion(node->position);
         auto smartPosition = getDistanceTraveledSinceLastSend(node->position);
         uint32_t msSinceLastSend = millis() - lastGpsSend;
         if (smartPosition.hasTraveledOverThreshold &&
@@ -503,10 +512,55 @@ void PositionModule::handleNewPosition()
                       minimumTimeThreshold);
 
             // Set the current coords as our last ones, after we've compared distance with current and decided to send
-            lastGpsLatitude = node->position.latitude_i;
-            lastGpsLongitude = node->position.longitude_i;
+            rememberSentPosition(node->position);
         }
     }
 }
 
+/**
+ * Follow our velocity from fix to fix, smoothed a little so one jumpy fix doesn't change it much
+ */
+void PositionModule::updateMotion(const meshtastic_PositionLite &pos)
+{
+    uint32_t now = millis();
+    float secs = (now - motion.fixMs) / 1000.0f;
+    if (motion.fixMs && secs < 1)
+        return; // Too close together for a useful velocity
+
+    if (motion.fixMs && secs < 120) {
+        float meters, bearing;
+        GeoCoord::distanceAndBearing(motion.fixLatitude, motion.fixLongitude, pos.latitude_i, pos.longitude_i, &meters,
+                                     &bearing);
+        motion.east = (motion.east + meters * sinf(bearing) / secs) / 2;
+        motion.north = (motion.north + meters * cosf(bearing) / secs) / 2;
+    } else {
+        // First fix, or the last one is too old to say anything about now
+        motion.east = 0;
+        motion.north = 0;
+    }
+    motion.fixLatitude = pos.latitude_i;
+    motion.fixLongitude = pos.longitude_i;
+    motion.fixMs = now;
+}
+
+/**
+ * Note what we just broadcast, smart broadcast compares against it
+ */
+void PositionModule::rememberSentPosition(const meshtastic_PositionLite &pos)
+{
+    lastGpsLatitude = pos.latitude_i;
+    lastGpsLongitude = pos.longitude_i;
+
+    // Receivers can only extrapolate if our packets tell them how we move
+    const uint32_t velocityFlags =
+        meshtastic_Config_PositionConfig_PositionFlags_SPEED | meshtastic_Config_PositionConfig_PositionFlags_HEADING;
+    if (SMART_POSITION_DEAD_RECKONING && (config.position.position_flags & velocityFlags) == velocityFlags) {
+        motion.sentEast = motion.east;
+        motion.sentNorth = motion.north;
+    } else {
+        motion.sentEast = 0;
+        motion.sentNorth = 0;
+    }
+}
+
 #endif
\ No newline at end of file
@@ -3,6 +3,15 @@
 #include "ProtobufModule.h"
 #include "concurrency/OSThread.h"
 
+/**
+ * Smart broadcast by dead reckoning: once our packets carry speed and heading, a receiver can extrapolate where we are, so only
+ * broadcast when that guess is broadcast_smart_minimum_distance off, rather than whenever we moved that far.  A vehicle on a
+ * straight road then sends far fewer positions.  Off by default, as clients that don't extrapolate would show a stale position.
+ */
+#ifndef SMART_POSITION_DEAD_RECKONING
+#define SMART_POSITION_DEAD_RECKONING 0
+#endif
+
 /**
  * Position module for sending/receiving positions into the mesh
  */
@@ -21,6 +30,14 @@ class PositionModule : public ProtobufModule<meshtastic_Position>, private concu
     int32_t lastGpsLatitude = 0;
     int32_t lastGpsLongitude = 0;
 
+    // Our velocity worked out from recent fixes, for SMART_POSITION_DEAD_RECKONING
+    struct Motion {
+        int32_t fixLatitude = 0, fixLongitude = 0;
+        uint32_t fixMs = 0;
+        float east = 0, north = 0;         // m/s
+        float sentEast = 0, sentNorth = 0; // as of our last broadcast, what receivers extrapolate with
+    } motion;
+
     /// We force a rebroadcast if the radio settings change
     uint32_t currentGeneration = 0;
 
@@ -57,6 +74,8 @@ class PositionModule : public ProtobufModule<meshtastic_Position>, private concu
   private:
     meshtastic_MeshPacket *allocPositionPacket();
     struct SmartPosition getDistanceTraveledSinceLastSend(meshtastic_PositionLite currentPosition);
+    void updateMotion(const meshtastic_PositionLite &pos);
+    void rememberSentPosition(const meshtastic_PositionLite &pos);
     meshtastic_MeshPacket *allocAtakPli();
     void trySetRtc(meshtastic_Position p, bool isLocal, bool forceUpdate = false);
     uint32_t precision;
@@ -3,15 +3,45 @@
 #include "MeshService.h"
 #include "NodeDB.h"
 #include "PowerMon.h"
+#include "PowerStatus.h"
 #include "RTC.h"
+#include "RadioInterface.h"
 #include "Router.h"
 #include "configuration.h"
 #include "main.h"
 #include "sleep.h"
 #include "target_specific.h"
 #include <Throttle.h>
+#if !MESHTASTIC_EXCLUDE_GPS
+#include "GPS.h"
+#endif
 
 extern void printInfo();
+extern RadioInterface *rIf;
+
+typedef PowerStressModule::ProfileStep Step;
+#define OP(x) meshtastic_PowerStressMessage_Opcode_##x
+
+// Every profile starts from a quiet device, so each step measures what it adds
+#define QUIET_STEPS {OP(SCREEN_OFF), 0, true}, {OP(BT_OFF), 0, true}, {OP(GPS_OFF), 0, true}
+#define IDLE_RX_STEPS {OP(LORA_RX), 0, false}
+#define TX_SWEEP_STEPS {OP(LORA_TX), 2, false}, {OP(LORA_TX), 10, false}, {OP(LORA_TX), 17, false}, {OP(LORA_TX), 22, false}
+#define PERIPHERAL_STEPS {OP(BT_ON), 0, false}, {OP(SCREEN_ON), 0, false}, {OP(GPS_ON), 0, false}
+
+static const Step profileFull[] = {QUIET_STEPS, IDLE_RX_STEPS, TX_SWEEP_STEPS, PERIPHERAL_STEPS};
+static const Step profileIdleRx[] = {QUIET_STEPS, IDLE_RX_STEPS};
+static const Step profileTxSweep[] = {QUIET_STEPS, TX_SWEEP_STEPS};
+static const Step profilePeripherals[] = {QUIET_STEPS, PERIPHERAL_STEPS};
+
+static const struct {
+    const Step *steps;
+    uint8_t len;
+} profiles[] = {
+    {profileFull, sizeof(profileFull) / sizeof(Step)},               // POWERSTRESS_PROFILE_BASE + 0
+    {profileIdleRx, sizeof(profileIdleRx) / sizeof(Step)},           // + 1
+    {profileTxSweep, sizeof(profileTxSweep) / sizeof(Step)},         // + 2
+    {profilePeripherals, sizeof(profilePeripherals) / sizeof(Step)}, // + 3
+};
 
 PowerStressModule::PowerStressModule()
     : ProtobufModule("powerstress", meshtastic_PortNum_POWERSTRESS_APP, &meshtastic_PowerStressMessage_msg),
@@ -41,8 +71,10 @@ bool PowerStressModule::handleReceivedProtobuf(const meshtastic_MeshPacket &req,
             break;
 
         default:
-            if (currentMessage.cmd != meshtastic_PowerStressMessage_Opcode_UNSET)
+            if (currentMessage.cmd != meshtastic_PowerStressMessage_Opcode_UNSET || profile)
                 LOG_ERROR("PowerStress operation %d already in progress! Can't start new command", currentMessage.cmd);
+            else if (p.cmd >= POWERSTRESS_PROFILE_BASE)
+                startProfile(p.cmd - POWERSTRESS_PROFILE_BASE, p.num_seconds);
             else
                 currentMessage = p; // copy for use by thread (the message provided to us will be getting freed)
             break;
@@ -62,12 +94,19 @@ int32_t PowerStressModule::runOnce()
 
     auto &p = currentMessage;
 
+    if (isRunningCommand && txMs && Throttle::isWithinTimespanMs(txStartMs, txMs)) {
+        return sendTxPacket(); // LORA_TX still sending
+    }
+
     if (isRunningCommand) {
         // Done with the previous command - our sleep must have finished
         p.cmd = meshtastic_PowerStressMessage_Opcode_UNSET;
         p.num_seconds = 0;
         isRunningCommand = false;
+        txMs = 0;
         LOG_INFO("S:PS:%u", p.cmd);
+        if (profile)
+            nextProfileStep();
     } else {
         if (p.cmd != meshtastic_PowerStressMessage_Opcode_UNSET) {
             sleep_msec = (int32_t)(p.num_seconds * 1000);
@@ -84,25 +123,40 @@ int32_t PowerStressModule::runOnce()
                 ledForceOn.set(false);
                 break;
             case meshtastic_PowerStressMessage_Opcode_GPS_ON:
-                // FIXME - implement
+#if !MESHTASTIC_EXCLUDE_GPS
+                if (gps)
+                    gps->enable(); // searching until it has a fix
+#endif
                 break;
             case meshtastic_PowerStressMessage_Opcode_GPS_OFF:
-                // FIXME - implement
+#if !MESHTASTIC_EXCLUDE_GPS
+                if (gps)
+                    gps->disable();
+#endif
                 break;
             case meshtastic_PowerStressMessage_Opcode_LORA_OFF:
                 // FIXME - implement
                 break;
             case meshtastic_PowerStressMessage_Opcode_LORA_RX:
-                // FIXME - implement
+                // The radio listens whenever it isn't sending, nothing to do
                 break;
             case meshtastic_PowerStressMessage_Opcode_LORA_TX:
-                // FIXME - implement
+                txStartMs = millis();
+                txMs = sleep_msec;
+                if (txMs)
+                    sleep_msec = sendTxPacket();
                 break;
             case meshtastic_PowerStressMessage_Opcode_SCREEN_OFF:
-                // FIXME - implement
+#if HAS_SCREEN
+                if (screen)
+                    screen->setOn(false);
+#endif
                 break;
             case meshtastic_PowerStressMessage_Opcode_SCREEN_ON:
-                // FIXME - implement
+#if HAS_SCREEN
+                if (screen)
+                    screen->setOn(true);
+#endif
                 break;
             case meshtastic_PowerStressMessage_Opcode_BT_OFF:
                 setBluetoothEnable(false);
@@ -131,4 +185,81 @@ int32_t PowerStressModule::runOnce()
         }
     }
     return sleep_msec;
-}
\ No newline at end of file
+}
+
+void PowerStressModule::startProfile(uint8_t num, float stepSecs)
+{
+    if (num >= sizeof(profiles) / sizeof(profiles[0])) {
+        LOG_ERROR("PowerStress profile %u unknown", num);
+        return;
+    }
+    profile = profiles[num].steps;
+    profileLen = profiles[num].len;
+    profileNum = num;
+    profileStepSecs = stepSecs > 0 ? stepSecs : POWERSTRESS_PROFILE_STEP_SECS;
+    savedTxPower = config.lora.tx_power;
+    batteryMvAtStart = powerStatus->getBatteryVoltageMv();
+    powerMon->force_enabled = true;
+    LOG_INFO("PowerStress profile %u: %u steps of %u s", num, profileLen, (uint32_t)profileStepSecs);
+
+    // The first step is loaded like any later one, as if a step had just finished
+    profileStep = (uint8_t)-1;
+    nextProfileStep();
+}
+
+void PowerStressModule::nextProfileStep()
+{
+    char label[12];
+    if (profileStep < profileLen && !profile[profileStep].setup) {
+        snprintf(label, sizeof(label), "%u.%u", profileNum, profileStep);
+        powerMon->logDwell(label);
+    }
+
+    profileStep++;
+    if (profileStep >= profileLen) {
+        LOG_INFO("S:PB:%d,%d", batteryMvAtStart, powerStatus->getBatteryVoltageMv()); // battery mV before, after
+        profile = NULL;
+
+        // Back to how the device is configured
+        if (config.lora.tx_power != savedTxPower) {
+            config.lora.tx_power = savedTxPower;
+            service->configChanged.notifyObservers(NULL);
+        }
+        setBluetoothEnable(config.bluetooth.enabled);
+#if HAS_SCREEN
+        if (screen)
+            screen->setOn(true);
+#endif
+#if !MESHTASTIC_EXCLUDE_GPS
+        if (gps && config.position.gps_mode == meshtastic_Config_PositionConfig_GpsMode_ENABLED)
+            gps->enable();
+#endif
+        return;
+    }
+
+    const ProfileStep &step = profile[profileStep];
+    int8_t txPower = step.txPower ? step.txPower : savedTxPower;
+    if (config.lora.tx_power != txPower) {
+        config.lora.tx_power = txPower; // not saved, put back when the profile ends
+        service->configChanged.notifyObservers(NULL);
+    }
+    LOG_INFO("S:PP:%u,%u,%d", profileNum, profileStep, txPower); // profile, step, tx power
+    currentMessage.cmd = step.cmd;
+    currentMessage.num_seconds = step.setup ? 0.1f : profileStepSecs; // a command of 0 s would never finish
+    if (!step.setup)
+        powerMon->startDwell();
+}
+
+int32_t PowerStressModule::sendTxPacket()
+{
+    meshtastic_MeshPacket *p = allocDataPacket();
+    p->to = NODENUM_BROADCAST;
+    p->hop_limit = 0; // nobody should repeat our noise
+    p->priority = meshtastic_MeshPacket_Priority_BACKGROUND;
+    p->decoded.payload.size = meshtastic_Constants_DATA_PAYLOAD_LEN;
+    memset(p->decoded.payload.bytes, 0, p->decoded.payload.size);
+    service->sendToMesh(p);
+
+    // Back to back, allowing for the radio's own random backoff before each send
+    return rIf ? rIf->getPacketTime((uint32_t)MAX_LORA_PAYLOAD_LEN) : 1000;
+}
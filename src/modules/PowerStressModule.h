@@ -3,14 +3,52 @@
 #include "concurrency/OSThread.h"
 #include "mesh/generated/meshtastic/powermon.pb.h"
 
+/// Opcodes from here up run built-in energy benchmark profile (opcode - POWERSTRESS_PROFILE_BASE), see PowerStressModule.cpp
+#define POWERSTRESS_PROFILE_BASE 0xC0
+
+/// How long each step of a profile lasts if the command's num_seconds doesn't say
+#ifndef POWERSTRESS_PROFILE_STEP_SECS
+#define POWERSTRESS_PROFILE_STEP_SECS 60
+#endif
+
 /**
  * A module that provides easy low-level remote access to device hardware.
+ *
+ * Besides single commands it runs energy benchmark profiles: a script of commands (quiet the device, idle RX, TX at each power
+ * level, BLE on, screen on, GPS searching), each step held for num_seconds.  Each step starts with an S:PP:profile,step,txPower
+ * log marker just before the usual S:PS one, so a meter's trace lines up with the steps, and ends with PowerMon's dwell time
+ * and estimated charge of each state during it (S:PD lines, see PowerMon::logDwell()).  The battery voltage before and after
+ * the whole profile is logged as S:PB.
  */
 class PowerStressModule : public ProtobufModule<meshtastic_PowerStressMessage>, private concurrency::OSThread
 {
+  public:
+    struct ProfileStep {
+        meshtastic_PowerStressMessage_Opcode cmd;
+        int8_t txPower; // dBm for LORA_TX, 0 for the configured power
+        bool setup;     // done on the way to the next step rather than held and measured
+    };
+
+  private:
     meshtastic_PowerStressMessage currentMessage = meshtastic_PowerStressMessage_init_default;
     bool isRunningCommand = false;
 
+    const ProfileStep *profile = NULL; // the profile being run, if any
+    uint8_t profileNum = 0, profileLen = 0, profileStep = 0;
+    float profileStepSecs = 0;
+    int8_t savedTxPower = 0;
+    int batteryMvAtStart = 0;
+    uint32_t txStartMs = 0, txMs = 0; // LORA_TX keeps sending until txMs have passed
+
+    void startProfile(uint8_t num, float stepSecs);
+
+    /// Load the next step into currentMessage, or finish the profile
+    void nextProfileStep();
+
+    /// Queue one full size packet for LORA_TX
+    /// @return how long until the next one
+    int32_t sendTxPacket();
+
   public:
     /** Constructor
      * name is for debugging output
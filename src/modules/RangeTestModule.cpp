@@ -19,8 +19,10 @@
 #include "airtime.h"
 #include "configuration.h"
 #include "gps/GeoCoord.h"
+#include "sleep.h"
 #include <Arduino.h>
 #include <Throttle.h>
+#include <stdarg.h>
 
 RangeTestModule *rangeTestModule;
 RangeTestModuleRadio *rangeTestModuleRadio;
@@ -100,6 +102,21 @@ int32_t RangeTestModule::runOnce()
     return disable();
 }
 
+RangeTestModuleRadio::RangeTestModuleRadio()
+    : SinglePortModule("RangeTestModuleRadio", meshtastic_PortNum_RANGE_TEST_APP), concurrency::OSThread("RangeTestLog")
+{
+    loopbackOk = true; // Allow locally generated messages to loop back to the client
+    rebootObserver.observe(&notifyReboot);
+    deepSleepObserver.observe(&notifyDeepSleep);
+    disable(); // Nothing to write until a row is buffered
+}
+
+int32_t RangeTestModuleRadio::runOnce()
+{
+    flushFile();
+    return disable();
+}
+
 /**
  * Sends a payload to a specified destination node.
  *
@@ -179,74 +196,29 @@ ProcessMessage RangeTestModuleRadio::handleReceived(const meshtastic_MeshPacket
     return ProcessMessage::CONTINUE; // Let others look at this message also if they want
 }
 
+#ifdef ARCH_ESP32
+/// printf to the end of a row, truncating it if it's full
+static void appendRow(char *row, size_t size, size_t &len, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(row + len, size - len, format, args);
+    va_end(args);
+    if (written > 0)
+        len = std::min(len + written, size - 1);
+}
+#endif
+
 bool RangeTestModuleRadio::appendFile(const meshtastic_MeshPacket &mp)
 {
 #ifdef ARCH_ESP32
     auto &p = mp.decoded;
 
     meshtastic_NodeInfoLite *n = nodeDB->getMeshNode(getFrom(&mp));
-    /*
-        LOG_DEBUG("-----------------------------------------");
-        LOG_DEBUG("p.payload.bytes  \"%s\"", p.payload.bytes);
-        LOG_DEBUG("p.payload.size   %d", p.payload.size);
-        LOG_DEBUG("---- Received Packet:");
-        LOG_DEBUG("mp.from          %d", mp.from);
-        LOG_DEBUG("mp.rx_snr        %f", mp.rx_snr);
-        LOG_DEBUG("mp.hop_limit     %d", mp.hop_limit);
-        LOG_DEBUG("---- Node Information of Received Packet (mp.from):");
-        LOG_DEBUG("n->user.long_name         %s", n->user.long_name);
-        LOG_DEBUG("n->user.short_name        %s", n->user.short_name);
-        LOG_DEBUG("n->has_position           %d", n->has_position);
-        LOG_DEBUG("n->position.latitude_i    %d", n->position.latitude_i);
-        LOG_DEBUG("n->position.longitude_i   %d", n->position.longitude_i);
-        LOG_DEBUG("---- Current device location information:");
-        LOG_DEBUG("gpsStatus->getLatitude()     %d", gpsStatus->getLatitude());
-        LOG_DEBUG("gpsStatus->getLongitude()    %d", gpsStatus->getLongitude());
-        LOG_DEBUG("gpsStatus->getHasLock()      %d", gpsStatus->getHasLock());
-        LOG_DEBUG("gpsStatus->getDOP()          %d", gpsStatus->getDOP());
-        LOG_DEBUG("-----------------------------------------");
-    */
-    concurrency::LockGuard g(spiLock);
-    if (!FSBegin()) {
-        LOG_DEBUG("An Error has occurred while mounting the filesystem");
-        return 0;
-    }
 
-    if (FSCom.totalBytes() - FSCom.usedBytes() < 51200) {
-        LOG_DEBUG("Filesystem doesn't have enough free space. Aborting write");
-        return 0;
-    }
-
-    FSCom.mkdir("/static");
-
-    // If the file doesn't exist, write the header.
-    if (!FSCom.exists("/static/rangetest.csv")) {
-        //--------- Write to file
-        File fileToWrite = FSCom.open("/static/rangetest.csv", FILE_WRITE);
-
-        if (!fileToWrite) {
-            LOG_ERROR("There was an error opening the file for writing");
-            return 0;
-        }
-
-        // Print the CSV header
-        if (fileToWrite.println(
-                "time,from,sender name,sender lat,sender long,rx lat,rx long,rx elevation,rx snr,distance,hop limit,payload")) {
-            LOG_INFO("File was written");
-        } else {
-            LOG_ERROR("File write failed");
-        }
-        fileToWrite.flush();
-        fileToWrite.close();
-    }
-
-    //--------- Append content to file
-    File fileToAppend = FSCom.open("/static/rangetest.csv", FILE_APPEND);
-
-    if (!fileToAppend) {
-        LOG_ERROR("There was an error opening the file for appending");
-        return 0;
-    }
+    // Longest row: the fixed columns, a full long name and a full payload
+    char row[meshtastic_Constants_DATA_PAYLOAD_LEN + 192];
+    size_t len = 0;
 
     struct timeval tv;
     if (!gettimeofday(&tv, NULL)) {
@@ -258,44 +230,102 @@ bool RangeTestModuleRadio::appendFile(const meshtastic_MeshPacket &mp)
         int min = (hms % SEC_PER_HOUR) / SEC_PER_MIN;
         int sec = (hms % SEC_PER_HOUR) % SEC_PER_MIN; // or hms % SEC_PER_MIN
 
-        fileToAppend.printf("%02d:%02d:%02d,", hour, min, sec); // Time
+        appendRow(row, sizeof(row), len, "%02d:%02d:%02d,", hour, min, sec); // Time
     } else {
-        fileToAppend.printf("??:??:??,"); // Time
+        appendRow(row, sizeof(row), len, "??:??:??,"); // Time
     }
 
-    fileToAppend.printf("%d,", getFrom(&mp));                   // From
-    fileToAppend.printf("%s,", n->user.long_name);              // Long Name
-    fileToAppend.printf("%f,", n->position.latitude_i * 1e-7);  // Sender Lat
-    fileToAppend.printf("%f,", n->position.longitude_i * 1e-7); // Sender Long
+    appendRow(row, sizeof(row), len, "%d,", getFrom(&mp));                   // From
+    appendRow(row, sizeof(row), len, "%s,", n->user.long_name);              // Long Name
+    appendRow(row, sizeof(row), len, "%f,", n->position.latitude_i * 1e-7);  // Sender Lat
+    appendRow(row, sizeof(row), len, "%f,", n->position.longitude_i * 1e-7); // Sender Long
     if (gpsStatus->getIsConnected() || config.position.fixed_position) {
-        fileToAppend.printf("%f,", gpsStatus->getLatitude() * 1e-7);  // RX Lat
-        fileToAppend.printf("%f,", gpsStatus->getLongitude() * 1e-7); // RX Long
-        fileToAppend.printf("%d,", gpsStatus->getAltitude());         // RX Altitude
+        appendRow(row, sizeof(row), len, "%f,", gpsStatus->getLatitude() * 1e-7);  // RX Lat
+        appendRow(row, sizeof(row), len, "%f,", gpsStatus->getLongitude() * 1e-7); // RX Long
+        appendRow(row, sizeof(row), len, "%d,", gpsStatus->getAltitude());         // RX Altitude
     } else {
         // When the phone API is in use, the node info will be updated with position
         meshtastic_NodeInfoLite *us = nodeDB->getMeshNode(nodeDB->getNodeNum());
-        fileToAppend.printf("%f,", us->position.latitude_i * 1e-7);  // RX Lat
-        fileToAppend.printf("%f,", us->position.longitude_i * 1e-7); // RX Long
-        fileToAppend.printf("%d,", us->position.altitude);           // RX Altitude
+        appendRow(row, sizeof(row), len, "%f,", us->position.latitude_i * 1e-7);  // RX Lat
+        appendRow(row, sizeof(row), len, "%f,", us->position.longitude_i * 1e-7); // RX Long
+        appendRow(row, sizeof(row), len, "%d,", us->position.altitude);           // RX Altitude
     }
 
-    fileToAppend.printf("%f,", mp.rx_snr); // RX SNR
+    appendRow(row, sizeof(row), len, "%f,", mp.rx_snr); // RX SNR
 
     if (n->position.latitude_i && n->position.longitude_i && gpsStatus->getLatitude() && gpsStatus->getLongitude()) {
         float distance = GeoCoord::latLongToMeter(n->position.latitude_i * 1e-7, n->position.longitude_i * 1e-7,
                                                   gpsStatus->getLatitude() * 1e-7, gpsStatus->getLongitude() * 1e-7);
-        fileToAppend.printf("%f,", distance); // Distance in meters
+        appendRow(row, sizeof(row), len, "%f,", distance); // Distance in meters
     } else {
-        fileToAppend.printf("0,");
+        appendRow(row, sizeof(row), len, "0,");
     }
 
-    fileToAppend.printf("%d,", mp.hop_limit); // Packet Hop Limit
+    appendRow(row, sizeof(row), len, "%d,", mp.hop_limit); // Packet Hop Limit
 
     // TODO: If quotes are found in the payload, it has to be escaped.
-    fileToAppend.printf("\"%s\"\n", p.payload.bytes);
+    appendRow(row, sizeof(row), len, "\"%.*s\"\n", p.payload.size, p.payload.bytes);
+
+    if (logLength + len > sizeof(logBuffer))
+        flushFile();
+    memcpy(logBuffer + logLength, row, len);
+    logLength += len;
+
+    // Start the timer with the first row, later ones don't put the write off
+    if (logLength == len) {
+        enabled = true;
+        setIntervalFromNow(RANGE_TEST_FLUSH_MS);
+    }
+#endif
+
+    return 1;
+}
+
+bool RangeTestModuleRadio::flushFile()
+{
+#ifdef ARCH_ESP32
+    if (!logLength)
+        return 1;
+
+    concurrency::LockGuard g(fsLock);
+    // The rows are dropped if they can't be written, keeping them would only fill the buffer
+    size_t length = logLength;
+    logLength = 0;
+
+    if (!FSBegin()) {
+        LOG_DEBUG("An Error has occurred while mounting the filesystem");
+        return 0;
+    }
+
+    if (FSCom.totalBytes() - FSCom.usedBytes() < 51200) {
+        LOG_DEBUG("Filesystem doesn't have enough free space. Aborting write");
+        return 0;
+    }
+
+    FSCom.mkdir("/static");
+
+    // If the file doesn't exist, write the header.
+    bool isNew = !FSCom.exists("/static/rangetest.csv");
+
+    //--------- Append content to file
+    File fileToAppend = FSCom.open("/static/rangetest.csv", isNew ? FILE_WRITE : FILE_APPEND);
+
+    if (!fileToAppend) {
+        LOG_ERROR("There was an error opening the file for appending");
+        return 0;
+    }
+
+    // Print the CSV header
+    if (isNew)
+        fileToAppend.println(
+            "time,from,sender name,sender lat,sender long,rx lat,rx long,rx elevation,rx snr,distance,hop limit,payload");
+
+    if (fileToAppend.write((const uint8_t *)logBuffer, length) != length)
+        LOG_ERROR("File write failed");
     fileToAppend.flush();
     fileToAppend.close();
+    invalidateFileManifest();
 #endif
 
     return 1;
-}
\ No newline at end of file
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Observer.h"
 #include "SinglePortModule.h"
 #include "concurrency/OSThread.h"
 #include "configuration.h"
@@ -20,19 +21,27 @@ class RangeTestModule : private concurrency::OSThread
 
 extern RangeTestModule *rangeTestModule;
 
+/// Received rows are held in RAM and appended to rangetest.csv when this much is waiting, or RANGE_TEST_FLUSH_MS after the first
+#ifndef RANGE_TEST_LOG_BUFFER
+#define RANGE_TEST_LOG_BUFFER 1024
+#endif
+#ifndef RANGE_TEST_FLUSH_MS
+#define RANGE_TEST_FLUSH_MS (30 * 1000)
+#endif
+
 /*
  * Radio interface for RangeTestModule
  *
  */
-class RangeTestModuleRadio : public SinglePortModule
+class RangeTestModuleRadio : public SinglePortModule, private concurrency::OSThread
 {
     uint32_t lastRxID = 0;
 
+    char logBuffer[RANGE_TEST_LOG_BUFFER]; // CSV rows not yet in the file
+    size_t logLength = 0;
+
   public:
-    RangeTestModuleRadio() : SinglePortModule("RangeTestModuleRadio", meshtastic_PortNum_RANGE_TEST_APP)
-    {
-        loopbackOk = true; // Allow locally generated messages to loop back to the client
-    }
+    RangeTestModuleRadio();
 
     /**
      * Send our payload into the mesh
@@ -41,9 +50,13 @@ class RangeTestModuleRadio : public SinglePortModule
 
     /**
      * Append range test data to the file on the Filesystem
+     * The row is buffered, flushFile() writes it
      */
     bool appendFile(const meshtastic_MeshPacket &mp);
 
+    /// Write the buffered rows to the file
+    bool flushFile();
+
   protected:
     /** Called to handle a particular incoming message
 
@@ -51,6 +64,20 @@ class RangeTestModuleRadio : public SinglePortModule
     it
     */
     virtual ProcessMessage handleReceived(const meshtastic_MeshPacket &mp) override;
+
+    virtual int32_t runOnce() override;
+
+  private:
+    // Rows still buffered are written before we reboot or sleep
+    int onShutdown(void *unused)
+    {
+        flushFile();
+        return 0;
+    }
+    CallbackObserver<RangeTestModuleRadio, void *> rebootObserver =
+        CallbackObserver<RangeTestModuleRadio, void *>(this, &RangeTestModuleRadio::onShutdown);
+    CallbackObserver<RangeTestModuleRadio, void *> deepSleepObserver =
+        CallbackObserver<RangeTestModuleRadio, void *>(this, &RangeTestModuleRadio::onShutdown);
 };
 
 extern RangeTestModuleRadio *rangeTestModuleRadio;
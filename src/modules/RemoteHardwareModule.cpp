@@ -6,6 +6,9 @@
 #include "configuration.h"
 #include "main.h"
 #include <Throttle.h>
+#if REMOTE_HARDWARE_INTERRUPTS && defined(ARCH_ESP32)
+#include "sleep.h"
+#endif
 
 #define NUM_GPIOS 64
 
@@ -15,6 +18,11 @@
 // a max of one change per 30 seconds
 #define WATCH_INTERVAL_MSEC (30 * 1000)
 
+// With interrupts: a change is only read once the pins have been quiet this long, so a bouncing contact is read once
+#define WATCH_DEBOUNCE_MSEC 20
+// and in case an edge got lost, the pins are still read this often
+#define WATCH_IDLE_POLL_MSEC (5 * 60 * 1000)
+
 // Tests for access to read from or write to a specified GPIO pin
 static bool pinAccessAllowed(uint64_t mask, uint8_t pin)
 {
@@ -44,11 +52,13 @@ static void pinModes(uint64_t mask, uint8_t mode, uint64_t maskAvailable)
 }
 
 /// Read all the pins mentioned in a mask
-static uint64_t digitalReads(uint64_t mask, uint64_t maskAvailable)
+/// @param setModes make them inputs first, not needed (and best avoided) for pins already set up for watching
+static uint64_t digitalReads(uint64_t mask, uint64_t maskAvailable, bool setModes = true)
 {
     uint64_t res = 0;
 
-    pinModes(mask, INPUT_PULLUP, maskAvailable);
+    if (setModes)
+        pinModes(mask, INPUT_PULLUP, maskAvailable);
 
     for (uint64_t i = 0; i < NUM_GPIOS; i++) {
         uint64_t m = 1ULL << i;
@@ -115,6 +125,9 @@ bool RemoteHardwareModule::handleReceivedProtobuf(const meshtastic_MeshPacket &r
                 ~watchGpios;   // generate a 'previous' value which is guaranteed to not match (to force an initial publish)
             enabled = true;    // Let our thread run at least once
             setInterval(2000); // Set a new interval so we'll run soon
+#if REMOTE_HARDWARE_INTERRUPTS
+            attachWatchInterrupts();
+#endif
             LOG_INFO("Now watching GPIOs 0x%llx", watchGpios);
             break;
         }
@@ -135,6 +148,35 @@ bool RemoteHardwareModule::handleReceivedProtobuf(const meshtastic_MeshPacket &r
 int32_t RemoteHardwareModule::runOnce()
 {
     if (moduleConfig.remote_hardware.enabled && watchGpios) {
+#if REMOTE_HARDWARE_INTERRUPTS
+        if (interruptGpios) {
+            // Nothing to do until a pin changes, the throttle allows sending it and the pins have settled
+            uint32_t sinceChange = millis() - lastChangeMsec;
+            uint32_t sinceWatch = millis() - lastWatchMsec;
+            bool due = changePending || lastWatchMsec == 0 || sinceWatch >= WATCH_IDLE_POLL_MSEC;
+            if (!due)
+                return WATCH_IDLE_POLL_MSEC - sinceWatch;
+            if (lastWatchMsec != 0 && sinceWatch < WATCH_INTERVAL_MSEC)
+                return WATCH_INTERVAL_MSEC - sinceWatch; // changes meanwhile are sent as one, with the newest values
+            if (changePending && sinceChange < WATCH_DEBOUNCE_MSEC)
+                return WATCH_DEBOUNCE_MSEC - sinceChange;
+
+            changePending = false; // before reading, an edge during the read makes us read again
+            uint64_t curVal = digitalReads(watchGpios, availablePins, false);
+            lastWatchMsec = millis();
+            if (curVal != previousWatch) {
+                previousWatch = curVal;
+                LOG_INFO("Broadcast GPIOS 0x%llx changed!", curVal);
+
+                meshtastic_HardwareMessage r = meshtastic_HardwareMessage_init_default;
+                r.type = meshtastic_HardwareMessage_Type_GPIOS_CHANGED;
+                r.gpio_value = curVal;
+                meshtastic_MeshPacket *p = allocDataProtobuf(r);
+                service->sendToMesh(p);
+            }
+            return changePending ? WATCH_INTERVAL_MSEC : WATCH_IDLE_POLL_MSEC;
+        }
+#endif
 
         if (!Throttle::isWithinTimespanMs(lastWatchMsec, WATCH_INTERVAL_MSEC)) {
             uint64_t curVal = digitalReads(watchGpios, availablePins);
@@ -154,8 +196,94 @@ int32_t RemoteHardwareModule::runOnce()
         }
     } else {
         // No longer watching anything - stop using CPU
+#if REMOTE_HARDWARE_INTERRUPTS
+        detachWatchInterrupts();
+#endif
         return disable();
     }
 
     return 2000; // Poll our GPIOs every 2000ms
-}
\ No newline at end of file
+}
+
+#if REMOTE_HARDWARE_INTERRUPTS
+RemoteHardwareModule *RemoteHardwareModule::watcher;
+
+IRAM_ATTR void RemoteHardwareModule::onPinChange()
+{
+    RemoteHardwareModule *w = watcher;
+    if (!w)
+        return;
+    w->lastChangeMsec = millis();
+    w->changePending = true;
+    w->setInterval(0); // runOnce() holds off until the throttle and debounce allow
+    runASAP = true;
+
+    BaseType_t higherWake = 0;
+    concurrency::mainDelay.interruptFromISR(&higherWake);
+}
+
+void RemoteHardwareModule::attachWatchInterrupts()
+{
+    detachWatchInterrupts();
+    pinModes(watchGpios, INPUT_PULLUP, availablePins);
+    for (uint8_t i = 0; i < NUM_GPIOS; i++) {
+        if ((watchGpios & (1ULL << i)) && pinAccessAllowed(availablePins, i)) {
+            attachInterrupt(digitalPinToInterrupt(i), onPinChange, CHANGE);
+            interruptGpios |= 1ULL << i;
+        }
+    }
+    if (!interruptGpios)
+        return;
+    watcher = this;
+#ifdef ARCH_ESP32
+    lsObserver.observe(&notifyLightSleep);
+    lsEndObserver.observe(&notifyLightSleepEnd);
+#endif
+}
+
+void RemoteHardwareModule::detachWatchInterrupts()
+{
+    for (uint8_t i = 0; i < NUM_GPIOS; i++)
+        if (interruptGpios & (1ULL << i))
+            detachInterrupt(digitalPinToInterrupt(i));
+    interruptGpios = 0;
+    changePending = false;
+#ifdef ARCH_ESP32
+    lsObserver.unobserve(&notifyLightSleep);
+    lsEndObserver.unobserve(&notifyLightSleepEnd);
+#endif
+}
+
+#ifdef ARCH_ESP32
+int RemoteHardwareModule::beforeLightSleep(void *unused)
+{
+    // Wake when a pin leaves the level it has now
+    uint64_t levels = digitalReads(interruptGpios, availablePins, false);
+    for (uint8_t i = 0; i < NUM_GPIOS; i++) {
+        uint64_t m = 1ULL << i;
+        if (interruptGpios & m)
+            gpio_wakeup_enable((gpio_num_t)i, (levels & m) ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+    }
+    wakeGpios = interruptGpios;
+    return 0;
+}
+
+int RemoteHardwareModule::afterLightSleep(esp_sleep_wakeup_cause_t cause)
+{
+    for (uint8_t i = 0; i < NUM_GPIOS; i++) {
+        if (wakeGpios & (1ULL << i)) {
+            gpio_wakeup_disable((gpio_num_t)i);
+            attachInterrupt(digitalPinToInterrupt(i), onPinChange, CHANGE);
+        }
+    }
+    wakeGpios = 0;
+    // A pin may have changed while its interrupt was off
+    if (cause == ESP_SLEEP_WAKEUP_GPIO) {
+        lastChangeMsec = millis();
+        changePending = true;
+        setIntervalFromNow(0);
+    }
+    return 0;
+}
+#endif
+#endif
@@ -3,6 +3,17 @@
 #include "concurrency/OSThread.h"
 #include "mesh/generated/meshtastic/remote_hardware.pb.h"
 
+/// Watch GPIOs with pin change interrupts instead of reading them every 2 seconds, so a change is seen right away and the
+/// device can sleep in between
+#ifndef REMOTE_HARDWARE_INTERRUPTS
+#define REMOTE_HARDWARE_INTERRUPTS 0
+#endif
+
+#if REMOTE_HARDWARE_INTERRUPTS && defined(ARCH_ESP32)
+#include "Observer.h"
+#include <esp_sleep.h>
+#endif
+
 /**
  * A module that provides easy low-level remote access to device hardware.
  */
@@ -20,6 +31,32 @@ class RemoteHardwareModule : public ProtobufModule<meshtastic_HardwareMessage>,
     /// A bitmask of GPIOs that are exposed to the mesh if undefined access is not enabled
     uint64_t availablePins = 0;
 
+#if REMOTE_HARDWARE_INTERRUPTS
+    /// The watched pins we attached our interrupt to
+    uint64_t interruptGpios = 0;
+
+    /// Set by the interrupt, cleared when we read the pins
+    volatile bool changePending = false;
+    volatile uint32_t lastChangeMsec = 0;
+
+    static RemoteHardwareModule *watcher; // For the ISR
+    static void onPinChange();
+
+    void attachWatchInterrupts();
+    void detachWatchInterrupts();
+
+#ifdef ARCH_ESP32
+    // Light sleep reprograms the GPIO interrupts, and we want any watched pin leaving its level to wake us
+    int beforeLightSleep(void *unused);
+    int afterLightSleep(esp_sleep_wakeup_cause_t cause);
+    CallbackObserver<RemoteHardwareModule, void *> lsObserver =
+        CallbackObserver<RemoteHardwareModule, void *>(this, &RemoteHardwareModule::beforeLightSleep);
+    CallbackObserver<RemoteHardwareModule, esp_sleep_wakeup_cause_t> lsEndObserver =
+        CallbackObserver<RemoteHardwareModule, esp_sleep_wakeup_cause_t>(this, &RemoteHardwareModule::afterLightSleep);
+    uint64_t wakeGpios = 0; // Pins enabled as light sleep wake sources
+#endif
+#endif
+
   public:
     /** Constructor
      * name is for debugging output
@@ -34,6 +34,7 @@ class RoutingModule : public ProtobufModule<meshtastic_Routing>
 
     /// Override wantPacket to say we want to see all packets, not just those for our port number
     virtual bool wantPacket(const meshtastic_MeshPacket *p) override { return true; }
+    virtual int dispatchPortNum() const override { return MESHMODULE_ANY_PORT; }
 };
 
 extern RoutingModule *routingModule;
\ No newline at end of file
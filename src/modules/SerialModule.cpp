@@ -49,7 +49,12 @@
 #if (defined(ARCH_ESP32) || defined(ARCH_NRF52) || defined(ARCH_RP2040)) && !defined(CONFIG_IDF_TARGET_ESP32S2) &&               \
     !defined(CONFIG_IDF_TARGET_ESP32C3)
 
-#define RX_BUFFER 256
+#define RX_BUFFER 256      // Smallest receive buffer
+#define RX_BUFFER_MAX 4096 // Largest, for high baud rates
+// The receive buffer holds at least this long of data at the configured baud rate, so bytes survive a busy main loop
+#ifndef SERIAL_MODULE_RX_BUFFER_MSEC
+#define SERIAL_MODULE_RX_BUFFER_MSEC 100
+#endif
 #define TIMEOUT 250
 #define BAUD 38400
 #define ACK 1
@@ -74,6 +79,24 @@ static Print *serialPrint = &Serial2;
 char serialBytes[512];
 size_t serialPayloadSize;
 
+/// Size of the receive buffer for baud, which the UART driver fills from its interrupt (or DMA) while we are busy elsewhere
+static size_t rxBufferSizeFor(uint32_t baud)
+{
+    size_t bytes = (uint64_t)baud / 10 * SERIAL_MODULE_RX_BUFFER_MSEC / 1000; // 10 bits a byte with start and stop bits
+    return bytes < RX_BUFFER ? RX_BUFFER : bytes > RX_BUFFER_MAX ? RX_BUFFER_MAX : bytes;
+}
+
+#ifdef ARCH_ESP32
+static volatile uint32_t rxDriverOverflows = 0;
+
+// Called from the UART driver's event task
+static void onRxError(hardwareSerial_error_t error)
+{
+    if (error == UART_BUFFER_FULL_ERROR || error == UART_FIFO_OVF_ERROR)
+        rxDriverOverflows++;
+}
+#endif
+
 SerialModuleRadio::SerialModuleRadio() : MeshModule("SerialModuleRadio")
 {
     switch (moduleConfig.serial.mode) {
@@ -128,6 +151,7 @@ int32_t SerialModule::runOnce()
             LOG_INFO("Init serial peripheral interface");
 
             uint32_t baud = getBaudRate();
+            rxBufferBytes = rxBufferSizeFor(baud);
 
             if (moduleConfig.serial.override_console_serial_port) {
 #ifdef RP2040_SLOW_CLOCK
@@ -142,8 +166,9 @@ int32_t SerialModule::runOnce()
             }
 #if defined(CONFIG_IDF_TARGET_ESP32C6)
             if (moduleConfig.serial.rxd && moduleConfig.serial.txd) {
-                Serial1.setRxBufferSize(RX_BUFFER);
+                Serial1.setRxBufferSize(rxBufferBytes);
                 Serial1.begin(baud, SERIAL_8N1, moduleConfig.serial.rxd, moduleConfig.serial.txd);
+                Serial1.onReceiveError(onRxError);
             } else {
                 Serial.begin(baud);
                 Serial.setTimeout(moduleConfig.serial.timeout > 0 ? moduleConfig.serial.timeout : TIMEOUT);
@@ -152,8 +177,9 @@ int32_t SerialModule::runOnce()
 #elif defined(ARCH_ESP32)
 
             if (moduleConfig.serial.rxd && moduleConfig.serial.txd) {
-                Serial2.setRxBufferSize(RX_BUFFER);
+                Serial2.setRxBufferSize(rxBufferBytes);
                 Serial2.begin(baud, SERIAL_8N1, moduleConfig.serial.rxd, moduleConfig.serial.txd);
+                Serial2.onReceiveError(onRxError);
             } else {
                 Serial.begin(baud);
                 Serial.setTimeout(moduleConfig.serial.timeout > 0 ? moduleConfig.serial.timeout : TIMEOUT);
@@ -161,7 +187,7 @@ int32_t SerialModule::runOnce()
 #elif !defined(TTGO_T_ECHO) && !defined(CANARYONE) && !defined(MESHLINK) && !defined(ELECROW_ThinkNode_M1)
             if (moduleConfig.serial.rxd && moduleConfig.serial.txd) {
 #ifdef ARCH_RP2040
-                Serial2.setFIFOSize(RX_BUFFER);
+                Serial2.setFIFOSize(rxBufferBytes);
                 Serial2.setPinout(moduleConfig.serial.txd, moduleConfig.serial.rxd);
 #else
                 Serial2.setPins(moduleConfig.serial.rxd, moduleConfig.serial.txd);
@@ -183,6 +209,10 @@ int32_t SerialModule::runOnce()
 #endif
             serialModuleRadio = new SerialModuleRadio();
 
+#if defined(ARCH_NRF52) && defined(SERIAL_BUFFER_SIZE)
+            rxBufferBytes = SERIAL_BUFFER_SIZE; // Fixed by the core
+#endif
+            LOG_INFO("Serial module at %u baud, %u byte receive buffer", baud, (unsigned)rxBufferBytes);
             firstTime = 0;
 
             // in API mode send rebooted sequence
@@ -190,6 +220,7 @@ int32_t SerialModule::runOnce()
                 emitRebooted();
             }
         } else {
+            checkRxOverflow();
             if (moduleConfig.serial.mode == meshtastic_ModuleConfig_SerialConfig_Serial_Mode_PROTO) {
                 return runOncePart();
             } else if ((moduleConfig.serial.mode == meshtastic_ModuleConfig_SerialConfig_Serial_Mode_NMEA) && HAS_GPS) {
@@ -237,6 +268,26 @@ int32_t SerialModule::runOnce()
     }
 }
 
+/**
+ * Count the times received bytes were lost because the receive buffer was full, and warn about it now and then.
+ * ESP32's UART driver tells us, elsewhere a buffer found full when we come to read it has most likely overflowed.
+ */
+void SerialModule::checkRxOverflow()
+{
+#ifdef ARCH_ESP32
+    uint32_t overflows = rxDriverOverflows;
+#else
+    if (stream->available() >= (int)rxBufferBytes - 1)
+        rxFullSeen++;
+    uint32_t overflows = rxFullSeen;
+#endif
+    if (overflows != rxOverflowsLogged && !Throttle::isWithinTimespanMs(lastOverflowLogMsec, 10000)) {
+        LOG_WARN("Serial module receive buffer overflowed, %u times so far, received bytes were lost", overflows);
+        rxOverflowsLogged = overflows;
+        lastOverflowLogMsec = millis();
+    }
+}
+
 /**
  * Sends telemetry packet over the mesh network.
  *
@@ -408,62 +459,72 @@ uint32_t SerialModule::getBaudRate()
     return BAUD;
 }
 
-// Add this structure to help with parsing WindGust =       24.4 serial lines.
-struct ParsedLine {
-    char name[64];
-    char value[128];
-};
-
 /**
- * Parse a line of format "Name = Value" into name/value pair
- * @param line Input line to parse
- * @return ParsedLine containing name and value, or empty strings if parse failed
+ * Parses the "Name = Value" lines of a WS80/WS85 weather station a byte at a time as they arrive, so a line split over two reads
+ * is not lost, and nothing is copied, searched or converted again afterwards.  Only the number at the start of a value is kept
+ * (units such as the V of "3.3V" end it), that is all we use.
  */
-ParsedLine parseLine(const char *line)
-{
-    ParsedLine result = {"", ""};
+struct WXLineParser {
+    enum State : uint8_t { NAME, VALUE, SKIP };
+    State state = NAME;
+    bool ended = false; // the last byte ended a line, start over with the next
+    char name[16] = "";
+    uint8_t nameLen = 0;
+    bool negative = false, hasDigits = false, inFraction = false, numberDone = false;
+    uint64_t mantissa = 0;
+    float scale = 1;
+
+    /// Feed one byte
+    /// @return true if it ended a line with a name and a number, see is() and value()
+    bool push(char c)
+    {
+        if (ended)
+            *this = WXLineParser();
+        if (c == '\n' || c == '\r') {
+            ended = true;
+            return state == VALUE && hasDigits;
+        }
 
-    // Find equals sign
-    const char *equals = strchr(line, '=');
-    if (!equals) {
-        return result;
+        switch (state) {
+        case NAME:
+            if (c == '=') {
+                name[nameLen] = '\0';
+                state = VALUE;
+            } else if (!isspace((unsigned char)c)) {
+                if (nameLen < sizeof(name) - 1)
+                    name[nameLen++] = c;
+                else
+                    state = SKIP; // not a name we know
+            }
+            break;
+        case VALUE:
+            if (numberDone)
+                break;
+            if (c >= '0' && c <= '9') {
+                hasDigits = true;
+                if (mantissa < 100000000000000ULL) { // digits beyond float precision don't matter
+                    mantissa = mantissa * 10 + (c - '0');
+                    if (inFraction)
+                        scale *= 10;
+                }
+            } else if (c == '-' && !hasDigits && !negative && !inFraction) {
+                negative = true;
+            } else if (c == '.' && !inFraction) {
+                inFraction = true;
+            } else if (!(isspace((unsigned char)c) && !hasDigits && !negative && !inFraction)) {
+                numberDone = true;
+            }
+            break;
+        case SKIP:
+            break;
+        }
+        return false;
     }
 
-    // Extract name by copying substring
-    char nameBuf[64]; // Temporary buffer
-    size_t nameLen = equals - line;
-    if (nameLen >= sizeof(nameBuf)) {
-        nameLen = sizeof(nameBuf) - 1;
-    }
-    strncpy(nameBuf, line, nameLen);
-    nameBuf[nameLen] = '\0';
-
-    // Trim whitespace from name
-    char *nameStart = nameBuf;
-    while (*nameStart && isspace(*nameStart))
-        nameStart++;
-    char *nameEnd = nameStart + strlen(nameStart) - 1;
-    while (nameEnd > nameStart && isspace(*nameEnd))
-        *nameEnd-- = '\0';
-
-    // Copy trimmed name
-    strncpy(result.name, nameStart, sizeof(result.name) - 1);
-    result.name[sizeof(result.name) - 1] = '\0';
-
-    // Extract value part (after equals)
-    const char *valueStart = equals + 1;
-    while (*valueStart && isspace(*valueStart))
-        valueStart++;
-    strncpy(result.value, valueStart, sizeof(result.value) - 1);
-    result.value[sizeof(result.value) - 1] = '\0';
-
-    // Trim trailing whitespace from value
-    char *valueEnd = result.value + strlen(result.value) - 1;
-    while (valueEnd > result.value && isspace(*valueEnd))
-        *valueEnd-- = '\0';
-
-    return result;
-}
+    bool is(const char *n) const { return strcmp(name, n) == 0; }
+
+    float value() const { return (negative ? -1 : 1) * (mantissa / scale); }
+};
 
 /**
  * Process the received weather station serial data, extract wind, voltage, and temperature information,
@@ -484,112 +545,75 @@ void SerialModule::processWXSerial()
     static float lull = -1;
     static int velCount = 0;
     static int dirCount = 0;
-    static char windDir[4] = "xxx";   // Assuming windDir is 3 characters long + null terminator
-    static char windVel[5] = "xx.x";  // Assuming windVel is 4 characters long + null terminator
-    static char windGust[5] = "xx.x"; // Assuming windGust is 4 characters long + null terminator
-    static char batVoltage[5] = "0.0V";
-    static char capVoltage[5] = "0.0V";
-    static char temperature[5] = "00.0";
+    static float windDirF = 0;
+    static float windVelF = 0;
+    static float windGustF = 0;
     static float batVoltageF = 0;
     static float capVoltageF = 0;
     static float temperatureF = 0;
 
-    static char rainStr[] = "5780860000";
     static int rainSum = 0;
     static float rain = 0;
+    static WXLineParser wx;
     bool gotwind = false;
 
-    while (Serial2.available()) {
-        // clear serialBytes buffer
-        memset(serialBytes, '\0', sizeof(serialBytes));
-        // memset(formattedString, '\0', sizeof(formattedString));
-        serialPayloadSize = Serial2.readBytes(serialBytes, 512);
-        // check for a strings we care about
-        // example output of serial data fields from the WS85
-        // WindDir      = 79
-        // WindSpeed    = 0.5
-        // WindGust     = 0.6
-        // GXTS04Temp   = 24.4
-        // Temperature = 23.4 // WS80
-
-        // RainIntSum     = 0
-        // Rain           = 0.0
-        if (serialPayloadSize > 0) {
-            // Define variables for line processing
-            int lineStart = 0;
-            int lineEnd = -1;
-
-            // Process each byte in the received data
-            for (size_t i = 0; i < serialPayloadSize; i++) {
-                // go until we hit the end of line and then process the line
-                if (serialBytes[i] == '\n') {
-                    lineEnd = i;
-                    // Extract the current line
-                    char line[meshtastic_Constants_DATA_PAYLOAD_LEN];
-                    memset(line, '\0', sizeof(line));
-                    if ((size_t)(lineEnd - lineStart) < sizeof(line) - 1) {
-                        memcpy(line, &serialBytes[lineStart], lineEnd - lineStart);
-
-                        ParsedLine parsed = parseLine(line);
-                        if (strlen(parsed.name) > 0) {
-                            if (strcmp(parsed.name, "WindDir") == 0) {
-                                strlcpy(windDir, parsed.value, sizeof(windDir));
-                                double radians = GeoCoord::toRadians(strtof(windDir, nullptr));
-                                dir_sum_sin += sin(radians);
-                                dir_sum_cos += cos(radians);
-                                dirCount++;
-                                gotwind = true;
-                            } else if (strcmp(parsed.name, "WindSpeed") == 0) {
-                                strlcpy(windVel, parsed.value, sizeof(windVel));
-                                float newv = strtof(windVel, nullptr);
-                                velSum += newv;
-                                velCount++;
-                                if (newv < lull || lull == -1) {
-                                    lull = newv;
-                                }
-                                gotwind = true;
-                            } else if (strcmp(parsed.name, "WindGust") == 0) {
-                                strlcpy(windGust, parsed.value, sizeof(windGust));
-                                float newg = strtof(windGust, nullptr);
-                                if (newg > gust) {
-                                    gust = newg;
-                                }
-                                gotwind = true;
-                            } else if (strcmp(parsed.name, "BatVoltage") == 0) {
-                                strlcpy(batVoltage, parsed.value, sizeof(batVoltage));
-                                batVoltageF = strtof(batVoltage, nullptr);
-                                break; // last possible data we want so break
-                            } else if (strcmp(parsed.name, "CapVoltage") == 0) {
-                                strlcpy(capVoltage, parsed.value, sizeof(capVoltage));
-                                capVoltageF = strtof(capVoltage, nullptr);
-                            } else if (strcmp(parsed.name, "GXTS04Temp") == 0 || strcmp(parsed.name, "Temperature") == 0) {
-                                strlcpy(temperature, parsed.value, sizeof(temperature));
-                                temperatureF = strtof(temperature, nullptr);
-                            } else if (strcmp(parsed.name, "RainIntSum") == 0) {
-                                strlcpy(rainStr, parsed.value, sizeof(rainStr));
-                                rainSum = int(strtof(rainStr, nullptr));
-                            } else if (strcmp(parsed.name, "Rain") == 0) {
-                                strlcpy(rainStr, parsed.value, sizeof(rainStr));
-                                rain = strtof(rainStr, nullptr);
-                            }
-                        }
-
-                        // Update lineStart for the next line
-                        lineStart = lineEnd + 1;
-                    }
-                }
-            }
+    // example output of serial data fields from the WS85
+    // WindDir      = 79
+    // WindSpeed    = 0.5
+    // WindGust     = 0.6
+    // GXTS04Temp   = 24.4
+    // Temperature = 23.4 // WS80
+
+    // RainIntSum     = 0
+    // Rain           = 0.0
+    // Only read what has arrived, the rest of a line comes next time
+    int avail;
+    while ((avail = Serial2.available()) > 0) {
+        size_t got = Serial2.readBytes(serialBytes, min((size_t)avail, sizeof(serialBytes)));
+        if (got == 0)
             break;
-            // clear the input buffer
-            while (Serial2.available() > 0) {
-                Serial2.read(); // Read and discard the bytes in the input buffer
+        for (size_t i = 0; i < got; i++) {
+            if (!wx.push(serialBytes[i]))
+                continue;
+            float v = wx.value();
+            if (wx.is("WindDir")) {
+                windDirF = v;
+                double radians = GeoCoord::toRadians(v);
+                dir_sum_sin += sin(radians);
+                dir_sum_cos += cos(radians);
+                dirCount++;
+                gotwind = true;
+            } else if (wx.is("WindSpeed")) {
+                windVelF = v;
+                velSum += v;
+                velCount++;
+                if (v < lull || lull == -1) {
+                    lull = v;
+                }
+                gotwind = true;
+            } else if (wx.is("WindGust")) {
+                windGustF = v;
+                if (v > gust) {
+                    gust = v;
+                }
+                gotwind = true;
+            } else if (wx.is("BatVoltage")) {
+                batVoltageF = v;
+            } else if (wx.is("CapVoltage")) {
+                capVoltageF = v;
+            } else if (wx.is("GXTS04Temp") || wx.is("Temperature")) {
+                temperatureF = v;
+            } else if (wx.is("RainIntSum")) {
+                rainSum = int(v);
+            } else if (wx.is("Rain")) {
+                rain = v;
             }
         }
     }
     if (gotwind) {
 
-        LOG_INFO("WS8X : %i %.1fg%.1f %.1fv %.1fv %.1fC rain: %.1f, %i sum", atoi(windDir), strtof(windVel, nullptr),
-                 strtof(windGust, nullptr), batVoltageF, capVoltageF, temperatureF, rain, rainSum);
+        LOG_INFO("WS8X : %i %.1fg%.1f %.1fv %.1fv %.1fC rain: %.1f, %i sum", (int)windDirF, windVelF, windGustF, batVoltageF,
+                 capVoltageF, temperatureF, rain, rainSum);
     }
     if (gotwind && !Throttle::isWithinTimespanMs(lastAveraged, averageIntervalMillis)) {
         // calculate averages and send to the mesh
@@ -17,6 +17,11 @@ class SerialModule : public StreamAPI, private concurrency::OSThread
     unsigned long lastNmeaTime = millis();
     char outbuf[90] = "";
 
+    size_t rxBufferBytes = 256;     // Receive buffer of the serial port, sized for its baud rate
+    uint32_t rxFullSeen = 0;        // Times we found it full, where the driver doesn't report overflows itself
+    uint32_t rxOverflowsLogged = 0; // Overflow count we last warned about
+    uint32_t lastOverflowLogMsec = 0;
+
   public:
     SerialModule();
 
@@ -30,6 +35,7 @@ class SerialModule : public StreamAPI, private concurrency::OSThread
     uint32_t getBaudRate();
     void sendTelemetry(meshtastic_Telemetry m);
     void processWXSerial();
+    void checkRxOverflow();
 };
 
 extern SerialModule *serialModule;
@@ -0,0 +1,177 @@
+#include "StoreForwardHistory.h"
+#include <stdlib.h>
+
+StoreForwardHistory::~StoreForwardHistory()
+{
+    delete storage;
+    free(entries);
+    free(nextDirect);
+    free(broadcasts);
+}
+
+bool StoreForwardHistory::init(uint32_t _capacity, StoreForwardStorage *_storage)
+{
+    storage = _storage;
+    entries = static_cast<Entry *>(storeForwardAlloc(_capacity, sizeof(Entry)));
+    nextDirect = static_cast<uint32_t *>(storeForwardAlloc(_capacity, sizeof(uint32_t)));
+    broadcasts = static_cast<uint32_t *>(storeForwardAlloc(_capacity, sizeof(uint32_t)));
+    if (!_capacity || !entries || !nextDirect || !broadcasts) {
+        free(entries);
+        free(nextDirect);
+        free(broadcasts);
+        entries = NULL;
+        nextDirect = broadcasts = NULL;
+        return false;
+    }
+
+    capacity = _capacity;
+    direct.clear();
+    direct.findOrInsert(OTHER_DIRECT); // Always has a slot, so every direct message can be indexed
+    return true;
+}
+
+void StoreForwardHistory::evictOldest()
+{
+    uint32_t seq = oldestSeq++;
+    const Entry &r = at(seq);
+
+    if (r.to == NODENUM_BROADCAST) {
+        broadcastFirst = (broadcastFirst + 1) % capacity;
+        broadcastCount--;
+        return;
+    }
+
+    // Being the oldest record, it is at the head of whichever chain it is in
+    Chain *chain = direct.find(r.to);
+    bool own = chain && chain->head == seq;
+    if (!own)
+        chain = direct.find(OTHER_DIRECT);
+    chain->head = nextDirect[seq % capacity];
+    if (chain->head == NONE) {
+        chain->tail = NONE;
+        if (own && r.to != OTHER_DIRECT)
+            direct.erase(r.to);
+    }
+}
+
+// The storage may have lost records the index still has (flash segments are dropped whole), forget those too
+void StoreForwardHistory::evictUnreadable()
+{
+    while (size() && oldestSeq < storage->firstSeq())
+        evictOldest();
+}
+
+void StoreForwardHistory::add(const PacketHistoryStruct &record)
+{
+    if (!capacity)
+        return;
+
+    uint32_t seq = index(record);
+    if (!storage->write(seq, record))
+        LOG_WARN("S&F - Can't store record %u", seq);
+    evictUnreadable();
+}
+
+void StoreForwardHistory::restore()
+{
+    storage->restore([this](const PacketHistoryStruct &record) { return index(record); });
+    evictUnreadable();
+}
+
+// Add a record to the index, overwriting the oldest if full
+// @return its seq
+uint32_t StoreForwardHistory::index(const PacketHistoryStruct &record)
+{
+    if (size() == capacity) {
+        if (oldestSeq % capacity == 0)
+            LOG_WARN("S&F - History full, overwriting the oldest records");
+        evictOldest();
+    }
+
+    uint32_t seq = nextSeq++;
+    entries[seq % capacity] = {record.time, record.from, record.to};
+    nextDirect[seq % capacity] = NONE;
+
+    if (record.to == NODENUM_BROADCAST) {
+        broadcasts[(broadcastFirst + broadcastCount) % capacity] = seq;
+        broadcastCount++;
+        return seq;
+    }
+
+    Chain *chain = direct.findOrInsert(record.to);
+    if (!chain)
+        chain = direct.find(OTHER_DIRECT);
+    if (chain->tail == NONE)
+        chain->head = seq;
+    else
+        nextDirect[chain->tail % capacity] = seq;
+    chain->tail = seq;
+    return seq;
+}
+
+uint32_t StoreForwardHistory::firstAfter(uint32_t time) const
+{
+    uint32_t lo = oldestSeq, hi = nextSeq;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (at(mid).time > time)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+// The first record in chain from seq up to (not including) before, that is for dest and not from it
+uint32_t StoreForwardHistory::firstInChain(const Chain *chain, NodeNum dest, uint32_t seq, uint32_t before) const
+{
+    if (!chain)
+        return NONE;
+    for (uint32_t s = chain->head; s != NONE && s < before; s = nextDirect[s % capacity]) {
+        const Entry &r = at(s);
+        if (s >= seq && r.to == dest && r.from != dest)
+            return s;
+    }
+    return NONE;
+}
+
+const StoreForwardHistory::Entry *StoreForwardHistory::next(NodeNum dest, uint32_t &seq) const
+{
+    if (seq < oldestSeq)
+        seq = oldestSeq;
+    if (seq >= nextSeq)
+        return NULL;
+
+    // First broadcast at or after seq, skipping the client's own
+    uint32_t found = NONE;
+    uint32_t lo = 0, hi = broadcastCount;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (broadcastAt(mid) >= seq)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    for (uint32_t i = lo; i < broadcastCount; i++) {
+        uint32_t s = broadcastAt(i);
+        if (at(s).from != dest) {
+            found = s;
+            break;
+        }
+    }
+
+    // Unless a direct message to the client comes sooner
+    if (dest != OTHER_DIRECT && dest != NODENUM_BROADCAST) {
+        uint32_t s = firstInChain(direct.find(dest), dest, seq, found);
+        if (s != NONE)
+            found = s;
+        s = firstInChain(direct.find(OTHER_DIRECT), dest, seq, found);
+        if (s != NONE)
+            found = s;
+    }
+
+    if (found == NONE)
+        return NULL;
+    seq = found;
+    return &at(found);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "FlatHashMap.h"
+#include "MeshTypes.h"
+#include "StoreForwardStorage.h"
+#include "configuration.h"
+
+/**
+ * The messages kept by a Store & Forward server, in a ring buffer that overwrites the oldest first.
+ *
+ * Every record gets a sequence number ("seq") in the order it was heard, which is never reused, so a client's progress is
+ * simply the next seq it hasn't been offered yet and stays valid when the buffer wraps.  Broadcasts are indexed in a sorted
+ * array and direct messages in a chain per destination, so finding the next record for a client is a binary search plus a
+ * walk over its own direct messages, rather than a scan of the whole history.
+ *
+ * Only the index (time, sender and destination of each record) is kept here, it always stays in RAM.  The full records are
+ * in a StoreForwardStorage, which may be PSRAM or flash.
+ */
+class StoreForwardHistory
+{
+  public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // What the index knows about each record
+    struct Entry {
+        uint32_t time;
+        NodeNum from, to;
+    };
+
+    ~StoreForwardHistory();
+
+    /// Allocate the index for capacity records (in PSRAM on ESP32, if there is some), keeping the records in storage
+    /// Takes ownership of storage, which must already have room for capacity records.
+    /// @return false if there wasn't enough memory
+    bool init(uint32_t capacity, StoreForwardStorage *storage);
+
+    /// Memory needed per record for the index, for sizing the history to the memory available
+    static size_t bytesPerRecord() { return sizeof(Entry) + 2 * sizeof(uint32_t); }
+
+    /// Index whatever the storage kept from before a reboot
+    void restore();
+
+    uint32_t getCapacity() const { return capacity; }
+    uint32_t size() const { return nextSeq - oldestSeq; }
+
+    /// Store a record, overwriting the oldest if full
+    void add(const PacketHistoryStruct &record);
+
+    /// Fetch the full record numbered seq
+    /// @return false if it is no longer available
+    bool read(uint32_t seq, PacketHistoryStruct &record) const { return storage->read(seq, record); }
+
+    /// @return seq of the first record heard after time, assuming records were heard in time order
+    uint32_t firstAfter(uint32_t time) const;
+
+    /**
+     * Find the first record at or after seq that client dest should be offered: not sent by it, and either a broadcast or
+     * addressed to it.
+     *
+     * @return the record's entry, with seq set to its number, or NULL if there are no more
+     */
+    const Entry *next(NodeNum dest, uint32_t &seq) const;
+
+  private:
+    // A list of the direct messages to one destination, linked through nextDirect
+    struct Chain {
+        uint32_t head = NONE, tail = NONE;
+    };
+
+    // Direct messages whose destination didn't fit in the map are chained under this key. Zero is never a real node.
+    enum : NodeNum { OTHER_DIRECT = 0 };
+
+    StoreForwardStorage *storage = NULL;
+    Entry *entries = NULL;
+    uint32_t *nextDirect = NULL; // for each slot, the seq of the next record in its chain, NONE at the tail
+    uint32_t *broadcasts = NULL; // ring of broadcast seqs in order, starting at broadcastFirst
+    uint32_t broadcastFirst = 0, broadcastCount = 0;
+    uint32_t capacity = 0;
+    uint32_t oldestSeq = 0, nextSeq = 0;
+    FlatHashMap<NodeNum, Chain, 256> direct;
+
+    const Entry &at(uint32_t seq) const { return entries[seq % capacity]; }
+    uint32_t broadcastAt(uint32_t i) const { return broadcasts[(broadcastFirst + i) % capacity]; }
+
+    uint32_t index(const PacketHistoryStruct &record);
+    void evictOldest();
+    void evictUnreadable();
+    uint32_t firstInChain(const Chain *chain, NodeNum dest, uint32_t seq, uint32_t before) const;
+};
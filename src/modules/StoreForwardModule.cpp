@@ -25,6 +25,7 @@
 #include "mesh/generated/meshtastic/storeforward.pb.h"
 #include "modules/ModuleDev.h"
 #include <Arduino.h>
+#include <algorithm>
 #include <iterator>
 #include <map>
 
@@ -32,17 +33,25 @@ StoreForwardModule *storeForwardModule;
 
 int32_t StoreForwardModule::runOnce()
 {
-#if defined(ARCH_ESP32) || defined(ARCH_PORTDUINO)
+#if defined(ARCH_ESP32) || defined(ARCH_PORTDUINO) || defined(ARCH_NRF52) || defined(ARCH_RP2040)
     if (moduleConfig.store_forward.enabled && is_server) {
         // Send out the message queue.
         if (this->busy) {
-            // Only send packets if the channel is less than 25% utilized and until historyReturnMax
-            if (airTime->isTxAllowedChannelUtil(true) && this->requestCount < this->historyReturnMax) {
+            // Don't queue history faster than the radio sends it, other traffic needs room too
+            meshtastic_QueueStatus qs = router->getQueueStatus();
+            bool queueBusy = qs.maxlen && qs.free < qs.maxlen / 2;
+
+            if (this->requestCount >= this->historyReturnMax) {
+                this->requestCount = 0;
+                this->busy = false;
+            } else if (!queueBusy && airTime->isTxAllowedChannelUtil(true)) {
+                // Only send packets if the channel is less than 25% utilized and until historyReturnMax
                 if (!storeForwardModule->sendPayload(this->busyTo, this->last_time)) {
                     this->requestCount = 0;
                     this->busy = false;
                 }
             }
+            return queueBusy ? this->packetTimeMax : replayInterval();
         } else if (this->heartbeat && (!Throttle::isWithinTimespanMs(lastHeartbeat, heartbeatInterval * 1000)) &&
                    airTime->isTxAllowedChannelUtil(true)) {
             lastHeartbeat = millis();
@@ -63,7 +72,7 @@ int32_t StoreForwardModule::runOnce()
 /**
  * Populates the PSRAM with data to be sent later when a device is out of range.
  */
-void StoreForwardModule::populatePSRAM()
+bool StoreForwardModule::populatePSRAM()
 {
     /*
     For PSRAM usage, see:
@@ -76,19 +85,56 @@ void StoreForwardModule::populatePSRAM()
     /* Use a maximum of 3/4 the available PSRAM unless otherwise specified.
         Note: This needs to be done after every thing that would use PSRAM
     */
-    uint32_t numberOfPackets =
-        (this->records ? this->records : (((memGet.getFreePsram() / 4) * 3) / sizeof(PacketHistoryStruct)));
+    size_t bytesPerRecord = StoreForwardHistory::bytesPerRecord() + sizeof(PacketHistoryStruct); // index and record
+    uint32_t numberOfPackets = (this->records ? this->records : (((memGet.getFreePsram() / 4) * 3) / bytesPerRecord));
     this->records = numberOfPackets;
-#if defined(ARCH_ESP32)
-    this->packetHistory = static_cast<PacketHistoryStruct *>(ps_calloc(numberOfPackets, sizeof(PacketHistoryStruct)));
-#elif defined(ARCH_PORTDUINO)
-    this->packetHistory = static_cast<PacketHistoryStruct *>(calloc(numberOfPackets, sizeof(PacketHistoryStruct)));
-
-#endif
+    StoreForwardMemoryStorage *storage = new StoreForwardMemoryStorage();
+    bool okay = storage->init(numberOfPackets);
+    this->history = new StoreForwardHistory();
+    okay = this->history->init(numberOfPackets, storage) && okay;
+    if (!okay) {
+        LOG_ERROR("S&F: can't allocate history for %u records", numberOfPackets);
+        delete this->history;
+        this->history = NULL;
+    }
 
     LOG_DEBUG("After PSRAM init: heap %d/%d PSRAM %d/%d", memGet.getFreeHeap(), memGet.getHeapSize(), memGet.getFreePsram(),
               memGet.getPsramSize());
     LOG_DEBUG("numberOfPackets for packetHistory - %u", numberOfPackets);
+    return okay;
+}
+
+/**
+ * Keeps the message history in flash instead, for servers without PSRAM. It survives reboots, only the index is in RAM.
+ */
+bool StoreForwardModule::populateFlash()
+{
+#if SF_FLASH_HISTORY
+    uint32_t numberOfPackets = StoreForwardFlashStorage::recordsThatFit(this->records ? this->records : SF_FLASH_RECORDS);
+    if (!numberOfPackets) {
+        LOG_ERROR("S&F: no room for a history in flash");
+        return false;
+    }
+    this->records = numberOfPackets;
+    LOG_DEBUG("Before S&F flash history init: heap %d/%d", memGet.getFreeHeap(), memGet.getHeapSize());
+
+    StoreForwardFlashStorage *storage = new StoreForwardFlashStorage();
+    bool okay = storage->init(numberOfPackets);
+    this->history = new StoreForwardHistory();
+    okay = this->history->init(numberOfPackets, storage) && okay;
+    if (okay) {
+        this->history->restore();
+    } else {
+        LOG_ERROR("S&F: can't allocate history index for %u records", numberOfPackets);
+        delete this->history;
+        this->history = NULL;
+    }
+
+    LOG_DEBUG("After S&F flash history init: heap %d/%d", memGet.getFreeHeap(), memGet.getHeapSize());
+    return okay;
+#else
+    return false;
+#endif
 }
 
 /**
@@ -100,9 +146,7 @@ void StoreForwardModule::populatePSRAM()
 void StoreForwardModule::historySend(uint32_t secAgo, uint32_t to)
 {
     this->last_time = getTime() < secAgo ? 0 : getTime() - secAgo;
-    uint32_t queueSize = getNumAvailablePackets(to, last_time);
-    if (queueSize > this->historyReturnMax)
-        queueSize = this->historyReturnMax;
+    uint32_t queueSize = getNumAvailablePackets(to, last_time, this->historyReturnMax);
 
     if (queueSize) {
         LOG_INFO("S&F - Send %u message(s)", queueSize);
@@ -116,32 +160,44 @@ void StoreForwardModule::historySend(uint32_t secAgo, uint32_t to)
     sf.which_variant = meshtastic_StoreAndForward_history_tag;
     sf.variant.history.history_messages = queueSize;
     sf.variant.history.window = secAgo * 1000;
-    sf.variant.history.last_request = lastRequest[to];
+    sf.variant.history.last_request = *getLastRequest(to);
     storeForwardModule->sendMessage(to, sf);
     setIntervalFromNow(this->packetTimeMax); // Delay start of sending payloads
 }
 
+uint32_t *StoreForwardModule::getLastRequest(NodeNum dest)
+{
+    uint32_t *r = lastRequest.findOrInsert(dest);
+    if (!r) {
+        // Clients may be offered messages again, but only from within the time window they ask for
+        LOG_WARN("S&F - Too many clients, reset last request indexes");
+        lastRequest.clear();
+        r = lastRequest.findOrInsert(dest);
+    }
+    return r;
+}
+
 /**
  * Returns the number of available packets in the message history for a specified destination node.
  *
  * @param dest The destination node number.
  * @param last_time The relative time to start counting messages from.
+ * @param max Stop counting once there are this many.
  * @return The number of available packets in the message history.
  */
-uint32_t StoreForwardModule::getNumAvailablePackets(NodeNum dest, uint32_t last_time)
+uint32_t StoreForwardModule::getNumAvailablePackets(NodeNum dest, uint32_t last_time, uint32_t max)
 {
+    if (!this->history)
+        return 0;
+
     uint32_t count = 0;
-    if (lastRequest.find(dest) == lastRequest.end()) {
-        lastRequest.emplace(dest, 0);
-    }
-    for (uint32_t i = lastRequest[dest]; i < this->packetHistoryTotalCount; i++) {
-        if (this->packetHistory[i].time && (this->packetHistory[i].time > last_time)) {
-            // Client is only interested in packets not from itself and only in broadcast packets or packets towards it.
-            if (this->packetHistory[i].from != dest &&
-                (this->packetHistory[i].to == NODENUM_BROADCAST || this->packetHistory[i].to == dest)) {
-                count++;
-            }
-        }
+    uint32_t seq = std::max(*getLastRequest(dest), this->history->firstAfter(last_time));
+    const StoreForwardHistory::Entry *r;
+    // Client is only interested in packets not from itself and only in broadcast packets or packets towards it.
+    while (count < max && (r = this->history->next(dest, seq))) {
+        if (r->time && r->time > last_time)
+            count++;
+        seq++;
     }
     return count;
 }
@@ -157,7 +213,7 @@ meshtastic_MeshPacket *StoreForwardModule::getForPhone()
         NodeNum to = nodeDB->getNodeNum();
         if (!this->busy) {
             // Get number of packets we're going to send in this loop
-            uint32_t histSize = getNumAvailablePackets(to, 0); // No time limit
+            uint32_t histSize = getNumAvailablePackets(to, 0, 1); // No time limit, just whether there are any
             if (histSize) {
                 this->busy = true;
                 this->busyTo = to;
@@ -186,25 +242,21 @@ void StoreForwardModule::historyAdd(const meshtastic_MeshPacket &mp)
 {
     const auto &p = mp.decoded;
 
-    if (this->packetHistoryTotalCount == this->records) {
-        LOG_WARN("S&F - PSRAM Full. Starting overwrite");
-        this->packetHistoryTotalCount = 0;
-        for (auto &i : lastRequest) {
-            i.second = 0; // Clear the last request index for each client device
-        }
-    }
-
-    this->packetHistory[this->packetHistoryTotalCount].time = getTime();
-    this->packetHistory[this->packetHistoryTotalCount].to = mp.to;
-    this->packetHistory[this->packetHistoryTotalCount].channel = mp.channel;
-    this->packetHistory[this->packetHistoryTotalCount].from = getFrom(&mp);
-    this->packetHistory[this->packetHistoryTotalCount].id = mp.id;
-    this->packetHistory[this->packetHistoryTotalCount].reply_id = p.reply_id;
-    this->packetHistory[this->packetHistoryTotalCount].emoji = (bool)p.emoji;
-    this->packetHistory[this->packetHistoryTotalCount].payload_size = p.payload.size;
-    memcpy(this->packetHistory[this->packetHistoryTotalCount].payload, p.payload.bytes, meshtastic_Constants_DATA_PAYLOAD_LEN);
-
-    this->packetHistoryTotalCount++;
+    if (!this->history)
+        return;
+
+    // Clients' last request seqs stay valid when this overwrites the oldest record
+    PacketHistoryStruct record;
+    record.time = getTime();
+    record.to = mp.to;
+    record.channel = mp.channel;
+    record.from = getFrom(&mp);
+    record.id = mp.id;
+    record.reply_id = p.reply_id;
+    record.emoji = (bool)p.emoji;
+    record.payload_size = p.payload.size;
+    memcpy(record.payload, p.payload.bytes, meshtastic_Constants_DATA_PAYLOAD_LEN);
+    this->history->add(record);
 }
 
 /**
@@ -216,70 +268,124 @@ void StoreForwardModule::historyAdd(const meshtastic_MeshPacket &mp)
  */
 bool StoreForwardModule::sendPayload(NodeNum dest, uint32_t last_time)
 {
-    meshtastic_MeshPacket *p = preparePayload(dest, last_time);
+    meshtastic_MeshPacket *p = preparePayload(dest, last_time, false, this->historyReturnMax - this->requestCount);
     if (p) {
-        LOG_INFO("Send S&F Payload");
+        LOG_INFO("Send S&F Payload with %u message(s)", this->payloadRecords);
         service->sendToMesh(p);
-        this->requestCount++;
+        this->requestCount += this->payloadRecords;
         return true;
     }
     return false;
 }
 
+/**
+ * How long to wait between history packets: SF_REPLAY_MIN_MS on an idle channel, slowing to packetTimeMax as the channel
+ * utilization nears the polite limit (above which runOnce() doesn't send at all).
+ */
+uint32_t StoreForwardModule::replayInterval()
+{
+    float load = airTime->channelUtilizationPercent() / airTime->getPoliteChannelUtilPercent();
+    if (load > 1)
+        load = 1;
+    return SF_REPLAY_MIN_MS + (uint32_t)((this->packetTimeMax - SF_REPLAY_MIN_MS) * load);
+}
+
+/**
+ * Appends the messages that follow seq to text, while they look like one burst from the same sender: same destination and
+ * channel, plain text (not a reply or reaction), each heard within SF_BATCH_WINDOW_SECS of the last, joined by newlines.
+ *
+ * @param first The record at seq, already in text.
+ * @return The seq of the last message added, payloadRecords is set to how many are in text.
+ */
+uint32_t StoreForwardModule::batchFollowing(NodeNum dest, uint32_t seq, const PacketHistoryStruct *first,
+                                            meshtastic_StoreAndForward_text_t &text, uint32_t maxRecords)
+{
+    this->payloadRecords = 1;
+    if (first->reply_id || first->emoji)
+        return seq;
+
+    PacketHistoryStruct more;
+    uint32_t lastTime = first->time;
+    while (this->payloadRecords < maxRecords) {
+        uint32_t nextSeq = seq + 1;
+        const StoreForwardHistory::Entry *e = this->history->next(dest, nextSeq);
+        if (!e || e->from != first->from || e->to != first->to || e->time - lastTime > SF_BATCH_WINDOW_SECS)
+            break;
+        if (!this->history->read(nextSeq, more) || more.channel != first->channel || more.reply_id || more.emoji)
+            break;
+        if (text.size + 1 + more.payload_size > SF_BATCH_TEXT_MAX)
+            break;
+
+        text.bytes[text.size++] = '\n';
+        memcpy(text.bytes + text.size, more.payload, more.payload_size);
+        text.size += more.payload_size;
+        seq = nextSeq;
+        lastTime = more.time;
+        this->payloadRecords++;
+    }
+    return seq;
+}
+
 /**
  * Prepares a payload to be sent to a specified destination node from the S&F packet history.
  *
  * @param dest The destination node number.
  * @param last_time The relative time to start sending messages from.
+ * @param local True if the packet is for our own phone, which gets each message as a normal text message.
+ * @param maxRecords How many consecutive messages may be batched into one payload (not for local), see payloadRecords.
  * @return A pointer to the prepared mesh packet or nullptr if none is available.
  */
-meshtastic_MeshPacket *StoreForwardModule::preparePayload(NodeNum dest, uint32_t last_time, bool local)
+meshtastic_MeshPacket *StoreForwardModule::preparePayload(NodeNum dest, uint32_t last_time, bool local, uint32_t maxRecords)
 {
-    for (uint32_t i = lastRequest[dest]; i < this->packetHistoryTotalCount; i++) {
-        if (this->packetHistory[i].time && (this->packetHistory[i].time > last_time)) {
-            /*  Copy the messages that were received by the server in the last msAgo
-                to the packetHistoryTXQueue structure.
-                Client not interested in packets from itself and only in broadcast packets or packets towards it. */
-            if (this->packetHistory[i].from != dest &&
-                (this->packetHistory[i].to == NODENUM_BROADCAST || this->packetHistory[i].to == dest)) {
-
-                meshtastic_MeshPacket *p = allocDataPacket();
-
-                p->to = local ? this->packetHistory[i].to : dest; // PhoneAPI can handle original `to`
-                p->from = this->packetHistory[i].from;
-                p->id = this->packetHistory[i].id;
-                p->channel = this->packetHistory[i].channel;
-                p->decoded.reply_id = this->packetHistory[i].reply_id;
-                p->rx_time = this->packetHistory[i].time;
-                p->decoded.emoji = (uint32_t)this->packetHistory[i].emoji;
-
-                // Let's assume that if the server received the S&F request that the client is in range.
-                //   TODO: Make this configurable.
-                p->want_ack = false;
-
-                if (local) { // PhoneAPI gets normal TEXT_MESSAGE_APP
-                    p->decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
-                    memcpy(p->decoded.payload.bytes, this->packetHistory[i].payload, this->packetHistory[i].payload_size);
-                    p->decoded.payload.size = this->packetHistory[i].payload_size;
+    if (!this->history)
+        return nullptr;
+
+    uint32_t seq = std::max(*getLastRequest(dest), this->history->firstAfter(last_time));
+    /*  Copy the messages that were received by the server in the last msAgo
+        to the packetHistoryTXQueue structure.
+        Client not interested in packets from itself and only in broadcast packets or packets towards it. */
+    PacketHistoryStruct record;
+    const PacketHistoryStruct *r = &record;
+    for (const StoreForwardHistory::Entry *e; (e = this->history->next(dest, seq)); seq++) {
+        if (e->time && (e->time > last_time) && this->history->read(seq, record)) {
+            meshtastic_MeshPacket *p = allocDataPacket();
+
+            p->to = local ? r->to : dest; // PhoneAPI can handle original `to`
+            p->from = r->from;
+            p->id = r->id;
+            p->channel = r->channel;
+            p->decoded.reply_id = r->reply_id;
+            p->rx_time = r->time;
+            p->decoded.emoji = (uint32_t)r->emoji;
+
+            // Let's assume that if the server received the S&F request that the client is in range.
+            //   TODO: Make this configurable.
+            p->want_ack = false;
+
+            if (local) { // PhoneAPI gets normal TEXT_MESSAGE_APP
+                p->decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
+                memcpy(p->decoded.payload.bytes, r->payload, r->payload_size);
+                p->decoded.payload.size = r->payload_size;
+                this->payloadRecords = 1;
+            } else {
+                meshtastic_StoreAndForward sf = meshtastic_StoreAndForward_init_zero;
+                sf.which_variant = meshtastic_StoreAndForward_text_tag;
+                sf.variant.text.size = r->payload_size;
+                memcpy(sf.variant.text.bytes, r->payload, r->payload_size);
+                seq = batchFollowing(dest, seq, r, sf.variant.text, maxRecords);
+                if (r->to == NODENUM_BROADCAST) {
+                    sf.rr = meshtastic_StoreAndForward_RequestResponse_ROUTER_TEXT_BROADCAST;
                 } else {
-                    meshtastic_StoreAndForward sf = meshtastic_StoreAndForward_init_zero;
-                    sf.which_variant = meshtastic_StoreAndForward_text_tag;
-                    sf.variant.text.size = this->packetHistory[i].payload_size;
-                    memcpy(sf.variant.text.bytes, this->packetHistory[i].payload, this->packetHistory[i].payload_size);
-                    if (this->packetHistory[i].to == NODENUM_BROADCAST) {
-                        sf.rr = meshtastic_StoreAndForward_RequestResponse_ROUTER_TEXT_BROADCAST;
-                    } else {
-                        sf.rr = meshtastic_StoreAndForward_RequestResponse_ROUTER_TEXT_DIRECT;
-                    }
-
-                    p->decoded.payload.size = pb_encode_to_bytes(p->decoded.payload.bytes, sizeof(p->decoded.payload.bytes),
-                                                                 &meshtastic_StoreAndForward_msg, &sf);
+                    sf.rr = meshtastic_StoreAndForward_RequestResponse_ROUTER_TEXT_DIRECT;
                 }
 
-                lastRequest[dest] = i + 1; // Update the last request index for the client device
-
-                return p;
+                p->decoded.payload.size = pb_encode_to_bytes(p->decoded.payload.bytes, sizeof(p->decoded.payload.bytes),
+                                                             &meshtastic_StoreAndForward_msg, &sf);
             }
+
+            *getLastRequest(dest) = seq + 1; // Update the last request seq for the client device
+
+            return p;
         }
     }
     return nullptr;
@@ -362,7 +468,7 @@ void StoreForwardModule::statsSend(uint32_t to)
     sf.rr = meshtastic_StoreAndForward_RequestResponse_ROUTER_STATS;
     sf.which_variant = meshtastic_StoreAndForward_stats_tag;
     sf.variant.stats.messages_total = this->records;
-    sf.variant.stats.messages_saved = this->packetHistoryTotalCount;
+    sf.variant.stats.messages_saved = this->history ? this->history->size() : 0;
     sf.variant.stats.messages_max = this->records;
     sf.variant.stats.up_time = millis() / 1000;
     sf.variant.stats.requests = this->requests;
@@ -383,7 +489,7 @@ void StoreForwardModule::statsSend(uint32_t to)
  */
 ProcessMessage StoreForwardModule::handleReceived(const meshtastic_MeshPacket &mp)
 {
-#if defined(ARCH_ESP32) || defined(ARCH_PORTDUINO)
+#if defined(ARCH_ESP32) || defined(ARCH_PORTDUINO) || defined(ARCH_NRF52) || defined(ARCH_RP2040)
     if (moduleConfig.store_forward.enabled) {
 
         if ((mp.decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_APP) && is_server) {
@@ -399,7 +505,7 @@ ProcessMessage StoreForwardModule::handleReceived(const meshtastic_MeshPacket &m
                 }
             } else {
                 storeForwardModule->historyAdd(mp);
-                LOG_INFO("S&F stored. Message history contains %u records now", this->packetHistoryTotalCount);
+                LOG_INFO("S&F stored. Message history contains %u records now", this->history ? this->history->size() : 0);
             }
         } else if (!isFromUs(&mp) && mp.decoded.portnum == meshtastic_PortNum_STORE_FORWARD_APP) {
             auto &p = mp.decoded;
@@ -562,7 +668,7 @@ StoreForwardModule::StoreForwardModule()
       ProtobufModule("StoreForward", meshtastic_PortNum_STORE_FORWARD_APP, &meshtastic_StoreAndForward_msg)
 {
 
-#if defined(ARCH_ESP32) || defined(ARCH_PORTDUINO)
+#if defined(ARCH_ESP32) || defined(ARCH_PORTDUINO) || defined(ARCH_NRF52) || defined(ARCH_RP2040)
 
     isPromiscuous = true; // Brown chicken brown cow
 
@@ -580,36 +686,34 @@ StoreForwardModule::StoreForwardModule()
         // Router
         if ((config.device.role == meshtastic_Config_DeviceConfig_Role_ROUTER || moduleConfig.store_forward.is_server)) {
             LOG_INFO("Init Store & Forward Module in Server mode");
-            if (memGet.getPsramSize() > 0) {
-                if (memGet.getFreePsram() >= 1024 * 1024) {
-
-                    // Do the startup here
-
-                    // Maximum number of records to return.
-                    if (moduleConfig.store_forward.history_return_max)
-                        this->historyReturnMax = moduleConfig.store_forward.history_return_max;
-
-                    // Maximum time window for records to return (in minutes)
-                    if (moduleConfig.store_forward.history_return_window)
-                        this->historyReturnWindow = moduleConfig.store_forward.history_return_window;
-
-                    // Maximum number of records to store in memory
-                    if (moduleConfig.store_forward.records)
-                        this->records = moduleConfig.store_forward.records;
-
-                    // send heartbeat advertising?
-                    if (moduleConfig.store_forward.heartbeat)
-                        this->heartbeat = moduleConfig.store_forward.heartbeat;
-                    else
-                        this->heartbeat = false;
-
-                    // Popupate PSRAM with our data structures.
-                    this->populatePSRAM();
-                    is_server = true;
-                } else {
-                    LOG_INFO(".");
-                    LOG_INFO("S&F: not enough PSRAM free, Disable");
-                }
+            bool havePsram = memGet.getPsramSize() > 0 && memGet.getFreePsram() >= 1024 * 1024;
+            if (havePsram || SF_FLASH_HISTORY) {
+
+                // Do the startup here
+
+                // Maximum number of records to return.
+                if (moduleConfig.store_forward.history_return_max)
+                    this->historyReturnMax = moduleConfig.store_forward.history_return_max;
+
+                // Maximum time window for records to return (in minutes)
+                if (moduleConfig.store_forward.history_return_window)
+                    this->historyReturnWindow = moduleConfig.store_forward.history_return_window;
+
+                // Maximum number of records to store in memory
+                if (moduleConfig.store_forward.records)
+                    this->records = moduleConfig.store_forward.records;
+
+                // send heartbeat advertising?
+                if (moduleConfig.store_forward.heartbeat)
+                    this->heartbeat = moduleConfig.store_forward.heartbeat;
+                else
+                    this->heartbeat = false;
+
+                // Popupate PSRAM with our data structures, or without it keep the history in flash
+                is_server = havePsram ? this->populatePSRAM() : this->populateFlash();
+            } else if (memGet.getPsramSize() > 0) {
+                LOG_INFO(".");
+                LOG_INFO("S&F: not enough PSRAM free, Disable");
             } else {
                 LOG_INFO("S&F: device doesn't have PSRAM, Disable");
             }
@@ -1,25 +1,27 @@
 #pragma once
 
+#include "FlatHashMap.h"
 #include "ProtobufModule.h"
+#include "StoreForwardHistory.h"
 #include "concurrency/OSThread.h"
 #include "mesh/generated/meshtastic/storeforward.pb.h"
 
 #include "configuration.h"
 #include <Arduino.h>
 #include <functional>
-#include <unordered_map>
-
-struct PacketHistoryStruct {
-    uint32_t time;
-    uint32_t to;
-    uint32_t from;
-    uint32_t id;
-    uint8_t channel;
-    uint32_t reply_id;
-    bool emoji;
-    uint8_t payload[meshtastic_Constants_DATA_PAYLOAD_LEN];
-    pb_size_t payload_size;
-};
+
+// Shortest gap between history packets, on an idle channel. The longest is packetTimeMax.
+#ifndef SF_REPLAY_MIN_MS
+#define SF_REPLAY_MIN_MS 1000
+#endif
+
+// Messages from the same sender heard at most this far apart may be sent to a client together in one S&F payload
+#ifndef SF_BATCH_WINDOW_SECS
+#define SF_BATCH_WINDOW_SECS 60
+#endif
+
+// Most text in one S&F payload, leaving room for the rr and text field headers
+#define SF_BATCH_TEXT_MAX (meshtastic_Constants_DATA_PAYLOAD_LEN - 5)
 
 class StoreForwardModule : private concurrency::OSThread, public ProtobufModule<meshtastic_StoreAndForward>
 {
@@ -27,18 +29,21 @@ class StoreForwardModule : private concurrency::OSThread, public ProtobufModule<
     uint32_t busyTo = 0;
     char routerMessage[meshtastic_Constants_DATA_PAYLOAD_LEN] = {0};
 
-    PacketHistoryStruct *packetHistory = 0;
-    uint32_t packetHistoryTotalCount = 0;
+    StoreForwardHistory *history = NULL; // only allocated on a server
     uint32_t last_time = 0;
     uint32_t requestCount = 0;
 
-    uint32_t packetTimeMax = 5000; // Interval between sending history packets as a server.
+    uint32_t packetTimeMax = 5000; // Interval between sending history packets as a server on a busy channel.
+    uint32_t payloadRecords = 0;   // How many history records the last preparePayload() covered
 
     bool is_client = false;
     bool is_server = false;
 
-    // Unordered_map stores the last request for each nodeNum (`to` field)
-    std::unordered_map<NodeNum, uint32_t> lastRequest;
+    // For each client (`to` field), the history seq it has been sent up to
+    FlatHashMap<NodeNum, uint32_t, 128> lastRequest;
+
+    /// The history seq a client has already been sent up to, never NULL
+    uint32_t *getLastRequest(NodeNum dest);
 
   public:
     StoreForwardModule();
@@ -53,18 +58,19 @@ class StoreForwardModule : private concurrency::OSThread, public ProtobufModule<
     void historyAdd(const meshtastic_MeshPacket &mp);
     void statsSend(uint32_t to);
     void historySend(uint32_t secAgo, uint32_t to);
-    uint32_t getNumAvailablePackets(NodeNum dest, uint32_t last_time);
+    uint32_t getNumAvailablePackets(NodeNum dest, uint32_t last_time, uint32_t max = UINT32_MAX);
 
     /**
      * Send our payload into the mesh
      */
     bool sendPayload(NodeNum dest = NODENUM_BROADCAST, uint32_t packetHistory_index = 0);
-    meshtastic_MeshPacket *preparePayload(NodeNum dest, uint32_t packetHistory_index, bool local = false);
+    meshtastic_MeshPacket *preparePayload(NodeNum dest, uint32_t packetHistory_index, bool local = false,
+                                          uint32_t maxRecords = 1);
     void sendMessage(NodeNum dest, const meshtastic_StoreAndForward &payload);
     void sendMessage(NodeNum dest, meshtastic_StoreAndForward_RequestResponse rr);
     void sendErrorTextMessage(NodeNum dest, bool want_response);
     meshtastic_MeshPacket *getForPhone();
-    // Returns true if we are configured as server AND we could allocate PSRAM.
+    // Returns true if we are configured as server AND we could allocate the history (in PSRAM, or flash).
     bool isServer() { return is_server; }
 
     /*
@@ -80,9 +86,14 @@ class StoreForwardModule : private concurrency::OSThread, public ProtobufModule<
             return false;
         }
     }
+    virtual int dispatchPortNum() const override { return MESHMODULE_ANY_PORT; }
 
   private:
-    void populatePSRAM();
+    bool populatePSRAM();
+    bool populateFlash();
+    uint32_t replayInterval();
+    uint32_t batchFollowing(NodeNum dest, uint32_t seq, const PacketHistoryStruct *first, meshtastic_StoreAndForward_text_t &text,
+                            uint32_t maxRecords);
 
     // S&F Defaults
     uint32_t historyReturnMax = 25;     // Return maximum of 25 records by default.
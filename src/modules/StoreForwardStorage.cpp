@@ -0,0 +1,359 @@
+#include "StoreForwardStorage.h"
+#include <stdlib.h>
+
+#if SF_FLASH_HISTORY
+#include "FSCommon.h"
+#include "SPILock.h"
+#include <ErriezCRC32.h>
+#include <algorithm>
+#endif
+
+void *storeForwardAlloc(size_t count, size_t size)
+{
+#if defined(ARCH_ESP32)
+    void *p = ps_calloc(count, size);
+    return p ? p : calloc(count, size); // No PSRAM, e.g. the index of a flash history
+#else
+    return calloc(count, size);
+#endif
+}
+
+StoreForwardMemoryStorage::~StoreForwardMemoryStorage()
+{
+    free(records);
+}
+
+bool StoreForwardMemoryStorage::init(uint32_t _capacity)
+{
+    records = static_cast<PacketHistoryStruct *>(storeForwardAlloc(_capacity, sizeof(PacketHistoryStruct)));
+    capacity = records ? _capacity : 0;
+    return records != NULL;
+}
+
+bool StoreForwardMemoryStorage::write(uint32_t seq, const PacketHistoryStruct &record)
+{
+    records[seq % capacity] = record;
+    return true;
+}
+
+bool StoreForwardMemoryStorage::read(uint32_t seq, PacketHistoryStruct &record)
+{
+    record = records[seq % capacity];
+    return true;
+}
+
+#if SF_FLASH_HISTORY
+
+static const uint8_t SEGMENT_MAGIC[4] = {'S', 'F', 'H', '1'};
+static const size_t SEGMENT_HEADER_LEN = sizeof(SEGMENT_MAGIC) + 4; // magic, file number
+static const size_t RECORD_FIXED_LEN = 5 * 4 + 3;                   // see encodeRecord()
+static const size_t RECORD_MAX_LEN = 2 + RECORD_FIXED_LEN + meshtastic_Constants_DATA_PAYLOAD_LEN + 4;
+
+static const size_t SEGMENT_MAX_LEN = SEGMENT_HEADER_LEN + SF_FLASH_SEGMENT_RECORDS * RECORD_MAX_LEN;
+
+static_assert(SEGMENT_MAX_LEN <= 0xffff, "S&F segment offsets must fit in 16 bits, reduce SF_FLASH_SEGMENT_RECORDS");
+
+/// Free filesystem bytes, -1 where the filesystem can't tell.  Call with fsLock held.
+static int64_t fsFreeBytes()
+{
+#ifdef ARCH_ESP32
+    return (int64_t)FSCom.totalBytes() - FSCom.usedBytes();
+#else
+    return -1;
+#endif
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// [u16 length][time][to][from][id][reply_id][channel][emoji][payload_size][payload][crc32], little endian
+static size_t encodeRecord(const PacketHistoryStruct &r, uint8_t *buf)
+{
+    size_t payloadLen = std::min<size_t>(r.payload_size, meshtastic_Constants_DATA_PAYLOAD_LEN);
+    size_t bodyLen = RECORD_FIXED_LEN + payloadLen;
+    uint8_t *body = buf + 2;
+    buf[0] = bodyLen;
+    buf[1] = bodyLen >> 8;
+    put32(body, r.time);
+    put32(body + 4, r.to);
+    put32(body + 8, r.from);
+    put32(body + 12, r.id);
+    put32(body + 16, r.reply_id);
+    body[20] = r.channel;
+    body[21] = r.emoji;
+    body[22] = payloadLen;
+    memcpy(body + RECORD_FIXED_LEN, r.payload, payloadLen);
+    put32(body + bodyLen, crc32Buffer(body, bodyLen));
+    return 2 + bodyLen + 4;
+}
+
+// body as written by encodeRecord, without the length before it or the crc after
+static bool decodeRecord(const uint8_t *body, size_t bodyLen, PacketHistoryStruct &r)
+{
+    if (bodyLen < RECORD_FIXED_LEN || body[22] != bodyLen - RECORD_FIXED_LEN)
+        return false;
+    memset(&r, 0, sizeof(r));
+    r.time = get32(body);
+    r.to = get32(body + 4);
+    r.from = get32(body + 8);
+    r.id = get32(body + 12);
+    r.reply_id = get32(body + 16);
+    r.channel = body[20];
+    r.emoji = body[21];
+    r.payload_size = body[22];
+    memcpy(r.payload, body + RECORD_FIXED_LEN, r.payload_size);
+    return true;
+}
+
+// Read the record at the file's current position into buf
+// @return the length of its body, at buf + 2, or 0 if it is missing or damaged
+template <class F> static size_t readRecord(F &f, uint8_t *buf)
+{
+    if (f.read(buf, 2) != 2)
+        return 0;
+    size_t bodyLen = buf[0] | (buf[1] << 8);
+    if (bodyLen < RECORD_FIXED_LEN || 2 + bodyLen + 4 > RECORD_MAX_LEN)
+        return 0;
+    if ((size_t)f.read(buf + 2, bodyLen + 4) != bodyLen + 4)
+        return 0;
+    if (get32(buf + 2 + bodyLen) != crc32Buffer(buf + 2, bodyLen))
+        return 0;
+    return bodyLen;
+}
+
+StoreForwardFlashStorage::~StoreForwardFlashStorage()
+{
+    free(locations);
+}
+
+bool StoreForwardFlashStorage::init(uint32_t _capacity)
+{
+    locations = static_cast<uint32_t *>(storeForwardAlloc(_capacity, sizeof(uint32_t)));
+    if (!locations)
+        return false;
+    capacity = _capacity;
+    // One spare segment, so there is still a full capacity of records while the newest is being filled
+    segments.resize((capacity + SF_FLASH_SEGMENT_RECORDS - 1) / SF_FLASH_SEGMENT_RECORDS + 1);
+    return true;
+}
+
+uint32_t StoreForwardFlashStorage::recordsThatFit(uint32_t wanted)
+{
+    uint32_t wantedSegments = (wanted + SF_FLASH_SEGMENT_RECORDS - 1) / SF_FLASH_SEGMENT_RECORDS + 1; // see init()
+    int64_t freeBytes;
+    {
+        concurrency::LockGuard g(fsLock);
+        freeBytes = fsFreeBytes();
+        if (freeBytes < 0)
+            return wanted;
+        // Our segments from before a reboot get reused, so the space they take is ours too
+        char name[32];
+        for (uint16_t slot = 0; slot < wantedSegments; slot++) {
+            fileName(slot, name, sizeof(name));
+            auto f = FSCom.open(name, FILE_O_READ);
+            if (f) {
+                freeBytes += f.size();
+                f.close();
+            }
+        }
+    }
+
+    int64_t usable = freeBytes - SF_FLASH_RESERVE_BYTES;
+    uint32_t fitSegments = usable > 0 ? usable / SEGMENT_MAX_LEN : 0;
+    if (fitSegments >= wantedSegments)
+        return wanted;
+    uint32_t fits = fitSegments > 1 ? (fitSegments - 1) * SF_FLASH_SEGMENT_RECORDS : 0;
+    LOG_WARN("S&F - Only room for %u of %u records in flash", fits, wanted);
+    return fits;
+}
+
+void StoreForwardFlashStorage::fileName(uint16_t slot, char *name, size_t size)
+{
+    snprintf(name, size, SF_FLASH_DIR "/%u.log", slot);
+}
+
+// Reuse the oldest slot for a new segment, starting with seq
+bool StoreForwardFlashStorage::startSegment(uint32_t seq)
+{
+    current = nextFileNo % segments.size();
+    if (!segments[current].valid) {
+        int64_t freeBytes;
+        {
+            concurrency::LockGuard g(fsLock);
+            freeBytes = fsFreeBytes();
+        }
+        if (freeBytes >= 0 && freeBytes < SF_FLASH_RESERVE_BYTES + (int64_t)SEGMENT_MAX_LEN) {
+            // Something else filled the filesystem since init(), start over on our oldest file rather than add one
+            int oldest = -1;
+            for (size_t i = 0; i < segments.size(); i++)
+                if (segments[i].valid && (oldest < 0 || segments[i].fileNo < segments[oldest].fileNo))
+                    oldest = i;
+            if (oldest < 0) {
+                LOG_WARN("S&F - Filesystem full, history not kept");
+                haveCurrent = false;
+                return false;
+            }
+            current = oldest;
+        }
+    }
+    Segment &s = segments[current];
+    if (s.valid)
+        first = std::max(first, s.endSeq); // The oldest records go with it
+
+    char name[32];
+    fileName(current, name, sizeof(name));
+    uint8_t header[SEGMENT_HEADER_LEN];
+    memcpy(header, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+    put32(header + sizeof(SEGMENT_MAGIC), nextFileNo);
+
+    concurrency::LockGuard g(fsLock);
+    FSCom.mkdir(SF_FLASH_DIR);
+    FSCom.remove(name); // FILE_O_WRITE appends on nRF52
+    auto f = FSCom.open(name, FILE_O_WRITE);
+    bool okay = f && f.write(header, sizeof(header)) == sizeof(header);
+    if (f)
+        f.close();
+    invalidateFileManifest();
+
+    s.valid = okay;
+    s.fileNo = nextFileNo++;
+    s.firstSeq = s.endSeq = seq;
+    s.bytes = sizeof(header);
+    haveCurrent = okay;
+    if (!okay)
+        LOG_ERROR("S&F - Can't create %s", name);
+    return okay;
+}
+
+bool StoreForwardFlashStorage::write(uint32_t seq, const PacketHistoryStruct &record)
+{
+    if (!haveCurrent || segments[current].endSeq - segments[current].firstSeq >= SF_FLASH_SEGMENT_RECORDS) {
+        if (!startSegment(seq))
+            return false;
+    }
+
+    uint8_t buf[RECORD_MAX_LEN];
+    size_t len = encodeRecord(record, buf);
+    Segment &s = segments[current];
+    char name[32];
+    fileName(current, name, sizeof(name));
+
+    bool okay = false;
+    {
+        concurrency::LockGuard g(fsLock);
+        auto f = FSCom.open(name, FILE_O_APPEND);
+        if (f) {
+            okay = f.write(buf, len) == len;
+            f.close();
+            invalidateFileManifest();
+        }
+    }
+    if (!okay) {
+        LOG_ERROR("S&F - Can't append to %s", name);
+        haveCurrent = false; // Whatever got written may be damaged, carry on in a fresh segment
+        return false;
+    }
+
+    locations[seq % capacity] = (uint32_t)current << 16 | s.bytes;
+    s.bytes += len;
+    s.endSeq = seq + 1;
+    return true;
+}
+
+bool StoreForwardFlashStorage::read(uint32_t seq, PacketHistoryStruct &record)
+{
+    if (seq < first)
+        return false;
+    uint32_t location = locations[seq % capacity];
+    uint16_t slot = location >> 16;
+    if (slot >= segments.size())
+        return false;
+    const Segment &s = segments[slot];
+    if (!s.valid || seq < s.firstSeq || seq >= s.endSeq)
+        return false;
+
+    char name[32];
+    fileName(slot, name, sizeof(name));
+    uint8_t buf[RECORD_MAX_LEN];
+    size_t bodyLen = 0;
+    {
+        concurrency::LockGuard g(fsLock);
+        auto f = FSCom.open(name, FILE_O_READ);
+        if (!f)
+            return false;
+        if (f.seek(location & 0xffff))
+            bodyLen = readRecord(f, buf);
+        f.close();
+    }
+    return bodyLen && decodeRecord(buf + 2, bodyLen, record);
+}
+
+void StoreForwardFlashStorage::restore(std::function<uint32_t(const PacketHistoryStruct &)> index)
+{
+    // Find the segments left from before, to replay them oldest first
+    struct Found {
+        uint32_t fileNo;
+        uint16_t slot;
+    };
+    std::vector<Found> found;
+    char name[32];
+    for (uint16_t slot = 0; slot < segments.size(); slot++) {
+        fileName(slot, name, sizeof(name));
+        uint8_t header[SEGMENT_HEADER_LEN];
+        concurrency::LockGuard g(fsLock);
+        auto f = FSCom.open(name, FILE_O_READ);
+        if (!f)
+            continue;
+        if (f.read(header, sizeof(header)) == sizeof(header) && memcmp(header, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) == 0)
+            found.push_back({get32(header + sizeof(SEGMENT_MAGIC)), slot});
+        f.close();
+    }
+    std::sort(found.begin(), found.end(), [](const Found &a, const Found &b) { return a.fileNo < b.fileNo; });
+
+    uint32_t restored = 0;
+    uint8_t buf[RECORD_MAX_LEN];
+    PacketHistoryStruct record;
+    for (const Found &seg : found) {
+        Segment &s = segments[seg.slot];
+        s.valid = true;
+        s.fileNo = seg.fileNo;
+        s.bytes = SEGMENT_HEADER_LEN;
+        s.firstSeq = s.endSeq = UINT32_MAX; // set by the first record
+        nextFileNo = seg.fileNo + 1;
+
+        fileName(seg.slot, name, sizeof(name));
+        concurrency::LockGuard g(fsLock);
+        auto f = FSCom.open(name, FILE_O_READ);
+        bool opened = f && f.seek(SEGMENT_HEADER_LEN);
+        size_t bodyLen;
+        // Stop at the end of the file, or the first damaged record
+        while (opened && (bodyLen = readRecord(f, buf)) && decodeRecord(buf + 2, bodyLen, record)) {
+            uint32_t seq = index(record);
+            if (s.firstSeq == UINT32_MAX)
+                s.firstSeq = seq;
+            s.endSeq = seq + 1;
+            locations[seq % capacity] = (uint32_t)seg.slot << 16 | s.bytes;
+            s.bytes += 2 + bodyLen + 4;
+            restored++;
+        }
+        if (f)
+            f.close();
+
+        if (s.firstSeq == UINT32_MAX)
+            s.valid = false; // Nothing in it worth keeping
+    }
+    haveCurrent = false; // New records go in a fresh segment, never after a possibly damaged tail
+    LOG_INFO("S&F - Restored %u records from %u segments", restored, (unsigned)found.size());
+}
+
+#endif
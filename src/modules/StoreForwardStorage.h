@@ -0,0 +1,137 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include "configuration.h"
+#include <functional>
+#include <vector>
+
+// Keep the S&F history in flash on servers without PSRAM.  Opt in on nRF52 and RP2040: their filesystems are small, hold the
+// node database too, and can't report their free space, so only the record count would bound the log
+#ifndef SF_FLASH_HISTORY
+#if defined(ARCH_ESP32)
+#define SF_FLASH_HISTORY 1
+#else
+#define SF_FLASH_HISTORY 0
+#endif
+#endif
+
+// Records kept in flash unless moduleConfig.store_forward.records says otherwise. The index stays in RAM, about 24 bytes each
+#ifndef SF_FLASH_RECORDS
+#define SF_FLASH_RECORDS 500
+#endif
+
+// Records per segment file. The oldest segment is deleted as a whole when a new one is needed.
+#ifndef SF_FLASH_SEGMENT_RECORDS
+#define SF_FLASH_SEGMENT_RECORDS 50
+#endif
+
+// Filesystem space the log leaves free, where the filesystem can report it.  Fewer records are kept rather than go below it.
+#ifndef SF_FLASH_RESERVE_BYTES
+#define SF_FLASH_RESERVE_BYTES (64 * 1024)
+#endif
+
+#define SF_FLASH_DIR "/sf"
+
+struct PacketHistoryStruct {
+    uint32_t time;
+    uint32_t to;
+    uint32_t from;
+    uint32_t id;
+    uint8_t channel;
+    uint32_t reply_id;
+    bool emoji;
+    uint8_t payload[meshtastic_Constants_DATA_PAYLOAD_LEN];
+    pb_size_t payload_size;
+};
+
+/// A zeroed array, in PSRAM where there is some
+void *storeForwardAlloc(size_t count, size_t size);
+
+/**
+ * Where StoreForwardHistory keeps full records, by seq. The index used to find them always stays in RAM.
+ */
+class StoreForwardStorage
+{
+  public:
+    virtual ~StoreForwardStorage() {}
+
+    /// Keep the record numbered seq. Records always arrive in seq order, with no gaps.
+    virtual bool write(uint32_t seq, const PacketHistoryStruct &record) = 0;
+
+    /// @return false if the record is gone or damaged
+    virtual bool read(uint32_t seq, PacketHistoryStruct &record) = 0;
+
+    /// Records before this seq can no longer be read, even if the history hasn't overwritten them yet
+    virtual uint32_t firstSeq() const { return 0; }
+
+    /**
+     * Pass whatever survived from before a reboot to index, oldest first.
+     * index adds it to the history without writing it again, and returns the seq it is now known by.
+     */
+    virtual void restore(std::function<uint32_t(const PacketHistoryStruct &)> index) {}
+};
+
+/// Records in a RAM (or PSRAM) array, lost at reboot
+class StoreForwardMemoryStorage : public StoreForwardStorage
+{
+  public:
+    virtual ~StoreForwardMemoryStorage();
+
+    bool init(uint32_t capacity);
+
+    virtual bool write(uint32_t seq, const PacketHistoryStruct &record) override;
+    virtual bool read(uint32_t seq, PacketHistoryStruct &record) override;
+
+  private:
+    PacketHistoryStruct *records = NULL;
+    uint32_t capacity = 0;
+};
+
+#if SF_FLASH_HISTORY
+/**
+ * Records in an append-only log on the filesystem, which survives reboots.
+ *
+ * The log is split into segment files of SF_FLASH_SEGMENT_RECORDS records, reused in turn, so expiring old records is just
+ * starting over on the oldest file.  Each file starts with a header holding its number in the sequence, and each record is
+ * [u16 length][fields][crc32].  Where each record is (file and offset) is kept in RAM.
+ *
+ * After a reboot new records always go in a fresh segment, so a record damaged by losing power only ever costs the rest of
+ * its own file.  If the filesystem gets within SF_FLASH_RESERVE_BYTES of full, new segments reuse the oldest file instead of
+ * adding one.
+ */
+class StoreForwardFlashStorage : public StoreForwardStorage
+{
+  public:
+    virtual ~StoreForwardFlashStorage();
+
+    /// Room for at least capacity records
+    bool init(uint32_t capacity);
+
+    /// @return how many of wanted records fit on the filesystem above SF_FLASH_RESERVE_BYTES, 0 if none do
+    static uint32_t recordsThatFit(uint32_t wanted);
+
+    virtual bool write(uint32_t seq, const PacketHistoryStruct &record) override;
+    virtual bool read(uint32_t seq, PacketHistoryStruct &record) override;
+    virtual uint32_t firstSeq() const override { return first; }
+    virtual void restore(std::function<uint32_t(const PacketHistoryStruct &)> index) override;
+
+  private:
+    // One segment file, in the slot its number maps to
+    struct Segment {
+        bool valid = false;
+        uint32_t fileNo = 0;
+        uint32_t firstSeq = 0, endSeq = 0; // the seqs it holds
+        uint32_t bytes = 0;                // file size so far
+    };
+    std::vector<Segment> segments;
+    uint32_t *locations = NULL; // for each seq (modulo capacity), its segment slot << 16 | offset in the file
+    uint32_t capacity = 0;
+    uint32_t first = 0;         // see firstSeq()
+    uint32_t nextFileNo = 0;
+    bool haveCurrent = false;   // whether new records can go at the end of current
+    uint16_t current = 0;
+
+    static void fileName(uint16_t slot, char *name, size_t size);
+    bool startSegment(uint32_t seq);
+};
+#endif
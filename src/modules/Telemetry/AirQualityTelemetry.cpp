@@ -94,7 +94,8 @@ int32_t AirQualityTelemetryModule::runOnce()
             if (((lastSentToMesh == 0) ||
                  !Throttle::isWithinTimespanMs(lastSentToMesh, Default::getConfiguredOrDefaultMsScaled(
                                                                    moduleConfig.telemetry.air_quality_interval,
-                                                                   default_telemetry_broadcast_interval_secs, numOnlineNodes))) &&
+                                                                   default_telemetry_broadcast_interval_secs, numOnlineNodes,
+                                                                   meshtastic_PortNum_TELEMETRY_APP))) &&
                 airTime->isTxAllowedChannelUtil(config.device.role != meshtastic_Config_DeviceConfig_Role_SENSOR) &&
                 airTime->isTxAllowedAirUtil()) {
                 sendTelemetry();
@@ -105,6 +106,12 @@ int32_t AirQualityTelemetryModule::runOnce()
                 sendTelemetry(NODENUM_BROADCAST, true);
             }
 
+            if (batch.wantSample()) {
+                meshtastic_Telemetry m = meshtastic_Telemetry_init_zero;
+                if (getAirQualityTelemetry(&m))
+                    batch.add(m);
+            }
+
 #ifdef PMSA003I_ENABLE_PIN
             // put sensor back to sleep
             digitalWrite(PMSA003I_ENABLE_PIN, LOW);
@@ -131,6 +138,10 @@ bool AirQualityTelemetryModule::handleReceivedProtobuf(const meshtastic_MeshPack
         LOG_INFO("                  | PM1.0(Environmental)=%i, PM2.5(Environmental)=%i, PM10.0(Environmental)=%i",
                  t->variant.air_quality_metrics.pm10_environmental, t->variant.air_quality_metrics.pm25_environmental,
                  t->variant.air_quality_metrics.pm100_environmental);
+
+        size_t batched = TelemetryBatch::forEachSample(mp, *t, [](const meshtastic_Telemetry &) {});
+        if (batched)
+            LOG_INFO("(Received from %s): %u earlier samples", sender, (unsigned)batched);
 #endif
         // release previous packet before occupying a new spot
         if (lastMeasurementPacket != nullptr)
@@ -225,6 +236,7 @@ bool AirQualityTelemetryModule::sendTelemetry(NodeNum dest, bool phoneOnly)
             service->sendToPhone(p);
         } else {
             LOG_INFO("Send packet to mesh");
+            batch.sendWith(p, m);
             service->sendToMesh(p, RX_SRC_LOCAL, true);
         }
         return true;
@@ -7,6 +7,7 @@
 #include "Adafruit_PM25AQI.h"
 #include "NodeDB.h"
 #include "ProtobufModule.h"
+#include "TelemetryBatch.h"
 
 class AirQualityTelemetryModule : private concurrency::OSThread, public ProtobufModule<meshtastic_Telemetry>
 {
@@ -62,6 +63,7 @@ class AirQualityTelemetryModule : private concurrency::OSThread, public Protobuf
     meshtastic_MeshPacket *lastMeasurementPacket;
     uint32_t sendToPhoneIntervalMs = SECONDS_IN_MINUTE * 1000; // Send to phone every minute
     uint32_t lastSentToMesh = 0;
+    TelemetryBatch batch = TelemetryBatch(meshtastic_Telemetry_air_quality_metrics_tag); // samples taken between sends
 };
 
 #endif
\ No newline at end of file
@@ -1,12 +1,16 @@
 #include "DeviceTelemetry.h"
 #include "../mesh/generated/meshtastic/telemetry.pb.h"
 #include "Default.h"
+#include "HeapTracker.h"
 #include "MeshService.h"
 #include "NodeDB.h"
+#include "PacketLatency.h"
 #include "PowerFSM.h"
 #include "RTC.h"
 #include "RadioLibInterface.h"
+#include "ReliableRouter.h"
 #include "Router.h"
+#include "SPILock.h"
 #include "configuration.h"
 #include "main.h"
 #include "memGet.h"
@@ -24,7 +28,8 @@ int32_t DeviceTelemetryModule::runOnce()
     if (((lastSentToMesh == 0) ||
          ((uptimeLastMs - lastSentToMesh) >=
           Default::getConfiguredOrDefaultMsScaled(moduleConfig.telemetry.device_update_interval,
-                                                  default_telemetry_broadcast_interval_secs, numOnlineNodes))) &&
+                                                  default_telemetry_broadcast_interval_secs, numOnlineNodes,
+                                                  meshtastic_PortNum_TELEMETRY_APP))) &&
         airTime->isTxAllowedChannelUtil(!isImpoliteRole) && airTime->isTxAllowedAirUtil() &&
         config.device.role != meshtastic_Config_DeviceConfig_Role_REPEATER &&
         config.device.role != meshtastic_Config_DeviceConfig_Role_CLIENT_HIDDEN) {
@@ -150,6 +155,44 @@ meshtastic_Telemetry DeviceTelemetryModule::getLocalStatsTelemetry()
 
     LOG_INFO("num_packets_tx=%i, num_packets_rx=%i, num_packets_rx_bad=%i", telemetry.variant.local_stats.num_packets_tx,
              telemetry.variant.local_stats.num_packets_rx, telemetry.variant.local_stats.num_packets_rx_bad);
+    if (RadioLibInterface::instance)
+        LOG_INFO("Channel access: %u CAD scans, %u found the channel busy, %u deferred while receiving",
+                 RadioLibInterface::instance->cadScans, RadioLibInterface::instance->txDeferredCad,
+                 RadioLibInterface::instance->txDeferredRx);
+    // Compare the bad and good counts across duty cycle settings to see what sleeping costs in missed packets
+    if (RadioLibInterface::instance && RadioLibInterface::instance->getRxDutyCycle() < 1)
+        LOG_INFO("RX duty cycle: listening %.0f%% of the time, %u good of %u received",
+                 RadioLibInterface::instance->getRxDutyCycle() * 100, RadioLibInterface::instance->rxGood,
+                 RadioLibInterface::instance->rxGood + RadioLibInterface::instance->rxBad);
+#if PIGGYBACK_ACKS
+    if (router)
+        LOG_INFO("%u queued ACKs replaced by replies", router->txAckPiggybacked);
+#endif
+#if RELAY_DOWNSAMPLE
+    if (router)
+        LOG_INFO("%u periodic broadcasts not relayed, too soon after the last one", router->txRelayDownsampled);
+#endif
+    if (service)
+        LOG_INFO("ToPhone queue: %u dropped, %u replaced by newer", service->getToPhoneDropped(),
+                 service->getToPhoneCoalesced());
+#if RADIO_SPI_STATS
+    LockingArduinoHal::logSpiStats();
+#endif
+#if LOCK_STATS
+    spiLock->logStats();
+    if (fsLock != spiLock)
+        fsLock->logStats();
+#endif
+#if POWER_STATE_STATS && !MESHTASTIC_EXCLUDE_POWER_FSM
+    PowerFSM_logStateTimes();
+#endif
+#if HEAP_TRACKING
+    // LocalStats only has room for the heap totals, the rest goes to the log alongside
+    HeapTracker::logStats();
+#endif
+#if PACKET_LATENCY
+    PacketLatency::logHistograms();
+#endif
 
     return telemetry;
 }
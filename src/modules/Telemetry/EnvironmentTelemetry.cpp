@@ -199,6 +199,9 @@ IndicatorSensor indicatorSensor;
 #endif
 
 #define FAILED_STATE_SENSOR_READ_MULTIPLIER 10
+// How often to check whether started measurements are ready, and how long to wait for them
+#define SENSOR_MEASUREMENT_POLL_MS 20
+#define SENSOR_MEASUREMENT_TIMEOUT_MS 1000
 #define DISPLAY_RECEIVEID_MEASUREMENTS_ON_SCREEN true
 
 #include "graphics/ScreenFonts.h"
@@ -325,23 +328,80 @@ int32_t EnvironmentTelemetryModule::runOnce()
 #endif
         }
 
-        if (((lastSentToMesh == 0) ||
-             !Throttle::isWithinTimespanMs(lastSentToMesh, Default::getConfiguredOrDefaultMsScaled(
-                                                               moduleConfig.telemetry.environment_update_interval,
-                                                               default_telemetry_broadcast_interval_secs, numOnlineNodes))) &&
-            airTime->isTxAllowedChannelUtil(config.device.role != meshtastic_Config_DeviceConfig_Role_SENSOR) &&
-            airTime->isTxAllowedAirUtil()) {
+        bool meshDue = ((lastSentToMesh == 0) ||
+                        !Throttle::isWithinTimespanMs(lastSentToMesh, Default::getConfiguredOrDefaultMsScaled(
+                                                                          moduleConfig.telemetry.environment_update_interval,
+                                                                          default_telemetry_broadcast_interval_secs,
+                                                                          numOnlineNodes, meshtastic_PortNum_TELEMETRY_APP))) &&
+                       airTime->isTxAllowedChannelUtil(config.device.role != meshtastic_Config_DeviceConfig_Role_SENSOR) &&
+                       airTime->isTxAllowedAirUtil();
+        // Only send to phone while queue is empty (phone assumed connected)
+        bool phoneDue = ((lastSentToPhone == 0) || !Throttle::isWithinTimespanMs(lastSentToPhone, sendToPhoneIntervalMs)) &&
+                        (service->isToPhoneQueueEmpty());
+        bool sampleDue = batch.wantSample();
+
+        // Let the slow sensors convert while other threads run, rather than waiting for them in getMetrics()
+        if (meshDue || phoneDue || sampleDue) {
+            if (measurementStartMs == 0) {
+                uint32_t waitMs = startMeasurements();
+                if (waitMs) {
+                    measurementStartMs = millis();
+                    return min(waitMs, result);
+                }
+            } else if (!measurementsReady()) {
+                if (Throttle::isWithinTimespanMs(measurementStartMs, SENSOR_MEASUREMENT_TIMEOUT_MS))
+                    return min((uint32_t)SENSOR_MEASUREMENT_POLL_MS, result);
+                LOG_WARN("Environment sensors not ready after %ums, read anyway", SENSOR_MEASUREMENT_TIMEOUT_MS);
+            }
+        }
+        measurementStartMs = 0;
+
+        if (meshDue) {
             sendTelemetry();
             lastSentToMesh = millis();
-        } else if (((lastSentToPhone == 0) || !Throttle::isWithinTimespanMs(lastSentToPhone, sendToPhoneIntervalMs)) &&
-                   (service->isToPhoneQueueEmpty())) {
+        } else if (phoneDue) {
             // Just send to phone when it's not our time to send to mesh yet
-            // Only send while queue is empty (phone assumed connected)
             sendTelemetry(NODENUM_BROADCAST, true);
             lastSentToPhone = millis();
         }
+
+        if (sampleDue) {
+            meshtastic_Telemetry m = meshtastic_Telemetry_init_zero;
+            m.which_variant = meshtastic_Telemetry_environment_metrics_tag;
+            m.time = getTime();
+            if (getEnvironmentTelemetry(&m))
+                batch.add(m);
+        }
+    }
+    return min(min(sendToPhoneIntervalMs, result), batch.msUntilNextSample());
+}
+
+#if !MESHTASTIC_EXCLUDE_ENVIRONMENTAL_SENSOR_EXTERNAL
+// Sensors that take long enough to convert to be worth not waiting for, see TelemetrySensor::startMeasurement()
+static TelemetrySensor *const slowSensors[] = {&nau7802Sensor, &rcwl9620Sensor, &rak12035Sensor};
+#endif
+
+uint32_t EnvironmentTelemetryModule::startMeasurements()
+{
+    uint32_t waitMs = 0;
+#if !MESHTASTIC_EXCLUDE_ENVIRONMENTAL_SENSOR_EXTERNAL
+    for (TelemetrySensor *sensor : slowSensors) {
+        if (sensor->hasSensor())
+            waitMs = max(waitMs, sensor->startMeasurement());
     }
-    return min(sendToPhoneIntervalMs, result);
+#endif
+    return waitMs;
+}
+
+bool EnvironmentTelemetryModule::measurementsReady()
+{
+#if !MESHTASTIC_EXCLUDE_ENVIRONMENTAL_SENSOR_EXTERNAL
+    for (TelemetrySensor *sensor : slowSensors) {
+        if (sensor->hasSensor() && !sensor->isMeasurementReady())
+            return false;
+    }
+#endif
+    return true;
 }
 
 bool EnvironmentTelemetryModule::wantUIFrame()
@@ -521,6 +581,10 @@ bool EnvironmentTelemetryModule::handleReceivedProtobuf(const meshtastic_MeshPac
 
         LOG_INFO("(Received from %s): radiation=%fµR/h", sender, t->variant.environment_metrics.radiation);
 
+        size_t batched = TelemetryBatch::forEachSample(mp, *t, [](const meshtastic_Telemetry &) {});
+        if (batched)
+            LOG_INFO("(Received from %s): %u earlier samples", sender, (unsigned)batched);
+
 #endif
         // release previous packet before occupying a new spot
         if (lastMeasurementPacket != nullptr)
@@ -762,6 +826,7 @@ bool EnvironmentTelemetryModule::sendTelemetry(NodeNum dest, bool phoneOnly)
             service->sendToPhone(p);
         } else {
             LOG_INFO("Send packet to mesh");
+            batch.sendWith(p, m);
             service->sendToMesh(p, RX_SRC_LOCAL, true);
 
             if (config.device.role == meshtastic_Config_DeviceConfig_Role_SENSOR && config.power.is_power_saving) {
@@ -11,6 +11,7 @@
 #include "../mesh/generated/meshtastic/telemetry.pb.h"
 #include "NodeDB.h"
 #include "ProtobufModule.h"
+#include "TelemetryBatch.h"
 #include <OLEDDisplay.h>
 #include <OLEDDisplayUi.h>
 
@@ -46,6 +47,9 @@ class EnvironmentTelemetryModule : private concurrency::OSThread, public Protobu
     @return true if it contains valid data
     */
     bool getEnvironmentTelemetry(meshtastic_Telemetry *m);
+    /// Start the slow sensors converting, @return msecs until they should all be ready, 0 if there are none
+    uint32_t startMeasurements();
+    bool measurementsReady();
     virtual meshtastic_MeshPacket *allocReply() override;
     /**
      * Send our Telemetry into the mesh
@@ -61,7 +65,9 @@ class EnvironmentTelemetryModule : private concurrency::OSThread, public Protobu
     meshtastic_MeshPacket *lastMeasurementPacket;
     uint32_t sendToPhoneIntervalMs = SECONDS_IN_MINUTE * 1000; // Send to phone every minute
     uint32_t lastSentToMesh = 0;
+    TelemetryBatch batch = TelemetryBatch(meshtastic_Telemetry_environment_metrics_tag); // samples taken between sends
     uint32_t lastSentToPhone = 0;
+    uint32_t measurementStartMs = 0; // when startMeasurements() was called, 0 if not waiting for one
     uint32_t sensor_read_error_count = 0;
 };
 
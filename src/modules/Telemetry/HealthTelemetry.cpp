@@ -72,7 +72,8 @@ int32_t HealthTelemetryModule::runOnce()
         if (((lastSentToMesh == 0) ||
              !Throttle::isWithinTimespanMs(lastSentToMesh, Default::getConfiguredOrDefaultMsScaled(
                                                                moduleConfig.telemetry.health_update_interval,
-                                                               default_telemetry_broadcast_interval_secs, numOnlineNodes))) &&
+                                                               default_telemetry_broadcast_interval_secs, numOnlineNodes,
+                                                               meshtastic_PortNum_TELEMETRY_APP))) &&
             airTime->isTxAllowedChannelUtil(config.device.role != meshtastic_Config_DeviceConfig_Role_SENSOR) &&
             airTime->isTxAllowedAirUtil()) {
             sendTelemetry();
@@ -3,7 +3,10 @@
 #include "MeshService.h"
 #if ARCH_PORTDUINO
 #include "PortduinoGlue.h"
+#include <dirent.h>
+#include <fcntl.h>
 #include <filesystem>
+#include <unistd.h>
 #endif
 
 int32_t HostMetricsModule::runOnce()
@@ -69,46 +72,103 @@ meshtastic_MeshPacket *HostMetricsModule::allocReply()
     */
 
 #if ARCH_PORTDUINO
+/// Read a procfs file from the start into buf, null terminated.  fd is opened on first use and kept
+static bool readProc(int &fd, const char *path, char *buf, size_t size)
+{
+    if (fd < 0)
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    ssize_t n = pread(fd, buf, size - 1, 0);
+    if (n <= 0)
+        return false;
+    buf[n] = '\0';
+    return true;
+}
+
+/// The next unsigned number in s, s is left after it
+static uint64_t parseNumber(const char *&s)
+{
+    while (*s && (*s < '0' || *s > '9'))
+        s++;
+    uint64_t v = 0;
+    while (*s >= '0' && *s <= '9')
+        v = v * 10 + (*s++ - '0');
+    return v;
+}
+
+/// The next decimal number in s times 100, as /proc/loadavg has them ("0.52" is 52)
+static uint32_t parseHundredths(const char *&s)
+{
+    uint32_t v = parseNumber(s) * 100;
+    if (*s == '.') {
+        s++;
+        if (*s >= '0' && *s <= '9')
+            v += (*s++ - '0') * 10;
+        if (*s >= '0' && *s <= '9')
+            v += *s++ - '0';
+    }
+    return v;
+}
+
+/// The number following key (e.g. "MemAvailable:") in a procfs file of "key value" lines, 0 if it's not there
+static uint64_t parseField(const char *buf, const char *key)
+{
+    const char *s = strstr(buf, key);
+    if (!s)
+        return 0;
+    s += strlen(key);
+    return parseNumber(s);
+}
+
+/// utime + stime in clock ticks from a /proc/.../stat line, and the thread name in comm
+static uint64_t parseStatTicks(const char *buf, char *comm, size_t commSize)
+{
+    const char *nameStart = strchr(buf, '(');
+    const char *nameEnd = strrchr(buf, ')'); // The name may contain ')' itself
+    if (!nameStart || !nameEnd)
+        return 0;
+    if (comm) {
+        size_t len = std::min((size_t)(nameEnd - nameStart - 1), commSize - 1);
+        memcpy(comm, nameStart + 1, len);
+        comm[len] = '\0';
+    }
+    // After the name: state, then utime and stime are the 12th and 13th fields
+    const char *s = nameEnd + 2;
+    for (int field = 0; field < 11 && *s; field++) {
+        s = strchr(s, ' ');
+        if (!s)
+            return 0;
+        s++;
+    }
+    uint64_t utime = parseNumber(s);
+    uint64_t stime = parseNumber(s);
+    return utime + stime;
+}
+
 meshtastic_Telemetry HostMetricsModule::getHostMetrics()
 {
-    std::string file_line;
+    char buf[4096];
     meshtastic_Telemetry t = meshtastic_Telemetry_init_zero;
     t.which_variant = meshtastic_Telemetry_host_metrics_tag;
     t.variant.host_metrics = meshtastic_HostMetrics_init_zero;
 
-    if (access("/proc/uptime", R_OK) == 0) {
-        std::ifstream proc_uptime("/proc/uptime");
-        if (proc_uptime.is_open()) {
-            std::getline(proc_uptime, file_line, ' ');
-            proc_uptime.close();
-            t.variant.host_metrics.uptime_seconds = stoul(file_line);
-        }
+    if (readProc(uptimeFd, "/proc/uptime", buf, sizeof(buf))) {
+        const char *s = buf;
+        t.variant.host_metrics.uptime_seconds = parseNumber(s);
     }
 
     std::filesystem::space_info root = std::filesystem::space("/");
     t.variant.host_metrics.diskfree1_bytes = root.available;
 
-    if (access("/proc/meminfo", R_OK) == 0) {
-        std::ifstream proc_meminfo("/proc/meminfo");
-        if (proc_meminfo.is_open()) {
-            do {
-                std::getline(proc_meminfo, file_line);
-            } while (file_line.find("MemAvailable") == std::string::npos);
-            proc_meminfo.close();
-            t.variant.host_metrics.freemem_bytes = stoull(file_line.substr(file_line.find_first_of("0123456789"))) * 1024;
-        }
-    }
-    if (access("/proc/loadavg", R_OK) == 0) {
-        std::ifstream proc_loadavg("/proc/loadavg");
-        if (proc_loadavg.is_open()) {
-            std::getline(proc_loadavg, file_line, ' ');
-            t.variant.host_metrics.load1 = stof(file_line) * 100;
-            std::getline(proc_loadavg, file_line, ' ');
-            t.variant.host_metrics.load5 = stof(file_line) * 100;
-            std::getline(proc_loadavg, file_line, ' ');
-            t.variant.host_metrics.load15 = stof(file_line) * 100;
-            proc_loadavg.close();
-        }
+    if (readProc(meminfoFd, "/proc/meminfo", buf, sizeof(buf)))
+        t.variant.host_metrics.freemem_bytes = parseField(buf, "MemAvailable:") * 1024;
+
+    if (readProc(loadavgFd, "/proc/loadavg", buf, sizeof(buf))) {
+        const char *s = buf;
+        t.variant.host_metrics.load1 = parseHundredths(s);
+        t.variant.host_metrics.load5 = parseHundredths(s);
+        t.variant.host_metrics.load15 = parseHundredths(s);
     }
     if (settingsStrings[hostMetrics_user_command] != "") {
         std::string userCommandResult = exec(settingsStrings[hostMetrics_user_command].c_str());
@@ -121,6 +181,46 @@ meshtastic_Telemetry HostMetricsModule::getHostMetrics()
     return t;
 }
 
+/**
+ * Log what meshtasticd itself uses: CPU time per thread and in total, resident memory and disk I/O.  HostMetrics has no fields
+ * for these, so they are only logged, next to each host metrics send.
+ */
+void HostMetricsModule::logProcessFootprint()
+{
+    char buf[4096];
+    const long ticksPerSec = sysconf(_SC_CLK_TCK);
+
+    uint64_t cpuTicks = readProc(selfStatFd, "/proc/self/stat", buf, sizeof(buf)) ? parseStatTicks(buf, NULL, 0) : 0;
+    uint64_t rssKb = readProc(selfStatusFd, "/proc/self/status", buf, sizeof(buf)) ? parseField(buf, "VmRSS:") : 0;
+    uint64_t readBytes = 0, writeBytes = 0;
+    if (readProc(selfIoFd, "/proc/self/io", buf, sizeof(buf))) {
+        readBytes = parseField(buf, "\nread_bytes:");
+        writeBytes = parseField(buf, "\nwrite_bytes:");
+    }
+    LOG_INFO("meshtasticd: cpu=%.2fs, rss=%luKB, disk read=%lu, written=%lu", (double)cpuTicks / ticksPerSec, (unsigned long)rssKb,
+             (unsigned long)readBytes, (unsigned long)writeBytes);
+
+    // Threads come and go, so these are opened each time
+    DIR *tasks = opendir("/proc/self/task");
+    if (!tasks)
+        return;
+    while (struct dirent *task = readdir(tasks)) {
+        if (task->d_name[0] < '0' || task->d_name[0] > '9')
+            continue;
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/self/task/%s/stat", task->d_name);
+        int fd = -1;
+        char comm[32];
+        if (readProc(fd, path, buf, sizeof(buf))) {
+            uint64_t ticks = parseStatTicks(buf, comm, sizeof(comm));
+            LOG_DEBUG("  thread %s (%s): cpu=%.2fs", task->d_name, comm, (double)ticks / ticksPerSec);
+        }
+        if (fd >= 0)
+            close(fd);
+    }
+    closedir(tasks);
+}
+
 bool HostMetricsModule::sendMetrics()
 {
     meshtastic_Telemetry telemetry = getHostMetrics();
@@ -130,6 +230,7 @@ bool HostMetricsModule::sendMetrics()
              static_cast<float>(telemetry.variant.host_metrics.load5) / 100,
              static_cast<float>(telemetry.variant.host_metrics.load15) / 100);
     // telemetry.variant.host_metrics.has_user_string ? telemetry.variant.host_metrics.user_string : "");
+    logProcessFootprint();
 
     meshtastic_MeshPacket *p = allocDataProtobuf(telemetry);
     p->to = NODENUM_BROADCAST;
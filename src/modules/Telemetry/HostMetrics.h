@@ -33,6 +33,13 @@ class HostMetricsModule : private concurrency::OSThread, public ProtobufModule<m
 
   private:
     meshtastic_Telemetry getHostMetrics();
+#if ARCH_PORTDUINO
+    void logProcessFootprint();
+
+    // The procfs files read every interval stay open, and are read again from the start with pread
+    int uptimeFd = -1, meminfoFd = -1, loadavgFd = -1;
+    int selfStatFd = -1, selfStatusFd = -1, selfIoFd = -1;
+#endif
 
     uint32_t lastSentToMesh = 0;
     uint32_t uptimeWrapCount;
@@ -52,7 +52,8 @@ int32_t PowerTelemetryModule::runOnce()
     }
 
     uint32_t sendToMeshIntervalMs = Default::getConfiguredOrDefaultMsScaled(
-        moduleConfig.telemetry.power_update_interval, default_telemetry_broadcast_interval_secs, numOnlineNodes);
+        moduleConfig.telemetry.power_update_interval, default_telemetry_broadcast_interval_secs, numOnlineNodes,
+        meshtastic_PortNum_TELEMETRY_APP);
 
     if (firstTime) {
         // This is the first time the OSThread library has called this function, so do some setup
@@ -98,8 +99,16 @@ int32_t PowerTelemetryModule::runOnce()
             sendTelemetry(NODENUM_BROADCAST, true);
             lastSentToPhone = millis();
         }
+
+        if (batch.wantSample()) {
+            meshtastic_Telemetry m = meshtastic_Telemetry_init_zero;
+            m.which_variant = meshtastic_Telemetry_power_metrics_tag;
+            m.time = getTime();
+            if (getPowerTelemetry(&m))
+                batch.add(m);
+        }
     }
-    return min(sendToPhoneIntervalMs, sendToMeshIntervalMs);
+    return min(min(sendToPhoneIntervalMs, sendToMeshIntervalMs), batch.msUntilNextSample());
 }
 
 bool PowerTelemetryModule::wantUIFrame()
@@ -176,6 +185,10 @@ bool PowerTelemetryModule::handleReceivedProtobuf(const meshtastic_MeshPacket &m
                  sender, t->variant.power_metrics.ch1_voltage, t->variant.power_metrics.ch1_current,
                  t->variant.power_metrics.ch2_voltage, t->variant.power_metrics.ch2_current, t->variant.power_metrics.ch3_voltage,
                  t->variant.power_metrics.ch3_current);
+
+        size_t batched = TelemetryBatch::forEachSample(mp, *t, [](const meshtastic_Telemetry &) {});
+        if (batched)
+            LOG_INFO("(Received from %s): %u earlier samples", sender, (unsigned)batched);
 #endif
         // release previous packet before occupying a new spot
         if (lastMeasurementPacket != nullptr)
@@ -269,6 +282,7 @@ bool PowerTelemetryModule::sendTelemetry(NodeNum dest, bool phoneOnly)
             service->sendToPhone(p);
         } else {
             LOG_INFO("Send packet to mesh");
+            batch.sendWith(p, m);
             service->sendToMesh(p, RX_SRC_LOCAL, true);
 
             if (config.device.role == meshtastic_Config_DeviceConfig_Role_SENSOR && config.power.is_power_saving) {
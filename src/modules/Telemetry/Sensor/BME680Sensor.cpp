@@ -76,7 +76,7 @@ bool BME680Sensor::getMetrics(meshtastic_Telemetry *measurement)
 void BME680Sensor::loadState()
 {
 #ifdef FSCom
-    spiLock->lock();
+    fsLock->lock();
     auto file = FSCom.open(bsecConfigFileName, FILE_O_READ);
     if (file) {
         file.read((uint8_t *)&bsecState, BSEC_MAX_STATE_BLOB_SIZE);
@@ -86,7 +86,7 @@ void BME680Sensor::loadState()
     } else {
         LOG_INFO("No %s state found (File: %s)", sensorName, bsecConfigFileName);
     }
-    spiLock->unlock();
+    fsLock->unlock();
 #else
     LOG_ERROR("ERROR: Filesystem not implemented");
 #endif
@@ -95,7 +95,7 @@ void BME680Sensor::loadState()
 void BME680Sensor::updateState()
 {
 #ifdef FSCom
-    spiLock->lock();
+    fsLock->lock();
     bool update = false;
     if (stateUpdateCounter == 0) {
         /* First state update when IAQ accuracy is >= 3 */
@@ -127,11 +127,12 @@ void BME680Sensor::updateState()
             file.write((uint8_t *)&bsecState, BSEC_MAX_STATE_BLOB_SIZE);
             file.flush();
             file.close();
+            invalidateFileManifest();
         } else {
             LOG_INFO("Can't write %s state (File: %s)", sensorName, bsecConfigFileName);
         }
     }
-    spiLock->unlock();
+    fsLock->unlock();
 #else
     LOG_ERROR("ERROR: Filesystem not implemented");
 #endif
@@ -7,6 +7,18 @@
 #include "TelemetrySensor.h"
 #include <spo2_algorithm.h>
 
+static constexpr uint8_t SAMPLE_AVERAGE = 4; // 1, 2, 4, 8, 16, 32
+static constexpr uint16_t SAMPLE_RATE = 100; // 50, 100, 200, 400, 800, 1000, 1600, 3200
+
+// Samples reach the FIFO at SAMPLE_RATE / SAMPLE_AVERAGE a second, 32 fit before the oldest are overwritten
+static constexpr uint32_t SAMPLE_MSEC = 1000 * SAMPLE_AVERAGE / SAMPLE_RATE;
+static constexpr size_t FIFO_DEPTH = 32;
+static constexpr size_t FIFO_POLL_SAMPLES = 24; // read the FIFO when about this many are in, well before it fills
+
+static constexpr uint8_t REG_FIFO_DATA = 0x07;
+static constexpr size_t SAMPLE_BYTES = 6;  // red then IR, 3 bytes each, most significant first
+static constexpr size_t BURST_SAMPLES = 5; // per I2C read, Wire buffers 32 bytes
+
 MAX30102Sensor::MAX30102Sensor() : TelemetrySensor(meshtastic_TelemetrySensorType_MAX30102, "MAX30102") {}
 
 int32_t MAX30102Sensor::runOnce()
@@ -19,15 +31,13 @@ int32_t MAX30102Sensor::runOnce()
     if (max30102.begin(*nodeTelemetrySensorsMap[sensorType].second, _speed, nodeTelemetrySensorsMap[sensorType].first) ==
         true) // MAX30102 init
     {
-        byte brightness = 60;   // 0=Off to 255=50mA
-        byte sampleAverage = 4; // 1, 2, 4, 8, 16, 32
-        byte leds = 2;          // 1 = Red only, 2 = Red + IR
-        byte sampleRate = 100;  // 50, 100, 200, 400, 800, 1000, 1600, 3200
-        int pulseWidth = 411;   // 69, 118, 215, 411
-        int adcRange = 4096;    // 2048, 4096, 8192, 16384
+        byte brightness = 60; // 0=Off to 255=50mA
+        byte leds = 2;        // 1 = Red only, 2 = Red + IR; readFifo() expects both
+        int pulseWidth = 411; // 69, 118, 215, 411
+        int adcRange = 4096;  // 2048, 4096, 8192, 16384
 
         max30102.enableDIETEMPRDY(); // Enable the temperature ready interrupt
-        max30102.setup(brightness, sampleAverage, leds, sampleRate, pulseWidth, adcRange);
+        max30102.setup(brightness, SAMPLE_AVERAGE, leds, SAMPLE_RATE, pulseWidth, adcRange);
         LOG_DEBUG("MAX30102 Init Succeed");
         status = true;
     } else {
@@ -39,6 +49,39 @@ int32_t MAX30102Sensor::runOnce()
 
 void MAX30102Sensor::setup() {}
 
+size_t MAX30102Sensor::readFifo(uint32_t *red, uint32_t *ir, size_t want)
+{
+    TwoWire *bus = nodeTelemetrySensorsMap[sensorType].second;
+    uint8_t address = nodeTelemetrySensorsMap[sensorType].first;
+
+    size_t waiting = (max30102.getWritePointer() - max30102.getReadPointer()) & (FIFO_DEPTH - 1);
+    if (waiting > want)
+        waiting = want; // the rest stay for next time
+
+    // Reading FIFO_DATA over and over walks the read pointer through the samples
+    size_t got = 0;
+    while (got < waiting) {
+        size_t burst = waiting - got < BURST_SAMPLES ? waiting - got : BURST_SAMPLES;
+        bus->beginTransmission(address);
+        bus->write(REG_FIFO_DATA);
+        bus->endTransmission();
+        if (bus->requestFrom(address, (uint8_t)(burst * SAMPLE_BYTES)) != burst * SAMPLE_BYTES)
+            break;
+        for (size_t i = 0; i < burst; i++, got++) {
+            uint32_t v[2];
+            for (uint32_t &led : v) {
+                led = (uint32_t)bus->read() << 16;
+                led |= (uint32_t)bus->read() << 8;
+                led |= bus->read();
+                led &= 0x3FFFF; // 18 bit samples
+            }
+            red[got] = v[0];
+            ir[got] = v[1];
+        }
+    }
+    return got;
+}
+
 bool MAX30102Sensor::getMetrics(meshtastic_Telemetry *measurement)
 {
     uint32_t ir_buff[MAX30102_BUFFER_LEN];
@@ -53,13 +96,22 @@ bool MAX30102Sensor::getMetrics(meshtastic_Telemetry *measurement)
     measurement->variant.environment_metrics.has_temperature = true;
     measurement->variant.health_metrics.temperature = temp;
     measurement->variant.health_metrics.has_temperature = true;
-    for (byte i = 0; i < MAX30102_BUFFER_LEN; i++) {
-        while (max30102.available() == false)
-            max30102.check();
 
-        red_buff[i] = max30102.getRed();
-        ir_buff[i] = max30102.getIR();
-        max30102.nextSample();
+    // Drop what the FIFO kept since the last measurement, it would put a gap in the middle of the block
+    max30102.clearFIFO();
+
+    // Let the FIFO fill between burst reads, rather than asking the sensor for a sample at a time until one is ready
+    size_t got = 0;
+    uint8_t idle = 0;
+    while (got < MAX30102_BUFFER_LEN) {
+        size_t want = MAX30102_BUFFER_LEN - got;
+        delay((want < FIFO_POLL_SAMPLES ? want : FIFO_POLL_SAMPLES) * SAMPLE_MSEC);
+        size_t n = readFifo(red_buff + got, ir_buff + got, want);
+        if (n == 0 && ++idle > 2) {
+            LOG_WARN("MAX30102 stopped sampling");
+            return false;
+        }
+        got += n;
     }
 
     maxim_heart_rate_and_oxygen_saturation(ir_buff, MAX30102_BUFFER_LEN, red_buff, &spo2, &spo2_valid, &heart_rate,
@@ -75,7 +127,7 @@ bool MAX30102Sensor::getMetrics(meshtastic_Telemetry *measurement)
         measurement->variant.health_metrics.has_spO2 = true;
         measurement->variant.health_metrics.spO2 = spo2;
     } else {
-        measurement->variant.health_metrics.has_spO2 = true;
+        measurement->variant.health_metrics.has_spO2 = false;
     }
     return true;
 }
@@ -14,6 +14,12 @@ class MAX30102Sensor : public TelemetrySensor
     MAX30105 max30102 = MAX30105();
     uint32_t _speed = 200000UL;
 
+    /**
+     * Burst read whatever samples wait in the sensor's FIFO, up to want of them, into red and ir
+     * @return how many were read
+     */
+    size_t readFifo(uint32_t *red, uint32_t *ir, size_t want);
+
   protected:
     virtual void setup() override;
 
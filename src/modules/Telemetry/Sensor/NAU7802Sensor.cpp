@@ -34,10 +34,19 @@ int32_t NAU7802Sensor::runOnce()
 
 void NAU7802Sensor::setup() {}
 
+uint32_t NAU7802Sensor::startMeasurement()
+{
+    nau7802.powerUp();
+    measuring = true;
+    return 100;
+}
+
 bool NAU7802Sensor::getMetrics(meshtastic_Telemetry *measurement)
 {
     LOG_DEBUG("NAU7802 getMetrics");
-    nau7802.powerUp();
+    if (!measuring)
+        nau7802.powerUp();
+    measuring = false;
     // Wait for the sensor to become ready for one second max
     uint32_t start = millis();
     while (!nau7802.available()) {
@@ -112,16 +121,16 @@ bool NAU7802Sensor::saveCalibrationData()
     } else {
         okay = true;
     }
-    spiLock->lock();
+    fsLock->lock();
     okay &= file.close();
-    spiLock->unlock();
+    fsLock->unlock();
 
     return okay;
 }
 
 bool NAU7802Sensor::loadCalibrationData()
 {
-    spiLock->lock();
+    fsLock->lock();
     auto file = FSCom.open(nau7802ConfigFileName, FILE_O_READ);
     bool okay = false;
     if (file) {
@@ -138,7 +147,7 @@ bool NAU7802Sensor::loadCalibrationData()
     } else {
         LOG_INFO("No %s state found (File: %s)", sensorName, nau7802ConfigFileName);
     }
-    spiLock->unlock();
+    fsLock->unlock();
     return okay;
 }
 
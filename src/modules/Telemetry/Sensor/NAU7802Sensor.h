@@ -11,6 +11,7 @@ class NAU7802Sensor : public TelemetrySensor
 {
   private:
     NAU7802 nau7802;
+    bool measuring = false; // powered up by startMeasurement()
 
   protected:
     virtual void setup() override;
@@ -21,6 +22,8 @@ class NAU7802Sensor : public TelemetrySensor
   public:
     NAU7802Sensor();
     virtual int32_t runOnce() override;
+    virtual uint32_t startMeasurement() override;
+    virtual bool isMeasurementReady() override { return nau7802.available(); }
     virtual bool getMetrics(meshtastic_Telemetry *measurement) override;
     void tare();
     void calibrate(float weight);
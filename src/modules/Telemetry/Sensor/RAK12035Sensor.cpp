@@ -3,6 +3,7 @@
 
 #include "../mesh/generated/meshtastic/telemetry.pb.h"
 #include "RAK12035Sensor.h"
+#include <Throttle.h>
 
 RAK12035Sensor::RAK12035Sensor() : TelemetrySensor(meshtastic_TelemetrySensorType_RAK12035, "RAK12035") {}
 
@@ -75,6 +76,19 @@ void RAK12035Sensor::setup()
     LOG_INFO("Wet calibration value is %d", hundred_val);
 }
 
+uint32_t RAK12035Sensor::startMeasurement()
+{
+    sensor.sensor_on();
+    sensorOnMs = millis();
+    measuring = true;
+    return WAKE_MS;
+}
+
+bool RAK12035Sensor::isMeasurementReady()
+{
+    return !measuring || !Throttle::isWithinTimespanMs(sensorOnMs, WAKE_MS);
+}
+
 bool RAK12035Sensor::getMetrics(meshtastic_Telemetry *measurement)
 {
     // TODO:: read and send metrics for up to 2 additional soil monitors if present.
@@ -89,8 +103,14 @@ bool RAK12035Sensor::getMetrics(meshtastic_Telemetry *measurement)
     uint16_t temp = 0;
     bool success = false;
 
-    sensor.sensor_on();
-    delay(200);
+    if (!measuring) {
+        sensor.sensor_on();
+        sensorOnMs = millis();
+    }
+    measuring = false;
+    uint32_t elapsed = millis() - sensorOnMs;
+    if (elapsed < WAKE_MS)
+        delay(WAKE_MS - elapsed);
     success = sensor.get_sensor_moisture(&moisture);
     delay(200);
     success &= sensor.get_sensor_temperature(&temp);
@@ -16,6 +16,9 @@ class RAK12035Sensor : public TelemetrySensor
 {
   private:
     RAK12035 sensor;
+    uint32_t sensorOnMs = 0;
+    bool measuring = false; // switched on by startMeasurement()
+    static constexpr uint32_t WAKE_MS = 200;
 
   protected:
     virtual void setup() override;
@@ -23,6 +26,8 @@ class RAK12035Sensor : public TelemetrySensor
   public:
     RAK12035Sensor();
     virtual int32_t runOnce() override;
+    virtual uint32_t startMeasurement() override;
+    virtual bool isMeasurementReady() override;
     virtual bool getMetrics(meshtastic_Telemetry *measurement) override;
 };
 #endif
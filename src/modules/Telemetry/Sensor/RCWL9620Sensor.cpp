@@ -5,6 +5,7 @@
 #include "../mesh/generated/meshtastic/telemetry.pb.h"
 #include "RCWL9620Sensor.h"
 #include "TelemetrySensor.h"
+#include <Throttle.h>
 
 RCWL9620Sensor::RCWL9620Sensor() : TelemetrySensor(meshtastic_TelemetrySensorType_RCWL9620, "RCWL9620") {}
 
@@ -21,6 +22,19 @@ int32_t RCWL9620Sensor::runOnce()
 
 void RCWL9620Sensor::setup() {}
 
+uint32_t RCWL9620Sensor::startMeasurement()
+{
+    startDistance();
+    measureStartMs = millis();
+    measuring = true;
+    return MEASURE_MS;
+}
+
+bool RCWL9620Sensor::isMeasurementReady()
+{
+    return !measuring || !Throttle::isWithinTimespanMs(measureStartMs, MEASURE_MS);
+}
+
 bool RCWL9620Sensor::getMetrics(meshtastic_Telemetry *measurement)
 {
     measurement->variant.environment_metrics.has_distance = true;
@@ -39,18 +53,30 @@ void RCWL9620Sensor::begin(TwoWire *wire, uint8_t addr, uint8_t sda, uint8_t scl
     _wire->begin();
 }
 
-float RCWL9620Sensor::getDistance()
+void RCWL9620Sensor::startDistance()
 {
-    uint32_t data = 0;
-    uint8_t b1 = 0, b2 = 0, b3 = 0;
-
     LOG_DEBUG("[RCWL9620] Start measure command");
 
     _wire->beginTransmission(_addr);
     _wire->write(0x01); // À tester aussi sans cette ligne si besoin
     uint8_t result = _wire->endTransmission();
     LOG_DEBUG("[RCWL9620] endTransmission result = %d", result);
-    delay(100); // délai pour laisser le capteur répondre
+}
+
+float RCWL9620Sensor::getDistance()
+{
+    uint32_t data = 0;
+    uint8_t b1 = 0, b2 = 0, b3 = 0;
+
+    if (!measuring) {
+        startDistance();
+        measureStartMs = millis();
+    }
+    measuring = false;
+    // délai pour laisser le capteur répondre
+    uint32_t elapsed = millis() - measureStartMs;
+    if (elapsed < MEASURE_MS)
+        delay(MEASURE_MS - elapsed);
 
     LOG_DEBUG("[RCWL9620] Read i2c data:");
     _wire->requestFrom(_addr, (uint8_t)3);
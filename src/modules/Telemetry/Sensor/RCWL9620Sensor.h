@@ -14,15 +14,21 @@ class RCWL9620Sensor : public TelemetrySensor
     uint8_t _scl = -1;
     uint8_t _sda = -1;
     uint32_t _speed = 200000UL;
+    uint32_t measureStartMs = 0;
+    bool measuring = false; // started by startMeasurement()
+    static constexpr uint32_t MEASURE_MS = 100;
 
   protected:
     virtual void setup() override;
     void begin(TwoWire *wire = &Wire, uint8_t addr = 0x57, uint8_t sda = -1, uint8_t scl = -1, uint32_t speed = 200000UL);
+    void startDistance();
     float getDistance();
 
   public:
     RCWL9620Sensor();
     virtual int32_t runOnce() override;
+    virtual uint32_t startMeasurement() override;
+    virtual bool isMeasurementReady() override;
     virtual bool getMetrics(meshtastic_Telemetry *measurement) override;
 };
 
@@ -57,6 +57,17 @@ class TelemetrySensor
     virtual bool isInitialized() { return initialized; }
     virtual bool isRunning() { return status > 0; }
 
+    /**
+     * Start a measurement ahead of getMetrics(), for sensors that take a while to convert, so the caller can get on with
+     * other work rather than getMetrics() waiting for the result.
+     * @return msecs until the result should be ready, 0 if there is nothing to wait for
+     */
+    virtual uint32_t startMeasurement() { return 0; }
+
+    /// Whether getMetrics() can read the measurement startMeasurement() started without waiting
+    virtual bool isMeasurementReady() { return true; }
+
+    /// Read the sensor. If no measurement was started, or it isn't ready yet, this waits for one.
     virtual bool getMetrics(meshtastic_Telemetry *measurement) = 0;
 };
 
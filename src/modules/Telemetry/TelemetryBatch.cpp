@@ -0,0 +1,377 @@
+#include "TelemetryBatch.h"
+#include "MeshService.h"
+#include "Router.h"
+#include "mesh-pb-constants.h"
+#include <Throttle.h>
+#include <math.h>
+#include <pb_common.h>
+
+static const uint8_t BATCH_VERSION = 1;
+// Field key and length (2 bytes each at most at these sizes), version and count
+static const size_t BATCH_OVERHEAD = 2 + 2 + 1 + 2;
+
+static size_t putVarint(uint8_t *out, uint64_t v)
+{
+    size_t n = 0;
+    do {
+        uint8_t b = v & 0x7f;
+        v >>= 7;
+        out[n++] = b | (v ? 0x80 : 0);
+    } while (v);
+    return n;
+}
+
+static size_t varintSize(uint64_t v)
+{
+    size_t n = 1;
+    while (v >>= 7)
+        n++;
+    return n;
+}
+
+static bool getVarint(const uint8_t *&p, const uint8_t *end, uint64_t &v)
+{
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t b = *p++;
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static uint64_t zigzag(int64_t v)
+{
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v)
+{
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+int32_t TelemetryBatch::Sample::get(uint8_t tag) const
+{
+    for (uint8_t i = 0; i < count; i++)
+        if (values[i].tag == tag)
+            return values[i].v;
+    return 0;
+}
+
+bool TelemetryBatch::wantSample() const
+{
+    return enabled() && !Throttle::isWithinTimespanMs(lastSampleMs, TELEMETRY_BATCH_SAMPLE_SECS * 1000UL);
+}
+
+uint32_t TelemetryBatch::msUntilNextSample() const
+{
+    if (!enabled())
+        return UINT32_MAX;
+    uint32_t since = millis() - lastSampleMs;
+    return since >= TELEMETRY_BATCH_SAMPLE_SECS * 1000UL ? 0 : TELEMETRY_BATCH_SAMPLE_SECS * 1000UL - since;
+}
+
+const pb_msgdesc_t *TelemetryBatch::metricsFields(pb_size_t variant)
+{
+    switch (variant) {
+    case meshtastic_Telemetry_environment_metrics_tag:
+        return meshtastic_EnvironmentMetrics_fields;
+    case meshtastic_Telemetry_power_metrics_tag:
+        return meshtastic_PowerMetrics_fields;
+    case meshtastic_Telemetry_air_quality_metrics_tag:
+        return meshtastic_AirQualityMetrics_fields;
+    default:
+        return NULL;
+    }
+}
+
+// The metrics of t that are set, as they are batched.  These variants only have optional floats and uint32s.
+void TelemetryBatch::quantize(const meshtastic_Telemetry &t, Sample &s)
+{
+    s.time = t.time;
+    s.count = 0;
+    const pb_msgdesc_t *fields = metricsFields(t.which_variant);
+    pb_field_iter_t it;
+    if (!fields || !pb_field_iter_begin(&it, fields, (void *)&t.variant))
+        return;
+    do {
+        if (PB_HTYPE(it.type) != PB_HTYPE_OPTIONAL || !*(const bool *)it.pSize || s.count >= TELEMETRY_BATCH_MAX_FIELDS)
+            continue;
+        int64_t v;
+        if (PB_LTYPE(it.type) == PB_LTYPE_FIXED32 && it.data_size == sizeof(float))
+            v = llroundf(*(const float *)it.pData * 100);
+        else if (PB_LTYPE(it.type) == PB_LTYPE_UVARINT && it.data_size == sizeof(uint32_t))
+            v = *(const uint32_t *)it.pData;
+        else
+            continue;
+        s.values[s.count].tag = it.tag;
+        s.values[s.count].v = v > INT32_MAX ? INT32_MAX : (v < INT32_MIN ? INT32_MIN : v);
+        s.count++;
+    } while (pb_field_iter_next(&it));
+}
+
+void TelemetryBatch::toTelemetry(const Sample &s, pb_size_t variant, meshtastic_Telemetry &t)
+{
+    memset(&t, 0, sizeof(t));
+    t.which_variant = variant;
+    t.time = s.time;
+    const pb_msgdesc_t *fields = metricsFields(variant);
+    pb_field_iter_t it;
+    if (!fields || !pb_field_iter_begin(&it, fields, &t.variant))
+        return;
+    for (uint8_t i = 0; i < s.count; i++) {
+        if (!pb_field_iter_find(&it, s.values[i].tag) || PB_HTYPE(it.type) != PB_HTYPE_OPTIONAL)
+            continue;
+        if (PB_LTYPE(it.type) == PB_LTYPE_FIXED32 && it.data_size == sizeof(float))
+            *(float *)it.pData = s.values[i].v / 100.0f;
+        else if (PB_LTYPE(it.type) == PB_LTYPE_UVARINT && it.data_size == sizeof(uint32_t))
+            *(uint32_t *)it.pData = s.values[i].v;
+        else
+            continue;
+        *(bool *)it.pSize = true;
+    }
+}
+
+size_t TelemetryBatch::encodedSize(const Sample &s, pb_size_t variant)
+{
+    meshtastic_Telemetry t;
+    toTelemetry(s, variant, t);
+    size_t size = 0;
+    pb_get_encoded_size(&size, meshtastic_Telemetry_fields, &t);
+    return size;
+}
+
+// [varint seconds before ref][varint tag, zigzag varint change from ref]...[0]
+// @return the length written, out may be NULL to just measure it
+size_t TelemetryBatch::writeDelta(const Sample &s, const Sample &ref, uint8_t *out)
+{
+    size_t len = 0;
+    auto put = [&](uint64_t v) { len += out ? putVarint(out + len, v) : varintSize(v); };
+    put(ref.time >= s.time ? ref.time - s.time : 0);
+    for (uint8_t i = 0; i < s.count; i++) {
+        put(s.values[i].tag);
+        put(zigzag((int64_t)s.values[i].v - ref.get(s.values[i].tag)));
+    }
+    put(0);
+    return len;
+}
+
+std::vector<uint16_t> TelemetryBatch::offsets() const
+{
+    std::vector<uint16_t> result;
+    for (size_t i = 0; i < records.size(); i += 1 + records[i])
+        result.push_back(i);
+    return result;
+}
+
+void TelemetryBatch::read(uint16_t offset, Sample &s) const
+{
+    const uint8_t *p = &records[offset + 1];
+    const uint8_t *end = p + records[offset];
+    s.time = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    p += 4;
+    s.count = 0;
+    uint64_t tag, v;
+    while (s.count < TELEMETRY_BATCH_MAX_FIELDS && getVarint(p, end, tag) && getVarint(p, end, v)) {
+        s.values[s.count].tag = tag;
+        s.values[s.count].v = unzigzag(v);
+        s.count++;
+    }
+}
+
+void TelemetryBatch::add(const meshtastic_Telemetry &t)
+{
+    lastSampleMs = millis();
+    Sample s;
+    quantize(t, s);
+
+    uint8_t rec[1 + 4 + TELEMETRY_BATCH_MAX_FIELDS * (2 + 5)];
+    size_t len = 1;
+    for (int i = 0; i < 4; i++)
+        rec[len++] = s.time >> (8 * i);
+    for (uint8_t i = 0; i < s.count; i++) {
+        len += putVarint(rec + len, s.values[i].tag);
+        len += putVarint(rec + len, zigzag(s.values[i].v));
+    }
+    rec[0] = len - 1;
+
+    // Make room by forgetting the oldest samples
+    size_t drop = 0;
+    while (drop < records.size() && records.size() - drop + len > TELEMETRY_BATCH_BUFFER_BYTES)
+        drop += 1 + records[drop];
+    if (drop) {
+        LOG_WARN("Telemetry batch full, drop the oldest samples");
+        records.erase(records.begin(), records.begin() + drop);
+    }
+    records.insert(records.end(), rec, rec + len);
+}
+
+void TelemetryBatch::appendBatch(meshtastic_Data_payload_t &payload, const uint8_t *body, size_t len, uint32_t count)
+{
+    uint8_t head[2 * 5 + 1 + 5];
+    size_t n = putVarint(head, (TELEMETRY_BATCH_FIELD << 3) | PB_WT_STRING);
+    size_t contentLen = 1 + varintSize(count) + len;
+    n += putVarint(head + n, contentLen);
+    head[n++] = BATCH_VERSION;
+    n += putVarint(head + n, count);
+    if (payload.size + n + len > sizeof(payload.bytes))
+        return; // Chunks are sized with room to spare, so this would be a bug
+    memcpy(payload.bytes + payload.size, head, n);
+    memcpy(payload.bytes + payload.size + n, body, len);
+    payload.size += n + len;
+}
+
+void TelemetryBatch::sendWith(meshtastic_MeshPacket *p, const meshtastic_Telemetry &latest)
+{
+    lastSampleMs = millis();
+    std::vector<uint16_t> offs = offsets();
+    size_t n = offs.size();
+    if (!n)
+        return;
+
+    Sample ref, s;
+    uint8_t body[TELEMETRY_BATCH_PAYLOAD_MAX];
+
+    // As many of the newest samples as fit go in p itself, each relative to the one after it
+    size_t inP = 0;
+    size_t size = p->decoded.payload.size + BATCH_OVERHEAD;
+    quantize(latest, ref);
+    while (inP < n) {
+        read(offs[n - 1 - inP], s);
+        size_t cost = writeDelta(s, ref, NULL);
+        if (size + cost > TELEMETRY_BATCH_PAYLOAD_MAX)
+            break;
+        size += cost;
+        ref = s;
+        inP++;
+    }
+
+    // The rest go first, oldest first, in packets carrying the newest of theirs the usual way
+    size_t first = 0, older = n - inP;
+    while (first < older) {
+        read(offs[first], s);
+        size_t last = first;
+        size_t deltas = 0;
+        while (last + 1 < older) {
+            Sample next, nextRef;
+            read(offs[last + 1], next);
+            meshtastic_Telemetry t;
+            toTelemetry(next, variant, t);
+            quantize(t, nextRef); // as the receiver will see it
+            size_t extra = writeDelta(s, nextRef, NULL);
+            if (encodedSize(next, variant) + BATCH_OVERHEAD + deltas + extra > TELEMETRY_BATCH_PAYLOAD_MAX)
+                break;
+            deltas += extra;
+            s = next;
+            last++;
+        }
+
+        // Sample last is the packet's own, then last - 1 down to first
+        meshtastic_Telemetry t;
+        toTelemetry(s, variant, t);
+        meshtastic_MeshPacket *q = packetPool.allocCopy(*p);
+        q->id = generatePacketId();
+        q->decoded.payload.size =
+            pb_encode_to_bytes(q->decoded.payload.bytes, sizeof(q->decoded.payload.bytes), &meshtastic_Telemetry_msg, &t);
+        quantize(t, ref);
+        size_t len = 0;
+        for (size_t i = last; i-- > first;) {
+            read(offs[i], s);
+            len += writeDelta(s, ref, body + len);
+            ref = s;
+        }
+        if (last > first)
+            appendBatch(q->decoded.payload, body, len, last - first);
+        LOG_INFO("Send %u earlier telemetry samples", (unsigned)(last - first + 1));
+        service->sendToMesh(q, RX_SRC_LOCAL, true);
+        first = last + 1;
+    }
+
+    quantize(latest, ref);
+    size_t len = 0;
+    for (size_t i = 0; i < inP; i++) {
+        read(offs[n - 1 - i], s);
+        len += writeDelta(s, ref, body + len);
+        ref = s;
+    }
+    if (inP)
+        appendBatch(p->decoded.payload, body, len, inP);
+    LOG_INFO("Batched %u telemetry samples with the latest", (unsigned)inP);
+    records.clear();
+}
+
+size_t TelemetryBatch::forEachSample(const meshtastic_MeshPacket &mp, const meshtastic_Telemetry &latest,
+                                     std::function<void(const meshtastic_Telemetry &)> f)
+{
+    if (mp.which_payload_variant != meshtastic_MeshPacket_decoded_tag || !metricsFields(latest.which_variant))
+        return 0;
+
+    // Look for our field among the top level ones
+    const uint8_t *p = mp.decoded.payload.bytes;
+    const uint8_t *end = p + mp.decoded.payload.size;
+    const uint8_t *body = NULL;
+    uint64_t key, v, bodyLen = 0;
+    while (p < end && getVarint(p, end, key)) {
+        switch (key & 7) {
+        case PB_WT_VARINT:
+            if (!getVarint(p, end, v))
+                return 0;
+            break;
+        case PB_WT_64BIT:
+            p += 8;
+            break;
+        case PB_WT_32BIT:
+            p += 4;
+            break;
+        case PB_WT_STRING:
+            if (!getVarint(p, end, v) || v > (uint64_t)(end - p))
+                return 0;
+            if ((key >> 3) == TELEMETRY_BATCH_FIELD) {
+                body = p;
+                bodyLen = v;
+            }
+            p += v;
+            break;
+        default:
+            return 0;
+        }
+    }
+    if (!body || bodyLen < 1 || body[0] != BATCH_VERSION)
+        return 0;
+
+    p = body + 1;
+    end = body + bodyLen;
+    uint64_t count;
+    if (!getVarint(p, end, count))
+        return 0;
+
+    Sample ref, s;
+    quantize(latest, ref);
+    size_t done = 0;
+    while (done < count) {
+        uint64_t before, tag;
+        if (!getVarint(p, end, before))
+            break;
+        s.time = ref.time - before;
+        s.count = 0;
+        bool okay = true;
+        while ((okay = getVarint(p, end, tag)) && tag) {
+            if (!(okay = getVarint(p, end, v)))
+                break;
+            if (s.count < TELEMETRY_BATCH_MAX_FIELDS) {
+                s.values[s.count].tag = tag;
+                s.values[s.count].v = ref.get(tag) + unzigzag(v);
+                s.count++;
+            }
+        }
+        if (!okay)
+            break;
+        meshtastic_Telemetry t;
+        toTelemetry(s, latest.which_variant, t);
+        f(t);
+        ref = s;
+        done++;
+    }
+    return done;
+}
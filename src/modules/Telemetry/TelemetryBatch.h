@@ -0,0 +1,101 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include "configuration.h"
+#include "mesh/generated/meshtastic/telemetry.pb.h"
+#include <functional>
+#include <vector>
+
+// Take a sample this often between transmissions and send them all with the next one. 0 (the default) sends one sample per
+// transmission as before.  E.g. 60 with an update interval of an hour sends 60 samples an hour in a few packets.
+#ifndef TELEMETRY_BATCH_SAMPLE_SECS
+#define TELEMETRY_BATCH_SAMPLE_SECS 0
+#endif
+
+// Most bytes of samples kept between transmissions, the oldest are dropped beyond this
+#ifndef TELEMETRY_BATCH_BUFFER_BYTES
+#define TELEMETRY_BATCH_BUFFER_BYTES 1536
+#endif
+
+// Most bytes of Telemetry payload in each packet, leaving room for the Data wrapper and encryption
+#ifndef TELEMETRY_BATCH_PAYLOAD_MAX
+#define TELEMETRY_BATCH_PAYLOAD_MAX 200
+#endif
+
+// Protobuf field number the earlier samples are sent in, after the regular Telemetry fields
+#define TELEMETRY_BATCH_FIELD 2047
+
+// Most metrics per sample, more than any Telemetry variant has
+#define TELEMETRY_BATCH_MAX_FIELDS 24
+
+/**
+ * Samples of one kind of telemetry (environment, power or air quality metrics) taken between transmissions.
+ *
+ * Each packet is still an ordinary Telemetry message carrying the newest of its samples, so nodes and apps that don't know
+ * about batching see the same as before.  The earlier samples follow in an extra field they skip: for each one the seconds
+ * before and the change of every metric from the sample after it, as varints.  Floats are sent in hundredths, so a batched
+ * sample is usually a byte or two per metric instead of a packet of its own.
+ *
+ * If the samples don't all fit in one packet the oldest are sent first, in packets of their own.
+ */
+class TelemetryBatch
+{
+  public:
+    /// @param variant the Telemetry variant tag this batch keeps, e.g. meshtastic_Telemetry_environment_metrics_tag
+    explicit TelemetryBatch(pb_size_t variant) : variant(variant) {}
+
+    static bool enabled() { return TELEMETRY_BATCH_SAMPLE_SECS != 0; }
+
+    /// Whether it is time to take another sample
+    bool wantSample() const;
+
+    /// msecs until wantSample() will be true, UINT32_MAX when batching is off
+    uint32_t msUntilNextSample() const;
+
+    /// Keep a sample, with t.time set, to send with the next packet
+    void add(const meshtastic_Telemetry &t);
+
+    size_t size() const { return offsets().size(); }
+
+    /**
+     * Send the samples kept so far along with p, the packet for the latest sample.  Whatever doesn't fit in p goes first,
+     * in copies of p.  Call just before p itself is sent.
+     */
+    void sendWith(meshtastic_MeshPacket *p, const meshtastic_Telemetry &latest);
+
+    /**
+     * Call f for each earlier sample mp carries, newest first
+     * @param latest mp decoded as a Telemetry
+     * @return how many there were
+     */
+    static size_t forEachSample(const meshtastic_MeshPacket &mp, const meshtastic_Telemetry &latest,
+                                std::function<void(const meshtastic_Telemetry &)> f);
+
+  private:
+    struct Value {
+        uint8_t tag;
+        int32_t v; // floats in hundredths
+    };
+
+    struct Sample {
+        uint32_t time = 0;
+        uint8_t count = 0;
+        Value values[TELEMETRY_BATCH_MAX_FIELDS];
+
+        int32_t get(uint8_t tag) const;
+    };
+
+    pb_size_t variant;
+    std::vector<uint8_t> records; // for each sample, [u8 length][u32 time][varint tag, zigzag varint value]...
+    uint32_t lastSampleMs = 0;
+
+    std::vector<uint16_t> offsets() const;
+    void read(uint16_t offset, Sample &s) const;
+
+    static const pb_msgdesc_t *metricsFields(pb_size_t variant);
+    static void quantize(const meshtastic_Telemetry &t, Sample &s);
+    static void toTelemetry(const Sample &s, pb_size_t variant, meshtastic_Telemetry &t);
+    static size_t encodedSize(const Sample &s, pb_size_t variant);
+    static size_t writeDelta(const Sample &s, const Sample &ref, uint8_t *out);
+    static void appendBatch(meshtastic_Data_payload_t &payload, const uint8_t *body, size_t len, uint32_t count);
+};
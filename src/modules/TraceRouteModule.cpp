@@ -1,5 +1,6 @@
 #include "TraceRouteModule.h"
 #include "MeshService.h"
+#include "RouteCache.h"
 #include "meshUtils.h"
 
 TraceRouteModule *traceRouteModule;
@@ -23,6 +24,10 @@ void TraceRouteModule::alterReceivedProtobuf(meshtastic_MeshPacket &p, meshtasti
         printRoute(r, p.from, p.to, true);
     else
         printRoute(r, p.to, p.from, false);
+#if ROUTES_FROM_TRACEROUTE
+    if (incoming.request_id)
+        learnRoutes(r, p.to, p.from);
+#endif
 
     // Set updated route to the payload of the to be flooded packet
     p.decoded.payload.size =
@@ -106,6 +111,35 @@ void TraceRouteModule::appendMyIDandSNR(meshtastic_RouteDiscovery *updated, floa
     }
 }
 
+#if ROUTES_FROM_TRACEROUTE
+void TraceRouteModule::learnRoutes(const meshtastic_RouteDiscovery *r, uint32_t origin, uint32_t dest)
+{
+    // Where we are on the forward route, -1 for the origin
+    NodeNum ourNum = nodeDB->getNodeNum();
+    int us = -2;
+    if (origin == ourNum) {
+        us = -1;
+    } else {
+        for (uint8_t i = 0; i < r->route_count; i++)
+            if (r->route[i] == ourNum)
+                us = i;
+    }
+    if (us == -2)
+        return; // The request didn't pass through us
+
+    // The hop after us, and the SNR it heard us with
+    uint8_t next = us + 1;
+    NodeNum via = next < r->route_count ? r->route[next] : dest;
+    float snr = (next < r->snr_towards_count && r->snr_towards[next] != INT8_MIN) ? (float)r->snr_towards[next] / 4 : 0;
+    if (via == NODENUM_BROADCAST)
+        return; // A node that couldn't decrypt the request, we don't know who it was
+
+    for (uint8_t i = next; i < r->route_count; i++)
+        router->learnRoute(r->route[i], via, snr);
+    router->learnRoute(dest, via, snr);
+}
+#endif
+
 void TraceRouteModule::printRoute(meshtastic_RouteDiscovery *r, uint32_t origin, uint32_t dest, bool isTowardsDestination)
 {
 #ifdef DEBUG_PORT
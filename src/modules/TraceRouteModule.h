@@ -31,6 +31,10 @@ class TraceRouteModule : public ProtobufModule<meshtastic_RouteDiscovery>
        Set origin to where the request came from.
        Set dest to the ID of its destination, or NODENUM_BROADCAST if it has not yet arrived there. */
     void printRoute(meshtastic_RouteDiscovery *r, uint32_t origin, uint32_t dest, bool isTowardsDestination);
+
+    /* Call with a reply to give the router the routes it proves: the request got from origin to dest along the forward route,
+       so if we are the origin or one of its hops, everything after us on it is reachable through the hop after us */
+    void learnRoutes(const meshtastic_RouteDiscovery *r, uint32_t origin, uint32_t dest);
 };
 
 extern TraceRouteModule *traceRouteModule;
\ No newline at end of file
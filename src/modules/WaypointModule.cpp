@@ -2,10 +2,10 @@
 #include "NodeDB.h"
 #include "PowerFSM.h"
 #include "configuration.h"
+#include "gps/RTC.h"
 #include "graphics/draw/CompassRenderer.h"
 
 #if HAS_SCREEN
-#include "gps/RTC.h"
 #include "graphics/Screen.h"
 #include "graphics/TimeFormatters.h"
 #include "graphics/draw/NodeListRenderer.h"
@@ -14,6 +14,22 @@
 
 WaypointModule *waypointModule;
 
+WaypointModule::WaypointModule() : SinglePortModule("waypoint", meshtastic_PortNum_WAYPOINT_APP)
+{
+    store.load(getTime());
+
+    // The last waypoint we heard, kept in the device state from before there was a store
+    if (devicestate.has_rx_waypoint) {
+        const meshtastic_MeshPacket &mp = devicestate.rx_waypoint;
+        meshtastic_Waypoint wp = meshtastic_Waypoint_init_zero;
+        if (pb_decode_from_bytes(mp.decoded.payload.bytes, mp.decoded.payload.size, &meshtastic_Waypoint_msg, &wp)) {
+            latestId = wp.id;
+            if (!store.get(wp.id) && store.add(wp, mp.from, mp.rx_time, getTime()))
+                store.save();
+        }
+    }
+}
+
 ProcessMessage WaypointModule::handleReceived(const meshtastic_MeshPacket &mp)
 {
 #ifdef DEBUG_PORT
@@ -25,6 +41,15 @@ ProcessMessage WaypointModule::handleReceived(const meshtastic_MeshPacket &mp)
     devicestate.rx_waypoint = mp;
     devicestate.has_rx_waypoint = true;
 
+    // Decoded once here, the screens look waypoints up in the store
+    meshtastic_Waypoint wp = meshtastic_Waypoint_init_zero;
+    if (pb_decode_from_bytes(mp.decoded.payload.bytes, mp.decoded.payload.size, &meshtastic_Waypoint_msg, &wp)) {
+        latestId = wp.id;
+        if (store.add(wp, mp.from, mp.rx_time, getTime()))
+            store.save();
+    } else
+        LOG_ERROR("Failed to decode waypoint");
+
     powerFSM.trigger(EVENT_RECEIVED_MSG);
 
 #if HAS_SCREEN
@@ -58,25 +83,10 @@ bool WaypointModule::shouldDraw()
     if (!devicestate.has_rx_waypoint)
         return false;
 
-    // Decode the message, to find the expiration time (is waypoint still valid)
-    // This handles "deletion" as well as expiration
-    meshtastic_Waypoint wp;
-    memset(&wp, 0, sizeof(wp));
-    if (pb_decode_from_bytes(devicestate.rx_waypoint.decoded.payload.bytes, devicestate.rx_waypoint.decoded.payload.size,
-                             &meshtastic_Waypoint_msg, &wp)) {
-        // Valid waypoint
-        if (wp.expire > getTime())
-            return devicestate.has_rx_waypoint = true;
-
-        // Expired, or deleted
-        else
-            return devicestate.has_rx_waypoint = false;
-    }
-
-    // If decoding failed
-    LOG_ERROR("Failed to decode waypoint");
-    devicestate.has_rx_waypoint = false;
-    return false;
+    // Drop whatever has expired, from the top of the store's expiry heap
+    // The last waypoint is gone from the store if it expired or was deleted
+    store.expire(getTime());
+    return devicestate.has_rx_waypoint = store.get(latestId) != NULL;
 #else
     return false;
 #endif
@@ -96,16 +106,16 @@ void WaypointModule::drawFrame(OLEDDisplay *display, OLEDDisplayUiState *state,
     if (config.display.displaymode != meshtastic_Config_DisplayConfig_DisplayMode_INVERTED)
         display->fillRect(0 + x, 0 + y, x + display->getWidth(), y + FONT_HEIGHT_SMALL);
 
-    // Decode the waypoint
+    // Look up the waypoint
     const meshtastic_MeshPacket &mp = devicestate.rx_waypoint;
-    meshtastic_Waypoint wp;
-    memset(&wp, 0, sizeof(wp));
-    if (!pb_decode_from_bytes(mp.decoded.payload.bytes, mp.decoded.payload.size, &meshtastic_Waypoint_msg, &wp)) {
-        // This *should* be caught by shouldDrawWaypoint, but we'll short-circuit here just in case
-        display->drawStringMaxWidth(0 + x, 0 + y, x + display->getWidth(), "Couldn't decode waypoint");
+    const WaypointStore::Entry *found = store.get(latestId);
+    if (!found) {
+        // This *should* be caught by shouldDraw, but we'll short-circuit here just in case
+        display->drawStringMaxWidth(0 + x, 0 + y, x + display->getWidth(), "Waypoint expired");
         devicestate.has_rx_waypoint = false;
         return;
     }
+    const WaypointStore::Entry &wp = *found;
 
     // Get timestamp info. Will pass as a field to drawColumns
     static char lastStr[20];
@@ -1,6 +1,7 @@
 #pragma once
 #include "Observer.h"
 #include "SinglePortModule.h"
+#include "WaypointStore.h"
 
 /**
  * Waypoint message handling for meshtastic
@@ -11,7 +12,13 @@ class WaypointModule : public SinglePortModule, public Observable<const UIFrameE
     /** Constructor
      * name is for debugging output
      */
-    WaypointModule() : SinglePortModule("waypoint", meshtastic_PortNum_WAYPOINT_APP) {}
+    WaypointModule();
+
+    /// The active waypoints we have heard, for the screens to show
+    const WaypointStore &getStore() const { return store; }
+
+    /// Id of the last waypoint we heard, the one the waypoint frame shows
+    uint32_t getLatestId() const { return latestId; }
 #if HAS_SCREEN
     bool shouldDraw();
 #endif
@@ -28,6 +35,10 @@ class WaypointModule : public SinglePortModule, public Observable<const UIFrameE
     virtual void drawFrame(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t x, int16_t y) override;
 #endif
     virtual ProcessMessage handleReceived(const meshtastic_MeshPacket &mp) override;
+
+  private:
+    WaypointStore store;
+    uint32_t latestId = 0;
 };
 
 extern WaypointModule *waypointModule;
\ No newline at end of file
@@ -0,0 +1,244 @@
+#include "WaypointStore.h"
+#include "FSCommon.h"
+#include "SPILock.h"
+#include "SafeFile.h"
+#include "concurrency/LockGuard.h"
+#include "configuration.h"
+#include <string.h>
+
+static_assert(WAYPOINT_STORE_MAX < WaypointStore::NONE, "WaypointStore indexes entries with a uint8_t");
+
+static const char *waypointsFileName = "/prefs/waypoints.dat";
+
+// Each record on flash: id, from, latitude_i, longitude_i, expire, locked_to, rx_time, icon, then the name and the
+// description, each led by its length
+static constexpr size_t RECORD_FIXED_SIZE = 8 * sizeof(uint32_t);
+
+WaypointStore::WaypointStore()
+{
+    memset(entries, 0, sizeof(entries));
+    memset(heads, NONE, sizeof(heads));
+}
+
+uint8_t WaypointStore::find(uint32_t id) const
+{
+    for (uint8_t i = 0; i < WAYPOINT_STORE_MAX; i++)
+        if (entries[i].used && entries[i].id == id)
+            return i;
+    return NONE;
+}
+
+const WaypointStore::Entry *WaypointStore::get(uint32_t id) const
+{
+    uint8_t i = find(id);
+    return i == NONE ? NULL : &entries[i];
+}
+
+bool WaypointStore::add(const meshtastic_Waypoint &wp, NodeNum from, uint32_t rxTime, uint32_t now)
+{
+    // Sent again already expired: a deletion
+    if (wp.expire <= now)
+        return remove(wp.id);
+
+    uint8_t i = find(wp.id);
+    if (i != NONE)
+        take(i); // an update, put back below where its new expiry and position go
+    else {
+        if (count == WAYPOINT_STORE_MAX) {
+            LOG_DEBUG("Waypoint store full, drop 0x%x", entries[heap[0]].id);
+            take(heap[0]);
+        }
+        for (i = 0; entries[i].used; i++)
+            ;
+    }
+
+    Entry &e = entries[i];
+    e.id = wp.id;
+    e.from = from;
+    e.latitude_i = wp.latitude_i;
+    e.longitude_i = wp.longitude_i;
+    e.expire = wp.expire;
+    e.lockedTo = wp.locked_to;
+    e.rxTime = rxTime;
+    e.icon = wp.icon;
+    strncpy(e.name, wp.name, sizeof(e.name) - 1);
+    e.name[sizeof(e.name) - 1] = '\0';
+    strncpy(e.description, wp.description, sizeof(e.description) - 1);
+    e.description[sizeof(e.description) - 1] = '\0';
+    e.cellLat = cellOf(e.latitude_i);
+    e.cellLng = wrapCellLng(cellOf(e.longitude_i));
+    e.used = true;
+    link(i);
+
+    e.heapPos = count;
+    heap[count++] = i;
+    siftUp(e.heapPos);
+    return true;
+}
+
+bool WaypointStore::remove(uint32_t id)
+{
+    uint8_t i = find(id);
+    if (i == NONE)
+        return false;
+    take(i);
+    return true;
+}
+
+size_t WaypointStore::expire(uint32_t now)
+{
+    size_t dropped = 0;
+    while (count && entries[heap[0]].expire <= now) {
+        take(heap[0]);
+        dropped++;
+    }
+    return dropped;
+}
+
+// Take entry i out of the heap and the grid, and free its slot
+void WaypointStore::take(uint8_t i)
+{
+    size_t pos = entries[i].heapPos;
+    count--;
+    if (pos != count) {
+        uint8_t moved = heap[count];
+        heap[pos] = moved;
+        entries[moved].heapPos = pos;
+        siftDown(pos);
+        siftUp(entries[moved].heapPos);
+    }
+    unlink(i);
+    entries[i].used = false;
+}
+
+void WaypointStore::heapSwap(size_t a, size_t b)
+{
+    uint8_t t = heap[a];
+    heap[a] = heap[b];
+    heap[b] = t;
+    entries[heap[a]].heapPos = a;
+    entries[heap[b]].heapPos = b;
+}
+
+void WaypointStore::siftUp(size_t pos)
+{
+    while (pos > 0) {
+        size_t parent = (pos - 1) / 2;
+        if (entries[heap[parent]].expire <= entries[heap[pos]].expire)
+            break;
+        heapSwap(pos, parent);
+        pos = parent;
+    }
+}
+
+void WaypointStore::siftDown(size_t pos)
+{
+    for (;;) {
+        size_t least = pos, left = 2 * pos + 1, right = left + 1;
+        if (left < count && entries[heap[left]].expire < entries[heap[least]].expire)
+            least = left;
+        if (right < count && entries[heap[right]].expire < entries[heap[least]].expire)
+            least = right;
+        if (least == pos)
+            return;
+        heapSwap(pos, least);
+        pos = least;
+    }
+}
+
+void WaypointStore::link(uint8_t i)
+{
+    size_t b = bucketOf(entries[i].cellLat, entries[i].cellLng);
+    entries[i].next = heads[b];
+    heads[b] = i;
+}
+
+void WaypointStore::unlink(uint8_t i)
+{
+    uint8_t *p = &heads[bucketOf(entries[i].cellLat, entries[i].cellLng)];
+    while (*p != NONE && *p != i)
+        p = &entries[*p].next;
+    if (*p == i)
+        *p = entries[i].next;
+}
+
+bool WaypointStore::save()
+{
+#ifdef FSCom
+    auto f = SafeFile(waypointsFileName);
+
+    // Take firmware's filesystem lock while writing, SafeFile::close takes it for itself
+    fsLock->lock();
+    uint32_t magic = FILE_MAGIC;
+    uint8_t n = count;
+    f.write((uint8_t *)&magic, sizeof(magic));
+    f.write(n);
+    forEach([&](const Entry &e) {
+        uint32_t fixed[] = {e.id,     e.from,     (uint32_t)e.latitude_i, (uint32_t)e.longitude_i,
+                            e.expire, e.lockedTo, e.rxTime,               e.icon};
+        static_assert(sizeof(fixed) == RECORD_FIXED_SIZE, "record layout");
+        f.write((uint8_t *)fixed, sizeof(fixed));
+        uint8_t len = strlen(e.name);
+        f.write(len);
+        f.write((uint8_t *)e.name, len);
+        len = strlen(e.description);
+        f.write(len);
+        f.write((uint8_t *)e.description, len);
+    });
+    fsLock->unlock();
+
+    if (!f.close()) {
+        LOG_ERROR("Can't write %s", waypointsFileName);
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void WaypointStore::load(uint32_t now)
+{
+#ifdef FSCom
+    concurrency::LockGuard guard(fsLock);
+    if (!FSCom.exists(waypointsFileName))
+        return;
+    auto f = FSCom.open(waypointsFileName, FILE_O_READ);
+    if (!f) {
+        LOG_ERROR("Could not open / read %s", waypointsFileName);
+        return;
+    }
+
+    uint32_t magic = 0;
+    uint8_t n = 0;
+    if (f.readBytes((char *)&magic, sizeof(magic)) != sizeof(magic) || magic != FILE_MAGIC ||
+        f.readBytes((char *)&n, 1) != 1) {
+        LOG_WARN("%s not a waypoint store, ignored", waypointsFileName);
+        f.close();
+        return;
+    }
+
+    size_t loaded = 0;
+    for (uint8_t r = 0; r < n; r++) {
+        uint32_t fixed[RECORD_FIXED_SIZE / sizeof(uint32_t)];
+        meshtastic_Waypoint wp = meshtastic_Waypoint_init_zero;
+        uint8_t len;
+        if (f.readBytes((char *)fixed, sizeof(fixed)) != sizeof(fixed) || f.readBytes((char *)&len, 1) != 1 ||
+            len >= sizeof(wp.name) || f.readBytes(wp.name, len) != len || f.readBytes((char *)&len, 1) != 1 ||
+            len >= sizeof(wp.description) || f.readBytes(wp.description, len) != len) {
+            LOG_WARN("%s cut short", waypointsFileName);
+            break;
+        }
+        wp.id = fixed[0];
+        wp.has_latitude_i = wp.has_longitude_i = true;
+        wp.latitude_i = fixed[2];
+        wp.longitude_i = fixed[3];
+        wp.expire = fixed[4];
+        wp.locked_to = fixed[5];
+        wp.icon = fixed[7];
+        loaded += add(wp, fixed[1], fixed[6], now);
+    }
+    f.close();
+    LOG_INFO("Loaded %u active waypoints of %u", (unsigned)loaded, n);
+#endif
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include "mesh/generated/meshtastic/mesh.pb.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+/// Waypoints kept at once, the one due to expire soonest makes room for a new one
+#ifndef WAYPOINT_STORE_MAX
+#define WAYPOINT_STORE_MAX 32
+#endif
+
+/**
+ * The active waypoints we have heard, so the screens can show them without decoding packets or looking at every one for
+ * the expired.
+ *
+ * A fixed array of entries, with a min-heap of them by expiry time: expire() drops what is due from the top, O(log n) each,
+ * and the heap keeps its entries' positions so an update or deletion takes one out of the middle as cheaply.  Entries are
+ * also bucketed by a grid of GRID_CELL_E7 square cells (as NodePositionIndex does for nodes), so forEachNear() only looks
+ * at those in the cells around a point.
+ *
+ * Saved to /prefs/waypoints.dat after each change, as a short header then one variable length record per waypoint.
+ */
+class WaypointStore
+{
+  public:
+    /// Grid cell size, in 1e-7 degrees (0.1 degree, about 11 km north to south)
+    static constexpr int32_t GRID_CELL_E7 = 1000000;
+
+    static constexpr uint8_t NONE = 0xff;
+
+    struct Entry {
+        uint32_t id;
+        NodeNum from;
+        int32_t latitude_i;
+        int32_t longitude_i;
+        uint32_t expire; // epoch seconds
+        uint32_t lockedTo;
+        uint32_t rxTime; // epoch seconds, 0 if we had no time when it came
+        uint32_t icon;   // unicode codepoint
+        char name[sizeof(meshtastic_Waypoint::name)];
+        char description[sizeof(meshtastic_Waypoint::description)];
+        int16_t cellLat, cellLng;
+        uint8_t next;    // next entry in the same grid bucket, NONE ends the list
+        uint8_t heapPos; // where the entry sits in the expiry heap
+        bool used;
+    };
+
+    WaypointStore();
+
+    /**
+     * Keep a waypoint heard from a node, replacing one with the same id.  A waypoint that has already expired deletes it, as
+     * the apps delete one by sending it again with an expiry in the past.
+     * @return true if the store changed
+     */
+    bool add(const meshtastic_Waypoint &wp, NodeNum from, uint32_t rxTime, uint32_t now);
+
+    bool remove(uint32_t id);
+
+    /**
+     * Drop the waypoints that have expired by now
+     * @return how many were dropped
+     */
+    size_t expire(uint32_t now);
+
+    /// The active waypoint with this id, NULL if we have none
+    const Entry *get(uint32_t id) const;
+
+    size_t size() const { return count; }
+
+    /// Seconds since the epoch the next waypoint expires, 0 if there are none
+    uint32_t nextExpiry() const { return count ? entries[heap[0]].expire : 0; }
+
+    /// Call f(const Entry &) for every waypoint, in no particular order
+    template <typename Fn> void forEach(Fn f) const
+    {
+        for (size_t i = 0; i < WAYPOINT_STORE_MAX; i++)
+            if (entries[i].used)
+                f(entries[i]);
+    }
+
+    /// Call f(const Entry &) for every waypoint within rings cells of a point (those further may be included too)
+    template <typename Fn> void forEachNear(int32_t latitude_i, int32_t longitude_i, int rings, Fn f) const
+    {
+        int16_t cellLat = cellOf(latitude_i), cellLng = wrapCellLng(cellOf(longitude_i));
+        if ((2 * rings + 1) * (2 * rings + 1) >= WAYPOINT_STORE_MAX) {
+            forEach(f); // more cells than waypoints, cheaper to look at them all
+            return;
+        }
+        for (int dLat = -rings; dLat <= rings; dLat++)
+            for (int dLng = -rings; dLng <= rings; dLng++) {
+                int16_t cLat = cellLat + dLat, cLng = wrapCellLng(cellLng + dLng);
+                for (uint8_t i = heads[bucketOf(cLat, cLng)]; i != NONE; i = entries[i].next)
+                    if (entries[i].cellLat == cLat && entries[i].cellLng == cLng)
+                        f(entries[i]);
+            }
+    }
+
+    /// Write the store to flash, called after each change
+    bool save();
+
+    /// Read the store back from flash, dropping what expired while we were off
+    void load(uint32_t now);
+
+  private:
+    static constexpr size_t GRID_BUCKETS = 16;
+    static constexpr uint32_t FILE_MAGIC = 0x31505757; // "WWP1"
+
+    Entry entries[WAYPOINT_STORE_MAX];
+    uint8_t heap[WAYPOINT_STORE_MAX]; // entry indices, soonest expiry first
+    uint8_t heads[GRID_BUCKETS];
+    size_t count = 0;
+
+    uint8_t find(uint32_t id) const;
+    void take(uint8_t i);
+
+    void heapSwap(size_t a, size_t b);
+    void siftUp(size_t pos);
+    void siftDown(size_t pos);
+
+    void link(uint8_t i);
+    void unlink(uint8_t i);
+
+    /// Rounds down, so the cells either side of 0 don't merge
+    static int16_t cellOf(int32_t e7)
+    {
+        int32_t c = e7 / GRID_CELL_E7;
+        return (int16_t)(e7 < 0 && c * GRID_CELL_E7 != e7 ? c - 1 : c);
+    }
+
+    /// Longitude cells wrap around at the antimeridian
+    static int16_t wrapCellLng(int c)
+    {
+        const int cells = 3600000000 / GRID_CELL_E7;
+        c = (c + cells / 2) % cells;
+        return (int16_t)(c < 0 ? c + cells / 2 : c - cells / 2);
+    }
+
+    static size_t bucketOf(int16_t cellLat, int16_t cellLng)
+    {
+        return ((uint32_t)(cellLat * 7919 + cellLng) * 2654435761u) >> 28; // top 4 bits, GRID_BUCKETS
+    }
+};
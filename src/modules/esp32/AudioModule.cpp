@@ -30,17 +30,43 @@
 ButterworthFilter hp_filter(240, 8000, ButterworthFilter::ButterworthFilter::Highpass, 1);
 
 TaskHandle_t codec2HandlerTask;
+TaskHandle_t captureHandlerTask;
 AudioModule *audioModule;
 
-#ifdef ARCH_ESP32
-// ESP32 doesn't use that flag
-#define YIELD_FROM_ISR(x) portYIELD_FROM_ISR()
-#else
-#define YIELD_FROM_ISR(x) portYIELD_FROM_ISR(x)
-#endif
-
 #include "graphics/ScreenFonts.h"
 
+/**
+ * Reads whole codec2 frames from the I2S DMA ring while PTT is held and hands them to run_codec2 through capture_queue.  The DMA
+ * keeps sampling while the encoder works, so a slow frame no longer costs the samples behind it.
+ */
+void run_capture(void *parameter)
+{
+    uint8_t fill = 0;
+
+    LOG_INFO("Start audio capture task");
+
+    while (true) {
+        if (audioModule->radio_state != RadioState::tx) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // runOnce wakes us when PTT is pressed
+            continue;
+        }
+
+        size_t frameBytes = audioModule->adc_buffer_size * sizeof(int16_t);
+        size_t bytesIn = 0;
+        esp_err_t res = i2s_read(I2S_PORT, audioModule->capture_buffer[fill], frameBytes, &bytesIn, pdMS_TO_TICKS(100));
+        if (res != ESP_OK || bytesIn != frameBytes)
+            continue;
+
+        // The queue holds one frame, so while it is full the encoder still owns the other two buffers; drop this frame then
+        if (xQueueSend(audioModule->capture_queue, &fill, 0) == pdTRUE) {
+            fill = (fill + 1) % AUDIO_CAPTURE_BUFFERS;
+            xTaskNotifyGive(codec2HandlerTask);
+        } else {
+            audioModule->dropped_frames++;
+        }
+    }
+}
+
 void run_codec2(void *parameter)
 {
     // 4 bytes of header in each frame hex c0 de c2 plus the bitrate
@@ -49,43 +75,55 @@ void run_codec2(void *parameter)
     LOG_INFO("Start codec2 task");
 
     while (true) {
-        uint32_t tcount = ulTaskNotifyTake(pdFALSE, pdMS_TO_TICKS(10000));
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10000));
 
-        if (tcount != 0) {
-            if (audioModule->radio_state == RadioState::tx) {
-                for (int i = 0; i < audioModule->adc_buffer_size; i++)
-                    audioModule->speech[i] = (int16_t)hp_filter.Update((float)audioModule->speech[i]);
+        uint8_t filled;
+        while (xQueueReceive(audioModule->capture_queue, &filled, 0) == pdTRUE) {
+            int16_t *speech = audioModule->capture_buffer[filled];
+            for (int i = 0; i < audioModule->adc_buffer_size; i++)
+                speech[i] = (int16_t)hp_filter.Update((float)speech[i]);
 
-                codec2_encode(audioModule->codec2, audioModule->tx_encode_frame + audioModule->tx_encode_frame_index,
-                              audioModule->speech);
-                audioModule->tx_encode_frame_index += audioModule->encode_codec_size;
+            codec2_encode(audioModule->codec2, audioModule->tx_encode_frame + audioModule->tx_encode_frame_index, speech);
+            audioModule->tx_encode_frame_index += audioModule->encode_codec_size;
 
-                if (audioModule->tx_encode_frame_index == (audioModule->encode_frame_size + sizeof(audioModule->tx_header))) {
-                    LOG_INFO("Send %d codec2 bytes", audioModule->encode_frame_size);
-                    audioModule->sendPayload();
-                    audioModule->tx_encode_frame_index = sizeof(audioModule->tx_header);
-                }
+            if (audioModule->tx_encode_frame_index == (audioModule->encode_frame_size + sizeof(audioModule->tx_header))) {
+                LOG_INFO("Send %d codec2 bytes", audioModule->encode_frame_size);
+                audioModule->sendPayload();
+                audioModule->tx_encode_frame_index = sizeof(audioModule->tx_header);
             }
-            if (audioModule->radio_state == RadioState::rx) {
-                size_t bytesOut = 0;
-                if (memcmp(audioModule->rx_encode_frame, &audioModule->tx_header, sizeof(audioModule->tx_header)) == 0) {
-                    for (int i = 4; i < audioModule->rx_encode_frame_index; i += audioModule->encode_codec_size) {
-                        codec2_decode(audioModule->codec2, audioModule->output_buffer, audioModule->rx_encode_frame + i);
-                        i2s_write(I2S_PORT, &audioModule->output_buffer, audioModule->adc_buffer_size, &bytesOut,
-                                  pdMS_TO_TICKS(500));
-                    }
-                } else {
-                    // if the buffer header does not match our own codec, make a temp decoding setup.
-                    CODEC2 *tmp_codec2 = codec2_create(audioModule->rx_encode_frame[3]);
-                    codec2_set_lpc_post_filter(tmp_codec2, 1, 0, 0.8, 0.2);
-                    int tmp_encode_codec_size = (codec2_bits_per_frame(tmp_codec2) + 7) / 8;
-                    int tmp_adc_buffer_size = codec2_samples_per_frame(tmp_codec2);
-                    for (int i = 4; i < audioModule->rx_encode_frame_index; i += tmp_encode_codec_size) {
-                        codec2_decode(tmp_codec2, audioModule->output_buffer, audioModule->rx_encode_frame + i);
-                        i2s_write(I2S_PORT, &audioModule->output_buffer, tmp_adc_buffer_size, &bytesOut, pdMS_TO_TICKS(500));
-                    }
-                    codec2_destroy(tmp_codec2);
+        }
+
+        // PTT was released, send what is left of the last packet
+        if (audioModule->radio_state != RadioState::tx && audioModule->tx_encode_frame_index > sizeof(audioModule->tx_header)) {
+            LOG_INFO("Send %d codec2 bytes (incomplete)", audioModule->tx_encode_frame_index);
+            audioModule->sendPayload();
+            audioModule->tx_encode_frame_index = sizeof(audioModule->tx_header);
+            if (audioModule->dropped_frames)
+                LOG_WARN("Dropped %u audio frames, the encoder did not keep up", audioModule->dropped_frames);
+            audioModule->dropped_frames = 0;
+        }
+
+        if (audioModule->rx_pending) {
+            audioModule->rx_pending = false;
+            size_t bytesOut = 0;
+            if (memcmp(audioModule->rx_encode_frame, &audioModule->tx_header, sizeof(audioModule->tx_header)) == 0) {
+                for (int i = 4; i < audioModule->rx_encode_frame_index; i += audioModule->encode_codec_size) {
+                    codec2_decode(audioModule->codec2, audioModule->output_buffer, audioModule->rx_encode_frame + i);
+                    i2s_write(I2S_PORT, &audioModule->output_buffer, audioModule->adc_buffer_size * sizeof(int16_t), &bytesOut,
+                              pdMS_TO_TICKS(500));
+                }
+            } else {
+                // if the buffer header does not match our own codec, make a temp decoding setup.
+                CODEC2 *tmp_codec2 = codec2_create(audioModule->rx_encode_frame[3]);
+                codec2_set_lpc_post_filter(tmp_codec2, 1, 0, 0.8, 0.2);
+                int tmp_encode_codec_size = (codec2_bits_per_frame(tmp_codec2) + 7) / 8;
+                int tmp_adc_buffer_size = codec2_samples_per_frame(tmp_codec2);
+                for (int i = 4; i < audioModule->rx_encode_frame_index; i += tmp_encode_codec_size) {
+                    codec2_decode(tmp_codec2, audioModule->output_buffer, audioModule->rx_encode_frame + i);
+                    i2s_write(I2S_PORT, &audioModule->output_buffer, tmp_adc_buffer_size * sizeof(int16_t), &bytesOut,
+                              pdMS_TO_TICKS(500));
                 }
+                codec2_destroy(tmp_codec2);
             }
         }
     }
@@ -112,7 +150,10 @@ AudioModule::AudioModule() : SinglePortModule("Audio", meshtastic_PortNum_AUDIO_
         adc_buffer_size = codec2_samples_per_frame(codec2);
         LOG_INFO("Use %d frames of %d bytes for a total payload length of %d bytes", encode_frame_num, encode_codec_size,
                  encode_frame_size);
-        xTaskCreate(&run_codec2, "codec2_task", 30000, NULL, 5, &codec2HandlerTask);
+        capture_queue = xQueueCreate(1, sizeof(uint8_t));
+        xTaskCreatePinnedToCore(&run_codec2, "codec2_task", 30000, NULL, 5, &codec2HandlerTask, AUDIO_TASK_CORE);
+        // Above the encoder, so the DMA ring is always drained in time
+        xTaskCreatePinnedToCore(&run_capture, "audio_capture", 4096, NULL, 6, &captureHandlerTask, AUDIO_TASK_CORE);
     } else {
         disable();
     }
@@ -195,43 +236,19 @@ int32_t AudioModule::runOnce()
                 if (radio_state == RadioState::rx) {
                     LOG_INFO("PTT pressed, switching to TX");
                     radio_state = RadioState::tx;
+                    xTaskNotifyGive(captureHandlerTask);
                     e.action = UIFrameEvent::Action::REGENERATE_FRAMESET; // We want to change the list of frames shown on-screen
                     this->notifyObservers(&e);
                 }
             } else {
                 if (radio_state == RadioState::tx) {
                     LOG_INFO("PTT released, switching to RX");
-                    if (tx_encode_frame_index > sizeof(tx_header)) {
-                        // Send the incomplete frame
-                        LOG_INFO("Send %d codec2 bytes (incomplete)", tx_encode_frame_index);
-                        sendPayload();
-                    }
-                    tx_encode_frame_index = sizeof(tx_header);
                     radio_state = RadioState::rx;
+                    xTaskNotifyGive(codec2HandlerTask); // it owns tx_encode_frame, let it send the incomplete frame
                     e.action = UIFrameEvent::Action::REGENERATE_FRAMESET; // We want to change the list of frames shown on-screen
                     this->notifyObservers(&e);
                 }
             }
-            if (radio_state == RadioState::tx) {
-                // Get I2S data from the microphone and place in data buffer
-                size_t bytesIn = 0;
-                res = i2s_read(I2S_PORT, adc_buffer + adc_buffer_index, adc_buffer_size - adc_buffer_index, &bytesIn,
-                               pdMS_TO_TICKS(40)); // wait 40ms for audio to arrive.
-
-                if (res == ESP_OK) {
-                    adc_buffer_index += bytesIn;
-                    if (adc_buffer_index == adc_buffer_size) {
-                        adc_buffer_index = 0;
-                        memcpy((void *)speech, (void *)adc_buffer, 2 * adc_buffer_size);
-                        // Notify run_codec2 task that the buffer is ready.
-                        radio_state = RadioState::tx;
-                        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-                        vTaskNotifyGiveFromISR(codec2HandlerTask, &xHigherPriorityTaskWoken);
-                        if (xHigherPriorityTaskWoken == pdTRUE)
-                            YIELD_FROM_ISR(xHigherPriorityTaskWoken);
-                    }
-                }
-            }
         }
         return 100;
     } else {
@@ -276,11 +293,9 @@ ProcessMessage AudioModule::handleReceived(const meshtastic_MeshPacket &mp)
             memcpy(rx_encode_frame, p.payload.bytes, p.payload.size);
             radio_state = RadioState::rx;
             rx_encode_frame_index = p.payload.size;
+            rx_pending = true;
             // Notify run_codec2 task that the buffer is ready.
-            BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-            vTaskNotifyGiveFromISR(codec2HandlerTask, &xHigherPriorityTaskWoken);
-            if (xHigherPriorityTaskWoken == pdTRUE)
-                YIELD_FROM_ISR(xHigherPriorityTaskWoken);
+            xTaskNotifyGive(codec2HandlerTask);
         }
     }
 
@@ -28,6 +28,14 @@ struct c2_header {
 #define I2S_PORT I2S_NUM_0
 
 #define AUDIO_MODULE_RX_BUFFER 128
+
+// Microphone frames in flight: one being filled from I2S DMA, one queued and one being encoded
+#define AUDIO_CAPTURE_BUFFERS 3
+
+// Capture and codec2 run in their own tasks, pinned away from the core running the main loop
+#ifndef AUDIO_TASK_CORE
+#define AUDIO_TASK_CORE 0
+#endif
 #define AUDIO_MODULE_MODE meshtastic_ModuleConfig_AudioConfig_Audio_Baud_CODEC2_700
 
 class AudioModule : public SinglePortModule, public Observable<const UIFrameEvent *>, private concurrency::OSThread
@@ -36,11 +44,12 @@ class AudioModule : public SinglePortModule, public Observable<const UIFrameEven
     unsigned char rx_encode_frame[meshtastic_Constants_DATA_PAYLOAD_LEN] = {};
     unsigned char tx_encode_frame[meshtastic_Constants_DATA_PAYLOAD_LEN] = {};
     c2_header tx_header = {};
-    int16_t speech[ADC_BUFFER_SIZE_MAX] = {};
+    int16_t capture_buffer[AUDIO_CAPTURE_BUFFERS][ADC_BUFFER_SIZE_MAX] = {};
     int16_t output_buffer[ADC_BUFFER_SIZE_MAX] = {};
-    uint16_t adc_buffer[ADC_BUFFER_SIZE_MAX] = {};
-    int adc_buffer_size = 0;
-    uint16_t adc_buffer_index = 0;
+    int adc_buffer_size = 0;              // samples per codec2 frame
+    QueueHandle_t capture_queue = NULL;   // indexes of filled capture_buffer entries, capture task -> codec2 task
+    volatile uint32_t dropped_frames = 0; // microphone frames the encoder did not keep up with
+    volatile bool rx_pending = false;     // rx_encode_frame holds a packet to play
     int tx_encode_frame_index = sizeof(c2_header); // leave room for header
     int rx_encode_frame_index = 0;
     int encode_codec_size = 0;
@@ -0,0 +1,62 @@
+#include "PaxSketch.h"
+#include <math.h>
+#include <string.h>
+
+// FNV-1a, then the murmur3 finalizer so the register index (top bits) is well mixed for MACs differing only in the last byte
+static uint32_t hashMac(const uint8_t *mac, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= mac[i];
+        h *= 16777619u;
+    }
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+void PaxSketch::add(const uint8_t *mac, size_t len)
+{
+    uint32_t h = hashMac(mac, len);
+    uint16_t index = h >> (32 - PAX_SKETCH_BITS);
+    uint32_t rest = h << PAX_SKETCH_BITS;
+    // Position of the first set bit in what is left of the hash
+    uint8_t rank = rest ? __builtin_clz(rest) + 1 : (32 - PAX_SKETCH_BITS) + 1;
+    if (rank > registers[index])
+        registers[index] = rank;
+}
+
+void PaxSketch::clear()
+{
+    memset((void *)registers, 0, sizeof(registers));
+}
+
+uint32_t PaxSketch::estimate(const PaxSketch *other) const
+{
+    const float m = numRegisters;
+    float sum = 0;
+    uint16_t zeros = 0;
+    for (uint16_t i = 0; i < numRegisters; i++) {
+        uint8_t r = registers[i];
+        if (other && other->registers[i] > r)
+            r = other->registers[i];
+        sum += ldexpf(1.0f, -r);
+        if (r == 0)
+            zeros++;
+    }
+
+    float alpha = 0.7213f / (1 + 1.079f / m);
+    float e = alpha * m * m / sum;
+    // Few sightings leave empty registers, linear counting is more accurate there
+    if (e <= 2.5f * m && zeros)
+        e = m * logf(m / zeros);
+    return (uint32_t)(e + 0.5f);
+}
+
+float PaxSketch::relativeError()
+{
+    return 1.04f / sqrtf(numRegisters);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// log2 of the number of registers, each costs one byte.  10 gives 1KB per sketch and about 3% standard error
+#ifndef PAX_SKETCH_BITS
+#define PAX_SKETCH_BITS 10
+#endif
+
+/**
+ * HyperLogLog estimate of how many distinct MACs were seen.  Unlike a set of addresses it takes the same memory however crowded
+ * the venue is, and a sighting costs one hash and a compare.
+ *
+ * add() may be called from the WiFi task while the main thread reads or clears: registers are single bytes that only ever grow,
+ * so a race can at worst lose one sighting.
+ */
+class PaxSketch
+{
+  public:
+    static constexpr uint16_t numRegisters = 1 << PAX_SKETCH_BITS;
+
+    void add(const uint8_t *mac, size_t len = 6);
+
+    void clear();
+
+    /// Estimated number of distinct MACs added since the last clear(), counted over the union with other if given
+    uint32_t estimate(const PaxSketch *other = NULL) const;
+
+    /// Relative standard error of estimate(), e.g. 0.0325 for 1024 registers
+    static float relativeError();
+
+  private:
+    volatile uint8_t registers[numRegisters] = {};
+};
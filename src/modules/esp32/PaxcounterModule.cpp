@@ -8,6 +8,13 @@
 #include "graphics/images.h"
 #include <assert.h>
 
+#if PAXCOUNTER_SKETCH
+#include <esp_wifi.h>
+
+#define PAX_WIFI_CHANNELS 13
+#define PAX_WIFI_HOP_MS 50
+#endif
+
 PaxcounterModule *paxcounterModule;
 
 /**
@@ -42,6 +49,14 @@ bool PaxcounterModule::sendInfo(NodeNum dest)
     if (paxcounterModule->reportedDataSent)
         return false;
 
+#if PAXCOUNTER_SKETCH
+    count_from_libpax.wifi_count = wifiCount();
+    LOG_INFO("PaxcounterModule: wifi estimate %d +/- %.1f%%", count_from_libpax.wifi_count, PaxSketch::relativeError() * 100);
+    // Start the next interval, dropping the one before the current
+    currentSketch ^= 1;
+    wifiSketches[currentSketch].clear();
+#endif
+
     LOG_INFO("PaxcounterModule: send pax info wifi=%d; ble=%d; uptime=%lu", count_from_libpax.wifi_count,
              count_from_libpax.ble_count, millis() / 1000);
 
@@ -67,6 +82,51 @@ bool PaxcounterModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, m
     return false; // Let others look at this message also if they want. We don't do anything with received packets.
 }
 
+#if PAXCOUNTER_SKETCH
+/**
+ * Promiscuous mode callback from the WiFi task: note the sender of every management frame (probe requests mostly) strong enough
+ */
+void PaxcounterModule::wifiSniffed(void *buf, wifi_promiscuous_pkt_type_t type)
+{
+    const wifi_promiscuous_pkt_t *pkt = (const wifi_promiscuous_pkt_t *)buf;
+    if (pkt->rx_ctrl.rssi < Default::getConfiguredOrDefault(moduleConfig.paxcounter.wifi_threshold, -80))
+        return;
+    const uint8_t *transmitter = pkt->payload + 10; // addr2 of the 802.11 header
+    paxcounterModule->wifiSketches[paxcounterModule->currentSketch].add(transmitter);
+}
+
+void PaxcounterModule::hopChannel(TimerHandle_t timer)
+{
+    static uint8_t channel = 0;
+    channel = (channel % PAX_WIFI_CHANNELS) + 1;
+    esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+}
+
+void PaxcounterModule::startWifiSniffer()
+{
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    esp_wifi_init(&cfg);
+    esp_wifi_set_storage(WIFI_STORAGE_RAM);
+    esp_wifi_set_mode(WIFI_MODE_NULL);
+    esp_wifi_start();
+
+    wifi_promiscuous_filter_t filter = {.filter_mask = WIFI_PROMIS_FILTER_MASK_MGMT};
+    esp_wifi_set_promiscuous_filter(&filter);
+    esp_wifi_set_promiscuous_rx_cb(&wifiSniffed);
+    esp_wifi_set_promiscuous(true);
+
+    TimerHandle_t hopTimer = xTimerCreate("paxHop", pdMS_TO_TICKS(PAX_WIFI_HOP_MS), pdTRUE, NULL, &hopChannel);
+    xTimerStart(hopTimer, 0);
+    LOG_INFO("Paxcounter sketches WiFi in %u bytes, +/- %.1f%%", (unsigned)sizeof(wifiSketches),
+             PaxSketch::relativeError() * 100);
+}
+
+uint32_t PaxcounterModule::wifiCount()
+{
+    return wifiSketches[currentSketch].estimate(&wifiSketches[currentSketch ^ 1]);
+}
+#endif
+
 meshtastic_MeshPacket *PaxcounterModule::allocReply()
 {
     meshtastic_Paxcount pl = meshtastic_Paxcount_init_default;
@@ -89,7 +149,12 @@ int32_t PaxcounterModule::runOnce()
 
             configuration.blecounter = 1;
             configuration.blescantime = 0; // infinite
+#if PAXCOUNTER_SKETCH
+            configuration.wificounter = 0; // our own sniffer feeds the sketches
+            startWifiSniffer();
+#else
             configuration.wificounter = 1;
+#endif
             configuration.wifi_channel_map = WIFI_CHANNEL_ALL;
             configuration.wifi_channel_switch_interval = 50;
             configuration.wifi_rssi_threshold = Default::getConfiguredOrDefault(moduleConfig.paxcounter.wifi_threshold, -80);
@@ -106,7 +171,8 @@ int32_t PaxcounterModule::runOnce()
             sendInfo(NODENUM_BROADCAST);
         }
         return Default::getConfiguredOrDefaultMsScaled(moduleConfig.paxcounter.paxcounter_update_interval,
-                                                       default_telemetry_broadcast_interval_secs, numOnlineNodes);
+                                                       default_telemetry_broadcast_interval_secs, numOnlineNodes,
+                                                       meshtastic_PortNum_PAXCOUNTER_APP);
     } else {
         return disable();
     }
@@ -135,12 +201,21 @@ void PaxcounterModule::drawFrame(OLEDDisplay *display, OLEDDisplayUiState *state
     display->setFont(FONT_SMALL);
 
     libpax_counter_count(&count_from_libpax);
+#if PAXCOUNTER_SKETCH
+    count_from_libpax.wifi_count = wifiCount();
+#endif
 
     display->setTextAlignment(TEXT_ALIGN_CENTER);
     display->setFont(FONT_SMALL);
+#if PAXCOUNTER_SKETCH
+    display->drawStringf(display->getWidth() / 2 + x, graphics::getTextPositions(display)[line++], buffer,
+                         "WiFi: ~%d (%d%%)\nBLE: %d\nUptime: %ds", count_from_libpax.wifi_count,
+                         (int)(PaxSketch::relativeError() * 100 + 0.5f), count_from_libpax.ble_count, millis() / 1000);
+#else
     display->drawStringf(display->getWidth() / 2 + x, graphics::getTextPositions(display)[line++], buffer,
                          "WiFi: %d\nBLE: %d\nUptime: %ds", count_from_libpax.wifi_count, count_from_libpax.ble_count,
                          millis() / 1000);
+#endif
 }
 #endif // HAS_SCREEN
 
@@ -7,6 +7,18 @@
 #include "NodeDB.h"
 #include <libpax_api.h>
 
+/**
+ * Count WiFi devices with our own sniffer into a pair of fixed size HyperLogLog sketches instead of libpax's per-MAC bookkeeping,
+ * so memory stays constant in crowded venues.  BLE is still counted by libpax.
+ */
+#ifndef PAXCOUNTER_SKETCH
+#define PAXCOUNTER_SKETCH 0
+#endif
+
+#if PAXCOUNTER_SKETCH
+#include "PaxSketch.h"
+#endif
+
 /**
  * Wrapper module for the estimate passenger (PAX) count library (https://github.com/dbinfrago/libpax) which
  * implements the core functionality of the ESP32 Paxcounter project (https://github.com/cyberman54/ESP32-Paxcounter)
@@ -18,6 +30,17 @@ class PaxcounterModule : private concurrency::OSThread, public ProtobufModule<me
 
     static void handlePaxCounterReportRequest();
 
+#if PAXCOUNTER_SKETCH
+    // Each report covers the current and the previous interval, so a device seen just before a rotation is not forgotten
+    PaxSketch wifiSketches[2];
+    uint8_t currentSketch = 0;
+
+    static void wifiSniffed(void *buf, wifi_promiscuous_pkt_type_t type);
+    static void hopChannel(TimerHandle_t timer);
+    void startWifiSniffer();
+    uint32_t wifiCount();
+#endif
+
   public:
     PaxcounterModule();
 
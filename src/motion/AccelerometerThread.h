@@ -62,8 +62,13 @@ class AccelerometerThread : public concurrency::OSThread
         // Assume we should not keep the board awake
         canSleep = true;
 
-        if (isInitialised)
-            return sensor->runOnce();
+        if (isInitialised) {
+            int32_t next = sensor->runOnce();
+            // Nothing moved: the sensor's interrupt wakes us when something does
+            if (sensor->isInterruptDriven() && next == MOTION_SENSOR_CHECK_INTERVAL_MS)
+                return MOTION_SENSOR_IDLE_POLL_MS;
+            return next;
+        }
 
         return MOTION_SENSOR_CHECK_INTERVAL_MS;
     }
@@ -121,11 +126,13 @@ class AccelerometerThread : public concurrency::OSThread
             return;
         }
 
+        MotionSensor::thread = this;
         isInitialised = sensor->init();
         if (!isInitialised) {
             clean();
         }
-        LOG_DEBUG("AccelerometerThread::init %s", isInitialised ? "ok" : "failed");
+        LOG_DEBUG("AccelerometerThread::init %s%s", isInitialised ? "ok" : "failed",
+                  isInitialised && sensor->isInterruptDriven() ? ", wait for interrupts" : "");
     }
 
     // Copy constructor (not implemented / included to avoid cppcheck warnings)
@@ -13,15 +13,11 @@ bool BMA423Sensor::init()
         sensor.enableAccelerometer();
         sensor.configInterrupt(BMA4_LEVEL_TRIGGER, BMA4_ACTIVE_HIGH, BMA4_PUSH_PULL, BMA4_OUTPUT_ENABLE, BMA4_INPUT_DISABLE);
 
-#ifdef BMA423_INT
+#ifdef BMA4XX_INT
+        // runOnce() reads the interrupt status itself, the ISR only has to wake it
         pinMode(BMA4XX_INT, INPUT);
-        attachInterrupt(
-            BMA4XX_INT,
-            [] {
-                // Set interrupt to set irq value to true
-                BMA_IRQ = true;
-            },
-            RISING); // Select the interrupt mode according to the actual circuit
+        attachInterrupt(BMA4XX_INT, wakeFromISR, RISING); // Select the interrupt mode according to the actual circuit
+        interruptDriven = true;
 #endif
 
 #ifdef T_WATCH_S3
@@ -13,7 +13,6 @@ class BMA423Sensor : public MotionSensor
 {
   private:
     SensorBMA423 sensor;
-    volatile bool BMA_IRQ = false;
 
   public:
     explicit BMA423Sensor(ScanI2C::FoundDevice foundDevice);
@@ -14,6 +14,7 @@ volatile static bool ICM20948_IRQ = false;
 void ICM20948SetInterrupt()
 {
     ICM20948_IRQ = true;
+    MotionSensor::wakeFromISR();
 }
 
 ICM20948Sensor::ICM20948Sensor(ScanI2C::FoundDevice foundDevice) : MotionSensor::MotionSensor(foundDevice) {}
@@ -26,7 +27,12 @@ bool ICM20948Sensor::init()
         return false;
 
     // Enable simple Wake on Motion
-    return sensor->setWakeOnMotion();
+    if (!sensor->setWakeOnMotion())
+        return false;
+#ifdef ICM_20948_INT_PIN
+    interruptDriven = true;
+#endif
+    return true;
 }
 
 #ifdef ICM_20948_INT_PIN
@@ -108,26 +114,7 @@ int32_t ICM20948Sensor::runOnce()
     }
 
     float heading = FusionCompassCalculateHeading(FusionConventionNed, ga, ma);
-
-    switch (config.display.compass_orientation) {
-    case meshtastic_Config_DisplayConfig_CompassOrientation_DEGREES_0_INVERTED:
-    case meshtastic_Config_DisplayConfig_CompassOrientation_DEGREES_0:
-        break;
-    case meshtastic_Config_DisplayConfig_CompassOrientation_DEGREES_90:
-    case meshtastic_Config_DisplayConfig_CompassOrientation_DEGREES_90_INVERTED:
-        heading += 90;
-        break;
-    case meshtastic_Config_DisplayConfig_CompassOrientation_DEGREES_180:
-    case meshtastic_Config_DisplayConfig_CompassOrientation_DEGREES_180_INVERTED:
-        heading += 180;
-        break;
-    case meshtastic_Config_DisplayConfig_CompassOrientation_DEGREES_270:
-    case meshtastic_Config_DisplayConfig_CompassOrientation_DEGREES_270_INVERTED:
-        heading += 270;
-        break;
-    }
-    if (screen)
-        screen->setHeading(heading);
+    setCompassHeading(heading);
 #endif
 
     // Wake on motion using polling  - this is not as efficient as using hardware interrupt pin (see above)
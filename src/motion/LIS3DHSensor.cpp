@@ -11,6 +11,12 @@ bool LIS3DHSensor::init()
         sensor.setRange(LIS3DH_RANGE_2_G);
         // Adjust threshold, higher numbers are less sensitive
         sensor.setClick(config.device.double_tap_as_button_press ? 2 : 1, MOTION_SENSOR_CHECK_INTERVAL_MS);
+#ifdef LIS3DH_INT_PIN
+        // setClick() latches clicks onto INT1, reading them in runOnce() clears it
+        pinMode(LIS3DH_INT_PIN, INPUT);
+        attachInterrupt(digitalPinToInterrupt(LIS3DH_INT_PIN), wakeFromISR, RISING);
+        interruptDriven = true;
+#endif
         LOG_DEBUG("LIS3DH init ok");
         return true;
     }
@@ -24,6 +30,8 @@ int32_t LIS3DHSensor::runOnce()
         uint8_t click = sensor.getClick();
         if (!config.device.double_tap_as_button_press && config.display.wake_on_tap_or_motion) {
             wakeScreen();
+        } else {
+            noteMotion(); // Not waking the screen, but we still moved
         }
 
         if (config.device.double_tap_as_button_press && (click & 0x20)) {
@@ -8,6 +8,8 @@
 
 #include <Adafruit_LIS3DH.h>
 
+// Define LIS3DH_INT_PIN in variant.h if INT1 is wired, to sleep until the sensor sees a tap instead of polling it
+
 class LIS3DHSensor : public MotionSensor
 {
   private:
@@ -14,6 +14,13 @@ bool LSM6DS3Sensor::init()
 
         // Duration is number of occurrences needed to trigger, higher threshold is less sensitive
         sensor.enableWakeup(config.display.wake_on_tap_or_motion, 1, LSM6DS3_WAKE_THRESH);
+#ifdef LSM6DS3_INT_PIN
+        // Raise INT1 on wakeup, shake() in runOnce() reads what happened
+        sensor.configInt1(false, false, false, false, true);
+        pinMode(LSM6DS3_INT_PIN, INPUT);
+        attachInterrupt(digitalPinToInterrupt(LSM6DS3_INT_PIN), wakeFromISR, RISING);
+        interruptDriven = config.display.wake_on_tap_or_motion;
+#endif
 
         LOG_DEBUG("LSM6DS3 init ok");
         return true;
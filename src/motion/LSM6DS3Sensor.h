@@ -10,6 +10,8 @@
 #define LSM6DS3_WAKE_THRESH 20
 #endif
 
+// Define LSM6DS3_INT_PIN in variant.h if INT1 is wired, to sleep until the sensor sees motion instead of polling it
+
 #include <Adafruit_LSM6DS3TRC.h>
 
 class LSM6DS3Sensor : public MotionSensor
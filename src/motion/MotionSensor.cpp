@@ -1,10 +1,15 @@
 #include "MotionSensor.h"
 #include "graphics/draw/CompassRenderer.h"
+#include "main.h"
 
 #if !defined(ARCH_STM32WL) && !MESHTASTIC_EXCLUDE_I2C
 
 char timeRemainingBuffer[12];
 
+uint32_t MotionSensor::motionCount = 0;
+
+concurrency::OSThread *MotionSensor::thread = nullptr;
+
 // screen is defined in main.cpp
 extern graphics::Screen *screen;
 
@@ -32,6 +37,17 @@ ScanI2C::I2CPort MotionSensor::devicePort()
     return device.address.port;
 }
 
+IRAM_ATTR void MotionSensor::wakeFromISR()
+{
+    if (!thread)
+        return;
+    thread->setInterval(0);
+    runASAP = true;
+
+    BaseType_t higherWake = 0;
+    concurrency::mainDelay.interruptFromISR(&higherWake);
+}
+
 #if !defined(MESHTASTIC_EXCLUDE_SCREEN) && HAS_SCREEN
 void MotionSensor::drawFrameCalibration(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t x, int16_t y)
 {
@@ -64,9 +80,52 @@ void MotionSensor::drawFrameCalibration(OLEDDisplay *display, OLEDDisplayUiState
 }
 #endif
 
+void MotionSensor::setCompassHeading(float heading)
+{
+#if !defined(MESHTASTIC_EXCLUDE_SCREEN)
+    switch (config.display.compass_orientation) {
+    case meshtastic_Config_DisplayConfig_CompassOrientation_DEGREES_0_INVERTED:
+    case meshtastic_Config_DisplayConfig_CompassOrientation_DEGREES_0:
+        break;
+    case meshtastic_Config_DisplayConfig_CompassOrientation_DEGREES_90:
+    case meshtastic_Config_DisplayConfig_CompassOrientation_DEGREES_90_INVERTED:
+        heading += 90;
+        break;
+    case meshtastic_Config_DisplayConfig_CompassOrientation_DEGREES_180:
+    case meshtastic_Config_DisplayConfig_CompassOrientation_DEGREES_180_INVERTED:
+        heading += 180;
+        break;
+    case meshtastic_Config_DisplayConfig_CompassOrientation_DEGREES_270:
+    case meshtastic_Config_DisplayConfig_CompassOrientation_DEGREES_270_INVERTED:
+        heading += 270;
+        break;
+    }
+
+#if MOTION_HEADING_SMOOTHING
+    float x = cosf(heading * DEG_TO_RAD);
+    float y = sinf(heading * DEG_TO_RAD);
+    if (haveHeading) {
+        headingX += (x - headingX) / MOTION_HEADING_SMOOTHING;
+        headingY += (y - headingY) / MOTION_HEADING_SMOOTHING;
+    } else {
+        headingX = x;
+        headingY = y;
+        haveHeading = true;
+    }
+    heading = atan2f(headingY, headingX) * RAD_TO_DEG;
+    if (heading < 0)
+        heading += 360;
+#endif
+
+    if (screen)
+        screen->setHeading(heading);
+#endif
+}
+
 #if !MESHTASTIC_EXCLUDE_POWER_FSM
 void MotionSensor::wakeScreen()
 {
+    noteMotion();
     if (powerFSM.getState() == &stateDARK) {
         LOG_DEBUG("Motion wakeScreen detected");
         powerFSM.trigger(EVENT_INPUT);
@@ -81,7 +140,10 @@ void MotionSensor::buttonPress()
 
 #else
 
-void MotionSensor::wakeScreen() {}
+void MotionSensor::wakeScreen()
+{
+    noteMotion();
+}
 
 void MotionSensor::buttonPress() {}
 
@@ -5,11 +5,22 @@
 #define MOTION_SENSOR_CHECK_INTERVAL_MS 100
 #define MOTION_SENSOR_CLICK_THRESHOLD 40
 
+// How often a sensor that raises an interrupt on motion is still read while nothing moves, in case an edge got lost
+#ifndef MOTION_SENSOR_IDLE_POLL_MS
+#define MOTION_SENSOR_IDLE_POLL_MS 10000
+#endif
+
+// Smooth the compass heading over roughly this many readings, 0 shows each reading as it comes
+#ifndef MOTION_HEADING_SMOOTHING
+#define MOTION_HEADING_SMOOTHING 0
+#endif
+
 #include "../configuration.h"
 
 #if !defined(ARCH_STM32WL) && !MESHTASTIC_EXCLUDE_I2C
 
 #include "../PowerFSM.h"
+#include "../concurrency/OSThread.h"
 #include "../detect/ScanI2C.h"
 #include "../graphics/Screen.h"
 #include "../graphics/ScreenFonts.h"
@@ -42,13 +53,31 @@ class MotionSensor
 
     virtual void calibrate(uint16_t forSeconds){};
 
+    // How many times a sensor has seen us move. Only useful by comparison, to know if we have moved since
+    static uint32_t motionCount;
+
+    // Did init() route motion to an interrupt line? Then runOnce() only has work to do after wakeFromISR()
+    bool isInterruptDriven() const { return interruptDriven; }
+
+    // The thread that calls runOnce(), woken by wakeFromISR()
+    static concurrency::OSThread *thread;
+
+    // Call from the sensor's ISR, so the thread runs as soon as possible instead of at its next poll
+    static void wakeFromISR();
+
   protected:
+    // Record that we moved, for motionCount
+    static void noteMotion() { motionCount++; }
+
     // Turn on the screen when a tap or motion is detected
     virtual void wakeScreen();
 
     // Register a button press when a double-tap is detected
     virtual void buttonPress();
 
+    // Correct a compass heading for the configured orientation, smooth it and show it on the screen
+    void setCompassHeading(float heading);
+
 #if !defined(MESHTASTIC_EXCLUDE_SCREEN) && HAS_SCREEN
     // draw an OLED frame (currently only used by the RAK4631 BMX160 sensor)
     static void drawFrameCalibration(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t x, int16_t y);
@@ -59,6 +88,15 @@ class MotionSensor
     // Do calibration if true
     bool doCalibration = false;
     uint32_t endCalibrationAt = 0;
+
+    // Set by init() when the sensor's ISR calls wakeFromISR()
+    bool interruptDriven = false;
+
+#if MOTION_HEADING_SMOOTHING
+    // Smoothed heading as a unit vector, so readings either side of north don't average to south
+    float headingX = 0, headingY = 0;
+    bool haveHeading = false;
+#endif
 };
 
 namespace MotionSensorI2C
@@ -9,6 +9,7 @@ volatile static bool QMA6100P_IRQ = false;
 void QMA6100PSetInterrupt()
 {
     QMA6100P_IRQ = true;
+    MotionSensor::wakeFromISR();
 }
 
 QMA6100PSensor::QMA6100PSensor(ScanI2C::FoundDevice foundDevice) : MotionSensor::MotionSensor(foundDevice) {}
@@ -21,7 +22,12 @@ bool QMA6100PSensor::init()
         return false;
 
     // Enable simple Wake on Motion
-    return sensor->setWakeOnMotion();
+    if (!sensor->setWakeOnMotion())
+        return false;
+#ifdef QMA_6100P_INT_PIN
+    interruptDriven = true;
+#endif
+    return true;
 }
 
 #ifdef QMA_6100P_INT_PIN
@@ -15,7 +15,13 @@ bool STK8XXXSensor::init()
         sensor.STK8xxx_Anymotion_init();
         pinMode(STK8XXX_INT, INPUT_PULLUP);
         attachInterrupt(
-            digitalPinToInterrupt(STK8XXX_INT), [] { STK_IRQ = true; }, RISING);
+            digitalPinToInterrupt(STK8XXX_INT),
+            [] {
+                STK_IRQ = true;
+                wakeFromISR();
+            },
+            RISING);
+        interruptDriven = true;
 
         LOG_DEBUG("STK8XXX init ok");
         return true;
@@ -30,6 +36,8 @@ int32_t STK8XXXSensor::runOnce()
         STK_IRQ = false;
         if (config.display.wake_on_tap_or_motion) {
             wakeScreen();
+        } else {
+            noteMotion(); // Not waking the screen, but we still moved
         }
     }
     return MOTION_SENSOR_CHECK_INTERVAL_MS;
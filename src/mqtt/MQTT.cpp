@@ -25,11 +25,16 @@
 #endif // HAS_ETHERNET
 #include "Default.h"
 #if !defined(ARCH_NRF52) || NRF52_USE_JSON
-#include "serialization/JSON.h"
+#include "serialization/JSONReader.h"
 #include "serialization/MeshPacketSerializer.h"
 #endif
 #include <Throttle.h>
+#if MQTT_SPILL_TO_FLASH
+#include "FSCommon.h"
+#include "SPILock.h"
+#endif
 #include <assert.h>
+#include <pb_decode.h>
 #include <utility>
 
 #include <IPAddress.h>
@@ -51,14 +56,52 @@ static uint8_t bytes[meshtastic_MqttClientProxyMessage_size + 30]; // 12 for cha
 
 static bool isMqttServerAddressPrivate = false;
 
-inline void onReceiveProto(char *topic, byte *payload, size_t length)
+/// The string members of an encoded ServiceEnvelope, pointing into it (not null terminated)
+struct EnvelopeIds {
+    const char *channelId = NULL, *gatewayId = NULL;
+    size_t channelIdLen = 0, gatewayIdLen = 0;
+};
+
+// Find channel_id and gateway_id by walking the envelope's top level fields, skipping the packet without decoding it
+static bool peekServiceEnvelope(const byte *payload, size_t length, EnvelopeIds &ids)
+{
+    pb_istream_t stream = pb_istream_from_buffer(payload, length);
+    pb_wire_type_t wireType;
+    uint32_t tag;
+    bool eof;
+    while (pb_decode_tag(&stream, &wireType, &tag, &eof)) {
+        bool isChannel = tag == meshtastic_ServiceEnvelope_channel_id_tag;
+        if (wireType != PB_WT_STRING || !(isChannel || tag == meshtastic_ServiceEnvelope_gateway_id_tag)) {
+            if (!pb_skip_field(&stream, wireType))
+                return false;
+            continue;
+        }
+        uint32_t len;
+        if (!pb_decode_varint32(&stream, &len) || len > stream.bytes_left)
+            return false;
+        (isChannel ? ids.channelId : ids.gatewayId) = (const char *)payload + (length - stream.bytes_left);
+        (isChannel ? ids.channelIdLen : ids.gatewayIdLen) = len;
+        if (!pb_read(&stream, NULL, len))
+            return false;
+    }
+    return eof && ids.channelId && ids.gatewayId;
+}
+
+static bool idEquals(const char *id, size_t idLen, const char *s)
+{
+    return strlen(s) == idLen && memcmp(id, s, idLen) == 0;
+}
+
+/// @param chIndex the channel named by the envelope's channel_id
+/// @param accept the envelope's channel_id is PKI or a channel we have downlink enabled for
+inline void onReceiveProto(char *topic, byte *payload, size_t length, ChannelIndex chIndex, bool accept)
 {
     const DecodedServiceEnvelope e(payload, length);
     if (!e.validDecode || e.channel_id == NULL || e.gateway_id == NULL || e.packet == NULL) {
         LOG_ERROR("Invalid MQTT service envelope, topic %s, len %u!", topic, length);
         return;
     }
-    const meshtastic_Channel &ch = channels.getByName(e.channel_id);
+    const meshtastic_Channel &ch = channels.getByIndex(chIndex);
     if (strcmp(e.gateway_id, owner.id) == 0) {
         // Generate an implicit ACK towards ourselves (handled and processed only locally!) for this message.
         // We do this because packets are not rebroadcasted back into MQTT anymore and we assume that at least one node
@@ -74,11 +117,8 @@ inline void onReceiveProto(char *topic, byte *payload, size_t length)
         return;
     }
 
-    // Find channel by channel_id and check downlink_enabled
-    if (!(strcmp(e.channel_id, "PKI") == 0 ||
-          (strcmp(e.channel_id, channels.getGlobalId(ch.index)) == 0 && ch.settings.downlink_enabled))) {
+    if (!accept)
         return;
-    }
     LOG_INFO("Received MQTT topic %s, len=%u", topic, length);
     if (e.packet->hop_limit > HOP_MAX || e.packet->hop_start > HOP_MAX) {
         LOG_INFO("Invalid hop_limit(%u) or hop_start(%u)", e.packet->hop_limit, e.packet->hop_start);
@@ -123,86 +163,158 @@ inline void onReceiveProto(char *topic, byte *payload, size_t length)
 }
 
 #if !defined(ARCH_NRF52) || NRF52_USE_JSON
-// returns true if this is a valid JSON envelope which we accept on downlink
-inline bool isValidJsonEnvelope(JSONObject &json)
+/// The members of a downlink JSON envelope we act on, pulled out in a single pass over the message
+struct JsonEnvelope {
+    bool hasFrom = false, hasType = false, hasPayload = false, validHopLimit = true, fromUs = false;
+    double from = 0;
+    bool hasChannel = false, hasTo = false, hasHopLimit = false;
+    double channel = 0, to = 0, hopLimit = 0;
+    char type[16] = "";
+    bool payloadIsText = false, payloadIsPosition = false;
+    char text[meshtastic_Constants_DATA_PAYLOAD_LEN + 1] = ""; // "sendtext" payload
+    size_t textLen = 0;                                        // may be more than fits in text
+    meshtastic_Position pos = meshtastic_Position_init_default; // "sendposition" payload
+};
+
+// Pull the position members we accept out of the payload object, the reader is just past its OBJECT_START
+static bool parseJsonPosition(JSONReader &json, meshtastic_Position &pos)
 {
-    // if "sender" is provided, avoid processing packets we uplinked
-    return (json.find("sender") != json.end() ? (json["sender"]->AsString().compare(owner.id) != 0) : true) &&
-           (json.find("hopLimit") != json.end() ? json["hopLimit"]->IsNumber() : true) && // hop limit should be a number
-           (json.find("from") != json.end()) && json["from"]->IsNumber() &&
-           (json["from"]->AsNumber() == nodeDB->getNodeNum()) &&            // only accept message if the "from" is us
-           (json.find("type") != json.end()) && json["type"]->IsString() && // should specify a type
-           (json.find("payload") != json.end());                            // should have a payload
+    JSONReader::Token t;
+    while ((t = json.next()) == JSONReader::TOKEN_KEY) {
+        int32_t *i32 = NULL;
+        uint32_t *u32 = NULL;
+        if (json.is("latitude_i"))
+            i32 = &pos.latitude_i;
+        else if (json.is("longitude_i"))
+            i32 = &pos.longitude_i;
+        else if (json.is("altitude"))
+            i32 = &pos.altitude;
+        else if (json.is("time"))
+            u32 = &pos.time;
+
+        if (json.next() != JSONReader::TOKEN_NUMBER) {
+            if (!json.finishValue())
+                return false;
+        } else if (i32) {
+            *i32 = json.getNumber();
+        } else if (u32) {
+            *u32 = json.getNumber();
+        }
+    }
+    return t == JSONReader::TOKEN_OBJECT_END;
+}
+
+// Parse a downlink JSON message in a single pass, without building a JSONValue tree
+static bool parseJsonEnvelope(const char *payload, size_t length, JsonEnvelope &env)
+{
+    JSONReader json(payload, length);
+    if (json.next() != JSONReader::TOKEN_OBJECT_START)
+        return false;
+
+    JSONReader::Token t;
+    while ((t = json.next()) == JSONReader::TOKEN_KEY) {
+        bool *has = NULL;
+        double *num = NULL;
+        if (json.is("from")) {
+            has = &env.hasFrom;
+            num = &env.from;
+        } else if (json.is("to")) {
+            has = &env.hasTo;
+            num = &env.to;
+        } else if (json.is("channel")) {
+            has = &env.hasChannel;
+            num = &env.channel;
+        } else if (json.is("hopLimit")) {
+            has = &env.hasHopLimit;
+            num = &env.hopLimit;
+        }
+
+        if (has) {
+            *has = json.next() == JSONReader::TOKEN_NUMBER;
+            if (*has)
+                *num = json.getNumber();
+            else if (has == &env.hasHopLimit)
+                env.validHopLimit = false; // hop limit should be a number
+        } else if (json.is("sender")) {
+            // if "sender" is provided, avoid processing packets we uplinked
+            if (json.next() == JSONReader::TOKEN_STRING) {
+                char sender[sizeof(owner.id) + 1];
+                env.fromUs = json.getString(sender, sizeof(sender)) < sizeof(sender) && strcmp(sender, owner.id) == 0;
+            }
+        } else if (json.is("type")) {
+            env.hasType = json.next() == JSONReader::TOKEN_STRING;
+            if (env.hasType)
+                json.getString(env.type, sizeof(env.type));
+        } else if (json.is("payload")) {
+            env.hasPayload = true;
+            JSONReader::Token p = json.next();
+            if (p == JSONReader::TOKEN_STRING) {
+                env.payloadIsText = true;
+                env.textLen = json.getString(env.text, sizeof(env.text));
+            } else if (p == JSONReader::TOKEN_OBJECT_START) {
+                if (!parseJsonPosition(json, env.pos))
+                    return false;
+                env.payloadIsPosition = true;
+            }
+        } else {
+            json.next(); // something we don't use
+        }
+
+        if (!json.finishValue())
+            return false;
+    }
+    return t == JSONReader::TOKEN_OBJECT_END && json.next() == JSONReader::TOKEN_END;
 }
 
 inline void onReceiveJson(byte *payload, size_t length)
 {
-    char payloadStr[length + 1];
-    memcpy(payloadStr, payload, length);
-    payloadStr[length] = 0; // null terminated string
-    std::unique_ptr<JSONValue> json_value(JSON::Parse(payloadStr));
-    if (json_value == nullptr) {
+    JsonEnvelope json;
+    if (!parseJsonEnvelope((const char *)payload, length, json)) {
         LOG_ERROR("JSON received payload on MQTT but not a valid JSON");
         return;
     }
 
-    JSONObject json;
-    json = json_value->AsObject();
-
-    if (!isValidJsonEnvelope(json)) {
+    // only accept message if the "from" is us, and it has a type and payload
+    if (json.fromUs || !json.validHopLimit || !json.hasFrom || json.from != nodeDB->getNodeNum() || !json.hasType ||
+        !json.hasPayload) {
         LOG_ERROR("JSON received payload on MQTT but not a valid envelope");
         return;
     }
 
     // this is a valid envelope
-    if (json["type"]->AsString().compare("sendtext") == 0 && json["payload"]->IsString()) {
-        std::string jsonPayloadStr = json["payload"]->AsString();
-        LOG_INFO("JSON payload %s, length %u", jsonPayloadStr.c_str(), jsonPayloadStr.length());
+    if (strcmp(json.type, "sendtext") == 0 && json.payloadIsText) {
+        LOG_INFO("JSON payload %s, length %u", json.text, json.textLen);
 
         // construct protobuf data packet using TEXT_MESSAGE, send it to the mesh
         meshtastic_MeshPacket *p = router->allocForSending();
         p->decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
-        if (json.find("channel") != json.end() && json["channel"]->IsNumber() &&
-            (json["channel"]->AsNumber() < channels.getNumChannels()))
-            p->channel = json["channel"]->AsNumber();
-        if (json.find("to") != json.end() && json["to"]->IsNumber())
-            p->to = json["to"]->AsNumber();
-        if (json.find("hopLimit") != json.end() && json["hopLimit"]->IsNumber())
-            p->hop_limit = json["hopLimit"]->AsNumber();
-        if (jsonPayloadStr.length() <= sizeof(p->decoded.payload.bytes)) {
-            memcpy(p->decoded.payload.bytes, jsonPayloadStr.c_str(), jsonPayloadStr.length());
-            p->decoded.payload.size = jsonPayloadStr.length();
+        if (json.hasChannel && json.channel < channels.getNumChannels())
+            p->channel = json.channel;
+        if (json.hasTo)
+            p->to = json.to;
+        if (json.hasHopLimit)
+            p->hop_limit = json.hopLimit;
+        if (json.textLen <= sizeof(p->decoded.payload.bytes)) {
+            memcpy(p->decoded.payload.bytes, json.text, json.textLen);
+            p->decoded.payload.size = json.textLen;
             service->sendToMesh(p, RX_SRC_LOCAL);
         } else {
             LOG_WARN("Received MQTT json payload too long, drop");
         }
-    } else if (json["type"]->AsString().compare("sendposition") == 0 && json["payload"]->IsObject()) {
+    } else if (strcmp(json.type, "sendposition") == 0 && json.payloadIsPosition) {
         // invent the "sendposition" type for a valid envelope
-        JSONObject posit;
-        posit = json["payload"]->AsObject(); // get nested JSON Position
-        meshtastic_Position pos = meshtastic_Position_init_default;
-        if (posit.find("latitude_i") != posit.end() && posit["latitude_i"]->IsNumber())
-            pos.latitude_i = posit["latitude_i"]->AsNumber();
-        if (posit.find("longitude_i") != posit.end() && posit["longitude_i"]->IsNumber())
-            pos.longitude_i = posit["longitude_i"]->AsNumber();
-        if (posit.find("altitude") != posit.end() && posit["altitude"]->IsNumber())
-            pos.altitude = posit["altitude"]->AsNumber();
-        if (posit.find("time") != posit.end() && posit["time"]->IsNumber())
-            pos.time = posit["time"]->AsNumber();
-
         // construct protobuf data packet using POSITION, send it to the mesh
         meshtastic_MeshPacket *p = router->allocForSending();
         p->decoded.portnum = meshtastic_PortNum_POSITION_APP;
-        if (json.find("channel") != json.end() && json["channel"]->IsNumber() &&
-            (json["channel"]->AsNumber() < channels.getNumChannels()))
-            p->channel = json["channel"]->AsNumber();
-        if (json.find("to") != json.end() && json["to"]->IsNumber())
-            p->to = json["to"]->AsNumber();
-        if (json.find("hopLimit") != json.end() && json["hopLimit"]->IsNumber())
-            p->hop_limit = json["hopLimit"]->AsNumber();
+        if (json.hasChannel && json.channel < channels.getNumChannels())
+            p->channel = json.channel;
+        if (json.hasTo)
+            p->to = json.to;
+        if (json.hasHopLimit)
+            p->hop_limit = json.hopLimit;
         p->decoded.payload.size =
             pb_encode_to_bytes(p->decoded.payload.bytes, sizeof(p->decoded.payload.bytes), &meshtastic_Position_msg,
-                               &pos); // make the Data protobuf from position
+                               &json.pos); // make the Data protobuf from position
         service->sendToMesh(p, RX_SRC_LOCAL);
     } else {
         LOG_DEBUG("JSON ignore downlink message with unsupported type");
@@ -349,15 +461,10 @@ void MQTT::onReceive(char *topic, byte *payload, size_t length)
     // check if this is a json payload message by comparing the topic start
     if (moduleConfig.mqtt.json_enabled && (strncmp(topic, jsonTopic.c_str(), jsonTopic.length()) == 0)) {
 #if !defined(ARCH_NRF52) || NRF52_USE_JSON
-        // parse the channel name from the topic string
-        // the topic has been checked above for having jsonTopic prefix, so just move past it
-        char *channelName = topic + jsonTopic.length();
-        // if another "/" was added, parse string up to that character
-        channelName = strtok(channelName, "/") ? strtok(channelName, "/") : channelName;
+        // The channel name follows the jsonTopic prefix, up to the next "/" if there is one
+        const char *channelName = topic + jsonTopic.length();
         // We allow downlink JSON packets only on a channel named "mqtt"
-        const meshtastic_Channel &sendChannel = channels.getByName(channelName);
-        if (!(strncasecmp(channels.getGlobalId(sendChannel.index), Channels::mqttChannel, strlen(Channels::mqttChannel)) == 0 &&
-              sendChannel.settings.downlink_enabled)) {
+        if (!getDownlinkChannel(channelName, strcspn(channelName, "/")).json) {
             LOG_WARN("JSON downlink received on channel not called 'mqtt' or without downlink enabled");
             return;
         }
@@ -366,7 +473,43 @@ void MQTT::onReceive(char *topic, byte *payload, size_t length)
         return;
     }
 
-    onReceiveProto(topic, payload, length);
+    // On a busy broker most envelopes are for channels we don't downlink, drop those before decoding the packet
+    EnvelopeIds ids;
+    if (!peekServiceEnvelope(payload, length, ids)) {
+        LOG_ERROR("Invalid MQTT service envelope, topic %s, len %u!", topic, length);
+        return;
+    }
+    const DownlinkChannel &ch = getDownlinkChannel(ids.channelId, ids.channelIdLen);
+    bool accept = idEquals(ids.channelId, ids.channelIdLen, "PKI") ||
+                  (ch.downlink && ch.idLen == ids.channelIdLen && memcmp(ch.id, ids.channelId, ch.idLen) == 0);
+    // Our own envelopes coming back are still decoded, they may be an implicit ACK
+    if (!accept && !idEquals(ids.gatewayId, ids.gatewayIdLen, owner.id))
+        return;
+
+    onReceiveProto(topic, payload, length, ch.index, accept);
+}
+
+const MQTT::DownlinkChannel &MQTT::getDownlinkChannel(const char *id, size_t idLen)
+{
+    if (downlinkChannelCount == 0) {
+        for (ChannelIndex i = 0; i < channels.getNumChannels() && i < MAX_NUM_CHANNELS; i++) {
+            DownlinkChannel &c = downlinkChannels[i];
+            strncpy(c.id, channels.getGlobalId(i), sizeof(c.id) - 1);
+            c.id[sizeof(c.id) - 1] = '\0';
+            c.idLen = strlen(c.id);
+            c.index = i;
+            c.downlink = channels.getByIndex(i).settings.downlink_enabled;
+            c.json = c.downlink && strncasecmp(c.id, Channels::mqttChannel, strlen(Channels::mqttChannel)) == 0;
+            downlinkChannelCount++;
+        }
+    }
+
+    for (uint8_t i = 0; i < downlinkChannelCount; i++) {
+        const DownlinkChannel &c = downlinkChannels[i];
+        if (c.idLen == idLen && strncasecmp(c.id, id, idLen) == 0)
+            return c;
+    }
+    return downlinkChannels[channels.getPrimaryIndex()];
 }
 
 void mqttInit()
@@ -377,9 +520,9 @@ void mqttInit()
 #if HAS_NETWORKING
 MQTT::MQTT() : MQTT(std::unique_ptr<MQTTClient>(new MQTTClient())) {}
 MQTT::MQTT(std::unique_ptr<MQTTClient> _mqttClient)
-    : concurrency::OSThread("mqtt"), mqttQueue(MAX_MQTT_QUEUE), mqttClient(std::move(_mqttClient)), pubSub(*mqttClient)
+    : concurrency::OSThread("mqtt"), mqttQueue(MQTT_QUEUE_BYTES), mqttClient(std::move(_mqttClient)), pubSub(*mqttClient)
 #else
-MQTT::MQTT() : concurrency::OSThread("mqtt"), mqttQueue(MAX_MQTT_QUEUE)
+MQTT::MQTT() : concurrency::OSThread("mqtt"), mqttQueue(MQTT_QUEUE_BYTES)
 #endif
 {
     if (moduleConfig.mqtt.enabled) {
@@ -387,6 +530,9 @@ MQTT::MQTT() : concurrency::OSThread("mqtt"), mqttQueue(MAX_MQTT_QUEUE)
 
         assert(!mqtt);
         mqtt = this;
+#if MQTT_SPILL_TO_FLASH
+        mqttQueue.setEvictCallback(spillToFlash);
+#endif
 
         if (*moduleConfig.mqtt.root) {
             cryptTopic = moduleConfig.mqtt.root + cryptTopic;
@@ -527,6 +673,7 @@ void MQTT::reconnect()
 
 void MQTT::sendSubscriptions()
 {
+    onChannelsChanged(); // the names of unnamed channels follow the modem preset
 #if HAS_NETWORKING
     bool hasDownlink = false;
     size_t numChan = channels.getNumChannels();
@@ -591,6 +738,8 @@ int32_t MQTT::runOnce()
         if (!wantConnection) {
             LOG_INFO("MQTT link not needed, drop");
             pubSub.disconnect();
+        } else {
+            publishQueuedMessages(); // the next batch of whatever queued up while we were offline
         }
 
         powerFSM.trigger(EVENT_CONTACT_FROM_PHONE); // Suppress entering light sleep (because that would turn off bluetooth)
@@ -647,37 +796,45 @@ void MQTT::publishNodeInfo()
 }
 void MQTT::publishQueuedMessages()
 {
+#if MQTT_SPILL_TO_FLASH
+    if (mqttQueue.isEmpty())
+        refillFromFlash();
+#endif
     if (mqttQueue.isEmpty())
         return;
 
-    LOG_DEBUG("Publish enqueued MQTT message");
-    const std::unique_ptr<QueueEntry> entry(mqttQueue.dequeuePtr(0));
-    LOG_INFO("publish %s, %u bytes from queue", entry->topic.c_str(), entry->envBytes.size());
-    publish(entry->topic.c_str(), entry->envBytes.data(), entry->envBytes.size(), false);
-
-#if !defined(ARCH_NRF52) ||                                                                                                      \
-    defined(NRF52_USE_JSON) // JSON is not supported on nRF52, see issue #2804 ### Fixed by using ArduinoJson ###
-    if (!moduleConfig.mqtt.json_enabled)
-        return;
-
-    // handle json topic
-    const DecodedServiceEnvelope env(entry->envBytes.data(), entry->envBytes.size());
-    if (!env.validDecode || env.packet == NULL || env.channel_id == NULL)
-        return;
-
-    auto jsonString = MeshPacketSerializer::JsonSerialize(env.packet);
-    if (jsonString.length() == 0)
-        return;
-
-    std::string topicJson;
-    if (env.packet->pki_encrypted) {
-        topicJson = jsonTopic + "PKI/" + owner.id;
-    } else {
-        topicJson = jsonTopic + env.channel_id + "/" + owner.id;
+    LOG_DEBUG("Publish up to %d of %u enqueued MQTT messages", MQTT_PUBLISH_BATCH, mqttQueue.size());
+    uint32_t start = millis();
+    for (int i = 0; i < MQTT_PUBLISH_BATCH && millis() - start < MQTT_PUBLISH_BUDGET_MS; i++) {
+        const char *topic;
+        const uint8_t *bytes;
+        size_t len;
+        bool text;
+        if (!mqttQueue.front(topic, bytes, len, text))
+            break;
+
+        // A JSON entry was rendered when its packet was queued, there is nothing to decode here
+        LOG_INFO("publish %s, %u bytes from queue", topic, len);
+        if (!(text ? publish(topic, (const char *)bytes, false) : publish(topic, bytes, len, false)))
+            break; // lost the server again, keep this one for next time
+        mqttQueue.pop();
     }
-    LOG_INFO("JSON publish message to %s, %u bytes: %s", topicJson.c_str(), jsonString.length(), jsonString.c_str());
-    publish(topicJson.c_str(), jsonString.c_str(), false);
-#endif // ARCH_NRF52 NRF52_USE_JSON
+}
+
+const MQTT::UplinkTopics &MQTT::getUplinkTopics(const char *channelId)
+{
+    const size_t numSlots = sizeof(uplinkTopics) / sizeof(uplinkTopics[0]);
+    for (size_t i = 0; i < numSlots; i++)
+        if (!uplinkTopics[i].crypt.empty() && uplinkTopics[i].channelId == channelId)
+            return uplinkTopics[i];
+
+    // First time we've seen this channel id (or it was renamed), build its topics
+    UplinkTopics &t = uplinkTopics[nextUplinkTopics];
+    nextUplinkTopics = (nextUplinkTopics + 1) % numSlots;
+    t.channelId = channelId;
+    t.crypt = cryptTopic + channelId + "/" + owner.id;
+    t.json = jsonTopic + channelId + "/" + owner.id;
+    return t;
 }
 
 void MQTT::onSend(const meshtastic_MeshPacket &mp_encrypted, const meshtastic_MeshPacket &mp_decoded, ChannelIndex chIndex)
@@ -734,7 +891,8 @@ void MQTT::onSend(const meshtastic_MeshPacket &mp_encrypted, const meshtastic_Me
     const meshtastic_ServiceEnvelope env = {
         .packet = const_cast<meshtastic_MeshPacket *>(p), .channel_id = const_cast<char *>(channelId), .gateway_id = owner.id};
     size_t numBytes = pb_encode_to_bytes(bytes, sizeof(bytes), &meshtastic_ServiceEnvelope_msg, &env);
-    std::string topic = cryptTopic + channelId + "/" + owner.id;
+    const UplinkTopics &topics = getUplinkTopics(channelId);
+    const std::string &topic = topics.crypt;
 
     if (moduleConfig.mqtt.proxy_to_client_enabled || this->isConnectedDirectly()) {
         LOG_DEBUG("MQTT Publish %s, %u bytes", topic.c_str(), numBytes);
@@ -742,33 +900,112 @@ void MQTT::onSend(const meshtastic_MeshPacket &mp_encrypted, const meshtastic_Me
 
 #if !defined(ARCH_NRF52) ||                                                                                                      \
     defined(NRF52_USE_JSON) // JSON is not supported on nRF52, see issue #2804 ### Fixed by using ArduinoJson ###
-        if (!moduleConfig.mqtt.json_enabled)
+        // Nothing to render (or nobody to render it for) if we couldn't decode it
+        if (!moduleConfig.mqtt.json_enabled || mp_decoded.which_payload_variant != meshtastic_MeshPacket_decoded_tag)
             return;
         // handle json topic
         auto jsonString = MeshPacketSerializer::JsonSerialize(&mp_decoded);
         if (jsonString.length() == 0)
             return;
-        std::string topicJson = jsonTopic + channelId + "/" + owner.id;
+        const std::string &topicJson = topics.json;
         LOG_INFO("JSON publish message to %s, %u bytes: %s", topicJson.c_str(), jsonString.length(), jsonString.c_str());
         publish(topicJson.c_str(), jsonString.c_str(), false);
 #endif // ARCH_NRF52 NRF52_USE_JSON
     } else {
         LOG_INFO("MQTT not connected, queue packet");
-        QueueEntry *entry;
-        if (mqttQueue.numFree() == 0) {
-            LOG_WARN("MQTT queue is full, discard oldest");
-            entry = mqttQueue.dequeuePtr(0);
-        } else {
-            entry = new QueueEntry;
+        if (!mqttQueue.push(topic.c_str(), bytes, numBytes)) {
+            LOG_WARN("Failed to add a message to mqttQueue!");
+            return;
         }
-        entry->topic = std::move(topic);
-        entry->envBytes.assign(bytes, numBytes);
-        if (mqttQueue.enqueue(entry, 0) == false) {
-            LOG_CRIT("Failed to add a message to mqttQueue!");
-            abort();
+
+#if !defined(ARCH_NRF52) ||                                                                                                      \
+    defined(NRF52_USE_JSON) // JSON is not supported on nRF52, see issue #2804 ### Fixed by using ArduinoJson ###
+        // Render the JSON now, while we have the decoded packet, and queue it right behind its envelope
+        if (!moduleConfig.mqtt.json_enabled || mp_decoded.which_payload_variant != meshtastic_MeshPacket_decoded_tag)
+            return;
+        auto jsonString = MeshPacketSerializer::JsonSerialize(&mp_decoded);
+        if (jsonString.length() == 0)
+            return;
+        // Counting the null terminator, and no longer than an envelope so it can be spilled and refilled like one
+        size_t jsonLen = jsonString.length() + 1;
+        if (jsonLen > sizeof(bytes) ||
+            !mqttQueue.push(topics.json.c_str(), (const uint8_t *)jsonString.c_str(), jsonLen, true))
+            LOG_WARN("Failed to add JSON to mqttQueue!");
+#endif // ARCH_NRF52 NRF52_USE_JSON
+    }
+}
+
+#if MQTT_SPILL_TO_FLASH
+static const char *mqttSpillFile = "/mqtt_spill";
+static bool mqttSpillPending = true; // there may be one left from before we rebooted
+
+// Each spilled entry is [u16 length, top bit set for text][u8 topic length][topic][envelope or text]
+static const uint16_t SPILL_TEXT_FLAG = 0x8000;
+
+void MQTT::spillToFlash(const char *topic, const uint8_t *bytes, size_t len, bool text)
+{
+    concurrency::LockGuard g(fsLock);
+    File f = FSCom.open(mqttSpillFile, "a");
+    if (!f)
+        return;
+    size_t topicLen = strlen(topic);
+    if (f.size() + 3 + topicLen + len > MQTT_SPILL_MAX_BYTES || topicLen > UINT8_MAX) {
+        f.close();
+        return; // spill is full too, this one is lost
+    }
+    uint16_t flagged = len | (text ? SPILL_TEXT_FLAG : 0);
+    uint8_t header[3] = {(uint8_t)flagged, (uint8_t)(flagged >> 8), (uint8_t)topicLen};
+    f.write(header, sizeof(header));
+    f.write((const uint8_t *)topic, topicLen);
+    f.write(bytes, len);
+    f.close();
+    invalidateFileManifest();
+    mqttSpillPending = true;
+}
+
+void MQTT::refillFromFlash()
+{
+    if (!mqttSpillPending)
+        return;
+
+    concurrency::LockGuard g(fsLock);
+    File f = FSCom.open(mqttSpillFile, FILE_O_READ);
+    if (!f) {
+        mqttSpillPending = false;
+        return;
+    }
+
+    // Only move back what fits without evicting, or we'd just spill it again
+    size_t moved = 0;
+    f.seek(spillReadOffset);
+    uint8_t header[3];
+    char topic[UINT8_MAX + 1];
+    while (moved + sizeof(bytes) < MQTT_QUEUE_BYTES / 2 && f.read(header, sizeof(header)) == sizeof(header)) {
+        uint16_t flagged = header[0] | (header[1] << 8);
+        size_t len = flagged & ~SPILL_TEXT_FLAG;
+        if (len > sizeof(bytes) || f.read((uint8_t *)topic, header[2]) != header[2] || f.read(bytes, len) != len) {
+            LOG_WARN("MQTT spill file is corrupt, discard rest");
+            spillReadOffset = f.size();
+            break;
         }
+        topic[header[2]] = '\0';
+        mqttQueue.push(topic, bytes, len, flagged & SPILL_TEXT_FLAG);
+        spillReadOffset += sizeof(header) + header[2] + len;
+        moved += sizeof(header) + header[2] + len;
+    }
+
+    bool done = spillReadOffset >= f.size();
+    f.close();
+    if (moved)
+        LOG_INFO("Moved %u MQTT messages back from flash", mqttQueue.size());
+    if (done) {
+        FSCom.remove(mqttSpillFile);
+        invalidateFileManifest();
+        spillReadOffset = 0;
+        mqttSpillPending = false;
     }
 }
+#endif
 
 void MQTT::perhapsReportToMap()
 {
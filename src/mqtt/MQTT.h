@@ -6,6 +6,7 @@
 #include "concurrency/OSThread.h"
 #include "mesh/Channels.h"
 #include "mesh/generated/meshtastic/mqtt.pb.h"
+#include "mqtt/MQTTQueue.h"
 #if !defined(ARCH_NRF52) || NRF52_USE_JSON
 #include "serialization/JSON.h"
 #endif
@@ -24,7 +25,34 @@
 #include <memory>
 #endif
 
-#define MAX_MQTT_QUEUE 16
+/// Bytes of ServiceEnvelopes we keep for the server while it is unreachable, oldest are dropped (or spilled) beyond that
+#ifndef MQTT_QUEUE_BYTES
+#ifdef ARCH_PORTDUINO
+#define MQTT_QUEUE_BYTES 65536
+#else
+#define MQTT_QUEUE_BYTES 8192
+#endif
+#endif
+
+/// Most queued messages we publish per runOnce(), and the time we may spend on them, so catching up after an outage doesn't
+/// hog the main loop
+#ifndef MQTT_PUBLISH_BATCH
+#define MQTT_PUBLISH_BATCH 16
+#endif
+#ifndef MQTT_PUBLISH_BUDGET_MS
+#define MQTT_PUBLISH_BUDGET_MS 50
+#endif
+
+/// Set to 1 to append messages that don't fit in the queue to a file, and publish them once the server is back (flash wear!)
+#ifndef MQTT_SPILL_TO_FLASH
+#define MQTT_SPILL_TO_FLASH 0
+#endif
+#ifndef MQTT_SPILL_MAX_BYTES
+#define MQTT_SPILL_MAX_BYTES (64 * 1024)
+#endif
+#if MQTT_SPILL_TO_FLASH && !defined(ARCH_ESP32) && !defined(ARCH_PORTDUINO)
+#error "MQTT_SPILL_TO_FLASH needs a filesystem that can append, only ESP32 and portduino for now"
+#endif
 
 /**
  * Our wrapper/singleton for sending/receiving MQTT "udp" packets.  This object isolates the MQTT protocol implementation from
@@ -64,12 +92,11 @@ class MQTT : private concurrency::OSThread
     /// Validate the meshtastic_ModuleConfig_MQTTConfig.
     static bool isValidConfig(const meshtastic_ModuleConfig_MQTTConfig &config) { return isValidConfig(config, nullptr); }
 
+    /// The channel settings changed, rebuild the downlink channel index before the next message
+    void onChannelsChanged() { downlinkChannelCount = 0; }
+
   protected:
-    struct QueueEntry {
-        std::string topic;
-        std::basic_string<uint8_t> envBytes; // binary/pb_encode_to_bytes ServiceEnvelope
-    };
-    PointerQueue<QueueEntry> mqttQueue;
+    MQTTQueue mqttQueue; // encoded ServiceEnvelopes, each followed by its JSON if enabled, waiting for the server
 
     int reconnectCount = 0;
     bool isConfiguredForDefaultServer = true;
@@ -105,6 +132,31 @@ class MQTT : private concurrency::OSThread
     std::string jsonTopic = "/2/json/"; // msh/2/json/CHANNELID/NODEID
     std::string mapTopic = "/2/map/";   // For protobuf-encoded MapReport messages
 
+    /// The topics we uplink a channel's packets to, built once per channel rather than for every packet
+    struct UplinkTopics {
+        std::string channelId; // or "PKI"
+        std::string crypt;     // cryptTopic + channelId + "/" + owner.id
+        std::string json;      // jsonTopic + channelId + "/" + owner.id
+    };
+    UplinkTopics uplinkTopics[MAX_NUM_CHANNELS + 1]; // one more for PKI
+    uint8_t nextUplinkTopics = 0;                    // slot to reuse if a channel id we haven't seen turns up
+
+    const UplinkTopics &getUplinkTopics(const char *channelId);
+
+    /// A channel's global id and what we accept from MQTT on it, so received messages don't search the channels by name
+    struct DownlinkChannel {
+        char id[24]; // the name, or for an unnamed channel its modem preset name
+        uint8_t idLen;
+        ChannelIndex index;
+        bool downlink; // downlink_enabled
+        bool json;     // downlink_enabled and named "mqtt", JSON downlink is only allowed there
+    };
+    DownlinkChannel downlinkChannels[MAX_NUM_CHANNELS];
+    uint8_t downlinkChannelCount = 0; // 0 until built
+
+    /// @return the channel with this global id (not null terminated, compared ignoring case), or else the primary channel
+    const DownlinkChannel &getDownlinkChannel(const char *id, size_t idLen);
+
     // For map reporting (only applies when enabled)
     const uint32_t default_map_position_precision = 14; // defaults to max. offset of ~1459m
     uint32_t last_report_to_map = 0;
@@ -129,6 +181,16 @@ class MQTT : private concurrency::OSThread
 
     void publishQueuedMessages();
 
+#if MQTT_SPILL_TO_FLASH
+    /// Queue eviction callback, appends the entry to the spill file
+    static void spillToFlash(const char *topic, const uint8_t *bytes, size_t len, bool text);
+
+    /// Move spilled entries back into the (empty) queue
+    void refillFromFlash();
+
+    uint32_t spillReadOffset = 0; // how much of the spill file has been moved back to the queue
+#endif
+
     void publishNodeInfo();
 
     // Check if we should report unencrypted information about our node for consumption by a map
@@ -0,0 +1,114 @@
+#include "MQTTQueue.h"
+#include "configuration.h"
+#include "memGet.h"
+#include <string.h>
+
+size_t MQTTQueue::entryAt(size_t pos) const
+{
+    if (capacity - pos < HEADER_LEN)
+        return 0; // no room for a wrap marker at the very end
+    uint16_t len;
+    memcpy(&len, buf + pos, sizeof(len));
+    return len == WRAP ? 0 : pos;
+}
+
+size_t MQTTQueue::findSpace(size_t need) const
+{
+    if (count == 0)
+        return 0;
+    if (tail > head) {
+        // Entries fill [head, tail), we can use the rest of the ring or wrap around to the start
+        if (capacity - tail >= need)
+            return tail;
+        return need <= head ? 0 : capacity;
+    }
+    // We have wrapped, entries fill [head, capacity) and [0, tail)
+    return (head - tail >= need) ? tail : capacity;
+}
+
+int MQTTQueue::internTopic(const char *topic)
+{
+    for (size_t i = 0; i < topics.size(); i++)
+        if (topics[i] == topic)
+            return i;
+    if (topics.size() >= maxTopics)
+        return -1;
+    topics.push_back(topic);
+    return topics.size() - 1;
+}
+
+bool MQTTQueue::push(const char *topic, const uint8_t *bytes, size_t len, bool text)
+{
+    size_t need = HEADER_LEN + len;
+    if (2 * need > capacity)
+        return false;
+
+    if (!buf) {
+        buf = (uint8_t *)memGet.allocCold(capacity);
+        if (!buf)
+            return false;
+    }
+
+    size_t pos;
+    while ((pos = findSpace(need)) == capacity) {
+        const char *oldTopic;
+        const uint8_t *oldBytes;
+        size_t oldLen;
+        bool oldText;
+        front(oldTopic, oldBytes, oldLen, oldText);
+        if (onEvict)
+            onEvict(oldTopic, oldBytes, oldLen, oldText);
+        evicted++;
+        pop();
+    }
+
+    int topicIndex = internTopic(topic); // after evicting, which may have emptied the queue and so the topic table
+    if (topicIndex < 0)
+        return false;
+
+    if (count == 0)
+        head = 0;
+    else if (pos == 0 && tail != 0 && capacity - tail >= HEADER_LEN) {
+        uint16_t wrap = WRAP;
+        memcpy(buf + tail, &wrap, sizeof(wrap));
+    }
+
+    uint16_t len16 = len;
+    memcpy(buf + pos, &len16, sizeof(len16));
+    buf[pos + 2] = topicIndex | (text ? TEXT_FLAG : 0);
+    if (len)
+        memcpy(buf + pos + HEADER_LEN, bytes, len);
+    tail = pos + need;
+    count++;
+    return true;
+}
+
+bool MQTTQueue::front(const char *&topic, const uint8_t *&bytes, size_t &len, bool &text) const
+{
+    if (count == 0)
+        return false;
+
+    size_t pos = entryAt(head);
+    uint16_t len16;
+    memcpy(&len16, buf + pos, sizeof(len16));
+    topic = topics[buf[pos + 2] & ~TEXT_FLAG].c_str();
+    bytes = buf + pos + HEADER_LEN;
+    len = len16;
+    text = buf[pos + 2] & TEXT_FLAG;
+    return true;
+}
+
+void MQTTQueue::pop()
+{
+    if (count == 0)
+        return;
+
+    size_t pos = entryAt(head);
+    uint16_t len16;
+    memcpy(&len16, buf + pos, sizeof(len16));
+    head = pos + HEADER_LEN + len16;
+    if (--count == 0) {
+        head = tail = 0;
+        topics.clear();
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+/**
+ * A FIFO of encoded ServiceEnvelopes (and their JSON renderings) waiting for the MQTT server, kept in one byte ring so queueing
+ * never allocates.
+ *
+ * Each entry is its topic (interned, as there are only a handful: one per channel), whether it is text and its bytes, stored
+ * contiguously so front() can hand out a plain pointer.  When the ring is full the oldest entries are evicted (and passed to
+ * the eviction callback, if any).  The ring itself is allocated the first time something is queued, so nodes that never lose
+ * their server don't pay for it.
+ */
+class MQTTQueue
+{
+  public:
+    /// Called with every entry that has to make room for a newer one
+    typedef void (*EvictCallback)(const char *topic, const uint8_t *bytes, size_t len, bool text);
+
+    /// @param capacity bytes for the ring, must be at least twice the largest entry plus 3 bytes
+    /// @param maxTopics at most 128
+    explicit MQTTQueue(size_t capacity, size_t maxTopics = 16) : capacity(capacity), maxTopics(maxTopics) {}
+    ~MQTTQueue() { free(buf); }
+
+    void setEvictCallback(EvictCallback cb) { onEvict = cb; }
+
+    /// Queue a copy of bytes for topic, evicting the oldest entries if needed
+    /// @param text bytes are a null terminated string (counted in len) to publish as text, rather than binary
+    /// @return false if it could not be queued (too big, too many different topics or out of memory)
+    bool push(const char *topic, const uint8_t *bytes, size_t len, bool text = false);
+
+    /// @return false if empty, else the oldest entry (valid until the next push or pop)
+    bool front(const char *&topic, const uint8_t *&bytes, size_t &len, bool &text) const;
+
+    /// Remove the oldest entry
+    void pop();
+
+    bool isEmpty() const { return count == 0; }
+
+    /// @return the number of queued entries
+    size_t size() const { return count; }
+
+    /// @return the number of entries evicted to make room since boot
+    uint32_t getEvicted() const { return evicted; }
+
+  private:
+    enum : uint16_t { WRAP = 0xffff };
+    static const size_t HEADER_LEN = 3; // u16 length, u8 topic index
+    static const uint8_t TEXT_FLAG = 0x80; // in the topic index byte
+
+    uint8_t *buf = NULL;
+    size_t capacity, maxTopics;
+    size_t head = 0, tail = 0, count = 0;
+    uint32_t evicted = 0;
+    EvictCallback onEvict = NULL;
+    std::vector<std::string> topics; // interned topics, cleared whenever the queue empties
+
+    /// @return the position of the entry at or after pos, skipping the end of the ring if we wrapped there
+    size_t entryAt(size_t pos) const;
+
+    /// @return where an entry of need bytes can be written, or capacity if it doesn't fit without evicting
+    size_t findSpace(size_t need) const;
+
+    int internTopic(const char *topic);
+};
@@ -1,6 +1,8 @@
 #include "configuration.h"
 #if !MESHTASTIC_EXCLUDE_BLUETOOTH
 #include "BluetoothCommon.h"
+#include "BluetoothLogBatch.h"
+#include "BluetoothPhoneAPIBase.h"
 #include "NimbleBluetooth.h"
 #include "PowerFSM.h"
 
@@ -10,22 +12,27 @@
 #include "sleep.h"
 #include <NimBLEDevice.h>
 
+/// Largest ATT MTU we ask for, enough for a full 512 byte attribute value in one read response
+#define BLE_MTU_MAX 517
+/// Largest link layer payload for data length extension
+#define BLE_DATA_LEN_MAX 251
+
 NimBLECharacteristic *fromNumCharacteristic;
 NimBLECharacteristic *BatteryCharacteristic;
 NimBLECharacteristic *logRadioCharacteristic;
 NimBLEServer *bleServer;
+#if BLE_LOG_BATCHING
+NimBLECharacteristic *logRadioPackedCharacteristic;
+static uint16_t connHandle;
+#endif
 
 static bool passkeyShowing;
 
-class BluetoothPhoneAPI : public PhoneAPI
+class BluetoothPhoneAPI : public BluetoothPhoneAPIBase
 {
-    /**
-     * Subclasses can use this as a hook to provide custom notifications for their transport (i.e. bluetooth notifies)
-     */
-    virtual void onNowHasData(uint32_t fromRadioNum)
+    /// Called by BluetoothPhoneAPIBase, which merges notifications that come in quick succession
+    virtual void notifyFromNum(uint32_t fromRadioNum) override
     {
-        PhoneAPI::onNowHasData(fromRadioNum);
-
         LOG_DEBUG("BLE notify fromNum");
 
         uint8_t val[4];
@@ -40,6 +47,21 @@ class BluetoothPhoneAPI : public PhoneAPI
 };
 
 static BluetoothPhoneAPI *bluetoothPhoneAPI;
+
+#if BLE_LOG_BATCHING
+class NimbleLogBatch : public BluetoothLogBatch
+{
+    virtual bool notifyBatch(const uint8_t *buf, size_t len) override
+    {
+        logRadioPackedCharacteristic->notify(buf, len, true);
+        return true; // NimBLE queues it or drops it itself, BLE_LOG_BATCH_MSEC keeps us from flooding it
+    }
+
+    virtual size_t maxNotifyLen() override { return bleServer->getPeerMTU(connHandle) - 3; }
+};
+
+static NimbleLogBatch *logBatch;
+#endif
 /**
  * Subclasses can use this as a hook to provide custom notifications for their transport (i.e. bluetooth notifies)
  */
@@ -77,8 +99,29 @@ class NimbleBluetoothFromRadioCallback : public NimBLECharacteristicCallbacks
     }
 };
 
+class NimbleBluetoothFromRadioPackedCallback : public NimBLECharacteristicCallbacks
+{
+    virtual void onRead(NimBLECharacteristic *pCharacteristic, ble_gap_conn_desc *desc)
+    {
+        // Fill a single ATT read response if we can, long reads cost a round trip for every MTU - 1 bytes
+        static uint8_t packedBytes[BLE_PACKED_FROMRADIO_SIZE];
+        size_t numBytes = bluetoothPhoneAPI->getPackedFromRadio(packedBytes, bleServer->getPeerMTU(desc->conn_handle) - 1);
+
+        pCharacteristic->setValue(packedBytes, numBytes);
+    }
+};
+
 class NimbleBluetoothServerCallback : public NimBLEServerCallbacks
 {
+    virtual void onConnect(NimBLEServer *pServer, ble_gap_conn_desc *desc)
+    {
+        // Ask for the longest link layer packets we can get, so a big MTU needs fewer radio packets (data length extension)
+        pServer->setDataLen(desc->conn_handle, BLE_DATA_LEN_MAX);
+#if BLE_LOG_BATCHING
+        connHandle = desc->conn_handle;
+#endif
+    }
+
     virtual uint32_t onPassKeyRequest()
     {
         uint32_t passkey = config.bluetooth.fixed_pin;
@@ -151,11 +194,16 @@ class NimbleBluetoothServerCallback : public NimBLEServerCallbacks
         if (bluetoothPhoneAPI) {
             bluetoothPhoneAPI->close();
         }
+#if BLE_LOG_BATCHING
+        if (logBatch)
+            logBatch->clear();
+#endif
     }
 };
 
 static NimbleBluetoothToRadioCallback *toRadioCallbacks;
 static NimbleBluetoothFromRadioCallback *fromRadioCallbacks;
+static NimbleBluetoothFromRadioPackedCallback *fromRadioPackedCallbacks;
 
 void NimbleBluetooth::shutdown()
 {
@@ -213,6 +261,7 @@ void NimbleBluetooth::setup()
 
     NimBLEDevice::init(getDeviceName());
     NimBLEDevice::setPower(ESP_PWR_LVL_P9);
+    NimBLEDevice::setMTU(BLE_MTU_MAX); // so a whole FromRadio (or several, see FROMRADIOPACKED_UUID) fits in one read
 
     if (config.bluetooth.mode != meshtastic_Config_BluetoothConfig_PairingMode_NO_PIN) {
         NimBLEDevice::setSecurityAuth(BLE_SM_PAIR_AUTHREQ_BOND | BLE_SM_PAIR_AUTHREQ_MITM | BLE_SM_PAIR_AUTHREQ_SC);
@@ -233,26 +282,45 @@ void NimbleBluetooth::setupService()
     NimBLEService *bleService = bleServer->createService(MESH_SERVICE_UUID);
     NimBLECharacteristic *ToRadioCharacteristic;
     NimBLECharacteristic *FromRadioCharacteristic;
+    NimBLECharacteristic *FromRadioPackedCharacteristic;
     // Define the characteristics that the app is looking for
     if (config.bluetooth.mode == meshtastic_Config_BluetoothConfig_PairingMode_NO_PIN) {
         ToRadioCharacteristic = bleService->createCharacteristic(TORADIO_UUID, NIMBLE_PROPERTY::WRITE);
         FromRadioCharacteristic = bleService->createCharacteristic(FROMRADIO_UUID, NIMBLE_PROPERTY::READ);
+        FromRadioPackedCharacteristic =
+            bleService->createCharacteristic(FROMRADIOPACKED_UUID, NIMBLE_PROPERTY::READ, BLE_PACKED_FROMRADIO_SIZE);
         fromNumCharacteristic = bleService->createCharacteristic(FROMNUM_UUID, NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ);
         logRadioCharacteristic =
             bleService->createCharacteristic(LOGRADIO_UUID, NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ, 512U);
+#if BLE_LOG_BATCHING
+        logRadioPackedCharacteristic =
+            bleService->createCharacteristic(LOGRADIOPACKED_UUID, NIMBLE_PROPERTY::NOTIFY, BLE_LOG_BATCH_SIZE);
+#endif
     } else {
         ToRadioCharacteristic = bleService->createCharacteristic(
             TORADIO_UUID, NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_AUTHEN | NIMBLE_PROPERTY::WRITE_ENC);
         FromRadioCharacteristic = bleService->createCharacteristic(
             FROMRADIO_UUID, NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::READ_AUTHEN | NIMBLE_PROPERTY::READ_ENC);
+        FromRadioPackedCharacteristic = bleService->createCharacteristic(
+            FROMRADIOPACKED_UUID, NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::READ_AUTHEN | NIMBLE_PROPERTY::READ_ENC,
+            BLE_PACKED_FROMRADIO_SIZE);
         fromNumCharacteristic =
             bleService->createCharacteristic(FROMNUM_UUID, NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ |
                                                                NIMBLE_PROPERTY::READ_AUTHEN | NIMBLE_PROPERTY::READ_ENC);
         logRadioCharacteristic = bleService->createCharacteristic(
             LOGRADIO_UUID,
             NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::READ_AUTHEN | NIMBLE_PROPERTY::READ_ENC, 512U);
+#if BLE_LOG_BATCHING
+        logRadioPackedCharacteristic = bleService->createCharacteristic(
+            LOGRADIOPACKED_UUID, NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ_AUTHEN | NIMBLE_PROPERTY::READ_ENC,
+            BLE_LOG_BATCH_SIZE);
+#endif
     }
     bluetoothPhoneAPI = new BluetoothPhoneAPI();
+#if BLE_LOG_BATCHING
+    if (!logBatch)
+        logBatch = new NimbleLogBatch();
+#endif
 
     toRadioCallbacks = new NimbleBluetoothToRadioCallback();
     ToRadioCharacteristic->setCallbacks(toRadioCallbacks);
@@ -260,6 +328,9 @@ void NimbleBluetooth::setupService()
     fromRadioCallbacks = new NimbleBluetoothFromRadioCallback();
     FromRadioCharacteristic->setCallbacks(fromRadioCallbacks);
 
+    fromRadioPackedCallbacks = new NimbleBluetoothFromRadioPackedCallback();
+    FromRadioPackedCharacteristic->setCallbacks(fromRadioPackedCallbacks);
+
     bleService->start();
 
     // Setup the battery service
@@ -299,11 +370,17 @@ void NimbleBluetooth::clearBonds()
     NimBLEDevice::deleteAllBonds();
 }
 
-void NimbleBluetooth::sendLog(const uint8_t *logMessage, size_t length)
+void NimbleBluetooth::sendLog(const uint8_t *logMessage, size_t length, meshtastic_LogRecord_Level level)
 {
     if (!bleServer || !isConnected() || length > 512) {
         return;
     }
+#if BLE_LOG_BATCHING
+    if (logBatch && logRadioPackedCharacteristic->getSubscribedCount() > 0) {
+        logBatch->add(level, logMessage, length);
+        return;
+    }
+#endif
     logRadioCharacteristic->notify(logMessage, length, true);
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 #include "BluetoothCommon.h"
+#include "mesh/generated/meshtastic/mesh.pb.h"
 
 class NimbleBluetooth : BluetoothApi
 {
@@ -11,7 +12,7 @@ class NimbleBluetooth : BluetoothApi
     bool isActive();
     bool isConnected();
     int getRssi();
-    void sendLog(const uint8_t *logMessage, size_t length);
+    void sendLog(const uint8_t *logMessage, size_t length, meshtastic_LogRecord_Level level);
 
   private:
     void setupService();
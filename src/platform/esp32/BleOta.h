@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <functional>
 
+// Finds and boots the separate Meshtastic-OTA app, which does the BLE transfer and flash writes
 class BleOta
 {
   public:
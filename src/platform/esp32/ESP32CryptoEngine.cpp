@@ -6,34 +6,100 @@
 class ESP32CryptoEngine : public CryptoEngine
 {
 
-    mbedtls_aes_context aes;
+    /// One expanded key schedule per CryptoEngine key cache slot
+    mbedtls_aes_context aes[CRYPTO_KEY_CACHE_SIZE];
+
+#if !(MESHTASTIC_EXCLUDE_PKI)
+    /// Single block context used by AES-CCM for PKI
+    mbedtls_aes_context blockAes;
+    bool blockKeySet = false;
+
+    /// -1 until the hardware block path has been self tested, then 1 if it may be used or 0 to stay on the software path
+    int8_t hwBlockState = -1;
+#endif
 
   public:
-    ESP32CryptoEngine() { mbedtls_aes_init(&aes); }
+    ESP32CryptoEngine()
+    {
+        for (int i = 0; i < CRYPTO_KEY_CACHE_SIZE; i++)
+            mbedtls_aes_init(&aes[i]);
+#if !(MESHTASTIC_EXCLUDE_PKI)
+        mbedtls_aes_init(&blockAes);
+#endif
+    }
+
+    ~ESP32CryptoEngine()
+    {
+        for (int i = 0; i < CRYPTO_KEY_CACHE_SIZE; i++)
+            mbedtls_aes_free(&aes[i]);
+#if !(MESHTASTIC_EXCLUDE_PKI)
+        mbedtls_aes_free(&blockAes);
+#endif
+    }
 
-    ~ESP32CryptoEngine() { mbedtls_aes_free(&aes); }
+#if !(MESHTASTIC_EXCLUDE_PKI)
+    /// Route the AES-CCM block operations through the AES peripheral (via mbedtls), after a one time known answer test
+    virtual void aesSetKey(const uint8_t *key_bytes, size_t key_len) override
+    {
+        if (hwBlockState < 0) {
+            hwBlockState = 1; // so the self test below exercises the hardware path
+            hwBlockState = aesSelfTest() ? 1 : 0;
+            if (!hwBlockState)
+                LOG_WARN("ESP32 AES self test failed, use software AES");
+        }
+        if (!hwBlockState) {
+            CryptoEngine::aesSetKey(key_bytes, key_len);
+            return;
+        }
+        blockKeySet = key_len != 0 && mbedtls_aes_setkey_enc(&blockAes, key_bytes, key_len * 8) == 0;
+    }
+
+    virtual void aesEncrypt(uint8_t *in, uint8_t *out) override
+    {
+        if (hwBlockState > 0 && blockKeySet)
+            mbedtls_aes_crypt_ecb(&blockAes, MBEDTLS_AES_ENCRYPT, in, out);
+        else
+            CryptoEngine::aesEncrypt(in, out);
+    }
+
+    virtual uint32_t benchmarkTicks() override { return ESP.getCycleCount(); }
+#endif
+
+    virtual void invalidateKeyCache() override
+    {
+        CryptoEngine::invalidateKeyCache();
+        for (int i = 0; i < CRYPTO_KEY_CACHE_SIZE; i++) {
+            mbedtls_aes_free(&aes[i]); // zeroizes the round keys
+            mbedtls_aes_init(&aes[i]);
+        }
+    }
 
     /**
      * Encrypt a packet
      *
-     * @param bytes is updated in place
+     * @param in is read, and out written, they may be the same buffer
      *  TODO: return bool, and handle graciously when something fails
      */
-    virtual void encryptAESCtr(CryptoKey _key, uint8_t *_nonce, size_t numBytes, uint8_t *bytes) override
+    using CryptoEngine::encryptAESCtr;
+    virtual void encryptAESCtr(CryptoKey _key, uint8_t *_nonce, size_t numBytes, const uint8_t *in, uint8_t *out) override
     {
         if (_key.length > 0) {
             if (numBytes <= MAX_BLOCKSIZE) {
-                mbedtls_aes_setkey_enc(&aes, _key.bytes, _key.length * 8);
-                static uint8_t scratch[MAX_BLOCKSIZE];
+                bool isNew;
+                int slot = findKeySlot(_key, isNew);
+                if (isNew)
+                    mbedtls_aes_setkey_enc(&aes[slot], _key.bytes, _key.length * 8);
                 uint8_t stream_block[16];
                 size_t nc_off = 0;
-                memcpy(scratch, bytes, numBytes);
-                memset(scratch + numBytes, 0,
-                       sizeof(scratch) - numBytes); // Fill rest of buffer with zero (in case cypher looks at it)
-                mbedtls_aes_crypt_ctr(&aes, numBytes, &nc_off, _nonce, stream_block, scratch, bytes);
+                // mbedtls allows input and output to be the same buffer, so no scratch copy is needed
+                mbedtls_aes_crypt_ctr(&aes[slot], numBytes, &nc_off, _nonce, stream_block, in, out);
             } else {
                 LOG_ERROR("Packet too large for crypto engine: %d. noop encryption!", numBytes);
+                if (out != in)
+                    memcpy(out, in, numBytes);
             }
+        } else if (out != in) {
+            memcpy(out, in, numBytes);
         }
     }
 };
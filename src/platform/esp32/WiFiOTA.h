@@ -4,6 +4,8 @@
 #include "mesh-pb-constants.h"
 #include <Arduino.h>
 
+// The firmware itself is received, written and verified by the separate OTA-WiFi app, this only hands over to it and
+// keeps the WiFi settings across the update
 namespace WiFiOTA
 {
 void initialize();
@@ -1,6 +1,8 @@
 #include "NRF52Bluetooth.h"
 #include "BLEDfuSecure.h"
 #include "BluetoothCommon.h"
+#include "BluetoothLogBatch.h"
+#include "BluetoothPhoneAPIBase.h"
 #include "PowerFSM.h"
 #include "configuration.h"
 #include "main.h"
@@ -11,8 +13,12 @@
 static BLEService meshBleService = BLEService(BLEUuid(MESH_SERVICE_UUID_16));
 static BLECharacteristic fromNum = BLECharacteristic(BLEUuid(FROMNUM_UUID_16));
 static BLECharacteristic fromRadio = BLECharacteristic(BLEUuid(FROMRADIO_UUID_16));
+static BLECharacteristic fromRadioPacked = BLECharacteristic(BLEUuid(FROMRADIOPACKED_UUID_16));
 static BLECharacteristic toRadio = BLECharacteristic(BLEUuid(TORADIO_UUID_16));
 static BLECharacteristic logRadio = BLECharacteristic(BLEUuid(LOGRADIO_UUID_16));
+#if BLE_LOG_BATCHING
+static BLECharacteristic logRadioPacked = BLECharacteristic(BLEUuid(LOGRADIOPACKED_UUID_16));
+#endif
 
 static BLEDis bledis; // DIS (Device Information Service) helper class instance
 static BLEBas blebas; // BAS (Battery Service) helper class instance
@@ -26,19 +32,16 @@ static BLEDfuSecure bledfusecure;                                             //
 // process at once
 // static uint8_t trBytes[_max(_max(_max(_max(ToRadio_size, RadioConfig_size), User_size), MyNodeInfo_size), FromRadio_size)];
 static uint8_t fromRadioBytes[meshtastic_FromRadio_size];
+static uint8_t fromRadioPackedBytes[BLE_PACKED_FROMRADIO_SIZE];
 static uint8_t toRadioBytes[meshtastic_ToRadio_size];
 
 static uint16_t connectionHandle;
 
-class BluetoothPhoneAPI : public PhoneAPI
+class BluetoothPhoneAPI : public BluetoothPhoneAPIBase
 {
-    /**
-     * Subclasses can use this as a hook to provide custom notifications for their transport (i.e. bluetooth notifies)
-     */
-    virtual void onNowHasData(uint32_t fromRadioNum) override
+    /// Called by BluetoothPhoneAPIBase, which merges notifications that come in quick succession
+    virtual void notifyFromNum(uint32_t fromRadioNum) override
     {
-        PhoneAPI::onNowHasData(fromRadioNum);
-
         LOG_INFO("BLE notify fromNum");
         fromNum.notify32(fromRadioNum);
     }
@@ -49,6 +52,21 @@ class BluetoothPhoneAPI : public PhoneAPI
 
 static BluetoothPhoneAPI *bluetoothPhoneAPI;
 
+#if BLE_LOG_BATCHING
+class NRF52LogBatch : public BluetoothLogBatch
+{
+    virtual bool notifyBatch(const uint8_t *buf, size_t len) override { return logRadioPacked.notify(buf, (uint16_t)len); }
+
+    virtual size_t maxNotifyLen() override
+    {
+        BLEConnection *connection = Bluefruit.Connection(connectionHandle);
+        return (connection ? connection->getMtu() : BLE_GATT_ATT_MTU_DEFAULT) - 3;
+    }
+};
+
+static NRF52LogBatch *logBatch;
+#endif
+
 void onConnect(uint16_t conn_handle)
 {
     // Get the reference to current connection
@@ -58,6 +76,11 @@ void onConnect(uint16_t conn_handle)
     connection->getPeerName(central_name, sizeof(central_name));
     LOG_INFO("BLE Connected to %s", central_name);
 
+    // Ask for the biggest MTU and link layer packets configPrphBandwidth(BANDWIDTH_MAX) allows, so config downloads need fewer
+    // round trips.  Phones usually start the MTU exchange themselves, but not all do
+    connection->requestMtuExchange(BLE_GATT_ATT_MTU_MAX);
+    connection->requestDataLengthUpdate();
+
     // Notify UI (or any other interested firmware components)
     bluetoothStatus->updateStatus(new meshtastic::BluetoothStatus(meshtastic::BluetoothStatus::ConnectionState::CONNECTED));
 }
@@ -72,6 +95,10 @@ void onDisconnect(uint16_t conn_handle, uint8_t reason)
     if (bluetoothPhoneAPI) {
         bluetoothPhoneAPI->close();
     }
+#if BLE_LOG_BATCHING
+    if (logBatch)
+        logBatch->clear();
+#endif
 
     // Notify UI (or any other interested firmware components)
     bluetoothStatus->updateStatus(new meshtastic::BluetoothStatus(meshtastic::BluetoothStatus::ConnectionState::DISCONNECTED));
@@ -143,6 +170,19 @@ void onFromRadioAuthorize(uint16_t conn_hdl, BLECharacteristic *chr, ble_gatts_e
     }
     authorizeRead(conn_hdl);
 }
+/**
+ * client is starting a read of the packed characteristic, fill it with as many FromRadio as fit in one read response
+ */
+void onFromRadioPackedAuthorize(uint16_t conn_hdl, BLECharacteristic *chr, ble_gatts_evt_read_t *request)
+{
+    if (request->offset == 0) {
+        BLEConnection *connection = Bluefruit.Connection(conn_hdl);
+        uint16_t mtu = connection ? connection->getMtu() : BLE_GATT_ATT_MTU_DEFAULT;
+        size_t numBytes = bluetoothPhoneAPI->getPackedFromRadio(fromRadioPackedBytes, mtu - 1);
+        fromRadioPacked.write(fromRadioPackedBytes, numBytes);
+    }
+    authorizeRead(conn_hdl);
+}
 // Last ToRadio value received from the phone
 static uint8_t lastToRadio[MAX_TO_FROM_RADIO_SIZE];
 
@@ -189,6 +229,13 @@ void setupMeshService(void)
     // for two copies
     fromRadio.begin();
 
+    fromRadioPacked.setProperties(CHR_PROPS_READ);
+    fromRadioPacked.setPermission(secMode, SECMODE_NO_ACCESS);
+    fromRadioPacked.setMaxLen(sizeof(fromRadioPackedBytes));
+    fromRadioPacked.setReadAuthorizeCallback(onFromRadioPackedAuthorize, false);
+    fromRadioPacked.setBuffer(fromRadioPackedBytes, sizeof(fromRadioPackedBytes));
+    fromRadioPacked.begin();
+
     toRadio.setProperties(CHR_PROPS_WRITE);
     toRadio.setPermission(secMode, secMode); // FIXME secure this!
     toRadio.setFixedLen(0);
@@ -204,6 +251,15 @@ void setupMeshService(void)
     logRadio.setCccdWriteCallback(onCccd);
     logRadio.write32(0);
     logRadio.begin();
+
+#if BLE_LOG_BATCHING
+    logRadioPacked.setProperties(CHR_PROPS_NOTIFY);
+    logRadioPacked.setPermission(secMode, SECMODE_NO_ACCESS);
+    logRadioPacked.setMaxLen(BLE_LOG_BATCH_SIZE);
+    logRadioPacked.begin();
+    if (!logBatch)
+        logBatch = new NRF52LogBatch();
+#endif
 }
 static uint32_t configuredPasskey;
 void NRF52Bluetooth::shutdown()
@@ -412,10 +468,16 @@ void NRF52Bluetooth::onPairingCompleted(uint16_t conn_handle, uint8_t auth_statu
     }
 }
 
-void NRF52Bluetooth::sendLog(const uint8_t *logMessage, size_t length)
+void NRF52Bluetooth::sendLog(const uint8_t *logMessage, size_t length, meshtastic_LogRecord_Level level)
 {
     if (!isConnected() || length > 512)
         return;
+#if BLE_LOG_BATCHING
+    if (logBatch && logRadioPacked.notifyEnabled()) {
+        logBatch->add(level, logMessage, length);
+        return;
+    }
+#endif
     if (logRadio.indicateEnabled())
         logRadio.indicate(logMessage, (uint16_t)length);
     else
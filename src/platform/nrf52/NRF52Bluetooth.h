@@ -1,6 +1,7 @@
 #pragma once
 
 #include "BluetoothCommon.h"
+#include "mesh/generated/meshtastic/mesh.pb.h"
 #include <Arduino.h>
 
 class NRF52Bluetooth : BluetoothApi
@@ -13,7 +14,7 @@ class NRF52Bluetooth : BluetoothApi
     void clearBonds();
     bool isConnected();
     int getRssi();
-    void sendLog(const uint8_t *logMessage, size_t length);
+    void sendLog(const uint8_t *logMessage, size_t length, meshtastic_LogRecord_Level level);
 
   private:
     static void onConnectionSecured(uint16_t conn_handle);
@@ -4,27 +4,98 @@
 #include <Adafruit_nRFCrypto.h>
 class NRF52CryptoEngine : public CryptoEngine
 {
+    /// Expanded AES256 key schedules, one per CryptoEngine key cache slot
+    AES_ctx aes256[CRYPTO_KEY_CACHE_SIZE];
+
+#if !(MESHTASTIC_EXCLUDE_PKI)
+    /// Block context for AES-CCM.  The CryptoCell only does AES128 and PKI uses AES256, so this is tiny-aes with a fully
+    /// expanded key schedule rather than the on the fly schedule of AESSmall256
+    AES_ctx blockCtx;
+    bool blockKeySet = false;
+    int8_t blockState = -1; // -1 untested, 1 passed the self test, 0 use CryptoEngine's implementation
+#endif
+
   public:
     NRF52CryptoEngine() {}
 
+#if !(MESHTASTIC_EXCLUDE_PKI)
+    virtual void aesSetKey(const uint8_t *key_bytes, size_t key_len) override
+    {
+        if (blockState < 0) {
+            blockState = 1;
+            blockState = aesSelfTest() ? 1 : 0;
+            if (!blockState)
+                LOG_WARN("nRF52 AES self test failed, use generic AES");
+        }
+        if (!blockState || (key_len != 0 && key_len != 32)) {
+            blockKeySet = false;
+            CryptoEngine::aesSetKey(key_bytes, key_len);
+            return;
+        }
+        blockKeySet = key_len != 0;
+        if (blockKeySet)
+            AES_init_ctx(&blockCtx, key_bytes);
+        else
+            memset(&blockCtx, 0, sizeof(blockCtx));
+    }
+
+    virtual void aesEncrypt(uint8_t *in, uint8_t *out) override
+    {
+        if (!blockKeySet) {
+            CryptoEngine::aesEncrypt(in, out);
+            return;
+        }
+        if (out != in)
+            memcpy(out, in, AES_BLOCKLEN);
+        AES_ECB_encrypt(&blockCtx, out);
+    }
+
+    /// The DWT cycle counter, enabled on first use
+    virtual uint32_t benchmarkTicks() override
+    {
+        if (!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+            CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+            DWT->CYCCNT = 0;
+            DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+        }
+        return DWT->CYCCNT;
+    }
+#endif
+
     ~NRF52CryptoEngine() {}
 
-    virtual void encryptAESCtr(CryptoKey _key, uint8_t *_nonce, size_t numBytes, uint8_t *bytes) override
+    virtual void invalidateKeyCache() override
+    {
+        CryptoEngine::invalidateKeyCache();
+        memset(aes256, 0, sizeof(aes256));
+    }
+
+    using CryptoEngine::encryptAESCtr;
+    virtual void encryptAESCtr(CryptoKey _key, uint8_t *_nonce, size_t numBytes, const uint8_t *in, uint8_t *out) override
     {
         if (_key.length > 16) {
-            AES_ctx ctx;
-            AES_init_ctx_iv(&ctx, _key.bytes, _nonce);
-            AES_CTR_xcrypt_buffer(&ctx, bytes, numBytes);
+            if (out != in)
+                memcpy(out, in, numBytes); // tiny-AES only works in place
+            bool isNew;
+            int slot = findKeySlot(_key, isNew);
+            if (isNew)
+                AES_init_ctx(&aes256[slot], _key.bytes);
+            // CTR mode advances the IV in place, so work on a copy and leave the cached round keys untouched
+            AES_ctx ctx = aes256[slot];
+            AES_ctx_set_iv(&ctx, _nonce);
+            AES_CTR_xcrypt_buffer(&ctx, out, numBytes);
         } else if (_key.length > 0) {
             nRFCrypto.begin();
             nRFCrypto_AES ctx;
             uint8_t myLen = ctx.blockLen(numBytes);
             char encBuf[myLen] = {0};
             ctx.begin();
-            ctx.Process((char *)bytes, numBytes, _nonce, _key.bytes, _key.length, encBuf, ctx.encryptFlag, ctx.ctrMode);
+            ctx.Process((char *)in, numBytes, _nonce, _key.bytes, _key.length, encBuf, ctx.encryptFlag, ctx.ctrMode);
             ctx.end();
             nRFCrypto.end();
-            memcpy(bytes, encBuf, numBytes);
+            memcpy(out, encBuf, numBytes);
+        } else if (out != in) {
+            memcpy(out, in, numBytes);
         }
     }
 };
@@ -188,6 +188,12 @@ static void Cipher(state_t *state, const uint8_t *RoundKey)
     AddRoundKey(Nr, state, RoundKey);
 }
 
+void AES_ECB_encrypt(const struct AES_ctx *ctx, uint8_t *buf)
+{
+    // The next function call encrypts the PlainText with the Key using AES algorithm.
+    Cipher((state_t *)buf, ctx->RoundKey);
+}
+
 void AES_CTR_xcrypt_buffer(struct AES_ctx *ctx, uint8_t *buf, size_t length)
 {
     uint8_t buffer[AES_BLOCKLEN];
@@ -17,6 +17,8 @@ void AES_init_ctx(struct AES_ctx *ctx, const uint8_t *key);
 void AES_init_ctx_iv(struct AES_ctx *ctx, const uint8_t *key, const uint8_t *iv);
 void AES_ctx_set_iv(struct AES_ctx *ctx, const uint8_t *iv);
 
+void AES_ECB_encrypt(const struct AES_ctx *ctx, uint8_t *buf);
+
 void AES_CTR_xcrypt_buffer(struct AES_ctx *ctx, uint8_t *buf, size_t length);
 
 #endif // _TINY_AES_H_
@@ -1,3 +1,4 @@
+#include "HeapTracker.h"
 #include "configuration.h"
 #include "rtos.h"
 #include <assert.h>
@@ -7,26 +8,44 @@
  * Custom new/delete to panic if out out memory
  */
 
+#if HEAP_TRACKING
+static void *trackedMalloc(size_t size)
+{
+    return rtos_malloc(size);
+}
+
+static void trackedFree(void *ptr)
+{
+    rtos_free(ptr);
+}
+
+#define ALLOC(size) HeapTracker::alloc(size, __builtin_return_address(0), trackedMalloc)
+#define FREE(ptr) HeapTracker::free(ptr, trackedFree)
+#else
+#define ALLOC(size) rtos_malloc(size)
+#define FREE(ptr) rtos_free(ptr)
+#endif
+
 void *operator new(size_t size)
 {
-    auto p = rtos_malloc(size);
+    auto p = ALLOC(size);
     assert(p);
     return p;
 }
 
 void *operator new[](size_t size)
 {
-    auto p = rtos_malloc(size);
+    auto p = ALLOC(size);
     assert(p);
     return p;
 }
 
 void operator delete(void *ptr)
 {
-    rtos_free(ptr);
+    FREE(ptr);
 }
 
 void operator delete[](void *ptr)
 {
-    rtos_free(ptr);
-}
\ No newline at end of file
+    FREE(ptr);
+}
@@ -0,0 +1,456 @@
+#include "MeshSimulator.h"
+#include "RadioInterface.h"
+#include <algorithm>
+#include <math.h>
+#include <queue>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIM_PREAMBLE_LEN 16 // RadioInterface's default preambleLength
+#define SIM_NOISE_FIGURE_DB 6
+#define SIM_CAPTURE_DB 6 // a reception survives an overlapping one this much weaker
+#define SIM_CW_MIN 3 // RadioInterface's contention window, before any ADAPTIVE_CONTENTION_WINDOW shift
+#define SIM_CW_MAX 8
+#define SIM_UTIL_PERIODS 6
+#define SIM_UTIL_PERIOD_MS 10000
+
+int MeshSimulator::indexOf(uint32_t num) const
+{
+    for (size_t i = 0; i < nodes.size(); i++)
+        if (nodes[i].num == num)
+            return i;
+    return -1;
+}
+
+bool MeshSimulator::loadTopology(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        printf("Can't open topology %s\n", path);
+        return false;
+    }
+    bool ok = loadTopology(f);
+    fclose(f);
+    return ok;
+}
+
+bool MeshSimulator::loadTopology(FILE *f)
+{
+    char line[256];
+    unsigned lineNum = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineNum++;
+        char *hash = strchr(line, '#');
+        if (hash)
+            *hash = '\0';
+
+        char what[16] = "", a[16] = "", b[16] = "";
+        if (sscanf(line, "%15s", what) < 1)
+            continue;
+
+        bool ok = true;
+        if (!strcmp(what, "modem")) {
+            unsigned s, c;
+            ok = sscanf(line, "%*s %u %f %u", &s, &bw, &c) == 3 && s >= 7 && s <= 12 && c >= 5 && c <= 8 && bw > 0;
+            sf = s;
+            cr = c;
+        } else if (!strcmp(what, "seed")) {
+            ok = sscanf(line, "%*s %u", &seed) == 1;
+        } else if (!strcmp(what, "duration")) {
+            ok = sscanf(line, "%*s %u", &durationSecs) == 1;
+        } else if (!strcmp(what, "propagation")) {
+            ok = sscanf(line, "%*s %f %f %f", &txPowerDbm, &pathLoss1mDb, &pathLossExponent) == 3;
+        } else if (!strcmp(what, "node")) {
+            Node n = {0, 0, 0, Client, 3};
+            unsigned hops = 3;
+            int got = sscanf(line, "%*s %u %f %f %15s %u", &n.num, &n.x, &n.y, a, &hops);
+            ok = got >= 3 && indexOf(n.num) < 0 && hops <= 7;
+            if (got >= 4) {
+                if (!strcmp(a, "router"))
+                    n.role = Router;
+                else if (!strcmp(a, "mute"))
+                    n.role = Mute;
+                else if (strcmp(a, "client"))
+                    ok = false;
+            }
+            n.hopLimit = hops;
+            if (ok)
+                nodes.push_back(n);
+        } else if (!strcmp(what, "link")) {
+            Link l = {0, 0, 0, 0};
+            ok = sscanf(line, "%*s %u %u %f %f", &l.a, &l.b, &l.snr, &l.loss) >= 3 && indexOf(l.a) >= 0 && indexOf(l.b) >= 0 &&
+                 l.loss >= 0 && l.loss <= 1;
+            if (ok)
+                links.push_back(l);
+        } else if (!strcmp(what, "send")) {
+            Send s;
+            unsigned from;
+            ok = sscanf(line, "%*s %u %u %15s %u", &s.atMs, &from, b, &s.payloadLen) == 4;
+            s.from = indexOf(from);
+            s.to = strcmp(b, "all") ? indexOf(strtoul(b, NULL, 10)) : -1;
+            ok = ok && s.from >= 0 && (s.to >= 0 || !strcmp(b, "all"));
+            if (ok)
+                sends.push_back(s);
+        } else if (!strcmp(what, "traffic")) {
+            ok = sscanf(line, "%*s %u %u %u", &trafficCount, &trafficIntervalMs, &trafficPayloadLen) == 3;
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            printf("Topology line %u not understood: %s\n", lineNum, line);
+            return false;
+        }
+    }
+
+    if (nodes.size() < 2) {
+        printf("Topology needs at least two nodes\n");
+        return false;
+    }
+    return true;
+}
+
+/// The state of one run, kept out of the header
+class MeshSimulation
+{
+  public:
+    explicit MeshSimulation(const MeshSimulator &sim) : sim(sim), n(sim.nodes.size()), rngState(sim.seed ? sim.seed : 1)
+    {
+        slotTimeMsec = RadioInterface::loraSlotTimeMsec(sim.sf, sim.bw, false);
+
+        float noiseDbm = -174 + 10 * log10f(sim.bw * 1000) + SIM_NOISE_FIGURE_DB;
+        snrLimit = -7.5f - 2.5f * (sim.sf - 7);
+
+        snr.assign(n * n, -1000);
+        loss.assign(n * n, 0);
+        neighbours.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++) {
+                if (i == j)
+                    continue;
+                float dx = sim.nodes[i].x - sim.nodes[j].x, dy = sim.nodes[i].y - sim.nodes[j].y;
+                float d = std::max(1.0f, sqrtf(dx * dx + dy * dy));
+                snr[i * n + j] = sim.txPowerDbm - (sim.pathLoss1mDb + 10 * sim.pathLossExponent * log10f(d)) - noiseDbm;
+            }
+        }
+        for (const MeshSimulator::Link &l : sim.links) {
+            size_t a = sim.indexOf(l.a), b = sim.indexOf(l.b);
+            snr[a * n + b] = snr[b * n + a] = l.snr;
+            loss[a * n + b] = loss[b * n + a] = l.loss;
+        }
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = 0; j < n; j++)
+                if (i != j && snr[i * n + j] >= snrLimit)
+                    neighbours[i].push_back(j);
+
+        nodes.resize(n);
+        report.nodes.resize(n);
+        for (size_t i = 0; i < n; i++)
+            report.nodes[i].num = sim.nodes[i].num;
+    }
+
+    MeshSimulator::Report run()
+    {
+        std::vector<MeshSimulator::Send> sends = sim.sends;
+        for (uint32_t i = 0; i < sim.trafficCount; i++)
+            sends.push_back({i * sim.trafficIntervalMs, (int)random(0, n), -1, sim.trafficPayloadLen});
+
+        uint32_t lastSendMs = 0;
+        for (size_t i = 0; i < sends.size(); i++) {
+            lastSendMs = std::max(lastSendMs, sends[i].atMs);
+            Packet p;
+            p.from = sends[i].from;
+            p.to = sends[i].to;
+            p.createdMs = sends[i].atMs;
+            p.len = sends[i].payloadLen + sizeof(PacketHeader);
+            p.airtimeMs = packetTime(p.len);
+            p.seen.assign(n, 0);
+            packets.push_back(p);
+            schedule(sends[i].atMs, Originate, p.from, i);
+        }
+        uint64_t stopMs = lastSendMs + (uint64_t)sim.durationSecs * 1000;
+
+        while (!events.empty() && events.top().atMs <= stopMs) {
+            Event e = events.top();
+            events.pop();
+            now = e.atMs;
+            switch (e.type) {
+            case Originate:
+                originate(e.node, e.arg);
+                break;
+            case TxDue:
+                txDue(e.node, e.arg);
+                break;
+            case TxEnd:
+                txEnd(e.arg);
+                break;
+            }
+        }
+
+        report.packets = packets.size();
+        return report;
+    }
+
+  private:
+    enum EventType { Originate, TxDue, TxEnd };
+
+    struct Event {
+        uint64_t atMs;
+        uint64_t seq; // keeps events at the same time in the order they were made, for repeatable runs
+        EventType type;
+        size_t node;
+        size_t arg;
+
+        bool operator>(const Event &o) const { return atMs != o.atMs ? atMs > o.atMs : seq > o.seq; }
+    };
+
+    struct Packet {
+        int from, to;
+        uint32_t createdMs;
+        uint32_t len;
+        uint32_t airtimeMs;
+        std::vector<uint8_t> seen; // by node
+    };
+
+    struct Pending { // a transmission waiting in a node's queue
+        size_t packet;
+        uint8_t hopLimit;
+        bool isRelay;
+        bool canceled;
+    };
+
+    struct Transmission {
+        size_t node;
+        size_t packet;
+        uint8_t hopLimit;
+        uint64_t endMs;
+    };
+
+    struct Reception {
+        size_t tx;
+        float snr;
+        bool corrupted;
+    };
+
+    struct NodeState {
+        std::vector<Pending> pending;
+        std::vector<Reception> receiving;
+        bool transmitting = false;
+        uint64_t busyUntilMs = 0; // end of the last transmission heard or sent
+        uint32_t utilMs[SIM_UTIL_PERIODS] = {};
+        uint64_t utilPeriod[SIM_UTIL_PERIODS] = {};
+    };
+
+    const MeshSimulator &sim;
+    size_t n;
+    uint32_t rngState;
+    uint32_t slotTimeMsec;
+    float snrLimit;
+    std::vector<float> snr, loss; // n x n, from * n + to
+    std::vector<std::vector<size_t>> neighbours;
+    std::vector<NodeState> nodes;
+    std::vector<Packet> packets;
+    std::vector<Transmission> transmissions;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+    uint64_t now = 0, seq = 0;
+    MeshSimulator::Report report;
+
+    uint32_t random(uint32_t lo, uint32_t hi) // xorshift32, the same sequence on every platform
+    {
+        rngState ^= rngState << 13;
+        rngState ^= rngState >> 17;
+        rngState ^= rngState << 5;
+        return hi > lo ? lo + rngState % (hi - lo) : lo;
+    }
+
+    float random01() { return random(0, 1000000) / 1000000.0f; }
+
+    void schedule(uint64_t atMs, EventType type, size_t node, size_t arg) { events.push({atMs, seq++, type, node, arg}); }
+
+    uint32_t packetTime(uint32_t pl) const
+    {
+        return RadioInterface::loraPacketTime(sim.sf, sim.bw, sim.cr, SIM_PREAMBLE_LEN, pl);
+    }
+
+    void addUtil(size_t node, uint64_t startMs, uint32_t ms)
+    {
+        uint64_t period = startMs / SIM_UTIL_PERIOD_MS;
+        NodeState &s = nodes[node];
+        int i = period % SIM_UTIL_PERIODS;
+        if (s.utilPeriod[i] != period) {
+            s.utilPeriod[i] = period;
+            s.utilMs[i] = 0;
+        }
+        s.utilMs[i] += ms;
+    }
+
+    float channelUtilPercent(size_t node) const
+    {
+        uint64_t period = now / SIM_UTIL_PERIOD_MS;
+        uint32_t busy = 0;
+        for (int i = 0; i < SIM_UTIL_PERIODS; i++)
+            if (nodes[node].utilPeriod[i] + SIM_UTIL_PERIODS > period)
+                busy += nodes[node].utilMs[i];
+        return std::min(100.0f, 100.0f * busy / (SIM_UTIL_PERIODS * SIM_UTIL_PERIOD_MS));
+    }
+
+    // Like RadioInterface::getTxDelayMsec(), with our own random numbers
+    uint32_t txDelayMsec(size_t node)
+    {
+        uint8_t cw = SIM_CW_MIN + (long)channelUtilPercent(node) * (SIM_CW_MAX - SIM_CW_MIN) / 100;
+        return random(0, 1 << cw) * slotTimeMsec;
+    }
+
+    // Like RadioInterface::getTxDelayMsecWeighted(), radios don't report SNR beyond -20..10
+    uint32_t txDelayMsecWeighted(size_t node, float rxSnr)
+    {
+        uint8_t cw = RadioInterface::cwSizeForSnr(std::min(10.0f, std::max(-20.0f, rxSnr)), SIM_CW_MIN, SIM_CW_MAX);
+        if (sim.nodes[node].role == MeshSimulator::Router)
+            return random(0, 2 * cw) * slotTimeMsec;
+        return 2 * SIM_CW_MAX * slotTimeMsec + random(0, 1 << cw) * slotTimeMsec;
+    }
+
+    void originate(size_t node, size_t packet)
+    {
+        Packet &p = packets[packet];
+        p.seen[node] = 1;
+        report.nodes[node].sent++;
+        report.wanted += p.to < 0 ? n - 1 : 1;
+        enqueue(node, packet, sim.nodes[node].hopLimit, false, txDelayMsec(node));
+    }
+
+    void enqueue(size_t node, size_t packet, uint8_t hopLimit, bool isRelay, uint32_t delayMs)
+    {
+        nodes[node].pending.push_back({packet, hopLimit, isRelay, false});
+        schedule(now + delayMs, TxDue, node, nodes[node].pending.size() - 1);
+    }
+
+    void txDue(size_t node, size_t pendingIndex)
+    {
+        NodeState &s = nodes[node];
+        Pending &q = s.pending[pendingIndex];
+        if (q.canceled)
+            return;
+
+        // Like RadioLibInterface, wait a while longer if we're sending, receiving or the channel is busy
+        if (s.transmitting || !s.receiving.empty() || s.busyUntilMs > now) {
+            uint64_t after = std::max(now, s.busyUntilMs);
+            schedule(after + txDelayMsec(node), TxDue, node, pendingIndex);
+            return;
+        }
+
+        q.canceled = true; // taken out of the queue
+        if (q.isRelay)
+            report.nodes[node].relayed++;
+
+        const Packet &p = packets[q.packet];
+        size_t tx = transmissions.size();
+        transmissions.push_back({node, q.packet, q.hopLimit, now + p.airtimeMs});
+        s.transmitting = true;
+        s.busyUntilMs = now + p.airtimeMs;
+        report.nodes[node].airtimeMs += p.airtimeMs;
+        addUtil(node, now, p.airtimeMs);
+
+        for (size_t r : neighbours[node]) {
+            NodeState &rs = nodes[r];
+            float rxSnr = snr[node * n + r];
+            addUtil(r, now, p.airtimeMs);
+            rs.busyUntilMs = std::max(rs.busyUntilMs, now + p.airtimeMs);
+            if (rs.transmitting) {
+                report.nodes[r].rxCollided++;
+                continue;
+            }
+
+            Reception rx = {tx, rxSnr, false};
+            for (Reception &other : rs.receiving) {
+                if (other.snr < rxSnr + SIM_CAPTURE_DB)
+                    other.corrupted = true;
+                if (rxSnr < other.snr + SIM_CAPTURE_DB)
+                    rx.corrupted = true;
+            }
+            rs.receiving.push_back(rx);
+        }
+        schedule(now + p.airtimeMs, TxEnd, node, tx);
+    }
+
+    void txEnd(size_t tx)
+    {
+        const Transmission &t = transmissions[tx];
+        nodes[t.node].transmitting = false;
+
+        for (size_t r : neighbours[t.node]) {
+            std::vector<Reception> &receiving = nodes[r].receiving;
+            for (size_t i = 0; i < receiving.size(); i++) {
+                if (receiving[i].tx != tx)
+                    continue;
+                Reception rx = receiving[i];
+                receiving.erase(receiving.begin() + i);
+                if (rx.corrupted)
+                    report.nodes[r].rxCollided++;
+                else if (random01() >= loss[t.node * n + r])
+                    receive(r, t, rx.snr);
+                break;
+            }
+        }
+    }
+
+    // The simplified flood: relay once, non-routers give up their relay on hearing someone else's, no next hops or acks
+    void receive(size_t node, const Transmission &t, float rxSnr)
+    {
+        Packet &p = packets[t.packet];
+        MeshSimulator::NodeStats &stats = report.nodes[node];
+
+        if (p.seen[node]) {
+            stats.rxDupe++;
+            if (sim.nodes[node].role != MeshSimulator::Router) {
+                for (Pending &q : nodes[node].pending) {
+                    if (q.packet == t.packet && q.isRelay && !q.canceled) {
+                        q.canceled = true;
+                        stats.canceled++;
+                    }
+                }
+            }
+            return;
+        }
+
+        p.seen[node] = 1;
+        stats.rxOk++;
+        if (p.to < 0 || p.to == (int)node) {
+            uint32_t latency = now - p.createdMs;
+            report.delivered++;
+            report.latencySumMs += latency;
+            report.latencyMaxMs = std::max(report.latencyMaxMs, latency);
+        }
+
+        if (p.to != (int)node && t.hopLimit > 0 && p.from != (int)node && sim.nodes[node].role != MeshSimulator::Mute)
+            enqueue(node, t.packet, t.hopLimit - 1, true, txDelayMsecWeighted(node, rxSnr));
+    }
+};
+
+MeshSimulator::Report MeshSimulator::run()
+{
+    MeshSimulation s(*this);
+    return s.run();
+}
+
+void MeshSimulator::printReport(const Report &r, FILE *out)
+{
+    fprintf(out, "packets %u delivered %u/%u (%.1f%%) latency mean %ums max %ums\n", r.packets, r.delivered, r.wanted,
+            100.0f * r.deliveryRatio(), r.latencyMeanMs(), r.latencyMaxMs);
+    fprintf(out, "%8s %6s %7s %8s %6s %6s %8s %10s\n", "node", "sent", "relayed", "canceled", "rx", "dupe", "collided",
+            "airtime_ms");
+    for (size_t i = 0; i < r.nodes.size(); i++) {
+        const NodeStats &s = r.nodes[i];
+        fprintf(out, "%8u %6u %7u %8u %6u %6u %8u %10llu\n", s.num, s.sent, s.relayed, s.canceled, s.rxOk, s.rxDupe, s.rxCollided,
+                (unsigned long long)s.airtimeMs);
+    }
+}
+
+int MeshSimulator::runFile(const char *path)
+{
+    MeshSimulator sim;
+    if (!sim.loadTopology(path))
+        return EXIT_FAILURE;
+    printReport(sim.run(), stdout);
+    return EXIT_SUCCESS;
+}
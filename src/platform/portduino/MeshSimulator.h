@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/**
+ * An in-process discrete-event model of channel load on a LoRa mesh of 50-500 nodes: how much airtime a density of nodes and
+ * traffic takes, how much of it collides and how far a plain flood gets, without running that many meshtasticd instances.
+ *
+ * It is NOT a routing evaluator.  Router, NodeDB and the radio are process wide singletons and none of them run here, each node
+ * follows a simplified flood instead (drop dupes, non-routers give up their pending relay on hearing someone else's, hop limit),
+ * so changes to the routing code don't show in its results; test those with meshtasticd --sim instances.  Airtime, slot time
+ * and the SNR weighted contention window come from RadioInterface.  Time is virtual and the random numbers come from a seeded
+ * generator, so a run is repeatable.
+ *
+ * The topology file is line based, '#' starts a comment:
+ *
+ *   modem <sf> <bw_khz> <cr>                   LongFast (11 250 5) if not given
+ *   seed <n>
+ *   duration <secs>                            stop this long after the last send, default 60
+ *   propagation <tx_dbm> <pl_1m_db> <exponent> log distance path loss, default 22 40 2.7
+ *   node <num> <x_m> <y_m> [client|router|mute] [hops]
+ *   link <a> <b> <snr_db> [loss]               fixed SNR and random drop probability for one pair, both directions
+ *   send <time_ms> <from> <to|all> <payload_bytes>
+ *   traffic <count> <interval_ms> <payload_bytes>  count broadcasts from random nodes
+ */
+class MeshSimulator
+{
+  public:
+    enum Role { Client, Router, Mute };
+
+    struct NodeStats {
+        uint32_t num = 0;
+        uint32_t sent = 0;     // packets we originated
+        uint32_t relayed = 0;  // rebroadcasts that made it on air
+        uint32_t canceled = 0; // rebroadcasts canceled because someone else went first
+        uint32_t rxOk = 0;
+        uint32_t rxDupe = 0;
+        uint32_t rxCollided = 0; // lost to an overlapping transmission or to us transmitting
+        uint64_t airtimeMs = 0;
+    };
+
+    struct Report {
+        uint32_t packets = 0;
+        uint32_t wanted = 0;    // (packet, destination) pairs that should have been delivered
+        uint32_t delivered = 0; // of which arrived
+        uint64_t latencySumMs = 0;
+        uint32_t latencyMaxMs = 0;
+        std::vector<NodeStats> nodes;
+
+        float deliveryRatio() const { return wanted ? (float)delivered / wanted : 1.0f; }
+        uint32_t latencyMeanMs() const { return delivered ? latencySumMs / delivered : 0; }
+    };
+
+    /// @return false and print why if the topology can't be read
+    bool loadTopology(const char *path);
+    bool loadTopology(FILE *f);
+
+    Report run();
+
+    static void printReport(const Report &r, FILE *out);
+
+    /// Load, run and print, what meshtasticd --simulate does
+    static int runFile(const char *path);
+
+  private:
+    struct Node {
+        uint32_t num;
+        float x, y;
+        Role role;
+        uint8_t hopLimit;
+    };
+
+    struct Link {
+        uint32_t a, b;
+        float snr, loss;
+    };
+
+    struct Send {
+        uint32_t atMs;
+        int from; // node index
+        int to;   // node index, -1 for broadcast
+        uint32_t payloadLen;
+    };
+
+    uint8_t sf = 11, cr = 5;
+    float bw = 250;
+    uint32_t seed = 1;
+    uint32_t durationSecs = 60;
+    float txPowerDbm = 22, pathLoss1mDb = 40, pathLossExponent = 2.7f;
+    std::vector<Node> nodes;
+    std::vector<Link> links;
+    std::vector<Send> sends;
+    uint32_t trafficCount = 0, trafficIntervalMs = 0, trafficPayloadLen = 0;
+
+    friend class MeshSimulation;
+    int indexOf(uint32_t num) const;
+};
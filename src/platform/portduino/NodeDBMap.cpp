@@ -0,0 +1,155 @@
+#include "NodeDBMap.h"
+#include "configuration.h"
+#include <ErriezCRC32.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+uint32_t NodeDBMap::recordCRC(const meshtastic_NodeInfoLite &node)
+{
+    return crc32Buffer(&node, sizeof(node));
+}
+
+bool NodeDBMap::open(const char *path, uint32_t capacity)
+{
+    close();
+    fd = ::open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Can't open node map %s", path);
+        return false;
+    }
+
+    // A file from another layout is started over, nodes.proto still has the nodes
+    Header existing = {};
+    bool fresh = pread(fd, &existing, sizeof(existing), 0) != sizeof(existing) || existing.magic != MAGIC ||
+                 existing.version != VERSION || existing.recordSize != sizeof(Record);
+    if (fresh)
+        LOG_INFO("Create node map %s for %u nodes", path, capacity);
+    else if (existing.capacity != capacity)
+        LOG_INFO("Resize node map %s from %u to %u nodes", path, existing.capacity, capacity);
+
+    size_t size = sizeof(Header) + (size_t)capacity * sizeof(Record);
+    if ((fresh && ftruncate(fd, 0) != 0) || ftruncate(fd, size) != 0) {
+        LOG_ERROR("Can't size node map %s", path);
+        close();
+        return false;
+    }
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        LOG_ERROR("Can't map node map %s", path);
+        close();
+        return false;
+    }
+
+    mapSize = size;
+    header = (Header *)map;
+    records = (Record *)((uint8_t *)map + sizeof(Header));
+    // Growing the file zero fills, so new records are free
+    header->magic = MAGIC;
+    header->version = VERSION;
+    header->recordSize = sizeof(Record);
+    header->capacity = capacity;
+    return true;
+}
+
+void NodeDBMap::close()
+{
+    if (header)
+        munmap(header, mapSize);
+    if (fd >= 0)
+        ::close(fd);
+    header = NULL;
+    records = NULL;
+    mapSize = 0;
+    fd = -1;
+}
+
+uint32_t NodeDBMap::load(std::vector<meshtastic_NodeInfoLite> &nodes) const
+{
+    if (!header)
+        return 0;
+    uint32_t loaded = 0, damaged = 0;
+    for (uint32_t i = 0; i < header->capacity; i++) {
+        const Record &r = records[i];
+        if (r.node.num == 0)
+            continue;
+        if (r.crc != recordCRC(r.node)) {
+            damaged++;
+            continue;
+        }
+        nodes.push_back(r.node);
+        loaded++;
+    }
+    if (damaged)
+        LOG_WARN("Node map had %u damaged records, ignoring them", damaged);
+    return loaded;
+}
+
+bool NodeDBMap::save(const meshtastic_NodeInfoLite *nodes, uint32_t count, uint32_t *bytesWritten)
+{
+    *bytesWritten = 0;
+    if (!header)
+        return false;
+
+    std::unordered_map<uint32_t, uint32_t> slotOf; // num -> record
+    slotOf.reserve(count);
+    for (uint32_t i = 0; i < header->capacity; i++)
+        if (records[i].node.num != 0)
+            slotOf[records[i].node.num] = i;
+
+    std::vector<bool> keep(header->capacity, false);
+    std::vector<const meshtastic_NodeInfoLite *> added;
+    for (uint32_t i = 0; i < count; i++) {
+        const meshtastic_NodeInfoLite &node = nodes[i];
+        if (node.num == 0)
+            continue;
+        auto it = slotOf.find(node.num);
+        if (it == slotOf.end()) {
+            added.push_back(&node);
+            continue;
+        }
+        keep[it->second] = true;
+        Record &r = records[it->second];
+        uint32_t crc = recordCRC(node);
+        if (r.crc != crc || memcmp(&r.node, &node, sizeof(node)) != 0) {
+            r.node = node;
+            r.crc = crc;
+            *bytesWritten += sizeof(Record);
+        }
+    }
+
+    // Free the records of nodes no longer in the database, then the added ones go into free records
+    for (const auto &entry : slotOf) {
+        if (!keep[entry.second]) {
+            memset(&records[entry.second], 0, sizeof(Record));
+            *bytesWritten += sizeof(Record);
+        }
+    }
+    bool okay = true;
+    uint32_t next = 0, stored = 0;
+    for (const meshtastic_NodeInfoLite *node : added) {
+        while (next < header->capacity && records[next].node.num != 0)
+            next++;
+        if (next == header->capacity)
+            break;
+        Record &r = records[next];
+        r.crc = recordCRC(*node);
+        r.node = *node;
+        *bytesWritten += sizeof(Record);
+        stored++;
+    }
+    if (stored < added.size()) {
+        LOG_ERROR("Node map is full, %u nodes not saved", (unsigned)(added.size() - stored));
+        okay = false;
+    }
+
+    // Only the pages written above are dirty, msync leaves the rest alone
+    if (*bytesWritten && msync(header, mapSize, MS_SYNC) != 0) {
+        LOG_ERROR("Can't sync node map");
+        okay = false;
+    }
+    return okay;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "mesh/generated/meshtastic/deviceonly.pb.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * meshtasticd's node database as a memory-mapped file of fixed size records, instead of nodes.proto.  Loading is a copy out of
+ * the map rather than a protobuf decode of the whole database, and saving writes only the records of nodes that changed, then
+ * msyncs, so only those pages go to disk.
+ *
+ * The file is a Header followed by capacity Records, native byte order.  A record holds a node's NodeInfoLite exactly as the
+ * firmware keeps it in RAM, after a CRC32 of it.  num 0 marks a free record, and one whose CRC doesn't match (torn by a crash
+ * while it was written) is ignored.  Records are not in any particular order, a node keeps the record it was first stored in.
+ * Other programs on the same machine can read the file while meshtasticd runs, given the same struct layout.
+ */
+class NodeDBMap
+{
+  public:
+    static constexpr uint32_t MAGIC = 0x4244444e; // "NDDB"
+    static constexpr uint32_t VERSION = 1;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;    // of this layout, the protobufs have their own
+        uint32_t recordSize; // sizeof(Record), changes whenever NodeInfoLite does
+        uint32_t capacity;   // records in the file
+    };
+
+    struct Record {
+        uint32_t crc; // of node
+        meshtastic_NodeInfoLite node;
+    };
+
+    ~NodeDBMap() { close(); }
+
+    /// Map the file at path, creating it or resizing it to hold capacity records
+    /// @return false if it can't be mapped, the caller falls back to nodes.proto
+    bool open(const char *path, uint32_t capacity);
+
+    void close();
+
+    bool isOpen() const { return header != NULL; }
+
+    /// Append every valid record to nodes
+    /// @return how many were
+    uint32_t load(std::vector<meshtastic_NodeInfoLite> &nodes) const;
+
+    /**
+     * Bring the file up to date with nodes[0..count): write the records of added and changed nodes, free those of removed
+     * ones, then msync.
+     * @param bytesWritten set to the bytes of records written
+     * @return false if a node didn't fit or msync failed
+     */
+    bool save(const meshtastic_NodeInfoLite *nodes, uint32_t count, uint32_t *bytesWritten);
+
+  private:
+    int fd = -1;
+    Header *header = NULL;
+    Record *records = NULL;
+    size_t mapSize = 0;
+
+    static uint32_t recordCRC(const meshtastic_NodeInfoLite &node);
+};
@@ -0,0 +1,195 @@
+#include "PacketCapture.h"
+#include "concurrency/LockGuard.h"
+#include "configuration.h"
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+
+PacketCapture *packetCapture;
+
+static constexpr uint32_t LINKTYPE_USER0 = 147;
+
+// What the classic pcap format has before and between packets, host byte order with the magic saying which
+struct PcapFileHeader {
+    uint32_t magic;
+    uint16_t versionMajor, versionMinor;
+    int32_t thisZone;
+    uint32_t sigFigs;
+    uint32_t snapLen;
+    uint32_t linkType;
+};
+
+struct PcapRecordHeader {
+    uint32_t tsSec, tsUsec;
+    uint32_t inclLen, origLen;
+};
+
+PacketCapture::PacketCapture(const std::string &path, uint32_t maxBytes)
+    : concurrency::OSThread("PacketCapture"), path(path), maxBytes(maxBytes)
+{
+    if (!open())
+        disable();
+}
+
+PacketCapture::~PacketCapture()
+{
+    write();
+    if (file)
+        fclose(file);
+}
+
+bool PacketCapture::open()
+{
+    file = fopen(path.c_str(), "wb");
+    if (!file) {
+        LOG_ERROR("Can't open packet capture %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+    PcapFileHeader h = {0xa1b2c3d4, 2, 4, 0, 0, 65535, LINKTYPE_USER0};
+    fwrite(&h, sizeof(h), 1, file);
+    fileBytes = sizeof(h);
+    LOG_INFO("Capture packets to %s", path.c_str());
+    return true;
+}
+
+void PacketCapture::capture(const meshtastic_MeshPacket *p, Direction dir, uint16_t portnum, float freqMhz)
+{
+    if (!file || p->which_payload_variant != meshtastic_MeshPacket_encrypted_tag)
+        return;
+
+    concurrency::LockGuard guard(&lock);
+    if (head - tail == PCAP_RING_FRAMES) {
+        dropped++;
+        return;
+    }
+    Record &r = ring[head % PCAP_RING_FRAMES];
+    gettimeofday(&r.ts, NULL);
+
+    r.meta = {};
+    r.meta.version = 1;
+    r.meta.direction = dir;
+    r.meta.metaLen = sizeof(Meta);
+    r.meta.flags = portnum ? PORTNUM_KNOWN : 0;
+    r.meta.portnum = portnum;
+    r.meta.freqKhz = freqMhz * 1000 + 0.5f;
+    if (dir == RX) {
+        r.meta.rssi = p->rx_rssi;
+        r.meta.snrX4 = p->rx_snr * 4;
+        r.meta.rxTime = p->rx_time;
+    }
+
+    PacketHeader h;
+    RadioInterface::packHeader(p, h);
+    size_t payloadLen = std::min<size_t>(p->encrypted.size, sizeof(r.frame) - sizeof(h));
+    memcpy(r.frame, &h, sizeof(h));
+    memcpy(r.frame + sizeof(h), p->encrypted.bytes, payloadLen);
+    r.frameLen = sizeof(h) + payloadLen;
+
+    if (++head - tail == PCAP_RING_FRAMES / 2)
+        setIntervalFromNow(0); // don't wait for the timer to come round
+}
+
+int32_t PacketCapture::runOnce()
+{
+    write();
+    return PCAP_FLUSH_MSEC;
+}
+
+void PacketCapture::write()
+{
+    if (!file)
+        return;
+
+    uint32_t from, to, lost;
+    {
+        concurrency::LockGuard guard(&lock);
+        from = tail;
+        to = head;
+        lost = dropped - reportedDropped;
+        reportedDropped = dropped;
+    }
+    if (lost)
+        LOG_WARN("Packet capture dropped %u frames, the ring was full", lost);
+    if (from == to)
+        return;
+
+    // The slots between from and to are ours until tail moves past them, capture() only writes beyond head
+    for (uint32_t i = from; i != to; i++) {
+        const Record &r = ring[i % PCAP_RING_FRAMES];
+        PcapRecordHeader rh = {(uint32_t)r.ts.tv_sec, (uint32_t)r.ts.tv_usec, 0, 0};
+        rh.inclLen = rh.origLen = sizeof(Meta) + r.frameLen;
+        fwrite(&rh, sizeof(rh), 1, file);
+        fwrite(&r.meta, sizeof(Meta), 1, file);
+        fwrite(r.frame, r.frameLen, 1, file);
+        fileBytes += sizeof(rh) + rh.inclLen;
+    }
+    fflush(file);
+    {
+        concurrency::LockGuard guard(&lock);
+        tail = to;
+    }
+
+    if (maxBytes && fileBytes >= maxBytes) {
+        fclose(file);
+        file = NULL;
+        std::string older = path + ".1";
+        if (rename(path.c_str(), older.c_str()) != 0)
+            LOG_WARN("Can't rename packet capture to %s: %s", older.c_str(), strerror(errno));
+        if (!open())
+            disable();
+    }
+}
+
+bool PacketCapture::read(const char *path, std::vector<Frame> &frames)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        LOG_ERROR("Can't open packet capture %s: %s", path, strerror(errno));
+        return false;
+    }
+    PcapFileHeader h;
+    if (fread(&h, sizeof(h), 1, f) != 1 || h.magic != 0xa1b2c3d4 || h.linkType != LINKTYPE_USER0) {
+        LOG_ERROR("%s is not a packet capture of ours", path);
+        fclose(f);
+        return false;
+    }
+
+    PcapRecordHeader rh;
+    uint8_t buf[sizeof(Meta) + sizeof(Frame::frame)];
+    while (fread(&rh, sizeof(rh), 1, f) == 1) {
+        if (rh.inclLen > sizeof(buf)) {
+            fseek(f, rh.inclLen, SEEK_CUR);
+            continue;
+        }
+        if (fread(buf, rh.inclLen, 1, f) != 1)
+            break; // cut short, the capture was still being written
+        Frame fr;
+        memcpy(&fr.meta, buf, std::min<size_t>(rh.inclLen, sizeof(Meta)));
+        if (rh.inclLen < sizeof(Meta) || fr.meta.version != 1 || fr.meta.metaLen > rh.inclLen ||
+            rh.inclLen - fr.meta.metaLen < sizeof(PacketHeader))
+            continue;
+        fr.timeUs = (uint64_t)rh.tsSec * 1000000 + rh.tsUsec;
+        fr.frameLen = rh.inclLen - fr.meta.metaLen;
+        memcpy(fr.frame, buf + fr.meta.metaLen, fr.frameLen);
+        frames.push_back(fr);
+    }
+    fclose(f);
+    return true;
+}
+
+meshtastic_MeshPacket *PacketCapture::toPacket(const Frame &f)
+{
+    meshtastic_MeshPacket *p = packetPool.allocZeroed();
+    if (!p)
+        return NULL;
+    PacketHeader h;
+    memcpy(&h, f.frame, sizeof(h));
+    RadioInterface::unpackHeader(h, p);
+    p->which_payload_variant = meshtastic_MeshPacket_encrypted_tag;
+    p->encrypted.size = f.frameLen - sizeof(h);
+    memcpy(p->encrypted.bytes, f.frame + sizeof(h), p->encrypted.size);
+    p->rx_rssi = f.meta.rssi;
+    p->rx_snr = f.meta.snrX4 / 4.0f;
+    p->rx_time = f.meta.rxTime;
+    return p;
+}
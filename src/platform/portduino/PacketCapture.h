@@ -0,0 +1,102 @@
+#pragma once
+
+#include "RadioInterface.h"
+#include "concurrency/Lock.h"
+#include "concurrency/OSThread.h"
+#include <stdio.h>
+#include <string>
+#include <sys/time.h>
+#include <vector>
+
+/// Frames the capture holds between writes, more arriving before the next write are dropped (and counted)
+#ifndef PCAP_RING_FRAMES
+#define PCAP_RING_FRAMES 256
+#endif
+
+/// How often the captured frames are written out, sooner if the ring is half full
+#ifndef PCAP_FLUSH_MSEC
+#define PCAP_FLUSH_MSEC 2000
+#endif
+
+/**
+ * Writes every LoRa frame the router hears or sends to a pcap file, for Wireshark or scripts to pick apart later.
+ *
+ * Set with Logging: PcapFile in config.yaml, and optionally PcapMaxMB to keep the capture to a ring of two files: once the
+ * file reaches that size it is renamed to <PcapFile>.1 (replacing the older one) and a new file is started.
+ *
+ * The radio path only copies the frame into an in-memory ring; a thread of its own writes the ring out in one go every
+ * PCAP_FLUSH_MSEC, so a slow disk never holds up the router.
+ *
+ * The link type is LINKTYPE_USER0 (147).  Each packet is a Meta, little endian, then the frame as it went over the air: the
+ * 16 byte PacketHeader and the encrypted payload.  Frames heard again (duplicates, rebroadcasts by others) are captured
+ * too, as are those from nodes we ignore.
+ */
+class PacketCapture : private concurrency::OSThread
+{
+  public:
+    enum Direction : uint8_t { RX = 0, TX = 1 };
+
+    enum Flags : uint8_t { PORTNUM_KNOWN = 1 };
+
+    struct __attribute__((packed)) Meta {
+        uint8_t version;   // of this struct, 1
+        uint8_t direction; // Direction
+        uint8_t metaLen;   // sizeof(Meta), the frame starts after it
+        uint8_t flags;     // Flags
+        int16_t rssi;      // dBm, RX only
+        int16_t snrX4;     // dB * 4, RX only
+        uint32_t freqKhz;  // the radio was on, 0 if not known
+        uint16_t portnum;  // what the payload decrypts to, with PORTNUM_KNOWN (our own sends)
+        uint16_t reserved;
+        uint32_t rxTime; // mesh time (seconds since 1970) the packet came in, RX only
+    };
+
+    PacketCapture(const std::string &path, uint32_t maxBytes);
+    ~PacketCapture();
+
+    /// Copy an encrypted packet into the ring, anything else is ignored
+    void capture(const meshtastic_MeshPacket *p, Direction dir, uint16_t portnum = 0, float freqMhz = 0);
+
+    /// A packet of a capture file, for replaying it
+    struct Frame {
+        uint64_t timeUs; // since 1970
+        Meta meta;
+        uint16_t frameLen;
+        uint8_t frame[MAX_LORA_PAYLOAD_LEN + 1];
+    };
+
+    /**
+     * Read a capture this class wrote, skipping packets that aren't whole frames
+     * @return false and log why if it isn't one
+     */
+    static bool read(const char *path, std::vector<Frame> &frames);
+
+    /// A packet from the pool as the radio would have handed frame f to the router, NULL if the pool is empty
+    static meshtastic_MeshPacket *toPacket(const Frame &f);
+
+  protected:
+    virtual int32_t runOnce() override;
+
+  private:
+    struct Record {
+        struct timeval ts;
+        Meta meta;
+        uint16_t frameLen;
+        uint8_t frame[MAX_LORA_PAYLOAD_LEN + 1];
+    };
+
+    std::string path;
+    uint32_t maxBytes;
+    FILE *file = NULL;
+    uint32_t fileBytes = 0;
+
+    concurrency::Lock lock; // guards head, tail and dropped; the records between tail and head belong to the writer
+    Record ring[PCAP_RING_FRAMES];
+    uint32_t head = 0, tail = 0; // free running, slot is % PCAP_RING_FRAMES
+    uint32_t dropped = 0, reportedDropped = 0;
+
+    bool open();
+    void write();
+};
+
+extern PacketCapture *packetCapture;
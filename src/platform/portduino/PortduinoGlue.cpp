@@ -1,4 +1,5 @@
 #include "CryptoEngine.h"
+#include "MeshSimulator.h"
 #include "PortduinoGPIO.h"
 #include "SPIChip.h"
 #include "mesh/RF95Interface.h"
@@ -27,13 +28,15 @@
 
 #include "platform/portduino/USBHal.h"
 
-std::map<configNames, int> settingsMap;
-std::map<configNames, std::string> settingsStrings;
+PortduinoSettings<int> settingsMap;
+PortduinoSettings<std::string> settingsStrings;
 std::ofstream traceFile;
 Ch341Hal *ch341Hal = nullptr;
+volatile sig_atomic_t termRequested = 0;
 char *configPath = nullptr;
 char *optionMac = nullptr;
 bool forceSimulated = false;
+char *simulateTopology = nullptr;
 
 // FIXME - move setBluetoothEnable into a HALPlatform class
 void setBluetoothEnable(bool enable)
@@ -68,6 +71,9 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state)
     case 'h':
         optionMac = arg;
         break;
+    case 'S':
+        simulateTopology = arg;
+        break;
 
     case ARGP_KEY_ARG:
         return 0;
@@ -83,6 +89,8 @@ void portduinoCustomInit()
                                            {"config", 'c', "CONFIG_PATH", 0, "Full path of the .yaml config file to use."},
                                            {"hwid", 'h', "HWID", 0, "The mac address to assign to this virtual machine"},
                                            {"sim", 's', 0, 0, "Run in Simulated radio mode"},
+                                           {"simulate", 'S', "TOPOLOGY", 0,
+                                            "Model channel load on the mesh in the TOPOLOGY file, print the results and exit."},
                                            {0}};
     static void *childArguments;
     static char doc[] = "Meshtastic native build.";
@@ -141,6 +149,12 @@ void getMacAddr(uint8_t *dmac)
  */
 void portduinoSetup()
 {
+    if (simulateTopology != nullptr)
+        exit(MeshSimulator::runFile(simulateTopology));
+
+    // Exit from the main loop rather than at once, so changes still waiting in SaveScheduler are written
+    signal(SIGTERM, [](int) { termRequested = 1; });
+
     printf("Set up Meshtastic on Portduino...\n");
     int max_GPIO = 0;
     const configNames GPIO_lines[] = {cs_pin,
@@ -393,11 +407,14 @@ void portduinoSetup()
                            {reset_pin, reset_gpiochip, reset_line},
                            {rxen_pin, rxen_gpiochip, rxen_line},
                            {txen_pin, txen_gpiochip, txen_line},
-                           {sx126x_ant_sw_pin, sx126x_ant_sw_gpiochip, sx126x_ant_sw_line}};
+                           {sx126x_ant_sw_pin, sx126x_ant_sw_gpiochip, sx126x_ant_sw_line},
+                           {lora2_cs_pin, lora2_cs_gpiochip, lora2_cs_line},
+                           {lora2_irq_pin, lora2_irq_gpiochip, lora2_irq_line},
+                           {lora2_busy_pin, lora2_busy_gpiochip, lora2_busy_line},
+                           {lora2_reset_pin, lora2_reset_gpiochip, lora2_reset_line}};
         for (auto &pinMap : pinMappings) {
-            auto setMapIter = settingsMap.find(pinMap.pin);
-            if (setMapIter != settingsMap.end() && setMapIter->second != RADIOLIB_NC) {
-                if (initGPIOPin(setMapIter->second, gpioChipName + std::to_string(settingsMap[pinMap.gpiochip]),
+            if (settingsMap.count(pinMap.pin) && settingsMap[pinMap.pin] != RADIOLIB_NC) {
+                if (initGPIOPin(settingsMap[pinMap.pin], gpioChipName + std::to_string(settingsMap[pinMap.gpiochip]),
                                 settingsMap[pinMap.line]) != ERRNO_OK) {
                     printf("Error setting pin number %d. It may not exist, or may already be in use.\n",
                            settingsMap[pinMap.line]);
@@ -459,6 +476,9 @@ bool loadConfig(const char *configPath)
                 settingsMap[logoutputlevel] = level_error;
             }
             settingsStrings[traceFilename] = yamlConfig["Logging"]["TraceFile"].as<std::string>("");
+            settingsStrings[pcapFilename] = yamlConfig["Logging"]["PcapFile"].as<std::string>("");
+            settingsMap[pcapMaxMB] = yamlConfig["Logging"]["PcapMaxMB"].as<int>(0);
+            settingsStrings[eventTraceFilename] = yamlConfig["Logging"]["EventTraceFile"].as<std::string>("");
             if (yamlConfig["Logging"]["AsciiLogs"]) {
                 // Default is !isatty(1) but can be set explicitly in config.yaml
                 settingsMap[ascii_logs] = yamlConfig["Logging"]["AsciiLogs"].as<bool>();
@@ -545,6 +565,68 @@ bool loadConfig(const char *configPath)
                 }
             }
         }
+        // A second radio on the same SPI bus, with its own pins, frequency slot or preset (see Router::addInterface)
+        settingsMap[lora2_module] = 0;
+        if (yamlConfig["Lora2"]) {
+            const struct {
+                configNames cfgName;
+                std::string strName;
+            } loraModules[] = {{use_rf95, "RF95"},     {use_sx1262, "sx1262"}, {use_sx1268, "sx1268"}, {use_sx1280, "sx1280"},
+                               {use_lr1110, "lr1110"}, {use_lr1120, "lr1120"}, {use_lr1121, "lr1121"}, {use_llcc68, "LLCC68"}};
+            for (auto &loraModule : loraModules) {
+                if (yamlConfig["Lora2"]["Module"].as<std::string>("") == loraModule.strName) {
+                    settingsMap[lora2_module] = loraModule.cfgName;
+                    break;
+                }
+            }
+
+            int defaultGpioChip = yamlConfig["Lora2"]["gpiochip"].as<int>(settingsMap[default_gpiochip]);
+            const struct {
+                configNames pin;
+                configNames gpiochip;
+                configNames line;
+                std::string strName;
+            } pinMappings[] = {
+                {lora2_cs_pin, lora2_cs_gpiochip, lora2_cs_line, "CS"},
+                {lora2_irq_pin, lora2_irq_gpiochip, lora2_irq_line, "IRQ"},
+                {lora2_busy_pin, lora2_busy_gpiochip, lora2_busy_line, "Busy"},
+                {lora2_reset_pin, lora2_reset_gpiochip, lora2_reset_line, "Reset"},
+            };
+            for (auto &pinMap : pinMappings) {
+                if (yamlConfig["Lora2"][pinMap.strName].IsMap()) {
+                    settingsMap[pinMap.pin] = yamlConfig["Lora2"][pinMap.strName]["pin"].as<int>(RADIOLIB_NC);
+                    settingsMap[pinMap.line] = yamlConfig["Lora2"][pinMap.strName]["line"].as<int>(settingsMap[pinMap.pin]);
+                    settingsMap[pinMap.gpiochip] = yamlConfig["Lora2"][pinMap.strName]["gpiochip"].as<int>(defaultGpioChip);
+                } else {
+                    settingsMap[pinMap.pin] = yamlConfig["Lora2"][pinMap.strName].as<int>(RADIOLIB_NC);
+                    settingsMap[pinMap.line] = settingsMap[pinMap.pin];
+                    settingsMap[pinMap.gpiochip] = defaultGpioChip;
+                }
+            }
+
+            const struct {
+                meshtastic_Config_LoRaConfig_ModemPreset preset;
+                std::string strName;
+            } presets[] = {{meshtastic_Config_LoRaConfig_ModemPreset_LONG_FAST, "LONG_FAST"},
+                           {meshtastic_Config_LoRaConfig_ModemPreset_LONG_SLOW, "LONG_SLOW"},
+                           {meshtastic_Config_LoRaConfig_ModemPreset_VERY_LONG_SLOW, "VERY_LONG_SLOW"},
+                           {meshtastic_Config_LoRaConfig_ModemPreset_MEDIUM_SLOW, "MEDIUM_SLOW"},
+                           {meshtastic_Config_LoRaConfig_ModemPreset_MEDIUM_FAST, "MEDIUM_FAST"},
+                           {meshtastic_Config_LoRaConfig_ModemPreset_SHORT_SLOW, "SHORT_SLOW"},
+                           {meshtastic_Config_LoRaConfig_ModemPreset_SHORT_FAST, "SHORT_FAST"},
+                           {meshtastic_Config_LoRaConfig_ModemPreset_LONG_MODERATE, "LONG_MODERATE"},
+                           {meshtastic_Config_LoRaConfig_ModemPreset_SHORT_TURBO, "SHORT_TURBO"}};
+            settingsMap[lora2_modem_preset] = -1;
+            for (auto &preset : presets) {
+                if (yamlConfig["Lora2"]["ModemPreset"].as<std::string>("") == preset.strName) {
+                    settingsMap[lora2_modem_preset] = preset.preset;
+                    break;
+                }
+            }
+            settingsMap[lora2_channel_num] = yamlConfig["Lora2"]["ChannelNum"].as<int>(0);
+            settingsMap[lora2_frequency_khz] = yamlConfig["Lora2"]["Frequency"].as<float>(0) * 1000;
+            settingsMap[lora2_bridge] = yamlConfig["Lora2"]["Bridge"].as<bool>(true);
+        }
         if (yamlConfig["GPIO"]) {
             settingsMap[userButtonPin] = yamlConfig["GPIO"]["User"].as<int>(RADIOLIB_NC);
         }
@@ -671,6 +753,7 @@ bool loadConfig(const char *configPath)
                 std::cout << "Cannot set both MACAddress and MACAddressSource!" << std::endl;
                 exit(EXIT_FAILURE);
             }
+            settingsStrings[shmAPIName] = (yamlConfig["General"]["ShmAPI"]).as<std::string>("");
             settingsStrings[mac_address] = (yamlConfig["General"]["MACAddress"]).as<std::string>("");
             if ((yamlConfig["General"]["MACAddressSource"]).as<std::string>("") != "") {
                 std::ifstream infile("/sys/class/net/" + (yamlConfig["General"]["MACAddressSource"]).as<std::string>("") +
@@ -1,6 +1,7 @@
 #pragma once
+#include <csignal>
 #include <fstream>
-#include <map>
+#include <string>
 #include <unordered_map>
 
 #include "platform/portduino/USBHal.h"
@@ -57,6 +58,23 @@ enum configNames {
     lora_usb_serial_num,
     lora_usb_pid,
     lora_usb_vid,
+    lora2_module, // the use_* entry of the second radio's module, 0 for none
+    lora2_cs_pin,
+    lora2_cs_line,
+    lora2_cs_gpiochip,
+    lora2_irq_pin,
+    lora2_irq_line,
+    lora2_irq_gpiochip,
+    lora2_busy_pin,
+    lora2_busy_line,
+    lora2_busy_gpiochip,
+    lora2_reset_pin,
+    lora2_reset_line,
+    lora2_reset_gpiochip,
+    lora2_channel_num,
+    lora2_modem_preset,
+    lora2_frequency_khz,
+    lora2_bridge,
     userButtonPin,
     tbUpPin,
     tbDownPin,
@@ -95,6 +113,9 @@ enum configNames {
     pointerDevice,
     logoutputlevel,
     traceFilename,
+    pcapFilename,
+    pcapMaxMB,
+    eventTraceFilename,
     webserver,
     webserverport,
     webserverrootpath,
@@ -106,18 +127,42 @@ enum configNames {
     config_directory,
     available_directory,
     mac_address,
+    shmAPIName,
     hostMetrics_interval,
     hostMetrics_channel,
-    hostMetrics_user_command
+    hostMetrics_user_command,
+    configNames_MAX // not a setting, the number of them
 };
 enum { no_screen, x11, fb, st7789, st7735, st7735s, st7796, ili9341, ili9342, ili9486, ili9488, hx8357d };
 enum { no_touchscreen, xpt2046, stmpe610, gt911, ft5x06 };
 enum { level_error, level_warn, level_info, level_debug, level_trace };
 
-extern std::map<configNames, int> settingsMap;
-extern std::map<configNames, std::string> settingsStrings;
+/**
+ * Settings indexed by configNames. Used like the std::map this replaced, but each access is an array index rather than a tree
+ * lookup, as some are read on every log message or SPI transfer.
+ */
+template <class T> class PortduinoSettings
+{
+    T values[configNames_MAX] = {};
+    bool present[configNames_MAX] = {};
+
+  public:
+    /// As with std::map, a setting that was never set reads as a default value, and counts as set from then on
+    T &operator[](configNames k)
+    {
+        present[k] = true;
+        return values[k];
+    }
+
+    size_t count(configNames k) const { return present[k] ? 1 : 0; }
+};
+
+extern PortduinoSettings<int> settingsMap;
+extern PortduinoSettings<std::string> settingsStrings;
 extern std::ofstream traceFile;
 extern Ch341Hal *ch341Hal;
+/// Set by SIGTERM, powerCommandsCheck() then saves what is pending and exits
+extern volatile sig_atomic_t termRequested;
 int initGPIOPin(int pinNum, std::string gpioChipname, int line);
 bool loadConfig(const char *configPath);
 static bool ends_with(std::string_view str, std::string_view suffix);
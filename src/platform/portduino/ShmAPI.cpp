@@ -0,0 +1,212 @@
+#include "ShmAPI.h"
+#include "NodeDB.h"
+#include "PowerFSM.h"
+#include "configuration.h"
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static_assert((SHM_API_RING_BYTES & (SHM_API_RING_BYTES - 1)) == 0, "SHM_API_RING_BYTES must be a power of two");
+static_assert(MAX_TO_FROM_RADIO_SIZE < ShmAPI::FRAME_SKIP, "frame lengths are 16 bits");
+
+/// How often we look whether the UI process is still there
+static constexpr uint32_t ALIVE_CHECK_MSEC = 1000;
+
+static constexpr uint32_t RING_MASK = SHM_API_RING_BYTES - 1;
+
+ShmAPI *shmAPI;
+
+ShmAPI *ShmAPI::create(const std::string &name, uint32_t nodeCapacity)
+{
+    // Start from nothing, a segment left behind by a crash may have another layout
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0660);
+    if (fd < 0) {
+        LOG_ERROR("Can't create shared memory %s: %s", name.c_str(), strerror(errno));
+        return nullptr;
+    }
+    size_t size = sizeof(Header) + 2 * sizeof(Ring) + (size_t)nodeCapacity * sizeof(meshtastic_NodeInfoLite);
+    void *map = MAP_FAILED;
+    if (ftruncate(fd, size) == 0)
+        map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the segment
+    if (map == MAP_FAILED) {
+        LOG_ERROR("Can't map shared memory %s: %s", name.c_str(), strerror(errno));
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    // ftruncate zero filled it, so the rings are empty and the view has no nodes
+    Header *h = (Header *)map;
+    h->magic = MAGIC;
+    h->version = VERSION;
+    h->ringBytes = SHM_API_RING_BYTES;
+    h->nodeSize = sizeof(meshtastic_NodeInfoLite);
+    h->nodeCapacity = nodeCapacity;
+    h->daemonPid = getpid();
+    LOG_INFO("Phone API on shared memory %s, %u KB", name.c_str(), (unsigned)(size / 1024));
+    return new ShmAPI(name, map, size);
+}
+
+ShmAPI::ShmAPI(const std::string &name, void *map, size_t mapSize)
+    : concurrency::OSThread("ShmAPI"), name(name), mapSize(mapSize), header((Header *)map)
+{
+    fromRadio = (Ring *)((uint8_t *)map + sizeof(Header));
+    toRadio = fromRadio + 1;
+    nodes = (meshtastic_NodeInfoLite *)(toRadio + 1);
+}
+
+ShmAPI::~ShmAPI()
+{
+    header->daemonPid = 0;
+    munmap(header, mapSize);
+    shm_unlink(name.c_str());
+}
+
+void ShmAPI::checkClient()
+{
+    uint32_t pid = header->clientPid.load(std::memory_order_acquire);
+    if (pid && pid == attachedPid) {
+        if (millis() - lastAliveCheckMs < ALIVE_CHECK_MSEC)
+            return;
+        lastAliveCheckMs = millis();
+        if (kill(pid, 0) == 0 || errno != ESRCH)
+            return;
+        LOG_INFO("Shared memory client %u went away", pid);
+        // Empty the rings of what it left before letting another client in, which only writes once its clientPid is set
+        emptyRings();
+        header->clientPid.compare_exchange_strong(pid, 0);
+        pid = 0;
+    } else if (attached && !pid) {
+        emptyRings(); // it left by clearing clientPid
+    }
+    if (attached) {
+        close(); // the session ends with the process, a new one starts with its want_config
+        attached = false;
+    }
+    if (pid) {
+        LOG_INFO("Shared memory client %u attached", pid);
+        attached = true;
+        lastAliveCheckMs = millis();
+    }
+    attachedPid = pid;
+}
+
+void ShmAPI::emptyRings()
+{
+    fromRadio->tail.store(fromRadio->head.load());
+    toRadio->tail.store(toRadio->head.load());
+}
+
+uint8_t *ShmAPI::reserve(Ring &r, size_t maxLen, uint32_t &frameHead)
+{
+    uint32_t head = r.head.load(std::memory_order_relaxed);
+    uint32_t tail = r.tail.load(std::memory_order_acquire);
+    uint32_t offset = head & RING_MASK;
+    uint32_t toEnd = SHM_API_RING_BYTES - offset;
+    uint32_t need = sizeof(uint16_t) + maxLen;
+    uint32_t skip = toEnd < need ? toEnd : 0;
+    if (SHM_API_RING_BYTES - (head - tail) < skip + need)
+        return nullptr;
+    if (skip) {
+        if (toEnd >= sizeof(uint16_t))
+            memcpy(&r.data[offset], &FRAME_SKIP, sizeof(uint16_t));
+        head += skip;
+        offset = 0;
+    }
+    frameHead = head;
+    return &r.data[offset + sizeof(uint16_t)];
+}
+
+void ShmAPI::commit(Ring &r, uint8_t *frame, size_t len, uint32_t frameHead)
+{
+    uint16_t len16 = len;
+    memcpy(frame - sizeof(uint16_t), &len16, sizeof(len16));
+    r.head.store(frameHead + sizeof(uint16_t) + len, std::memory_order_release);
+}
+
+const uint8_t *ShmAPI::peek(Ring &r, size_t &len)
+{
+    uint32_t head = r.head.load(std::memory_order_acquire);
+    uint32_t tail = r.tail.load(std::memory_order_relaxed);
+    while (tail != head) {
+        uint32_t offset = tail & RING_MASK;
+        uint32_t toEnd = SHM_API_RING_BYTES - offset;
+        uint16_t len16 = FRAME_SKIP;
+        if (toEnd >= sizeof(uint16_t))
+            memcpy(&len16, &r.data[offset], sizeof(len16));
+        if (len16 == FRAME_SKIP) {
+            tail += toEnd;
+            r.tail.store(tail, std::memory_order_release);
+            continue;
+        }
+        if (len16 > MAX_TO_FROM_RADIO_SIZE || len16 > toEnd - sizeof(uint16_t)) {
+            LOG_ERROR("Shared memory ring corrupt, dropping what is in it");
+            r.tail.store(head, std::memory_order_release);
+            return nullptr;
+        }
+        len = len16;
+        return &r.data[offset + sizeof(uint16_t)];
+    }
+    return nullptr;
+}
+
+void ShmAPI::consume(Ring &r, size_t len)
+{
+    r.tail.store(r.tail.load(std::memory_order_relaxed) + sizeof(uint16_t) + len, std::memory_order_release);
+}
+
+void ShmAPI::refreshNodes()
+{
+    uint32_t count = std::min<uint32_t>(nodeDB->getNumMeshNodes(), header->nodeCapacity);
+    bool changed = count != header->nodeCount.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < count && !changed; i++)
+        changed = memcmp(&nodes[i], nodeDB->getMeshNodeByIndex(i), sizeof(meshtastic_NodeInfoLite)) != 0;
+    if (!changed)
+        return;
+
+    uint32_t seq = header->nodesSeq.load(std::memory_order_relaxed);
+    header->nodesSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (uint32_t i = 0; i < count; i++)
+        nodes[i] = *nodeDB->getMeshNodeByIndex(i);
+    header->nodeCount.store(count, std::memory_order_relaxed);
+    header->nodesSeq.store(seq + 2, std::memory_order_release);
+}
+
+int32_t ShmAPI::runOnce()
+{
+    if (millis() - lastNodesRefreshMs >= SHM_API_NODES_REFRESH_MSEC) {
+        lastNodesRefreshMs = millis();
+        refreshNodes(); // kept up to date even with no UI, so one attaching can draw the list at once
+    }
+
+    checkClient();
+    if (!attached)
+        return 100;
+
+    bool busy = false;
+    size_t len;
+    while (const uint8_t *frame = peek(*toRadio, len)) {
+        powerFSM.trigger(EVENT_CONTACT_FROM_PHONE);
+        lastContactMsec = millis();
+        handleToRadio(frame, len);
+        consume(*toRadio, len);
+        busy = true;
+    }
+
+    uint32_t frameHead;
+    while (uint8_t *frame = reserve(*fromRadio, MAX_TO_FROM_RADIO_SIZE, frameHead)) {
+        len = getFromRadio(frame);
+        if (!len)
+            break;
+        commit(*fromRadio, frame, len, frameHead);
+        busy = true;
+    }
+
+    return busy ? 5 : 20;
+}
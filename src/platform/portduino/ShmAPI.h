@@ -0,0 +1,106 @@
+#pragma once
+
+#include "PhoneAPI.h"
+#include "concurrency/OSThread.h"
+#include "mesh/generated/meshtastic/deviceonly.pb.h"
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+/// Bytes in each direction's ring, a power of two
+#ifndef SHM_API_RING_BYTES
+#define SHM_API_RING_BYTES (64 * 1024)
+#endif
+
+/// How often the node view is brought up to date
+#ifndef SHM_API_NODES_REFRESH_MSEC
+#define SHM_API_NODES_REFRESH_MSEC 1000
+#endif
+
+/**
+ * The phone API over POSIX shared memory, for a UI running as another process on the same machine as meshtasticd.
+ *
+ * Set with General: ShmAPI in config.yaml, the name passed to shm_open().  The segment is a Header, then a Ring of FromRadio
+ * frames to the UI, a Ring of ToRadio frames from it, then the node view: nodeCapacity NodeInfoLite exactly as NodeDB keeps
+ * them.  Native byte order and struct layout, so the UI has to be built from the same protobufs.
+ *
+ * A frame is its length (uint16_t) then the encoded protobuf.  FromRadio messages are encoded straight into the ring and the
+ * UI decodes them where they lie, as we do ToRadio, so nothing is copied on the way.  A frame never wraps around the end of
+ * the ring: when one wouldn't fit, a length of FRAME_SKIP (or the less than two bytes left) says to go on from the start.
+ * Each ring has one writer, which only moves head, and one reader, which only moves tail; both count bytes since the start.
+ *
+ * The node view lets the UI draw the node list without it being streamed: a UI that asks for its config with
+ * SPECIAL_NONCE_ONLY_CONFIG gets no NodeInfos, and reads the nodes from the view instead.  nodesSeq is a seqlock, odd while
+ * the view is being written: read it, copy what you need, and read again; if it changed, or was odd, copy again.
+ *
+ * The UI attaches by setting clientPid from 0 (compare and swap, one UI at a time), then writes to the rings, and clears it
+ * when it leaves.  If the process goes away without, we end the session and empty the rings before clearing clientPid.
+ */
+class ShmAPI : public PhoneAPI, private concurrency::OSThread
+{
+  public:
+    static constexpr uint32_t MAGIC = 0x49504153; // "SAPI"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint16_t FRAME_SKIP = 0xffff;
+
+    struct Ring {
+        std::atomic<uint32_t> head; // bytes written, moved by the writer once a frame is complete
+        std::atomic<uint32_t> tail; // bytes read, moved by the reader once it is done with a frame
+        uint8_t data[SHM_API_RING_BYTES];
+    };
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;      // of this layout
+        uint32_t ringBytes;    // SHM_API_RING_BYTES
+        uint32_t nodeSize;     // sizeof(meshtastic_NodeInfoLite), changes whenever it does
+        uint32_t nodeCapacity; // nodes the view holds
+        std::atomic<uint32_t> daemonPid;
+        std::atomic<uint32_t> clientPid; // 0 while no UI is attached
+        std::atomic<uint32_t> nodesSeq;  // seqlock over nodeCount and the nodes, odd while they change
+        std::atomic<uint32_t> nodeCount;
+    };
+
+    /// Create the segment, nullptr if it can't be
+    static ShmAPI *create(const std::string &name, uint32_t nodeCapacity);
+
+    ~ShmAPI();
+
+  protected:
+    virtual int32_t runOnce() override;
+
+    virtual bool checkIsConnected() override { return attached; }
+
+  private:
+    ShmAPI(const std::string &name, void *map, size_t mapSize);
+
+    std::string name;
+    size_t mapSize;
+    Header *header;
+    Ring *fromRadio, *toRadio;
+    meshtastic_NodeInfoLite *nodes;
+
+    uint32_t attachedPid = 0;
+    bool attached = false;
+    uint32_t lastAliveCheckMs = 0, lastNodesRefreshMs = 0;
+
+    /// Follow the UI coming and going
+    void checkClient();
+
+    /// Drop whatever is in both rings, between clients
+    void emptyRings();
+
+    /// Room for a frame of up to maxLen bytes in r, nullptr if it is full.  Nothing is visible to the reader until commit()
+    uint8_t *reserve(Ring &r, size_t maxLen, uint32_t &frameHead);
+    void commit(Ring &r, uint8_t *frame, size_t len, uint32_t frameHead);
+
+    /// The next frame in r, nullptr if there is none.  Stays in the ring until consume()
+    const uint8_t *peek(Ring &r, size_t &len);
+    void consume(Ring &r, size_t len);
+
+    /// Copy NodeDB into the node view, if anything in it changed
+    void refreshNodes();
+};
+
+extern ShmAPI *shmAPI;
@@ -13,7 +13,7 @@ ErrorCode SimRadio::send(meshtastic_MeshPacket *p)
 {
     printPacket("enqueuing for send", p);
 
-    ErrorCode res = txQueue.enqueue(p) ? ERRNO_OK : ERRNO_UNKNOWN;
+    ErrorCode res = txQueue.enqueue(p, getPacketTime(p), getAirTime()) ? ERRNO_OK : ERRNO_UNKNOWN;
 
     if (res != ERRNO_OK) { // we weren't able to queue it, so we must drop it to prevent leaks
         packetPool.release(p);
@@ -173,7 +173,11 @@ void SimRadio::onNotify(uint32_t notification)
                 // LOG_DEBUG("Currently Rx/Tx-ing: set random delay");
                 setTransmitDelay(); // currently Rx/Tx-ing: reset random delay
             } else {
-                if (isChannelActive()) { // check if there is currently a LoRa packet on the channel
+                bool busy = isChannelActive(); // check if there is currently a LoRa packet on the channel
+#if AIRTIME_SERIES
+                getAirTime()->logCad(busy);
+#endif
+                if (busy) {
                     // LOG_DEBUG("Channel is active: set random delay");
                     setTransmitDelay(); // reset random delay
                 } else {
@@ -183,7 +187,7 @@ void SimRadio::onNotify(uint32_t notification)
                     startSend(txp);
                     // Packet has been sent, count it toward our TX airtime utilization.
                     uint32_t xmitMsec = getPacketTime(txp);
-                    airTime->logAirtime(TX_LOG, xmitMsec);
+                    getAirTime()->logAirtime(TX_LOG, xmitMsec);
 
                     notifyLater(xmitMsec, ISR_TX, false); // Model the time it is busy sending
                 }
@@ -252,7 +256,7 @@ void SimRadio::startReceive(meshtastic_MeshPacket *p)
     if (isActivelyReceiving()) {
         LOG_WARN("Collision detected, dropping current and previous packet!");
         rxBad++;
-        airTime->logAirtime(RX_ALL_LOG, getPacketTime(receivingPacket));
+        getAirTime()->logAirtime(RX_ALL_LOG, getPacketTime(receivingPacket));
         packetPool.release(receivingPacket);
         receivingPacket = nullptr;
         return;
@@ -308,10 +312,11 @@ void SimRadio::handleReceiveInterrupt()
     meshtastic_MeshPacket *mp = packetPool.allocCopy(*receivingPacket); // keep a copy in packetPool
     packetPool.release(receivingPacket);                                // release the original
     receivingPacket = nullptr;
+    mp->rx_time = 0; // whatever the simulator packet carried, let the router stamp our arrival time
 
     printPacket("Lora RX", mp);
 
-    airTime->logAirtime(RX_LOG, getPacketTime(mp));
+    getAirTime()->logAirtime(RX_LOG, getPacketTime(mp));
 
     deliverToReceiver(mp);
 }
@@ -15,6 +15,14 @@
 #ifndef HAS_WIRE
 #define HAS_WIRE 1
 #endif
+// Only 64KB of RAM, keep a small packet slab and let bursts use the heap
+#ifndef PACKET_POOL_SIZE
+#define PACKET_POOL_SIZE 8
+#endif
+// One packet per serial write, the batch buffer isn't worth the RAM here
+#ifndef STREAM_TX_BATCH_SIZE
+#define STREAM_TX_BATCH_SIZE MAX_STREAM_BUF_SIZE
+#endif
 
 //
 // set HW_VENDOR
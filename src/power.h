@@ -106,7 +106,7 @@ class Power : private concurrency::OSThread
 {
 
   public:
-    Observable<const meshtastic::PowerStatus *> newStatus;
+    ObservableArray<const meshtastic::PowerStatus *, 2> newStatus;
 
     Power();
 
@@ -0,0 +1,341 @@
+#include "JSONReader.h"
+#include <stdlib.h>
+#include <string.h>
+
+JSONReader::Token JSONReader::fail()
+{
+    failed = true;
+    return token = TOKEN_ERROR;
+}
+
+void JSONReader::skipWhitespace()
+{
+    while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n'))
+        pos++;
+}
+
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// pos is at the opening quote
+bool JSONReader::scanString()
+{
+    tokStart = ++pos;
+    while (pos < end) {
+        unsigned char c = *pos;
+        if (c == '"') {
+            tokLen = pos++ - tokStart;
+            return true;
+        }
+        if (c < 0x20)
+            return false;
+        if (c == '\\') {
+            if (++pos >= end)
+                return false;
+            if (*pos == 'u') {
+                for (int i = 0; i < 4; i++)
+                    if (++pos >= end || hexValue(*pos) < 0)
+                        return false;
+            } else if (!strchr("\"\\/bfnrt", *pos) || !*pos) {
+                return false;
+            }
+        }
+        pos++;
+    }
+    return false;
+}
+
+static bool isDigit(const char *p, const char *end)
+{
+    return p < end && *p >= '0' && *p <= '9';
+}
+
+bool JSONReader::scanNumber()
+{
+    tokStart = pos;
+    if (*pos == '-')
+        pos++;
+    if (!isDigit(pos, end))
+        return false;
+    if (*pos == '0')
+        pos++;
+    else
+        while (isDigit(pos, end))
+            pos++;
+    if (pos < end && *pos == '.') {
+        if (!isDigit(++pos, end))
+            return false;
+        while (isDigit(pos, end))
+            pos++;
+    }
+    if (pos < end && (*pos == 'e' || *pos == 'E')) {
+        pos++;
+        if (pos < end && (*pos == '+' || *pos == '-'))
+            pos++;
+        if (!isDigit(pos, end))
+            return false;
+        while (isDigit(pos, end))
+            pos++;
+    }
+    tokLen = pos - tokStart;
+    return true;
+}
+
+bool JSONReader::scanLiteral(const char *literal)
+{
+    size_t n = strlen(literal);
+    if ((size_t)(end - pos) < n || memcmp(pos, literal, n) != 0)
+        return false;
+    pos += n;
+    return true;
+}
+
+void JSONReader::valueDone()
+{
+    expect = depth ? EXPECT_COMMA_OR_END : EXPECT_DONE;
+}
+
+JSONReader::Token JSONReader::open(bool isArray)
+{
+    if (depth >= MAX_DEPTH)
+        return fail();
+    pos++;
+    if (isArray)
+        inArray |= 1UL << depth;
+    else
+        inArray &= ~(1UL << depth);
+    depth++;
+    expect = isArray ? EXPECT_VALUE_OR_END : EXPECT_KEY_OR_END;
+    return token = isArray ? TOKEN_ARRAY_START : TOKEN_OBJECT_START;
+}
+
+JSONReader::Token JSONReader::close(bool isArray)
+{
+    if (!depth || (bool)(inArray & (1UL << (depth - 1))) != isArray)
+        return fail();
+    pos++;
+    depth--;
+    valueDone();
+    return token = isArray ? TOKEN_ARRAY_END : TOKEN_OBJECT_END;
+}
+
+JSONReader::Token JSONReader::next()
+{
+    if (failed)
+        return TOKEN_ERROR;
+
+    skipWhitespace();
+    if (expect == EXPECT_DONE)
+        return token = (pos == end) ? TOKEN_END : fail();
+    if (pos == end)
+        return fail();
+
+    char c = *pos;
+    switch (expect) {
+    case EXPECT_COMMA_OR_END:
+        if (c == '}' || c == ']')
+            return close(c == ']');
+        if (c != ',')
+            return fail();
+        pos++;
+        skipWhitespace();
+        if (pos == end)
+            return fail();
+        c = *pos;
+        if (!(inArray & (1UL << (depth - 1))))
+            goto key;
+        break;
+
+    case EXPECT_KEY_OR_END:
+        if (c == '}')
+            return close(false);
+        // fall through
+    case EXPECT_KEY:
+    key:
+        if (c != '"' || !scanString())
+            return fail();
+        skipWhitespace();
+        if (pos == end || *pos != ':')
+            return fail();
+        pos++;
+        expect = EXPECT_VALUE;
+        return token = TOKEN_KEY;
+
+    case EXPECT_VALUE_OR_END:
+        if (c == ']')
+            return close(true);
+        break;
+
+    default:
+        break;
+    }
+
+    // A value, either where one is expected or after a comma in an array
+    switch (c) {
+    case '{':
+        return open(false);
+    case '[':
+        return open(true);
+    case '"':
+        if (!scanString())
+            return fail();
+        token = TOKEN_STRING;
+        break;
+    case 't':
+        if (!scanLiteral("true"))
+            return fail();
+        token = TOKEN_TRUE;
+        break;
+    case 'f':
+        if (!scanLiteral("false"))
+            return fail();
+        token = TOKEN_FALSE;
+        break;
+    case 'n':
+        if (!scanLiteral("null"))
+            return fail();
+        token = TOKEN_NULL;
+        break;
+    default:
+        if (!scanNumber())
+            return fail();
+        token = TOKEN_NUMBER;
+        break;
+    }
+    valueDone();
+    return token;
+}
+
+bool JSONReader::skipValue()
+{
+    Token t = next();
+    if (t == TOKEN_ERROR || t == TOKEN_END || t == TOKEN_KEY || t == TOKEN_OBJECT_END || t == TOKEN_ARRAY_END)
+        return false;
+    return finishValue();
+}
+
+bool JSONReader::finishValue()
+{
+    if (token == TOKEN_ERROR)
+        return false;
+    if (token != TOKEN_OBJECT_START && token != TOKEN_ARRAY_START)
+        return true;
+
+    uint8_t containerDepth = depth - 1;
+    while (depth > containerDepth)
+        if (next() == TOKEN_ERROR)
+            return false;
+    return true;
+}
+
+bool JSONReader::is(const char *str) const
+{
+    return strlen(str) == tokLen && memcmp(str, tokStart, tokLen) == 0;
+}
+
+// Encode a code point as UTF-8, returns its length
+static size_t toUtf8(uint32_t cp, char *utf8)
+{
+    if (cp < 0x80) {
+        utf8[0] = cp;
+        return 1;
+    } else if (cp < 0x800) {
+        utf8[0] = 0xC0 | (cp >> 6);
+        utf8[1] = 0x80 | (cp & 0x3F);
+        return 2;
+    } else if (cp < 0x10000) {
+        utf8[0] = 0xE0 | (cp >> 12);
+        utf8[1] = 0x80 | ((cp >> 6) & 0x3F);
+        utf8[2] = 0x80 | (cp & 0x3F);
+        return 3;
+    }
+    utf8[0] = 0xF0 | (cp >> 18);
+    utf8[1] = 0x80 | ((cp >> 12) & 0x3F);
+    utf8[2] = 0x80 | ((cp >> 6) & 0x3F);
+    utf8[3] = 0x80 | (cp & 0x3F);
+    return 4;
+}
+
+static uint32_t hex4(const char *p)
+{
+    return (hexValue(p[0]) << 12) | (hexValue(p[1]) << 8) | (hexValue(p[2]) << 4) | hexValue(p[3]);
+}
+
+size_t JSONReader::getString(char *dst, size_t dstSize) const
+{
+    size_t n = 0;                                     // unescaped length so far
+    size_t written = 0;                               // how much of that fitted in dst
+    size_t room = dstSize ? dstSize - 1 : 0;          // leave space for the NUL
+    const char *s = tokStart, *e = tokStart + tokLen; // scanString() has already checked the escapes
+    while (s < e) {
+        char c[4] = {*s++};
+        size_t len = 1;
+        if (c[0] == '\\') {
+            switch (*s++) {
+            case 'b':
+                c[0] = '\b';
+                break;
+            case 'f':
+                c[0] = '\f';
+                break;
+            case 'n':
+                c[0] = '\n';
+                break;
+            case 'r':
+                c[0] = '\r';
+                break;
+            case 't':
+                c[0] = '\t';
+                break;
+            case 'u': {
+                uint32_t cp = hex4(s);
+                s += 4;
+                // Combine a surrogate pair, a lone surrogate is kept as it is
+                if (cp >= 0xD800 && cp < 0xDC00 && e - s >= 6 && s[0] == '\\' && s[1] == 'u') {
+                    uint32_t low = hex4(s + 2);
+                    if (low >= 0xDC00 && low < 0xE000) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        s += 6;
+                    }
+                }
+                len = toUtf8(cp, c);
+                break;
+            }
+            default:
+                c[0] = s[-1]; // " \ and / stand for themselves
+                break;
+            }
+        }
+        if (written == n && n + len <= room) { // never split a character when truncating
+            memcpy(dst + n, c, len);
+            written += len;
+        }
+        n += len;
+    }
+    if (dstSize)
+        dst[written] = '\0';
+    return n;
+}
+
+double JSONReader::getNumber() const
+{
+    char num[32];
+    size_t n = tokLen < sizeof(num) - 1 ? tokLen : sizeof(num) - 1;
+    memcpy(num, tokStart, n);
+    num[n] = '\0';
+    return strtod(num, NULL);
+}
+
+bool JSONReader::isValid(const char *json, size_t len)
+{
+    JSONReader reader(json, len);
+    return reader.skipValue() && reader.next() == TOKEN_END;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A pull parser over a JSON document in memory, for the downlink path where building a JSONValue tree for each message
+ * would mean a heap allocation per member.
+ *
+ * Call next() to walk the document one token at a time.  Strings (and keys) are left escaped in the input, getString()
+ * unescapes one into a caller supplied buffer, so the parser never allocates and never modifies its input.
+ */
+class JSONReader
+{
+  public:
+    enum Token {
+        TOKEN_END, // the whole document has been read
+        TOKEN_ERROR,
+        TOKEN_OBJECT_START,
+        TOKEN_OBJECT_END,
+        TOKEN_ARRAY_START,
+        TOKEN_ARRAY_END,
+        TOKEN_KEY,
+        TOKEN_STRING,
+        TOKEN_NUMBER,
+        TOKEN_TRUE,
+        TOKEN_FALSE,
+        TOKEN_NULL
+    };
+
+    JSONReader(const char *json, size_t len) : json(json), end(json + len), pos(json) {}
+
+    /// @return the next token, after TOKEN_END or TOKEN_ERROR it always returns the same again
+    Token next();
+
+    /// Skip the next value, including everything inside it if it is an object or array
+    /// @return false if the document is invalid
+    bool skipValue();
+
+    /// If next() just returned TOKEN_OBJECT_START or TOKEN_ARRAY_START, skip everything up to the matching end
+    /// @return false if the document is invalid
+    bool finishValue();
+
+    /// @return true if the current TOKEN_KEY or TOKEN_STRING is exactly str (compared before unescaping)
+    bool is(const char *str) const;
+
+    /// Unescape the current TOKEN_KEY or TOKEN_STRING into dst, truncating to fit and NUL terminating it
+    /// @return the unescaped length, which is more than dstSize - 1 if it was truncated
+    size_t getString(char *dst, size_t dstSize) const;
+
+    /// @return the value of the current TOKEN_NUMBER
+    double getNumber() const;
+
+    /// @return true if json is exactly one valid JSON value, optionally surrounded by whitespace
+    static bool isValid(const char *json, size_t len);
+
+  private:
+    enum Expect { EXPECT_VALUE, EXPECT_VALUE_OR_END, EXPECT_KEY, EXPECT_KEY_OR_END, EXPECT_COMMA_OR_END, EXPECT_DONE };
+    static const uint8_t MAX_DEPTH = 32;
+
+    const char *json, *end, *pos;
+    const char *tokStart = NULL; // contents of the current string or number (without the quotes)
+    size_t tokLen = 0;
+    Token token = TOKEN_END;
+    Expect expect = EXPECT_VALUE;
+    bool failed = false;
+    uint8_t depth = 0;
+    uint32_t inArray = 0; // bit n is set if the container at depth n + 1 is an array
+
+    Token fail();
+    void skipWhitespace();
+    bool scanString();
+    bool scanNumber();
+    bool scanLiteral(const char *literal);
+    Token open(bool isArray);
+    Token close(bool isArray);
+    void valueDone();
+};
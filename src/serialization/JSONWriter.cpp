@@ -0,0 +1,204 @@
+#include "JSONWriter.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+JSONWriter::JSONWriter(char *buf, size_t size) : buf(buf), size(size)
+{
+    if (size)
+        buf[0] = '\0';
+    else
+        overflow = true;
+}
+
+void JSONWriter::put(const char *s, size_t n)
+{
+    if (overflow)
+        return;
+    if (n >= size - len) {
+        overflow = true;
+        return;
+    }
+    memcpy(buf + len, s, n);
+    len += n;
+    buf[len] = '\0';
+}
+
+void JSONWriter::put(char c)
+{
+    put(&c, 1);
+}
+
+void JSONWriter::appendf(const char *format, ...)
+{
+    if (overflow)
+        return;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf + len, size - len, format, args);
+    va_end(args);
+    if (n < 0 || (size_t)n >= size - len) {
+        overflow = true;
+        buf[len] = '\0'; // drop the partial number
+        return;
+    }
+    len += n;
+}
+
+void JSONWriter::separate()
+{
+    if (needComma)
+        put(',');
+    needComma = true;
+}
+
+JSONWriter &JSONWriter::beginObject()
+{
+    separate();
+    put('{');
+    needComma = false;
+    return *this;
+}
+
+JSONWriter &JSONWriter::endObject()
+{
+    put('}');
+    needComma = true;
+    return *this;
+}
+
+JSONWriter &JSONWriter::beginArray()
+{
+    separate();
+    put('[');
+    needComma = false;
+    return *this;
+}
+
+JSONWriter &JSONWriter::endArray()
+{
+    put(']');
+    needComma = true;
+    return *this;
+}
+
+JSONWriter &JSONWriter::key(const char *name)
+{
+    value(name);
+    put(':');
+    needComma = false;
+    return *this;
+}
+
+JSONWriter &JSONWriter::value(const char *str)
+{
+    return value(str, strlen(str));
+}
+
+// Same escaping as JSONValue::StringifyString(), multi-byte UTF-8 sequences are copied as they are
+JSONWriter &JSONWriter::value(const char *str, size_t n)
+{
+    separate();
+    put('"');
+    const char *run = str; // start of the characters that need no escaping
+    for (const char *s = str; s < str + n; s++) {
+        unsigned char c = *s;
+        const char *esc = NULL;
+        switch (c) {
+        case '"':
+            esc = "\\\"";
+            break;
+        case '\\':
+            esc = "\\\\";
+            break;
+        case '/':
+            esc = "\\/";
+            break;
+        case '\b':
+            esc = "\\b";
+            break;
+        case '\f':
+            esc = "\\f";
+            break;
+        case '\n':
+            esc = "\\n";
+            break;
+        case '\r':
+            esc = "\\r";
+            break;
+        case '\t':
+            esc = "\\t";
+            break;
+        default:
+            if (c < 0x20 || c == 0x7F)
+                break;
+            continue;
+        }
+
+        put(run, s - run);
+        run = s + 1;
+        if (esc)
+            put(esc, strlen(esc));
+        else
+            appendf("\\u%04x", c);
+    }
+    put(run, str + n - run);
+    put('"');
+    return *this;
+}
+
+JSONWriter &JSONWriter::value(bool b)
+{
+    separate();
+    if (b)
+        put("true", 4);
+    else
+        put("false", 5);
+    return *this;
+}
+
+JSONWriter &JSONWriter::value(int i)
+{
+    separate();
+    appendf("%d", i);
+    return *this;
+}
+
+JSONWriter &JSONWriter::value(unsigned int u)
+{
+    separate();
+    appendf("%u", u);
+    return *this;
+}
+
+JSONWriter &JSONWriter::value(long i)
+{
+    separate();
+    appendf("%ld", i);
+    return *this;
+}
+
+JSONWriter &JSONWriter::value(unsigned long u)
+{
+    separate();
+    appendf("%lu", u);
+    return *this;
+}
+
+JSONWriter &JSONWriter::value(double d)
+{
+    separate();
+    if (isinf(d) || isnan(d))
+        put("null", 4);
+    else
+        appendf("%.15g", d);
+    return *this;
+}
+
+JSONWriter &JSONWriter::raw(const char *json, size_t n)
+{
+    separate();
+    put(json, n);
+    return *this;
+}
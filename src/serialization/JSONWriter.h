@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Writes JSON straight into a caller supplied buffer, for the hot paths (MQTT uplink, packet logging) where building a
+ * JSONValue tree would mean a heap allocation per member.
+ *
+ * Members are written in the order they are added and commas are inserted as needed.  Nothing is checked beyond that, so
+ * keys must only be added inside objects.  If the buffer fills up the writer stops writing and overflowed() is set, the
+ * buffer then holds a truncated (but NUL terminated) document.
+ *
+ * Output matches JSONValue::Stringify(): strings get the same escaping and numbers are printed with 15 significant digits.
+ */
+class JSONWriter
+{
+  public:
+    JSONWriter(char *buf, size_t size);
+
+    JSONWriter &beginObject();
+    JSONWriter &endObject();
+    JSONWriter &beginArray();
+    JSONWriter &endArray();
+
+    /// Start an object member, follow with a value() or begin*()
+    JSONWriter &key(const char *name);
+
+    JSONWriter &value(const char *str);
+    JSONWriter &value(const char *str, size_t len);
+    JSONWriter &value(bool b);
+    JSONWriter &value(int i);
+    JSONWriter &value(unsigned int u);
+    JSONWriter &value(long i);
+    JSONWriter &value(unsigned long u);
+    JSONWriter &value(double d);
+
+    /// Insert json, which must already be a complete valid JSON value
+    JSONWriter &raw(const char *json, size_t len);
+
+    /// Shorthand for key(name).value(v)
+    template <typename T> JSONWriter &field(const char *name, T v) { return key(name).value(v); }
+    JSONWriter &field(const char *name, const char *str, size_t len) { return key(name).value(str, len); }
+
+    bool overflowed() const { return overflow; }
+    size_t length() const { return len; }
+    const char *c_str() const { return buf; }
+
+  private:
+    char *buf;
+    size_t size, len = 0;
+    bool overflow = false;
+    bool needComma = false; // a value was just completed, the next one needs a separator
+
+    void put(char c);
+    void put(const char *s, size_t n);
+    void separate();
+    void appendf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
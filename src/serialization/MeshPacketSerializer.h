@@ -1,6 +1,11 @@
 #include <meshtastic/mesh.pb.h>
 #include <string>
 
+/// Largest JSON rendering of a packet we produce, including the NUL
+#ifndef MESHPACKET_JSON_MAX
+#define MESHPACKET_JSON_MAX 2048
+#endif
+
 static const char hexChars[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
 
 class MeshPacketSerializer
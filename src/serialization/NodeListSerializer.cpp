@@ -0,0 +1,81 @@
+#include "NodeListSerializer.h"
+#include "JSONWriter.h"
+#include "NodeDB.h"
+#include "configuration.h"
+#include <stdio.h>
+
+size_t NodeListSerializer::next(char *buf, size_t size)
+{
+    switch (state) {
+    case HEADER: {
+        state = NODES;
+        int n = snprintf(buf, size, "{\"data\":{\"nodes\":[");
+        return (n > 0 && (size_t)n < size) ? n : 0;
+    }
+
+    case NODES: {
+        const meshtastic_NodeInfoLite *node;
+        while ((node = nodeDB->readNextMeshNode(readIndex)) != NULL) {
+            if (!node->has_user)
+                continue;
+            // Past the page we still walk the rest for the total, but there's nothing to format
+            if (total++ < offset || sent >= limit)
+                continue;
+
+            size_t start = sent ? 1 : 0;
+            if (start)
+                buf[0] = ',';
+            JSONWriter w(buf + start, size - start);
+
+            char id[16];
+            snprintf(id, sizeof(id), "!%08x", node->num);
+            char macStr[18];
+            snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X", node->user.macaddr[0], node->user.macaddr[1],
+                     node->user.macaddr[2], node->user.macaddr[3], node->user.macaddr[4], node->user.macaddr[5]);
+
+            w.beginObject();
+            w.field("id", id);
+            w.field("snr", (double)node->snr);
+            w.field("via_mqtt", node->via_mqtt ? "true" : "false");
+            w.field("last_heard", (int)node->last_heard);
+            w.key("position");
+            if (nodeDB->hasValidPosition(node)) {
+                w.beginObject();
+                w.field("latitude", (float)node->position.latitude_i * 1e-7);
+                w.field("longitude", (float)node->position.longitude_i * 1e-7);
+                w.field("altitude", (int)node->position.altitude);
+                w.endObject();
+            } else {
+                w.raw("null", 4);
+            }
+            w.field("long_name", node->user.long_name);
+            w.field("short_name", node->user.short_name);
+            w.field("mac_address", macStr);
+            w.field("hw_model", (int)node->user.hw_model);
+            w.endObject();
+
+            if (w.overflowed()) {
+                LOG_WARN("Node %s too big for /json/nodes, skipped", id);
+                continue;
+            }
+            sent++;
+            return start + w.length();
+        }
+        state = FOOTER;
+    }
+        // fall through
+    case FOOTER: {
+        state = DONE;
+        int n;
+        if (limit == UINT32_MAX)
+            n = snprintf(buf, size, "],\"offset\":%u,\"total\":%u},\"status\":\"ok\"}", (unsigned)offset, (unsigned)total);
+        else
+            n = snprintf(buf, size, "],\"offset\":%u,\"limit\":%u,\"total\":%u},\"status\":\"ok\"}", (unsigned)offset,
+                         (unsigned)limit, (unsigned)total);
+        return (n > 0 && (size_t)n < size) ? n : 0;
+    }
+
+    default:
+        return 0;
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Produces the /json/nodes document a piece at a time, so the web servers can send it as they go instead of building the
+ * whole node list as JSONValues first.  The first piece is the envelope, then each node is its own piece, then the end.  Memory
+ * use is the caller's buffer however big NodeDB is.
+ *
+ *   {"data":{"nodes":[{...},...],"offset":0,"limit":10,"total":123},"status":"ok"}
+ *
+ * Only nodes that have a user are listed, offset and limit page through those and total counts all of them.  "limit" is
+ * left out when the whole list was asked for.
+ */
+class NodeListSerializer
+{
+  public:
+    /// Room next() needs for any single piece, including the NUL
+    static const size_t PIECE_MAX = 512;
+
+    /// Pass UINT32_MAX as limit for every node from offset on
+    NodeListSerializer(uint32_t offset, uint32_t limit) : offset(offset), limit(limit) {}
+
+    /// Fill buf (at least PIECE_MAX) with the next piece.  @return its length, 0 once the document is complete
+    size_t next(char *buf, size_t size);
+
+  private:
+    enum State { HEADER, NODES, FOOTER, DONE } state = HEADER;
+    uint32_t offset, limit;
+    uint32_t readIndex = 0; // into NodeDB
+    uint32_t total = 0;     // listable nodes seen so far
+    uint32_t sent = 0;
+};
@@ -1,3 +1,4 @@
+#include "NodeDB.h"
 #include "buzz.h"
 #include "configuration.h"
 #include "graphics/Screen.h"
@@ -7,6 +8,7 @@
 #if defined(ARCH_PORTDUINO)
 #include "api/WiFiServerAPI.h"
 #include "input/LinuxInputImpl.h"
+#include "platform/portduino/PortduinoGlue.h"
 
 #endif
 
@@ -52,9 +54,18 @@ void powerCommandsCheck()
         playShutdownMelody();
         power->shutdown();
 #elif defined(ARCH_PORTDUINO)
+        nodeDB->flushPendingSaves(); // deep sleep saves everything on the other platforms
         exit(EXIT_SUCCESS);
 #else
         LOG_WARN("FIXME implement shutdown for this platform");
 #endif
     }
+
+#if defined(ARCH_PORTDUINO)
+    if (termRequested) {
+        LOG_INFO("Shut down on SIGTERM");
+        nodeDB->flushPendingSaves();
+        exit(EXIT_SUCCESS);
+    }
+#endif
 }
\ No newline at end of file
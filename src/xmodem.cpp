@@ -80,6 +80,24 @@ unsigned short XModemAdapter::crc16_ccitt(const pb_byte_t *buffer, int length)
     return crc16;
 }
 
+/**
+ * Adds the given buffer to a running CRC-32 (IEEE 802.3), which starts at 0xFFFFFFFF and is inverted when done.
+ *
+ * @param crc The CRC so far.
+ * @param buffer The buffer to add.
+ * @param length The length of the buffer.
+ * @return The updated CRC.
+ */
+uint32_t XModemAdapter::crc32Update(uint32_t crc, const pb_byte_t *buffer, int length)
+{
+    while (length--) {
+        crc ^= *buffer++;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+    return crc;
+}
+
 /**
  * Calculates the checksum of the given buffer and compares it to the given
  * expected checksum. Returns 1 if the checksums match, 0 otherwise.
@@ -94,19 +112,77 @@ int XModemAdapter::check(const pb_byte_t *buf, int sz, unsigned short tcrc)
     return crc16_ccitt(buf, sz) == tcrc;
 }
 
-void XModemAdapter::sendControl(meshtastic_XModem_Control c)
+void XModemAdapter::sendControl(meshtastic_XModem_Control c, uint16_t seq)
 {
     xmodemStore = meshtastic_XModem_init_zero;
     xmodemStore.control = c;
+    xmodemStore.seq = seq;
     LOG_DEBUG("XModem: Notify Send control %d", c);
     packetReady.notifyObservers(packetno);
 }
 
 meshtastic_XModem XModemAdapter::getForPhone()
 {
+    // In windowed mode the blocks are read as the phone takes them, as long as the window has room
+    if (isTransmitting && isWindowed() && xmodemStore.control == meshtastic_XModem_Control_NUL &&
+        (!lastSeq || nextSeq <= lastSeq) && (uint16_t)(nextSeq - packetno) < window)
+        loadBlock(nextSeq++);
     return xmodemStore;
 }
 
+void XModemAdapter::startWindowed(uint16_t requested)
+{
+    window = requested < XMODEM_MAX_WINDOW ? requested : XMODEM_MAX_WINDOW;
+    packetno = 1;
+    nextSeq = 1;
+    lastSeq = 0;
+    crcSeq = 0;
+    fileCrc = 0xFFFFFFFF;
+    retrans = MAXRETRANS;
+    isTransmitting = true;
+    xmodemStore = meshtastic_XModem_init_zero;
+    LOG_DEBUG("XModem: Send with a window of %u blocks", window);
+    packetReady.notifyObservers(packetno);
+}
+
+void XModemAdapter::loadBlock(uint16_t seq)
+{
+    xmodemStore = meshtastic_XModem_init_zero;
+    xmodemStore.control = meshtastic_XModem_Control_SOH;
+    xmodemStore.seq = seq;
+    fsLock->lock();
+    file.seek((seq - 1) * sizeof(meshtastic_XModem_buffer_t::bytes));
+    xmodemStore.buffer.size = file.read(xmodemStore.buffer.bytes, sizeof(meshtastic_XModem_buffer_t::bytes));
+    fsLock->unlock();
+    xmodemStore.crc16 = crc16_ccitt(xmodemStore.buffer.bytes, xmodemStore.buffer.size);
+    if (xmodemStore.buffer.size < sizeof(meshtastic_XModem_buffer_t::bytes))
+        lastSeq = seq;
+    // Blocks are first read in order, going back after a NAK only reads them again
+    if (seq == crcSeq + 1) {
+        fileCrc = crc32Update(fileCrc, xmodemStore.buffer.bytes, xmodemStore.buffer.size);
+        crcSeq = seq;
+    }
+    LOG_DEBUG("XModem: Send packet %d, %d Bytes", seq, xmodemStore.buffer.size);
+}
+
+void XModemAdapter::finishWindowed()
+{
+    fsLock->lock();
+    file.close();
+    fsLock->unlock();
+    uint32_t crc = ~fileCrc;
+    xmodemStore = meshtastic_XModem_init_zero;
+    xmodemStore.control = meshtastic_XModem_Control_EOT;
+    xmodemStore.seq = lastSeq;
+    xmodemStore.buffer.size = sizeof(crc);
+    for (size_t i = 0; i < sizeof(crc); i++)
+        xmodemStore.buffer.bytes[i] = crc >> (8 * i);
+    LOG_INFO("XModem: Finished send file %s, CRC32 %08x", filename, crc);
+    isTransmitting = false;
+    window = 1;
+    packetReady.notifyObservers(packetno);
+}
+
 void XModemAdapter::resetForPhone()
 {
     xmodemStore = meshtastic_XModem_init_zero;
@@ -122,10 +198,12 @@ void XModemAdapter::handlePacket(meshtastic_XModem xmodemPacket)
             memcpy(filename, &xmodemPacket.buffer.bytes, xmodemPacket.buffer.size);
 
             if (xmodemPacket.control == meshtastic_XModem_Control_SOH) { // Receive this file and put to Flash
-                spiLock->lock();
+                fsLock->lock();
                 file = FSCom.open(filename, FILE_O_WRITE);
-                spiLock->unlock();
+                fsLock->unlock();
                 if (file) {
+                    // A windowed sender needs to know which blocks we have, classic ones ignore the seq
+                    window = xmodemPacket.crc16 > 1 ? xmodemPacket.crc16 : 1;
                     sendControl(meshtastic_XModem_Control_ACK);
                     isReceiving = true;
                     packetno = 1;
@@ -136,18 +214,23 @@ void XModemAdapter::handlePacket(meshtastic_XModem xmodemPacket)
                 break;
             } else { // Transmit this file from Flash
                 LOG_INFO("XModem: Transmit file %s", filename);
-                spiLock->lock();
+                fsLock->lock();
                 file = FSCom.open(filename, FILE_O_READ);
-                spiLock->unlock();
+                fsLock->unlock();
+                if (file && XMODEM_MAX_WINDOW > 1 && xmodemPacket.crc16 > 1) {
+                    startWindowed(xmodemPacket.crc16);
+                    break;
+                }
                 if (file) {
+                    window = 1;
                     packetno = 1;
                     isTransmitting = true;
                     xmodemStore = meshtastic_XModem_init_zero;
                     xmodemStore.control = meshtastic_XModem_Control_SOH;
                     xmodemStore.seq = packetno;
-                    spiLock->lock();
+                    fsLock->lock();
                     xmodemStore.buffer.size = file.read(xmodemStore.buffer.bytes, sizeof(meshtastic_XModem_buffer_t::bytes));
-                    spiLock->unlock();
+                    fsLock->unlock();
                     xmodemStore.crc16 = crc16_ccitt(xmodemStore.buffer.bytes, xmodemStore.buffer.size);
                     LOG_DEBUG("XModem: STX Notify Send packet %d, %d Bytes", packetno, xmodemStore.buffer.size);
                     if (xmodemStore.buffer.size < sizeof(meshtastic_XModem_buffer_t::bytes)) {
@@ -167,15 +250,20 @@ void XModemAdapter::handlePacket(meshtastic_XModem xmodemPacket)
                 if ((xmodemPacket.seq == packetno) &&
                     check(xmodemPacket.buffer.bytes, xmodemPacket.buffer.size, xmodemPacket.crc16)) {
                     // valid packet
-                    spiLock->lock();
+                    fsLock->lock();
                     file.write(xmodemPacket.buffer.bytes, xmodemPacket.buffer.size);
-                    spiLock->unlock();
-                    sendControl(meshtastic_XModem_Control_ACK);
+                    fsLock->unlock();
+                    sendControl(meshtastic_XModem_Control_ACK, isWindowed() ? packetno : 0);
                     packetno++;
                     break;
                 }
+                if (isWindowed() && xmodemPacket.seq < packetno) {
+                    // a block sent again after a lost ACK, we already have it
+                    sendControl(meshtastic_XModem_Control_ACK, packetno - 1);
+                    break;
+                }
                 // invalid packet
-                sendControl(meshtastic_XModem_Control_NAK);
+                sendControl(meshtastic_XModem_Control_NAK, isWindowed() ? packetno : 0);
                 break;
             } else if (isTransmitting) {
                 // just received something weird.
@@ -188,31 +276,47 @@ void XModemAdapter::handlePacket(meshtastic_XModem xmodemPacket)
     case meshtastic_XModem_Control_EOT:
         // End of transmission
         sendControl(meshtastic_XModem_Control_ACK);
-        spiLock->lock();
+        fsLock->lock();
         file.flush();
         file.close();
-        spiLock->unlock();
+        fsLock->unlock();
+        invalidateFileManifest();
         isReceiving = false;
+        window = 1;
         break;
     case meshtastic_XModem_Control_CAN:
         // Cancel transmission and remove file
         sendControl(meshtastic_XModem_Control_ACK);
-        spiLock->lock();
+        fsLock->lock();
         file.flush();
         file.close();
 
         FSCom.remove(filename);
-        spiLock->unlock();
+        fsLock->unlock();
+        invalidateFileManifest();
         isReceiving = false;
+        window = 1;
         break;
     case meshtastic_XModem_Control_ACK:
         // Acknowledge Send the next packet
-        if (isTransmitting) {
+        if (isTransmitting && isWindowed()) {
+            // Everything up to seq has arrived, which makes room in the window
+            uint16_t seq = xmodemPacket.seq;
+            if ((uint16_t)(seq - packetno) < (uint16_t)(nextSeq - packetno)) {
+                packetno = seq + 1;
+                retrans = MAXRETRANS;
+            }
+            if (lastSeq && (uint16_t)(packetno - 1) == lastSeq) {
+                finishWindowed();
+                break;
+            }
+            packetReady.notifyObservers(packetno);
+        } else if (isTransmitting) {
             if (isEOT) {
                 sendControl(meshtastic_XModem_Control_EOT);
-                spiLock->lock();
+                fsLock->lock();
                 file.close();
-                spiLock->unlock();
+                fsLock->unlock();
                 LOG_INFO("XModem: Finished send file %s", filename);
                 isTransmitting = false;
                 isEOT = false;
@@ -223,9 +327,9 @@ void XModemAdapter::handlePacket(meshtastic_XModem xmodemPacket)
             xmodemStore = meshtastic_XModem_init_zero;
             xmodemStore.control = meshtastic_XModem_Control_SOH;
             xmodemStore.seq = packetno;
-            spiLock->lock();
+            fsLock->lock();
             xmodemStore.buffer.size = file.read(xmodemStore.buffer.bytes, sizeof(meshtastic_XModem_buffer_t::bytes));
-            spiLock->unlock();
+            fsLock->unlock();
             xmodemStore.crc16 = crc16_ccitt(xmodemStore.buffer.bytes, xmodemStore.buffer.size);
             LOG_DEBUG("XModem: ACK Notify Send packet %d, %d Bytes", packetno, xmodemStore.buffer.size);
             if (xmodemStore.buffer.size < sizeof(meshtastic_XModem_buffer_t::bytes)) {
@@ -240,12 +344,31 @@ void XModemAdapter::handlePacket(meshtastic_XModem xmodemPacket)
         break;
     case meshtastic_XModem_Control_NAK:
         // Negative acknowledge. Send the same buffer again
-        if (isTransmitting) {
+        if (isTransmitting && isWindowed()) {
+            if (--retrans <= 0) {
+                sendControl(meshtastic_XModem_Control_CAN);
+                fsLock->lock();
+                file.close();
+                fsLock->unlock();
+                LOG_INFO("XModem: Retransmit timeout, cancel file %s", filename);
+                isTransmitting = false;
+                window = 1;
+                break;
+            }
+            // Go back to the block the client is missing, everything before it has arrived
+            uint16_t seq = xmodemPacket.seq;
+            if (seq && (uint16_t)(seq - packetno) <= (uint16_t)(nextSeq - packetno))
+                packetno = seq;
+            nextSeq = packetno;
+            if (xmodemStore.control == meshtastic_XModem_Control_SOH)
+                xmodemStore = meshtastic_XModem_init_zero; // a later block the phone hasn't taken yet
+            packetReady.notifyObservers(packetno);
+        } else if (isTransmitting) {
             if (--retrans <= 0) {
                 sendControl(meshtastic_XModem_Control_CAN);
-                spiLock->lock();
+                fsLock->lock();
                 file.close();
-                spiLock->unlock();
+                fsLock->unlock();
                 LOG_INFO("XModem: Retransmit timeout, cancel file %s", filename);
                 isTransmitting = false;
                 break;
@@ -253,11 +376,11 @@ void XModemAdapter::handlePacket(meshtastic_XModem xmodemPacket)
             xmodemStore = meshtastic_XModem_init_zero;
             xmodemStore.control = meshtastic_XModem_Control_SOH;
             xmodemStore.seq = packetno;
-            spiLock->lock();
+            fsLock->lock();
             file.seek((packetno - 1) * sizeof(meshtastic_XModem_buffer_t::bytes));
 
             xmodemStore.buffer.size = file.read(xmodemStore.buffer.bytes, sizeof(meshtastic_XModem_buffer_t::bytes));
-            spiLock->unlock();
+            fsLock->unlock();
             xmodemStore.crc16 = crc16_ccitt(xmodemStore.buffer.bytes, xmodemStore.buffer.size);
             LOG_DEBUG("XModem: NAK Notify Send packet %d, %d Bytes", packetno, xmodemStore.buffer.size);
             if (xmodemStore.buffer.size < sizeof(meshtastic_XModem_buffer_t::bytes)) {
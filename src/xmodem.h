@@ -38,6 +38,11 @@
 
 #define MAXRETRANS 25
 
+/// The most blocks we let a client have in flight when it asks for a window, 1 disables windowed transfers
+#ifndef XMODEM_MAX_WINDOW
+#define XMODEM_MAX_WINDOW 8
+#endif
+
 #ifdef FSCom
 
 class XModemAdapter
@@ -61,6 +66,25 @@ class XModemAdapter
 
     uint16_t packetno = 0;
 
+    /*
+     * Windowed transmit, which a client asks for by putting a window size in the crc16 field of the request for a file.
+     * We then keep sending blocks until window of them wait for an ACK.  An ACK carries the last block the client has
+     * in order, a NAK the block to go back to.  After the last block the EOT carries the CRC32 of the whole file,
+     * little endian.  A client that doesn't ask gets classic stop-and-wait, and one that asks an old firmware for a
+     * window simply gets one block per ACK.  When receiving, asking for a window makes our ACKs and NAKs carry the
+     * block they refer to, so the client can stream its blocks too.
+     */
+    uint16_t window = 1;      // blocks allowed in flight, 1 for classic
+    uint16_t nextSeq = 0;     // the next block to read from the file, packetno is the oldest unacknowledged one
+    uint16_t lastSeq = 0;     // the short block that ends the file, 0 until we've read it
+    uint16_t crcSeq = 0;      // the blocks so far included in fileCrc
+    uint32_t fileCrc = 0;
+
+    bool isWindowed() { return window > 1; }
+    void startWindowed(uint16_t requested);
+    void loadBlock(uint16_t seq);
+    void finishWindowed();
+
 #if defined(ARCH_NRF52) || defined(ARCH_STM32WL)
     File file = File(FSCom);
 #else
@@ -72,8 +96,9 @@ class XModemAdapter
   protected:
     meshtastic_XModem xmodemStore = meshtastic_XModem_init_zero;
     unsigned short crc16_ccitt(const pb_byte_t *buffer, int length);
+    uint32_t crc32Update(uint32_t crc, const pb_byte_t *buffer, int length);
     int check(const pb_byte_t *buf, int sz, unsigned short tcrc);
-    void sendControl(meshtastic_XModem_Control c);
+    void sendControl(meshtastic_XModem_Control c, uint16_t seq = 0);
 };
 
 extern XModemAdapter xModem;
@@ -0,0 +1,384 @@
+#include "DebugConfiguration.h"
+#include "TestUtil.h"
+#include <unity.h>
+
+#ifdef ARCH_PORTDUINO
+#include "mesh/CryptoEngine.h"
+#include "mesh/MeshPacketQueue.h"
+#include "mesh/NodeDB.h"
+#include "mesh/PacketHistory.h"
+#include "mesh/PayloadCompression.h"
+#include "mesh/compression/unishox2.h"
+#include "mesh/mesh-pb-constants.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+/*
+ * Micro-benchmarks of the routing and queueing hot paths.  Every benchmark does a fixed amount of work from a fixed seed
+ * and prints one line:
+ *
+ *   name param ops ns/op check
+ *
+ * Only ns/op should change between two runs of the same build; check is a digest of the results, so a change there
+ * between releases means the code now does something different, not just faster or slower.
+ */
+
+#define BENCH_REPEATS 5 // each benchmark runs this many times and reports the fastest
+
+static uint32_t rngState;
+
+static uint32_t nextRandom()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static uint32_t mix(uint32_t check, uint32_t v)
+{
+    return (check ^ v) * 16777619; // FNV-1a step
+}
+
+/// Run f(), which does ops operations and returns a check value, and print how long an operation took.
+/// prepare() is called untimed before each repeat.
+template <class F, class P> static void bench(const char *name, unsigned param, uint32_t ops, F f, P prepare)
+{
+    double bestNs = 0;
+    uint32_t check = 0;
+    for (int i = 0; i < BENCH_REPEATS; i++) {
+        prepare();
+        rngState = 0x12345678;
+        auto start = std::chrono::steady_clock::now();
+        uint32_t c = f();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || ns < bestNs)
+            bestNs = ns;
+        // Every repeat does the same work
+        TEST_ASSERT_TRUE(i == 0 || c == check);
+        check = c;
+    }
+    printf("BENCH %-32s %6u %8u %10.1f %08x\n", name, param, ops, bestNs / ops, check);
+}
+
+template <class F> static void bench(const char *name, unsigned param, uint32_t ops, F f)
+{
+    bench(name, param, ops, f, []() {});
+}
+
+static meshtastic_MeshPacket makePacket(NodeNum from, PacketId id)
+{
+    meshtastic_MeshPacket p = meshtastic_MeshPacket_init_zero;
+    p.from = from;
+    p.to = NODENUM_BROADCAST;
+    p.id = id;
+    p.hop_limit = 3;
+    p.hop_start = 3;
+    p.priority = meshtastic_MeshPacket_Priority_DEFAULT;
+    p.which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+    p.decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
+    p.decoded.payload.size = snprintf((char *)p.decoded.payload.bytes, sizeof(p.decoded.payload.bytes),
+                                      "Message %u from !%08x, anyone out there?", id, from);
+    return p;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_packetHistory(void)
+{
+    const uint32_t ops = 20000;
+    bench("PacketHistory::wasSeenRecently", ops, ops, [&]() {
+        PacketHistory history;
+        uint32_t seen = 0;
+        for (uint32_t i = 0; i < ops; i++) {
+            // Half new packets, half repeats of one heard a little earlier, like a busy mesh
+            uint32_t id = ((i & 1) && i > 32) ? i - 1 - 2 * (nextRandom() % 16) : i;
+            meshtastic_MeshPacket p = makePacket(0x1000 + id % 50, id + 1);
+            seen += history.wasSeenRecently(&p);
+        }
+        return seen;
+    });
+}
+
+void test_nodeDB(void)
+{
+    const unsigned counts[] = {10, 50, MAX_NUM_NODES};
+    for (unsigned count : counts) {
+        bench(
+            "NodeDB::getOrCreateMeshNode", count, count - 1,
+            [&]() {
+                uint32_t check = 0;
+                for (unsigned i = 1; i < count; i++)
+                    check = mix(check, nodeDB->getOrCreateMeshNode(0x2000 + i) != NULL);
+                return check;
+            },
+            []() { nodeDB->resetNodes(); });
+
+        const uint32_t ops = 10000;
+        bench("NodeDB::getMeshNode", count, ops, [&]() {
+            uint32_t found = 0;
+            for (uint32_t i = 0; i < ops; i++)
+                found += nodeDB->getMeshNode(0x2000 + nextRandom() % (count + count / 4)) != NULL; // some misses
+            return found;
+        });
+    }
+    nodeDB->resetNodes();
+}
+
+void test_meshPacketQueue(void)
+{
+    const uint32_t rounds = 1000;
+    static meshtastic_MeshPacket packets[MAX_TX_QUEUE];
+    for (uint32_t i = 0; i < MAX_TX_QUEUE; i++) {
+        packets[i] = makePacket(0x3000 + i % 4, i + 1);
+        packets[i].priority = (i % 3) ? meshtastic_MeshPacket_Priority_DEFAULT : meshtastic_MeshPacket_Priority_RELIABLE;
+    }
+
+    bench("MeshPacketQueue", MAX_TX_QUEUE, rounds * MAX_TX_QUEUE * 2, [&]() {
+        MeshPacketQueue queue(MAX_TX_QUEUE);
+        uint32_t check = 0;
+        for (uint32_t r = 0; r < rounds; r++) {
+            for (uint32_t i = 0; i < MAX_TX_QUEUE; i++)
+                queue.enqueue(&packets[i]);
+            // Cancel a quarter, as relays do when someone else went first, then send the rest
+            for (uint32_t i = 0; i < MAX_TX_QUEUE / 4; i++) {
+                uint32_t k = nextRandom() % MAX_TX_QUEUE;
+                check = mix(check, queue.remove(packets[k].from, packets[k].id) != NULL);
+            }
+            while (!queue.empty())
+                check = mix(check, queue.dequeue()->id);
+        }
+        return check;
+    });
+}
+
+void test_crypto(void)
+{
+    // Software AES against whatever this platform provides, on native both are the software implementation
+    crypto->aesBenchmark();
+
+    CryptoKey key;
+    for (int i = 0; i < 32; i++)
+        key.bytes[i] = i;
+    key.length = 32;
+    crypto->setKey(key);
+
+    const uint32_t ops = 5000;
+    uint8_t bytes[meshtastic_Constants_DATA_PAYLOAD_LEN];
+    const size_t lens[] = {16, 64, sizeof(bytes)};
+    for (size_t len : lens) {
+        bench("CryptoEngine encrypt+decrypt", len, ops, [&]() {
+            memset(bytes, 0x5a, sizeof(bytes));
+            uint32_t check = 0;
+            for (uint32_t i = 0; i < ops; i++) {
+                crypto->encryptPacket(0x4000, i, len, bytes);
+                check = mix(check, bytes[0]);
+                crypto->decrypt(0x4000, i, len, bytes);
+                check = mix(check, bytes[len - 1]);
+            }
+            return check;
+        });
+    }
+}
+
+void test_protobuf(void)
+{
+    const uint32_t ops = 10000;
+    meshtastic_MeshPacket p = makePacket(0x5000, 1);
+    uint8_t buf[meshtastic_MeshPacket_size];
+
+    bench("pb encode MeshPacket", p.decoded.payload.size, ops, [&]() {
+        uint32_t check = 0;
+        for (uint32_t i = 0; i < ops; i++) {
+            p.id = i;
+            check = mix(check, pb_encode_to_bytes(buf, sizeof(buf), &meshtastic_MeshPacket_msg, &p));
+        }
+        return check;
+    });
+
+    size_t len = pb_encode_to_bytes(buf, sizeof(buf), &meshtastic_MeshPacket_msg, &p);
+    bench("pb decode MeshPacket", len, ops, [&]() {
+        uint32_t check = 0;
+        for (uint32_t i = 0; i < ops; i++) {
+            meshtastic_MeshPacket out = meshtastic_MeshPacket_init_zero;
+            check = mix(check, pb_decode_from_bytes(buf, len, &meshtastic_MeshPacket_msg, &out) ? out.id : 0);
+        }
+        return check;
+    });
+}
+
+void test_unishox2(void)
+{
+    const uint32_t ops = 5000;
+    // Chat, and the kind of strings ATAK plugins send
+    const char *texts[] = {"ok", "On my way, be there in 10 minutes",
+                           "Anyone copy? Testing the new antenna on the hill, SNR looks good",
+                           "ANDROID-589520ccfcd20f01 WOLF-1 a-f-G-U-C 37.7749 -122.4194",
+                           "GeoChat.ANDROID-589520ccfcd20f01.All Chat Rooms.7b0ef4c5-0c9f-4e5d-a4b8-8c3d5f7b2a11"};
+    for (const char *text : texts) {
+        bench("unishox2_compress_simple", strlen(text), ops, [&]() {
+            char out[256];
+            uint32_t check = 0;
+            for (uint32_t i = 0; i < ops; i++)
+                check = mix(check, unishox2_compress_simple(text, strlen(text), out));
+            return check;
+        });
+
+        char compressed[256];
+        int compressedLen = unishox2_compress_simple(text, strlen(text), compressed);
+        bench("unishox2_decompress_simple", strlen(text), ops, [&]() {
+            char out[256];
+            uint32_t check = 0;
+            for (uint32_t i = 0; i < ops; i++)
+                check = mix(check, unishox2_decompress_simple(compressed, compressedLen, out));
+            return check;
+        });
+    }
+}
+
+void test_payloadCompression(void)
+{
+    const uint32_t ops = 2000;
+    const unsigned counts[] = {5, 10}; // 10 is all a NeighborInfo holds
+    for (unsigned count : counts) {
+        meshtastic_NeighborInfo info = meshtastic_NeighborInfo_init_zero;
+        info.node_id = info.last_sent_by_id = 0xa1b2c3d4;
+        info.node_broadcast_interval_secs = 900;
+        rngState = 0x12345678;
+        for (unsigned i = 0; i < count; i++) {
+            info.neighbors[i].node_id = nextRandom();
+            info.neighbors[i].snr = (int)(nextRandom() % 40 - 20) / 4.0f;
+        }
+        info.neighbors_count = count;
+        uint8_t plain[meshtastic_Constants_DATA_PAYLOAD_LEN];
+        size_t len = pb_encode_to_bytes(plain, sizeof(plain), &meshtastic_NeighborInfo_msg, &info);
+
+        uint8_t compressed[meshtastic_Constants_DATA_PAYLOAD_LEN], out[meshtastic_Constants_DATA_PAYLOAD_LEN];
+        size_t compressedLen = PayloadCompression::compress(plain, len, compressed, sizeof(compressed));
+        TEST_ASSERT_TRUE(compressedLen > 0);
+        TEST_ASSERT_EQUAL(len, PayloadCompression::decompress(compressed, compressedLen, out, sizeof(out)));
+        TEST_ASSERT_EQUAL_MEMORY(plain, out, len);
+
+        bench("PayloadCompression::compress", len, ops, [&]() {
+            uint32_t check = 0;
+            for (uint32_t i = 0; i < ops; i++)
+                check = mix(check, PayloadCompression::compress(plain, len, compressed, sizeof(compressed)));
+            return check;
+        });
+        bench("PayloadCompression::decompress", compressedLen, ops, [&]() {
+            uint32_t check = 0;
+            for (uint32_t i = 0; i < ops; i++)
+                check = mix(check, PayloadCompression::decompress(compressed, compressedLen, out, sizeof(out)));
+            return check;
+        });
+    }
+}
+
+/// Role source for the router benchmark with ROUTER_FIXED_ROLE defined: routingRole() is a constexpr
+template <meshtastic_Config_DeviceConfig_Role R> struct FixedRole {
+    constexpr meshtastic_Config_DeviceConfig_Role operator()() const { return R; }
+};
+
+/// Role source without ROUTER_FIXED_ROLE: routingRole() reads config.device.role
+struct RuntimeRole {
+    meshtastic_Config_DeviceConfig_Role operator()() const { return config.device.role; }
+};
+
+/// The role checks the router chain makes for one received packet: Router's perhapsDecode(), FloodingRouter's
+/// perhapsCancelDupe() and isRebroadcaster(), and NextHopRouter::stopRetransmission().  Not inlined, so the runtime
+/// role is read for every packet as it is in the firmware.
+template <class Role>
+static __attribute__((noinline)) uint32_t routeChecks(Role role, const meshtastic_MeshPacket &p, bool fromUs)
+{
+    uint32_t r = 0;
+    if (role() == meshtastic_Config_DeviceConfig_Role_REPEATER &&
+        config.device.rebroadcast_mode == meshtastic_Config_DeviceConfig_RebroadcastMode_ALL_SKIP_DECODING)
+        return 1;
+    if (role() != meshtastic_Config_DeviceConfig_Role_ROUTER && role() != meshtastic_Config_DeviceConfig_Role_REPEATER &&
+        role() != meshtastic_Config_DeviceConfig_Role_ROUTER_LATE)
+        r |= 2; // cancel our own rebroadcast of a dupe
+    if (role() == meshtastic_Config_DeviceConfig_Role_ROUTER_LATE)
+        r |= 4;
+    if (p.hop_limit > 0 && role() != meshtastic_Config_DeviceConfig_Role_CLIENT_MUTE &&
+        config.device.rebroadcast_mode != meshtastic_Config_DeviceConfig_RebroadcastMode_NONE)
+        r |= 8; // rebroadcast
+    if (fromUs ||
+        (role() != meshtastic_Config_DeviceConfig_Role_ROUTER && role() != meshtastic_Config_DeviceConfig_Role_REPEATER &&
+         role() != meshtastic_Config_DeviceConfig_Role_ROUTER_LATE))
+        r |= 16; // stop retransmitting
+    return r;
+}
+
+void test_routerRole(void)
+{
+    const uint32_t ops = 100000;
+    static meshtastic_MeshPacket packets[64];
+    for (uint32_t i = 0; i < 64; i++) {
+        packets[i] = makePacket(0x6000 + i % 8, i + 1);
+        packets[i].hop_limit = i % 4;
+    }
+
+    // Both versions make the same decisions, so print the same check; only ns/op may differ
+    const meshtastic_Config_DeviceConfig_Role roles[] = {meshtastic_Config_DeviceConfig_Role_CLIENT,
+                                                         meshtastic_Config_DeviceConfig_Role_REPEATER,
+                                                         meshtastic_Config_DeviceConfig_Role_CLIENT_MUTE};
+    for (auto r : roles) {
+        config.device.role = r;
+        config.device.rebroadcast_mode = meshtastic_Config_DeviceConfig_RebroadcastMode_ALL;
+        auto run = [&](auto role) {
+            uint32_t check = 0;
+            for (uint32_t i = 0; i < ops; i++) {
+                uint32_t n = nextRandom();
+                check = mix(check, routeChecks(role, packets[n % 64], (n >> 8) % 4 == 0));
+            }
+            return check;
+        };
+        bench("router role checks, runtime", r, ops, [&]() { return run(RuntimeRole()); });
+        switch (r) {
+        case meshtastic_Config_DeviceConfig_Role_CLIENT:
+            bench("router role checks, fixed", r, ops,
+                  [&]() { return run(FixedRole<meshtastic_Config_DeviceConfig_Role_CLIENT>()); });
+            break;
+        case meshtastic_Config_DeviceConfig_Role_REPEATER:
+            bench("router role checks, fixed", r, ops,
+                  [&]() { return run(FixedRole<meshtastic_Config_DeviceConfig_Role_REPEATER>()); });
+            break;
+        default:
+            bench("router role checks, fixed", r, ops,
+                  [&]() { return run(FixedRole<meshtastic_Config_DeviceConfig_Role_CLIENT_MUTE>()); });
+            break;
+        }
+    }
+    config.device.role = meshtastic_Config_DeviceConfig_Role_CLIENT;
+}
+
+void setup()
+{
+    initializeTestEnvironment();
+    nodeDB = new NodeDB();
+    UNITY_BEGIN();
+    RUN_TEST(test_packetHistory);
+    RUN_TEST(test_nodeDB);
+    RUN_TEST(test_meshPacketQueue);
+    RUN_TEST(test_crypto);
+    RUN_TEST(test_protobuf);
+    RUN_TEST(test_unishox2);
+    RUN_TEST(test_payloadCompression);
+    RUN_TEST(test_routerRole);
+    exit(UNITY_END());
+}
+#else
+void setup()
+{
+    initializeTestEnvironment();
+    LOG_WARN("The benchmarks only run on the native build");
+    UNITY_BEGIN();
+    UNITY_END();
+}
+#endif
+void loop() {}
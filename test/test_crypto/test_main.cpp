@@ -178,6 +178,11 @@ void test_AES_CTR(void)
     TEST_ASSERT_EQUAL_MEMORY(expected, plain, 16);
 }
 
+void test_AES_selftest(void)
+{
+    TEST_ASSERT(crypto->aesSelfTest());
+}
+
 void setup()
 {
     // NOTE!!! Wait for >2 secs
@@ -192,6 +197,7 @@ void setup()
     RUN_TEST(test_DH25519);
     RUN_TEST(test_AES_CTR);
     RUN_TEST(test_PKC);
+    RUN_TEST(test_AES_selftest);
     exit(UNITY_END()); // stop unit testing
 }
 
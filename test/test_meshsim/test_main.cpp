@@ -0,0 +1,85 @@
+#include "TestUtil.h"
+#include <unity.h>
+
+#ifdef ARCH_PORTDUINO
+#include "platform/portduino/MeshSimulator.h"
+#include <string.h>
+#include <string>
+
+static MeshSimulator::Report simulate(const char *topology)
+{
+    FILE *f = fmemopen((void *)topology, strlen(topology), "r");
+    MeshSimulator sim;
+    TEST_ASSERT_TRUE(sim.loadTopology(f));
+    fclose(f);
+    return sim.run();
+}
+
+// Five nodes in a line, each only hearing its neighbours
+static const char *line = "link 1 2 5\n"
+                          "link 2 3 5\n"
+                          "link 3 4 5\n"
+                          "link 4 5 5\n";
+
+static std::string lineWith(const char *sends, const char *firstHops = "3")
+{
+    return std::string("propagation 22 200 3\n"
+                       "node 1 0 0 client ") +
+           firstHops + "\nnode 2 0 0\nnode 3 0 0\nnode 4 0 0\nnode 5 0 0\n" + line + sends;
+}
+
+void test_hopLimit(void)
+{
+    // Three hops is three relays, enough to get from 1 to 5
+    MeshSimulator::Report r = simulate(lineWith("send 0 1 5 20\n").c_str());
+    TEST_ASSERT_EQUAL(1, r.delivered);
+    // Two get as far as 4
+    r = simulate(lineWith("send 0 1 4 20\n", "2").c_str());
+    TEST_ASSERT_EQUAL(1, r.delivered);
+    r = simulate(lineWith("send 0 1 5 20\n", "2").c_str());
+    TEST_ASSERT_EQUAL(0, r.delivered);
+    TEST_ASSERT_EQUAL(1, r.wanted);
+}
+
+void test_broadcast(void)
+{
+    MeshSimulator::Report r = simulate(lineWith("send 0 3 all 20\n").c_str());
+    TEST_ASSERT_EQUAL(4, r.wanted);
+    TEST_ASSERT_EQUAL(4, r.delivered);
+    // The ends have nobody new to relay to, but don't know that
+    TEST_ASSERT_EQUAL(1, r.nodes[2].sent);
+    TEST_ASSERT_GREATER_THAN(0, r.nodes[0].airtimeMs + r.nodes[4].airtimeMs);
+}
+
+void test_repeatable(void)
+{
+    const char *mesh = "seed 42\n"
+                       "node 1 0 0\nnode 2 1500 0\nnode 3 3000 0\nnode 4 0 1500 router\nnode 5 1500 1500\nnode 6 3000 1500\n"
+                       "traffic 20 5000 40\n";
+    MeshSimulator::Report a = simulate(mesh), b = simulate(mesh);
+    TEST_ASSERT_EQUAL(a.delivered, b.delivered);
+    TEST_ASSERT_EQUAL(a.latencySumMs, b.latencySumMs);
+    for (size_t i = 0; i < a.nodes.size(); i++) {
+        TEST_ASSERT_EQUAL(a.nodes[i].airtimeMs, b.nodes[i].airtimeMs);
+        TEST_ASSERT_EQUAL(a.nodes[i].rxCollided, b.nodes[i].rxCollided);
+    }
+}
+
+void setup()
+{
+    initializeTestEnvironment();
+    UNITY_BEGIN();
+    RUN_TEST(test_hopLimit);
+    RUN_TEST(test_broadcast);
+    RUN_TEST(test_repeatable);
+    exit(UNITY_END());
+}
+#else
+void setup()
+{
+    initializeTestEnvironment();
+    UNITY_BEGIN();
+    UNITY_END();
+}
+#endif
+void loop() {}
@@ -0,0 +1,250 @@
+#include "DebugConfiguration.h"
+#include "TestUtil.h"
+#include <unity.h>
+
+#ifdef ARCH_PORTDUINO
+#include "airtime.h"
+#include "mesh/Channels.h"
+#include "mesh/CryptoEngine.h"
+#include "mesh/MeshService.h"
+#include "mesh/NodeDB.h"
+#include "mesh/ReliableRouter.h"
+#include "modules/RoutingModule.h"
+#include "platform/portduino/PacketCapture.h"
+#include "platform/portduino/SimRadio.h"
+
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+/*
+ * Replays a packet capture (see PacketCapture) into Router::enqueueReceivedMessage() and prints how the router chain
+ * handled it:
+ *
+ *   REPLAY frames relayed delivered dropped replies depth_max depth_mean us_p50 us_p90 us_max check
+ *
+ * Frames are replayed at their recorded pace times REPLAY_SPEED, or one at a time as fast as the router takes them with
+ * REPLAY_SPEED=0.  A frame is relayed if the router handed a copy to the radio, delivered if it reached the phone queue, and
+ * dropped if neither (a duplicate, a packet from an ignored node, or one pushed out of a full queue).  Depth is the receive
+ * queue as each frame joins it, and the time is what Router::runOnce() took per frame it handled.  check is a digest of
+ * every frame's decisions, so two runs of the same capture only differ in the times.
+ *
+ * With REPLAY_PCAP=<file> a capture from meshtasticd (Logging: PcapFile) is replayed; frames on channels other than the
+ * default one aren't decoded, but still relayed or dropped as they would be.  Otherwise a synthetic capture is made and
+ * replayed twice, to check the decisions come out the same.
+ */
+
+static const NodeNum OUR_NODE = 0x0e5a0001;
+
+/// A SimRadio that keeps what the router asks it to send rather than sending it
+class ReplayRadio : public SimRadio
+{
+  public:
+    std::vector<std::pair<NodeNum, PacketId>> sent;
+
+    virtual ErrorCode send(meshtastic_MeshPacket *p) override
+    {
+        sent.emplace_back(p->from, p->id);
+        packetPool.release(p);
+        return ERRNO_OK;
+    }
+};
+
+struct Report {
+    uint32_t frames = 0, relayed = 0, delivered = 0, dropped = 0, replies = 0;
+    uint32_t depthMax = 0;
+    uint64_t depthSum = 0;
+    std::vector<uint32_t> frameNs;
+    uint32_t check = 0;
+};
+
+static ReplayRadio *radio;
+
+static uint32_t mix(uint32_t check, uint32_t v)
+{
+    return (check ^ v) * 16777619; // FNV-1a step
+}
+
+static std::pair<NodeNum, PacketId> keyOf(const PacketCapture::Frame &f)
+{
+    PacketHeader h;
+    memcpy(&h, f.frame, sizeof(h));
+    return {h.from, h.id};
+}
+
+/// Make a fresh router, so one replay's packet history and routes don't decide the next
+static void resetRouter()
+{
+    if (router) {
+        delete router;
+        delete cryptLock; // created by the Router constructor
+        cryptLock = NULL;
+    }
+    router = new ReliableRouter();
+    router->addInterface(radio);
+    nodeDB->resetNodes();
+    myNodeInfo.my_node_num = OUR_NODE;
+}
+
+static Report replay(const std::vector<PacketCapture::Frame> &frames, float speed)
+{
+    resetRouter();
+    Report r;
+    std::vector<size_t> pending; // frames in the receive queue
+    std::set<std::pair<NodeNum, PacketId>> delivered;
+    auto start = std::chrono::steady_clock::now();
+    auto elapsedUs = [&]() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    size_t next = 0;
+    while (next < frames.size() || !pending.empty()) {
+        // Everything due by now arrives, back to back as it would from a busy channel
+        while (next < frames.size()) {
+            const PacketCapture::Frame &f = frames[next];
+            if (speed > 0 && elapsedUs() < (f.timeUs - frames[0].timeUs) / speed)
+                break;
+            next++;
+            if (f.meta.direction != PacketCapture::RX)
+                continue; // we sent it, the router made it rather than heard it
+            meshtastic_MeshPacket *p = PacketCapture::toPacket(f);
+            TEST_ASSERT_NOT_NULL(p);
+            router->enqueueReceivedMessage(p);
+            pending.push_back(next - 1);
+            uint32_t depth = router->getRxQueueDepth();
+            r.depthMax = std::max(r.depthMax, depth);
+            r.depthSum += depth;
+            if (speed <= 0)
+                break;
+        }
+        if (pending.empty()) {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+            continue;
+        }
+
+        radio->sent.clear();
+        delivered.clear();
+        auto t = std::chrono::steady_clock::now();
+        router->runOnce();
+        uint32_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t).count();
+        meshtastic_MeshPacket *p;
+        while ((p = service->getForPhone()) != NULL) {
+            delivered.emplace(p->from, p->id);
+            service->releaseToPool(p);
+        }
+
+        for (auto &s : radio->sent)
+            if (s.first == OUR_NODE)
+                r.replies++;
+        for (size_t i : pending) {
+            auto key = keyOf(frames[i]);
+            bool relay = std::find(radio->sent.begin(), radio->sent.end(), key) != radio->sent.end();
+            bool deliver = delivered.count(key);
+            r.frames++;
+            r.relayed += relay;
+            r.delivered += deliver;
+            r.dropped += !relay && !deliver;
+            r.frameNs.push_back(ns / pending.size());
+            r.check = mix(r.check, relay | deliver << 1);
+        }
+        pending.clear();
+    }
+
+    std::vector<uint32_t> sorted = r.frameNs;
+    std::sort(sorted.begin(), sorted.end());
+    auto pct = [&](int p) { return sorted.empty() ? 0.0 : sorted[(sorted.size() - 1) * p / 100] / 1000.0; };
+    printf("REPLAY %6u %6u %6u %6u %6u %3u %5.2f %8.1f %8.1f %8.1f %08x\n", r.frames, r.relayed, r.delivered, r.dropped,
+           r.replies, r.depthMax, r.frames ? (double)r.depthSum / r.frames : 0.0, pct(50), pct(90), pct(100), r.check);
+    return r;
+}
+
+/// A capture of broadcasts from a few nodes, a quarter of them heard again from a relayer
+static void makeCapture(const char *path, uint32_t unique)
+{
+    PacketCapture *capture = new PacketCapture(path, 0);
+    for (uint32_t i = 0; i < unique; i++) {
+        meshtastic_MeshPacket *p = packetPool.allocZeroed();
+        p->from = 0x1000 + i % 10;
+        p->to = NODENUM_BROADCAST;
+        p->id = 0x10000 + i;
+        p->hop_limit = p->hop_start = 3;
+        p->which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+        p->decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
+        p->decoded.payload.size = snprintf((char *)p->decoded.payload.bytes, sizeof(p->decoded.payload.bytes), "replay %u", i);
+        TEST_ASSERT_EQUAL(meshtastic_Routing_Error_NONE, perhapsEncode(p));
+        p->rx_snr = 6.5f;
+        p->rx_rssi = -90;
+        capture->capture(p, PacketCapture::RX);
+        if (i % 4 == 0) {
+            p->hop_limit--;
+            p->relay_node = 0x42;
+            p->rx_snr = -3;
+            capture->capture(p, PacketCapture::RX);
+        }
+        packetPool.release(p);
+    }
+    delete capture; // writes the ring out
+}
+
+void test_synthetic(void)
+{
+    const uint32_t unique = 40;
+    const char *path = "/tmp/meshtastic_test_replay.pcap";
+    makeCapture(path, unique);
+    std::vector<PacketCapture::Frame> frames;
+    TEST_ASSERT_TRUE(PacketCapture::read(path, frames));
+    remove(path);
+    TEST_ASSERT_EQUAL(unique + unique / 4, frames.size());
+
+    Report a = replay(frames, 0);
+    TEST_ASSERT_EQUAL(frames.size(), a.frames);
+    TEST_ASSERT_EQUAL(unique, a.delivered);
+    TEST_ASSERT_TRUE(a.dropped >= unique / 4); // the repeats
+    TEST_ASSERT_EQUAL(1, a.depthMax);
+
+    Report b = replay(frames, 0);
+    TEST_ASSERT_EQUAL_HEX32(a.check, b.check);
+}
+
+void test_capture(void)
+{
+    const char *path = getenv("REPLAY_PCAP");
+    if (!path)
+        TEST_IGNORE_MESSAGE("Set REPLAY_PCAP to replay a capture");
+    const char *speed = getenv("REPLAY_SPEED");
+    std::vector<PacketCapture::Frame> frames;
+    TEST_ASSERT_TRUE(PacketCapture::read(path, frames));
+    replay(frames, speed ? atof(speed) : 1);
+}
+
+void setup()
+{
+    initializeTestEnvironment();
+    nodeDB = new NodeDB();
+    service = new MeshService();
+    routingModule = new RoutingModule();
+    airTime = new AirTime();
+    channels.initDefaults();
+    radio = new ReplayRadio();
+    resetRouter();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_synthetic);
+    RUN_TEST(test_capture);
+    exit(UNITY_END());
+}
+#else
+void setup()
+{
+    initializeTestEnvironment();
+    LOG_WARN("The replay harness only runs on the native build");
+    UNITY_BEGIN();
+    UNITY_END();
+}
+#endif
+void loop() {}